@@ -0,0 +1,137 @@
+#!/usr/bin/env python3
+"""
+Measure how many agent offers per second mod_callcenter dispatches.
+
+  callcenter_dispatch_bench.py --queue bench@default --agents 2000 --members 5000 --seconds 60
+
+Connects to mod_event_socket, creates --agents callback agents on the queue
+(which must exist in callcenter.conf.xml), parks --members calls in it and
+then samples "callcenter_config dispatch status" for --seconds.
+
+The default agent contact fails at once (error/user_busy) and the agents
+carry no busy delay, so every offer puts the agent straight back into the
+pool: the rate reported is the dispatcher's, not the media path's.  The
+members are loopback calls parked on the B leg with the callcenter app on
+the A leg.  Run it once with agent-index off and once with it on, and
+compare offers/s and agent queries/s.
+
+Only the python standard library is used.
+"""
+
+import argparse
+import socket
+import time
+
+
+class ESL(object):
+    def __init__(self, host, port, password):
+        self.sock = socket.create_connection((host, port))
+        self.buf = b""
+        self.read_reply()
+        reply = self.command("auth %s" % password)
+        if "+OK" not in reply:
+            raise RuntimeError("auth failed: %s" % reply)
+
+    def read_reply(self):
+        while b"\n\n" not in self.buf:
+            self.recv()
+        head, self.buf = self.buf.split(b"\n\n", 1)
+        headers = dict(line.split(": ", 1) for line in head.decode().split("\n") if ": " in line)
+        length = int(headers.get("Content-Length", 0))
+        while len(self.buf) < length:
+            self.recv()
+        body, self.buf = self.buf[:length], self.buf[length:]
+        return headers.get("Reply-Text", "") + body.decode()
+
+    def recv(self):
+        data = self.sock.recv(65536)
+        if not data:
+            raise ConnectionError("event socket closed")
+        self.buf += data
+
+    def command(self, cmd):
+        self.sock.sendall(cmd.encode() + b"\n\n")
+        return self.read_reply()
+
+    def api(self, cmd):
+        return self.command("api %s" % cmd)
+
+    def bgapi(self, cmd):
+        return self.command("bgapi %s" % cmd)
+
+
+def dispatch_status(esl):
+    stats = {}
+    for line in esl.api("callcenter_config dispatch status").splitlines():
+        if ": " in line:
+            key, value = line.split(": ", 1)
+            stats[key.strip()] = value.strip()
+    return stats
+
+
+def counter(stats, key):
+    try:
+        return int(stats.get(key, "0").split()[0])
+    except ValueError:
+        return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=8021)
+    parser.add_argument("--password", default="ClueCon")
+    parser.add_argument("--queue", default="bench@default")
+    parser.add_argument("--agents", type=int, default=200)
+    parser.add_argument("--members", type=int, default=500)
+    parser.add_argument("--seconds", type=int, default=30)
+    parser.add_argument("--agent-contact", default="error/user_busy")
+    parser.add_argument("--member-dial", default="loopback/park/default/inline")
+    parser.add_argument("--keep", action="store_true", help="leave agents and calls in place when done")
+    args = parser.parse_args()
+
+    esl = ESL(args.host, args.port, args.password)
+    names = ["bench-agent-%d" % i for i in range(args.agents)]
+
+    for name in names:
+        esl.api("callcenter_config agent add %s Callback" % name)
+        esl.api("callcenter_config agent set contact %s %s" % (name, args.agent_contact))
+        esl.api("callcenter_config agent set busy_delay_time %s 0" % name)
+        esl.api("callcenter_config tier add %s %s 1 1" % (args.queue, name))
+        esl.api("callcenter_config agent set status %s Available" % name)
+
+    for i in range(args.members):
+        esl.bgapi("originate {origination_caller_id_number=%d,cc_bench=true}%s &callcenter(%s)"
+                  % (100000 + i, args.member_dial, args.queue))
+
+    time.sleep(2)
+    first = dispatch_status(esl)
+    started = time.time()
+    last = first
+
+    print("%8s %10s %12s %14s %14s" % ("time", "offers/s", "passes/s", "queries/s", "skipped/s"))
+    while time.time() - started < args.seconds:
+        time.sleep(1)
+        now = dispatch_status(esl)
+        print("%8.1f %10d %12d %14d %14d" % (
+            time.time() - started,
+            counter(now, "offers") - counter(last, "offers"),
+            counter(now, "passes") - counter(last, "passes"),
+            counter(now, "agent_queries") - counter(last, "agent_queries"),
+            counter(now, "agent_queries_skipped") - counter(last, "agent_queries_skipped")))
+        last = now
+
+    elapsed = time.time() - started
+    print("average: %.1f offers/s, %.1f agent queries/s over %.0fs (%s)" % (
+        (counter(last, "offers") - counter(first, "offers")) / elapsed,
+        (counter(last, "agent_queries") - counter(first, "agent_queries")) / elapsed,
+        elapsed, last.get("agent_index", "agent_index: unknown")))
+
+    if not args.keep:
+        esl.api("hupall normal_clearing cc_bench true")
+        for name in names:
+            esl.api("callcenter_config agent del %s" % name)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,129 @@
+#!/usr/bin/env python3
+"""
+Exercise mod_hash limit sharing between several FreeSWITCH nodes.
+
+  hash_limit_loopback.py --node 127.0.0.1:8021 --node 127.0.0.1:8022 --calls 50 --keys 10
+
+Every --node must list the others as <remote> entries in hash.conf.xml (a
+couple of instances on one box with different event socket ports will do).
+On each node the script parks --calls loopback calls, each of which takes a
+"limit hash" slot on one of --keys resources, then polls "limit_usage" for
+every resource on every node until all of them report the cluster wide total
+(or --timeout expires).  The calls are then hung up and the script waits for
+the usage to drop back to 0 everywhere, which checks that released keys make
+it across in delta pulls.  "hash_remote list" is printed at the end so the
+full/delta pull counts and bytes received can be compared between runs.
+
+Only the python standard library is used.
+"""
+
+import argparse
+import socket
+import time
+
+
+class ESL(object):
+    def __init__(self, host, port, password):
+        self.sock = socket.create_connection((host, port))
+        self.buf = b""
+        self.read_reply()
+        reply = self.command("auth %s" % password)
+        if "+OK" not in reply:
+            raise RuntimeError("auth failed: %s" % reply)
+
+    def read_reply(self):
+        while b"\n\n" not in self.buf:
+            self.recv()
+        head, self.buf = self.buf.split(b"\n\n", 1)
+        headers = dict(line.split(": ", 1) for line in head.decode().split("\n") if ": " in line)
+        length = int(headers.get("Content-Length", 0))
+        while len(self.buf) < length:
+            self.recv()
+        body, self.buf = self.buf[:length], self.buf[length:]
+        return headers.get("Reply-Text", "") + body.decode()
+
+    def recv(self):
+        data = self.sock.recv(65536)
+        if not data:
+            raise ConnectionError("event socket closed")
+        self.buf += data
+
+    def command(self, cmd):
+        self.sock.sendall(cmd.encode() + b"\n\n")
+        return self.read_reply()
+
+    def api(self, cmd):
+        return self.command("api %s" % cmd)
+
+    def bgapi(self, cmd):
+        return self.command("bgapi %s" % cmd)
+
+
+def usage(esl, realm, resource):
+    try:
+        return int(esl.api("limit_usage hash %s %s" % (realm, resource)).strip())
+    except ValueError:
+        return -1
+
+
+def wait_for(nodes, realm, resources, expected, timeout):
+    started = time.time()
+    while True:
+        seen = dict((name, [usage(esl, realm, r) for r in resources]) for name, esl in nodes)
+        if all(counts == expected for counts in seen.values()):
+            return time.time() - started, seen
+        if time.time() - started > timeout:
+            return None, seen
+        time.sleep(0.1)
+
+
+def report(label, elapsed, seen, expected):
+    if elapsed is None:
+        print("%s: NOT converged, expected %s" % (label, expected))
+        for name, counts in seen.items():
+            print("  %-22s %s" % (name, counts))
+    else:
+        print("%s: converged on all nodes in %.2fs" % (label, elapsed))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--node", action="append", required=True, help="host:port of a node's event socket")
+    parser.add_argument("--password", default="ClueCon")
+    parser.add_argument("--realm", default="hashbench")
+    parser.add_argument("--calls", type=int, default=20, help="calls to park on each node")
+    parser.add_argument("--keys", type=int, default=5, help="limit resources to spread the calls over")
+    parser.add_argument("--timeout", type=float, default=30.0)
+    parser.add_argument("--member-dial", default="loopback/park/default/inline")
+    args = parser.parse_args()
+
+    nodes = []
+    for node in args.node:
+        host, port = node.rsplit(":", 1)
+        nodes.append((node, ESL(host, int(port), args.password)))
+
+    resources = ["key%d" % i for i in range(args.keys)]
+    expected = [0] * args.keys
+
+    for name, esl in nodes:
+        for i in range(args.calls):
+            key = i % args.keys
+            expected[key] += 1
+            esl.bgapi("originate {hash_bench=true}%s 'limit:hash %s %s -1,park' inline"
+                      % (args.member_dial, args.realm, resources[key]))
+
+    elapsed, seen = wait_for(nodes, args.realm, resources, expected, args.timeout)
+    report("acquire", elapsed, seen, expected)
+
+    for name, esl in nodes:
+        esl.api("hupall normal_clearing hash_bench true")
+
+    elapsed, seen = wait_for(nodes, args.realm, resources, [0] * args.keys, args.timeout)
+    report("release", elapsed, seen, [0] * args.keys)
+
+    for name, esl in nodes:
+        print("\n%s\n%s" % (name, esl.api("hash_remote list").strip()))
+
+
+if __name__ == "__main__":
+    main()
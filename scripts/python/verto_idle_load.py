@@ -0,0 +1,118 @@
+#!/usr/bin/env python3
+"""
+Open a large number of idle verto websocket connections and measure
+JSON-RPC round trips over a sample of them.
+
+  verto_idle_load.py --host 127.0.0.1 --port 8081 --connections 50000 --hold 300
+
+Only the python standard library is used.  Plain ws:// only; raise the
+open file limit (ulimit -n) and spread the connections over several
+source addresses with --bind when going past ~28k sockets per address.
+Compare "verto reactor" and the thread count of the freeswitch process
+with reactor-workers set and unset in verto.conf.xml.
+"""
+
+import argparse
+import asyncio
+import base64
+import json
+import os
+import struct
+import time
+
+
+def ws_frame(text):
+    payload = text.encode()
+    mask = os.urandom(4)
+    head = bytes([0x81])
+    n = len(payload)
+    if n < 126:
+        head += bytes([0x80 | n])
+    elif n < 65536:
+        head += bytes([0x80 | 126]) + struct.pack("!H", n)
+    else:
+        head += bytes([0x80 | 127]) + struct.pack("!Q", n)
+    return head + mask + bytes(b ^ mask[i % 4] for i, b in enumerate(payload))
+
+
+async def ws_read(reader):
+    b1, b2 = await reader.readexactly(2)
+    n = b2 & 0x7f
+    if n == 126:
+        n = struct.unpack("!H", await reader.readexactly(2))[0]
+    elif n == 127:
+        n = struct.unpack("!Q", await reader.readexactly(8))[0]
+    data = await reader.readexactly(n)
+    return b1 & 0x0f, data
+
+
+async def connect(args, i):
+    local = (args.bind[i % len(args.bind)], 0) if args.bind else None
+    reader, writer = await asyncio.open_connection(args.host, args.port, local_addr=local)
+    key = base64.b64encode(os.urandom(16)).decode()
+    writer.write(("GET / HTTP/1.1\r\nHost: %s:%d\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                  "Sec-WebSocket-Key: %s\r\nSec-WebSocket-Version: 13\r\n\r\n" % (args.host, args.port, key)).encode())
+    status = await reader.readuntil(b"\r\n\r\n")
+    if b" 101 " not in status.split(b"\r\n")[0]:
+        raise ConnectionError(status.split(b"\r\n")[0].decode())
+    return reader, writer
+
+
+async def rpc(reader, writer, rid):
+    start = time.monotonic()
+    writer.write(ws_frame(json.dumps({"jsonrpc": "2.0", "method": "echo", "params": {}, "id": rid})))
+    while True:
+        opcode, data = await ws_read(reader)
+        if opcode == 1 and json.loads(data).get("id") == rid:
+            return time.monotonic() - start
+
+
+async def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=8081)
+    parser.add_argument("--connections", type=int, default=50000)
+    parser.add_argument("--concurrency", type=int, default=500, help="connection attempts in flight")
+    parser.add_argument("--hold", type=int, default=60, help="seconds to keep the connections open")
+    parser.add_argument("--sample", type=int, default=100, help="connections used for round trip samples")
+    parser.add_argument("--bind", action="append", help="local address to connect from, may be repeated")
+    args = parser.parse_args()
+
+    conns, failed = [], 0
+    gate = asyncio.Semaphore(args.concurrency)
+    start = time.monotonic()
+
+    async def one(i):
+        nonlocal failed
+        async with gate:
+            try:
+                conns.append(await connect(args, i))
+            except (OSError, ConnectionError, asyncio.IncompleteReadError):
+                failed += 1
+
+    await asyncio.gather(*(one(i) for i in range(args.connections)))
+    print("connected %d, failed %d in %.1fs" % (len(conns), failed, time.monotonic() - start))
+
+    end = time.monotonic() + args.hold
+    rid = 0
+    while time.monotonic() < end and conns:
+        samples = []
+        for reader, writer in conns[:args.sample]:
+            rid += 1
+            try:
+                samples.append(await asyncio.wait_for(rpc(reader, writer, rid), 10))
+            except (OSError, asyncio.TimeoutError, asyncio.IncompleteReadError):
+                pass
+        if samples:
+            samples.sort()
+            print("rtt ms: min %.2f p50 %.2f p99 %.2f max %.2f (%d samples)" % (
+                samples[0] * 1000, samples[len(samples) // 2] * 1000,
+                samples[int(len(samples) * 0.99)] * 1000, samples[-1] * 1000, len(samples)))
+        await asyncio.sleep(5)
+
+    for reader, writer in conns:
+        writer.close()
+
+
+if __name__ == "__main__":
+    asyncio.run(main())
@@ -83,6 +83,35 @@ typedef enum {
 	SSF_MEDIA_BUG_TAP_ONLY = (1 << 10)
 } switch_session_flag_t;
 
+/* audio handed to the media bugs of a session is kept once per direction in a ring of frames,
+   every bug owns one bit of the ring and reads it back through its own cursor */
+#define SWITCH_MEDIA_BUG_RING_FRAMES 256
+#define SWITCH_MEDIA_BUG_RING_BUGS 64
+
+typedef struct switch_media_bug_ring_slot_s {
+	uint32_t seq;
+	uint64_t mask;
+	uint32_t datalen;
+	uint32_t buflen;
+	uint8_t *data;
+} switch_media_bug_ring_slot_t;
+
+typedef struct switch_media_bug_ring_cursor_s {
+	uint32_t seq;
+	uint32_t offset;
+	switch_size_t pending;
+	uint32_t frames;
+	uint32_t overruns;
+} switch_media_bug_ring_cursor_t;
+
+typedef struct switch_media_bug_ring_s {
+	switch_mutex_t *mutex;
+	uint32_t head;
+	uint64_t used;
+	switch_media_bug_ring_slot_t slots[SWITCH_MEDIA_BUG_RING_FRAMES];
+	switch_media_bug_ring_cursor_t cursors[SWITCH_MEDIA_BUG_RING_BUGS];
+} switch_media_bug_ring_t;
+
 struct switch_core_session {
 	switch_memory_pool_t *pool;
 	switch_thread_t *thread;
@@ -133,6 +162,7 @@ struct switch_core_session {
 	switch_queue_t *private_event_queue_pri;
 	switch_thread_rwlock_t *bug_rwlock;
 	switch_media_bug_t *bugs;
+	switch_media_bug_ring_t *bug_ring[2];
 	switch_app_log_t *app_log;
 	uint32_t stack_count;
 
@@ -173,8 +203,9 @@ struct switch_core_session {
 };
 
 struct switch_media_bug {
-	switch_buffer_t *raw_write_buffer;
-	switch_buffer_t *raw_read_buffer;
+	int ring_bit[2];
+	switch_audio_resampler_t *resampler;
+	uint32_t rate;
 	switch_frame_t *read_replace_frame_in;
 	switch_frame_t *read_replace_frame_out;
 	switch_frame_t *write_replace_frame_in;
@@ -183,7 +214,6 @@ struct switch_media_bug {
 	switch_frame_t *native_write_frame;
 	switch_media_bug_callback_t callback;
 	switch_mutex_t *read_mutex;
-	switch_mutex_t *write_mutex;
 	switch_core_session_t *session;
 	void *user_data;
 	uint32_t flags;
@@ -274,8 +304,10 @@ struct switch_runtime {
 	char *switchname;
 	int multiple_registrations;
 	uint32_t max_db_handles;
+	uint32_t max_db_handles_per_dsn;
 	uint32_t db_handle_timeout;
 	uint32_t event_heartbeat_interval;
+	uint32_t module_load_threads;
 	int cpu_count;
 	uint32_t time_sync;
 	char *core_db_pre_trans_execute;
@@ -287,14 +319,30 @@ struct switch_runtime {
 	char *event_channel_key_separator;
 	uint32_t max_audio_channels;
 	switch_call_cause_t shutdown_cause;
+	switch_size_t prompt_cache_size;
+	switch_size_t prompt_cache_max_file_size;
+	uint32_t record_writer_threads;
+	uint32_t record_writer_flush_ms;
+	uint32_t record_writer_max_lag_ms;
+	uint32_t directory_negative_cache_ms;
+	uint32_t directory_stale_cache_ms;
+	uint32_t curl_pool_max_idle;
 };
 
 extern struct switch_runtime runtime;
 
 
+/* the session table is split by key hash so lookups only contend with changes to their own stripe */
+#define SWITCH_SESSION_STRIPES 64
+
+struct switch_session_stripe {
+	switch_hash_t *table;
+	switch_thread_rwlock_t *rwlock;
+};
+
 struct switch_session_manager {
 	switch_memory_pool_t *memory_pool;
-	switch_hash_t *session_table;
+	struct switch_session_stripe session_stripes[SWITCH_SESSION_STRIPES];
 	uint32_t session_count;
 	uint32_t session_limit;
 	switch_size_t session_id;
@@ -314,6 +362,11 @@ void switch_core_sqldb_destroy();
 switch_status_t switch_core_sqldb_start(switch_memory_pool_t *pool, switch_bool_t manage);
 void switch_core_sqldb_stop(void);
 void switch_core_session_init(switch_memory_pool_t *pool);
+void switch_core_media_bug_ring_feed(switch_media_bug_t *bug, switch_rw_t rw, const void *data, uint32_t datalen, int64_t *ticket);
+void switch_core_media_bug_ring_destroy(switch_core_session_t *session);
+switch_status_t switch_core_prompt_cache_open(switch_file_handle_t *fh, const char *file_path);
+void switch_ivr_record_writers_start(switch_memory_pool_t *pool);
+void switch_ivr_record_writers_stop(void);
 void switch_core_session_uninit(void);
 void switch_core_state_machine_init(switch_memory_pool_t *pool);
 switch_memory_pool_t *switch_core_memory_init(void);
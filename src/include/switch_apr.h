@@ -424,6 +424,26 @@ SWITCH_DECLARE(void) switch_atomic_inc(volatile switch_atomic_t *mem);
  */
 SWITCH_DECLARE(int)  switch_atomic_dec(volatile switch_atomic_t *mem);
 
+/**
+ * Uses an atomic operation to set the value at the specified memory location
+ * to with if it currently holds cmp.
+ * @param mem The location of the value to compare and set.
+ * @param with The value to store if the comparison succeeds.
+ * @param cmp The value the location has to hold.
+ * @return The value the location held before the operation.
+ */
+SWITCH_DECLARE(uint32_t) switch_atomic_cas(volatile switch_atomic_t *mem, uint32_t with, uint32_t cmp);
+
+/**
+ * Uses an atomic operation with a full memory barrier to set the pointer at
+ * the specified memory location to with if it currently holds cmp.
+ * @param mem The location of the pointer to compare and set.
+ * @param with The pointer to store if the comparison succeeds.
+ * @param cmp The pointer the location has to hold.
+ * @return The pointer the location held before the operation.
+ */
+SWITCH_DECLARE(void *) switch_atomic_casptr(volatile void **mem, void *with, const void *cmp);
+
 /** @} */
 
 /**
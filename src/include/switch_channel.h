@@ -105,6 +105,42 @@ SWITCH_DECLARE(switch_status_t) switch_channel_wait_for_app_flag(switch_channel_
 																 uint32_t app_flag,
 																 const char *key, switch_bool_t pres, uint32_t to);
 
+/*!
+  \brief Create a watcher that is signalled when the channels it watches change state, ring, pre answer or answer
+  \param watcher the new watcher
+  \note the watcher is reference counted, every watched channel holds a reference until it is unwatched or destroyed
+*/
+SWITCH_DECLARE(switch_status_t) switch_channel_watcher_create(switch_channel_watcher_t **watcher);
+
+/*!
+  \brief Drop the reference of the creator, the watcher goes away once no channel watches it either
+*/
+SWITCH_DECLARE(void) switch_channel_watcher_release(switch_channel_watcher_t **watcher);
+
+/*!
+  \brief Have a watcher signalled on the changes of a channel
+  \return SWITCH_STATUS_FALSE if the channel already has SWITCH_CHANNEL_MAX_WATCHERS watchers, waits then time out instead
+*/
+SWITCH_DECLARE(switch_status_t) switch_channel_watch(switch_channel_t *channel, switch_channel_watcher_t *watcher);
+
+/*!
+  \brief Stop signalling a watcher, once this returns the channel no longer touches it
+*/
+SWITCH_DECLARE(void) switch_channel_unwatch(switch_channel_t *channel, switch_channel_watcher_t *watcher);
+
+/*!
+  \brief Wake whoever waits on a watcher
+*/
+SWITCH_DECLARE(void) switch_channel_watcher_signal(switch_channel_watcher_t *watcher);
+
+/*!
+  \brief Wait until the watcher is signalled or the timeout passes
+  \param watcher the watcher
+  \param timeout_ms the longest wait in milliseconds
+  \return SWITCH_STATUS_SUCCESS if it was signalled since the last wait, SWITCH_STATUS_TIMEOUT otherwise
+*/
+SWITCH_DECLARE(switch_status_t) switch_channel_watcher_wait(switch_channel_watcher_t *watcher, uint32_t timeout_ms);
+
 SWITCH_DECLARE(switch_channel_state_t) switch_channel_perform_set_state(switch_channel_t *channel,
 																		const char *file, const char *func, int line, switch_channel_state_t state);
 
@@ -308,6 +308,20 @@ SWITCH_DECLARE(void) switch_core_media_bug_resume(switch_core_session_t *session
 
 SWITCH_DECLARE(void) switch_core_media_bug_inuse(switch_media_bug_t *bug, switch_size_t *readp, switch_size_t *writep);
 
+/*!
+  \brief Report how far a media bug is behind the audio of its session
+  \param bug the bug to report on
+  \param stats receives the bytes and frames waiting to be read and the frames lost because the bug fell too far behind
+*/
+SWITCH_DECLARE(void) switch_core_media_bug_get_stats(switch_media_bug_t *bug, switch_media_bug_stats_t *stats);
+
+/*!
+  \brief Have switch_core_media_bug_read hand out audio at a given rate
+  \param bug the bug to set the rate on
+  \param rate the rate in hz, 0 to use the rate of the session
+*/
+SWITCH_DECLARE(void) switch_core_media_bug_set_rate(switch_media_bug_t *bug, uint32_t rate);
+
 /*!
   \brief Obtain private data from a media bug
   \param bug the bug to get the data from
@@ -467,6 +481,14 @@ SWITCH_DECLARE(switch_status_t) switch_core_port_allocator_request_port(_In_ swi
 */
 SWITCH_DECLARE(switch_status_t) switch_core_port_allocator_free_port(_In_ switch_core_port_allocator_t *alloc, _In_ switch_port_t port);
 
+/*!
+  \brief Get the number of ports handed out and the size of the range
+  \param alloc the allocator object
+  \param used the number of ports in use
+  \param total the number of ports the allocator can hand out
+*/
+SWITCH_DECLARE(void) switch_core_port_allocator_usage(_In_ switch_core_port_allocator_t *alloc, _Out_ uint32_t *used, _Out_ uint32_t *total);
+
 /*!
   \brief destroythe port allocator
   \param alloc the allocator object
@@ -1758,6 +1780,47 @@ SWITCH_DECLARE(switch_status_t) switch_core_codec_decode(switch_codec_t *codec,
 */
 SWITCH_DECLARE(switch_status_t) switch_core_codec_encode_video(switch_codec_t *codec, switch_frame_t *frame);
 
+/*! run the encoder once on frame->img, SWITCH_STATUS_MORE_DATA while more packets are to come */
+typedef switch_status_t (*switch_video_encode_func_t)(switch_core_session_t *session, switch_frame_t *frame);
+/*! write the packets of one frame, SWITCH_STATUS_INUSE when another thread is writing to the session */
+typedef switch_status_t (*switch_video_encode_write_func_t)(switch_core_session_t *session, switch_frame_t *packets, uint32_t count,
+															 switch_io_flag_t flags, int stream_id);
+
+/*!
+  \brief Start the threads that video frames can be handed to for encoding
+  \param threads the number of encoder threads, 0 leaves encoding in the writing thread
+  \param max_pending frames a session may have waiting, the oldest ones are dropped past that
+  \param affinity pin each thread to its own cpu
+*/
+SWITCH_DECLARE(switch_status_t) switch_core_video_encode_pool_start(uint32_t threads, uint32_t max_pending, switch_bool_t affinity);
+SWITCH_DECLARE(void) switch_core_video_encode_pool_stop(void);
+SWITCH_DECLARE(switch_bool_t) switch_core_video_encode_pool_active(void);
+/*!
+  \brief Queue an image to be encoded and written for a session
+  \param session the session to write to
+  \param frame the frame to send the image with, copied
+  \param img the image, taken over by the pool and set to NULL
+  \param encode called from a pool thread until the image is encoded
+  \param write called from a pool thread with all the packets, again later when it returns SWITCH_STATUS_INUSE
+  \note frames of one session are encoded one at a time and in order
+*/
+SWITCH_DECLARE(switch_status_t) switch_core_video_encode_pool_submit(switch_core_session_t *session, switch_frame_t *frame, switch_image_t **img,
+																	 switch_io_flag_t flags, int stream_id,
+																	 switch_video_encode_func_t encode, switch_video_encode_write_func_t write);
+/*!
+  \brief Drop the frames a session has queued and wait for the one being encoded, if any
+  \param session the session
+  \note call it once writes are blocked for other threads, so that no pool write follows
+*/
+SWITCH_DECLARE(void) switch_core_video_encode_pool_flush(switch_core_session_t *session);
+SWITCH_DECLARE(void) switch_core_video_encode_pool_counters(uint64_t *submitted, uint64_t *encoded, uint64_t *dropped);
+/*!
+  \brief Write the queue depth and frame latency of the video encode pool
+  \param stream where to write them
+  \param reset clear the counters once written
+*/
+SWITCH_DECLARE(void) switch_core_video_encode_pool_stats(switch_stream_handle_t *stream, switch_bool_t reset);
+
 
 /*!
   \brief send control data using a codec handle
@@ -2522,6 +2585,20 @@ SWITCH_DECLARE(void) switch_time_set_timerfd(int enable);
 SWITCH_DECLARE(void) switch_time_set_nanosleep(switch_bool_t enable);
 SWITCH_DECLARE(void) switch_time_set_matrix(switch_bool_t enable);
 SWITCH_DECLARE(void) switch_time_set_cond_yield(switch_bool_t enable);
+/*!
+  \brief Have soft timers of the same interval wait in groups each woken under its own lock
+  \param shards the number of groups per interval, 0 keeps the single condition per interval
+*/
+SWITCH_DECLARE(void) switch_time_set_timer_wheels(uint32_t shards);
+SWITCH_DECLARE(uint32_t) switch_time_get_timer_wheels(void);
+SWITCH_DECLARE(int) switch_time_get_timerfd(void);
+SWITCH_DECLARE(switch_bool_t) switch_time_get_matrix(void);
+/*!
+  \brief Write the wake latency and jitter histograms of the timer wheels
+  \param stream where to write them
+  \param reset clear the counters once written
+*/
+SWITCH_DECLARE(void) switch_time_timer_stats(switch_stream_handle_t *stream, switch_bool_t reset);
 SWITCH_DECLARE(void) switch_time_set_use_system_time(switch_bool_t enable);
 SWITCH_DECLARE(uint32_t) switch_core_min_dtmf_duration(uint32_t duration);
 SWITCH_DECLARE(uint32_t) switch_core_max_dtmf_duration(uint32_t duration);
@@ -2725,6 +2802,14 @@ SWITCH_DECLARE(int) switch_cache_db_load_extension(switch_cache_db_handle_t *dbh
  \param [in] stream stream for status
 */
 SWITCH_DECLARE(void) switch_cache_db_status(switch_stream_handle_t *stream);
+/*!
+  \brief Totals over the per database handle pools
+  \param pools number of databases handles were asked for
+  \param handles open handles
+  \param used handles currently held
+  \param waits times a caller had to wait for a handle
+*/
+SWITCH_DECLARE(void) switch_cache_db_pool_totals(uint32_t *pools, uint32_t *handles, uint32_t *used, uint64_t *waits);
 SWITCH_DECLARE(switch_status_t) _switch_core_db_handle(switch_cache_db_handle_t ** dbh, const char *file, const char *func, int line);
 #define switch_core_db_handle(_a) _switch_core_db_handle(_a, __FILE__, __SWITCH_FUNC__, __LINE__)
 
@@ -2767,6 +2852,32 @@ SWITCH_DECLARE(uint32_t) switch_default_ptime(const char *name, uint32_t number)
 SWITCH_DECLARE(uint32_t) switch_default_rate(const char *name, uint32_t number);
 SWITCH_DECLARE(uint32_t) switch_core_max_audio_channels(uint32_t limit);
 
+/*!
+  \brief Set the byte budget of the shared prompt cache
+  \param bytes the new budget, 0 to just query it
+  \return the current budget, 0 when the cache is disabled
+*/
+SWITCH_DECLARE(switch_size_t) switch_core_prompt_cache_size(switch_size_t bytes);
+
+/*!
+  \brief Drop decoded prompts from the shared prompt cache
+  \param path the file to drop, NULL for everything
+  \return the number of entries dropped
+*/
+SWITCH_DECLARE(uint32_t) switch_core_prompt_cache_flush(const char *path);
+
+/*!
+  \brief Provides per-file hit counts and usage of the shared prompt cache
+  \param [in] stream stream for status
+*/
+SWITCH_DECLARE(void) switch_core_prompt_cache_status(switch_stream_handle_t *stream);
+
+/*!
+  \brief Provides per-host request, reuse and latency counters of the pooled HTTP client (see switch_curl.h)
+  \param [in] stream stream for status
+*/
+SWITCH_DECLARE(void) switch_curl_pool_status(switch_stream_handle_t *stream);
+
 /*!
  \brief Add user registration
  \param [in] user
@@ -369,6 +369,13 @@ SWITCH_DECLARE(switch_status_t) switch_core_media_get_vid_params(switch_core_ses
 SWITCH_DECLARE(void) switch_core_session_write_blank_video(switch_core_session_t *session, uint32_t ms);
 SWITCH_DECLARE(switch_status_t) switch_core_media_lock_video_file(switch_core_session_t *session, switch_rw_t rw);
 SWITCH_DECLARE(switch_status_t) switch_core_media_unlock_video_file(switch_core_session_t *session, switch_rw_t rw);
+/*!
+  \brief Make the calling thread the only one writing video to the session until switch_core_media_unlock_video_write
+  \param session the session
+  \note frames the session has waiting on the video encode pool are dropped
+*/
+SWITCH_DECLARE(void) switch_core_media_lock_video_write(switch_core_session_t *session);
+SWITCH_DECLARE(void) switch_core_media_unlock_video_write(switch_core_session_t *session);
 SWITCH_DECLARE(switch_status_t) switch_core_media_set_video_file(switch_core_session_t *session, switch_file_handle_t *fh, switch_rw_t rw);
 SWITCH_DECLARE(switch_file_handle_t *) switch_core_media_get_video_file(switch_core_session_t *session, switch_rw_t rw);
 SWITCH_DECLARE(switch_bool_t) switch_core_session_in_video_thread(switch_core_session_t *session);
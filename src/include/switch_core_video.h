@@ -152,6 +152,27 @@ typedef enum {
 } switch_image_rotation_mode_t;
 
 
+/*!\brief Pick the fastest image row kernels the running cpu supports
+*
+* The alpha blends behind switch_img_patch and switch_img_overlay and the
+* chroma key cache check have plain C, SSE2 and AVX2 versions that give the
+* same bytes. Called once from switch_core_init, the plain C ones are used
+* until then.
+*/
+SWITCH_DECLARE(void) switch_img_simd_init(void);
+
+/*!\brief Force a specific set of image row kernels
+*
+* \param[in]    name      "scalar", "sse2", "avx2" or "auto"
+*
+* \return SWITCH_STATUS_FALSE if the name is unknown or the cpu lacks the instructions
+*/
+SWITCH_DECLARE(switch_status_t) switch_img_simd_set_impl(const char *name);
+
+/*!\brief Name of the image row kernels currently in use
+*/
+SWITCH_DECLARE(const char *) switch_img_simd_impl_name(void);
+
 /*!\brief Open a descriptor, allocating storage for the underlying image
 *
 * Returns a descriptor for storing an image of the given format. The
@@ -51,6 +51,25 @@ SWITCH_DECLARE(const char *) switch_curl_easy_strerror(switch_CURLcode errornum
 SWITCH_DECLARE(void) switch_curl_init(void);
 SWITCH_DECLARE(void) switch_curl_destroy(void);
 SWITCH_DECLARE(switch_status_t) switch_curl_process_form_post_params(switch_event_t *event, switch_CURL *curl_handle, struct curl_httppost **formpostp);
+
+/*!
+  \brief Take an easy handle from the per host pool of url, its connection, DNS and TLS session are reused when still alive
+  \note the handle comes reset, give it back with switch_curl_easy_release() rather than switch_curl_easy_cleanup()
+*/
+SWITCH_DECLARE(switch_CURL *) switch_curl_easy_acquire(const char *url);
+/*!
+  \brief Give a handle from switch_curl_easy_acquire() back to its pool and account the last request in the host metrics
+*/
+SWITCH_DECLARE(void) switch_curl_easy_release(switch_CURL *handle);
+
+typedef void (*switch_curl_async_callback_t)(switch_CURL *handle, switch_CURLcode code, void *user_data);
+/*!
+  \brief Run a configured handle on the shared multi handle, callback runs on the curl thread once the transfer is done
+  \note the callback owns the handle (release it there), CURLOPT_PRIVATE is used by the core while the transfer runs
+  and a module must wait for its callbacks before it unloads.  Every accepted request gets its callback, transfers
+  still running at shutdown get a few seconds to finish and are then called back with CURLE_ABORTED_BY_CALLBACK
+*/
+SWITCH_DECLARE(switch_status_t) switch_curl_easy_perform_async(switch_CURL *handle, switch_curl_async_callback_t callback, void *user_data);
 #define switch_curl_easy_setopt curl_easy_setopt
 
 SWITCH_END_EXTERN_C
@@ -0,0 +1,140 @@
+/*
+ * FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ * Copyright (C) 2005-2014, Anthony Minessale II <anthm@freeswitch.org>
+ *
+ * Version: MPL 1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ *
+ * The Initial Developer of the Original Code is
+ * Anthony Minessale II <anthm@freeswitch.org>
+ * Portions created by the Initial Developer are Copyright (C)
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *
+ *
+ * switch_dsp.h -- Vectorized signed linear DSP primitives
+ *
+ */
+/*!
+  \defgroup dsp1 Signed linear DSP primitives
+  \ingroup core1
+  \{
+*/
+#ifndef SWITCH_DSP_H
+#define SWITCH_DSP_H
+
+SWITCH_BEGIN_EXTERN_C
+
+/*!
+  \brief Pick the fastest implementation the running cpu supports
+  \note called once from switch_core_init, the scalar code is used until then
+*/
+SWITCH_DECLARE(void) switch_dsp_init(void);
+
+/*!
+  \brief Force a specific implementation ("scalar", "sse2", "avx2" or "auto")
+  \return SWITCH_STATUS_FALSE if the name is unknown or the cpu lacks the instructions
+*/
+SWITCH_DECLARE(switch_status_t) switch_dsp_set_impl(const char *name);
+
+/*!
+  \brief Name of the implementation currently in use
+*/
+SWITCH_DECLARE(const char *) switch_dsp_impl_name(void);
+
+/*!
+  \brief Sum of the absolute values of samples taken every stride samples
+  \param data the audio
+  \param samples the number of samples to visit
+  \param stride distance between visited samples (the channel count for interleaved audio)
+*/
+SWITCH_DECLARE(uint64_t) switch_dsp_energy(const int16_t *data, uint32_t samples, uint32_t stride);
+
+/*!
+  \brief Largest absolute value among samples taken every stride samples (0..32768)
+*/
+SWITCH_DECLARE(uint32_t) switch_dsp_peak(const int16_t *data, uint32_t samples, uint32_t stride);
+
+/*!
+  \brief Number of sign changes between consecutive samples taken every stride samples
+*/
+SWITCH_DECLARE(uint32_t) switch_dsp_zero_crossings(const int16_t *data, uint32_t samples, uint32_t stride);
+
+/*!
+  \brief Scale samples in place by gain, truncating toward zero and saturating to 16 bits
+  \note gives the same result as the (int32_t) (sample * gain) loops it replaces, gain must stay below 65536
+*/
+SWITCH_DECLARE(void) switch_dsp_gain(int16_t *data, uint32_t samples, double gain);
+
+/*!
+  \brief Add other into data with 16 bit saturation
+*/
+SWITCH_DECLARE(void) switch_dsp_mix(int16_t *data, const int16_t *other, uint32_t samples);
+
+/*!
+  \brief Saturate a 32 bit accumulator down to 16 bit samples
+*/
+SWITCH_DECLARE(void) switch_dsp_clamp_to_16bit(const int32_t *in, int16_t *out, uint32_t samples);
+
+/*!
+  \brief Run a bank of goertzel filters over the same block of audio
+  \param data the audio
+  \param samples the number of samples in the block
+  \param coefs 2 * cos(2 * pi * freq / rate) for each filter
+  \param filters the number of filters in the bank
+  \param power receives the squared magnitude at each frequency for the block
+*/
+SWITCH_DECLARE(void) switch_dsp_goertzel_bank(const int16_t *data, uint32_t samples, const float *coefs, uint32_t filters, float *power);
+
+/*! Most multi-frequency tones one switch_dsp_tone_bank_t can watch for */
+#define SWITCH_DSP_TONE_BANK_MAX 32
+
+typedef struct switch_dsp_tone_bank_s switch_dsp_tone_bank_t;
+
+/*!
+  \brief Create a detector for several multi-frequency tones sharing one filter bank
+  \param bank the new bank
+  \param rate the sample rate of the audio that will be fed to it
+  \param pool the pool to allocate from
+  \note the decision logic is the one of teletone_multi_tone_detect, the frequencies of
+  every tone are run through one switch_dsp_goertzel_bank pass per block of audio
+*/
+SWITCH_DECLARE(switch_status_t) switch_dsp_tone_bank_create(switch_dsp_tone_bank_t **bank, uint32_t rate, switch_memory_pool_t *pool);
+
+/*!
+  \brief Add a tone made of one or more frequencies
+  \return the index of the tone, or -1 if the bank is full
+*/
+SWITCH_DECLARE(int) switch_dsp_tone_bank_add(switch_dsp_tone_bank_t *bank, const double *freqs, uint32_t count);
+
+/*!
+  \brief Feed audio to the bank
+  \param active bit mask of the tones to look for, the others keep their state untouched
+  \return bit mask of the tones that were detected in this audio
+*/
+SWITCH_DECLARE(uint32_t) switch_dsp_tone_bank_feed(switch_dsp_tone_bank_t *bank, const int16_t *data, uint32_t samples, uint32_t active);
+
+SWITCH_END_EXTERN_C
+#endif
+/* For Emacs:
+ * Local Variables:
+ * mode:c
+ * indent-tabs-mode:t
+ * tab-width:4
+ * c-basic-offset:4
+ * End:
+ * For VIM:
+ * vim:set softtabstop=4 shiftwidth=4 tabstop=4 noet:
+ */
@@ -74,6 +74,8 @@ SWITCH_BEGIN_EXTERN_C
 	/*! hash of the header name */
 	unsigned long hash;
 	struct switch_event_header *next;
+	/*! where the header and its strings live, private to the event engine */
+	uint32_t flags;
 };
 
 /*! \brief Representation of an event */
@@ -100,6 +102,8 @@ struct switch_event {
 	unsigned long key;
 	struct switch_event *next;
 	int flags;
+	/*! storage for the headers, freed along with the event */
+	struct switch_event_arena *arena;
 };
 
 typedef struct switch_serial_event_s {
@@ -46,6 +46,45 @@ extern "C"
 SWITCH_DECLARE(cJSON *) cJSON_CreateStringPrintf(const char *fmt, ...);
 SWITCH_DECLARE(const char *)cJSON_GetObjectCstr(const cJSON *object, const char *string);
 
+/*!
+  \brief Streaming JSON encoder writing straight into one growable buffer
+  \note the output is byte for byte what cJSON_PrintUnformatted gives for the same tree
+  without building the tree, keep it on the stack and hand it some stack storage to start with
+*/
+typedef struct {
+	char *data;
+	switch_size_t len;
+	switch_size_t size;
+	char *initial;
+	uint8_t first;
+	uint8_t pending_key;
+} switch_json_writer_t;
+
+SWITCH_DECLARE(void) switch_json_writer_init(switch_json_writer_t *w, char *buf, switch_size_t size);
+/*! \brief Start over, keeping whatever memory the writer already has */
+SWITCH_DECLARE(void) switch_json_writer_reset(switch_json_writer_t *w);
+SWITCH_DECLARE(void) switch_json_writer_destroy(switch_json_writer_t *w);
+SWITCH_DECLARE(void) switch_json_writer_object_start(switch_json_writer_t *w);
+SWITCH_DECLARE(void) switch_json_writer_object_end(switch_json_writer_t *w);
+SWITCH_DECLARE(void) switch_json_writer_array_start(switch_json_writer_t *w);
+SWITCH_DECLARE(void) switch_json_writer_array_end(switch_json_writer_t *w);
+SWITCH_DECLARE(void) switch_json_writer_key(switch_json_writer_t *w, const char *name);
+/*! \brief Write prefix and name as one key without joining them first, prefix may be NULL */
+SWITCH_DECLARE(void) switch_json_writer_key_prefixed(switch_json_writer_t *w, const char *prefix, const char *name);
+SWITCH_DECLARE(void) switch_json_writer_string(switch_json_writer_t *w, const char *val);
+SWITCH_DECLARE(void) switch_json_writer_number(switch_json_writer_t *w, double val);
+/*! \brief Encode an existing cJSON item as the next value */
+SWITCH_DECLARE(void) switch_json_writer_cjson(switch_json_writer_t *w, const cJSON *item);
+/*!
+  \brief Add a string member, like cJSON_AddItemToObject the member is left out when name or val is NULL
+*/
+SWITCH_DECLARE(void) switch_json_writer_add_string(switch_json_writer_t *w, const char *name, const char *val);
+SWITCH_DECLARE(void) switch_json_writer_add_number(switch_json_writer_t *w, const char *name, double val);
+/*! \brief The text written so far, owned by the writer */
+SWITCH_DECLARE(const char *) switch_json_writer_get(switch_json_writer_t *w);
+/*! \brief A malloc'd copy of the text written so far */
+SWITCH_DECLARE(char *) switch_json_writer_dup(switch_json_writer_t *w);
+
 static inline cJSON *json_add_child_obj(cJSON *json, const char *name, cJSON *obj)
 {
 	cJSON *new_json = NULL;
@@ -345,6 +345,42 @@ SWITCH_DECLARE(switch_status_t) switch_loadable_module_protect(const char *mod);
 */
 SWITCH_DECLARE(switch_status_t) switch_loadable_module_unload_module(const char *dir, const char *fname, switch_bool_t force, const char **err);
 
+typedef switch_status_t (*switch_loadable_module_task_t) (void *obj);
+
+/*!
+  \brief Finish part of the initialization of a module after its load function returned
+  \param modname the name of the module the work belongs to
+  \param what a short description of the work for the startup timeline
+  \param task the function to run
+  \param obj the argument for task
+  \return the status
+  \note while modules.conf is loaded in parallel the task runs on the loader threads and startup waits for it
+  before the core is declared ready, otherwise it runs right away in the calling thread
+*/
+SWITCH_DECLARE(switch_status_t) switch_loadable_module_defer(const char *modname, const char *what, switch_loadable_module_task_t task, void *obj);
+
+/*!
+  \brief Print when every module load and deferred task started and how long it took
+  \param stream the stream to print to
+*/
+SWITCH_DECLARE(void) switch_loadable_module_timeline(switch_stream_handle_t *stream);
+
+typedef switch_status_t (*switch_loadable_module_load_func_t) (const char *path, const char *name, switch_bool_t global, void *user_data);
+
+/*!
+  \brief Load the <load> entries of a modules.conf style list
+  \param mods the node holding the <load> entries
+  \param threads the number of loader threads, 0 or 1 loads the entries one after the other
+  \param load_func the function loading one entry, NULL loads the module
+  \param user_data the last argument for load_func
+  \param failed set to the name of the critical module that failed to load, free it with free()
+  \return the number of entries handled
+  \note on more than one thread an entry with a depends or parallel attribute waits only for the modules it names,
+  the other entries still load in file order
+*/
+SWITCH_DECLARE(unsigned int) switch_loadable_module_load_list(switch_xml_t mods, uint32_t threads, switch_loadable_module_load_func_t load_func,
+															  void *user_data, char **failed);
+
 /* Prototypes of module interface functions */
 
 /*!
@@ -39,6 +39,7 @@
 #define SWITCH_LOG_H
 
 #include <switch.h>
+#include "switch_json.h"
 
 SWITCH_BEGIN_EXTERN_C
 ///\defgroup log Logger Routines
@@ -112,6 +113,18 @@ typedef switch_status_t (*switch_log_function_t) (const switch_log_node_t *node,
 */
 SWITCH_DECLARE(cJSON *) switch_log_node_to_json(const switch_log_node_t *node, int log_level, switch_log_json_format_t *json_format, switch_event_t *chan_vars);
 
+/*!
+  \brief Convert a log node to JSON text.  Free the text when finished.
+  \note same output as printing switch_log_node_to_json unformatted, without building the tree
+*/
+SWITCH_DECLARE(char *) switch_log_node_to_json_string(const switch_log_node_t *node, int log_level, switch_log_json_format_t *json_format, switch_event_t *chan_vars);
+
+/*!
+  \brief Write the fields of a log node into an object the caller has started on w
+  \note lets the caller add its own fields before ending the object
+*/
+SWITCH_DECLARE(void) switch_log_node_json_write(switch_json_writer_t *w, const switch_log_node_t *node, int log_level, switch_log_json_format_t *json_format, switch_event_t *chan_vars);
+
 /*!
   \brief Initilize the logging engine
   \param pool the memory pool to use
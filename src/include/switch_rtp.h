@@ -209,6 +209,19 @@ SWITCH_DECLARE(switch_status_t) switch_rtp_set_remote_ssrc(switch_rtp_t *rtp_ses
 */
 SWITCH_DECLARE(switch_port_t) switch_rtp_set_end_port(switch_port_t port);
 
+/*!
+  \brief Set/Get the number of pre-bound RTP/RTCP socket pairs kept ready per media ip
+  \param size new value (0 disables the pool)
+  \return the current pool size
+*/
+SWITCH_DECLARE(uint32_t) switch_rtp_set_socket_pool_size(uint32_t size);
+
+/*!
+  \brief Provides port allocation and socket pool counters, including how long requests waited on a port
+  \param stream stream for status
+*/
+SWITCH_DECLARE(void) switch_rtp_port_status(switch_stream_handle_t *stream);
+
 /*!
   \brief Request a new port to be used for media
   \param ip the ip to request a port from
@@ -591,7 +591,9 @@ SWITCH_DECLARE_DATA extern switch_filenames SWITCH_GLOBAL_filenames;
 #define SWITCH_RECOMMENDED_BUFFER_SIZE 8192
 #define SWITCH_MAX_CODECS 50
 #define SWITCH_MAX_STATE_HANDLERS 30
+#define SWITCH_CHANNEL_MAX_WATCHERS 4
 #define SWITCH_CORE_QUEUE_LEN 100000
+#define SWITCH_MAX_RECORD_WRITER_THREADS 64
 #define SWITCH_MAX_MANAGEMENT_BUFFER_LEN 1024 * 8
 
 #define SWITCH_ACCEPTABLE_INTERVAL(_i) (_i && _i <= SWITCH_MAX_INTERVAL && (_i % 10) == 0)
@@ -1921,6 +1923,15 @@ typedef enum {
 } switch_media_bug_flag_enum_t;
 typedef uint32_t switch_media_bug_flag_t;
 
+typedef struct {
+	switch_size_t read_lag_bytes;
+	uint32_t read_lag_frames;
+	uint32_t read_overruns;
+	switch_size_t write_lag_bytes;
+	uint32_t write_lag_frames;
+	uint32_t write_overruns;
+} switch_media_bug_stats_t;
+
 /*!
   \enum switch_file_flag_t
   \brief File flags
@@ -1937,6 +1948,7 @@ SWITCH_FILE_PAUSE =             (1 <<  8) - Pause
 SWITCH_FILE_NATIVE =            (1 <<  9) - File is in native format (no transcoding)
 SWITCH_FILE_SEEK = 				(1 << 10) - File has done a seek
 SWITCH_FILE_OPEN =              (1 << 11) - File is open
+SWITCH_FILE_NOCACHE =           (1 << 22) - Bypass the shared prompt cache
 </pre>
  */
 typedef enum {
@@ -1961,7 +1973,8 @@ typedef enum {
 	SWITCH_FILE_BREAK_ON_CHANGE = (1 << 18),
 	SWITCH_FILE_FLAG_VIDEO = (1 << 19),
 	SWITCH_FILE_FLAG_VIDEO_EOF = (1 << 20),
-	SWITCH_FILE_PRE_CLOSED = (1 << 21)
+	SWITCH_FILE_PRE_CLOSED = (1 << 21),
+	SWITCH_FILE_NOCACHE = (1 << 22)
 } switch_file_flag_enum_t;
 typedef uint32_t switch_file_flag_t;
 
@@ -2339,6 +2352,7 @@ typedef struct switch_loadable_module switch_loadable_module_t;
 typedef struct switch_frame switch_frame_t;
 typedef struct switch_rtcp_frame switch_rtcp_frame_t;
 typedef struct switch_channel switch_channel_t;
+typedef struct switch_channel_watcher switch_channel_watcher_t;
 typedef struct switch_sql_queue_manager switch_sql_queue_manager_t;
 typedef struct switch_file_handle switch_file_handle_t;
 typedef struct switch_caller_profile switch_caller_profile_t;
@@ -67,6 +67,7 @@ struct switch_xml_binding;
 ///\{
 SWITCH_BEGIN_EXTERN_C
 #define SWITCH_XML_BUFSIZE 1024	// size of internal memory buffers
+#define SWITCH_XML_CACHE_FLUSH_EVENT "xml::flush_cache"	// custom event subclass that drops cached users (headers: key, user, domain)
 	typedef enum {
 	SWITCH_XML_ROOT = (1 << 0),	// root
 	SWITCH_XML_NAMEM = (1 << 1),	// name is malloced
@@ -146,6 +147,17 @@ SWITCH_DECLARE(switch_xml_t) switch_xml_parse_file(_In_z_ const char *file);
 
 SWITCH_DECLARE(switch_xml_t) switch_xml_parse_file_simple(_In_z_ const char *file);
 
+///\brief write a parsed tree to a binary file switch_xml_parse_cache() can load without parsing
+///\param xml the tree to write
+///\param file the file to write, replaced atomically
+///\return SWITCH_STATUS_SUCCESS if the file was written
+SWITCH_DECLARE(switch_status_t) switch_xml_write_cache(_In_ switch_xml_t xml, _In_z_ const char *file);
+
+///\brief load a tree written by switch_xml_write_cache() or by the core for its own root
+///\param file the file to load
+///\return the tree or NULL if the file is missing, damaged, from another build or stale
+SWITCH_DECLARE(switch_xml_t) switch_xml_parse_cache(_In_z_ const char *file);
+
 ///\brief Wrapper for switch_xml_parse_str() that accepts a file stream. Reads the entire
 ///\ stream into memory and then parses it. For xml files, use switch_xml_parse_file()
 ///\ or switch_xml_parse_fd()
@@ -344,8 +356,13 @@ SWITCH_DECLARE(switch_status_t) switch_xml_set_root(switch_xml_t new_main);
 ///\brief Set and alternate function for opening xml root
 SWITCH_DECLARE(switch_status_t) switch_xml_set_open_root_function(switch_xml_open_root_function_t func, void *user_data);
 
+/*! reload value for switch_xml_open_root() that runs the preprocessor even if none of its inputs changed */
+#define SWITCH_XML_RELOAD_FORCE 2
+
 ///\brief open the Core xml root
-///\param reload if it's is already open close it and open it again as soon as permissable (blocking)
+///\param reload if it's is already open close it and open it again as soon as permissable (blocking),
+///\ the current tree is kept when no file, include pattern or variable the preprocessor read has changed
+///\ unless reload is SWITCH_XML_RELOAD_FORCE
 ///\param err a pointer to set error strings
 ///\return the xml root node or NULL
 SWITCH_DECLARE(switch_xml_t) switch_xml_open_root(_In_ uint8_t reload, _Out_ const char **err);
@@ -399,10 +416,16 @@ SWITCH_DECLARE(switch_status_t) switch_xml_locate_user(_In_z_ const char *key,
 SWITCH_DECLARE(switch_status_t) switch_xml_locate_user_in_domain(_In_z_ const char *user_name, _In_ switch_xml_t domain, _Out_ switch_xml_t *user,
 																 _Out_opt_ switch_xml_t *ingroup);
 
+///\brief hash the users of the directory section of a parsed document by id, number-alias and ip
+///\param xml the root of the document
+///\return the number of users that were indexed
+///\note switch_xml_set_root does this for every new root, lookups on unindexed trees walk the users
+SWITCH_DECLARE(uint32_t) switch_xml_index_directory(_In_ switch_xml_t xml);
 
 SWITCH_DECLARE(switch_status_t) switch_xml_locate_user_merged(const char *key, const char *user_name, const char *domain_name,
 															  const char *ip, switch_xml_t *user, switch_event_t *params);
 SWITCH_DECLARE(uint32_t) switch_xml_clear_user_cache(const char *key, const char *user_name, const char *domain_name);
+SWITCH_DECLARE(void) switch_xml_user_cache_status(switch_stream_handle_t *stream);
 SWITCH_DECLARE(void) switch_xml_merge_user(switch_xml_t user, switch_xml_t domain, switch_xml_t group);
 
 SWITCH_DECLARE(switch_xml_t) switch_xml_dup(switch_xml_t xml);
@@ -421,6 +421,30 @@ typedef enum {
 	PFLAG_DESTROY = 1 << 0
 } cc_flags_t;
 
+/* Availability of an agent as last written by this module, used to skip the agent SQL for queues nobody can answer */
+typedef struct cc_agent_index_entry {
+	cc_agent_status_t status;
+	cc_agent_state_t state;
+} cc_agent_index_entry_t;
+
+/* The agents of a queue, with the number of them that could take a call now and that are logged in */
+typedef struct cc_agent_index_queue {
+	switch_hash_t *agents;		/* agent name -> cc_agent_index_entry_t */
+	uint32_t idle;
+	uint32_t logged_in;
+} cc_agent_index_queue_t;
+
+struct cc_agent_index {
+	switch_hash_t *agents;		/* agent name -> cc_agent_index_entry_t */
+	switch_hash_t *queues;		/* queue name -> cc_agent_index_queue_t */
+};
+
+/* Shortest gap between two dispatch passes, so a burst of joins and state changes is handled in one pass */
+#define CC_DISPATCH_MIN_GAP 20000
+
+/* Default seconds between two full reloads of the agent index */
+#define CC_AGENT_INDEX_RESYNC 30
+
 static struct {
 	switch_hash_t *queue_hash;
 	int debug;
@@ -437,6 +461,27 @@ static struct {
 	switch_memory_pool_t *pool;
 	switch_event_node_t *node;
 	int agent_originate_timeout;
+
+	uint32_t dispatch_interval;
+	switch_mutex_t *dispatch_mutex;
+	switch_thread_cond_t *dispatch_cond;
+	int dispatch_pending;
+	/* under dispatch_mutex */
+	struct {
+		uint64_t passes;
+		uint64_t members;
+		uint64_t agent_queries;
+		uint64_t agent_queries_skipped;
+		uint64_t offers;
+	} dispatch_stats;
+
+	switch_bool_t agent_index_enabled;
+	switch_mutex_t *index_mutex;
+	struct cc_agent_index agent_index;
+	uint32_t agent_index_updates;
+	int agent_index_stale;
+	uint32_t agent_index_resync;
+	time_t agent_index_synced;
 } globals;
 
 #define CC_QUEUE_CONFIGITEM_COUNT 100
@@ -713,6 +758,374 @@ end:
 	return ret;
 }
 
+/* Wake the dispatch thread, something happened that may let a member reach an agent */
+static void cc_dispatch_kick(void)
+{
+	if (!globals.dispatch_mutex) {
+		return;
+	}
+
+	switch_mutex_lock(globals.dispatch_mutex);
+	globals.dispatch_pending = 1;
+	switch_thread_cond_signal(globals.dispatch_cond);
+	switch_mutex_unlock(globals.dispatch_mutex);
+}
+
+#define cc_dispatch_stat_inc(_field) do { switch_mutex_lock(globals.dispatch_mutex); globals.dispatch_stats._field++; switch_mutex_unlock(globals.dispatch_mutex); } while (0)
+
+static char agent_index_sql[] =
+"SELECT agents.name, agents.status, agents.state, tiers.queue FROM agents LEFT JOIN tiers ON (agents.name = tiers.agent)";
+
+static void cc_agent_index_count(cc_agent_index_queue_t *q, cc_agent_index_entry_t *entry, int sign)
+{
+	if (entry->status == CC_AGENT_STATUS_AVAILABLE || entry->status == CC_AGENT_STATUS_AVAILABLE_ON_DEMAND) {
+		q->logged_in += sign;
+		if (entry->state == CC_AGENT_STATE_WAITING) {
+			q->idle += sign;
+		}
+	} else if (entry->status == CC_AGENT_STATUS_ON_BREAK) {
+		q->logged_in += sign;
+	}
+}
+
+/* Add (sign 1) or take (sign -1) the agent to the counts of every queue it is in, around a change of its status or state */
+static void cc_agent_index_count_all(struct cc_agent_index *idx, const char *agent_name, cc_agent_index_entry_t *entry, int sign)
+{
+	switch_hash_index_t *hi;
+	void *val;
+
+	for (hi = switch_core_hash_first(idx->queues); hi; hi = switch_core_hash_next(&hi)) {
+		cc_agent_index_queue_t *q;
+
+		switch_core_hash_this(hi, NULL, NULL, &val);
+		q = (cc_agent_index_queue_t *) val;
+		if (switch_core_hash_find(q->agents, agent_name)) {
+			cc_agent_index_count(q, entry, sign);
+		}
+	}
+}
+
+static void cc_agent_index_link(struct cc_agent_index *idx, const char *queue_name, const char *agent_name, cc_agent_index_entry_t *entry)
+{
+	cc_agent_index_queue_t *q;
+
+	if (!(q = switch_core_hash_find(idx->queues, queue_name))) {
+		switch_zmalloc(q, sizeof(*q));
+		switch_core_hash_init(&q->agents);
+		switch_core_hash_insert(idx->queues, queue_name, q);
+	}
+
+	if (!switch_core_hash_find(q->agents, agent_name)) {
+		switch_core_hash_insert(q->agents, agent_name, entry);
+		cc_agent_index_count(q, entry, 1);
+	}
+}
+
+static void cc_agent_index_destroy(struct cc_agent_index *idx)
+{
+	switch_hash_index_t *hi;
+	void *val;
+
+	for (hi = switch_core_hash_first(idx->queues); hi; hi = switch_core_hash_next(&hi)) {
+		cc_agent_index_queue_t *q;
+
+		switch_core_hash_this(hi, NULL, NULL, &val);
+		q = (cc_agent_index_queue_t *) val;
+		switch_core_hash_destroy(&q->agents);
+		free(q);
+	}
+
+	for (hi = switch_core_hash_first(idx->agents); hi; hi = switch_core_hash_next(&hi)) {
+		switch_core_hash_this(hi, NULL, NULL, &val);
+		free(val);
+	}
+
+	switch_core_hash_destroy(&idx->queues);
+	switch_core_hash_destroy(&idx->agents);
+}
+
+static int agent_index_callback(void *pArg, int argc, char **argv, char **columnNames)
+{
+	struct cc_agent_index *idx = (struct cc_agent_index *) pArg;
+	const char *agent_name = argv[0];
+	const char *agent_status = argv[1];
+	const char *agent_state = argv[2];
+	const char *queue_name = argv[3];
+	cc_agent_index_entry_t *entry;
+
+	if (zstr(agent_name)) {
+		return 0;
+	}
+
+	if (!(entry = switch_core_hash_find(idx->agents, agent_name))) {
+		switch_zmalloc(entry, sizeof(*entry));
+		entry->status = cc_agent_str2status(switch_str_nil(agent_status));
+		entry->state = cc_agent_str2state(switch_str_nil(agent_state));
+		switch_core_hash_insert(idx->agents, agent_name, entry);
+	}
+
+	if (!zstr(queue_name)) {
+		cc_agent_index_link(idx, queue_name, agent_name, entry);
+	}
+
+	return 0;
+}
+
+/* Reload the index from the database, given up if the index was written to meanwhile (we stay stale and retry on the next pass) */
+static void cc_agent_index_sync(void)
+{
+	struct cc_agent_index idx = { 0 };
+	uint32_t updates;
+
+	switch_mutex_lock(globals.index_mutex);
+	updates = globals.agent_index_updates;
+	switch_mutex_unlock(globals.index_mutex);
+
+	switch_core_hash_init(&idx.agents);
+	switch_core_hash_init(&idx.queues);
+
+	cc_execute_sql_callback(NULL /* queue */, NULL /* mutex */, agent_index_sql, agent_index_callback, &idx);
+
+	switch_mutex_lock(globals.index_mutex);
+	if (updates == globals.agent_index_updates) {
+		struct cc_agent_index old = globals.agent_index;
+
+		globals.agent_index = idx;
+		globals.agent_index_stale = 0;
+		globals.agent_index_synced = switch_epoch_time_now(NULL);
+		idx = old;
+	}
+	switch_mutex_unlock(globals.index_mutex);
+
+	if (idx.agents) {
+		cc_agent_index_destroy(&idx);
+	}
+}
+
+static void cc_agent_index_add(const char *agent_name, cc_agent_status_t status, cc_agent_state_t state)
+{
+	cc_agent_index_entry_t *entry;
+
+	if (!globals.agent_index_enabled) {
+		return;
+	}
+
+	switch_mutex_lock(globals.index_mutex);
+	globals.agent_index_updates++;
+	if (globals.agent_index.agents) {
+		if (!(entry = switch_core_hash_find(globals.agent_index.agents, agent_name))) {
+			switch_zmalloc(entry, sizeof(*entry));
+			switch_core_hash_insert(globals.agent_index.agents, agent_name, entry);
+		}
+		cc_agent_index_count_all(&globals.agent_index, agent_name, entry, -1);
+		entry->status = status;
+		entry->state = state;
+		cc_agent_index_count_all(&globals.agent_index, agent_name, entry, 1);
+	}
+	switch_mutex_unlock(globals.index_mutex);
+}
+
+static void cc_agent_index_update(const char *agent_name, const char *status, const char *state)
+{
+	cc_agent_index_entry_t *entry;
+
+	if (!globals.agent_index_enabled) {
+		return;
+	}
+
+	switch_mutex_lock(globals.index_mutex);
+	globals.agent_index_updates++;
+	if (globals.agent_index.agents && (entry = switch_core_hash_find(globals.agent_index.agents, agent_name))) {
+		cc_agent_index_count_all(&globals.agent_index, agent_name, entry, -1);
+		if (status) {
+			entry->status = cc_agent_str2status(status);
+		}
+		if (state) {
+			entry->state = cc_agent_str2state(state);
+		}
+		cc_agent_index_count_all(&globals.agent_index, agent_name, entry, 1);
+	} else {
+		/* Agent was added behind our back */
+		globals.agent_index_stale = 1;
+	}
+	switch_mutex_unlock(globals.index_mutex);
+}
+
+static void cc_agent_index_del(const char *agent_name)
+{
+	cc_agent_index_entry_t *entry;
+	switch_hash_index_t *hi;
+	void *val;
+
+	if (!globals.agent_index_enabled) {
+		return;
+	}
+
+	switch_mutex_lock(globals.index_mutex);
+	globals.agent_index_updates++;
+	if (globals.agent_index.agents && (entry = switch_core_hash_find(globals.agent_index.agents, agent_name))) {
+		for (hi = switch_core_hash_first(globals.agent_index.queues); hi; hi = switch_core_hash_next(&hi)) {
+			cc_agent_index_queue_t *q;
+
+			switch_core_hash_this(hi, NULL, NULL, &val);
+			q = (cc_agent_index_queue_t *) val;
+			if (switch_core_hash_delete(q->agents, agent_name)) {
+				cc_agent_index_count(q, entry, -1);
+			}
+		}
+		switch_core_hash_delete(globals.agent_index.agents, agent_name);
+		free(entry);
+	}
+	switch_mutex_unlock(globals.index_mutex);
+}
+
+static void cc_agent_index_tier_add(const char *queue_name, const char *agent_name)
+{
+	cc_agent_index_entry_t *entry;
+
+	if (!globals.agent_index_enabled) {
+		return;
+	}
+
+	switch_mutex_lock(globals.index_mutex);
+	globals.agent_index_updates++;
+	if (globals.agent_index.agents && (entry = switch_core_hash_find(globals.agent_index.agents, agent_name))) {
+		cc_agent_index_link(&globals.agent_index, queue_name, agent_name, entry);
+	} else {
+		globals.agent_index_stale = 1;
+	}
+	switch_mutex_unlock(globals.index_mutex);
+}
+
+static void cc_agent_index_tier_del(const char *queue_name, const char *agent_name)
+{
+	cc_agent_index_queue_t *q;
+	cc_agent_index_entry_t *entry;
+
+	if (!globals.agent_index_enabled) {
+		return;
+	}
+
+	switch_mutex_lock(globals.index_mutex);
+	globals.agent_index_updates++;
+	if (globals.agent_index.queues && (q = switch_core_hash_find(globals.agent_index.queues, queue_name)) &&
+		(entry = switch_core_hash_delete(q->agents, agent_name))) {
+		cc_agent_index_count(q, entry, -1);
+	}
+	switch_mutex_unlock(globals.index_mutex);
+}
+
+static void cc_agent_index_totals(uint32_t *agents, uint32_t *ready)
+{
+	switch_hash_index_t *hi;
+	void *val;
+
+	*agents = *ready = 0;
+
+	for (hi = switch_core_hash_first(globals.agent_index.agents); hi; hi = switch_core_hash_next(&hi)) {
+		cc_agent_index_entry_t *entry;
+
+		switch_core_hash_this(hi, NULL, NULL, &val);
+		entry = (cc_agent_index_entry_t *) val;
+		(*agents)++;
+		if ((entry->status == CC_AGENT_STATUS_AVAILABLE || entry->status == CC_AGENT_STATUS_AVAILABLE_ON_DEMAND) &&
+			entry->state == CC_AGENT_STATE_WAITING) {
+			(*ready)++;
+		}
+	}
+}
+
+static int agent_index_totals_callback(void *pArg, int argc, char **argv, char **columnNames)
+{
+	uint32_t *totals = (uint32_t *) pArg;
+
+	totals[0] = argv[0] ? atoi(argv[0]) : 0;
+	totals[1] = argv[1] ? atoi(argv[1]) : 0;
+
+	return 0;
+}
+
+/*
+  Mark the index stale when the agents table no longer has the agents it counts, or the number of them ready
+  for a call, which is what another box or a direct write to a shared database leaves behind.
+  Changes that keep both counts (tiers, agents swapping states) are caught by the periodic resync.
+*/
+static void cc_agent_index_verify(void)
+{
+	char *sql;
+	uint32_t db[2] = { 0 }, agents, ready, updates;
+	const char *why = NULL;
+
+	if (!globals.agent_index_enabled || globals.agent_index_stale) {
+		return;
+	}
+
+	if (globals.agent_index_resync && switch_epoch_time_now(NULL) - globals.agent_index_synced >= globals.agent_index_resync) {
+		why = "resync interval reached";
+		goto stale;
+	}
+
+	switch_mutex_lock(globals.index_mutex);
+	updates = globals.agent_index_updates;
+	switch_mutex_unlock(globals.index_mutex);
+
+	sql = switch_mprintf("SELECT COUNT(*), SUM(CASE WHEN (status = '%q' OR status = '%q') AND state = '%q' THEN 1 ELSE 0 END) FROM agents",
+						 cc_agent_status2str(CC_AGENT_STATUS_AVAILABLE), cc_agent_status2str(CC_AGENT_STATUS_AVAILABLE_ON_DEMAND),
+						 cc_agent_state2str(CC_AGENT_STATE_WAITING));
+	cc_execute_sql_callback(NULL /* queue */, NULL /* mutex */, sql, agent_index_totals_callback, db);
+	switch_safe_free(sql);
+
+	switch_mutex_lock(globals.index_mutex);
+	/* our own writes may sit between the database and the index, only compare when nothing changed meanwhile */
+	if (updates == globals.agent_index_updates && globals.agent_index.agents) {
+		cc_agent_index_totals(&agents, &ready);
+		if (agents != db[0] || ready != db[1]) {
+			why = "agents changed in the database";
+		}
+	}
+	switch_mutex_unlock(globals.index_mutex);
+
+	if (!why) {
+		return;
+	}
+
+stale:
+	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "Agent dispatch index stale, %s\n", why);
+	switch_mutex_lock(globals.index_mutex);
+	globals.agent_index_stale = 1;
+	switch_mutex_unlock(globals.index_mutex);
+}
+
+/*
+  Returns SWITCH_FALSE only when the index knows that no agent of the queue can take a call right now,
+  logged_in tells if the queue has any agent the members_callback() would have found
+*/
+static switch_bool_t cc_agent_index_check(const char *queue_name, switch_bool_t *logged_in)
+{
+	switch_bool_t ready = SWITCH_TRUE;
+	cc_agent_index_queue_t *q;
+
+	*logged_in = SWITCH_TRUE;
+
+	if (!globals.agent_index_enabled) {
+		return ready;
+	}
+
+	switch_mutex_lock(globals.index_mutex);
+	if (globals.agent_index.queues && !globals.agent_index_stale) {
+		ready = SWITCH_FALSE;
+		*logged_in = SWITCH_FALSE;
+
+		if ((q = switch_core_hash_find(globals.agent_index.queues, queue_name))) {
+			ready = q->idle ? SWITCH_TRUE : SWITCH_FALSE;
+			*logged_in = q->logged_in ? SWITCH_TRUE : SWITCH_FALSE;
+		}
+	}
+	switch_mutex_unlock(globals.index_mutex);
+
+	return ready;
+}
+
 static cc_queue_t *load_queue(const char *queue_name, switch_bool_t request_agents, switch_bool_t request_tiers, switch_xml_t x_queues_cfg)
 {
 	cc_queue_t *queue = NULL;
@@ -912,6 +1325,8 @@ cc_status_t cc_agent_add(const char *agent, const char *type)
 		cc_execute_sql(NULL, sql, NULL);
 		switch_safe_free(sql);
 
+		cc_agent_index_add(agent, CC_AGENT_STATUS_LOGGED_OUT, CC_AGENT_STATE_WAITING);
+
 		if (switch_event_create_subclass(&event, SWITCH_EVENT_CUSTOM, CALLCENTER_EVENT) == SWITCH_STATUS_SUCCESS) {
 			switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "CC-Agent", agent);
 			switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "CC-Agent-Type", type);
@@ -939,6 +1354,9 @@ cc_status_t cc_agent_del(const char *agent)
 			agent, agent);
 	cc_execute_sql(NULL, sql, NULL);
 	switch_safe_free(sql);
+
+	cc_agent_index_del(agent);
+
 	return result;
 }
 
@@ -1026,6 +1444,11 @@ cc_status_t cc_agent_update(const char *key, const char *value, const char *agen
 			cc_execute_sql(NULL, sql, NULL);
 			switch_safe_free(sql);
 
+			cc_agent_index_update(agent, value, NULL);
+
+			if (cc_agent_str2status(value) == CC_AGENT_STATUS_AVAILABLE || cc_agent_str2status(value) == CC_AGENT_STATUS_AVAILABLE_ON_DEMAND) {
+				cc_dispatch_kick();
+			}
 
 			/* Used to stop any active callback */
 			if (cc_agent_str2status(value) != CC_AGENT_STATUS_AVAILABLE) {
@@ -1062,6 +1485,12 @@ cc_status_t cc_agent_update(const char *key, const char *value, const char *agen
 			cc_execute_sql(NULL, sql, NULL);
 			switch_safe_free(sql);
 
+			cc_agent_index_update(agent, NULL, value);
+
+			if (cc_agent_str2state(value) == CC_AGENT_STATE_WAITING) {
+				cc_dispatch_kick();
+			}
+
 			result = CC_STATUS_SUCCESS;
 
 			if (switch_event_create_subclass(&event, SWITCH_EVENT_CUSTOM, CALLCENTER_EVENT) == SWITCH_STATUS_SUCCESS) {
@@ -1099,6 +1528,8 @@ cc_status_t cc_agent_update(const char *key, const char *value, const char *agen
 		cc_execute_sql(NULL, sql, NULL);
 		switch_safe_free(sql);
 
+		cc_dispatch_kick();
+
 		result = CC_STATUS_SUCCESS;
 	} else if (!strcasecmp(key, "busy_delay_time")) {
 		sql = switch_mprintf("UPDATE agents SET busy_delay_time = '%ld', instance_id = 'single_box' WHERE name = '%q'", atol(value), agent);
@@ -1157,6 +1588,7 @@ cc_status_t cc_agent_update(const char *key, const char *value, const char *agen
 
 			if (cc_execute_sql_affected_rows(sql) > 0) {
 				result = CC_STATUS_SUCCESS;
+				cc_agent_index_update(agent, NULL, value);
 				if (switch_event_create_subclass(&event, SWITCH_EVENT_CUSTOM, CALLCENTER_EVENT) == SWITCH_STATUS_SUCCESS) {
 					switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "CC-Agent", agent);
 					switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "CC-Action", "agent-state-change");
@@ -1224,6 +1656,9 @@ cc_status_t cc_tier_add(const char *queue_name, const char *agent, const char *s
 		cc_execute_sql(NULL, sql, NULL);
 		switch_safe_free(sql);
 
+		cc_agent_index_tier_add(queue_name, agent);
+		cc_dispatch_kick();
+
 		result = CC_STATUS_SUCCESS;
 	} else {
 		result = CC_STATUS_TIER_INVALID_STATE;
@@ -1274,6 +1709,7 @@ cc_status_t cc_tier_update(const char *key, const char *value, const char *queue
 			sql = switch_mprintf("UPDATE tiers SET state = '%q' WHERE queue = '%q' AND agent = '%q'", value, queue_name, agent);
 			cc_execute_sql(NULL, sql, NULL);
 			switch_safe_free(sql);
+			cc_dispatch_kick();
 			result = CC_STATUS_SUCCESS;
 		} else {
 			result = CC_STATUS_TIER_INVALID_STATE;
@@ -1313,6 +1749,8 @@ cc_status_t cc_tier_del(const char *queue_name, const char *agent)
 	cc_execute_sql(NULL, sql, NULL);
 	switch_safe_free(sql);
 
+	cc_agent_index_tier_del(queue_name, agent);
+
 	result = CC_STATUS_SUCCESS;
 
 	return result;
@@ -1516,6 +1954,7 @@ static switch_status_t load_config(switch_memory_pool_t *pool)
 
 	switch_mutex_lock(globals.mutex);
 	globals.global_database_lock = SWITCH_TRUE;
+	globals.agent_index_resync = CC_AGENT_INDEX_RESYNC;
 	if ((settings = switch_xml_child(cfg, "settings"))) {
 		for (param = switch_xml_child(settings, "param"); param; param = param->next) {
 			char *var = (char *) switch_xml_attr_soft(param, "name");
@@ -1539,6 +1978,22 @@ static switch_status_t load_config(switch_memory_pool_t *pool)
 				globals.cc_instance_id = switch_core_strdup(pool, val);
 			} else if (!strcasecmp(var, "agent-originate-timeout")) {
 				globals.agent_originate_timeout = atoi(val);
+			} else if (!strcasecmp(var, "dispatch-interval")) {
+				int tmp = atoi(val);
+				if (tmp >= 10) {
+					globals.dispatch_interval = tmp;
+				} else {
+					switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "dispatch-interval must be at least 10 ms\n");
+				}
+			} else if (!strcasecmp(var, "agent-index")) {
+				globals.agent_index_enabled = switch_true(val);
+			} else if (!strcasecmp(var, "agent-index-resync")) {
+				int tmp = atoi(val);
+				if (tmp >= 0) {
+					globals.agent_index_resync = tmp;
+				} else {
+					switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "agent-index-resync must be 0 or more seconds\n");
+				}
 			}
 		}
 	}
@@ -1560,6 +2015,8 @@ static switch_status_t load_config(switch_memory_pool_t *pool)
 
 	if (!globals.agent_originate_timeout) globals.agent_originate_timeout = 60;
 
+	if (!globals.dispatch_interval) globals.dispatch_interval = 1000;
+
 	/* Initialize database */
 	if (!(dbh = cc_get_db_handle())) {
 		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CRIT, "Cannot open DB!\n");
@@ -1643,6 +2100,11 @@ static switch_status_t load_config(switch_memory_pool_t *pool)
 		load_tiers(SWITCH_TRUE, NULL, NULL, NULL, NULL);
 	}
 
+	if (globals.agent_index_enabled) {
+		cc_agent_index_sync();
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "Agent dispatch index loaded\n");
+	}
+
 end:
 	switch_mutex_unlock(globals.mutex);
 
@@ -2122,6 +2584,7 @@ static void *SWITCH_THREAD_FUNC outbound_agent_thread_run(switch_thread_t *threa
 				h->agent_name, h->agent_system, h->member_uuid, globals.cc_instance_id);
 		cc_execute_sql(NULL, sql, NULL);
 		switch_safe_free(sql);
+		cc_dispatch_kick();
 		bridged = 0;
 		switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(member_session), SWITCH_LOG_DEBUG, "Agent %s Origination Canceled : %s\n", h->agent_name, switch_channel_cause2str(cause));
 
@@ -2443,6 +2906,7 @@ static int agents_callback(void *pArg, int argc, char **argv, char **columnNames
 				switch_threadattr_detach_set(thd_attr, 1);
 				switch_threadattr_stacksize_set(thd_attr, SWITCH_THREAD_STACKSIZE);
 				switch_thread_create(&thread, thd_attr, outbound_agent_thread_run, h, h->pool);
+				cc_dispatch_stat_inc(offers);
 			}
 
 			if (!strcasecmp(cbt->strategy,"ring-all")) {
@@ -2474,8 +2938,11 @@ static int members_callback(void *pArg, int argc, char **argv, char **columnName
 	const char *member_abandoned_epoch = NULL;
 	const char *serving_agent = NULL;
 	const char *last_originated_call = NULL;
+	switch_bool_t agent_logged_in = SWITCH_TRUE;
 	memset(&cbt, 0, sizeof(cbt));
 
+	cc_dispatch_stat_inc(members);
+
 	cbt.queue_name = argv[0];
 	cbt.member_uuid = argv[1];
 	cbt.member_session_uuid = argv[2];
@@ -2599,6 +3066,13 @@ static int members_callback(void *pArg, int argc, char **argv, char **columnName
 	cbt.record_template = queue_record_template;
 	cbt.agent_found = SWITCH_FALSE;
 
+	/* Nobody in this queue can take the call right now, don't ask the database */
+	if (!cc_agent_index_check(queue_name, &agent_logged_in)) {
+		cc_dispatch_stat_inc(agent_queries_skipped);
+		cbt.agent_found = agent_logged_in;
+		goto agents_done;
+	}
+
 	if (!strcasecmp(queue->strategy, "top-down")) {
 		/* WARNING this use channel variable to help dispatch... might need to be reviewed to save it in DB to make this multi server prooft in the future */
 		switch_core_session_t *member_session = switch_core_session_locate(cbt.member_session_uuid);
@@ -2707,9 +3181,11 @@ static int members_callback(void *pArg, int argc, char **argv, char **columnName
 	}
 
 	cc_execute_sql_callback(NULL /* queue */, NULL /* mutex */, sql, agents_callback, &cbt /* Call back variables */);
+	cc_dispatch_stat_inc(agent_queries);
 
 	switch_safe_free(sql);
 
+agents_done:
 	/* We update a field in the queue struct so we can kick caller out if waiting for too long with no agent */
 	if (!cbt.queue_name || !(queue = get_queue(cbt.queue_name))) {
 		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "Queue %s not found locally, skip this member\n", cbt.queue_name);
@@ -2765,6 +3241,13 @@ void *SWITCH_THREAD_FUNC cc_agent_dispatch_thread_run(switch_thread_t *thread, v
 
 	while (globals.running == 1) {
 		char *sql = NULL;
+		switch_time_t started = switch_micro_time_now(), elapsed;
+
+		cc_agent_index_verify();
+		if (globals.agent_index_enabled && globals.agent_index_stale) {
+			cc_agent_index_sync();
+		}
+
 		sql = switch_mprintf("SELECT queue,uuid,session_uuid,cid_number,cid_name,joined_epoch,(%" SWITCH_TIME_T_FMT "-joined_epoch)+base_score+skill_score AS score, state, abandoned_epoch, serving_agent, instance_id FROM members"
 				" WHERE (state = '%q' OR state = '%q' OR (serving_agent = 'ring-all' AND state = '%q') OR (serving_agent = 'ring-progressively' AND state = '%q')) AND instance_id = '%q' ORDER BY score DESC",
 				local_epoch_time_now(NULL),
@@ -2772,7 +3255,19 @@ void *SWITCH_THREAD_FUNC cc_agent_dispatch_thread_run(switch_thread_t *thread, v
 
 		cc_execute_sql_callback(NULL /* queue */, NULL /* mutex */, sql, members_callback, NULL /* Call back variables */);
 		switch_safe_free(sql);
-		switch_yield(100000);
+
+		/* Sleep until a member joins or an agent frees up, the interval only catches time based rules (wrap-up, ready time, tier wait) */
+		switch_mutex_lock(globals.dispatch_mutex);
+		globals.dispatch_stats.passes++;
+		if (!globals.dispatch_pending && globals.running == 1) {
+			switch_thread_cond_timedwait(globals.dispatch_cond, globals.dispatch_mutex, (switch_interval_time_t) globals.dispatch_interval * 1000);
+		}
+		globals.dispatch_pending = 0;
+		switch_mutex_unlock(globals.dispatch_mutex);
+
+		if ((elapsed = switch_micro_time_now() - started) < CC_DISPATCH_MIN_GAP) {
+			switch_yield(CC_DISPATCH_MIN_GAP - elapsed);
+		}
 	}
 
 	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CONSOLE, "Agent Dispatch Thread Ended\n");
@@ -3136,6 +3631,8 @@ SWITCH_STANDARD_APP(callcenter_function)
 		switch_safe_free(sql);
 	}
 
+	cc_dispatch_kick();
+
 	/* Send Event with queue count */
 	cc_queue_count(queue_name);
 	cc_send_presence(queue_name);
@@ -3520,7 +4017,9 @@ static int list_result_json_callback(void *pArg, int argc, char **argv, char **c
 "\tcallcenter_config queue count | \n" \
 "\tcallcenter_config queue count agents [queue_name] [status] [state] | \n" \
 "\tcallcenter_config queue count members [queue_name] | \n" \
-"\tcallcenter_config queue count tiers [queue_name]"
+"\tcallcenter_config queue count tiers [queue_name] | \n" \
+"\tcallcenter_config dispatch status | \n" \
+"\tcallcenter_config dispatch resync"
 
 SWITCH_STANDARD_API(cc_config_api_function)
 {
@@ -3993,6 +4492,54 @@ SWITCH_STANDARD_API(cc_config_api_function)
 				stream->write_function(stream, "%d\n", atoi(res));
 			}
 		}
+	} else if (section && !strcasecmp(section, "dispatch")) {
+		if (action && !strcasecmp(action, "status")) {
+			uint32_t agents = 0, ready = 0, queues = 0;
+			switch_hash_index_t *hi;
+			uint64_t passes, members, agent_queries, agent_queries_skipped, offers;
+
+			switch_mutex_lock(globals.index_mutex);
+			if (globals.agent_index.agents) {
+				cc_agent_index_totals(&agents, &ready);
+				for (hi = switch_core_hash_first(globals.agent_index.queues); hi; hi = switch_core_hash_next(&hi)) {
+					queues++;
+				}
+			}
+			switch_mutex_unlock(globals.index_mutex);
+
+			switch_mutex_lock(globals.dispatch_mutex);
+			passes = globals.dispatch_stats.passes;
+			members = globals.dispatch_stats.members;
+			agent_queries = globals.dispatch_stats.agent_queries;
+			agent_queries_skipped = globals.dispatch_stats.agent_queries_skipped;
+			offers = globals.dispatch_stats.offers;
+			switch_mutex_unlock(globals.dispatch_mutex);
+
+			stream->write_function(stream, "interval: %u ms\n", globals.dispatch_interval);
+			stream->write_function(stream, "passes: %" SWITCH_UINT64_T_FMT "\n", passes);
+			stream->write_function(stream, "members: %" SWITCH_UINT64_T_FMT "\n", members);
+			stream->write_function(stream, "agent_queries: %" SWITCH_UINT64_T_FMT "\n", agent_queries);
+			stream->write_function(stream, "agent_queries_skipped: %" SWITCH_UINT64_T_FMT "\n", agent_queries_skipped);
+			stream->write_function(stream, "offers: %" SWITCH_UINT64_T_FMT "\n", offers);
+			if (globals.agent_index_enabled) {
+				stream->write_function(stream, "agent_index: %s, %u agents (%u ready) in %u queues, resync every %u s\n",
+									   globals.agent_index_stale ? "stale" : "in sync", agents, ready, queues, globals.agent_index_resync);
+			} else {
+				stream->write_function(stream, "agent_index: disabled\n");
+			}
+		} else if (action && !strcasecmp(action, "resync")) {
+			if (!globals.agent_index_enabled) {
+				stream->write_function(stream, "%s", "-ERR agent-index is disabled\n");
+				goto done;
+			}
+			switch_mutex_lock(globals.index_mutex);
+			globals.agent_index_stale = 1;
+			switch_mutex_unlock(globals.index_mutex);
+			cc_dispatch_kick();
+			stream->write_function(stream, "%s", "+OK\n");
+		} else {
+			stream->write_function(stream, "%s", "-ERR Invalid!\n");
+		}
 	}
 
 	goto done;
@@ -4226,6 +4773,9 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_callcenter_load)
 
 	switch_core_hash_init(&globals.queue_hash);
 	switch_mutex_init(&globals.mutex, SWITCH_MUTEX_NESTED, globals.pool);
+	switch_mutex_init(&globals.index_mutex, SWITCH_MUTEX_NESTED, globals.pool);
+	switch_mutex_init(&globals.dispatch_mutex, SWITCH_MUTEX_NESTED, globals.pool);
+	switch_thread_cond_create(&globals.dispatch_cond, globals.pool);
 
 	if ((status = load_config(pool)) != SWITCH_STATUS_SUCCESS) {
 		switch_event_unbind(&globals.node);
@@ -4286,6 +4836,9 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_callcenter_load)
 	switch_console_set_complete("add callcenter_config queue count members");
 	switch_console_set_complete("add callcenter_config queue count tiers");
 
+	switch_console_set_complete("add callcenter_config dispatch status");
+	switch_console_set_complete("add callcenter_config dispatch resync");
+
 	switch_console_set_complete("add callcenter_break agent");
 
 	/* indicate that the module should continue to be loaded */
@@ -4314,6 +4867,8 @@ SWITCH_MODULE_SHUTDOWN_FUNCTION(mod_callcenter_shutdown)
 	}
 	switch_mutex_unlock(globals.mutex);
 
+	cc_dispatch_kick();
+
 	while (globals.threads) {
 		switch_cond_next();
 		if (++sanity >= 60000) {
@@ -4339,6 +4894,12 @@ SWITCH_MODULE_SHUTDOWN_FUNCTION(mod_callcenter_shutdown)
 
 	switch_core_hash_destroy(&globals.queue_hash);
 
+	switch_mutex_lock(globals.index_mutex);
+	if (globals.agent_index.agents) {
+		cc_agent_index_destroy(&globals.agent_index);
+	}
+	switch_mutex_unlock(globals.index_mutex);
+
 	switch_safe_free(globals.odbc_dsn);
 	switch_safe_free(globals.dbname);
 	switch_mutex_unlock(globals.mutex);
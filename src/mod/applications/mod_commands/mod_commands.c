@@ -722,6 +722,76 @@ SWITCH_STANDARD_API(db_cache_function)
 	return SWITCH_STATUS_SUCCESS;
 }
 
+#define PROMPT_CACHE_SYNTAX "status|flush [<path>]"
+SWITCH_STANDARD_API(prompt_cache_function)
+{
+	int argc;
+	char *mydata = NULL, *argv[2];
+
+	if (zstr(cmd)) {
+		goto error;
+	}
+
+	mydata = strdup(cmd);
+	switch_assert(mydata);
+
+	argc = switch_separate_string(mydata, ' ', argv, (sizeof(argv) / sizeof(argv[0])));
+
+	if (argc < 1) {
+		goto error;
+	}
+
+	if (!strcasecmp(argv[0], "status")) {
+		switch_core_prompt_cache_status(stream);
+		goto ok;
+	} else if (!strcasecmp(argv[0], "flush")) {
+		stream->write_function(stream, "+OK flushed %u\n", switch_core_prompt_cache_flush(argc > 1 ? argv[1] : NULL));
+		goto ok;
+	}
+
+  error:
+	stream->write_function(stream, "-USAGE: %s\n", PROMPT_CACHE_SYNTAX);
+  ok:
+	switch_safe_free(mydata);
+	return SWITCH_STATUS_SUCCESS;
+}
+
+#define RECORD_WRITERS_SYNTAX "status"
+SWITCH_STANDARD_API(record_writers_function)
+{
+	if (!zstr(cmd) && !strcasecmp(cmd, "status")) {
+		switch_ivr_record_writer_status(stream);
+	} else {
+		stream->write_function(stream, "-USAGE: %s\n", RECORD_WRITERS_SYNTAX);
+	}
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+#define CURL_POOL_SYNTAX "status"
+SWITCH_STANDARD_API(curl_pool_function)
+{
+	if (!zstr(cmd) && !strcasecmp(cmd, "status")) {
+		switch_curl_pool_status(stream);
+	} else {
+		stream->write_function(stream, "-USAGE: %s\n", CURL_POOL_SYNTAX);
+	}
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+#define RTP_PORTS_SYNTAX "status"
+SWITCH_STANDARD_API(rtp_ports_function)
+{
+	if (!zstr(cmd) && !strcasecmp(cmd, "status")) {
+		switch_rtp_port_status(stream);
+	} else {
+		stream->write_function(stream, "-USAGE: %s\n", RTP_PORTS_SYNTAX);
+	}
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
 SWITCH_STANDARD_API(host_lookup_function)
 {
 	char host[256] = "";
@@ -979,6 +1049,44 @@ SWITCH_STANDARD_API(timer_test_function)
 	return SWITCH_STATUS_SUCCESS;
 }
 
+#define TIMER_STATS_SYNTAX "[reset]"
+
+SWITCH_STANDARD_API(timer_stats_function)
+{
+	switch_bool_t reset = SWITCH_FALSE;
+
+	if (!zstr(cmd)) {
+		if (strcasecmp(cmd, "reset")) {
+			stream->write_function(stream, "-USAGE: %s\n", TIMER_STATS_SYNTAX);
+			return SWITCH_STATUS_SUCCESS;
+		}
+		reset = SWITCH_TRUE;
+	}
+
+	switch_time_timer_stats(stream, reset);
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+#define VIDEO_ENCODE_STATS_SYNTAX "[reset]"
+
+SWITCH_STANDARD_API(video_encode_stats_function)
+{
+	switch_bool_t reset = SWITCH_FALSE;
+
+	if (!zstr(cmd)) {
+		if (strcasecmp(cmd, "reset")) {
+			stream->write_function(stream, "-USAGE: %s\n", VIDEO_ENCODE_STATS_SYNTAX);
+			return SWITCH_STATUS_SUCCESS;
+		}
+		reset = SWITCH_TRUE;
+	}
+
+	switch_core_video_encode_pool_stats(stream, reset);
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
 SWITCH_STANDARD_API(group_call_function)
 {
 	char *domain, *dup_domain = NULL;
@@ -1719,6 +1827,13 @@ SWITCH_STANDARD_API(eval_function)
 	return SWITCH_STATUS_SUCCESS;
 }
 
+SWITCH_STANDARD_API(startup_timeline_function)
+{
+	switch_loadable_module_timeline(stream);
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
 SWITCH_STANDARD_API(module_exists_function)
 {
 	if (!zstr(cmd)) {
@@ -2330,6 +2445,8 @@ SWITCH_STANDARD_API(status_function)
 	char * nl = "\n";					/* shortcut to format.nl	*/
 	stream_format format = { 0 };
 	switch_size_t cur = 0, max = 0;
+	uint32_t db_pools = 0, db_handles = 0, db_used = 0;
+	uint64_t db_waits = 0;
 
 	set_format(&format, stream);
 
@@ -2380,6 +2497,9 @@ SWITCH_STANDARD_API(status_function)
 	stream->write_function(stream, "%d session(s) max%s", switch_core_session_limit(0), nl);
 	stream->write_function(stream, "min idle cpu %0.2f/%0.2f%s", switch_core_min_idle_cpu(-1.0), switch_core_idle_cpu(), nl);
 
+	switch_cache_db_pool_totals(&db_pools, &db_handles, &db_used, &db_waits);
+	stream->write_function(stream, "%u db handle(s) in %u pool(s), %u in use, %" SWITCH_UINT64_T_FMT " wait(s)%s", db_handles, db_pools, db_used, db_waits, nl);
+
 	if (switch_core_get_stacksizes(&cur, &max) == SWITCH_STATUS_SUCCESS) {		stream->write_function(stream, "Current Stack Size/Max %ldK/%ldK\n", cur / 1024, max / 1024);
 	}
 	return SWITCH_STATUS_SUCCESS;
@@ -2846,8 +2966,16 @@ SWITCH_STANDARD_API(reload_function)
 SWITCH_STANDARD_API(reload_xml_function)
 {
 	const char *err = "";
+	switch_xml_t xml_root;
+
+	if (!zstr(cmd) && !strcasecmp(cmd, "force")) {
+		if ((xml_root = switch_xml_open_root(SWITCH_XML_RELOAD_FORCE, &err))) {
+			switch_xml_free(xml_root);
+		}
+	} else {
+		switch_xml_reload(&err);
+	}
 
-	switch_xml_reload(&err);
 	stream->write_function(stream, "+OK [%s]\n", err);
 
 	return SWITCH_STATUS_SUCCESS;
@@ -6732,6 +6860,12 @@ SWITCH_STANDARD_API(hupall_api_function)
 }
 
 
+SWITCH_STANDARD_API(xml_cache_status_function)
+{
+	switch_xml_user_cache_status(stream);
+	return SWITCH_STATUS_SUCCESS;
+}
+
 SWITCH_STANDARD_API(xml_flush_function)
 {
 	char *mycmd = NULL, *argv[3] = { 0 };
@@ -7605,6 +7739,7 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_commands_load)
 	SWITCH_ADD_API(commands_api_interface, "console_complete", "", console_complete_function, "<line>");
 	SWITCH_ADD_API(commands_api_interface, "console_complete_xml", "", console_complete_xml_function, "<line>");
 	SWITCH_ADD_API(commands_api_interface, "create_uuid", "Create a uuid", uuid_function, UUID_SYNTAX);
+	SWITCH_ADD_API(commands_api_interface, "curl_pool", "Show the shared HTTP client pools", curl_pool_function, CURL_POOL_SYNTAX);
 	SWITCH_ADD_API(commands_api_interface, "db_cache", "Manage db cache", db_cache_function, "status");
 	SWITCH_ADD_API(commands_api_interface, "domain_data", "Find domain data", domain_data_function, "<domain> [var|param|attr] <name>");
 	SWITCH_ADD_API(commands_api_interface, "domain_exists", "Check if a domain exists", domain_exists_function, "<domain>");
@@ -7646,12 +7781,15 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_commands_load)
 	SWITCH_ADD_API(commands_api_interface, "originate", "Originate a call", originate_function, ORIGINATE_SYNTAX);
 	SWITCH_ADD_API(commands_api_interface, "pause", "Pause media on a channel", pause_function, PAUSE_SYNTAX);
 	SWITCH_ADD_API(commands_api_interface, "pool_stats", "Core pool memory usage", pool_stats_function, "Core pool memory usage.");
+	SWITCH_ADD_API(commands_api_interface, "prompt_cache", "Manage the shared prompt cache", prompt_cache_function, PROMPT_CACHE_SYNTAX);
 	SWITCH_ADD_API(commands_api_interface, "quote_shell_arg", "Quote/escape a string for use on shell command line", quote_shell_arg_function, "<data>");
+	SWITCH_ADD_API(commands_api_interface, "record_writers", "Show the shared record writer pool", record_writers_function, RECORD_WRITERS_SYNTAX);
 	SWITCH_ADD_API(commands_api_interface, "regex", "Evaluate a regex", regex_function, "<data>|<pattern>[|<subst string>][n|b]");
 	SWITCH_ADD_API(commands_api_interface, "reloadacl", "Reload XML", reload_acl_function, "");
 	SWITCH_ADD_API(commands_api_interface, "reload", "Reload module", reload_function, UNLOAD_SYNTAX);
-	SWITCH_ADD_API(commands_api_interface, "reloadxml", "Reload XML", reload_xml_function, "");
+	SWITCH_ADD_API(commands_api_interface, "reloadxml", "Reload XML", reload_xml_function, "[force]");
 	SWITCH_ADD_API(commands_api_interface, "replace", "Replace a string", replace_function, "<data>|<string1>|<string2>");
+	SWITCH_ADD_API(commands_api_interface, "rtp_ports", "Show RTP port allocation and socket pool counters", rtp_ports_function, RTP_PORTS_SYNTAX);
 	SWITCH_ADD_API(commands_api_interface, "say_string", "", say_string_function, SAY_STRING_SYNTAX);
 	SWITCH_ADD_API(commands_api_interface, "sched_api", "Schedule an api command", sched_api_function, SCHED_SYNTAX);
 	SWITCH_ADD_API(commands_api_interface, "sched_broadcast", "Schedule a broadcast event to a running call", sched_broadcast_function, SCHED_BROADCAST_SYNTAX);
@@ -7660,10 +7798,12 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_commands_load)
 	SWITCH_ADD_API(commands_api_interface, "sched_transfer", "Schedule a transfer for a running call", sched_transfer_function, SCHED_TRANSFER_SYNTAX);
 	SWITCH_ADD_API(commands_api_interface, "show", "Show various reports", show_function, SHOW_SYNTAX);
 	SWITCH_ADD_API(commands_api_interface, "sql_escape", "Escape a string to prevent sql injection", sql_escape, SQL_ESCAPE_SYNTAX);
+	SWITCH_ADD_API(commands_api_interface, "startup_timeline", "Show how long each module took to load", startup_timeline_function, "");
 	SWITCH_ADD_API(commands_api_interface, "status", "Show current status", status_function, "");
 	SWITCH_ADD_API(commands_api_interface, "strftime_tz", "Display formatted time of timezone", strftime_tz_api_function, "<timezone_name> [<epoch>|][format string]");
 	SWITCH_ADD_API(commands_api_interface, "stun", "Execute STUN lookup", stun_function, "<stun_server>[:port] [<source_ip>[:<source_port]]");
 	SWITCH_ADD_API(commands_api_interface, "time_test", "Show time jitter", time_test_function, "<mss> [count]");
+	SWITCH_ADD_API(commands_api_interface, "timer_stats", "Soft timer wheel latency and jitter", timer_stats_function, TIMER_STATS_SYNTAX);
 	SWITCH_ADD_API(commands_api_interface, "timer_test", "Exercise FS timer", timer_test_function, TIMER_TEST_SYNTAX);
 	SWITCH_ADD_API(commands_api_interface, "tone_detect", "Start tone detection on a channel", tone_detect_session_function, TONE_DETECT_SYNTAX);
 	SWITCH_ADD_API(commands_api_interface, "unload", "Unload module", unload_function, UNLOAD_SYNTAX);
@@ -7734,6 +7874,8 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_commands_load)
 	SWITCH_ADD_API(commands_api_interface, "uuid_jitterbuffer", "uuid_jitterbuffer", uuid_jitterbuffer_function, JITTERBUFFER_SYNTAX);
 	SWITCH_ADD_API(commands_api_interface, "uuid_zombie_exec", "Set zombie_exec flag on the specified uuid", uuid_zombie_exec_function, "<uuid>");
 	SWITCH_ADD_API(commands_api_interface, "uuid_xfer_zombie", "Allow A leg to hangup and continue originating", uuid_xfer_zombie, XFER_ZOMBIE_SYNTAX);
+	SWITCH_ADD_API(commands_api_interface, "video_encode_stats", "Video encode pool queue depth and frame latency", video_encode_stats_function, VIDEO_ENCODE_STATS_SYNTAX);
+	SWITCH_ADD_API(commands_api_interface, "xml_cache_status", "Show directory cache statistics", xml_cache_status_function, "");
 	SWITCH_ADD_API(commands_api_interface, "xml_flush_cache", "Clear xml cache", xml_flush_function, "<id> <key> <val>");
 	SWITCH_ADD_API(commands_api_interface, "xml_locate", "Find some xml", xml_locate_function, "[root | <section> <tag> <tag_attr_name> <tag_attr_val>]");
 	SWITCH_ADD_API(commands_api_interface, "xml_wrap", "Wrap another api command in xml", xml_wrap_api_function, "<command> <args>");
@@ -7757,6 +7899,7 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_commands_load)
 	switch_console_set_complete("add coalesce");
 	switch_console_set_complete("add complete add");
 	switch_console_set_complete("add complete del");
+	switch_console_set_complete("add curl_pool status");
 	switch_console_set_complete("add db_cache status");
 	switch_console_set_complete("add fsctl debug_level");
 	switch_console_set_complete("add fsctl debug_pool");
@@ -7818,8 +7961,13 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_commands_load)
 	switch_console_set_complete("add nat_map reinit");
 	switch_console_set_complete("add nat_map republish");
 	switch_console_set_complete("add nat_map status");
+	switch_console_set_complete("add prompt_cache status");
+	switch_console_set_complete("add prompt_cache flush");
+	switch_console_set_complete("add record_writers status");
 	switch_console_set_complete("add reload ::console::list_loaded_modules");
 	switch_console_set_complete("add reloadacl reloadxml");
+	switch_console_set_complete("add reloadxml force");
+	switch_console_set_complete("add rtp_ports status");
 	switch_console_set_complete("add show aliases");
 	switch_console_set_complete("add show api");
 	switch_console_set_complete("add show application");
@@ -7847,6 +7995,7 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_commands_load)
 	switch_console_set_complete("add show timer");
 	switch_console_set_complete("add shutdown");
 	switch_console_set_complete("add sql_escape");
+	switch_console_set_complete("add timer_stats reset");
 	switch_console_set_complete("add unload ::console::list_loaded_modules");
 	switch_console_set_complete("add uptime ms");
 	switch_console_set_complete("add uptime s");
@@ -7936,6 +8085,7 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_commands_load)
 	switch_console_set_complete("add uuid_video_bitrate ::console::list_uuid");
 	switch_console_set_complete("add uuid_video_bandwidth ::console::list_uuid");
 	switch_console_set_complete("add uuid_xfer_zombie ::console::list_uuid");
+	switch_console_set_complete("add video_encode_stats reset");
 	switch_console_set_complete("add version");
 	switch_console_set_complete("add uuid_warning ::console::list_uuid");
 	switch_console_set_complete("add ...");
@@ -953,7 +953,7 @@ void *SWITCH_THREAD_FUNC conference_loop_input(switch_thread_t *thread, void *ob
 		/* generate events when the level crosses the threshold        */
 		if (((conference_utils_member_test_flag(member, MFLAG_CAN_SPEAK) && !conference_utils_member_test_flag(member, MFLAG_HOLD)) ||
 			 conference_utils_member_test_flag(member, MFLAG_MUTE_DETECT))) {
-			uint32_t energy = 0, i = 0, samples = 0, j = 0;
+			uint32_t energy = 0, samples = 0;
 			int16_t *data;
 			int gate_check = 0;
 			int score_iir = 0;
@@ -966,11 +966,7 @@ void *SWITCH_THREAD_FUNC conference_loop_input(switch_thread_t *thread, void *ob
 			}
 
 			if ((samples = read_frame->datalen / sizeof(*data))) {
-				for (i = 0; i < samples; i++) {
-					energy += abs(data[j]);
-					j++;
-				}
-
+				energy = (uint32_t) switch_dsp_energy(data, samples, 1);
 				member->score = energy / samples;
 			}
 
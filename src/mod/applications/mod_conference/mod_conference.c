@@ -552,17 +552,7 @@ void *SWITCH_THREAD_FUNC conference_thread_run(switch_thread_t *thread, void *ob
 					}
 				} else {
 					if (has_file_data) {
-						switch_size_t x;
-						for (x = 0; x < file_sample_len * conference->channels; x++) {
-							int32_t z;
-							int16_t *muxed;
-
-							muxed = (int16_t *) file_frame;
-							bptr = (int16_t *) async_file_frame;
-							z = muxed[x] + bptr[x];
-							switch_normalize_to_16bit(z);
-							muxed[x] = (int16_t) z;
-						}
+						switch_dsp_mix((int16_t *) file_frame, (int16_t *) async_file_frame, (uint32_t) (file_sample_len * conference->channels));
 					} else {
 						memcpy(file_frame, async_file_frame, file_sample_len * 2 * conference->channels);
 						has_file_data = 1;
@@ -575,6 +565,7 @@ void *SWITCH_THREAD_FUNC conference_thread_run(switch_thread_t *thread, void *ob
 		if (ready || has_file_data) {
 			/* Use more bits in the main_frame to preserve the exact sum of the audio samples. */
 			int main_frame[SWITCH_RECOMMENDED_BUFFER_SIZE] = { 0 };
+			int32_t member_frame[SWITCH_RECOMMENDED_BUFFER_SIZE];
 			int16_t write_frame[SWITCH_RECOMMENDED_BUFFER_SIZE] = { 0 };
 
 
@@ -673,11 +664,12 @@ void *SWITCH_THREAD_FUNC conference_thread_run(switch_thread_t *thread, void *ob
 						}
 					}
 
-					/* Now we can convert to 16 bit. */
-					switch_normalize_to_16bit(z);
-					write_frame[x] = (int16_t) z;
+					member_frame[x] = z;
 				}
 
+				/* Now we can convert to 16 bit. */
+				switch_dsp_clamp_to_16bit(member_frame, write_frame, bytes / 2);
+
 				if (!omember->channel || switch_channel_test_flag(omember->channel, CF_AUDIO)) {
 					switch_mutex_lock(omember->audio_out_mutex);
 					ok = switch_buffer_write(omember->mux_buffer, write_frame, bytes);
@@ -198,7 +198,7 @@ static http_data_t *do_lookup_url(switch_memory_pool_t *pool, const char *url, c
 	}
 
 	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "method: %s, url: %s, content-type: %s\n", method, url, content_type);
-	curl_handle = switch_curl_easy_init();
+	curl_handle = switch_curl_easy_acquire(url);
 
 	if (options->connect_timeout) {
 		switch_curl_easy_setopt(curl_handle, CURLOPT_CONNECTTIMEOUT, options->connect_timeout);
@@ -305,7 +305,7 @@ static http_data_t *do_lookup_url(switch_memory_pool_t *pool, const char *url, c
 
 	switch_curl_easy_perform(curl_handle);
 	switch_curl_easy_getinfo(curl_handle, CURLINFO_RESPONSE_CODE, &httpRes);
-	switch_curl_easy_cleanup(curl_handle);
+	switch_curl_easy_release(curl_handle);
 	switch_curl_slist_free_all(headers);
 
 	if (http_data->stream.data && !zstr((char *) http_data->stream.data) && strcmp(" ", http_data->stream.data)) {
@@ -37,16 +37,27 @@
 #include "esl.h"
 
 #define LIMIT_HASH_CLEANUP_INTERVAL 900
+/* Must be a power of two */
+#define LIMIT_HASH_STRIPES 64
 
 SWITCH_MODULE_LOAD_FUNCTION(mod_hash_load);
 SWITCH_MODULE_SHUTDOWN_FUNCTION(mod_hash_shutdown);
 SWITCH_MODULE_DEFINITION(mod_hash, mod_hash_load, mod_hash_shutdown, NULL);
 
+/* One slice of the limit table, keys are spread over the stripes by hash so
+   incr/release on unrelated resources don't serialize on a single lock */
+typedef struct {
+	switch_thread_rwlock_t *rwlock;
+	switch_hash_t *hash;
+} limit_hash_stripe_t;
+
 /* CORE STUFF */
 static struct {
 	switch_memory_pool_t *pool;
-	switch_thread_rwlock_t *limit_hash_rwlock;
-	switch_hash_t *limit_hash;
+	limit_hash_stripe_t limit_stripes[LIMIT_HASH_STRIPES];
+	switch_mutex_t *sync_mutex;
+	switch_time_t sync_instance;	/* < Identifies this process to remotes pulling deltas */
+	switch_time_t sync_floor;		/* < Deltas older than this may miss purged keys */
 	switch_thread_rwlock_t *db_hash_rwlock;
 	switch_hash_t *db_hash;
 	switch_thread_rwlock_t *remote_hash_rwlock;
@@ -54,11 +65,11 @@ static struct {
 } globals;
 
 typedef struct {
-	uint32_t total_usage;	/* < Total */
+	switch_atomic_t total_usage;	/* < Total, changed with atomics under the stripe read lock */
 	uint32_t rate_usage;	/* < Current rate usage */
 	time_t last_check;		/* < Last rate check */
 	uint32_t interval;		/* < Interval used on last rate check */
-	switch_time_t last_update;	/* < Last updated timestamp (rate or total) */
+	switch_time_t last_update;	/* < Last updated timestamp (rate or total), monotonic clock for local items */
 } limit_hash_item_t;
 
 struct callback {
@@ -111,6 +122,15 @@ typedef struct {
 	switch_thread_t *thread;
 
 	limit_remote_state_t state;
+
+	/* Delta sync cursor, as handed back by the remote's last hash_dump */
+	switch_time_t sync_instance;
+	switch_time_t sync_token;
+
+	uint64_t full_syncs;
+	uint64_t delta_syncs;
+	uint64_t keys_received;
+	uint64_t bytes_received;
 } limit_remote_t;
 
 static limit_hash_item_t get_remote_usage(const char *key);
@@ -118,6 +138,24 @@ void limit_remote_destroy(limit_remote_t **r);
 static void do_config(switch_bool_t reload);
 
 
+static inline limit_hash_stripe_t *limit_hash_stripe(const char *key)
+{
+	switch_ssize_t len = (switch_ssize_t) strlen(key);
+
+	return &globals.limit_stripes[switch_hashfunc_default(key, &len) & (LIMIT_HASH_STRIPES - 1)];
+}
+
+/* Rate usage still counting against the current window, an expired window reads as 0
+   without having to be reset under the write lock */
+static inline uint32_t limit_hash_item_rate(limit_hash_item_t *item, time_t now)
+{
+	if (item->interval > 0 && item->last_check <= (now - (time_t) item->interval)) {
+		return 0;
+	}
+
+	return item->rate_usage;
+}
+
 /* \brief Enforces limit_hash restrictions
  * \param session current session
  * \param realm limit realm
@@ -134,18 +172,13 @@ SWITCH_LIMIT_INCR(limit_incr_hash)
 	limit_hash_item_t *item = NULL;
 	time_t now = switch_epoch_time_now(NULL);
 	limit_hash_private_t *pvt = NULL;
+	limit_hash_stripe_t *stripe;
 	uint8_t increment = 1;
+	uint32_t total_usage, rate_usage;
 	limit_hash_item_t remote_usage;
 
 	hashkey = switch_core_session_sprintf(session, "%s_%s", realm, resource);
-
-	switch_thread_rwlock_wrlock(globals.limit_hash_rwlock);
-	/* Check if that realm+resource has ever been checked */
-	if (!(item = (limit_hash_item_t *) switch_core_hash_find(globals.limit_hash, hashkey))) {
-		/* No, create an empty structure and add it, then continue like as if it existed */
-		switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_DEBUG10, "Creating new limit structure: key: %s\n", hashkey);
-		item = (limit_hash_item_t *)switch_core_hash_insert_alloc(globals.limit_hash, hashkey, sizeof(limit_hash_item_t));
-	}
+	stripe = limit_hash_stripe(hashkey);
 
 	if (!(pvt = switch_channel_get_private(channel, "limit_hash"))) {
 		pvt = (limit_hash_private_t *) switch_core_session_alloc(session, sizeof(limit_hash_private_t));
@@ -156,10 +189,28 @@ SWITCH_LIMIT_INCR(limit_incr_hash)
 		switch_core_hash_init(&pvt->hash);
 	}
 	increment = !switch_core_hash_find(pvt->hash, hashkey);
- 	remote_usage = get_remote_usage(hashkey);
+
+	/* Remote usage has its own locks, don't hold the stripe while summing it */
+	remote_usage = get_remote_usage(hashkey);
+
+	/* The read lock keeps the item from being purged, the write lock is only needed to create it
+	   or to move its rate window */
+	switch_thread_rwlock_rdlock(stripe->rwlock);
+	if (!(item = (limit_hash_item_t *) switch_core_hash_find(stripe->hash, hashkey)) || interval > 0) {
+		switch_thread_rwlock_unlock(stripe->rwlock);
+		switch_thread_rwlock_wrlock(stripe->rwlock);
+
+		/* Check if that realm+resource has ever been checked */
+		if (!(item = (limit_hash_item_t *) switch_core_hash_find(stripe->hash, hashkey))) {
+			/* No, create an empty structure and add it, then continue like as if it existed */
+			switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_DEBUG10, "Creating new limit structure: key: %s\n", hashkey);
+			item = (limit_hash_item_t *)switch_core_hash_insert_alloc(stripe->hash, hashkey, sizeof(limit_hash_item_t));
+		}
+	}
 
 	if (interval > 0) {
 		item->interval = interval;
+		item->last_update = switch_mono_micro_time_now();
 		if (item->last_check <= (now - interval)) {
 			item->rate_usage = 1;
 			item->last_check = now;
@@ -170,39 +221,55 @@ SWITCH_LIMIT_INCR(limit_incr_hash)
 			item->rate_usage++;
 
 			if ((max >= 0) && (item->rate_usage > (uint32_t) max)) {
+				rate_usage = item->rate_usage;
+				switch_thread_rwlock_unlock(stripe->rwlock);
 				switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_INFO, "Usage for %s exceeds maximum rate of %d/%ds, now at %d\n",
-								  hashkey, max, interval, item->rate_usage);
-				status = SWITCH_STATUS_GENERR;
-				goto end;
+								  hashkey, max, interval, rate_usage);
+				return SWITCH_STATUS_GENERR;
 			}
 		}
-	} else if ((max >= 0) && (item->total_usage + increment + remote_usage.total_usage > (uint32_t) max)) {
-		switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_INFO, "Usage for %s is already at max value (%d)\n", hashkey, item->total_usage);
-		status = SWITCH_STATUS_GENERR;
-		goto end;
 	}
 
+	/* Check and take the slot in one compare-and-swap so concurrent calls can't both get the last one */
+	do {
+		total_usage = switch_atomic_read(&item->total_usage);
+
+		if (interval == 0 && (max >= 0) && (total_usage + increment + remote_usage.total_usage > (uint32_t) max)) {
+			switch_thread_rwlock_unlock(stripe->rwlock);
+			switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_INFO, "Usage for %s is already at max value (%d)\n", hashkey, total_usage);
+			return SWITCH_STATUS_GENERR;
+		}
+	} while (increment && switch_atomic_cas(&item->total_usage, total_usage + 1, total_usage) != total_usage);
+
 	if (increment) {
-		item->total_usage++;
+		total_usage++;
+		/* Stamped after the swap, a dump that missed the new count reports it on the next pull */
+		item->last_update = switch_mono_micro_time_now();
+	}
+
+	rate_usage = item->rate_usage;
+	switch_thread_rwlock_unlock(stripe->rwlock);
 
+	/* The item can't be purged while this channel holds a count on it */
+	if (increment) {
 		switch_core_hash_insert(pvt->hash, hashkey, item);
 
 		if (max == -1) {
-			switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_DEBUG, "Usage for %s is now %d\n", hashkey, item->total_usage + remote_usage.total_usage);
+			switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_DEBUG, "Usage for %s is now %d\n", hashkey, total_usage + remote_usage.total_usage);
 		} else if (interval == 0) {
-			switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_DEBUG, "Usage for %s is now %d/%d\n", hashkey, item->total_usage + remote_usage.total_usage, max);
+			switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_DEBUG, "Usage for %s is now %d/%d\n", hashkey, total_usage + remote_usage.total_usage, max);
 		} else {
 			switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_DEBUG, "Usage for %s is now %d/%d for the last %d seconds\n", hashkey,
-							  item->rate_usage, max, interval);
+							  rate_usage, max, interval);
 		}
 
-		switch_limit_fire_event("hash", realm, resource, item->total_usage, item->rate_usage, max, max >= 0 ? (uint32_t) max : 0);
+		switch_limit_fire_event("hash", realm, resource, total_usage, rate_usage, max, max >= 0 ? (uint32_t) max : 0);
 	}
 
 	/* Save current usage & rate into channel variables so it can be used later in the dialplan, or added to CDR records */
 	{
-		const char *susage = switch_core_session_sprintf(session, "%d", item->total_usage);
-		const char *srate = switch_core_session_sprintf(session, "%d", item->rate_usage);
+		const char *susage = switch_core_session_sprintf(session, "%d", total_usage);
+		const char *srate = switch_core_session_sprintf(session, "%d", rate_usage);
 
 		switch_channel_set_variable(channel, "limit_usage", susage);
 		switch_channel_set_variable(channel, switch_core_session_sprintf(session, "limit_usage_%s", hashkey), susage);
@@ -211,25 +278,23 @@ SWITCH_LIMIT_INCR(limit_incr_hash)
 		switch_channel_set_variable(channel, switch_core_session_sprintf(session, "limit_rate_%s", hashkey), srate);
 	}
 
-  end:
-	switch_thread_rwlock_unlock(globals.limit_hash_rwlock);
 	return status;
 }
 
 /* !\brief Determines whether a given entry is ready to be removed. */
 SWITCH_HASH_DELETE_FUNC(limit_hash_cleanup_delete_callback) {
 	limit_hash_item_t *item = (limit_hash_item_t *) val;
-	time_t now = switch_epoch_time_now(NULL);
-
-	/* reset to 0 if window has passed so we can clean it up */
-	if (item->rate_usage > 0 && (item->last_check <= (now - item->interval))) {
-		item->rate_usage = 0;
-	}
+	switch_time_t *purged = (switch_time_t *) pData;
 
-	if (item->total_usage == 0 && item->rate_usage == 0) {
+	if (item->total_usage == 0 && limit_hash_item_rate(item, switch_epoch_time_now(NULL)) == 0) {
 		/* Noone is using this item anymore */
 		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "Freeing limit item: %s\n", (const char *) key);
 
+		/* Remotes syncing from before this point can't see the key go away */
+		if (item->last_update > *purged) {
+			*purged = item->last_update;
+		}
+
 		free(item);
 		return SWITCH_TRUE;
 	}
@@ -240,27 +305,63 @@ SWITCH_HASH_DELETE_FUNC(limit_hash_cleanup_delete_callback) {
 SWITCH_HASH_DELETE_FUNC(limit_hash_remote_cleanup_callback)
 {
 	limit_hash_item_t *item = (limit_hash_item_t *) val;
-	switch_time_t now = (switch_time_t)(intptr_t)pData;
 
-	if (item->last_update != now) {
+	/* No stamp given means drop everything */
+	if (!pData || item->last_update != *(switch_time_t *) pData) {
 		return SWITCH_TRUE;
 	}
 
 	return SWITCH_FALSE;
 }
 
-/* !\brief Periodically checks for unused limit entries and frees them */
+/* !\brief Periodically checks for unused limit entries and frees them, one stripe at a time */
 SWITCH_STANDARD_SCHED_FUNC(limit_hash_cleanup_callback)
 {
-	switch_thread_rwlock_wrlock(globals.limit_hash_rwlock);
-	if (globals.limit_hash) {
-		switch_core_hash_delete_multi(globals.limit_hash, limit_hash_cleanup_delete_callback, NULL);
+	int i;
+
+	for (i = 0; i < LIMIT_HASH_STRIPES; i++) {
+		limit_hash_stripe_t *stripe = &globals.limit_stripes[i];
+		switch_time_t purged = 0;
+
+		switch_thread_rwlock_wrlock(stripe->rwlock);
+		if (stripe->hash) {
+			switch_core_hash_delete_multi(stripe->hash, limit_hash_cleanup_delete_callback, &purged);
+		}
+
+		/* Raise the floor before anyone can scan this stripe without the purged keys */
+		if (purged) {
+			switch_mutex_lock(globals.sync_mutex);
+			if (purged > globals.sync_floor) {
+				globals.sync_floor = purged;
+			}
+			switch_mutex_unlock(globals.sync_mutex);
+		}
+		switch_thread_rwlock_unlock(stripe->rwlock);
 	}
-	switch_thread_rwlock_unlock(globals.limit_hash_rwlock);
 
-	if (globals.limit_hash) {
-		task->runtime = switch_epoch_time_now(NULL) + LIMIT_HASH_CLEANUP_INTERVAL;
+	task->runtime = switch_epoch_time_now(NULL) + LIMIT_HASH_CLEANUP_INTERVAL;
+}
+
+/* !\brief Drops one channel reference on an item, the item itself stays in place until the cleanup task purges it
+   so remotes pulling deltas get to see its usage go back to 0 */
+static void limit_hash_item_release(switch_core_session_t *session, const char *hashkey, limit_hash_item_t *item)
+{
+	limit_hash_stripe_t *stripe = limit_hash_stripe(hashkey);
+	uint32_t total_usage;
+
+	switch_thread_rwlock_rdlock(stripe->rwlock);
+	do {
+		if (!(total_usage = switch_atomic_read(&item->total_usage))) {
+			break;
+		}
+	} while (switch_atomic_cas(&item->total_usage, total_usage - 1, total_usage) != total_usage);
+	if (total_usage) {
+		total_usage--;
 	}
+	item->last_update = switch_mono_micro_time_now();
+	switch_thread_rwlock_unlock(stripe->rwlock);
+
+	switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_DEBUG, "Usage for %s is now %d\n", hashkey, total_usage);
 }
 
 /* !\brief Releases usage of a limit_hash-controlled resource  */
@@ -270,10 +371,7 @@ SWITCH_LIMIT_RELEASE(limit_release_hash)
 	limit_hash_private_t *pvt = switch_channel_get_private(channel, "limit_hash");
 	limit_hash_item_t *item = NULL;
 
-	switch_thread_rwlock_wrlock(globals.limit_hash_rwlock);
-
 	if (!pvt || !pvt->hash) {
-		switch_thread_rwlock_unlock(globals.limit_hash_rwlock);
 		return SWITCH_STATUS_SUCCESS;
 	}
 
@@ -289,14 +387,7 @@ SWITCH_LIMIT_RELEASE(limit_release_hash)
 			switch_core_hash_this(hi, &key, &keylen, &val);
 
 			item = (limit_hash_item_t *) val;
-			item->total_usage--;
-			switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_DEBUG, "Usage for %s is now %d\n", (const char *) key, item->total_usage);
-
-			if (item->total_usage == 0 && item->rate_usage == 0) {
-				/* Noone is using this item anymore */
-				switch_core_hash_delete(globals.limit_hash, (const char *) key);
-				free(item);
-			}
+			limit_hash_item_release(session, (const char *) key, item);
 
 			switch_core_hash_delete(pvt->hash, (const char *) key);
 		}
@@ -305,21 +396,11 @@ SWITCH_LIMIT_RELEASE(limit_release_hash)
 		char *hashkey = switch_core_session_sprintf(session, "%s_%s", realm, resource);
 
 		if ((item = (limit_hash_item_t *) switch_core_hash_find(pvt->hash, hashkey))) {
-			item->total_usage--;
-			switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_DEBUG, "Usage for %s is now %d\n", (const char *) hashkey, item->total_usage);
-
+			limit_hash_item_release(session, hashkey, item);
 			switch_core_hash_delete(pvt->hash, hashkey);
-
-			if (item->total_usage == 0 && item->rate_usage == 0) {
-				/* Noone is using this item anymore */
-				switch_core_hash_delete(globals.limit_hash, (const char *) hashkey);
-				free(item);
-			}
 		}
 	}
 
-	switch_thread_rwlock_unlock(globals.limit_hash_rwlock);
-
 	return SWITCH_STATUS_SUCCESS;
 }
 
@@ -327,24 +408,25 @@ SWITCH_LIMIT_USAGE(limit_usage_hash)
 {
 	char *hash_key = NULL;
 	limit_hash_item_t *item = NULL;
+	limit_hash_stripe_t *stripe;
 	int count = 0;
 	limit_hash_item_t remote_usage;
 
-	switch_thread_rwlock_rdlock(globals.limit_hash_rwlock);
-
 	hash_key = switch_mprintf("%s_%s", realm, resource);
 	remote_usage = get_remote_usage(hash_key);
 
 	count = remote_usage.total_usage;
 	*rcount = remote_usage.rate_usage;
 
-	if ((item = switch_core_hash_find(globals.limit_hash, hash_key))) {
-		count += item->total_usage;
-		*rcount += item->rate_usage;
+	stripe = limit_hash_stripe(hash_key);
+	switch_thread_rwlock_rdlock(stripe->rwlock);
+	if ((item = switch_core_hash_find(stripe->hash, hash_key))) {
+		count += switch_atomic_read(&item->total_usage);
+		*rcount += limit_hash_item_rate(item, switch_epoch_time_now(NULL));
 	}
+	switch_thread_rwlock_unlock(stripe->rwlock);
 
  	switch_safe_free(hash_key);
-	switch_thread_rwlock_unlock(globals.limit_hash_rwlock);
 
 	return count;
 }
@@ -358,39 +440,51 @@ SWITCH_LIMIT_INTERVAL_RESET(limit_interval_reset_hash)
 {
 	char *hash_key = NULL;
 	limit_hash_item_t *item = NULL;
-
-	switch_thread_rwlock_rdlock(globals.limit_hash_rwlock);
+	limit_hash_stripe_t *stripe;
 
 	hash_key = switch_mprintf("%s_%s", realm, resource);
-	if ((item = switch_core_hash_find(globals.limit_hash, hash_key))) {
+	stripe = limit_hash_stripe(hash_key);
+
+	switch_thread_rwlock_wrlock(stripe->rwlock);
+	if ((item = switch_core_hash_find(stripe->hash, hash_key))) {
 		item->rate_usage = 0;
 		item->last_check = switch_epoch_time_now(NULL);
+		item->last_update = switch_mono_micro_time_now();
 	}
+	switch_thread_rwlock_unlock(stripe->rwlock);
 
  	switch_safe_free(hash_key);
-	switch_thread_rwlock_unlock(globals.limit_hash_rwlock);
 	return SWITCH_STATUS_SUCCESS;
 }
 
 SWITCH_LIMIT_STATUS(limit_status_hash)
 {
-	/*
 	switch_hash_index_t *hi = NULL;
-	int count = 0;
-	char *ret = NULL;
+	time_t now = switch_epoch_time_now(NULL);
+	int count = 0, idle = 0, i;
 
-	switch_thread_rwlock_rdlock(globals.limit_hash_rwlock);
+	for (i = 0; i < LIMIT_HASH_STRIPES; i++) {
+		limit_hash_stripe_t *stripe = &globals.limit_stripes[i];
 
-	for (hi = switch_core_hash_first(globals.limit_hash); hi; switch_core_hash_next(hi)) {
-		count++;
-	}
+		switch_thread_rwlock_rdlock(stripe->rwlock);
+		for (hi = switch_core_hash_first(stripe->hash); hi; hi = switch_core_hash_next(&hi)) {
+			void *val = NULL;
+			const void *key;
+			switch_ssize_t keylen;
+			limit_hash_item_t *item;
 
-	switch_thread_rwlock_unlock(globals.limit_hash_rwlock);
+			switch_core_hash_this(hi, &key, &keylen, &val);
+			item = (limit_hash_item_t *) val;
+
+			count++;
+			if (switch_atomic_read(&item->total_usage) == 0 && limit_hash_item_rate(item, now) == 0) {
+				idle++;
+			}
+		}
+		switch_thread_rwlock_unlock(stripe->rwlock);
+	}
 
-	ret = switch_mprintf("There are %d elements being tracked.", count);
-	return ret;
-	*/
-	return strdup("-ERR not supported yet (locking problems).");
+	return switch_mprintf("There are %d elements being tracked (%d idle awaiting cleanup) in %d stripes.", count, idle, LIMIT_HASH_STRIPES);
 }
 
 /* APP/API STUFF */
@@ -564,7 +658,43 @@ SWITCH_STANDARD_API(hash_api_function)
 	return SWITCH_STATUS_SUCCESS;
 }
 
-#define HASH_DUMP_SYNTAX "all|limit|db [<realm>]"
+/* Writes the local limit items as L/key/usage/rate/interval/last_check lines. With since set only items
+   changed at or after that point on our monotonic clock are written, zeroed ones included, so the remote can drop them */
+static void limit_hash_dump(switch_stream_handle_t *stream, switch_time_t since)
+{
+	switch_hash_index_t *hi;
+	time_t now = switch_epoch_time_now(NULL);
+	int i;
+
+	for (i = 0; i < LIMIT_HASH_STRIPES; i++) {
+		limit_hash_stripe_t *stripe = &globals.limit_stripes[i];
+
+		switch_thread_rwlock_rdlock(stripe->rwlock);
+		for (hi = switch_core_hash_first(stripe->hash); hi; hi = switch_core_hash_next(&hi)) {
+			void *val = NULL;
+			const void *key;
+			switch_ssize_t keylen;
+			limit_hash_item_t *item;
+			switch_core_hash_this(hi, &key, &keylen, &val);
+
+			item = (limit_hash_item_t *)val;
+
+			if (since) {
+				if (item->last_update < since) {
+					continue;
+				}
+			} else if (switch_atomic_read(&item->total_usage) == 0 && limit_hash_item_rate(item, now) == 0) {
+				/* Nothing to tell on a full dump, the remote drops keys it doesn't get */
+				continue;
+			}
+
+			stream->write_function(stream, "L/%s/%d/%d/%d/%d\n", key, switch_atomic_read(&item->total_usage), item->rate_usage, item->interval, (int) item->last_check);
+		}
+		switch_thread_rwlock_unlock(stripe->rwlock);
+	}
+}
+
+#define HASH_DUMP_SYNTAX "all|limit|db [<realm>] | limit since <instance> <token>"
 SWITCH_STANDARD_API(hash_dump_function)
 {
 	int mode;
@@ -585,6 +715,32 @@ SWITCH_STANDARD_API(hash_dump_function)
 	argc = switch_separate_string(mydata, ' ', argv, (sizeof(argv) / sizeof(argv[0])));
 	cmd = argv[0];
 
+	if (argc == 4 && !strcmp(cmd, "limit") && !strcmp(argv[1], "since")) {
+		/* Delta sync from a remote, the reply ends with S/<instance>/<token>/<full|delta> and the remote hands
+		   instance and token back on its next pull. Anything we can't vouch for gets a full dump instead. */
+		switch_time_t instance = (switch_time_t) strtoll(argv[2], NULL, 10);
+		switch_time_t since = (switch_time_t) strtoll(argv[3], NULL, 10);
+		switch_time_t token = switch_mono_micro_time_now();
+		switch_bool_t full;
+
+		switch_mutex_lock(globals.sync_mutex);
+		full = (instance != globals.sync_instance || since <= globals.sync_floor || since > token) ? SWITCH_TRUE : SWITCH_FALSE;
+		switch_mutex_unlock(globals.sync_mutex);
+
+		limit_hash_dump(stream, full ? 0 : since);
+
+		/* The cleanup task may have purged a key we were meant to report while we were dumping,
+		   a zero token makes the next pull a full one */
+		switch_mutex_lock(globals.sync_mutex);
+		if (!full && since <= globals.sync_floor) {
+			token = 0;
+		}
+		switch_mutex_unlock(globals.sync_mutex);
+
+		stream->write_function(stream, "S/%" SWITCH_TIME_T_FMT "/%" SWITCH_TIME_T_FMT "/%s\n", globals.sync_instance, token, full ? "full" : "delta");
+		goto done;
+	}
+
 	if (argc == 2) {
 		realm = 1;
 		realmvalue = switch_mprintf("%s_", argv[1]);
@@ -602,19 +758,7 @@ SWITCH_STANDARD_API(hash_dump_function)
 	}
 
 	if (mode & 1) {
-		switch_thread_rwlock_rdlock(globals.limit_hash_rwlock);
-		for (hi = switch_core_hash_first(globals.limit_hash); hi; hi = switch_core_hash_next(&hi)) {
-			void *val = NULL;
-			const void *key;
-			switch_ssize_t keylen;
-			limit_hash_item_t *item;
-			switch_core_hash_this(hi, &key, &keylen, &val);
-
-			item = (limit_hash_item_t *)val;
-
-			stream->write_function(stream, "L/%s/%d/%d/%d/%d\n", key, item->total_usage, item->rate_usage, item->interval, item->last_check);
-		}
-		switch_thread_rwlock_unlock(globals.limit_hash_rwlock);
+		limit_hash_dump(stream, 0);
 	}
 
 	if (mode & 2) {
@@ -659,7 +803,7 @@ SWITCH_STANDARD_API(hash_remote_function)
 	switch_split(dup, ' ', argv);
 	if (argv[0] && !strcmp(argv[0], "list")) {
 		switch_hash_index_t *hi;
-		stream->write_function(stream, "Remote connections:\nName\t\t\tState\n");
+		stream->write_function(stream, "Remote connections:\nName\t\t\tState\tFull\tDelta\tReceived\tBytes\n");
 
 		switch_thread_rwlock_rdlock(globals.remote_hash_rwlock);
 		for (hi = switch_core_hash_first(globals.remote_hash); hi; hi = switch_core_hash_next(&hi)) {
@@ -670,7 +814,11 @@ SWITCH_STANDARD_API(hash_remote_function)
 			switch_core_hash_this(hi, &key, &keylen, &val);
 
 			item = (limit_remote_t *)val;
-			stream->write_function(stream, "%s\t\t\t%s\n", item->name, state_str(item->state));
+			switch_thread_rwlock_rdlock(item->rwlock);
+			stream->write_function(stream, "%s\t\t\t%s\t%" SWITCH_UINT64_T_FMT "\t%" SWITCH_UINT64_T_FMT "\t%" SWITCH_UINT64_T_FMT "\t%" SWITCH_UINT64_T_FMT "\n",
+								   item->name, state_str(item->state),
+								   item->full_syncs, item->delta_syncs, item->keys_received, item->bytes_received);
+			switch_thread_rwlock_unlock(item->rwlock);
 		}
 		switch_thread_rwlock_unlock(globals.remote_hash_rwlock);
 		stream->write_function(stream, "+OK\n");
@@ -793,7 +941,7 @@ static limit_hash_item_t get_remote_usage(const char *key) {
 		switch_thread_rwlock_rdlock(remote->rwlock);
 		if ((item = switch_core_hash_find(remote->index, key))) {
 			usage.total_usage += item->total_usage;
-			usage.rate_usage += item->rate_usage;
+			usage.rate_usage += limit_hash_item_rate(item, switch_epoch_time_now(NULL));
 			if (!usage.last_check) {
 				usage.last_check = item->last_check;
 			}
@@ -821,7 +969,14 @@ static void *SWITCH_THREAD_FUNC limit_remote_thread(switch_thread_t *thread, voi
 				memset(&remote->handle, 0, sizeof(remote->handle));
 			}
 		} else {
-			if (esl_send_recv_timed(&remote->handle, "api hash_dump limit", 5000) != ESL_SUCCESS) {
+			char cmd[128];
+
+			/* Ask only for what changed since the last pull, a peer without delta support ignores the
+			   extra arguments and answers with a full dump and no S/ trailer */
+			switch_snprintf(cmd, sizeof(cmd), "api hash_dump limit since %" SWITCH_TIME_T_FMT " %" SWITCH_TIME_T_FMT,
+							remote->sync_instance, remote->sync_token);
+
+			if (esl_send_recv_timed(&remote->handle, cmd, 5000) != ESL_SUCCESS) {
 				esl_disconnect(&remote->handle);
 				memset(&remote->handle, 0, sizeof(remote->handle));
 				switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "Disconnected from remote FreeSWITCH (%s) at %s:%d\n",
@@ -831,15 +986,25 @@ static void *SWITCH_THREAD_FUNC limit_remote_thread(switch_thread_t *thread, voi
 				/* Delete all remote tracking entries */
 				switch_thread_rwlock_wrlock(remote->rwlock);
 				switch_core_hash_delete_multi(remote->index, limit_hash_remote_cleanup_callback, NULL);
+				remote->sync_instance = 0;
+				remote->sync_token = 0;
 				switch_thread_rwlock_unlock(remote->rwlock);
 			} else {
 				if (!zstr(remote->handle.last_sr_event->body)) {
 					char *data = strdup(remote->handle.last_sr_event->body);
 					char *p = data, *p2;
-					switch_time_t now = switch_epoch_time_now(NULL);
+					switch_time_t now = switch_micro_time_now();
+					switch_bool_t full = SWITCH_TRUE;
+					switch_time_t instance = 0, token = 0;
+					uint64_t keys = 0;
+
+					switch_thread_rwlock_wrlock(remote->rwlock);
+					remote->bytes_received += strlen(data);
+
 					while (p && *p) {
 						/* We are getting the limit data as:
 							L/key/usage/rate/interval/last_checked
+						   followed by S/instance/token/full|delta if the remote can do deltas
 						*/
 						if ((p2 = strchr(p, '\n'))) {
 							*p2++ = '\0';
@@ -856,17 +1021,40 @@ static void *SWITCH_THREAD_FUNC limit_remote_thread(switch_thread_t *thread, voi
 									remote->name, p);
 							} else {
 								limit_hash_item_t *item;
-								switch_thread_rwlock_wrlock(remote->rwlock);
-								if (!(item = switch_core_hash_find(remote->index, argv[0]))) {
-									switch_zmalloc(item, sizeof(*item));
-									switch_core_hash_insert_auto_free(remote->index, argv[0], item);
+								uint32_t total_usage = atoi(argv[1]);
+								uint32_t rate_usage = atoi(argv[2]);
+
+								keys++;
+								item = switch_core_hash_find(remote->index, argv[0]);
+
+								if (total_usage == 0 && rate_usage == 0) {
+									/* Gone on the remote side */
+									if (item) {
+										switch_core_hash_delete(remote->index, argv[0]);
+									}
+								} else {
+									if (!item) {
+										switch_zmalloc(item, sizeof(*item));
+										switch_core_hash_insert_auto_free(remote->index, argv[0], item);
+									}
+									item->total_usage = total_usage;
+									item->rate_usage = rate_usage;
+									item->interval = atoi(argv[3]);
+									item->last_check = atoi(argv[4]);
+									item->last_update = now;
 								}
-								item->total_usage = atoi(argv[1]);
-								item->rate_usage = atoi(argv[2]);
-								item->interval = atoi(argv[3]);
-								item->last_check = atoi(argv[4]);
-								item->last_update = now;
-								switch_thread_rwlock_unlock(remote->rwlock);
+							}
+						} else if (*p == 'S') { /* Sync cursor */
+							char *argv[3];
+							int argc = switch_split(p+2, '/', argv);
+
+							if (argc < 3) {
+								switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "[%s] Protocol error: missing argument in line: %s\n",
+									remote->name, p);
+							} else {
+								instance = (switch_time_t) strtoll(argv[0], NULL, 10);
+								token = (switch_time_t) strtoll(argv[1], NULL, 10);
+								full = strcmp(argv[2], "delta") ? SWITCH_TRUE : SWITCH_FALSE;
 							}
 						}
 
@@ -874,9 +1062,17 @@ static void *SWITCH_THREAD_FUNC limit_remote_thread(switch_thread_t *thread, voi
 					}
 					free(data);
 
-					/* Now free up anything that wasn't in this update since it means their usage is 0 */
-					switch_thread_rwlock_wrlock(remote->rwlock);
-					switch_core_hash_delete_multi(remote->index, limit_hash_remote_cleanup_callback, (void*)(intptr_t)now);
+					if (full) {
+						/* Now free up anything that wasn't in this update since it means their usage is 0 */
+						switch_core_hash_delete_multi(remote->index, limit_hash_remote_cleanup_callback, &now);
+						remote->full_syncs++;
+					} else {
+						remote->delta_syncs++;
+					}
+
+					remote->keys_received += keys;
+					remote->sync_instance = instance;
+					remote->sync_token = token;
 					switch_thread_rwlock_unlock(remote->rwlock);
 				}
 			}
@@ -944,6 +1140,7 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_hash_load)
 	switch_api_interface_t *commands_api_interface;
 	switch_limit_interface_t *limit_interface;
 	switch_status_t status;
+	int i;
 
 	memset(&globals, 0, sizeof(globals));
 	globals.pool = pool;
@@ -954,10 +1151,15 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_hash_load)
 		return SWITCH_STATUS_FALSE;
 	}
 
-	switch_thread_rwlock_create(&globals.limit_hash_rwlock, globals.pool);
+	for (i = 0; i < LIMIT_HASH_STRIPES; i++) {
+		switch_thread_rwlock_create(&globals.limit_stripes[i].rwlock, globals.pool);
+		switch_core_hash_init(&globals.limit_stripes[i].hash);
+	}
+	switch_mutex_init(&globals.sync_mutex, SWITCH_MUTEX_NESTED, globals.pool);
+	globals.sync_instance = switch_micro_time_now();
+
 	switch_thread_rwlock_create(&globals.db_hash_rwlock, globals.pool);
 	switch_thread_rwlock_create(&globals.remote_hash_rwlock, globals.pool);
-	switch_core_hash_init(&globals.limit_hash);
 	switch_core_hash_init(&globals.db_hash);
 	switch_core_hash_init(&globals.remote_hash);
 
@@ -994,6 +1196,7 @@ SWITCH_MODULE_SHUTDOWN_FUNCTION(mod_hash_shutdown)
 {
 	switch_hash_index_t *hi = NULL;
 	switch_bool_t remote_clean = SWITCH_TRUE;
+	int i;
 
 	switch_scheduler_del_task_group("mod_hash");
 
@@ -1021,18 +1224,25 @@ SWITCH_MODULE_SHUTDOWN_FUNCTION(mod_hash_shutdown)
 		}
 	}
 
-	switch_thread_rwlock_wrlock(globals.limit_hash_rwlock);
-	switch_thread_rwlock_wrlock(globals.db_hash_rwlock);
+	for (i = 0; i < LIMIT_HASH_STRIPES; i++) {
+		limit_hash_stripe_t *stripe = &globals.limit_stripes[i];
 
-	while ((hi = switch_core_hash_first_iter( globals.limit_hash, hi))) {
-		void *val = NULL;
-		const void *key;
-		switch_ssize_t keylen;
-		switch_core_hash_this(hi, &key, &keylen, &val);
-		free(val);
-		switch_core_hash_delete(globals.limit_hash, key);
+		switch_thread_rwlock_wrlock(stripe->rwlock);
+		while ((hi = switch_core_hash_first_iter(stripe->hash, hi))) {
+			void *val = NULL;
+			const void *key;
+			switch_ssize_t keylen;
+			switch_core_hash_this(hi, &key, &keylen, &val);
+			free(val);
+			switch_core_hash_delete(stripe->hash, key);
+		}
+		switch_core_hash_destroy(&stripe->hash);
+		switch_thread_rwlock_unlock(stripe->rwlock);
+		switch_thread_rwlock_destroy(stripe->rwlock);
 	}
 
+	switch_thread_rwlock_wrlock(globals.db_hash_rwlock);
+
 	while ((hi = switch_core_hash_first_iter( globals.db_hash, hi))) {
 		void *val = NULL;
 		const void *key;
@@ -1042,15 +1252,12 @@ SWITCH_MODULE_SHUTDOWN_FUNCTION(mod_hash_shutdown)
 		switch_core_hash_delete(globals.db_hash, key);
 	}
 
-	switch_core_hash_destroy(&globals.limit_hash);
 	switch_core_hash_destroy(&globals.db_hash);
 	switch_core_hash_destroy(&globals.remote_hash);
 
-	switch_thread_rwlock_unlock(globals.limit_hash_rwlock);
 	switch_thread_rwlock_unlock(globals.db_hash_rwlock);
 
 	switch_thread_rwlock_destroy(globals.db_hash_rwlock);
-	switch_thread_rwlock_destroy(globals.limit_hash_rwlock);
 	switch_thread_rwlock_destroy(globals.remote_hash_rwlock);
 
 
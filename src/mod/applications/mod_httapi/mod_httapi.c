@@ -1549,7 +1549,7 @@ static switch_status_t httapi_sync(client_t *client)
 		creds = client->profile->cred;
 	}
 
-	curl_handle = switch_curl_easy_init();
+	curl_handle = switch_curl_easy_acquire(dynamic_url);
 
 	if (session_id) {
 		char *hval = switch_mprintf("HTTAPI_SESSION_ID=%s", session_id);
@@ -1667,7 +1667,7 @@ static switch_status_t httapi_sync(client_t *client)
 
 	switch_curl_easy_perform(curl_handle);
 	switch_curl_easy_getinfo(curl_handle, CURLINFO_RESPONSE_CODE, &client->code);
-	switch_curl_easy_cleanup(curl_handle);
+	switch_curl_easy_release(curl_handle);
 	switch_curl_slist_free_all(headers);
 
 	if (formpost) {
@@ -2546,7 +2546,7 @@ static switch_status_t fetch_cache_data(http_file_context_t *context, const char
 		url = dynamic_url;
 	}
 
-	curl_handle = switch_curl_easy_init();
+	curl_handle = switch_curl_easy_acquire(url);
 
 	switch_curl_easy_setopt(curl_handle, CURLOPT_NOSIGNAL, 1);
 	switch_curl_easy_setopt(curl_handle, CURLOPT_NOPROGRESS, 1);
@@ -2647,7 +2647,7 @@ static switch_status_t fetch_cache_data(http_file_context_t *context, const char
 	switch_curl_easy_setopt(curl_handle, CURLOPT_USERAGENT, ua);
 	switch_curl_easy_perform(curl_handle);
 	switch_curl_easy_getinfo(curl_handle, CURLINFO_RESPONSE_CODE, &code);
-	switch_curl_easy_cleanup(curl_handle);
+	switch_curl_easy_release(curl_handle);
 
 	if (client->fd > -1) {
 		close(client->fd);
@@ -91,6 +91,7 @@ SWITCH_STANDARD_API(http_cache_tryget);
 SWITCH_STANDARD_API(http_cache_clear);
 SWITCH_STANDARD_API(http_cache_remove);
 SWITCH_STANDARD_API(http_cache_prefetch);
+SWITCH_STANDARD_API(http_cache_status);
 
 #define DOWNLOAD_NEEDED "download"
 #define DOWNLOAD 1
@@ -117,6 +118,19 @@ enum cached_url_status {
 };
 typedef enum cached_url_status cached_url_status_t;
 
+/**
+ * LRU segment holding a cache entry
+ */
+enum cached_url_segment {
+	/** not linked */
+	CACHED_URL_SEGMENT_NONE,
+	/** not hit since it was added, evicted first */
+	CACHED_URL_SEGMENT_PROBATION,
+	/** hit at least once since it was added */
+	CACHED_URL_SEGMENT_PROTECTED
+};
+typedef enum cached_url_segment cached_url_segment_t;
+
 /**
  * Cached URL information
  */
@@ -133,12 +147,18 @@ struct cached_url {
 	const char *content_type_params;
 	/** The size of the cached URL, in bytes */
 	size_t size;
-	/** URL use flag */
-	int used;
 	/** Status of this entry */
 	cached_url_status_t status;
 	/** Number of sessions waiting for this URL */
 	int waiters;
+	/** True once a refresh ahead of expiry has been queued */
+	int refreshing;
+	/** LRU segment this entry is linked into */
+	cached_url_segment_t segment;
+	/** Previous (more recently used) entry in the segment */
+	struct cached_url *prev;
+	/** Next (less recently used) entry in the segment */
+	struct cached_url *next;
 	/** time when downloaded */
 	switch_time_t download_time;
 	/** nanoseconds until stale */
@@ -169,21 +189,67 @@ static void process_content_type_header(cached_url_t *url, char *data);
 static switch_status_t http_put(url_cache_t *cache, http_profile_t *profile, switch_core_session_t *session, const char *url, const char *filename, int cache_local_file, long *httpRes);
 
 /**
- * Queue used for clock cache replacement algorithm.  This
- * queue has been simplified since replacement only happens
- * once it is filled.
+ * A segment of the LRU list, most recently used first
  */
-struct simple_queue {
-	/** The queue data */
-	void **data;
-	/** queue bounds */
-	size_t max_size;
-	/** queue size */
+struct url_lru {
+	cached_url_t *head;
+	cached_url_t *tail;
+	int count;
+};
+typedef struct url_lru url_lru_t;
+
+/**
+ * One lock stripe of the cache.  A URL always hashes to the same shard,
+ * which owns its map entry, its LRU position and its waiters.
+ *
+ * Replacement is segmented LRU: new URLs enter the probation segment and
+ * move to the protected segment when hit again, so a burst of one-off URLs
+ * can only push out other one-off URLs.
+ */
+struct url_cache_shard {
+	/** Synchronizes access to this shard */
+	switch_mutex_t *mutex;
+	/** Signalled when a download in this shard completes */
+	switch_thread_cond_t *cond;
+	/** Cached URLs mapped by URL */
+	switch_hash_t *map;
+	/** URLs not hit since they were added */
+	url_lru_t probation;
+	/** URLs hit at least once since they were added */
+	url_lru_t protect;
+	/** The maximum number of URLs in this shard */
+	int max_url;
+	/** The maximum number of URLs in the protected segment */
+	int max_protected;
+	/** The current size of this shard, in bytes */
 	size_t size;
-	/** Current index */
-	int pos;
+	/** Number of cache hits */
+	int hits;
+	/** Number of cache misses */
+	int misses;
+	/** Number of cache errors */
+	int errors;
+	/** Number of requests that waited on another request's download */
+	int coalesced;
+	/** Number of URLs evicted to make room */
+	int evictions;
+	/** Number of URLs refreshed ahead of expiry */
+	int refreshes;
+};
+typedef struct url_cache_shard url_cache_shard_t;
+
+/**
+ * Work for the prefetch thread pool
+ */
+struct prefetch_job {
+	/** http_get command, or URL to refresh */
+	char *url;
+	/** profile to refresh with */
+	http_profile_t *profile;
+	/** True to refresh a cached URL ahead of expiry */
+	int refresh;
 };
-typedef struct simple_queue simple_queue_t;
+typedef struct prefetch_job prefetch_job_t;
 
 /**
  * The cache
@@ -191,32 +257,22 @@ typedef struct simple_queue simple_queue_t;
 struct url_cache {
 	/** The maximum number of URLs to cache */
 	int max_url;
-	/** The maximum size of this cache, in bytes */
-	size_t max_size;
 	/** The default time to allow a cached URL to live, if none is specified */
 	switch_time_t default_max_age;
-	/** The current size of this cache, in bytes */
-	size_t size;
+	/** Percent of max age left when a hit queues a background refresh, 0 to disable */
+	int refresh_ahead;
 	/** The location of the cache in the filesystem */
 	char *location;
 	/** HTTP profiles */
 	switch_hash_t *profiles;
 	/** profiles mapped by FQDN */
 	switch_hash_t *fqdn_profiles;
-	/** Cache mapped by URL */
-	switch_hash_t *map;
-	/** Cached URLs queued for replacement */
-	simple_queue_t queue;
-	/** Synchronizes access to cache */
-	switch_mutex_t *mutex;
+	/** Cache lock stripes */
+	url_cache_shard_t *shards;
+	/** Number of lock stripes */
+	int shard_count;
 	/** Memory pool */
 	switch_memory_pool_t *pool;
-	/** Number of cache hits */
-	int hits;
-	/** Number of cache misses */
-	int misses;
-	/** Number of cache errors */
-	int errors;
 	/** The prefetch queue */
 	switch_queue_t *prefetch_queue;
 	/** Max size of prefetch queue */
@@ -243,13 +299,15 @@ struct url_cache {
 static url_cache_t gcache;
 
 static char *url_cache_get(url_cache_t *cache, http_profile_t *profile, switch_core_session_t *session, const char *url, int download, int refresh, switch_memory_pool_t *pool);
-static switch_status_t url_cache_add(url_cache_t *cache, switch_core_session_t *session, cached_url_t *url);
-static void url_cache_remove(url_cache_t *cache, switch_core_session_t *session, cached_url_t *url);
-static void url_cache_remove_soft(url_cache_t *cache, switch_core_session_t *session, cached_url_t *url);
-static switch_status_t url_cache_replace(url_cache_t *cache, switch_core_session_t *session);
-static void url_cache_lock(url_cache_t *cache, switch_core_session_t *session);
-static void url_cache_unlock(url_cache_t *cache, switch_core_session_t *session);
+static void url_cache_refresh(url_cache_t *cache, http_profile_t *profile, const char *url);
+static url_cache_shard_t *url_cache_shard_find(url_cache_t *cache, const char *url);
+static switch_status_t url_cache_add(url_cache_t *cache, url_cache_shard_t *shard, switch_core_session_t *session, cached_url_t *url);
+static void url_cache_remove(url_cache_shard_t *shard, switch_core_session_t *session, cached_url_t *url);
+static switch_status_t url_cache_replace(url_cache_t *cache, url_cache_shard_t *shard, switch_core_session_t *session);
+static void url_cache_lock(url_cache_shard_t *shard, switch_core_session_t *session);
+static void url_cache_unlock(url_cache_shard_t *shard, switch_core_session_t *session);
 static void url_cache_clear(url_cache_t *cache, switch_core_session_t *session);
+static void url_cache_status(url_cache_t *cache, switch_stream_handle_t *stream);
 static http_profile_t *url_cache_http_profile_find(url_cache_t *cache, const char *name);
 static http_profile_t *url_cache_http_profile_find_by_fqdn(url_cache_t *cache, const char *url);
 
@@ -386,9 +444,9 @@ static switch_status_t http_put(url_cache_t *cache, http_profile_t *profile, swi
 			goto done;
 		}
 
-		curl_handle = switch_curl_easy_init();
+		curl_handle = switch_curl_easy_acquire(full_url);
 		if (!curl_handle) {
-			switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_ERROR, "switch_curl_easy_init() failure\n");
+			switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_ERROR, "switch_curl_easy_acquire() failure\n");
 			status = SWITCH_STATUS_FALSE;
 			goto done;
 		}
@@ -423,7 +481,7 @@ static switch_status_t http_put(url_cache_t *cache, http_profile_t *profile, swi
 		}
 		switch_curl_easy_perform(curl_handle);
 		switch_curl_easy_getinfo(curl_handle, CURLINFO_RESPONSE_CODE, httpRes);
-		switch_curl_easy_cleanup(curl_handle);
+		switch_curl_easy_release(curl_handle);
 
 		if (*httpRes == 200 || *httpRes == 201 || *httpRes == 202 || *httpRes == 204) {
 			switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_DEBUG, "%s saved to %s\n", filename, full_url);
@@ -452,18 +510,28 @@ static switch_status_t http_put(url_cache_t *cache, http_profile_t *profile, swi
 
 	if (status == SWITCH_STATUS_SUCCESS) {
 		if (cache_local_file) {
+			url_cache_shard_t *shard = url_cache_shard_find(cache, url);
 			cached_url_t *u = NULL;
 			/* save to cache */
-			url_cache_lock(cache, session);
-			u = cached_url_create(cache, url, filename);
-			u->size = file_info.st_size;
-			u->status = CACHED_URL_AVAILABLE;
-			if (url_cache_add(cache, session, u) != SWITCH_STATUS_SUCCESS) {
-				/* This error should never happen */
-				switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_CRIT, "Failed to add URL to cache!\n");
+			url_cache_lock(shard, session);
+			if ((u = switch_core_hash_find(shard->map, url)) && u->status == CACHED_URL_AVAILABLE) {
+				/* replace the stale copy */
+				url_cache_remove(shard, session, u);
 				cached_url_destroy(u, cache->pool);
+				u = NULL;
+			}
+			if (!u) {
+				u = cached_url_create(cache, url, filename);
+				u->size = file_info.st_size;
+				u->status = CACHED_URL_AVAILABLE;
+				if (url_cache_add(cache, shard, session, u) != SWITCH_STATUS_SUCCESS) {
+					switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_CRIT, "Failed to add URL to cache!\n");
+					cached_url_destroy(u, cache->pool);
+				} else {
+					shard->size += u->size;
+				}
 			}
-			url_cache_unlock(cache, session);
+			url_cache_unlock(shard, session);
 		}
 
 		if (profile && profile->finalise_put_ptr) {
@@ -649,27 +717,113 @@ static size_t get_header_callback(void *ptr, size_t size, size_t nmemb, void *ge
 }
 
 /**
- * Get exclusive access to the cache
+ * Find the shard owning a URL
  * @param cache The cache
- * @param session The session acquiring the cache
+ * @param url The URL
+ * @return the shard
+ */
+static url_cache_shard_t *url_cache_shard_find(url_cache_t *cache, const char *url)
+{
+	switch_ssize_t len = (switch_ssize_t) strlen(url);
+
+	return &cache->shards[switch_hashfunc_default(url, &len) % cache->shard_count];
+}
+
+/**
+ * Get exclusive access to a cache shard
+ * @param shard The shard
+ * @param session The session acquiring the shard
  */
-static void url_cache_lock(url_cache_t *cache, switch_core_session_t *session)
+static void url_cache_lock(url_cache_shard_t *shard, switch_core_session_t *session)
 {
-	switch_mutex_lock(cache->mutex);
+	switch_mutex_lock(shard->mutex);
 	switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_DEBUG, "Locked cache\n");
 }
 
 /**
- * Relinquish exclusive access to the cache
- * @param cache The cache
- * @param session The session relinquishing the cache
+ * Relinquish exclusive access to a cache shard
+ * @param shard The shard
+ * @param session The session relinquishing the shard
  */
-static void url_cache_unlock(url_cache_t *cache, switch_core_session_t *session)
+static void url_cache_unlock(url_cache_shard_t *shard, switch_core_session_t *session)
 {
-	switch_mutex_unlock(cache->mutex);
+	switch_mutex_unlock(shard->mutex);
 	switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_DEBUG, "Unlocked cache\n");
 }
 
+/**
+ * Number of URLs in a shard.  The caller must lock the shard.
+ */
+static int url_cache_shard_count(url_cache_shard_t *shard)
+{
+	return shard->probation.count + shard->protect.count;
+}
+
+/**
+ * Unlink a URL from its LRU segment.  The caller must lock the shard.
+ */
+static void url_lru_unlink(url_cache_shard_t *shard, cached_url_t *url)
+{
+	url_lru_t *lru;
+
+	if (url->segment == CACHED_URL_SEGMENT_NONE) {
+		return;
+	}
+
+	lru = url->segment == CACHED_URL_SEGMENT_PROTECTED ? &shard->protect : &shard->probation;
+
+	if (url->prev) {
+		url->prev->next = url->next;
+	} else {
+		lru->head = url->next;
+	}
+	if (url->next) {
+		url->next->prev = url->prev;
+	} else {
+		lru->tail = url->prev;
+	}
+
+	url->prev = url->next = NULL;
+	url->segment = CACHED_URL_SEGMENT_NONE;
+	lru->count--;
+}
+
+/**
+ * Link a URL at the most recently used end of a segment.  The caller must lock the shard.
+ */
+static void url_lru_push(url_cache_shard_t *shard, cached_url_t *url, cached_url_segment_t segment)
+{
+	url_lru_t *lru = segment == CACHED_URL_SEGMENT_PROTECTED ? &shard->protect : &shard->probation;
+
+	url->segment = segment;
+	url->prev = NULL;
+	url->next = lru->head;
+	if (lru->head) {
+		lru->head->prev = url;
+	} else {
+		lru->tail = url;
+	}
+	lru->head = url;
+	lru->count++;
+}
+
+/**
+ * Record a hit on a URL: move it to the front of the protected segment,
+ * demoting the least recently used protected URLs back to probation if
+ * the segment is over its limit.  The caller must lock the shard.
+ */
+static void url_cache_touch(url_cache_shard_t *shard, cached_url_t *url)
+{
+	url_lru_unlink(shard, url);
+	url_lru_push(shard, url, CACHED_URL_SEGMENT_PROTECTED);
+
+	while (shard->protect.count > shard->max_protected && shard->protect.tail != url) {
+		cached_url_t *demote = shard->protect.tail;
+		url_lru_unlink(shard, demote);
+		url_lru_push(shard, demote, CACHED_URL_SEGMENT_PROBATION);
+	}
+}
+
 /**
  * Empties the cache
  */
@@ -677,31 +831,62 @@ static void url_cache_clear(url_cache_t *cache, switch_core_session_t *session)
 {
 	int i;
 
-	url_cache_lock(cache, session);
-
-	// remove each cached URL from the hash and the queue
-	for (i = 0; i < cache->queue.max_size; i++) {
-		cached_url_t *url = cache->queue.data[i];
-		if (url) {
-			switch_core_hash_delete(cache->map, url->url);
-			cached_url_destroy(url, cache->pool);
-			cache->queue.data[i] = NULL;
+	for (i = 0; i < cache->shard_count; i++) {
+		url_cache_shard_t *shard = &cache->shards[i];
+		url_lru_t *lrus[2] = { &shard->probation, &shard->protect };
+		int j;
+
+		url_cache_lock(shard, session);
+
+		// remove each cached URL that is not being downloaded
+		for (j = 0; j < 2; j++) {
+			cached_url_t *url = lrus[j]->head;
+			while (url) {
+				cached_url_t *next = url->next;
+				if (url->status == CACHED_URL_AVAILABLE && !url->waiters) {
+					url_cache_remove(shard, session, url);
+					cached_url_destroy(url, cache->pool);
+				}
+				url = next;
+			}
 		}
-	}
-	cache->queue.pos = 0;
-	cache->queue.size = 0;
 
-	// reset cache stats
-	cache->size = 0;
-	cache->hits = 0;
-	cache->misses = 0;
-	cache->errors = 0;
+		// reset cache stats
+		shard->hits = 0;
+		shard->misses = 0;
+		shard->errors = 0;
+		shard->coalesced = 0;
+		shard->evictions = 0;
+		shard->refreshes = 0;
 
-	url_cache_unlock(cache, session);
+		url_cache_unlock(shard, session);
+	}
 
 	switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_INFO, "Emptied cache\n");
 }
 
+/**
+ * Queue a background refresh of a URL that is close to expiring.  The caller must lock the shard.
+ */
+static void url_cache_refresh_queue(url_cache_t *cache, http_profile_t *profile, switch_core_session_t *session, cached_url_t *url)
+{
+	prefetch_job_t *job;
+
+	switch_zmalloc(job, sizeof(*job));
+	job->url = strdup(url->url);
+	job->profile = profile;
+	job->refresh = 1;
+
+	if (switch_queue_trypush(cache->prefetch_queue, job) == SWITCH_STATUS_SUCCESS) {
+		url->refreshing = 1;
+		switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_DEBUG, "Queued refresh of %s\n", url->url);
+	} else {
+		/* prefetch pool is busy, try again on the next hit */
+		switch_safe_free(job->url);
+		switch_safe_free(job);
+	}
+}
+
 /**
  * Get a URL from the cache, add it if it does not exist
  * @param cache The cache
@@ -716,62 +901,70 @@ static void url_cache_clear(url_cache_t *cache, switch_core_session_t *session)
 static char *url_cache_get(url_cache_t *cache, http_profile_t *profile, switch_core_session_t *session, const char *url, int download, int refresh, switch_memory_pool_t *pool)
 {
 	switch_time_t download_timeout_ns = cache->download_timeout * 1000 * 1000;
+	url_cache_shard_t *shard;
 	char *filename = NULL;
 	cached_url_t *u = NULL;
 	if (zstr(url)) {
 		return NULL;
 	}
 
-	url_cache_lock(cache, session);
-	u = switch_core_hash_find(cache->map, url);
+	shard = url_cache_shard_find(cache, url);
+	url_cache_lock(shard, session);
+	u = switch_core_hash_find(shard->map, url);
 
 	if (u && u->status == CACHED_URL_AVAILABLE) {
 		if (switch_time_now() >= (u->download_time + u->max_age)) {
 			switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_INFO, "Cached URL has expired.\n");
-			url_cache_remove_soft(cache, session, u); /* will get permanently deleted upon replacement */
+			url_cache_remove(shard, session, u);
+			cached_url_destroy(u, cache->pool);
 			u = NULL;
 		} else if (switch_file_exists(u->filename, pool) != SWITCH_STATUS_SUCCESS) {
 			switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_INFO, "Cached URL file is missing.\n");
-			url_cache_remove_soft(cache, session, u); /* will get permanently deleted upon replacement */
+			url_cache_remove(shard, session, u);
+			cached_url_destroy(u, cache->pool);
 			u = NULL;
 		} else if (refresh) {
 			switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_INFO, "Cached URL manually expired.\n");
-			url_cache_remove_soft(cache, session, u); /* will get permanently deleted upon replacement */
-			u = NULL;
-		} else if (u->status == CACHED_URL_RX_IN_PROGRESS && switch_time_now() >= (u->download_time + download_timeout_ns)) {
-			switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_INFO, "Download of URL has timed out.\n");
+			url_cache_remove(shard, session, u);
+			cached_url_destroy(u, cache->pool);
 			u = NULL;
 		}
 	}
 
 	if (!u && download) {
 		/* URL is not cached, let's add it.*/
-		/* Set up URL entry and add to map to prevent simultaneous downloads */
-		cache->misses++;
-		switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_INFO, "Cache MISS: size = %zu (%zu MB), hit ratio = %d/%d\n", cache->queue.size, cache->size / 1000000, cache->hits, cache->hits + cache->misses);
+		/* Set up URL entry and add to map so other requests for it wait on this download */
+		shard->misses++;
+		switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_INFO, "Cache MISS: shard size = %d (%zu MB), hit ratio = %d/%d\n", url_cache_shard_count(shard), shard->size / 1000000, shard->hits, shard->hits + shard->misses);
 		u = cached_url_create(cache, url, NULL);
-		if (url_cache_add(cache, session, u) != SWITCH_STATUS_SUCCESS) {
-			/* This error should never happen */
-			url_cache_unlock(cache, session);
+		if (url_cache_add(cache, shard, session, u) != SWITCH_STATUS_SUCCESS) {
+			/* Every entry in the shard is being downloaded or waited on */
+			url_cache_unlock(shard, session);
 			switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_CRIT, "Failed to add URL to cache!\n");
 			cached_url_destroy(u, cache->pool);
 			return NULL;
 		}
 
 		/* download the file */
-		url_cache_unlock(cache, session);
+		url_cache_unlock(shard, session);
 		if (http_get(cache, profile, u, session) == SWITCH_STATUS_SUCCESS) {
 			/* Got the file, let the waiters know it is available */
-			url_cache_lock(cache, session);
+			url_cache_lock(shard, session);
 			u->status = CACHED_URL_AVAILABLE;
 			filename = switch_core_strdup(pool, u->filename);
-			cache->size += u->size;
+			shard->size += u->size;
 		} else {
-			/* Did not get the file, flag for replacement */
-			url_cache_lock(cache, session);
-			url_cache_remove_soft(cache, session, u);
+			/* Did not get the file, the last waiter out destroys it */
+			url_cache_lock(shard, session);
+			url_cache_remove(shard, session, u);
 			switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_INFO, "Failed to download URL %s\n", url);
-			cache->errors++;
+			shard->errors++;
+		}
+
+		if (u->waiters) {
+			switch_thread_cond_broadcast(shard->cond);
+		} else if (u->status == CACHED_URL_REMOVE) {
+			cached_url_destroy(u, cache->pool);
 		}
 	} else if (!u || (u->status == CACHED_URL_RX_IN_PROGRESS && download != DOWNLOAD)) {
 		filename = DOWNLOAD_NEEDED;
@@ -779,133 +972,195 @@ static char *url_cache_get(url_cache_t *cache, http_profile_t *profile, switch_c
 		/* Wait until file is downloaded */
 		if (u->status == CACHED_URL_RX_IN_PROGRESS) {
 			switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_INFO, "Waiting for URL %s to be available\n", url);
+			shard->coalesced++;
 			u->waiters++;
-			url_cache_unlock(cache, session);
-			while(!gcache.shutdown && u->status == CACHED_URL_RX_IN_PROGRESS && switch_time_now() < (u->download_time + download_timeout_ns)) {
-				switch_sleep(10 * 1000); /* 10 ms */
+			while (!cache->shutdown && u->status == CACHED_URL_RX_IN_PROGRESS && switch_time_now() < (u->download_time + download_timeout_ns)) {
+				/* woken by the downloader, time out now and then to check for shutdown */
+				switch_thread_cond_timedwait(shard->cond, shard->mutex, 100 * 1000);
 			}
-			url_cache_lock(cache, session);
 			u->waiters--;
+
+			if (u->status == CACHED_URL_REMOVE) {
+				if (!u->waiters) {
+					cached_url_destroy(u, cache->pool);
+				}
+				u = NULL;
+			}
 		}
 
 		/* grab filename if everything is OK */
-		if (u->status == CACHED_URL_AVAILABLE) {
+		if (u && u->status == CACHED_URL_AVAILABLE) {
 			filename = switch_core_strdup(pool, u->filename);
-			cache->hits++;
-			u->used = 1;
-			switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_DEBUG, "Cache HIT: size = %zu (%zu MB), hit ratio = %d/%d\n", cache->queue.size, cache->size / 1000000, cache->hits, cache->hits + cache->misses);
+			shard->hits++;
+			url_cache_touch(shard, u);
+			switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_DEBUG, "Cache HIT: shard size = %d (%zu MB), hit ratio = %d/%d\n", url_cache_shard_count(shard), shard->size / 1000000, shard->hits, shard->hits + shard->misses);
+
+			if (cache->refresh_ahead && !u->refreshing &&
+				switch_time_now() >= u->download_time + u->max_age - (u->max_age / 100 * cache->refresh_ahead)) {
+				url_cache_refresh_queue(cache, profile, session, u);
+			}
 		}
 	}
-	url_cache_unlock(cache, session);
+	url_cache_unlock(shard, session);
 	return filename;
 }
 
 /**
- * Add a URL to the cache.  The caller must lock the cache.
+ * Download a fresh copy of a cached URL and swap it in, leaving the
+ * current copy in service until the download completes.  Runs in the
+ * prefetch thread pool.
+ * @param cache The cache
+ * @param profile optional profile
+ * @param url The URL
+ */
+static void url_cache_refresh(url_cache_t *cache, http_profile_t *profile, const char *url)
+{
+	url_cache_shard_t *shard = url_cache_shard_find(cache, url);
+	cached_url_t *fresh = cached_url_create(cache, url, NULL);
+	cached_url_t *u;
+	switch_status_t status;
+
+	status = http_get(cache, profile, fresh, NULL);
+
+	url_cache_lock(shard, NULL);
+	u = switch_core_hash_find(shard->map, url);
+	if (status == SWITCH_STATUS_SUCCESS && u && u->status == CACHED_URL_AVAILABLE) {
+		cached_url_segment_t segment = u->segment;
+
+		url_cache_remove(shard, NULL, u);
+		cached_url_destroy(u, cache->pool);
+
+		fresh->status = CACHED_URL_AVAILABLE;
+		url_lru_push(shard, fresh, segment == CACHED_URL_SEGMENT_NONE ? CACHED_URL_SEGMENT_PROBATION : segment);
+		switch_core_hash_insert(shard->map, fresh->url, fresh);
+		shard->size += fresh->size;
+		shard->refreshes++;
+		fresh = NULL;
+	} else if (status != SWITCH_STATUS_SUCCESS) {
+		/* leave the refreshing flag set so a failing origin is not retried on every hit, the entry expires as usual */
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_INFO, "Failed to refresh URL %s\n", url);
+		shard->errors++;
+	}
+	url_cache_unlock(shard, NULL);
+
+	if (fresh) {
+		cached_url_destroy(fresh, cache->pool);
+	}
+}
+
+/**
+ * Add a URL to the cache.  The caller must lock the shard.
  * @param cache the cache
+ * @param shard the shard owning the URL
  * @param session the (optional) session
  * @param url the URL to add
  * @return SWITCH_STATUS_SUCCESS if successful
  */
-static switch_status_t url_cache_add(url_cache_t *cache, switch_core_session_t *session, cached_url_t *url)
+static switch_status_t url_cache_add(url_cache_t *cache, url_cache_shard_t *shard, switch_core_session_t *session, cached_url_t *url)
 {
-	simple_queue_t *queue = &cache->queue;
-	if (queue->size >= queue->max_size && url_cache_replace(cache, session) != SWITCH_STATUS_SUCCESS) {
+	if (url_cache_shard_count(shard) >= shard->max_url && url_cache_replace(cache, shard, session) != SWITCH_STATUS_SUCCESS) {
 		return SWITCH_STATUS_FALSE;
 	}
-	switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_DEBUG, "Adding %s(%s) to cache index %d\n", url->url, url->filename, queue->pos);
+	switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_DEBUG, "Adding %s(%s) to cache\n", url->url, url->filename);
 
-	queue->data[queue->pos] = url;
-	queue->pos = (queue->pos + 1) % queue->max_size;
-	queue->size++;
-	switch_core_hash_insert(cache->map, url->url, url);
+	url_lru_push(shard, url, CACHED_URL_SEGMENT_PROBATION);
+	switch_core_hash_insert(shard->map, url->url, url);
 	return SWITCH_STATUS_SUCCESS;
 }
 
 /**
- * Select a URL for replacement and remove it from the cache.
- * Currently implemented with the clock replacement algorithm.  It's not
- * great, but is better than least recently used and is simple to implement.
+ * Select a URL for replacement and remove it from the cache.  The least
+ * recently used URL in the probation segment goes first, then the least
+ * recently used protected URL.  URLs being downloaded or waited on are
+ * skipped.  The caller must lock the shard.
  *
  * @param cache the cache
+ * @param shard the shard to make room in
  * @param session the (optional) session
  * @return SWITCH_STATUS_SUCCESS if successful
  */
-static switch_status_t url_cache_replace(url_cache_t *cache, switch_core_session_t *session)
+static switch_status_t url_cache_replace(url_cache_t *cache, url_cache_shard_t *shard, switch_core_session_t *session)
 {
-	switch_status_t status = SWITCH_STATUS_FALSE;
-	int i = 0;
-	simple_queue_t *queue = &cache->queue;
-
-	if (queue->size < queue->max_size || queue->size == 0) {
-		return SWITCH_STATUS_FALSE;
-	}
-
-	for (i = 0; i < queue->max_size * 2; i++) {
-		cached_url_t *to_replace = (cached_url_t *)queue->data[queue->pos];
-
-		/* check for queue corruption */
-		if (to_replace == NULL) {
-			switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_CRIT, "Unexpected empty URL at cache index %d\n", queue->pos);
-			status = SWITCH_STATUS_SUCCESS;
-			break;
-		}
+	url_lru_t *lrus[2] = { &shard->probation, &shard->protect };
+	int i;
 
-		/* check if available for replacement */
-		if (!to_replace->used && !to_replace->waiters) {
-			/* remove from cache and destroy it */
-			url_cache_remove(cache, session, to_replace);
-			cached_url_destroy(to_replace, cache->pool);
-			status = SWITCH_STATUS_SUCCESS;
-			break;
-		}
+	for (i = 0; i < 2; i++) {
+		cached_url_t *to_replace;
 
-		/* not available for replacement.  Mark as not used and move to back of queue */
-		if (to_replace->status == CACHED_URL_AVAILABLE) {
-			to_replace->used = 0;
+		for (to_replace = lrus[i]->tail; to_replace; to_replace = to_replace->prev) {
+			if (to_replace->status == CACHED_URL_AVAILABLE && !to_replace->waiters) {
+				url_cache_remove(shard, session, to_replace);
+				cached_url_destroy(to_replace, cache->pool);
+				shard->evictions++;
+				return SWITCH_STATUS_SUCCESS;
+			}
 		}
-		queue->pos = (queue->pos + 1) % queue->max_size;
 	}
 
-	return status;
+	return SWITCH_STATUS_FALSE;
 }
 
 /**
- * Remove a URL from the hash map and mark it as eligible for replacement from the queue.
+ * Remove a URL from the hash map and its LRU segment and mark it removed.
+ * The caller must lock the shard and destroy the URL once nothing refers to it.
+ * @param shard the shard owning the URL
+ * @param session the (optional) session
+ * @param url the URL to remove
  */
-static void url_cache_remove_soft(url_cache_t *cache, switch_core_session_t *session, cached_url_t *url)
+static void url_cache_remove(url_cache_shard_t *shard, switch_core_session_t *session, cached_url_t *url)
 {
-	switch_core_hash_delete(cache->map, url->url);
-	url->used = 0;
+	if (switch_core_hash_find(shard->map, url->url) == url) {
+		switch_core_hash_delete(shard->map, url->url);
+	}
+
+	if (url->segment != CACHED_URL_SEGMENT_NONE) {
+		switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_DEBUG, "Removing %s(%s) from cache\n", url->url, url->filename);
+		url_lru_unlink(shard, url);
+	}
+
+	/* adjust cache statistics */
+	if (url->status == CACHED_URL_AVAILABLE) {
+		shard->size -= url->size;
+	}
 	url->status = CACHED_URL_REMOVE;
 }
 
 /**
- * Remove a URL from the front or back of the cache
+ * Write cache statistics
  * @param cache the cache
- * @param session the (optional) session
- * @param url the URL to remove
+ * @param stream the output stream
  */
-static void url_cache_remove(url_cache_t *cache, switch_core_session_t *session, cached_url_t *url)
+static void url_cache_status(url_cache_t *cache, switch_stream_handle_t *stream)
 {
-	simple_queue_t *queue;
-	cached_url_t *to_remove;
-
-	url_cache_remove_soft(cache, session, url);
-
-	/* make sure cached URL matches the item in the queue and remove it */
-	queue = &cache->queue;
-	to_remove = (cached_url_t *)queue->data[queue->pos];
-	if (url == to_remove) {
-		switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_DEBUG, "Removing %s(%s) from cache index %d\n", url->url, url->filename, queue->pos);
-		queue->data[queue->pos] = NULL;
-		queue->size--;
-	} else {
-		switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_CRIT, "URL entry, %s, not in cache queue!!!\n", url->url);
-	}
-
-	/* adjust cache statistics */
-	cache->size -= url->size;
+	int i, urls = 0, probation = 0, hits = 0, misses = 0, errors = 0, coalesced = 0, evictions = 0, refreshes = 0;
+	size_t size = 0;
+
+	for (i = 0; i < cache->shard_count; i++) {
+		url_cache_shard_t *shard = &cache->shards[i];
+
+		url_cache_lock(shard, NULL);
+		urls += url_cache_shard_count(shard);
+		probation += shard->probation.count;
+		size += shard->size;
+		hits += shard->hits;
+		misses += shard->misses;
+		errors += shard->errors;
+		coalesced += shard->coalesced;
+		evictions += shard->evictions;
+		refreshes += shard->refreshes;
+		url_cache_unlock(shard, NULL);
+	}
+
+	stream->write_function(stream, "urls: %d/%d (%d probation, %d protected)\n", urls, cache->max_url, probation, urls - probation);
+	stream->write_function(stream, "size: %zu bytes\n", size);
+	stream->write_function(stream, "shards: %d\n", cache->shard_count);
+	stream->write_function(stream, "hits: %d\n", hits);
+	stream->write_function(stream, "misses: %d\n", misses);
+	stream->write_function(stream, "coalesced: %d\n", coalesced);
+	stream->write_function(stream, "errors: %d\n", errors);
+	stream->write_function(stream, "evictions: %d\n", evictions);
+	stream->write_function(stream, "refreshes: %d\n", refreshes);
+	stream->write_function(stream, "prefetch queue: %u/%d\n", switch_queue_size(cache->prefetch_queue), cache->prefetch_queue_size);
 }
 
 /**
@@ -1057,7 +1312,6 @@ static cached_url_t *cached_url_create(url_cache_t *cache, const char *url, cons
 	}
 	u->url = switch_safe_strdup(url);
 	u->size = 0;
-	u->used = 1;
 	u->status = CACHED_URL_RX_IN_PROGRESS;
 	u->waiters = 0;
 	u->download_time = switch_time_now();
@@ -1122,7 +1376,7 @@ static switch_status_t http_get(url_cache_t *cache, http_profile_t *profile, cac
 		switch_strdup(full_url, url->url);
 	}
 
-	curl_handle = switch_curl_easy_init();
+	curl_handle = switch_curl_easy_acquire(full_url);
 	switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_DEBUG, "opening %s for URL cache\n", get_data.url->filename);
 #ifdef WIN32
 	if ((get_data.fd = open(get_data.url->filename, O_CREAT | O_RDWR | O_TRUNC, S_IRUSR | S_IWUSR | O_BINARY)) > -1) {
@@ -1164,7 +1418,7 @@ static switch_status_t http_get(url_cache_t *cache, http_profile_t *profile, cac
 		
 		curl_status = switch_curl_easy_perform(curl_handle);
 		switch_curl_easy_getinfo(curl_handle, CURLINFO_RESPONSE_CODE, &httpRes);
-		switch_curl_easy_cleanup(curl_handle);
+		switch_curl_easy_release(curl_handle);
 		close(get_data.fd);
 	} else {
 		switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_ERROR, "open() error: %s\n", strerror(errno));
@@ -1213,6 +1467,8 @@ static void setup_dir(url_cache_t *cache)
 	for (i = 0x00; i <= 0xff; i++) {
 		switch_dir_t *dir = NULL;
 		char *dirname = switch_mprintf("%s%s%02x", cache->location, SWITCH_PATH_SEPARATOR, i);
+		/* create it now, so cached_url_filename_create() only finds it existing */
+		switch_dir_make_recursive(dirname, SWITCH_DEFAULT_DIR_PERMS, cache->pool);
 		if (switch_dir_open(&dir, dirname, cache->pool) == SWITCH_STATUS_SUCCESS) {
 			char filenamebuf[256] = { 0 };
 			const char *filename = NULL;
@@ -1234,7 +1490,7 @@ static void setup_dir(url_cache_t *cache)
 SWITCH_STANDARD_API(http_cache_prefetch)
 {
 	switch_status_t status = SWITCH_STATUS_SUCCESS;
-	char *url;
+	prefetch_job_t *job;
 
 	if (zstr(cmd)) {
 		stream->write_function(stream, "USAGE: %s\n", HTTP_PREFETCH_SYNTAX);
@@ -1242,9 +1498,11 @@ SWITCH_STANDARD_API(http_cache_prefetch)
 	}
 
 	/* send to thread pool */
-	url = switch_mprintf("{prefetch=true}%s", cmd);
-	if (switch_queue_trypush(gcache.prefetch_queue, url) != SWITCH_STATUS_SUCCESS) {
-		switch_safe_free(url);
+	switch_zmalloc(job, sizeof(*job));
+	job->url = switch_mprintf("{prefetch=true}%s", cmd);
+	if (switch_queue_trypush(gcache.prefetch_queue, job) != SWITCH_STATUS_SUCCESS) {
+		switch_safe_free(job->url);
+		switch_safe_free(job);
 		switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_WARNING, "Failed to queue prefetch request\n");
 		stream->write_function(stream, "-ERR\n");
 	} else {
@@ -1495,6 +1753,20 @@ SWITCH_STANDARD_API(http_cache_remove)
 	return SWITCH_STATUS_SUCCESS;
 }
 
+#define HTTP_CACHE_STATUS_SYNTAX ""
+/**
+ * Show cache statistics
+ */
+SWITCH_STANDARD_API(http_cache_status)
+{
+	if (!zstr(cmd)) {
+		stream->write_function(stream, "USAGE: %s\n", HTTP_CACHE_STATUS_SYNTAX);
+	} else {
+		url_cache_status(&gcache, stream);
+	}
+	return SWITCH_STATUS_SUCCESS;
+}
+
 /**
  * Thread to prefetch URLs
  * @param thread the thread
@@ -1504,27 +1776,37 @@ SWITCH_STANDARD_API(http_cache_remove)
 static void *SWITCH_THREAD_FUNC prefetch_thread(switch_thread_t *thread, void *obj)
 {
 	int *started = obj;
-	void *url = NULL;
+	void *pop = NULL;
 
 	switch_thread_rwlock_rdlock(gcache.shutdown_lock);
 	*started = 1;
 
-	// process prefetch requests
+	// process prefetch and refresh requests
 	while (!gcache.shutdown) {
-		if (switch_queue_pop(gcache.prefetch_queue, &url) == SWITCH_STATUS_SUCCESS) {
-			switch_stream_handle_t stream = { 0 };
-			SWITCH_STANDARD_STREAM(stream);
-			switch_api_execute("http_get", url, NULL, &stream);
-			switch_safe_free(stream.data);
-			switch_safe_free(url);
+		if (switch_queue_pop(gcache.prefetch_queue, &pop) == SWITCH_STATUS_SUCCESS && pop) {
+			prefetch_job_t *job = (prefetch_job_t *) pop;
+			if (job->refresh) {
+				url_cache_refresh(&gcache, job->profile, job->url);
+			} else {
+				switch_stream_handle_t stream = { 0 };
+				SWITCH_STANDARD_STREAM(stream);
+				switch_api_execute("http_get", job->url, NULL, &stream);
+				switch_safe_free(stream.data);
+			}
+			switch_safe_free(job->url);
+			switch_safe_free(job);
 		}
-		url = NULL;
+		pop = NULL;
 	}
 
 	// shutting down- clear the queue
-	while (switch_queue_trypop(gcache.prefetch_queue, &url) == SWITCH_STATUS_SUCCESS) {
-		switch_safe_free(url);
-		url = NULL;
+	while (switch_queue_trypop(gcache.prefetch_queue, &pop) == SWITCH_STATUS_SUCCESS) {
+		prefetch_job_t *job = (prefetch_job_t *) pop;
+		if (job) {
+			switch_safe_free(job->url);
+			switch_safe_free(job);
+		}
+		pop = NULL;
 	}
 
 	switch_thread_rwlock_unlock(gcache.shutdown_lock);
@@ -1588,6 +1870,7 @@ static switch_status_t do_config(url_cache_t *cache)
 	switch_xml_t cfg, xml, param, settings, profiles;
 	switch_status_t status = SWITCH_STATUS_SUCCESS;
 	int max_urls;
+	int shards;
 	switch_time_t default_max_age_sec;
 
 	if (!(xml = switch_xml_open_cfg(cf, &cfg, NULL))) {
@@ -1597,7 +1880,9 @@ static switch_status_t do_config(url_cache_t *cache)
 
 	/* set default config */
 	max_urls = 4000;
+	shards = 16;
 	default_max_age_sec = 86400;
+	cache->refresh_ahead = 10;
 	cache->location = switch_core_sprintf(cache->pool, "%s%s", SWITCH_GLOBAL_dirs.base_dir, "/http_cache");
 	cache->prefetch_queue_size = 100;
 	cache->prefetch_thread_count = 8;
@@ -1634,6 +1919,12 @@ static switch_status_t do_config(url_cache_t *cache)
 			} else if (!strcasecmp(var, "prefetch-thread-count")) {
 				switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_INFO, "Setting prefetch-thread-count to %s\n", val);
 				cache->prefetch_thread_count = atoi(val);
+			} else if (!strcasecmp(var, "cache-shards")) {
+				switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_INFO, "Setting cache-shards to %s\n", val);
+				shards = atoi(val);
+			} else if (!strcasecmp(var, "refresh-ahead")) {
+				switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_INFO, "Setting refresh-ahead to %s\n", val);
+				cache->refresh_ahead = atoi(val);
 			} else if (!strcasecmp(var, "ssl-cacert")) {
 				switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_INFO, "Setting ssl-cacert to %s\n", val);
 				cache->ssl_cacert = switch_core_strdup(cache->pool, val);
@@ -1753,7 +2044,23 @@ static switch_status_t do_config(url_cache_t *cache)
 		goto done;
 	}
 
+	if (shards <= 0) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "cache-shards must be > 0\n");
+		status = SWITCH_STATUS_TERM;
+		goto done;
+	}
+	if (cache->refresh_ahead < 0 || cache->refresh_ahead > 100) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "refresh-ahead must be between 0 and 100\n");
+		status = SWITCH_STATUS_TERM;
+		goto done;
+	}
+
 	cache->max_url = max_urls;
+	/* don't spread the cache so thin that a shard evicts long before the cache is full */
+	cache->shard_count = shards > max_urls / 8 ? max_urls / 8 : shards;
+	if (cache->shard_count < 1) {
+		cache->shard_count = 1;
+	}
 	cache->default_max_age = (default_max_age_sec * 1000 * 1000); /* convert from seconds to nanoseconds */
 done:
 	switch_xml_free(xml);
@@ -1975,13 +2282,12 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_http_cache_load)
 	SWITCH_ADD_API(api, "http_clear_cache", "Clear the cache", http_cache_clear, HTTP_CACHE_CLEAR_SYNTAX);
 	SWITCH_ADD_API(api, "http_remove_cache", "Remove URL from cache", http_cache_remove, HTTP_CACHE_REMOVE_SYNTAX);
 	SWITCH_ADD_API(api, "http_prefetch", "Prefetch document in a background thread.  Use http_get to get the prefetched document", http_cache_prefetch, HTTP_PREFETCH_SYNTAX);
+	SWITCH_ADD_API(api, "http_cache_status", "Show cache statistics", http_cache_status, HTTP_CACHE_STATUS_SYNTAX);
 
 	memset(&gcache, 0, sizeof(url_cache_t));
 	gcache.pool = pool;
-	switch_core_hash_init(&gcache.map);
 	switch_core_hash_init(&gcache.profiles);
 	switch_core_hash_init_nocase(&gcache.fqdn_profiles);
-	switch_mutex_init(&gcache.mutex, SWITCH_MUTEX_UNNESTED, gcache.pool);
 	switch_thread_rwlock_create(&gcache.shutdown_lock, gcache.pool);
 
 	if (do_config(&gcache) != SWITCH_STATUS_SUCCESS) {
@@ -2023,11 +2329,16 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_http_cache_load)
         file_interface->file_seek = http_cache_file_seek;
 	}
 
-	/* create the queue from configuration */
-	gcache.queue.max_size = gcache.max_url;
-	gcache.queue.data = switch_core_alloc(gcache.pool, sizeof(void *) * gcache.queue.max_size);
-	gcache.queue.pos = 0;
-	gcache.queue.size = 0;
+	/* create the shards from configuration */
+	gcache.shards = switch_core_alloc(gcache.pool, sizeof(url_cache_shard_t) * gcache.shard_count);
+	for (i = 0; i < gcache.shard_count; i++) {
+		url_cache_shard_t *shard = &gcache.shards[i];
+		switch_mutex_init(&shard->mutex, SWITCH_MUTEX_UNNESTED, gcache.pool);
+		switch_thread_cond_create(&shard->cond, gcache.pool);
+		switch_core_hash_init(&shard->map);
+		shard->max_url = (gcache.max_url + gcache.shard_count - 1) / gcache.shard_count;
+		shard->max_protected = shard->max_url * 4 / 5;
+	}
 
 	setup_dir(&gcache);
 
@@ -2055,16 +2366,21 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_http_cache_load)
  */
 SWITCH_MODULE_SHUTDOWN_FUNCTION(mod_http_cache_shutdown)
 {
+	int i;
+
 	gcache.shutdown = 1;
 	switch_queue_interrupt_all(gcache.prefetch_queue);
 	switch_thread_rwlock_wrlock(gcache.shutdown_lock);
 	switch_thread_rwlock_unlock(gcache.shutdown_lock);
 
 	url_cache_clear(&gcache, NULL);
-	switch_core_hash_destroy(&gcache.map);
+	for (i = 0; i < gcache.shard_count; i++) {
+		switch_core_hash_destroy(&gcache.shards[i].map);
+		switch_thread_cond_destroy(gcache.shards[i].cond);
+		switch_mutex_destroy(gcache.shards[i].mutex);
+	}
 	switch_core_hash_destroy(&gcache.profiles);
 	switch_core_hash_destroy(&gcache.fqdn_profiles);
-	switch_mutex_destroy(gcache.mutex);
 	return SWITCH_STATUS_SUCCESS;
 }
 
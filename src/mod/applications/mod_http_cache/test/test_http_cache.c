@@ -0,0 +1,251 @@
+/*
+ * FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ * Copyright (C) 2005-2020, Anthony Minessale II <anthm@freeswitch.org>
+ *
+ * Version: MPL 1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ *
+ * The Initial Developer of the Original Code is
+ * Anthony Minessale II <anthm@freeswitch.org>
+ * Portions created by the Initial Developer are Copyright (C)
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *
+ * test_http_cache.c - Unit tests for waiting on a download in progress
+ *
+ */
+
+#include <switch.h>
+#include <test/switch_test.h>
+#include "../mod_http_cache.c"
+
+// Run test
+// make && libtool --mode=execute valgrind --leak-check=full  --log-file=vg.log ./test/test_http_cache && cat vg.log
+
+#define TEST_URL "http://localhost/test_http_cache.wav"
+#define TEST_FILE "/tmp/test_http_cache.wav"
+
+/** How the fake download finishes */
+struct test_download {
+	url_cache_t *cache;
+	cached_url_t *url;
+	/** the status the download finishes with */
+	cached_url_status_t status;
+};
+
+/**
+ * Stand in for the thread downloading the URL, finishes it after 200 ms
+ */
+static void *SWITCH_THREAD_FUNC test_download_thread(switch_thread_t *thread, void *obj)
+{
+	struct test_download *download = (struct test_download *)obj;
+	url_cache_shard_t *shard = url_cache_shard_find(download->cache, download->url->url);
+
+	switch_yield(200000);
+
+	url_cache_lock(shard, NULL);
+	if (download->status == CACHED_URL_AVAILABLE) {
+		download->url->status = CACHED_URL_AVAILABLE;
+	} else {
+		url_cache_remove(shard, NULL, download->url);
+	}
+	switch_thread_cond_broadcast(shard->cond);
+	url_cache_unlock(shard, NULL);
+
+	return NULL;
+}
+
+/**
+ * A single shard cache, set up like the module does
+ */
+static void test_cache_create(url_cache_t *cache, switch_memory_pool_t *pool)
+{
+	url_cache_shard_t *shard;
+
+	memset(cache, 0, sizeof(*cache));
+	cache->pool = pool;
+	cache->max_url = 8;
+	cache->default_max_age = 60 * 1000 * 1000;
+	cache->download_timeout = 1;
+	cache->shard_count = 1;
+	cache->shards = switch_core_alloc(pool, sizeof(url_cache_shard_t));
+
+	shard = &cache->shards[0];
+	switch_mutex_init(&shard->mutex, SWITCH_MUTEX_UNNESTED, pool);
+	switch_thread_cond_create(&shard->cond, pool);
+	switch_core_hash_init(&shard->map);
+	shard->max_url = cache->max_url;
+	shard->max_protected = shard->max_url * 4 / 5;
+}
+
+static void test_cache_destroy(url_cache_t *cache)
+{
+	url_cache_shard_t *shard = &cache->shards[0];
+	cached_url_t *u;
+
+	while ((u = switch_core_hash_find(shard->map, TEST_URL))) {
+		url_cache_remove(shard, NULL, u);
+		cached_url_destroy(u, cache->pool);
+	}
+	switch_core_hash_destroy(&shard->map);
+}
+
+/**
+ * Add an entry for TEST_URL that another thread is still downloading
+ */
+static cached_url_t *test_cache_add_in_progress(url_cache_t *cache)
+{
+	url_cache_shard_t *shard = &cache->shards[0];
+	cached_url_t *u = cached_url_create(cache, TEST_URL, TEST_FILE);
+
+	url_cache_lock(shard, NULL);
+	url_cache_add(cache, shard, NULL, u);
+	url_cache_unlock(shard, NULL);
+
+	return u;
+}
+
+static void test_download_start(struct test_download *download, switch_memory_pool_t *pool)
+{
+	switch_thread_t *thread;
+	switch_threadattr_t *thd_attr = NULL;
+
+	switch_threadattr_create(&thd_attr, pool);
+	switch_threadattr_detach_set(thd_attr, 1);
+	switch_thread_create(&thread, thd_attr, test_download_thread, download, pool);
+}
+
+FST_MINCORE_BEGIN("./conf")
+{
+
+FST_SUITE_BEGIN(http_cache)
+{
+	FST_SETUP_BEGIN()
+	{
+	}
+	FST_SETUP_END()
+
+	FST_TEARDOWN_BEGIN()
+	{
+	}
+	FST_TEARDOWN_END()
+
+	FST_TEST_BEGIN(wait_times_out)
+	{
+		url_cache_t cache;
+		cached_url_t *u;
+		switch_time_t start, elapsed;
+		char *filename;
+
+		test_cache_create(&cache, fst_pool);
+		u = test_cache_add_in_progress(&cache);
+
+		/* nobody finishes the download, the waiter gives up at download-timeout */
+		start = switch_time_now();
+		filename = url_cache_get(&cache, NULL, NULL, TEST_URL, DOWNLOAD, 0, fst_pool);
+		elapsed = switch_time_now() - start;
+		fst_check(filename == NULL);
+		fst_check(elapsed >= 900000);
+		fst_check(elapsed < 2000000);
+		fst_check_int_equals(cache.shards[0].coalesced, 1);
+		fst_check_int_equals(u->waiters, 0);
+		fst_check(u->status == CACHED_URL_RX_IN_PROGRESS);
+
+		/* once the timeout has passed, later requests do not wait at all */
+		start = switch_time_now();
+		filename = url_cache_get(&cache, NULL, NULL, TEST_URL, DOWNLOAD, 0, fst_pool);
+		elapsed = switch_time_now() - start;
+		fst_check(filename == NULL);
+		fst_check(elapsed < 100000);
+
+		test_cache_destroy(&cache);
+	}
+	FST_TEST_END()
+
+	FST_TEST_BEGIN(wait_woken_by_download)
+	{
+		url_cache_t cache;
+		struct test_download download;
+		switch_time_t start, elapsed;
+		char *filename;
+
+		test_cache_create(&cache, fst_pool);
+		cache.download_timeout = 10;
+		download.cache = &cache;
+		download.url = test_cache_add_in_progress(&cache);
+		download.status = CACHED_URL_AVAILABLE;
+
+		/* the waiter returns the file as soon as the download completes */
+		test_download_start(&download, fst_pool);
+		start = switch_time_now();
+		filename = url_cache_get(&cache, NULL, NULL, TEST_URL, DOWNLOAD, 0, fst_pool);
+		elapsed = switch_time_now() - start;
+		fst_check_string_equals(filename, TEST_FILE);
+		fst_check(elapsed < 1000000);
+		fst_check_int_equals(cache.shards[0].hits, 1);
+		fst_check_int_equals(download.url->waiters, 0);
+
+		test_cache_destroy(&cache);
+	}
+	FST_TEST_END()
+
+	FST_TEST_BEGIN(wait_download_failed)
+	{
+		url_cache_t cache;
+		struct test_download download;
+		switch_time_t start, elapsed;
+		char *filename;
+
+		test_cache_create(&cache, fst_pool);
+		cache.download_timeout = 10;
+		download.cache = &cache;
+		download.url = test_cache_add_in_progress(&cache);
+		download.status = CACHED_URL_REMOVE;
+
+		/* the download fails, the waiter fails with it and frees the entry */
+		test_download_start(&download, fst_pool);
+		start = switch_time_now();
+		filename = url_cache_get(&cache, NULL, NULL, TEST_URL, DOWNLOAD, 0, fst_pool);
+		elapsed = switch_time_now() - start;
+		fst_check(filename == NULL);
+		fst_check(elapsed < 1000000);
+		fst_check(switch_core_hash_find(cache.shards[0].map, TEST_URL) == NULL);
+		fst_check_int_equals(url_cache_shard_count(&cache.shards[0]), 0);
+
+		test_cache_destroy(&cache);
+	}
+	FST_TEST_END()
+
+	FST_TEST_BEGIN(prefetch_does_not_wait)
+	{
+		url_cache_t cache;
+		char *filename;
+
+		test_cache_create(&cache, fst_pool);
+		test_cache_add_in_progress(&cache);
+
+		/* a prefetch leaves a download in progress alone */
+		filename = url_cache_get(&cache, NULL, NULL, TEST_URL, PREFETCH, 0, fst_pool);
+		fst_check_string_equals(filename, DOWNLOAD_NEEDED);
+		fst_check_int_equals(cache.shards[0].coalesced, 0);
+
+		test_cache_destroy(&cache);
+	}
+	FST_TEST_END()
+}
+FST_SUITE_END()
+
+}
+FST_MINCORE_END()
@@ -34,7 +34,10 @@
 #include <switch.h>
 
 #define LCR_SYNTAX "lcr <digits> [<lcr profile>] [caller_id] [intrastate] [as xml]"
-#define LCR_ADMIN_SYNTAX "lcr_admin show profiles"
+#define LCR_ADMIN_SYNTAX "lcr_admin show profiles | deck reload <lcr profile> | deck bench <prefixes> [<lookups>]"
+
+/* longest number we walk down the deck trie */
+#define LCR_DECK_MAX_DIGITS 64
 
 #define LCR_HEADERS_COUNT 7
 
@@ -100,6 +103,79 @@ typedef lcr_obj_t *lcr_route;
 typedef struct max_obj max_obj_t;
 typedef max_obj_t *max_len;
 
+/* what a column of an in-memory rate deck is used for */
+typedef enum {
+	LCR_DECK_COL_FIELD,
+	LCR_DECK_COL_DIGITS,
+	LCR_DECK_COL_LRN,
+	LCR_DECK_COL_RATE,
+	LCR_DECK_COL_INTRASTATE_RATE,
+	LCR_DECK_COL_INTRALATA_RATE,
+	LCR_DECK_COL_USER_RATE,
+	LCR_DECK_COL_USER_INTRASTATE_RATE,
+	LCR_DECK_COL_USER_INTRALATA_RATE,
+	LCR_DECK_COL_DATE_START,
+	LCR_DECK_COL_DATE_END,
+	LCR_DECK_COL_NOW,
+	LCR_DECK_COL_ORDER
+} lcr_deck_col_t;
+
+/* a term of the profile's order_by, col is -1 for the rate picked per call */
+struct lcr_deck_order {
+	int col;
+	switch_bool_t desc;
+};
+typedef struct lcr_deck_order lcr_deck_order_t;
+
+/* a node of the deck's path compressed prefix trie.  the children of a
+   node are stored next to each other in digit order and child_mask has a
+   bit set for each digit that has a child */
+struct lcr_trie_node {
+	uint32_t label;
+	uint16_t label_len;
+	uint16_t child_mask;
+	uint32_t first_child;
+	uint32_t route_first;
+	uint32_t route_count;
+};
+typedef struct lcr_trie_node lcr_trie_node_t;
+
+/* an immutable snapshot of a profile's rate deck.  lookups hold a
+   reference, reloads build a new snapshot and swap it in */
+struct lcr_deck {
+	switch_memory_pool_t *pool;
+	int refs;
+	switch_bool_t retired;
+	int column_count;
+	char **columns;
+	lcr_deck_col_t *roles;
+	/* interned column values, index 0 is NULL */
+	char **strings;
+	uint32_t string_count;
+	lcr_trie_node_t *nodes;
+	uint32_t node_count;
+	char *labels;
+	size_t labels_len;
+	/* column_count string indexes per route, routes of a prefix are adjacent */
+	uint32_t *values;
+	uint8_t *lrn;
+	uint32_t route_count;
+	uint32_t prefix_count;
+	/* routes of a prefix are loaded in this order with the plain rate */
+	lcr_deck_order_t *order;
+	int order_count;
+	/* date_start and date_end are checked per lookup, times holds them
+	   parsed by string index, 0 if the string is not a date */
+	int date_start_col;
+	int date_end_col;
+	switch_time_t *times;
+	/* how far the database clock was ahead of ours at load */
+	switch_time_t clock_skew;
+	switch_time_t load_time;
+	int64_t load_ms;
+};
+typedef struct lcr_deck lcr_deck_t;
+
 struct profile_obj {
 	char *name;
 	uint16_t id;
@@ -120,6 +196,12 @@ struct profile_obj {
 	switch_bool_t single_bridge;
 	switch_bool_t info_in_headers;
 	switch_bool_t enable_sip_redir;
+
+	switch_bool_t in_memory;
+	char *deck_sql;
+	char *deck_csv;
+	lcr_deck_t *deck;
+	switch_bool_t deck_loading;
 };
 typedef struct profile_obj profile_t;
 
@@ -147,6 +229,9 @@ static struct {
 	switch_mutex_t *mutex;
 	switch_hash_t *profile_hash;
 	profile_t *default_profile;
+	/* running deck reload threads */
+	int deck_loads;
+	switch_bool_t deck_shutdown;
 	void *filler1;
 } globals;
 
@@ -827,6 +912,962 @@ static int route_add_callback(void *pArg, int argc, char **argv, char **columnNa
 
 }
 
+/* state while a deck is being loaded */
+struct lcr_deck_row {
+	char *digits;
+	uint32_t len;
+	uint32_t seq;
+	uint8_t lrn;
+};
+typedef struct lcr_deck_row lcr_deck_row_t;
+
+struct lcr_deck_builder {
+	lcr_deck_t *deck;
+	switch_hash_t *intern;
+	lcr_deck_row_t *rows;
+	uint32_t row_count;
+	uint32_t row_alloc;
+	/* column_count string indexes per row, in load order */
+	uint32_t *values;
+	uint32_t string_alloc;
+	uint32_t node_alloc;
+	size_t labels_alloc;
+	int digits_col;
+	int lrn_col;
+	uint32_t skipped;
+	switch_bool_t failed;
+};
+typedef struct lcr_deck_builder lcr_deck_builder_t;
+
+/* a trie node matched by a lookup, mask 1 is the dialed digits, 2 the lrn */
+struct lcr_deck_match {
+	uint32_t node;
+	const char *digits;
+	size_t len;
+	int mask;
+};
+typedef struct lcr_deck_match lcr_deck_match_t;
+
+static void lcr_deck_destroy(lcr_deck_t **deckp)
+{
+	lcr_deck_t *deck = *deckp;
+	switch_memory_pool_t *pool;
+
+	if (!deck) {
+		return;
+	}
+	*deckp = NULL;
+
+	switch_safe_free(deck->strings);
+	switch_safe_free(deck->nodes);
+	switch_safe_free(deck->labels);
+	switch_safe_free(deck->values);
+	switch_safe_free(deck->lrn);
+	switch_safe_free(deck->times);
+
+	/* the deck itself lives in its pool */
+	pool = deck->pool;
+	switch_core_destroy_memory_pool(&pool);
+}
+
+static void lcr_deck_builder_init(lcr_deck_builder_t *b)
+{
+	switch_memory_pool_t *pool = NULL;
+
+	memset(b, 0, sizeof(*b));
+	switch_core_new_memory_pool(&pool);
+	b->deck = switch_core_alloc(pool, sizeof(lcr_deck_t));
+	b->deck->pool = pool;
+	b->deck->date_start_col = -1;
+	b->deck->date_end_col = -1;
+	b->digits_col = -1;
+	b->lrn_col = -1;
+	switch_core_hash_init(&b->intern);
+
+	/* string 0 is NULL */
+	b->string_alloc = 1024;
+	switch_malloc(b->deck->strings, sizeof(char *) * b->string_alloc);
+	b->deck->strings[0] = NULL;
+	b->deck->string_count = 1;
+}
+
+static void lcr_deck_builder_destroy(lcr_deck_builder_t *b)
+{
+	uint32_t i;
+
+	for (i = 0; i < b->row_count; i++) {
+		switch_safe_free(b->rows[i].digits);
+	}
+	switch_safe_free(b->rows);
+	switch_safe_free(b->values);
+	if (b->intern) {
+		switch_core_hash_destroy(&b->intern);
+	}
+	lcr_deck_destroy(&b->deck);
+}
+
+static lcr_deck_col_t lcr_deck_col_role(const char *name)
+{
+	if (!strcasecmp(name, "lcr_digits")) {
+		return LCR_DECK_COL_DIGITS;
+	} else if (!strcasecmp(name, "lcr_lrn")) {
+		return LCR_DECK_COL_LRN;
+	} else if (!strcasecmp(name, "lcr_rate") || !strcasecmp(name, "lcr_rate_field")) {
+		return LCR_DECK_COL_RATE;
+	} else if (!strcasecmp(name, "lcr_intrastate_rate")) {
+		return LCR_DECK_COL_INTRASTATE_RATE;
+	} else if (!strcasecmp(name, "lcr_intralata_rate")) {
+		return LCR_DECK_COL_INTRALATA_RATE;
+	} else if (!strcasecmp(name, "lcr_user_rate")) {
+		return LCR_DECK_COL_USER_RATE;
+	} else if (!strcasecmp(name, "lcr_user_intrastate_rate")) {
+		return LCR_DECK_COL_USER_INTRASTATE_RATE;
+	} else if (!strcasecmp(name, "lcr_user_intralata_rate")) {
+		return LCR_DECK_COL_USER_INTRALATA_RATE;
+	} else if (!strcasecmp(name, "lcr_date_start")) {
+		return LCR_DECK_COL_DATE_START;
+	} else if (!strcasecmp(name, "lcr_date_end")) {
+		return LCR_DECK_COL_DATE_END;
+	} else if (!strcasecmp(name, "lcr_now")) {
+		return LCR_DECK_COL_NOW;
+	} else if (!strncasecmp(name, "lcr_order_", 10)) {
+		return LCR_DECK_COL_ORDER;
+	}
+	return LCR_DECK_COL_FIELD;
+}
+
+static switch_status_t lcr_deck_builder_columns(lcr_deck_builder_t *b, int argc, char **columnNames)
+{
+	lcr_deck_t *deck = b->deck;
+	int i;
+
+	deck->column_count = argc;
+	deck->columns = switch_core_alloc(deck->pool, sizeof(char *) * argc);
+	deck->roles = switch_core_alloc(deck->pool, sizeof(lcr_deck_col_t) * argc);
+
+	for (i = 0; i < argc; i++) {
+		deck->columns[i] = switch_core_strdup(deck->pool, columnNames[i]);
+		deck->roles[i] = lcr_deck_col_role(columnNames[i]);
+		if (deck->roles[i] == LCR_DECK_COL_DIGITS) {
+			b->digits_col = i;
+		} else if (deck->roles[i] == LCR_DECK_COL_LRN) {
+			b->lrn_col = i;
+		} else if (deck->roles[i] == LCR_DECK_COL_DATE_START) {
+			deck->date_start_col = i;
+		} else if (deck->roles[i] == LCR_DECK_COL_DATE_END) {
+			deck->date_end_col = i;
+		}
+	}
+
+	if (b->digits_col < 0) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "rate deck has no lcr_digits column\n");
+		return SWITCH_STATUS_FALSE;
+	}
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+static uint32_t lcr_deck_intern(lcr_deck_builder_t *b, const char *str)
+{
+	lcr_deck_t *deck = b->deck;
+	void *val;
+	uint32_t idx;
+
+	if (!str) {
+		return 0;
+	}
+
+	if ((val = switch_core_hash_find(b->intern, str))) {
+		return (uint32_t) (intptr_t) val;
+	}
+
+	if (deck->string_count == b->string_alloc) {
+		b->string_alloc *= 2;
+		deck->strings = realloc(deck->strings, sizeof(char *) * b->string_alloc);
+		switch_assert(deck->strings);
+	}
+
+	idx = deck->string_count++;
+	deck->strings[idx] = switch_core_strdup(deck->pool, str);
+	switch_core_hash_insert(b->intern, deck->strings[idx], (void *) (intptr_t) idx);
+
+	return idx;
+}
+
+static void lcr_deck_builder_add(lcr_deck_builder_t *b, int argc, char **argv)
+{
+	lcr_deck_t *deck = b->deck;
+	lcr_deck_row_t *row;
+	uint32_t *values;
+	char digits[LCR_DECK_MAX_DIGITS + 1];
+	const char *p;
+	size_t len = 0;
+	int i;
+
+	if (argc != deck->column_count || !argv[b->digits_col]) {
+		b->skipped++;
+		return;
+	}
+
+	for (p = argv[b->digits_col]; *p; p++) {
+		if (switch_isdigit(*p)) {
+			if (len == LCR_DECK_MAX_DIGITS) {
+				break;
+			}
+			digits[len++] = *p;
+		}
+	}
+	digits[len] = '\0';
+
+	if (!len || *p) {
+		b->skipped++;
+		return;
+	}
+
+	if (b->row_count == b->row_alloc) {
+		b->row_alloc = b->row_alloc ? b->row_alloc * 2 : 4096;
+		b->rows = realloc(b->rows, sizeof(lcr_deck_row_t) * b->row_alloc);
+		b->values = realloc(b->values, sizeof(uint32_t) * deck->column_count * b->row_alloc);
+		switch_assert(b->rows && b->values);
+	}
+
+	row = &b->rows[b->row_count];
+	row->digits = strdup(digits);
+	row->len = (uint32_t) len;
+	row->seq = b->row_count;
+	row->lrn = (b->lrn_col >= 0 && switch_true(argv[b->lrn_col])) ? 1 : 0;
+
+	values = &b->values[(size_t) b->row_count * deck->column_count];
+	for (i = 0; i < argc; i++) {
+		/* the digits come from the matched prefix at lookup time */
+		values[i] = (i == b->digits_col || i == b->lrn_col) ? 0 : lcr_deck_intern(b, argv[i]);
+	}
+
+	b->row_count++;
+}
+
+static int lcr_deck_sql_callback(void *pArg, int argc, char **argv, char **columnNames)
+{
+	lcr_deck_builder_t *b = (lcr_deck_builder_t *) pArg;
+
+	if (!b->deck->column_count && lcr_deck_builder_columns(b, argc, columnNames) != SWITCH_STATUS_SUCCESS) {
+		b->failed = SWITCH_TRUE;
+		return -1;
+	}
+
+	lcr_deck_builder_add(b, argc, argv);
+
+	return 0;
+}
+
+static switch_status_t lcr_deck_read_csv(lcr_deck_builder_t *b, const char *path)
+{
+	FILE *f;
+	char line[8192];
+	char *argv[128];
+	int argc;
+
+	if (!(f = fopen(path, "r"))) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Cannot open rate deck %s\n", path);
+		return SWITCH_STATUS_FALSE;
+	}
+
+	while (fgets(line, sizeof(line), f)) {
+		char *e = line + strlen(line);
+
+		while (e > line && (e[-1] == '\n' || e[-1] == '\r')) {
+			*--e = '\0';
+		}
+		if (!*line || *line == '#') {
+			continue;
+		}
+
+		argc = switch_separate_string(line, ',', argv, (sizeof(argv) / sizeof(argv[0])));
+
+		if (!b->deck->column_count) {
+			/* the first line names the columns */
+			if (lcr_deck_builder_columns(b, argc, argv) != SWITCH_STATUS_SUCCESS) {
+				fclose(f);
+				return SWITCH_STATUS_FALSE;
+			}
+			continue;
+		}
+
+		lcr_deck_builder_add(b, argc, argv);
+	}
+
+	fclose(f);
+	return SWITCH_STATUS_SUCCESS;
+}
+
+static int lcr_deck_row_cmp(const void *a, const void *b)
+{
+	const lcr_deck_row_t *ra = (const lcr_deck_row_t *) a;
+	const lcr_deck_row_t *rb = (const lcr_deck_row_t *) b;
+	int r = strcmp(ra->digits, rb->digits);
+
+	/* keep load order within a prefix, it carries the profile's order_by */
+	if (!r) {
+		r = ra->seq < rb->seq ? -1 : ra->seq > rb->seq;
+	}
+
+	return r;
+}
+
+static uint32_t lcr_deck_node_alloc(lcr_deck_builder_t *b, uint32_t count)
+{
+	lcr_deck_t *deck = b->deck;
+	uint32_t first = deck->node_count;
+
+	while (deck->node_count + count > b->node_alloc) {
+		b->node_alloc = b->node_alloc ? b->node_alloc * 2 : 4096;
+		deck->nodes = realloc(deck->nodes, sizeof(lcr_trie_node_t) * b->node_alloc);
+		switch_assert(deck->nodes);
+	}
+
+	memset(&deck->nodes[first], 0, sizeof(lcr_trie_node_t) * count);
+	deck->node_count += count;
+
+	return first;
+}
+
+static uint32_t lcr_deck_label_add(lcr_deck_builder_t *b, const char *digits, size_t len)
+{
+	lcr_deck_t *deck = b->deck;
+	uint32_t offset = (uint32_t) deck->labels_len;
+
+	while (deck->labels_len + len > b->labels_alloc) {
+		b->labels_alloc = b->labels_alloc ? b->labels_alloc * 2 : 65536;
+		deck->labels = realloc(deck->labels, b->labels_alloc);
+		switch_assert(deck->labels);
+	}
+
+	memcpy(deck->labels + deck->labels_len, digits, len);
+	deck->labels_len += len;
+
+	return offset;
+}
+
+/* rows lo..hi are sorted and all start with the depth digits leading to node */
+static void lcr_deck_build_node(lcr_deck_builder_t *b, uint32_t node, uint32_t lo, uint32_t hi, uint32_t depth)
+{
+	lcr_deck_row_t *rows = b->rows;
+	uint32_t start[10], end[10];
+	uint32_t i, first, groups = 0;
+	uint16_t mask = 0;
+
+	/* a row for exactly this prefix sorts first */
+	if (lo < hi && rows[lo].len == depth) {
+		b->deck->nodes[node].route_first = lo;
+		while (lo < hi && rows[lo].len == depth) {
+			lo++;
+		}
+		b->deck->nodes[node].route_count = lo - b->deck->nodes[node].route_first;
+		b->deck->prefix_count++;
+	}
+
+	for (i = lo; i < hi; i++) {
+		if (!groups || rows[i].digits[depth] != rows[start[groups - 1]].digits[depth]) {
+			start[groups] = i;
+			groups++;
+			mask |= (uint16_t) (1 << (rows[i].digits[depth] - '0'));
+		}
+		end[groups - 1] = i + 1;
+	}
+
+	if (!groups) {
+		return;
+	}
+
+	first = lcr_deck_node_alloc(b, groups);
+	b->deck->nodes[node].first_child = first;
+	b->deck->nodes[node].child_mask = mask;
+
+	for (i = 0; i < groups; i++) {
+		const char *lo_digits = rows[start[i]].digits;
+		const char *hi_digits = rows[end[i] - 1].digits;
+		uint32_t len = depth + 1;
+
+		/* the group shares the prefix its first and last rows share */
+		while (len < rows[start[i]].len && lo_digits[len] == hi_digits[len]) {
+			len++;
+		}
+
+		b->deck->nodes[first + i].label = lcr_deck_label_add(b, lo_digits + depth, len - depth);
+		b->deck->nodes[first + i].label_len = (uint16_t) (len - depth);
+		lcr_deck_build_node(b, first + i, start[i], end[i], len);
+	}
+}
+
+/* sort the rows, build the trie and hand the deck over to the caller */
+static lcr_deck_t *lcr_deck_builder_finish(lcr_deck_builder_t *b)
+{
+	lcr_deck_t *deck = b->deck;
+	uint32_t i;
+
+	qsort(b->rows, b->row_count, sizeof(lcr_deck_row_t), lcr_deck_row_cmp);
+
+	deck->route_count = b->row_count;
+	switch_malloc(deck->values, sizeof(uint32_t) * deck->column_count * (deck->route_count ? deck->route_count : 1));
+	switch_malloc(deck->lrn, deck->route_count ? deck->route_count : 1);
+	for (i = 0; i < b->row_count; i++) {
+		memcpy(&deck->values[(size_t) i * deck->column_count], &b->values[(size_t) b->rows[i].seq * deck->column_count],
+			   sizeof(uint32_t) * deck->column_count);
+		deck->lrn[i] = b->rows[i].lrn;
+	}
+
+	if (deck->date_start_col >= 0 || deck->date_end_col >= 0) {
+		uint8_t *parsed;
+		int cols[2] = { deck->date_start_col, deck->date_end_col };
+		int c;
+
+		switch_zmalloc(deck->times, sizeof(switch_time_t) * deck->string_count);
+		switch_zmalloc(parsed, deck->string_count);
+		for (i = 0; i < deck->route_count; i++) {
+			for (c = 0; c < 2; c++) {
+				uint32_t idx;
+
+				if (cols[c] < 0 || !(idx = deck->values[(size_t) i * deck->column_count + cols[c]]) || parsed[idx]) {
+					continue;
+				}
+				parsed[idx] = 1;
+				deck->times[idx] = switch_str_time(deck->strings[idx]);
+			}
+		}
+		free(parsed);
+	}
+
+	lcr_deck_node_alloc(b, 1);
+	lcr_deck_build_node(b, 0, 0, b->row_count, 0);
+
+	b->deck = NULL;
+	return deck;
+}
+
+/* map the profile's order_by onto the deck's lcr_order_<n> columns, see lcr_deck_default_sql() */
+static void lcr_deck_set_order(lcr_deck_t *deck, const char *order_by)
+{
+	char *dup, *argv[32];
+	int argc, i, c;
+
+	if (zstr(order_by)) {
+		return;
+	}
+
+	dup = switch_core_strdup(deck->pool, order_by);
+	argc = switch_separate_string(dup, ',', argv, (sizeof(argv) / sizeof(argv[0])));
+	deck->order = switch_core_alloc(deck->pool, sizeof(lcr_deck_order_t) * argc);
+
+	for (i = 0; i < argc; i++) {
+		char *term = argv[i];
+		size_t len;
+		int col = -1;
+
+		while (*term == ' ') {
+			term++;
+		}
+		if (!*term) {
+			continue;
+		}
+
+		if (!strstr(term, "${lcr_rate_field}")) {
+			char name[32];
+
+			/* a deck without the column was not loaded in that order */
+			switch_snprintf(name, sizeof(name), "lcr_order_%d", i);
+			for (c = 0; c < deck->column_count; c++) {
+				if (!strcasecmp(deck->columns[c], name)) {
+					col = c;
+					break;
+				}
+			}
+			if (col < 0) {
+				continue;
+			}
+		}
+
+		len = strlen(term);
+		while (len && term[len - 1] == ' ') {
+			len--;
+		}
+		deck->order[deck->order_count].col = col;
+		deck->order[deck->order_count].desc = (len > 5 && !strncasecmp(term + len - 5, " DESC", 5));
+		deck->order_count++;
+	}
+}
+
+static uint32_t lcr_popcount16(uint16_t v)
+{
+	uint32_t c = 0;
+
+	for (; v; c++) {
+		v &= v - 1;
+	}
+
+	return c;
+}
+
+/* collect the nodes with routes along the path of digits */
+static int lcr_deck_walk(lcr_deck_t *deck, const char *digits, int mask, lcr_deck_match_t *matches, int max, int count)
+{
+	uint32_t idx = 0;
+	size_t depth = 0;
+
+	while (deck->node_count) {
+		lcr_trie_node_t *node = &deck->nodes[idx];
+		lcr_trie_node_t *child;
+		uint16_t bit;
+
+		if (node->route_count && count < max) {
+			matches[count].node = idx;
+			matches[count].digits = digits;
+			matches[count].len = depth;
+			matches[count].mask = mask;
+			count++;
+		}
+
+		if (!switch_isdigit(digits[depth])) {
+			break;
+		}
+
+		bit = (uint16_t) (1 << (digits[depth] - '0'));
+		if (!(node->child_mask & bit)) {
+			break;
+		}
+
+		idx = node->first_child + lcr_popcount16(node->child_mask & (bit - 1));
+		child = &deck->nodes[idx];
+		if (strncmp(digits + depth, deck->labels + child->label, child->label_len)) {
+			break;
+		}
+		depth += child->label_len;
+	}
+
+	return count;
+}
+
+/* longest digits first, like ORDER BY digits DESC */
+static int lcr_deck_match_cmp(const void *a, const void *b)
+{
+	const lcr_deck_match_t *ma = (const lcr_deck_match_t *) a;
+	const lcr_deck_match_t *mb = (const lcr_deck_match_t *) b;
+	int r = memcmp(ma->digits, mb->digits, ma->len < mb->len ? ma->len : mb->len);
+
+	if (!r) {
+		r = ma->len < mb->len ? -1 : ma->len > mb->len;
+	}
+
+	return -r;
+}
+
+static lcr_deck_col_t lcr_deck_rate_role(lcr_deck_t *deck, const char *rate_field, switch_bool_t user)
+{
+	lcr_deck_col_t role = user ? LCR_DECK_COL_USER_RATE : LCR_DECK_COL_RATE;
+	int i;
+
+	if (!strcmp(rate_field, "intralata_rate")) {
+		role = user ? LCR_DECK_COL_USER_INTRALATA_RATE : LCR_DECK_COL_INTRALATA_RATE;
+	} else if (!strcmp(rate_field, "intrastate_rate")) {
+		role = user ? LCR_DECK_COL_USER_INTRASTATE_RATE : LCR_DECK_COL_INTRASTATE_RATE;
+	}
+
+	for (i = 0; i < deck->column_count; i++) {
+		if (deck->roles[i] == role) {
+			return role;
+		}
+	}
+
+	/* deck has no separate column for this rate */
+	return user ? LCR_DECK_COL_USER_RATE : LCR_DECK_COL_RATE;
+}
+
+/* compare two column values the way the database would, numbers as numbers and NULL first */
+static int lcr_deck_value_cmp(const char *a, const char *b)
+{
+	char *ea, *eb;
+	double da, db;
+
+	if (!a || !b) {
+		return a ? 1 : (b ? -1 : 0);
+	}
+
+	da = strtod(a, &ea);
+	db = strtod(b, &eb);
+	if (ea != a && !*ea && eb != b && !*eb) {
+		return da < db ? -1 : da > db;
+	}
+
+	return strcmp(a, b);
+}
+
+static int lcr_deck_route_cmp(lcr_deck_t *deck, uint32_t a, uint32_t b, int rate_col)
+{
+	uint32_t *va = &deck->values[(size_t) a * deck->column_count];
+	uint32_t *vb = &deck->values[(size_t) b * deck->column_count];
+	int i, r;
+
+	for (i = 0; i < deck->order_count; i++) {
+		int col = deck->order[i].col >= 0 ? deck->order[i].col : rate_col;
+
+		if (col < 0) {
+			continue;
+		}
+		if ((r = lcr_deck_value_cmp(deck->strings[va[col]], deck->strings[vb[col]]))) {
+			return deck->order[i].desc ? -r : r;
+		}
+	}
+
+	return 0;
+}
+
+/* the SQL ends its ORDER BY with the database's random function, shuffle the runs of
+   routes that tie on every order_by key so they come back in a different order per call */
+static void lcr_deck_shuffle_ties(lcr_deck_t *deck, uint32_t *routes, uint32_t count, int rate_col)
+{
+	uint32_t lo = 0, hi, k, j, t;
+
+	while (lo < count) {
+		for (hi = lo + 1; hi < count && !lcr_deck_route_cmp(deck, routes[lo], routes[hi], rate_col); hi++);
+
+		for (k = hi - 1; k > lo; k--) {
+			j = lo + (uint32_t) (rand() % (k - lo + 1));
+			t = routes[k];
+			routes[k] = routes[j];
+			routes[j] = t;
+		}
+
+		lo = hi;
+	}
+}
+
+/* a route is live if the lookup's time falls between its date_start and date_end */
+static switch_bool_t lcr_deck_route_live(lcr_deck_t *deck, uint32_t r, switch_time_t now)
+{
+	uint32_t *values = &deck->values[(size_t) r * deck->column_count];
+	switch_time_t t;
+
+	if (!deck->times) {
+		return SWITCH_TRUE;
+	}
+	if (deck->date_start_col >= 0 && (t = deck->times[values[deck->date_start_col]]) && now < t) {
+		return SWITCH_FALSE;
+	}
+	if (deck->date_end_col >= 0 && (t = deck->times[values[deck->date_end_col]]) && now > t) {
+		return SWITCH_FALSE;
+	}
+
+	return SWITCH_TRUE;
+}
+
+/* feed the deck's routes for the lookup through route_add_callback in the order the SQL would return them */
+static switch_status_t lcr_deck_lookup(callback_t *cb_struct, lcr_deck_t *deck, const char *digits, const char *rate_field)
+{
+	lcr_deck_match_t matches[(LCR_DECK_MAX_DIGITS + 1) * 2];
+	lcr_deck_col_t rate_role = lcr_deck_rate_role(deck, rate_field, SWITCH_FALSE);
+	lcr_deck_col_t user_rate_role = lcr_deck_rate_role(deck, rate_field, SWITCH_TRUE);
+	char **argv = switch_core_alloc(cb_struct->pool, sizeof(char *) * deck->column_count);
+	char **names = switch_core_alloc(cb_struct->pool, sizeof(char *) * deck->column_count);
+	uint32_t *routes = NULL, routes_alloc = 0;
+	switch_time_t now = switch_time_now() + deck->clock_skew;
+	int count, i, rate_col = -1, max = (int) (sizeof(matches) / sizeof(matches[0]));
+
+	for (i = 0; i < deck->column_count; i++) {
+		if (deck->roles[i] == rate_role) {
+			rate_col = i;
+			break;
+		}
+	}
+
+	/* lrn routes match the lrn if there is one, the dialed digits otherwise */
+	count = lcr_deck_walk(deck, digits, 1, matches, max, 0);
+	count = lcr_deck_walk(deck, cb_struct->lrn_number ? cb_struct->lrn_number : digits, 2, matches, max, count);
+	qsort(matches, count, sizeof(lcr_deck_match_t), lcr_deck_match_cmp);
+
+	for (i = 0; i < count; i++) {
+		lcr_trie_node_t *node = &deck->nodes[matches[i].node];
+		int mask = matches[i].mask;
+		char *prefix;
+		uint32_t r, k, live;
+
+		/* the same node matched by both walks */
+		while (i + 1 < count && matches[i + 1].node == matches[i].node) {
+			mask |= matches[++i].mask;
+		}
+
+		prefix = switch_core_strndup(cb_struct->pool, matches[i].digits, matches[i].len);
+
+		if (node->route_count > routes_alloc) {
+			routes_alloc = node->route_count;
+			routes = switch_core_alloc(cb_struct->pool, sizeof(uint32_t) * routes_alloc);
+		}
+
+		for (r = node->route_first, live = 0; r < node->route_first + node->route_count; r++) {
+			if ((mask & (deck->lrn[r] ? 2 : 1)) && lcr_deck_route_live(deck, r, now)) {
+				uint32_t j = live++;
+
+				/* the deck is loaded in plain rate order, other rates need the routes sorted again */
+				while (rate_role != LCR_DECK_COL_RATE && j && lcr_deck_route_cmp(deck, routes[j - 1], r, rate_col) > 0) {
+					routes[j] = routes[j - 1];
+					j--;
+				}
+				routes[j] = r;
+			}
+		}
+
+		/* a deck without a known order has nothing to tell the ties apart by */
+		if (db_random && deck->order_count) {
+			lcr_deck_shuffle_ties(deck, routes, live, rate_col);
+		}
+
+		for (k = 0; k < live; k++) {
+			uint32_t *values = &deck->values[(size_t) routes[k] * deck->column_count];
+			int c, n = 0;
+
+			for (c = 0; c < deck->column_count; c++) {
+				switch (deck->roles[c]) {
+				case LCR_DECK_COL_FIELD:
+					names[n] = deck->columns[c];
+					argv[n++] = deck->strings[values[c]];
+					break;
+				case LCR_DECK_COL_DIGITS:
+					names[n] = "lcr_digits";
+					argv[n++] = prefix;
+					break;
+				case LCR_DECK_COL_LRN:
+				case LCR_DECK_COL_DATE_START:
+				case LCR_DECK_COL_DATE_END:
+				case LCR_DECK_COL_NOW:
+				case LCR_DECK_COL_ORDER:
+					break;
+				default:
+					if (deck->roles[c] == rate_role) {
+						names[n] = "lcr_rate_field";
+						argv[n++] = deck->strings[values[c]];
+					} else if (deck->roles[c] == user_rate_role) {
+						names[n] = "lcr_user_rate";
+						argv[n++] = deck->strings[values[c]];
+					}
+					break;
+				}
+			}
+
+			if (route_add_callback(cb_struct, n, argv, names)) {
+				return SWITCH_STATUS_GENERR;
+			}
+		}
+	}
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+static lcr_deck_t *lcr_deck_acquire(profile_t *profile)
+{
+	lcr_deck_t *deck;
+
+	switch_mutex_lock(globals.mutex);
+	if ((deck = profile->deck)) {
+		deck->refs++;
+	}
+	switch_mutex_unlock(globals.mutex);
+
+	return deck;
+}
+
+static void lcr_deck_release(lcr_deck_t *deck)
+{
+	switch_bool_t destroy;
+
+	switch_mutex_lock(globals.mutex);
+	deck->refs--;
+	destroy = deck->retired && !deck->refs;
+	switch_mutex_unlock(globals.mutex);
+
+	if (destroy) {
+		lcr_deck_destroy(&deck);
+	}
+}
+
+/* publish a new snapshot, the old one goes away with its last lookup */
+static void lcr_deck_swap(profile_t *profile, lcr_deck_t *deck)
+{
+	lcr_deck_t *old;
+	switch_bool_t destroy = SWITCH_FALSE;
+
+	switch_mutex_lock(globals.mutex);
+	if ((old = profile->deck)) {
+		old->retired = SWITCH_TRUE;
+		destroy = !old->refs;
+	}
+	profile->deck = deck;
+	switch_mutex_unlock(globals.mutex);
+
+	if (destroy) {
+		lcr_deck_destroy(&old);
+	}
+}
+
+static size_t lcr_deck_memory(lcr_deck_t *deck)
+{
+	return sizeof(lcr_trie_node_t) * deck->node_count + deck->labels_len +
+		(sizeof(uint32_t) * deck->column_count + 1) * deck->route_count + sizeof(char *) * deck->string_count +
+		(deck->times ? sizeof(switch_time_t) * deck->string_count : 0);
+}
+
+static switch_status_t lcr_deck_load(profile_t *profile)
+{
+	lcr_deck_builder_t b;
+	lcr_deck_t *deck;
+	switch_time_t start = switch_time_now();
+	switch_status_t status;
+	int i;
+
+	lcr_deck_builder_init(&b);
+
+	if (profile->deck_csv) {
+		status = lcr_deck_read_csv(&b, profile->deck_csv);
+	} else {
+		status = lcr_execute_sql_callback(profile->deck_sql, lcr_deck_sql_callback, &b);
+	}
+
+	if (status != SWITCH_STATUS_SUCCESS || b.failed || !b.deck->column_count) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Failed to load rate deck for lcr profile %s, routing from the database\n", profile->name);
+		lcr_deck_builder_destroy(&b);
+		return SWITCH_STATUS_FALSE;
+	}
+
+	deck = lcr_deck_builder_finish(&b);
+	lcr_deck_set_order(deck, profile->order_by);
+	for (i = 0; i < deck->column_count && deck->route_count; i++) {
+		if (deck->roles[i] == LCR_DECK_COL_NOW && deck->strings[deck->values[i]]) {
+			deck->clock_skew = switch_str_time(deck->strings[deck->values[i]]) - start;
+			break;
+		}
+	}
+	if (b.skipped) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "Skipped %u rate deck rows without valid digits for lcr profile %s\n", b.skipped, profile->name);
+	}
+	lcr_deck_builder_destroy(&b);
+
+	deck->load_time = switch_time_now();
+	deck->load_ms = (deck->load_time - start) / 1000;
+	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_INFO, "Loaded rate deck for lcr profile %s: %u routes, %u prefixes, %u nodes, %zu KB in %" SWITCH_INT64_T_FMT " ms\n",
+					  profile->name, deck->route_count, deck->prefix_count, deck->node_count, lcr_deck_memory(deck) / 1024, deck->load_ms);
+
+	lcr_deck_swap(profile, deck);
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+static void *SWITCH_THREAD_FUNC lcr_deck_reload_thread(switch_thread_t *thread, void *obj)
+{
+	profile_t *profile = (profile_t *) obj;
+
+	lcr_deck_load(profile);
+
+	switch_mutex_lock(globals.mutex);
+	profile->deck_loading = SWITCH_FALSE;
+	globals.deck_loads--;
+	switch_mutex_unlock(globals.mutex);
+
+	return NULL;
+}
+
+/* rebuild the deck in the background, calls keep using the current one meanwhile */
+static switch_status_t lcr_deck_reload(profile_t *profile)
+{
+	switch_thread_data_t *td;
+	switch_memory_pool_t *pool = NULL;
+
+	switch_mutex_lock(globals.mutex);
+	if (globals.deck_shutdown) {
+		switch_mutex_unlock(globals.mutex);
+		return SWITCH_STATUS_FALSE;
+	}
+	if (profile->deck_loading) {
+		switch_mutex_unlock(globals.mutex);
+		return SWITCH_STATUS_INUSE;
+	}
+	profile->deck_loading = SWITCH_TRUE;
+	globals.deck_loads++;
+	switch_mutex_unlock(globals.mutex);
+
+	switch_core_new_memory_pool(&pool);
+	td = switch_core_alloc(pool, sizeof(*td));
+	td->func = lcr_deck_reload_thread;
+	td->obj = profile;
+	td->pool = pool;
+	switch_thread_pool_launch_thread(&td);
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+static uint32_t lcr_bench_rand(uint32_t *state)
+{
+	uint32_t x = *state;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+
+	return x;
+}
+
+/* build a synthetic deck of random prefixes and time lookups of random numbers against it */
+static void lcr_deck_bench(switch_stream_handle_t *stream, uint32_t prefixes, uint32_t lookups)
+{
+	lcr_deck_builder_t b;
+	lcr_deck_t *deck;
+	lcr_deck_match_t matches[LCR_DECK_MAX_DIGITS + 1];
+	char *columns[3] = { "lcr_digits", "lcr_carrier_name", "lcr_rate_field" };
+	char *carriers[4] = { "carrier_a", "carrier_b", "carrier_c", "carrier_d" };
+	char *argv[3];
+	char digits[16], rate[16];
+	uint32_t state = 2463534242U, i, d;
+	uint64_t matched = 0;
+	switch_time_t start, built, done;
+
+	lcr_deck_builder_init(&b);
+	lcr_deck_builder_columns(&b, 3, columns);
+
+	start = switch_time_now();
+	for (i = 0; i < prefixes; i++) {
+		uint32_t len = 3 + lcr_bench_rand(&state) % 7;
+
+		for (d = 0; d < len; d++) {
+			digits[d] = (char) ('0' + lcr_bench_rand(&state) % 10);
+		}
+		digits[len] = '\0';
+		switch_snprintf(rate, sizeof(rate), "0.%04u", lcr_bench_rand(&state) % 10000);
+		argv[0] = digits;
+		argv[1] = carriers[i % 4];
+		argv[2] = rate;
+		lcr_deck_builder_add(&b, 3, argv);
+	}
+	deck = lcr_deck_builder_finish(&b);
+	lcr_deck_builder_destroy(&b);
+	built = switch_time_now();
+
+	digits[11] = '\0';
+	for (i = 0; i < lookups; i++) {
+		for (d = 0; d < 11; d++) {
+			digits[d] = (char) ('0' + lcr_bench_rand(&state) % 10);
+		}
+		matched += lcr_deck_walk(deck, digits, 1, matches, LCR_DECK_MAX_DIGITS + 1, 0);
+	}
+	done = switch_time_now();
+
+	stream->write_function(stream, "prefixes:\t%u (%u distinct)\n", prefixes, deck->prefix_count);
+	stream->write_function(stream, "nodes:\t\t%u\n", deck->node_count);
+	stream->write_function(stream, "memory:\t\t%zu KB\n", lcr_deck_memory(deck) / 1024);
+	stream->write_function(stream, "build:\t\t%" SWITCH_INT64_T_FMT " ms\n", (int64_t) (built - start) / 1000);
+	stream->write_function(stream, "lookups:\t%u in %" SWITCH_INT64_T_FMT " ms, %.0f/s, %.2f prefixes matched per lookup\n",
+						   lookups, (int64_t) (done - built) / 1000, done > built ? lookups * 1000000.0 / (double) (done - built) : 0.0,
+						   lookups ? (double) matched / lookups : 0.0);
+
+	lcr_deck_destroy(&deck);
+}
+
 static int intrastatelata_callback(void *pArg, int argc, char **argv, char **columnNames)
 {
 	int count = 0;
@@ -906,6 +1947,7 @@ static switch_status_t lcr_do_lookup(callback_t *cb_struct)
 	char *safe_sql = NULL;
 	char *rate_field = NULL;
 	char *user_rate_field = NULL;
+	lcr_deck_t *deck = NULL;
 
 	switch_assert(cb_struct->lookup_number != NULL);
 
@@ -980,6 +2022,14 @@ static switch_status_t lcr_do_lookup(callback_t *cb_struct)
 		}
 	}
 
+	/* route from the profile's in-memory rate deck once it is loaded */
+	if (profile->in_memory && (deck = lcr_deck_acquire(profile))) {
+		lookup_status = lcr_deck_lookup(cb_struct, deck, digits_copy, rate_field);
+		lcr_deck_release(deck);
+		switch_core_hash_destroy(&cb_struct->dedup_hash);
+		return lookup_status;
+	}
+
 	/* set up the query to be executed */
 	/* format the custom_sql */
 	safe_sql = format_custom_sql(profile->custom_sql, cb_struct, digits_copy);
@@ -1005,6 +2055,73 @@ static switch_status_t lcr_do_lookup(callback_t *cb_struct)
 	return lookup_status;
 }
 
+/* the default SQL without the digits filter, so it returns the whole deck in route order */
+static char *lcr_deck_default_sql(profile_t *profile)
+{
+	switch_stream_handle_t sql_stream = { 0 };
+	char *order_by;
+	char *sql;
+	char *dup, *argv[32];
+	int argc, i;
+
+	SWITCH_STANDARD_STREAM(sql_stream);
+	sql_stream.write_function(&sql_stream, "SELECT l.digits AS lcr_digits, c.carrier_name AS lcr_carrier_name, l.rate AS lcr_rate, ");
+	if (profile->profile_has_intrastate) {
+		sql_stream.write_function(&sql_stream, "l.intrastate_rate AS lcr_intrastate_rate, ");
+	}
+	if (profile->profile_has_intralata) {
+		sql_stream.write_function(&sql_stream, "l.intralata_rate AS lcr_intralata_rate, ");
+	}
+	/* the order_by keys other than the rate, so lookups can sort by another rate the same way */
+	dup = strdup(profile->order_by);
+	argc = switch_separate_string(dup, ',', argv, (sizeof(argv) / sizeof(argv[0])));
+	for (i = 0; i < argc; i++) {
+		char *term = argv[i];
+		size_t len;
+
+		while (*term == ' ') {
+			term++;
+		}
+		len = strlen(term);
+		while (len && term[len - 1] == ' ') {
+			len--;
+		}
+		if (len > 5 && !strncasecmp(term + len - 5, " DESC", 5)) {
+			len -= 5;
+		} else if (len > 4 && !strncasecmp(term + len - 4, " ASC", 4)) {
+			len -= 4;
+		}
+		if (len && !strstr(term, "${lcr_rate_field}")) {
+			sql_stream.write_function(&sql_stream, "%.*s AS lcr_order_%d, ", (int) len, term, i);
+		}
+	}
+	switch_safe_free(dup);
+	sql_stream.write_function(&sql_stream, "cg.prefix AS lcr_gw_prefix, cg.suffix AS lcr_gw_suffix, l.lead_strip AS lcr_lead_strip, "
+							  "l.trail_strip AS lcr_trail_strip, l.prefix AS lcr_prefix, l.suffix AS lcr_suffix, "
+							  "cg.codec AS lcr_codec, l.cid AS lcr_cid, l.lrn AS lcr_lrn, "
+							  "l.date_start AS lcr_date_start, l.date_end AS lcr_date_end, CURRENT_TIMESTAMP AS lcr_now ");
+	/* routes that start later are kept, lookups check the dates */
+	sql_stream.write_function(&sql_stream, "FROM lcr l JOIN carriers c ON l.carrier_id=c.id JOIN carrier_gateway cg ON c.id=cg.carrier_id "
+							  "WHERE c.enabled = '1' AND cg.enabled = '1' AND l.enabled = '1' AND date_end >= CURRENT_TIMESTAMP ");
+	if (profile->id > 0) {
+		sql_stream.write_function(&sql_stream, "AND lcr_profile=%d ", profile->id);
+	}
+
+	/* the rate field is picked per call, order the deck by the plain rate */
+	order_by = switch_string_replace(profile->order_by, "${lcr_rate_field}", "rate");
+	sql_stream.write_function(&sql_stream, "ORDER BY digits DESC%s", order_by);
+	switch_safe_free(order_by);
+	if (db_random) {
+		sql_stream.write_function(&sql_stream, ", %s", db_random);
+	}
+	sql_stream.write_function(&sql_stream, ";");
+
+	sql = switch_core_strdup(globals.pool, (char *)sql_stream.data);
+	switch_safe_free(sql_stream.data);
+
+	return sql;
+}
+
 static switch_bool_t test_profile(char *lcr_profile)
 {
 	callback_t routes = { 0 };
@@ -1094,6 +2211,10 @@ static switch_status_t lcr_load_config()
 			char *custom_sql = NULL;
 			char *export_fields = NULL;
 			char *limit_type = NULL;
+			char *in_memory = NULL;
+			char *deck_sql = NULL;
+			char *deck_csv = NULL;
+			switch_bool_t default_sql = SWITCH_FALSE;
 			int argc, x = 0;
 			char *argv[32] = { 0 };
 
@@ -1153,6 +2274,12 @@ static switch_status_t lcr_load_config()
 					limit_type = val;
 				} else if (!strcasecmp(var, "enable_sip_redir") && !zstr(val)) {
 					enable_sip_redir = val;
+				} else if (!strcasecmp(var, "in_memory") && !zstr(val)) {
+					in_memory = val;
+				} else if (!strcasecmp(var, "deck_sql") && !zstr(val)) {
+					deck_sql = val;
+				} else if (!strcasecmp(var, "deck_csv") && !zstr(val)) {
+					deck_csv = val;
 				}
 			}
 
@@ -1178,6 +2305,7 @@ static switch_status_t lcr_load_config()
 				SWITCH_STANDARD_STREAM(sql_stream);
 				if (zstr(custom_sql)) {
 					/* use default sql */
+					default_sql = SWITCH_TRUE;
 
 					/* Checking for codec field, adding if needed */
 					if (db_check("SELECT codec FROM carrier_gateway LIMIT 1") == SWITCH_TRUE) {
@@ -1313,6 +2441,23 @@ static switch_status_t lcr_load_config()
 					profile->limit_type = "db";
 				}
 
+				if (!zstr(in_memory) && switch_true(in_memory)) {
+					if (!zstr(deck_csv)) {
+						profile->deck_csv = switch_core_strdup(globals.pool, deck_csv);
+					} else if (!zstr(deck_sql)) {
+						profile->deck_sql = switch_core_strdup(globals.pool, deck_sql);
+					} else if (default_sql) {
+						profile->deck_sql = lcr_deck_default_sql(profile);
+					}
+
+					if (profile->deck_csv || profile->deck_sql) {
+						profile->in_memory = SWITCH_TRUE;
+					} else {
+						switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING,
+										  "lcr profile %s uses custom_sql, set deck_sql or deck_csv to route it in memory\n", profile->name);
+					}
+				}
+
 				switch_core_hash_insert(globals.profile_hash, profile->name, profile);
 				switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_INFO, "Loaded lcr profile %s.\n", profile->name);
 				/* test the profile */
@@ -1330,6 +2475,11 @@ static switch_status_t lcr_load_config()
 				} else {
 					switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "Removing INVALID Profile %s.\n", profile->name);
 					switch_core_hash_delete(globals.profile_hash, profile->name);
+					profile->in_memory = SWITCH_FALSE;
+				}
+
+				if (profile->in_memory) {
+					lcr_deck_load(profile);
 				}
 
 			}
@@ -2062,8 +3212,35 @@ SWITCH_STANDARD_API(dialplan_lcr_admin_function)
 				stream->write_function(stream, " Sip Redirection Mode:\t%s\n", profile->enable_sip_redir ? "enabled" : "disabled");
 				stream->write_function(stream, " Import fields:\t%s\n", profile->export_fields_str ? profile->export_fields_str : "(null)");
 				stream->write_function(stream, " Limit type:\t%s\n", profile->limit_type);
+				if (profile->in_memory) {
+					lcr_deck_t *deck = lcr_deck_acquire(profile);
+					stream->write_function(stream, " In memory:\t%s\n", profile->deck_csv ? profile->deck_csv : "deck_sql");
+					if (deck) {
+						stream->write_function(stream, " Deck:\t\t%u routes, %u prefixes, %u nodes, %zu KB, loaded in %" SWITCH_INT64_T_FMT " ms\n",
+											   deck->route_count, deck->prefix_count, deck->node_count, lcr_deck_memory(deck) / 1024, deck->load_ms);
+						lcr_deck_release(deck);
+					} else {
+						stream->write_function(stream, " Deck:\t\tnot loaded, routing from the database\n");
+					}
+				}
 				stream->write_function(stream, "\n");
 			}
+		} else if (!strcasecmp(argv[0], "deck") && !strcasecmp(argv[1], "reload") && argc > 2) {
+			if (!(profile = locate_profile(argv[2])) || !profile->in_memory) {
+				stream->write_function(stream, "-ERR %s is not an in_memory lcr profile\n", argv[2]);
+			} else if (lcr_deck_reload(profile) != SWITCH_STATUS_SUCCESS) {
+				stream->write_function(stream, "-ERR rate deck for %s is already loading\n", profile->name);
+			} else {
+				stream->write_function(stream, "+OK reloading rate deck for %s\n", profile->name);
+			}
+		} else if (!strcasecmp(argv[0], "deck") && !strcasecmp(argv[1], "bench") && argc > 2) {
+			int prefixes = atoi(argv[2]);
+			int lookups = argc > 3 ? atoi(argv[3]) : 1000000;
+
+			if (prefixes <= 0 || lookups <= 0) {
+				goto usage;
+			}
+			lcr_deck_bench(stream, (uint32_t) prefixes, (uint32_t) lookups);
 		} else {
 			goto usage;
 		}
@@ -2087,6 +3264,7 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_lcr_load)
 	*module_interface = switch_loadable_module_create_module_interface(pool, modname);
 
 	globals.pool = pool;
+	globals.deck_shutdown = SWITCH_FALSE;
 
 	if (switch_mutex_init(&globals.mutex, SWITCH_MUTEX_NESTED, globals.pool) != SWITCH_STATUS_SUCCESS) {
 		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "failed to initialize mutex\n");
@@ -2112,6 +3290,23 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_lcr_load)
 
 SWITCH_MODULE_SHUTDOWN_FUNCTION(mod_lcr_shutdown)
 {
+	switch_hash_index_t *hi;
+	void *val;
+
+	/* reload threads use the profiles */
+	switch_mutex_lock(globals.mutex);
+	globals.deck_shutdown = SWITCH_TRUE;
+	while (globals.deck_loads) {
+		switch_mutex_unlock(globals.mutex);
+		switch_yield(100000);
+		switch_mutex_lock(globals.mutex);
+	}
+	switch_mutex_unlock(globals.mutex);
+
+	for (hi = switch_core_hash_first(globals.profile_hash); hi; hi = switch_core_hash_next(&hi)) {
+		switch_core_hash_this(hi, NULL, NULL, &val);
+		lcr_deck_swap((profile_t *) val, NULL);
+	}
 
 	switch_core_hash_destroy(&globals.profile_hash);
 
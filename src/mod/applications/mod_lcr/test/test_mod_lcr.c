@@ -0,0 +1,194 @@
+/*
+ * FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ * Copyright (C) 2005-2018, Anthony Minessale II <anthm@freeswitch.org>
+ *
+ * Version: MPL 1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ *
+ * The Initial Developer of the Original Code is
+ * Anthony Minessale II <anthm@freeswitch.org>
+ * Portions created by the Initial Developer are Copyright (C)
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *
+ * test_mod_lcr -- in-memory rate deck tests
+ *
+ */
+
+#include <test/switch_test.h>
+
+/* seconds until the expiring route's date_end */
+#define EXPIRES_IN 5
+
+/* sqlite's CURRENT_TIMESTAMP is UTC */
+static void utc_str(char *buf, switch_size_t len, int offset)
+{
+	switch_time_exp_t tm;
+	switch_size_t retsize;
+
+	switch_time_exp_gmt(&tm, switch_micro_time_now() + (switch_time_t) offset * 1000000);
+	switch_strftime_nocheck(buf, &retsize, len, "%Y-%m-%d %H:%M:%S", &tm);
+}
+
+static switch_status_t create_rate_deck(void)
+{
+	switch_cache_db_handle_t *dbh = NULL;
+	char expires[32], tomorrow[32];
+	char *sql;
+	switch_status_t status = SWITCH_STATUS_SUCCESS;
+
+	if (switch_cache_db_get_db_handle_dsn(&dbh, "sqlite://lcr_test") != SWITCH_STATUS_SUCCESS) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	utc_str(expires, sizeof(expires), EXPIRES_IN);
+	utc_str(tomorrow, sizeof(tomorrow), 86400);
+
+	sql = switch_mprintf("DROP TABLE IF EXISTS lcr;"
+						 "DROP TABLE IF EXISTS carriers;"
+						 "DROP TABLE IF EXISTS carrier_gateway;"
+						 "CREATE TABLE carriers (id INTEGER PRIMARY KEY, carrier_name VARCHAR(255), enabled BOOLEAN NOT NULL DEFAULT 1);"
+						 "CREATE TABLE carrier_gateway (id INTEGER PRIMARY KEY, carrier_id INTEGER, prefix VARCHAR(128), suffix VARCHAR(128), "
+						 "codec VARCHAR(255), enabled BOOLEAN NOT NULL DEFAULT 1);"
+						 "CREATE TABLE lcr (id INTEGER PRIMARY KEY, digits VARCHAR(15), rate NUMERIC(11,5), intrastate_rate NUMERIC(11,5), "
+						 "intralata_rate NUMERIC(11,5), carrier_id INTEGER, lead_strip INTEGER DEFAULT 0, trail_strip INTEGER DEFAULT 0, "
+						 "prefix VARCHAR(16) DEFAULT '', suffix VARCHAR(16) DEFAULT '', lcr_profile INTEGER DEFAULT 0, "
+						 "date_start DATETIME NOT NULL DEFAULT '1970-01-01', date_end DATETIME NOT NULL DEFAULT '2030-12-31', "
+						 "quality NUMERIC(10,6) DEFAULT 0, reliability NUMERIC(10,6) DEFAULT 0, cid VARCHAR(32) DEFAULT '', "
+						 "enabled BOOLEAN NOT NULL DEFAULT 1, lrn BOOLEAN NOT NULL DEFAULT 0);"
+						 "INSERT INTO carriers (id, carrier_name) VALUES (1, 'carrier_a'), (2, 'carrier_b'), (3, 'carrier_c'), (4, 'carrier_d');"
+						 "INSERT INTO carrier_gateway (carrier_id, prefix, suffix, codec) VALUES "
+						 "(1, 'sofia/gateway/a/', '', ''), (2, 'sofia/gateway/b/', '', ''), (3, 'sofia/gateway/c/', '', ''), (4, 'sofia/gateway/d/', '', '');"
+						 "INSERT INTO lcr (digits, rate, intrastate_rate, intralata_rate, carrier_id, date_end) VALUES "
+						 "('1555', 0.01, 0.05, 0.05, 1, '2099-12-31 00:00:00'), "
+						 "('1555', 0.02, 0.03, 0.03, 2, '2099-12-31 00:00:00'), "
+						 "('1555', 0.03, 0.01, 0.01, 3, '%s');"
+						 "INSERT INTO lcr (digits, rate, intrastate_rate, intralata_rate, carrier_id, date_start, date_end) VALUES "
+						 "('1555', 0.001, 0.001, 0.001, 4, '%s', '2099-12-31 00:00:00');",
+						 expires, tomorrow);
+
+	status = switch_cache_db_execute_sql(dbh, sql, NULL);
+	switch_safe_free(sql);
+	switch_cache_db_release_db_handle(&dbh);
+
+	return status;
+}
+
+static char *lcr_api(const char *cmd)
+{
+	switch_stream_handle_t stream = { 0 };
+
+	SWITCH_STANDARD_STREAM(stream);
+	switch_api_execute("lcr", cmd, NULL, &stream);
+
+	return (char *) stream.data;
+}
+
+/* the carriers in the order they appear in the output, "abc" for carrier_a, carrier_b, carrier_c */
+static void carrier_order(const char *out, char *order, size_t len)
+{
+	const char *p = out;
+	size_t n = 0;
+
+	while (out && (p = strstr(p, "carrier_")) && n + 1 < len) {
+		order[n++] = p[8];
+		p += 8;
+	}
+	order[n] = '\0';
+}
+
+FST_CORE_BEGIN("./conf")
+{
+	/* mod_lcr loads its decks as it loads, the tables have to be there first */
+	create_rate_deck();
+
+	FST_MODULE_BEGIN(mod_lcr, mod_lcr_test)
+	{
+		FST_SETUP_BEGIN()
+		{
+		}
+		FST_SETUP_END()
+
+		FST_TEARDOWN_BEGIN()
+		{
+		}
+		FST_TEARDOWN_END()
+
+		FST_TEST_BEGIN(deck_matches_sql)
+		{
+			char *sql_out, *mem_out;
+			char order[16];
+
+			/* plain rate, the order the deck was loaded in */
+			sql_out = lcr_api("15551234567 sql");
+			mem_out = lcr_api("15551234567 mem");
+			fst_check_string_equals(mem_out, sql_out);
+			carrier_order(mem_out, order, sizeof(order));
+			fst_check_string_equals(order, "abc");
+			switch_safe_free(sql_out);
+			switch_safe_free(mem_out);
+
+			/* the intrastate rate reverses the order, the deck has to sort each prefix again */
+			sql_out = lcr_api("15551234567 sql intrastate");
+			mem_out = lcr_api("15551234567 mem intrastate");
+			fst_check_string_equals(mem_out, sql_out);
+			carrier_order(mem_out, order, sizeof(order));
+			fst_check_string_equals(order, "cba");
+			switch_safe_free(sql_out);
+			switch_safe_free(mem_out);
+		}
+		FST_TEST_END()
+
+		FST_TEST_BEGIN(deck_checks_dates_per_call)
+		{
+			char *sql_out, *mem_out;
+			char order[16];
+
+			/* carrier_c expires without a reload, carrier_d has not started yet */
+			switch_sleep((EXPIRES_IN + 1) * 1000000);
+
+			sql_out = lcr_api("15551234567 sql");
+			mem_out = lcr_api("15551234567 mem");
+			fst_check_string_equals(mem_out, sql_out);
+			carrier_order(mem_out, order, sizeof(order));
+			fst_check_string_equals(order, "ab");
+			switch_safe_free(sql_out);
+			switch_safe_free(mem_out);
+
+			sql_out = lcr_api("15551234567 sql intrastate");
+			mem_out = lcr_api("15551234567 mem intrastate");
+			fst_check_string_equals(mem_out, sql_out);
+			carrier_order(mem_out, order, sizeof(order));
+			fst_check_string_equals(order, "ba");
+			switch_safe_free(sql_out);
+			switch_safe_free(mem_out);
+		}
+		FST_TEST_END()
+
+		FST_TEST_BEGIN(deck_reload_during_unload)
+		{
+			switch_stream_handle_t stream = { 0 };
+
+			/* the module unload below has to wait for this reload */
+			SWITCH_STANDARD_STREAM(stream);
+			switch_api_execute("lcr_admin", "deck reload mem", NULL, &stream);
+			fst_check_string_equals(stream.data, "+OK reloading rate deck for mem\n");
+			switch_safe_free(stream.data);
+		}
+		FST_TEST_END()
+	}
+	FST_MODULE_END()
+}
+FST_CORE_END()
@@ -6538,6 +6538,34 @@ char *sofia_stir_shaken_as_create_identity_header(switch_core_session_t *session
 }
 
 
+/* wait until every profile thread launched at load is stepping its sip stack or has given up */
+static switch_status_t sofia_wait_for_profiles(void *obj)
+{
+	int sanity = 1000;
+	int32_t starting;
+
+	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "Waiting for profiles to start\n");
+
+	for (;;) {
+		switch_mutex_lock(mod_sofia_globals.mutex);
+		starting = mod_sofia_globals.profiles_starting;
+		switch_mutex_unlock(mod_sofia_globals.mutex);
+
+		if (starting <= 0 || !mod_sofia_globals.running) {
+			break;
+		}
+
+		if (!--sanity) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "%d profile(s) still starting, not waiting any longer\n", starting);
+			break;
+		}
+
+		switch_yield(10000);
+	}
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
 SWITCH_MODULE_LOAD_FUNCTION(mod_sofia_load)
 {
 	switch_chat_interface_t *chat_interface;
@@ -6701,8 +6729,7 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_sofia_load)
 
 	sofia_msg_thread_start(0);
 
-	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "Waiting for profiles to start\n");
-	switch_yield(1500000);
+	switch_loadable_module_defer(modname, "profile start", sofia_wait_for_profiles, NULL);
 
 	if (switch_event_bind(modname, SWITCH_EVENT_CUSTOM, MULTICAST_EVENT, event_handler, NULL) != SWITCH_STATUS_SUCCESS) {
 		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Couldn't bind!\n");
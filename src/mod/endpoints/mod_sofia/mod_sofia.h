@@ -383,6 +383,7 @@ struct mod_sofia_globals {
 	uint32_t callid;
 	int32_t running;
 	int32_t threads;
+	int32_t profiles_starting;
 	int cpu_count;
 	int max_msg_queues;
 	switch_mutex_t *mutex;
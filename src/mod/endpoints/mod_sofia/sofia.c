@@ -3121,6 +3121,17 @@ switch_thread_t *launch_sofia_worker_thread(sofia_profile_t *profile)
 	return thread;
 }
 
+/* the profile is up or gave up, sofia_wait_for_profiles stops counting it */
+static void sofia_profile_thread_started(int *starting)
+{
+	if (*starting) {
+		switch_mutex_lock(mod_sofia_globals.mutex);
+		mod_sofia_globals.profiles_starting--;
+		switch_mutex_unlock(mod_sofia_globals.mutex);
+		*starting = 0;
+	}
+}
+
 void *SWITCH_THREAD_FUNC sofia_profile_thread_run(switch_thread_t *thread, void *obj)
 {
 	sofia_profile_t *profile = (sofia_profile_t *) obj;
@@ -3131,7 +3142,7 @@ void *SWITCH_THREAD_FUNC sofia_profile_thread_run(switch_thread_t *thread, void
 	int use_timer = !sofia_test_pflag(profile, PFLAG_DISABLE_TIMER);
 	int use_rfc_5626 = sofia_test_pflag(profile, PFLAG_ENABLE_RFC5626);
 	const char *supported = NULL;
-	int sanity, attempts = 0;
+	int sanity, attempts = 0, starting = 1;
 	switch_thread_t *worker_thread;
 	switch_status_t st;
 	char qname [128] = "";
@@ -3460,6 +3471,7 @@ void *SWITCH_THREAD_FUNC sofia_profile_thread_run(switch_thread_t *thread, void
 
 	switch_yield(1000000);
 
+	sofia_profile_thread_started(&starting);
 
 	while (mod_sofia_globals.running == 1 && sofia_test_pflag(profile, PFLAG_RUNNING) && sofia_test_pflag(profile, PFLAG_WORKER_RUNNING)) {
 		su_root_step(profile->s_root, 1000);
@@ -3592,6 +3604,7 @@ void *SWITCH_THREAD_FUNC sofia_profile_thread_run(switch_thread_t *thread, void
 		config_sofia(SOFIA_CONFIG_RESPAWN, profile->name);
 	}
 
+	sofia_profile_thread_started(&starting);
 	sofia_profile_destroy(profile);
 
 	switch_mutex_lock(mod_sofia_globals.mutex);
@@ -3620,7 +3633,16 @@ void launch_sofia_profile_thread(sofia_profile_t *profile)
 	switch_threadattr_detach_set(thd_attr, 1);
 	switch_threadattr_stacksize_set(thd_attr, SWITCH_THREAD_STACKSIZE);
 	switch_threadattr_priority_set(thd_attr, SWITCH_PRI_REALTIME);
-	switch_thread_create(&profile->thread, thd_attr, sofia_profile_thread_run, profile, profile->pool);
+
+	switch_mutex_lock(mod_sofia_globals.mutex);
+	mod_sofia_globals.profiles_starting++;
+	switch_mutex_unlock(mod_sofia_globals.mutex);
+
+	if (switch_thread_create(&profile->thread, thd_attr, sofia_profile_thread_run, profile, profile->pool) != SWITCH_STATUS_SUCCESS) {
+		switch_mutex_lock(mod_sofia_globals.mutex);
+		mod_sofia_globals.profiles_starting--;
+		switch_mutex_unlock(mod_sofia_globals.mutex);
+	}
 }
 
 static void logger(void *logarg, char const *fmt, va_list ap)
@@ -61,6 +61,11 @@ SWITCH_MODULE_DEFINITION(mod_verto, mod_verto_load, mod_verto_shutdown, mod_vert
 #define strerror_r(errno, buf, len) strerror_s(buf, len, errno)
 #endif
 
+#ifdef __linux__
+#include <sys/epoll.h>
+#define VERTO_REACTOR 1
+#endif
+
 #define log_and_exit(severity, ...) switch_log_printf(SWITCH_CHANNEL_LOG, (severity), __VA_ARGS__); goto error
 #define die(...) log_and_exit(SWITCH_LOG_WARNING, __VA_ARGS__)
 #define die_errno(fmt) do { char errbuf[BUFSIZ] = {0}; strerror_r(errno, (char *)&errbuf, sizeof(errbuf)); die(fmt ", errno=%d, %s\n", errno, (char *)&errbuf); } while(0)
@@ -74,6 +79,28 @@ static struct {
 	switch_hash_t *store_hash;
 } json_GLOBALS;
 
+#ifdef VERTO_REACTOR
+#define REACTOR_MAX_EVENTS 256
+
+/* with reactor-workers set, idle websockets are parked in an epoll set instead of keeping a thread each */
+static struct {
+	verto_reactor_t reactors[MAX_REACTORS];
+	int reactor_count;
+	switch_thread_t *workers[MAX_REACTOR_WORKERS];
+	int worker_count;
+	switch_queue_t *queue;
+	switch_mutex_t *mutex;
+	uint32_t next;
+	int running;
+} reactor_GLOBALS;
+#endif
+
+static void reactor_schedule(jsock_t *jsock);
+static verto_reactor_t *reactor_next(void);
+static void reactor_add(jsock_t *jsock);
+static void reactor_release(jsock_t *jsock);
+static void client_close(jsock_t *jsock);
+
 
 const char json_sql[] =
 	"create table json_store (\n"
@@ -626,19 +653,100 @@ static switch_ssize_t ws_write_json(jsock_t *jsock, cJSON **json, switch_bool_t
 	return r;
 }
 
-static switch_status_t jsock_queue_event(jsock_t *jsock, cJSON **json, switch_bool_t destroy)
+static verto_event_text_t *verto_event_text_create(cJSON *event, const char *event_channel)
 {
-	switch_status_t status = SWITCH_STATUS_FALSE;
-	cJSON *jp;
+	verto_event_text_t *text;
+	cJSON *channel = cJSON_CreateString(event_channel);
 
-	if (destroy) {
-		jp = *json;
-	} else {
-		jp = cJSON_Duplicate(*json, 1);
+	switch_zmalloc(text, sizeof(*text));
+
+	text->params = cJSON_PrintUnformatted(event);
+	text->params_len = strlen(text->params) - 1;
+	text->empty = text->params_len == 1;
+	text->channel = cJSON_PrintUnformatted(channel);
+	text->channel_len = strlen(text->channel);
+	switch_atomic_set(&text->refs, 1);
+
+	cJSON_Delete(channel);
+
+	return text;
+}
+
+static void verto_event_text_release(verto_event_text_t **textP)
+{
+	verto_event_text_t *text = *textP;
+
+	*textP = NULL;
+
+	if (text && !switch_atomic_dec(&text->refs)) {
+		free(text->params);
+		free(text->channel);
+		free(text);
+	}
+}
+
+/* the same bytes ws_write_json() would send for a verto.event built by write_event(), minus the JSON printing */
+static switch_ssize_t ws_write_event_text(jsock_t *jsock, verto_event_text_t *text, uint32_t id, uint32_t serno)
+{
+	switch_size_t len = 0, size = text->params_len + text->channel_len + 128;
+	switch_ssize_t r = -1;
+	char *buf;
+
+	switch_malloc(buf, size);
+
+	len += switch_snprintf(buf, size, "{\"jsonrpc\":\"2.0\",\"id\":%u,\"method\":\"verto.event\",\"params\":", id);
+	memcpy(buf + len, text->params, text->params_len);
+	len += text->params_len;
+	len += switch_snprintf(buf + len, size - len, "%s\"eventSerno\":%u,\"subscribedChannel\":", text->empty ? "" : ",", serno);
+	memcpy(buf + len, text->channel, text->channel_len);
+	len += text->channel_len;
+	memcpy(buf + len, "}}", 3);
+	len += 2;
+
+	if (jsock->profile->debug || verto_globals.debug) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, verto_globals.debug_level, "WRITE %s [%s]\n", jsock->name, buf);
 	}
 
-	if (switch_queue_trypush(jsock->event_queue, jp) == SWITCH_STATUS_SUCCESS) {
+	switch_mutex_lock(jsock->write_mutex);
+	r = kws_write_frame(jsock->ws, WSOC_TEXT, buf, len);
+	switch_mutex_unlock(jsock->write_mutex);
+
+	free(buf);
+
+	if (r <= 0) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ALERT, "WRITE RETURNED ERROR %" SWITCH_SIZE_T_FMT " \n", r);
+		jsock->drop = 1;
+		jsock->ready = 0;
+	}
+
+	return r;
+}
+
+static void jsock_qmsg_destroy(jsock_qmsg_t **qmP)
+{
+	jsock_qmsg_t *qm = *qmP;
+
+	*qmP = NULL;
+
+	if (qm->json) {
+		cJSON_Delete(qm->json);
+	}
+
+	verto_event_text_release(&qm->text);
+	free(qm);
+}
+
+static switch_status_t jsock_queue_msg(jsock_t *jsock, jsock_qmsg_t **qmP)
+{
+	switch_status_t status = SWITCH_STATUS_FALSE;
+
+	if (switch_queue_trypush(jsock->event_queue, *qmP) == SWITCH_STATUS_SUCCESS) {
 		status = SWITCH_STATUS_SUCCESS;
+		*qmP = NULL;
+
+		if (jsock->reactor) {
+			reactor_schedule(jsock);
+		}
 
 		if (jsock->lost_events) {
 			int le = jsock->lost_events;
@@ -650,17 +758,40 @@ static switch_status_t jsock_queue_event(jsock_t *jsock, cJSON **json, switch_bo
 			jsock->drop++;
 		}
 
-		if (!destroy) {
-			cJSON_Delete(jp);
-			jp = NULL;
-		}
+		jsock_qmsg_destroy(qmP);
 	}
 
+	return status;
+}
+
+static switch_status_t jsock_queue_event(jsock_t *jsock, cJSON **json, switch_bool_t destroy)
+{
+	jsock_qmsg_t *qm;
+
+	switch_zmalloc(qm, sizeof(*qm));
+
 	if (destroy) {
+		qm->json = *json;
 		*json = NULL;
+	} else {
+		qm->json = cJSON_Duplicate(*json, 1);
 	}
 
-	return status;
+	return jsock_queue_msg(jsock, &qm);
+}
+
+static switch_status_t jsock_queue_event_text(jsock_t *jsock, verto_event_text_t *text, uint32_t serno)
+{
+	jsock_qmsg_t *qm;
+
+	switch_zmalloc(qm, sizeof(*qm));
+
+	switch_atomic_inc(&text->refs);
+	qm->text = text;
+	qm->id = next_id();
+	qm->serno = serno;
+
+	return jsock_queue_msg(jsock, &qm);
 }
 
 static switch_bool_t event_channel_check_auth(jsock_t *jsock, const char *event_channel);
@@ -670,10 +801,9 @@ static void write_event(const char *event_channel, const char *super_channel, js
 
 	if ((head = switch_core_hash_find(verto_globals.event_channel_hash, event_channel))) {
 		jsock_sub_node_t *np;
+		verto_event_text_t *text = NULL;
 
 		for(np = head->node; np; np = np->next) {
-			cJSON *msg = NULL, *params;
-			
 			if (!use_jsock || use_jsock == np->jsock) {
 				const char *visibility;
 				//char *tmp;
@@ -704,15 +834,17 @@ static void write_event(const char *event_channel, const char *super_channel, js
 				//tmp = cJSON_Print(event);
 				//printf("%s\n", tmp);
 				//free(tmp);
-				
-				params = cJSON_Duplicate(event, 1);
-				cJSON_AddItemToObject(params, "eventSerno", cJSON_CreateNumber(np->serno++));
-				cJSON_AddItemToObject(params, "subscribedChannel", cJSON_CreateString(head->event_channel));
-				msg = jrpc_new_req("verto.event", NULL, &params);
 
-				jsock_queue_event(np->jsock, &msg, SWITCH_TRUE);
+				/* printed once here and shared by every subscriber, only the id and serno differ per socket */
+				if (!text) {
+					text = verto_event_text_create(event, head->event_channel);
+				}
+
+				jsock_queue_event_text(np->jsock, text, np->serno++);
 			}
 		}
+
+		verto_event_text_release(&text);
 	}
 }
 
@@ -1245,6 +1377,10 @@ static void attach_jsock(jsock_t *jsock)
 			jp->nodelete = 1;
 			jp->drop = 1;
 			jsock->attach_timer = 5;
+
+			if (jp->reactor) {
+				reactor_schedule(jp);
+			}
 		}
 	}
 
@@ -1582,8 +1718,15 @@ static void jsock_check_event_queue(jsock_t *jsock)
 
 	switch_mutex_lock(jsock->write_mutex);
 	while(this_pass-- > 0 && switch_queue_trypop(jsock->event_queue, &pop) == SWITCH_STATUS_SUCCESS) {
-		cJSON *json = (cJSON *) pop;
-		ws_write_json(jsock, &json, SWITCH_TRUE);
+		jsock_qmsg_t *qm = (jsock_qmsg_t *) pop;
+
+		if (qm->json) {
+			ws_write_json(jsock, &qm->json, SWITCH_TRUE);
+		} else if (qm->text) {
+			ws_write_event_text(jsock, qm->text, qm->id, qm->serno);
+		}
+
+		jsock_qmsg_destroy(&qm);
 	}
 	switch_mutex_unlock(jsock->write_mutex);
 }
@@ -1905,293 +2048,927 @@ authed:
 		}
 	}
 
-	switch_event_add_header_string(stream.param_event, SWITCH_STACK_BOTTOM, "HTTP-URI", request->uri);
+	switch_event_add_header_string(stream.param_event, SWITCH_STACK_BOTTOM, "HTTP-URI", request->uri);
+
+	if ((ext = strrchr(request->uri, '.'))) {
+		char path[1024];
+
+		if (!strncmp(ext, ".lua", 4)) {
+			switch_snprintf(path, sizeof(path), "%s%s", vhost->script_root, request->uri);
+			switch_api_execute("lua", path, NULL, &stream);
+		} else {
+			http_static_handler(request, vhost);
+		}
+	} else {
+		http_static_handler(request, vhost);
+	}
+
+done:
+
+	keepalive = request->keepalive;
+	kws_request_free(&request);
+	if (stream.param_event) switch_event_destroy(&stream.param_event);
+
+	if (keepalive) {
+		kws_t *wsh = jsock->ws;
+
+		while(jsock->profile->running) {
+			int pflags = kws_wait_sock(wsh, 3000, KS_POLL_READ);
+
+			if (jsock->drop) { die("%s Dropping Connection\n", jsock->name); }
+			if (pflags < 0 && (errno != EINTR)) { die_errnof("%s POLL FAILED with %d", jsock->name, pflags); }
+			if (pflags == 0) { /* keepalive socket poll timeout */ break; }
+			if (pflags > 0 && (pflags & KS_POLL_HUP)) { log_and_exit(SWITCH_LOG_INFO, "%s POLL HANGUP DETECTED (peer closed its end of socket)\n", jsock->name); }
+			if (pflags > 0 && (pflags & KS_POLL_ERROR)) { die("%s POLL ERROR\n", jsock->name); }
+			if (pflags > 0 && (pflags & KS_POLL_INVALID)) { die("%s POLL INVALID SOCKET (not opened or already closed)\n", jsock->name); }
+			if (pflags > 0 && (pflags & KS_POLL_READ)) {
+				if (kws_keepalive(wsh) == KS_STATUS_SUCCESS) {
+					switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "socket %s is going to handle a new request\n", jsock->name);
+					goto new_req;
+				} else {
+					// switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Socket Read Error\n");
+					break;
+				}
+			} else {
+				switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "unhandled flag: %d\n", pflags);
+			}
+		}
+	}
+
+	return;
+
+request_err:
+	kws_request_free(&request);
+
+err:
+	err = "HTTP/1.1 500 Internal Server Error\r\n"
+		"Content-Length: 0\r\n\r\n";
+	kws_raw_write(jsock->ws, err, strlen(err));
+
+error:
+	return;
+}
+
+static void client_close(jsock_t *jsock)
+{
+	detach_jsock(jsock);
+	kws_destroy(&jsock->ws);
+	ks_pool_close(&jsock->kpool);
+}
+
+static void jsock_send_ping(jsock_t *jsock)
+{
+	cJSON *params = NULL;
+	cJSON *msg = jrpc_new_req("verto.ping", 0, &params);
+
+	if (jsock->exptime) {
+		cJSON_AddItemToObject(params, "auth-expires", cJSON_CreateNumber(jsock->exptime));
+	}
+
+	cJSON_AddItemToObject(params, "serno", cJSON_CreateNumber(switch_epoch_time_now(NULL)));
+	jsock_queue_event(jsock, &msg, SWITCH_TRUE);
+}
+
+/* one whole websocket message, the speed test is kept as state on the jsock so no read ever waits for the next frame */
+static switch_status_t jsock_handle_message(jsock_t *jsock, uint8_t *data, switch_ssize_t bytes)
+{
+	char *s = (char *) data;
+	char repl[2048] = "";
+	switch_time_t b;
+
+	if (!bytes || !data) {
+		return SWITCH_STATUS_SUCCESS;
+	}
+
+	if (jsock->speed_size) {
+		int i, loops, rem, dur = 0, j;
+		int size = jsock->speed_size;
+
+		/* swallow the upload, the first frame after it stops the clock */
+		if (s[0] == '#' && s[3] == 'B') {
+			return SWITCH_STATUS_SUCCESS;
+		}
+
+		b = switch_time_now();
+		jsock->speed_size = 0;
+
+		if (s[0] != '#') goto nm;
+
+		switch_snprintf(repl, sizeof(repl), "#SPU %ld", (long)((b - jsock->speed_start) / 1000));
+		kws_write_frame(jsock->ws, WSOC_TEXT, repl, strlen(repl));
+		loops = size / 1024;
+		rem = size % 1024;
+		switch_snprintf(repl, sizeof(repl), "#SPB ");
+		memset(repl+4, '.', 1024);
+
+		for (j = 0; j < 10 ; j++) {
+			int ddur = 0;
+			switch_time_t a = switch_time_now();
+			for (i = 0; i < loops; i++) {
+				kws_write_frame(jsock->ws, WSOC_TEXT, repl, 1024);
+			}
+			if (rem) {
+				kws_write_frame(jsock->ws, WSOC_TEXT, repl, rem);
+			}
+			b = switch_time_now();
+			ddur += (int)((b - a) / 1000);
+			dur += ddur;
+
+		}
+
+		dur /= j+1;
+
+		switch_snprintf(repl, sizeof(repl), "#SPD %d", dur);
+		kws_write_frame(jsock->ws, WSOC_TEXT, repl, strlen(repl));
+
+		return SWITCH_STATUS_SUCCESS;
+	}
+
+	if (*s == '#') {
+		if (s[1] == 'S' && s[2] == 'P' && s[3] == 'U') {
+			if ((jsock->speed_size = atoi(s + 4)) > 0) {
+				jsock->speed_start = switch_time_now();
+			} else {
+				jsock->speed_size = 0;
+			}
+		}
+
+		return SWITCH_STATUS_SUCCESS;
+	}
+
+ nm:
+
+	if (process_input(jsock, data, bytes) != SWITCH_STATUS_SUCCESS) {
+		die("%s Input Error\n", jsock->name);
+	}
+
+	return SWITCH_STATUS_SUCCESS;
+
+ error:
+	return SWITCH_STATUS_FALSE;
+}
+
+static switch_status_t jsock_read_frame(jsock_t *jsock)
+{
+	switch_ssize_t bytes;
+	kws_opcode_t oc;
+	uint8_t *data;
+
+	bytes = kws_read_frame(jsock->ws, &oc, &data);
+
+	if (bytes < 0) {
+		if (bytes == -1000) {
+			log_and_exit(SWITCH_LOG_INFO, "%s Client sent close request\n", jsock->name);
+		} else {
+			die("%s BAD READ %" SWITCH_SSIZE_T_FMT "\n", jsock->name, bytes);
+		}
+	}
+
+	return jsock_handle_message(jsock, data, bytes);
+
+ error:
+	return SWITCH_STATUS_FALSE;
+}
+
+#ifdef VERTO_REACTOR
+/* kws_raw_read() result when a non blocking read finds nothing */
+#define WS_NOBLOCK 0
+#define WS_WOULD_BLOCK -2
+/* largest message a reactor connection may send, fragments included */
+#define JSOCK_MAX_MESSAGE (2 * 1024 * 1024)
+
+/* 1 and the frame's layout when buf starts with a whole frame, 0 when more is needed, -1 when it is not one we take */
+static int jsock_parse_frame(uint8_t *buf, switch_size_t len, int *fin, int *oc, uint8_t **payload, switch_size_t *plen, switch_size_t *flen)
+{
+	switch_size_t hlen = 2;
+	uint64_t n;
+	uint8_t *mask;
+	switch_size_t i;
+
+	if (len < 2) {
+		return 0;
+	}
+
+	/* clients always mask */
+	if (!(buf[1] & 0x80)) {
+		return -1;
+	}
+
+	n = buf[1] & 0x7f;
+
+	if (n == 126) {
+		hlen += 2;
+		if (len < hlen) return 0;
+		n = ((uint64_t) buf[2] << 8) | buf[3];
+	} else if (n == 127) {
+		hlen += 8;
+		if (len < hlen) return 0;
+		for (n = 0, i = 2; i < 10; i++) {
+			n = (n << 8) | buf[i];
+		}
+	}
+
+	if (n > JSOCK_MAX_MESSAGE) {
+		return -1;
+	}
+
+	hlen += 4;
+
+	if (len < hlen + n) {
+		return 0;
+	}
+
+	mask = buf + hlen - 4;
+	*payload = buf + hlen;
+	for (i = 0; i < n; i++) {
+		(*payload)[i] ^= mask[i % 4];
+	}
+
+	*fin = (buf[0] & 0x80) ? 1 : 0;
+	*oc = buf[0] & 0x0f;
+	*plen = (switch_size_t) n;
+	*flen = hlen + (switch_size_t) n;
+
+	return 1;
+}
+
+static switch_status_t jsock_message_append(jsock_t *jsock, uint8_t *data, switch_size_t len)
+{
+	if (jsock->msg_len + len > JSOCK_MAX_MESSAGE) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	if (jsock->msg_len + len + 1 > jsock->msg_size) {
+		switch_size_t size = jsock->msg_size ? jsock->msg_size : 4096;
+		uint8_t *msg;
+
+		while (size < jsock->msg_len + len + 1) {
+			size *= 2;
+		}
+
+		if (!(msg = realloc(jsock->msg, size))) {
+			return SWITCH_STATUS_FALSE;
+		}
+
+		jsock->msg = msg;
+		jsock->msg_size = size;
+	}
+
+	memcpy(jsock->msg + jsock->msg_len, data, len);
+	jsock->msg_len += len;
+	jsock->msg[jsock->msg_len] = '\0';
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+/*
+ * Reactor side read: take whatever the socket has without waiting, keep partial frames on the jsock and handle
+ * the messages that are complete.  A client trickling a frame in byte by byte costs a buffer, never a worker.
+ */
+static switch_status_t jsock_read_frames(jsock_t *jsock, int *messages)
+{
+	*messages = 0;
+
+	for (;;) {
+		switch_ssize_t r;
+		switch_size_t off = 0;
+
+		if (jsock->rbuf_size - jsock->rbuf_len < 4096) {
+			switch_size_t size = jsock->rbuf_size ? jsock->rbuf_size * 2 : 16384;
+			uint8_t *rbuf;
+
+			if (size > JSOCK_MAX_MESSAGE + 14) {
+				size = JSOCK_MAX_MESSAGE + 14;
+			}
+
+			if (size <= jsock->rbuf_len + 1 || !(rbuf = realloc(jsock->rbuf, size))) {
+				die("%s Frame too big\n", jsock->name);
+			}
+
+			jsock->rbuf = rbuf;
+			jsock->rbuf_size = size;
+		}
+
+		/* kws_raw_read() terminates what it read, keep a byte for the NUL */
+		r = kws_raw_read(jsock->ws, jsock->rbuf + jsock->rbuf_len, jsock->rbuf_size - jsock->rbuf_len - 1, WS_NOBLOCK);
+
+		if (r == WS_WOULD_BLOCK) {
+			break;
+		}
+
+		if (r == 0) {
+			log_and_exit(SWITCH_LOG_INFO, "%s Peer closed its end of socket\n", jsock->name);
+		}
+
+		if (r < 0) {
+			die("%s BAD READ %" SWITCH_SSIZE_T_FMT "\n", jsock->name, r);
+		}
+
+		jsock->rbuf_len += r;
+
+		for (;;) {
+			uint8_t *payload = NULL;
+			switch_size_t plen = 0, flen = 0;
+			int fin = 0, oc = 0, ok;
+
+			if (!(ok = jsock_parse_frame(jsock->rbuf + off, jsock->rbuf_len - off, &fin, &oc, &payload, &plen, &flen))) {
+				break;
+			}
+
+			if (ok < 0) {
+				die("%s Bad frame\n", jsock->name);
+			}
+
+			off += flen;
+
+			switch (oc) {
+			case WSOC_CLOSE:
+				log_and_exit(SWITCH_LOG_INFO, "%s Client sent close request\n", jsock->name);
+			case WSOC_PING:
+				switch_mutex_lock(jsock->write_mutex);
+				kws_write_frame(jsock->ws, WSOC_PONG, payload, plen);
+				switch_mutex_unlock(jsock->write_mutex);
+				continue;
+			case WSOC_PONG:
+				continue;
+			case WSOC_CONTINUATION:
+				if (!jsock->msg_oc) {
+					die("%s Continuation without a message\n", jsock->name);
+				}
+				break;
+			case WSOC_TEXT:
+			case WSOC_BINARY:
+				jsock->msg_len = 0;
+				jsock->msg_oc = oc;
+				break;
+			default:
+				die("%s Bad opcode %d\n", jsock->name, oc);
+			}
+
+			if (jsock_message_append(jsock, payload, plen) != SWITCH_STATUS_SUCCESS) {
+				die("%s Message too big\n", jsock->name);
+			}
+
+			if (fin) {
+				jsock->msg_oc = 0;
+				(*messages)++;
+
+				if (jsock_handle_message(jsock, jsock->msg, jsock->msg_len) != SWITCH_STATUS_SUCCESS) {
+					goto error;
+				}
+
+				jsock->msg_len = 0;
+			}
+		}
+
+		if (off) {
+			memmove(jsock->rbuf, jsock->rbuf + off, jsock->rbuf_len - off);
+			jsock->rbuf_len -= off;
+		}
+	}
+
+	return SWITCH_STATUS_SUCCESS;
+
+ error:
+	return SWITCH_STATUS_FALSE;
+}
+#endif
+
+static void client_run(jsock_t *jsock)
+{
+	int flags = KWS_BLOCK;
+	int idle = 0;
+	
+	if (jsock->profile->vhosts) {
+		flags |= KWS_STAY_OPEN;
+		flags |= KWS_HTTP;
+	}
+
+	ks_pool_open(&jsock->kpool);
+	if (kws_init(&jsock->ws, jsock->client_socket, (jsock->ptype & PTYPE_CLIENT_SSL) ? jsock->profile->ssl_ctx : NULL, 0, flags, jsock->kpool) != KS_STATUS_SUCCESS) {
+		log_and_exit(SWITCH_LOG_NOTICE, "%s WS SETUP FAILED\n", jsock->name);
+	}
+
+	if (kws_test_flag(jsock->ws, KWS_HTTP)) {
+		http_run(jsock);
+		kws_close(jsock->ws, WS_NONE);
+		goto end;
+	}
+
+	if ((jsock->reactor = reactor_next())) {
+		/* handed to the reactor by client_thread() once we are done with it */
+		return;
+	}
+
+	while(jsock->profile->running) {
+		int pflags, poll_time = 50;
+		time_t now;
+
+		if (!jsock->ws) { die("%s Setup Error\n", jsock->name); }
+		
+		pflags = kws_wait_sock(jsock->ws, poll_time, KS_POLL_READ);
+
+		if (jsock->exptime) {
+			now = switch_epoch_time_now(NULL);
+
+			if (now >= jsock->exptime) {
+				switch_set_flag(jsock, JPFLAG_AUTH_EXPIRED);
+				die("%s Authentication Expired [%ld] >= [%ld]\n", jsock->uid, now, jsock->exptime);
+			}
+
+		}
+
+		if (jsock->drop) { die("%s Dropping Connection\n", jsock->name); }
+		if (pflags < 0 && (errno != EINTR)) { die_errnof("%s POLL FAILED with %d", jsock->name, pflags); }
+		if (pflags == 0) {/* socket poll timeout */ jsock_check_event_queue(jsock); idle += poll_time;} else {idle = 0;}
+
+		if (idle >= 30000) {
+			jsock_send_ping(jsock);
+			idle = 0;
+		}
+		
+		if ((!switch_test_flag(jsock, JPFLAG_CHECK_ATTACH) || (jsock->attach_timer > 0 && jsock->attach_timer-- == 0)) &&
+			switch_test_flag(jsock, JPFLAG_AUTHED)) {
+			attach_calls(jsock);
+			switch_set_flag(jsock, JPFLAG_CHECK_ATTACH);
+		}
+
+		if (pflags > 0 && (pflags & KS_POLL_HUP)) { log_and_exit(SWITCH_LOG_INFO, "%s POLL HANGUP DETECTED (peer closed its end of socket)\n", jsock->name); }
+		if (pflags > 0 && (pflags & KS_POLL_ERROR)) { die("%s POLL ERROR\n", jsock->name); }
+		if (pflags > 0 && (pflags & KS_POLL_INVALID)) { die("%s POLL INVALID SOCKET (not opened or already closed)\n", jsock->name); }
+		if (pflags > 0 && (pflags & KS_POLL_READ)) {
+			if (jsock_read_frame(jsock) != SWITCH_STATUS_SUCCESS) {
+				goto error;
+			}
+		}
+	}
+
+ error:
+ end:
+	client_close(jsock);
+}
+
+static void jsock_flush(jsock_t *jsock)
+{
+	void *pop;
+
+	switch_mutex_lock(jsock->write_mutex);
+	while(switch_queue_trypop(jsock->event_queue, &pop) == SWITCH_STATUS_SUCCESS) {
+		jsock_qmsg_t *qm = (jsock_qmsg_t *) pop;
+		jsock_qmsg_destroy(&qm);
+	}
+	switch_mutex_unlock(jsock->write_mutex);
+}
+
+static void client_cleanup(jsock_t *jsock)
+{
+	switch_event_t *s_event;
+	switch_memory_pool_t *pool = jsock->pool;
+
+	detach_calls(jsock);
+
+	del_jsock(jsock);
+
+	switch_event_destroy(&jsock->params);
+	switch_event_destroy(&jsock->vars);
+	switch_event_destroy(&jsock->user_vars);
+
+	if (jsock->client_socket != KS_SOCK_INVALID) {
+		close_socket(&jsock->client_socket);
+	}
+
+	switch_event_destroy(&jsock->allowed_methods);
+	switch_event_destroy(&jsock->allowed_fsapi);
+	switch_event_destroy(&jsock->allowed_jsapi);
+	switch_event_destroy(&jsock->allowed_event_channels);
+
+	jsock_flush(jsock);
+
+	switch_safe_free(jsock->rbuf);
+	switch_safe_free(jsock->msg);
+
+    switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "%s Ending client thread.\n", jsock->name);
+	if (switch_event_create_subclass(&s_event, SWITCH_EVENT_CUSTOM, MY_EVENT_CLIENT_DISCONNECT) == SWITCH_STATUS_SUCCESS) {
+		switch_event_add_header_string(s_event, SWITCH_STACK_BOTTOM, "verto_profile_name", jsock->profile->name);
+		switch_event_add_header_string(s_event, SWITCH_STACK_BOTTOM, "verto_client_address", jsock->name);
+		switch_event_add_header_string(s_event, SWITCH_STACK_BOTTOM, "verto_login", switch_str_nil(jsock->uid));
+		switch_event_fire(&s_event);
+	}
+	switch_thread_rwlock_wrlock(jsock->rwlock);
+	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "%s Thread ended\n", jsock->name);
+	switch_thread_rwlock_unlock(jsock->rwlock);
+
+	if (jsock->reactor) {
+		/* the reactor thread frees the pool once it can no longer be holding an event for this jsock */
+		reactor_release(jsock);
+	} else {
+		switch_core_destroy_memory_pool(&pool);
+	}
+}
+
+static void *SWITCH_THREAD_FUNC client_thread(switch_thread_t *thread, void *obj)
+{
+	jsock_t *jsock = (jsock_t *) obj;
+
+	switch_event_create(&jsock->params, SWITCH_EVENT_CHANNEL_DATA);
+	switch_event_create(&jsock->vars, SWITCH_EVENT_CHANNEL_DATA);
+	switch_event_create(&jsock->user_vars, SWITCH_EVENT_CHANNEL_DATA);
+
+
+	add_jsock(jsock);
+
+    switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "%s Starting client thread.\n", jsock->name);
+
+	if ((jsock->ptype & PTYPE_CLIENT) || (jsock->ptype & PTYPE_CLIENT_SSL)) {
+		client_run(jsock);
+
+		if (jsock->reactor) {
+			reactor_add(jsock);
+			return NULL;
+		}
+	} else {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "%s Ending client thread.\n", jsock->name);
+	}
+
+	client_cleanup(jsock);
+
+	return NULL;
+}
+
+#ifdef VERTO_REACTOR
+static void reactor_schedule(jsock_t *jsock)
+{
+	int push = 0;
+
+	switch_mutex_lock(jsock->flag_mutex);
+	if (jsock->reactor_busy) {
+		jsock->reactor_again = 1;
+	} else {
+		jsock->reactor_busy = push = 1;
+	}
+	switch_mutex_unlock(jsock->flag_mutex);
+
+	/* a jsock is queued at most once so the queue never holds more than the connection count */
+	if (push) {
+		switch_queue_push(reactor_GLOBALS.queue, jsock);
+	}
+}
+
+static verto_reactor_t *reactor_next(void)
+{
+	verto_reactor_t *r = NULL;
+
+	switch_mutex_lock(reactor_GLOBALS.mutex);
+	if (reactor_GLOBALS.running) {
+		r = &reactor_GLOBALS.reactors[reactor_GLOBALS.next++ % reactor_GLOBALS.reactor_count];
+	}
+	switch_mutex_unlock(reactor_GLOBALS.mutex);
+
+	return r;
+}
 
-	if ((ext = strrchr(request->uri, '.'))) {
-		char path[1024];
+static void reactor_add(jsock_t *jsock)
+{
+	switch_mutex_lock(reactor_GLOBALS.mutex);
+	jsock->reactor->connections++;
+	switch_mutex_unlock(reactor_GLOBALS.mutex);
 
-		if (!strncmp(ext, ".lua", 4)) {
-			switch_snprintf(path, sizeof(path), "%s%s", vhost->script_root, request->uri);
-			switch_api_execute("lua", path, NULL, &stream);
-		} else {
-			http_static_handler(request, vhost);
-		}
-	} else {
-		http_static_handler(request, vhost);
-	}
+	jsock->reactor_input = switch_epoch_time_now(NULL);
 
-done:
+	/* reads from here on must never wait, see jsock_read_frames() */
+	fcntl(jsock->client_socket, F_SETFL, fcntl(jsock->client_socket, F_GETFL, 0) | O_NONBLOCK);
 
-	keepalive = request->keepalive;
-	kws_request_free(&request);
-	if (stream.param_event) switch_event_destroy(&stream.param_event);
+	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "%s Handing connection to reactor %d.\n", jsock->name, jsock->reactor->id);
 
-	if (keepalive) {
-		kws_t *wsh = jsock->ws;
+	/* the handshake may have buffered more input than the socket will report, so start with a pass on a worker */
+	reactor_schedule(jsock);
+}
 
-		while(jsock->profile->running) {
-			int pflags = kws_wait_sock(wsh, 3000, KS_POLL_READ);
+static void reactor_arm(jsock_t *jsock)
+{
+	struct epoll_event e = { 0 };
 
-			if (jsock->drop) { die("%s Dropping Connection\n", jsock->name); }
-			if (pflags < 0 && (errno != EINTR)) { die_errnof("%s POLL FAILED with %d", jsock->name, pflags); }
-			if (pflags == 0) { /* keepalive socket poll timeout */ break; }
-			if (pflags > 0 && (pflags & KS_POLL_HUP)) { log_and_exit(SWITCH_LOG_INFO, "%s POLL HANGUP DETECTED (peer closed its end of socket)\n", jsock->name); }
-			if (pflags > 0 && (pflags & KS_POLL_ERROR)) { die("%s POLL ERROR\n", jsock->name); }
-			if (pflags > 0 && (pflags & KS_POLL_INVALID)) { die("%s POLL INVALID SOCKET (not opened or already closed)\n", jsock->name); }
-			if (pflags > 0 && (pflags & KS_POLL_READ)) {
-				if (kws_keepalive(wsh) == KS_STATUS_SUCCESS) {
-					switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "socket %s is going to handle a new request\n", jsock->name);
-					goto new_req;
-				} else {
-					// switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Socket Read Error\n");
-					break;
-				}
-			} else {
-				switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "unhandled flag: %d\n", pflags);
-			}
-		}
+	if (jsock->client_socket == KS_SOCK_INVALID) {
+		return;
 	}
 
-	return;
+	e.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+	e.data.ptr = jsock;
 
-request_err:
-	kws_request_free(&request);
+	if (epoll_ctl(jsock->reactor->epfd, EPOLL_CTL_MOD, jsock->client_socket, &e) < 0 && errno == ENOENT) {
+		epoll_ctl(jsock->reactor->epfd, EPOLL_CTL_ADD, jsock->client_socket, &e);
+	}
+}
 
-err:
-	err = "HTTP/1.1 500 Internal Server Error\r\n"
-		"Content-Length: 0\r\n\r\n";
-	kws_raw_write(jsock->ws, err, strlen(err));
+static void reactor_release(jsock_t *jsock)
+{
+	switch_mutex_lock(reactor_GLOBALS.mutex);
+	jsock->reactor->connections--;
+	switch_mutex_unlock(reactor_GLOBALS.mutex);
 
-error:
-	return;
+	switch_queue_push(jsock->reactor->dead_queue, jsock);
 }
 
-static void client_run(jsock_t *jsock)
+static switch_bool_t reactor_service(jsock_t *jsock)
 {
-	int flags = KWS_BLOCK;
-	int idle = 0;
-	
-	if (jsock->profile->vhosts) {
-		flags |= KWS_STAY_OPEN;
-		flags |= KWS_HTTP;
+	verto_reactor_t *r = jsock->reactor;
+	switch_time_t ready = jsock->reactor_ready ? jsock->reactor_ready : switch_micro_time_now(), done;
+	time_t now = switch_epoch_time_now(NULL);
+	int messages = 0;
+
+	if (!jsock->profile->running) { return SWITCH_FALSE; }
+	if (jsock->drop) { die("%s Dropping Connection\n", jsock->name); }
+	if (jsock->exptime && now >= jsock->exptime) {
+		switch_set_flag(jsock, JPFLAG_AUTH_EXPIRED);
+		die("%s Authentication Expired [%ld] >= [%ld]\n", jsock->uid, now, jsock->exptime);
 	}
 
-	ks_pool_open(&jsock->kpool);
-	if (kws_init(&jsock->ws, jsock->client_socket, (jsock->ptype & PTYPE_CLIENT_SSL) ? jsock->profile->ssl_ctx : NULL, 0, flags, jsock->kpool) != KS_STATUS_SUCCESS) {
-		log_and_exit(SWITCH_LOG_NOTICE, "%s WS SETUP FAILED\n", jsock->name);
+	if (jsock_read_frames(jsock, &messages) != SWITCH_STATUS_SUCCESS) {
+		goto error;
 	}
 
-	if (kws_test_flag(jsock->ws, KWS_HTTP)) {
-		http_run(jsock);
-		kws_close(jsock->ws, WS_NONE);
-		goto end;
+	if (messages) {
+		jsock->reactor_input = now;
+		done = switch_micro_time_now();
+
+		switch_mutex_lock(reactor_GLOBALS.mutex);
+		r->messages += messages;
+		r->latency_total += (done - ready) * messages;
+		if (done - ready > r->latency_max) {
+			r->latency_max = done - ready;
+		}
+		switch_mutex_unlock(reactor_GLOBALS.mutex);
 	}
 
-	while(jsock->profile->running) {
-		int pflags, poll_time = 50;
-		time_t now;
+	jsock_check_event_queue(jsock);
 
-		if (!jsock->ws) { die("%s Setup Error\n", jsock->name); }
-		
-		pflags = kws_wait_sock(jsock->ws, poll_time, KS_POLL_READ);
+	if (!switch_test_flag(jsock, JPFLAG_CHECK_ATTACH) && switch_test_flag(jsock, JPFLAG_AUTHED)) {
+		attach_calls(jsock);
+		switch_set_flag(jsock, JPFLAG_CHECK_ATTACH);
+	}
 
-		if (jsock->exptime) {
-			now = switch_epoch_time_now(NULL);
+	if (jsock->drop) { die("%s Dropping Connection\n", jsock->name); }
 
-			if (now >= jsock->exptime) {
-				switch_set_flag(jsock, JPFLAG_AUTH_EXPIRED);
-				die("%s Authentication Expired [%ld] >= [%ld]\n", jsock->uid, now, jsock->exptime);
+	return SWITCH_TRUE;
+
+ error:
+	return SWITCH_FALSE;
+}
+
+static void *SWITCH_THREAD_FUNC reactor_worker_thread(switch_thread_t *thread, void *obj)
+{
+	void *pop = NULL;
+
+	while (switch_queue_pop(reactor_GLOBALS.queue, &pop) == SWITCH_STATUS_SUCCESS && pop) {
+		jsock_t *jsock = (jsock_t *) pop;
+		int again;
+
+		do {
+			if (!reactor_service(jsock)) {
+				/* reactor_busy stays set so nothing queues this jsock again */
+				if (jsock->client_socket != KS_SOCK_INVALID) {
+					struct epoll_event e = { 0 };
+					epoll_ctl(jsock->reactor->epfd, EPOLL_CTL_DEL, jsock->client_socket, &e);
+				}
+				client_close(jsock);
+				client_cleanup(jsock);
+				break;
 			}
 
-		}
+			switch_mutex_lock(jsock->flag_mutex);
+			if (!(again = jsock->reactor_again)) {
+				jsock->reactor_busy = 0;
+				jsock->reactor_ready = 0;
+				reactor_arm(jsock);
+			}
+			jsock->reactor_again = 0;
+			switch_mutex_unlock(jsock->flag_mutex);
+		} while (again);
+	}
 
-		if (jsock->drop) { die("%s Dropping Connection\n", jsock->name); }
-		if (pflags < 0 && (errno != EINTR)) { die_errnof("%s POLL FAILED with %d", jsock->name, pflags); }
-		if (pflags == 0) {/* socket poll timeout */ jsock_check_event_queue(jsock); idle += poll_time;} else {idle = 0;}
+	return NULL;
+}
 
-		if (idle >= 30000) {
-			cJSON *params = NULL;
-			cJSON *msg = jrpc_new_req("verto.ping", 0, &params);
+static void reactor_tick(verto_reactor_t *r, time_t now)
+{
+	verto_profile_t *profile;
+	jsock_t *jsock;
 
-			if (jsock->exptime) {
-				cJSON_AddItemToObject(params, "auth-expires", cJSON_CreateNumber(jsock->exptime));
+	switch_mutex_lock(verto_globals.mutex);
+	for (profile = verto_globals.profile_head; profile; profile = profile->next) {
+		switch_mutex_lock(profile->mutex);
+		for (jsock = profile->jsock_head; jsock; jsock = jsock->next) {
+			if (jsock->reactor != r || !jsock->reactor_input) {
+				continue;
+			}
+
+			if (!profile->running || jsock->drop || (jsock->exptime && now >= jsock->exptime)) {
+				reactor_schedule(jsock);
+			} else if (now - jsock->reactor_input >= 30) {
+				jsock_send_ping(jsock);
+				jsock->reactor_input = now;
 			}
-			
-			cJSON_AddItemToObject(params, "serno", cJSON_CreateNumber(switch_epoch_time_now(NULL)));
-			jsock_queue_event(jsock, &msg, SWITCH_TRUE);
-			idle = 0;
 		}
-		
-		if ((!switch_test_flag(jsock, JPFLAG_CHECK_ATTACH) || (jsock->attach_timer > 0 && jsock->attach_timer-- == 0)) &&
-			switch_test_flag(jsock, JPFLAG_AUTHED)) {
-			attach_calls(jsock);
-			switch_set_flag(jsock, JPFLAG_CHECK_ATTACH);
+		switch_mutex_unlock(profile->mutex);
+	}
+	switch_mutex_unlock(verto_globals.mutex);
+}
+
+static void *SWITCH_THREAD_FUNC reactor_thread(switch_thread_t *thread, void *obj)
+{
+	verto_reactor_t *r = (verto_reactor_t *) obj;
+	struct epoll_event events[REACTOR_MAX_EVENTS];
+	time_t last = switch_epoch_time_now(NULL);
+
+	while (reactor_GLOBALS.running) {
+		void *pop = NULL;
+		time_t now;
+		int i, n;
+
+		/* anything released since the last epoll_wait() can no longer show up in events[] */
+		while (switch_queue_trypop(r->dead_queue, &pop) == SWITCH_STATUS_SUCCESS) {
+			switch_memory_pool_t *pool = ((jsock_t *) pop)->pool;
+			switch_core_destroy_memory_pool(&pool);
 		}
 
-		if (pflags > 0 && (pflags & KS_POLL_HUP)) { log_and_exit(SWITCH_LOG_INFO, "%s POLL HANGUP DETECTED (peer closed its end of socket)\n", jsock->name); }
-		if (pflags > 0 && (pflags & KS_POLL_ERROR)) { die("%s POLL ERROR\n", jsock->name); }
-		if (pflags > 0 && (pflags & KS_POLL_INVALID)) { die("%s POLL INVALID SOCKET (not opened or already closed)\n", jsock->name); }
-		if (pflags > 0 && (pflags & KS_POLL_READ)) {
-			switch_ssize_t bytes;
-			kws_opcode_t oc;
-			uint8_t *data;
+		n = epoll_wait(r->epfd, events, REACTOR_MAX_EVENTS, 1000);
 
-			bytes = kws_read_frame(jsock->ws, &oc, &data);
+		if (n > 0) {
+			switch_time_t ready = switch_micro_time_now();
 
-			if (bytes < 0) {
-				if (bytes == -1000) {
-					log_and_exit(SWITCH_LOG_INFO, "%s Client sent close request\n", jsock->name);
-				} else {
-					die("%s BAD READ %" SWITCH_SSIZE_T_FMT "\n", jsock->name, bytes);
-				}
+			for (i = 0; i < n; i++) {
+				jsock_t *jsock = (jsock_t *) events[i].data.ptr;
+
+				jsock->reactor_ready = ready;
+				reactor_schedule(jsock);
 			}
+		}
 
-			if (bytes) {
-				char *s = (char *) data;
+		if ((now = switch_epoch_time_now(NULL)) != last) {
+			reactor_tick(r, now);
+			last = now;
+		}
+	}
 
-				if (*s == '#') {
-					char repl[2048] = "";
-					switch_time_t a, b;
+	return NULL;
+}
 
-					if (s[1] == 'S' && s[2] == 'P') {
+static void reactor_start(void)
+{
+	int i;
 
-						if (s[3] == 'U') {
-							int i, size = 0;
-							char *p = s+4;
-							int loops = 0;
-							int rem = 0;
-							int dur = 0, j = 0;
+	if (!verto_globals.reactor_workers) {
+		return;
+	}
 
-							if ((size = atoi(p)) <= 0) {
-								continue;
-							}
+	memset(&reactor_GLOBALS, 0, sizeof(reactor_GLOBALS));
+	reactor_GLOBALS.reactor_count = verto_globals.reactor_threads > 0 ? verto_globals.reactor_threads : 1;
+	reactor_GLOBALS.worker_count = verto_globals.reactor_workers;
 
-							a = switch_time_now();
-							do {
-								bytes = kws_read_frame(jsock->ws, &oc, &data);
-								s = (char *) data;
-							} while (bytes && data && s[0] == '#' && s[3] == 'B');
-							b = switch_time_now();
-
-							if (!bytes || !data) continue;
-
-							if (s[0] != '#') goto nm;
-
-							switch_snprintf(repl, sizeof(repl), "#SPU %ld", (long)((b - a) / 1000));
-							kws_write_frame(jsock->ws, WSOC_TEXT, repl, strlen(repl));
-							loops = size / 1024;
-							rem = size % 1024;
-							switch_snprintf(repl, sizeof(repl), "#SPB ");
-							memset(repl+4, '.', 1024);
-
-							for (j = 0; j < 10 ; j++) {
-								int ddur = 0;
-								a = switch_time_now();
-								for (i = 0; i < loops; i++) {
-									kws_write_frame(jsock->ws, WSOC_TEXT, repl, 1024);
-								}
-								if (rem) {
-									kws_write_frame(jsock->ws, WSOC_TEXT, repl, rem);
-								}
-								b = switch_time_now();
-								ddur += (int)((b - a) / 1000);
-								dur += ddur;
+	switch_mutex_init(&reactor_GLOBALS.mutex, SWITCH_MUTEX_NESTED, verto_globals.pool);
+	switch_queue_create(&reactor_GLOBALS.queue, SWITCH_CORE_QUEUE_LEN, verto_globals.pool);
+	reactor_GLOBALS.running = 1;
 
-							}
+	for (i = 0; i < reactor_GLOBALS.reactor_count; i++) {
+		verto_reactor_t *r = &reactor_GLOBALS.reactors[i];
+		switch_threadattr_t *thd_attr = NULL;
 
-							dur /= j+1;
+		r->id = i;
 
-							switch_snprintf(repl, sizeof(repl), "#SPD %d", dur);
-							kws_write_frame(jsock->ws, WSOC_TEXT, repl, strlen(repl));
-						}
-					}
+		if ((r->epfd = epoll_create(1024)) < 0) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Cannot create reactor %d, connections will use their own thread.\n", i);
+			reactor_GLOBALS.reactor_count = i;
+			break;
+		}
 
-					continue;
-				}
+		switch_queue_create(&r->dead_queue, SWITCH_CORE_QUEUE_LEN, verto_globals.pool);
+		switch_threadattr_create(&thd_attr, verto_globals.pool);
+		switch_threadattr_stacksize_set(thd_attr, SWITCH_THREAD_STACKSIZE);
+		switch_thread_create(&r->thread, thd_attr, reactor_thread, r, verto_globals.pool);
+	}
 
-			nm:
+	if (!reactor_GLOBALS.reactor_count) {
+		reactor_GLOBALS.running = 0;
+		return;
+	}
 
-				if (process_input(jsock, data, bytes) != SWITCH_STATUS_SUCCESS) {
-					die("%s Input Error\n", jsock->name);
-				}
-			}
-		}
+	for (i = 0; i < reactor_GLOBALS.worker_count; i++) {
+		switch_threadattr_t *thd_attr = NULL;
+
+		switch_threadattr_create(&thd_attr, verto_globals.pool);
+		switch_threadattr_stacksize_set(thd_attr, SWITCH_THREAD_STACKSIZE);
+		switch_thread_create(&reactor_GLOBALS.workers[i], thd_attr, reactor_worker_thread, NULL, verto_globals.pool);
 	}
 
- error:
- end:
-	detach_jsock(jsock);
-	kws_destroy(&jsock->ws);
-	ks_pool_close(&jsock->kpool);
-	return;
+	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_INFO, "Started %d reactor(s) with %d worker(s)\n",
+					  reactor_GLOBALS.reactor_count, reactor_GLOBALS.worker_count);
 }
 
-static void jsock_flush(jsock_t *jsock)
+static void reactor_stop(void)
 {
-	void *pop;
+	switch_status_t st;
+	int i, sanity = 50;
 
-	switch_mutex_lock(jsock->write_mutex);
-	while(switch_queue_trypop(jsock->event_queue, &pop) == SWITCH_STATUS_SUCCESS) {
-		cJSON *json = (cJSON *) pop;
-		cJSON_Delete(json);
+	if (!reactor_GLOBALS.running) {
+		return;
 	}
-	switch_mutex_unlock(jsock->write_mutex);
-}
 
-static void *SWITCH_THREAD_FUNC client_thread(switch_thread_t *thread, void *obj)
-{
-	switch_event_t *s_event;
+	/* the profiles are stopped so the next tick hands every connection to a worker for cleanup */
+	for (;;) {
+		uint32_t connections = 0;
 
-	jsock_t *jsock = (jsock_t *) obj;
+		switch_mutex_lock(reactor_GLOBALS.mutex);
+		for (i = 0; i < reactor_GLOBALS.reactor_count; i++) {
+			connections += reactor_GLOBALS.reactors[i].connections;
+		}
+		switch_mutex_unlock(reactor_GLOBALS.mutex);
 
-	switch_event_create(&jsock->params, SWITCH_EVENT_CHANNEL_DATA);
-	switch_event_create(&jsock->vars, SWITCH_EVENT_CHANNEL_DATA);
-	switch_event_create(&jsock->user_vars, SWITCH_EVENT_CHANNEL_DATA);
+		if (!connections || --sanity <= 0) {
+			break;
+		}
 
+		switch_yield(100000);
+	}
 
-	add_jsock(jsock);
+	reactor_GLOBALS.running = 0;
 
-    switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "%s Starting client thread.\n", jsock->name);
+	for (i = 0; i < reactor_GLOBALS.worker_count; i++) {
+		switch_queue_push(reactor_GLOBALS.queue, NULL);
+	}
 
-	if ((jsock->ptype & PTYPE_CLIENT) || (jsock->ptype & PTYPE_CLIENT_SSL)) {
-		client_run(jsock);
-	} else {
-		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "%s Ending client thread.\n", jsock->name);
+	for (i = 0; i < reactor_GLOBALS.worker_count; i++) {
+		switch_thread_join(&st, reactor_GLOBALS.workers[i]);
 	}
 
-	detach_calls(jsock);
+	for (i = 0; i < reactor_GLOBALS.reactor_count; i++) {
+		verto_reactor_t *r = &reactor_GLOBALS.reactors[i];
+		void *pop = NULL;
 
-	del_jsock(jsock);
+		switch_thread_join(&st, r->thread);
 
-	switch_event_destroy(&jsock->params);
-	switch_event_destroy(&jsock->vars);
-	switch_event_destroy(&jsock->user_vars);
+		while (switch_queue_trypop(r->dead_queue, &pop) == SWITCH_STATUS_SUCCESS) {
+			switch_memory_pool_t *pool = ((jsock_t *) pop)->pool;
+			switch_core_destroy_memory_pool(&pool);
+		}
 
-	if (jsock->client_socket != KS_SOCK_INVALID) {
-		close_socket(&jsock->client_socket);
+		close(r->epfd);
 	}
+}
 
-	switch_event_destroy(&jsock->allowed_methods);
-	switch_event_destroy(&jsock->allowed_fsapi);
-	switch_event_destroy(&jsock->allowed_jsapi);
-	switch_event_destroy(&jsock->allowed_event_channels);
+static void reactor_status(switch_stream_handle_t *stream)
+{
+	int i;
 
-	jsock_flush(jsock);
+	if (!reactor_GLOBALS.running) {
+		stream->write_function(stream, "Reactor not running, each connection has its own thread.\n");
+		return;
+	}
 
-    switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "%s Ending client thread.\n", jsock->name);
-	if (switch_event_create_subclass(&s_event, SWITCH_EVENT_CUSTOM, MY_EVENT_CLIENT_DISCONNECT) == SWITCH_STATUS_SUCCESS) {
-		switch_event_add_header_string(s_event, SWITCH_STACK_BOTTOM, "verto_profile_name", jsock->profile->name);
-		switch_event_add_header_string(s_event, SWITCH_STACK_BOTTOM, "verto_client_address", jsock->name);
-		switch_event_add_header_string(s_event, SWITCH_STACK_BOTTOM, "verto_login", switch_str_nil(jsock->uid));
-		switch_event_fire(&s_event);
+	switch_mutex_lock(reactor_GLOBALS.mutex);
+	for (i = 0; i < reactor_GLOBALS.reactor_count; i++) {
+		verto_reactor_t *r = &reactor_GLOBALS.reactors[i];
+
+		stream->write_function(stream, "reactor %d\tconnections %u\tmessages %" SWITCH_UINT64_T_FMT "\tavg latency %" SWITCH_TIME_T_FMT
+							   "us\tmax latency %" SWITCH_TIME_T_FMT "us\n", r->id, r->connections, r->messages,
+							   r->messages ? r->latency_total / r->messages : 0, r->latency_max);
 	}
-	switch_thread_rwlock_wrlock(jsock->rwlock);
-	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "%s Thread ended\n", jsock->name);
-	switch_thread_rwlock_unlock(jsock->rwlock);
+	stream->write_function(stream, "workers %d\tqueued %u\n", reactor_GLOBALS.worker_count, switch_queue_size(reactor_GLOBALS.queue));
+	switch_mutex_unlock(reactor_GLOBALS.mutex);
+}
+#else
+static void reactor_schedule(jsock_t *jsock)
+{
+}
 
+static verto_reactor_t *reactor_next(void)
+{
 	return NULL;
 }
 
+static void reactor_add(jsock_t *jsock)
+{
+}
+
+static void reactor_release(jsock_t *jsock)
+{
+}
+
+static void reactor_start(void)
+{
+	if (verto_globals.reactor_workers) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "reactor-workers is not supported on this platform, each connection will have its own thread.\n");
+	}
+}
+
+static void reactor_stop(void)
+{
+}
+
+static void reactor_status(switch_stream_handle_t *stream)
+{
+	stream->write_function(stream, "Reactor not supported on this platform.\n");
+}
+#endif
 
 static switch_bool_t auth_api_command(jsock_t *jsock, const char *api_cmd, const char *arg)
 {
@@ -4732,12 +5509,12 @@ static int start_jsock(verto_profile_t *profile, ks_socket_t sock, int family)
 	setsockopt(jsock->client_socket, IPPROTO_TCP, TCP_KEEPINTVL, (void *)&flag, sizeof(flag));
 #endif
 
-	td = switch_core_alloc(jsock->pool, sizeof(*td));
+	/* the jsock may outlive its thread once it is handed to a reactor, so client_cleanup() owns the pool */
+	switch_zmalloc(td, sizeof(*td));
 
-	td->alloc = 0;
+	td->alloc = 1;
 	td->func = client_thread;
 	td->obj = jsock;
-	td->pool = pool;
 
 	switch_mutex_init(&jsock->write_mutex, SWITCH_MUTEX_NESTED, jsock->pool);
 	switch_mutex_init(&jsock->filter_mutex, SWITCH_MUTEX_NESTED, jsock->pool);
@@ -5017,6 +5794,8 @@ static void do_shutdown(void)
 
 	kill_profiles();
 
+	reactor_stop();
+
 	unsub_all_jsock();
 
 	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_INFO, "Done\n");
@@ -5441,6 +6220,16 @@ static switch_status_t parse_config(const char *cf)
 				if (tmp > 0) {
 					verto_globals.detach_timeout = tmp;
 				}
+			} else if (!strcasecmp(var, "reactor-threads") && val) {
+				int tmp = atoi(val);
+				if (tmp > 0 && tmp <= MAX_REACTORS) {
+					verto_globals.reactor_threads = tmp;
+				}
+			} else if (!strcasecmp(var, "reactor-workers") && val) {
+				int tmp = atoi(val);
+				if (tmp >= 0 && tmp <= MAX_REACTOR_WORKERS) {
+					verto_globals.reactor_workers = tmp;
+				}
 			} else if (!strcasecmp(var, "kslog")) {
 				if (val) {
 					verto_globals.kslog_on = switch_true(val);
@@ -5468,6 +6257,8 @@ static int init(void)
 
 	verto_globals.running = 1;
 
+	reactor_start();
+
 	return 0;
 }
 
@@ -5693,6 +6484,7 @@ SWITCH_STANDARD_API(verto_function)
 	static const char usage_string[] = "USAGE:\n"
 		"--------------------------------------------------------------------------------\n"
 		"verto [status|xmlstatus|jsonstatus]\n"
+		"verto reactor\n"
 		"verto help\n"
 		"verto debug [0-10]\n"
 		"verto perm <sessid> <type> <value>\n"
@@ -5735,6 +6527,9 @@ SWITCH_STANDARD_API(verto_function)
 		}
 		status = SWITCH_STATUS_SUCCESS; 
 		goto done;
+	} else if (!strcasecmp(argv[0], "reactor")) {
+		reactor_status(stream);
+		goto done;
 	} else if (!strcasecmp(argv[0], "announce")) {
 		func = cmd_announce;
 	} else if (!strcasecmp(argv[0], "status")) {
@@ -6864,6 +7659,7 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_verto_load)
 	switch_console_set_complete("add verto debug-level");
 	switch_console_set_complete("add verto status");
 	switch_console_set_complete("add verto xmlstatus");
+	switch_console_set_complete("add verto reactor");
 
 	SWITCH_ADD_JSON_API(json_api_interface, "store", "JSON store", json_store_function, "");
 
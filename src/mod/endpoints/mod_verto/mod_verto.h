@@ -101,6 +101,38 @@ typedef enum {
 
 struct verto_profile_s;
 
+/* a verto.event serialized once and shared by every subscriber it is queued for */
+typedef struct verto_event_text_s {
+	char *params;
+	switch_size_t params_len;
+	char *channel;
+	switch_size_t channel_len;
+	int empty;
+	switch_atomic_t refs;
+} verto_event_text_t;
+
+/* event_queue entry, either a message built for this jsock or a shared event */
+typedef struct jsock_qmsg_s {
+	cJSON *json;
+	verto_event_text_t *text;
+	uint32_t id;
+	uint32_t serno;
+} jsock_qmsg_t;
+
+#define MAX_REACTORS 16
+#define MAX_REACTOR_WORKERS 128
+
+typedef struct verto_reactor_s {
+	int id;
+	int epfd;
+	switch_thread_t *thread;
+	switch_queue_t *dead_queue;
+	uint32_t connections;
+	uint64_t messages;
+	switch_time_t latency_total;
+	switch_time_t latency_max;
+} verto_reactor_t;
+
 struct jsock_s {
 	ks_socket_t client_socket;
 	switch_memory_pool_t *pool;
@@ -159,6 +191,24 @@ struct jsock_s {
 	int lost_events;
 	int ready;
 
+	verto_reactor_t *reactor;
+	uint8_t reactor_busy;
+	uint8_t reactor_again;
+	switch_time_t reactor_ready;
+	time_t reactor_input;
+	/* input a reactor worker has read but not handled yet */
+	uint8_t *rbuf;
+	switch_size_t rbuf_size;
+	switch_size_t rbuf_len;
+	/* the message being put together from fragments */
+	uint8_t *msg;
+	switch_size_t msg_size;
+	switch_size_t msg_len;
+	int msg_oc;
+	/* bytes of the #SPU speed test upload being timed */
+	int speed_size;
+	switch_time_t speed_start;
+
 	struct jsock_s *next;
 };
 
@@ -337,6 +387,9 @@ struct globals_s {
 
 	switch_log_level_t debug_level;
 
+	int reactor_threads;
+	int reactor_workers;
+
 };
 
 
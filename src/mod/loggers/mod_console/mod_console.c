@@ -83,11 +83,7 @@ static switch_log_json_format_t json_format = {
 
 static char *to_json_string(const switch_log_node_t *node)
 {
-	char *json_text = NULL;
-	cJSON *json = switch_log_node_to_json(node, node->level, &json_format, NULL);
-	json_text = cJSON_PrintUnformatted(json);
-	cJSON_Delete(json);
-	return json_text;
+	return switch_log_node_to_json_string(node, node->level, &json_format, NULL);
 }
 
 static void del_mapping(char *var)
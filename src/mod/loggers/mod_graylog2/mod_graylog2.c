@@ -85,11 +85,18 @@ static int to_graylog2_level(switch_log_level_t level)
  */
 static char *to_gelf(const switch_log_node_t *node, switch_log_level_t log_level)
 {
+	switch_json_writer_t w;
+	char buf[2048];
 	char *gelf_text = NULL;
-	cJSON *gelf = switch_log_node_to_json(node, to_graylog2_level(log_level), &globals.gelf_format, globals.session_fields);
-	cJSON_AddItemToObject(gelf, "_microtimestamp", cJSON_CreateNumber(node->timestamp));
-	gelf_text = cJSON_PrintUnformatted(gelf);
-	cJSON_Delete(gelf);
+
+	switch_json_writer_init(&w, buf, sizeof(buf));
+	switch_json_writer_object_start(&w);
+	switch_log_node_json_write(&w, node, to_graylog2_level(log_level), &globals.gelf_format, globals.session_fields);
+	switch_json_writer_add_number(&w, "_microtimestamp", node->timestamp);
+	switch_json_writer_object_end(&w);
+
+	gelf_text = switch_json_writer_dup(&w);
+	switch_json_writer_destroy(&w);
 	return gelf_text;
 }
 
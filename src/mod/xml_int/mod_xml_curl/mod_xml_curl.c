@@ -208,7 +208,7 @@ static switch_xml_t xml_url_fetch(const char *section, const char *tag_name, con
 	switch_uuid_format(uuid_str, &uuid);
 
 	switch_snprintf(filename, sizeof(filename), "%s%s%s.tmp.xml", SWITCH_GLOBAL_dirs.temp_dir, SWITCH_PATH_SEPARATOR, uuid_str);
-	curl_handle = switch_curl_easy_init();
+	curl_handle = switch_curl_easy_acquire(binding->use_get_style == 1 ? uri : dynamic_url);
 	headers = switch_curl_slist_append(headers, "Content-Type: application/x-www-form-urlencoded");
 
 	if (!strncasecmp(binding->url, "https", 5)) {
@@ -296,7 +296,7 @@ static switch_xml_t xml_url_fetch(const char *section, const char *tag_name, con
 		}
 
 		switch_curl_easy_getinfo(curl_handle, CURLINFO_RESPONSE_CODE, &httpRes);
-		switch_curl_easy_cleanup(curl_handle);
+		switch_curl_easy_release(curl_handle);
 		switch_curl_slist_free_all(headers);
 		switch_curl_slist_free_all(slist);
 		close(config_data.fd);
@@ -188,8 +188,20 @@ struct switch_channel {
 	switch_device_node_t *device_node;
 	char *device_id;
 	switch_event_t *log_tags;
+	switch_mutex_t *watch_mutex;
+	switch_channel_watcher_t *watchers[SWITCH_CHANNEL_MAX_WATCHERS];
 };
 
+struct switch_channel_watcher {
+	switch_memory_pool_t *pool;
+	switch_mutex_t *mutex;
+	switch_thread_cond_t *cond;
+	uint32_t signalled;
+	uint32_t refs;
+};
+
+static void switch_channel_signal_watchers(switch_channel_t *channel);
+
 static void process_device_hup(switch_channel_t *channel);
 static void switch_channel_check_device_state(switch_channel_t *channel, switch_channel_callstate_t callstate);
 
@@ -465,6 +477,7 @@ SWITCH_DECLARE(switch_status_t) switch_channel_alloc(switch_channel_t **channel,
 	switch_mutex_init(&(*channel)->state_mutex, SWITCH_MUTEX_NESTED, pool);
 	switch_mutex_init(&(*channel)->thread_mutex, SWITCH_MUTEX_NESTED, pool);
 	switch_mutex_init(&(*channel)->profile_mutex, SWITCH_MUTEX_NESTED, pool);
+	switch_mutex_init(&(*channel)->watch_mutex, SWITCH_MUTEX_NESTED, pool);
 	(*channel)->hangup_cause = SWITCH_CAUSE_NONE;
 	(*channel)->name = "";
 	(*channel)->direction = (*channel)->logical_direction = direction;
@@ -739,6 +752,7 @@ SWITCH_DECLARE(void) switch_channel_flush_dtmf(switch_channel_t *channel)
 SWITCH_DECLARE(void) switch_channel_uninit(switch_channel_t *channel)
 {
 	void *pop;
+	int i;
 	switch_channel_flush_dtmf(channel);
 	while (switch_queue_trypop(channel->dtmf_log_queue, &pop) == SWITCH_STATUS_SUCCESS) {
 		switch_safe_free(pop);
@@ -752,6 +766,12 @@ SWITCH_DECLARE(void) switch_channel_uninit(switch_channel_t *channel)
 		switch_core_hash_destroy(&channel->app_flag_hash);
 	}
 
+	switch_mutex_lock(channel->watch_mutex);
+	for (i = 0; i < SWITCH_CHANNEL_MAX_WATCHERS; i++) {
+		switch_channel_watcher_release(&channel->watchers[i]);
+	}
+	switch_mutex_unlock(channel->watch_mutex);
+
 	switch_mutex_lock(channel->profile_mutex);
 	switch_event_destroy(&channel->variables);
 	switch_event_destroy(&channel->api_list);
@@ -1796,6 +1816,118 @@ SWITCH_DECLARE(switch_status_t) switch_channel_wait_for_flag(switch_channel_t *c
 	return SWITCH_STATUS_SUCCESS;
 }
 
+SWITCH_DECLARE(switch_status_t) switch_channel_watcher_create(switch_channel_watcher_t **watcher)
+{
+	switch_memory_pool_t *pool = NULL;
+	switch_channel_watcher_t *w;
+
+	if (switch_core_new_memory_pool(&pool) != SWITCH_STATUS_SUCCESS) {
+		return SWITCH_STATUS_MEMERR;
+	}
+
+	w = switch_core_alloc(pool, sizeof(*w));
+	w->pool = pool;
+	w->refs = 1;
+	switch_mutex_init(&w->mutex, SWITCH_MUTEX_NESTED, pool);
+	switch_thread_cond_create(&w->cond, pool);
+	*watcher = w;
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+SWITCH_DECLARE(void) switch_channel_watcher_release(switch_channel_watcher_t **watcher)
+{
+	switch_channel_watcher_t *w = *watcher;
+	uint32_t refs;
+
+	if (!w) {
+		return;
+	}
+
+	*watcher = NULL;
+
+	switch_mutex_lock(w->mutex);
+	refs = --w->refs;
+	switch_mutex_unlock(w->mutex);
+
+	if (!refs) {
+		switch_memory_pool_t *pool = w->pool;
+		switch_core_destroy_memory_pool(&pool);
+	}
+}
+
+SWITCH_DECLARE(switch_status_t) switch_channel_watch(switch_channel_t *channel, switch_channel_watcher_t *watcher)
+{
+	switch_status_t status = SWITCH_STATUS_FALSE;
+	int i;
+
+	switch_mutex_lock(channel->watch_mutex);
+	for (i = 0; i < SWITCH_CHANNEL_MAX_WATCHERS; i++) {
+		if (!channel->watchers[i]) {
+			switch_mutex_lock(watcher->mutex);
+			watcher->refs++;
+			switch_mutex_unlock(watcher->mutex);
+			channel->watchers[i] = watcher;
+			status = SWITCH_STATUS_SUCCESS;
+			break;
+		}
+	}
+	switch_mutex_unlock(channel->watch_mutex);
+
+	return status;
+}
+
+SWITCH_DECLARE(void) switch_channel_unwatch(switch_channel_t *channel, switch_channel_watcher_t *watcher)
+{
+	int i;
+
+	switch_mutex_lock(channel->watch_mutex);
+	for (i = 0; i < SWITCH_CHANNEL_MAX_WATCHERS; i++) {
+		if (channel->watchers[i] == watcher) {
+			switch_channel_watcher_release(&channel->watchers[i]);
+		}
+	}
+	switch_mutex_unlock(channel->watch_mutex);
+}
+
+SWITCH_DECLARE(void) switch_channel_watcher_signal(switch_channel_watcher_t *watcher)
+{
+	switch_mutex_lock(watcher->mutex);
+	watcher->signalled++;
+	switch_thread_cond_signal(watcher->cond);
+	switch_mutex_unlock(watcher->mutex);
+}
+
+SWITCH_DECLARE(switch_status_t) switch_channel_watcher_wait(switch_channel_watcher_t *watcher, uint32_t timeout_ms)
+{
+	switch_status_t status = SWITCH_STATUS_SUCCESS;
+
+	switch_mutex_lock(watcher->mutex);
+	if (!watcher->signalled) {
+		switch_thread_cond_timedwait(watcher->cond, watcher->mutex, (switch_interval_time_t) timeout_ms * 1000);
+	}
+	if (!watcher->signalled) {
+		status = SWITCH_STATUS_TIMEOUT;
+	}
+	watcher->signalled = 0;
+	switch_mutex_unlock(watcher->mutex);
+
+	return status;
+}
+
+static void switch_channel_signal_watchers(switch_channel_t *channel)
+{
+	int i;
+
+	switch_mutex_lock(channel->watch_mutex);
+	for (i = 0; i < SWITCH_CHANNEL_MAX_WATCHERS; i++) {
+		if (channel->watchers[i]) {
+			switch_channel_watcher_signal(channel->watchers[i]);
+		}
+	}
+	switch_mutex_unlock(channel->watch_mutex);
+}
+
 SWITCH_DECLARE(switch_status_t) switch_channel_wait_for_app_flag(switch_channel_t *channel,
 																 uint32_t app_flag,
 																 const char *key, switch_bool_t pres, uint32_t to)
@@ -2394,6 +2526,8 @@ SWITCH_DECLARE(switch_channel_state_t) switch_channel_perform_set_running_state(
 
 	switch_mutex_unlock(channel->state_mutex);
 
+	switch_channel_signal_watchers(channel);
+
 	return (switch_channel_state_t) SWITCH_STATUS_SUCCESS;
 }
 
@@ -2605,6 +2739,8 @@ SWITCH_DECLARE(switch_channel_state_t) switch_channel_perform_set_state(switch_c
 		if (state <= CS_DESTROY) {
 			switch_core_session_signal_state_change(channel->session);
 		}
+
+		switch_channel_signal_watchers(channel);
 	} else {
 		switch_log_printf(SWITCH_CHANNEL_ID_LOG, file, func, line, switch_channel_get_uuid(channel), SWITCH_LOG_WARNING,
 						  "(%s) Invalid State Change %s -> %s\n", channel->name, state_names[last_state], state_names[state]);
@@ -3495,6 +3631,8 @@ SWITCH_DECLARE(switch_status_t) switch_channel_perform_mark_ring_ready_value(swi
 
 		send_ind(channel, SWITCH_MESSAGE_RING_EVENT, file, func, line);
 
+		switch_channel_signal_watchers(channel);
+
 		return SWITCH_STATUS_SUCCESS;
 	}
 
@@ -3625,6 +3763,8 @@ SWITCH_DECLARE(switch_status_t) switch_channel_perform_mark_pre_answered(switch_
 
 		switch_core_media_check_autoadj(channel->session);
 
+		switch_channel_signal_watchers(channel);
+
 		return SWITCH_STATUS_SUCCESS;
 	}
 
@@ -3957,6 +4097,8 @@ SWITCH_DECLARE(switch_status_t) switch_channel_perform_mark_answered(switch_chan
 		switch_channel_set_flag_partner(channel, CF_RTT);
 	}
 
+	switch_channel_signal_watchers(channel);
+
 	return SWITCH_STATUS_SUCCESS;
 }
 
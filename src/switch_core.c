@@ -1909,6 +1909,9 @@ SWITCH_DECLARE(switch_status_t) switch_core_init(switch_core_flag_t flags, switc
 #endif
 
 	if (!runtime.cpu_count) runtime.cpu_count = 1;
+
+	switch_dsp_init();
+	switch_img_simd_init();
 	// SQLite是一个进程内的库，实现了自给自足的、无服务器的、零配置的、事务性的 SQL 数据库引擎。
 	if (sqlite3_initialize() != SQLITE_OK) {
 		*err = "FATAL ERROR! Could not initialize SQLite\n";
@@ -2025,12 +2028,17 @@ SWITCH_DECLARE(switch_status_t) switch_core_init(switch_core_flag_t flags, switc
 	runtime.tipping_point = 0;
 	runtime.timer_affinity = -1;
 	runtime.microseconds_per_tick = 20000;
+	runtime.prompt_cache_max_file_size = 10 * 1024 * 1024;
+	runtime.record_writer_flush_ms = 1000;
+	runtime.record_writer_max_lag_ms = 10000;
+	runtime.curl_pool_max_idle = 8;
 
 	if (flags & SCF_MINIMAL) return SWITCH_STATUS_SUCCESS;
 
 	switch_load_core_config("switch.conf");
 
 	switch_core_state_machine_init(runtime.memory_pool);
+	switch_ivr_record_writers_start(runtime.memory_pool);
 
 	switch_core_media_init();
 	switch_scheduler_task_thread_start();
@@ -2107,6 +2115,8 @@ static uint32_t d_30 = 30;
 static void switch_load_core_config(const char *file)
 {
 	switch_xml_t xml = NULL, cfg = NULL;
+	uint32_t video_encode_threads = 0, video_encode_max_pending = 2;
+	switch_bool_t video_encode_affinity = SWITCH_FALSE, video_encode_set = SWITCH_FALSE;
 
 	switch_core_hash_insert(runtime.ptimes, "ilbc", &d_30);
 	switch_core_hash_insert(runtime.ptimes, "isac", &d_30);
@@ -2180,6 +2190,14 @@ static void switch_load_core_config(const char *file)
 					} else {
 						switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "max-db-handles must be between 5 and 5000\n");
 					}
+				} else if (!strcasecmp(var, "max-db-handles-per-dsn")) {
+					long tmp = atol(val);
+
+					if (tmp >= 0 && tmp < 5001) {
+						runtime.max_db_handles_per_dsn = (uint32_t) tmp;
+					} else {
+						switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "max-db-handles-per-dsn must be between 0 and 5000\n");
+					}
 				} else if (!strcasecmp(var, "db-handle-timeout")) {
 					long tmp = atol(val);
 
@@ -2287,6 +2305,14 @@ static void switch_load_core_config(const char *file)
 					switch_time_set_cond_yield(switch_true(val));
 				} else if (!strcasecmp(var, "enable-timer-matrix")) {
 					switch_time_set_matrix(switch_true(val));
+				} else if (!strcasecmp(var, "timer-wheels") && !zstr(val)) {
+					if (!strcasecmp(val, "auto")) {
+						switch_time_set_timer_wheels(switch_core_cpu_count());
+					} else if (switch_is_number(val)) {
+						switch_time_set_timer_wheels((uint32_t) atoi(val));
+					} else {
+						switch_time_set_timer_wheels(switch_true(val) ? switch_core_cpu_count() : 0);
+					}
 				} else if (!strcasecmp(var, "max-sessions") && !zstr(val)) {
 					switch_core_session_limit(atoi(val));
 				} else if (!strcasecmp(var, "verbose-channel-events") && !zstr(val)) {
@@ -2371,6 +2397,25 @@ static void switch_load_core_config(const char *file)
 					switch_rtp_set_start_port((switch_port_t) atoi(val));
 				} else if (!strcasecmp(var, "rtp-end-port") && !zstr(val)) {
 					switch_rtp_set_end_port((switch_port_t) atoi(val));
+				} else if (!strcasecmp(var, "rtp-socket-pool-size") && !zstr(val)) {
+					int tmp = atoi(val);
+					if (tmp >= 0 && tmp <= 1024) {
+						switch_rtp_set_socket_pool_size((uint32_t) tmp);
+					} else {
+						switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "rtp-socket-pool-size must be between 0 and 1024\n");
+					}
+				} else if (!strcasecmp(var, "module-load-threads") && !zstr(val)) {
+					int tmp = atoi(val);
+					if (tmp >= 0 && tmp <= 64) {
+						runtime.module_load_threads = (uint32_t) tmp;
+					} else {
+						switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "module-load-threads must be between 0 and 64\n");
+					}
+				} else if (!strcasecmp(var, "dsp-implementation") && !zstr(val)) {
+					if (switch_dsp_set_impl(val) != SWITCH_STATUS_SUCCESS) {
+						switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "dsp-implementation %s is not supported here, using %s\n",
+										  val, switch_dsp_impl_name());
+					}
 				} else if (!strcasecmp(var, "rtp-port-usage-robustness") && switch_true(val)) {
 					runtime.port_alloc_flags |= SPF_ROBUST_UDP;
 				} else if (!strcasecmp(var, "core-db-name") && !zstr(val)) {
@@ -2437,10 +2482,88 @@ static void switch_load_core_config(const char *file)
 					}
 				} else if (!strcasecmp(var, "max-audio-channels") && !zstr(val)) {
 					switch_core_max_audio_channels(atoi(val));
+				} else if (!strcasecmp(var, "prompt-cache-size") && !zstr(val)) {
+					int tmp = atoi(val);
+					if (tmp >= 0) {
+						runtime.prompt_cache_size = (switch_size_t) tmp * 1024 * 1024;
+					} else {
+						switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "prompt-cache-size must be 0 or more megabytes\n");
+					}
+				} else if (!strcasecmp(var, "prompt-cache-max-file-size") && !zstr(val)) {
+					int tmp = atoi(val);
+					if (tmp > 0) {
+						runtime.prompt_cache_max_file_size = (switch_size_t) tmp * 1024;
+					} else {
+						switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "prompt-cache-max-file-size must be greater than 0 kilobytes\n");
+					}
+				} else if (!strcasecmp(var, "record-writer-threads") && !zstr(val)) {
+					int tmp = atoi(val);
+					if (tmp >= 0 && tmp <= SWITCH_MAX_RECORD_WRITER_THREADS) {
+						runtime.record_writer_threads = (uint32_t) tmp;
+					} else {
+						switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "record-writer-threads must be between 0 and %d\n", SWITCH_MAX_RECORD_WRITER_THREADS);
+					}
+				} else if (!strcasecmp(var, "record-writer-flush-ms") && !zstr(val)) {
+					int tmp = atoi(val);
+					if (tmp >= 20) {
+						runtime.record_writer_flush_ms = (uint32_t) tmp;
+					} else {
+						switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "record-writer-flush-ms must be at least 20\n");
+					}
+				} else if (!strcasecmp(var, "record-writer-max-lag-ms") && !zstr(val)) {
+					int tmp = atoi(val);
+					if (tmp >= 0) {
+						runtime.record_writer_max_lag_ms = (uint32_t) tmp;
+					} else {
+						switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "record-writer-max-lag-ms must be 0 or more\n");
+					}
+				} else if (!strcasecmp(var, "directory-negative-cache-ms") && !zstr(val)) {
+					int tmp = atoi(val);
+					if (tmp >= 0) {
+						runtime.directory_negative_cache_ms = (uint32_t) tmp;
+					} else {
+						switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "directory-negative-cache-ms must be 0 or more\n");
+					}
+				} else if (!strcasecmp(var, "directory-stale-cache-ms") && !zstr(val)) {
+					int tmp = atoi(val);
+					if (tmp >= 0) {
+						runtime.directory_stale_cache_ms = (uint32_t) tmp;
+					} else {
+						switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "directory-stale-cache-ms must be 0 or more\n");
+					}
+				} else if (!strcasecmp(var, "curl-pool-max-idle") && !zstr(val)) {
+					int tmp = atoi(val);
+					if (tmp >= 0 && tmp <= 64) {
+						runtime.curl_pool_max_idle = (uint32_t) tmp;
+					} else {
+						switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "curl-pool-max-idle must be between 0 and 64\n");
+					}
+				} else if (!strcasecmp(var, "video-encode-threads") && !zstr(val)) {
+					if (!strcasecmp(val, "auto")) {
+						video_encode_threads = switch_core_cpu_count();
+					} else if (switch_is_number(val) && atoi(val) >= 0) {
+						video_encode_threads = (uint32_t) atoi(val);
+					} else {
+						video_encode_threads = switch_true(val) ? switch_core_cpu_count() : 0;
+					}
+					video_encode_set = SWITCH_TRUE;
+				} else if (!strcasecmp(var, "video-encode-max-pending") && !zstr(val)) {
+					int tmp = atoi(val);
+					if (tmp >= 1 && tmp <= 30) {
+						video_encode_max_pending = (uint32_t) tmp;
+					} else {
+						switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "video-encode-max-pending must be between 1 and 30\n");
+					}
+				} else if (!strcasecmp(var, "video-encode-affinity")) {
+					video_encode_affinity = switch_true(val);
 				}
 			}
 		}
 
+		if (video_encode_set) {
+			switch_core_video_encode_pool_start(video_encode_threads, video_encode_max_pending, video_encode_affinity);
+		}
+
 		if (runtime.event_channel_key_separator == NULL) {
 			runtime.event_channel_key_separator = switch_core_strdup(runtime.memory_pool, ".");
 		}
@@ -3093,12 +3216,15 @@ SWITCH_DECLARE(switch_status_t) switch_core_destroy(void)
 
 	switch_loadable_module_shutdown();
 
+	switch_ivr_record_writers_stop();
+
 	switch_curl_destroy();
 
 	switch_ssl_destroy_ssl_locks();
 	EVP_cleanup();
 
 	switch_scheduler_task_thread_stop();
+	switch_core_video_encode_pool_stop();
 
 	switch_rtp_shutdown();
 	switch_msrp_destroy();
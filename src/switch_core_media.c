@@ -6879,8 +6879,7 @@ static void *SWITCH_THREAD_FUNC video_write_thread(switch_thread_t *thread, void
 
 	v_engine = &smh->engines[SWITCH_MEDIA_TYPE_VIDEO];
 
-	switch_mutex_lock(smh->write_mutex[SWITCH_MEDIA_TYPE_VIDEO]);
-	v_engine->thread_write_lock = switch_thread_self();
+	switch_core_media_lock_video_write(session);
 
 	
 	buf = switch_core_session_alloc(session, buflen);
@@ -7006,8 +7005,7 @@ static void *SWITCH_THREAD_FUNC video_write_thread(switch_thread_t *thread, void
 	}
 
 	
-	v_engine->thread_write_lock = 0;
-	switch_mutex_unlock(smh->write_mutex[SWITCH_MEDIA_TYPE_VIDEO]);
+	switch_core_media_unlock_video_write(session);
 
 	switch_channel_clear_flag(session->channel, CF_VIDEO_WRITING);
 	smh->video_write_thread_running = 0;
@@ -7068,6 +7066,41 @@ SWITCH_DECLARE(switch_status_t) switch_core_media_unlock_video_file(switch_core_
 	return SWITCH_STATUS_SUCCESS;
 }
 
+SWITCH_DECLARE(void) switch_core_media_lock_video_write(switch_core_session_t *session)
+{
+	switch_media_handle_t *smh;
+
+	switch_assert(session);
+
+	if (!(smh = session->media_handle)) {
+		return;
+	}
+
+	if (smh->write_mutex[SWITCH_MEDIA_TYPE_VIDEO]) {
+		switch_mutex_lock(smh->write_mutex[SWITCH_MEDIA_TYPE_VIDEO]);
+	}
+	smh->engines[SWITCH_MEDIA_TYPE_VIDEO].thread_write_lock = switch_thread_self();
+
+	/* frames the encode pool still has would otherwise be encoded alongside ours */
+	switch_core_video_encode_pool_flush(session);
+}
+
+SWITCH_DECLARE(void) switch_core_media_unlock_video_write(switch_core_session_t *session)
+{
+	switch_media_handle_t *smh;
+
+	switch_assert(session);
+
+	if (!(smh = session->media_handle)) {
+		return;
+	}
+
+	smh->engines[SWITCH_MEDIA_TYPE_VIDEO].thread_write_lock = 0;
+	if (smh->write_mutex[SWITCH_MEDIA_TYPE_VIDEO]) {
+		switch_mutex_unlock(smh->write_mutex[SWITCH_MEDIA_TYPE_VIDEO]);
+	}
+}
+
 SWITCH_DECLARE(switch_status_t) switch_core_media_set_video_file(switch_core_session_t *session, switch_file_handle_t *fh, switch_rw_t rw)
 {
 	switch_media_handle_t *smh;
@@ -14847,6 +14880,96 @@ SWITCH_DECLARE(void) switch_core_session_video_reinit(switch_core_session_t *ses
 
 }
 
+/* encode the image and write every packet it comes out as */
+static switch_status_t video_encode_frame(switch_core_session_t *session, switch_codec_t *codec, switch_frame_t *frame, switch_io_flag_t flags,
+										  int stream_id)
+{
+	switch_status_t status = SWITCH_STATUS_FALSE;
+	switch_status_t encode_status;
+
+	do {
+		frame->datalen = SWITCH_DEFAULT_VIDEO_SIZE;
+		encode_status = switch_core_codec_encode_video(codec, frame);
+
+		if (encode_status == SWITCH_STATUS_SUCCESS || encode_status == SWITCH_STATUS_MORE_DATA) {
+
+			switch_assert((encode_status == SWITCH_STATUS_SUCCESS && frame->m) || !frame->m);
+
+			if (frame->flags & SFF_PICTURE_RESET) {
+				switch_core_session_video_reinit(session);
+				frame->flags &= ~SFF_PICTURE_RESET;
+			}
+
+			if (frame->datalen == 0) break;
+
+			switch_set_flag(frame, SFF_RAW_RTP_PARSE_FRAME);
+			status = switch_core_session_write_encoded_video_frame(session, frame, flags, stream_id);
+		}
+
+	} while(status == SWITCH_STATUS_SUCCESS && encode_status == SWITCH_STATUS_MORE_DATA);
+
+	return status;
+}
+
+/* the video encode pool half of video_encode_frame, see switch_core_video_encode.c */
+static switch_status_t video_encode_job(switch_core_session_t *session, switch_frame_t *frame)
+{
+	switch_codec_t *codec;
+	switch_status_t status;
+
+	if (!session->media_handle || !(codec = switch_core_session_get_video_write_codec(session)) || !switch_core_codec_ready(codec)) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	frame->datalen = SWITCH_DEFAULT_VIDEO_SIZE;
+	status = switch_core_codec_encode_video(codec, frame);
+
+	if (status == SWITCH_STATUS_SUCCESS || status == SWITCH_STATUS_MORE_DATA) {
+		switch_assert((status == SWITCH_STATUS_SUCCESS && frame->m) || !frame->m);
+
+		if (frame->flags & SFF_PICTURE_RESET) {
+			switch_core_session_video_reinit(session);
+			frame->flags &= ~SFF_PICTURE_RESET;
+		}
+
+		if (frame->datalen) {
+			switch_set_flag(frame, SFF_RAW_RTP_PARSE_FRAME);
+		}
+	}
+
+	return status;
+}
+
+/* never waits for the write mutex, a pool thread has other sessions to serve */
+static switch_status_t video_encode_write(switch_core_session_t *session, switch_frame_t *packets, uint32_t count, switch_io_flag_t flags, int stream_id)
+{
+	switch_media_handle_t *smh = session->media_handle;
+	switch_status_t status = SWITCH_STATUS_SUCCESS;
+	uint32_t i;
+
+	if (!smh) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	if (smh->write_mutex[SWITCH_MEDIA_TYPE_VIDEO] && switch_mutex_trylock(smh->write_mutex[SWITCH_MEDIA_TYPE_VIDEO]) != SWITCH_STATUS_SUCCESS) {
+		return SWITCH_STATUS_INUSE;
+	}
+
+	if (smh->engines[SWITCH_MEDIA_TYPE_VIDEO].thread_write_lock) {
+		status = SWITCH_STATUS_INUSE;
+	} else {
+		for (i = 0; i < count && status == SWITCH_STATUS_SUCCESS; i++) {
+			status = switch_core_session_write_encoded_video_frame(session, &packets[i], flags, stream_id);
+		}
+	}
+
+	if (smh->write_mutex[SWITCH_MEDIA_TYPE_VIDEO]) {
+		switch_mutex_unlock(smh->write_mutex[SWITCH_MEDIA_TYPE_VIDEO]);
+	}
+
+	return status;
+}
+
 SWITCH_DECLARE(switch_status_t) switch_core_session_write_video_frame(switch_core_session_t *session, switch_frame_t *frame, switch_io_flag_t flags,
 																	  int stream_id)
 {
@@ -14855,8 +14978,7 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_write_video_frame(switch_cor
 	switch_codec_t *codec = switch_core_session_get_video_write_codec(session);
 	switch_timer_t *timer;
 	switch_media_handle_t *smh;
-	switch_image_t *dup_img = NULL, *img = frame->img;
-	switch_status_t encode_status;
+	switch_image_t *dup_img = NULL, *pool_img = NULL, *img = frame->img;
 	switch_frame_t write_frame = {0};
 	switch_rtp_engine_t *v_engine = NULL;
 	switch_bool_t need_free = SWITCH_FALSE;
@@ -15042,26 +15164,28 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_write_video_frame(switch_cor
 	switch_clear_flag(frame, SFF_SAME_IMAGE);
 	frame->m = 0;
 
-	do {
-		frame->datalen = SWITCH_DEFAULT_VIDEO_SIZE;
-		encode_status = switch_core_codec_encode_video(codec, frame);
-
-		if (encode_status == SWITCH_STATUS_SUCCESS || encode_status == SWITCH_STATUS_MORE_DATA) {
-
-			switch_assert((encode_status == SWITCH_STATUS_SUCCESS && frame->m) || !frame->m);
-
-			if (frame->flags & SFF_PICTURE_RESET) {
-				switch_core_session_video_reinit(session);
-				frame->flags &= ~SFF_PICTURE_RESET;
-			}
-
-			if (frame->datalen == 0) break;
+	/* a thread that took over writing for the session (file playback) keeps encoding itself */
+	if (switch_core_video_encode_pool_active() && !v_engine->thread_write_lock) {
+		if (img == dup_img) {
+			pool_img = dup_img;
+			dup_img = NULL;
+		} else if (need_free) {
+			pool_img = img;
+			frame->img = NULL;
+			need_free = SWITCH_FALSE;
+		} else {
+			switch_img_copy(img, &pool_img);
+		}
 
-			switch_set_flag(frame, SFF_RAW_RTP_PARSE_FRAME);
-			status = switch_core_session_write_encoded_video_frame(session, frame, flags, stream_id);
+		/* never fall back to encoding here, a pool thread may be using the encoder */
+		if (switch_core_video_encode_pool_submit(session, frame, &pool_img, flags, stream_id, video_encode_job, video_encode_write) == SWITCH_STATUS_SUCCESS) {
+			switch_goto_status(SWITCH_STATUS_SUCCESS, done);
 		}
 
-	} while(status == SWITCH_STATUS_SUCCESS && encode_status == SWITCH_STATUS_MORE_DATA);
+		switch_goto_status(SWITCH_STATUS_FALSE, done);
+	}
+
+	status = video_encode_frame(session, codec, frame, flags, stream_id);
 
  done:
 
@@ -15070,6 +15194,7 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_write_video_frame(switch_cor
 	}
 
 	switch_img_free(&dup_img);
+	switch_img_free(&pool_img);
 
 	if (need_free) {
 		switch_img_free(&frame->img);
@@ -16277,6 +16402,7 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_write_frame(switch_core_sess
 	if (session->bugs) {
 		switch_media_bug_t *bp;
 		int prune = 0;
+		int64_t ticket = -1;
 
 		switch_thread_rwlock_rdlock(session->bug_rwlock);
 		for (bp = session->bugs; bp; bp = bp->next) {
@@ -16300,9 +16426,7 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_write_frame(switch_core_sess
 			}
 
 			if (switch_test_flag(bp, SMBF_WRITE_STREAM)) {
-				switch_mutex_lock(bp->write_mutex);
-				switch_buffer_write(bp->raw_write_buffer, write_frame->data, write_frame->datalen);
-				switch_mutex_unlock(bp->write_mutex);
+				switch_core_media_bug_ring_feed(bp, SWITCH_RW_WRITE, write_frame->data, write_frame->datalen, &ticket);
 
 				if (bp->callback) {
 					ok = bp->callback(bp, bp->user_data, SWITCH_ABC_TYPE_WRITE);
@@ -16317,6 +16441,8 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_write_frame(switch_core_sess
 					if ((ok = bp->callback(bp, bp->user_data, SWITCH_ABC_TYPE_WRITE_REPLACE)) == SWITCH_TRUE) {
 						write_frame = bp->write_replace_frame_out;
 					}
+					/* the audio may have been changed, the bugs after this one get it stored apart */
+					ticket = -1;
 				}
 			}
 
@@ -35,6 +35,259 @@
 #include "switch.h"
 #include "private/switch_core_pvt.h"
 
+/* Each direction of the session has one ring of frames shared by all of its bugs.  A frame is copied in once and
+   tagged with the bit of every bug that should see it, the tags are the reference count of the slot: a bug drops its
+   bit when it has read the frame and a slot is free again once no bit is left.  A bug that falls more than the length
+   of the ring behind loses the oldest frames, that is counted as an overrun against it. */
+
+#define RING_SLOT(_r, _s) (&(_r)->slots[(_s) % SWITCH_MEDIA_BUG_RING_FRAMES])
+
+static int media_bug_ring_attach(switch_core_session_t *session, switch_rw_t rw)
+{
+	switch_media_bug_ring_t *ring;
+	int bit = -1, x;
+
+	if (!(ring = session->bug_ring[rw])) {
+		ring = switch_core_session_alloc(session, sizeof(*ring));
+		switch_mutex_init(&ring->mutex, SWITCH_MUTEX_NESTED, session->pool);
+		session->bug_ring[rw] = ring;
+	}
+
+	switch_mutex_lock(ring->mutex);
+	for (x = 0; x < SWITCH_MEDIA_BUG_RING_BUGS; x++) {
+		if (!(ring->used & ((uint64_t) 1 << x))) {
+			ring->used |= ((uint64_t) 1 << x);
+			memset(&ring->cursors[x], 0, sizeof(ring->cursors[x]));
+			ring->cursors[x].seq = ring->head;
+			bit = x;
+			break;
+		}
+	}
+	switch_mutex_unlock(ring->mutex);
+
+	return bit;
+}
+
+static void media_bug_ring_clear(switch_media_bug_ring_t *ring, int bit)
+{
+	switch_media_bug_ring_cursor_t *cursor = &ring->cursors[bit];
+	uint32_t seq = cursor->seq;
+
+	if (ring->head - seq > SWITCH_MEDIA_BUG_RING_FRAMES) {
+		seq = ring->head - SWITCH_MEDIA_BUG_RING_FRAMES;
+	}
+
+	for (; cursor->frames && seq != ring->head; seq++) {
+		switch_media_bug_ring_slot_t *slot = RING_SLOT(ring, seq);
+
+		if ((slot->mask & ((uint64_t) 1 << bit))) {
+			slot->mask &= ~((uint64_t) 1 << bit);
+			cursor->frames--;
+		}
+	}
+
+	cursor->seq = ring->head;
+	cursor->offset = 0;
+	cursor->pending = 0;
+	cursor->frames = 0;
+}
+
+static void media_bug_ring_detach(switch_media_bug_t *bug, switch_rw_t rw)
+{
+	switch_media_bug_ring_t *ring;
+	int bit = bug->ring_bit[rw];
+
+	bug->ring_bit[rw] = -1;
+
+	if (bit < 0 || !bug->session || !(ring = bug->session->bug_ring[rw])) {
+		return;
+	}
+
+	switch_mutex_lock(ring->mutex);
+	media_bug_ring_clear(ring, bit);
+	ring->used &= ~((uint64_t) 1 << bit);
+	switch_mutex_unlock(ring->mutex);
+}
+
+static switch_media_bug_ring_slot_t *media_bug_ring_push(switch_media_bug_ring_t *ring, const void *data, uint32_t datalen)
+{
+	switch_media_bug_ring_slot_t *slot = RING_SLOT(ring, ring->head);
+	int bit;
+
+	for (bit = 0; slot->mask && bit < SWITCH_MEDIA_BUG_RING_BUGS; bit++) {
+		switch_media_bug_ring_cursor_t *cursor = &ring->cursors[bit];
+
+		if (!(slot->mask & ((uint64_t) 1 << bit))) {
+			continue;
+		}
+
+		slot->mask &= ~((uint64_t) 1 << bit);
+
+		if (cursor->seq == slot->seq) {
+			cursor->pending -= slot->datalen - cursor->offset;
+		} else {
+			cursor->pending -= slot->datalen;
+		}
+
+		if ((int32_t) (cursor->seq - slot->seq) <= 0) {
+			cursor->seq = slot->seq + 1;
+			cursor->offset = 0;
+		}
+
+		cursor->frames--;
+		cursor->overruns++;
+	}
+
+	if (slot->buflen < datalen) {
+		void *mem = realloc(slot->data, datalen);
+		switch_assert(mem);
+		slot->data = mem;
+		slot->buflen = datalen;
+	}
+
+	memcpy(slot->data, data, datalen);
+	slot->datalen = datalen;
+	slot->seq = ring->head++;
+
+	return slot;
+}
+
+static switch_size_t media_bug_ring_read(switch_media_bug_t *bug, switch_rw_t rw, void *data, switch_size_t len)
+{
+	switch_media_bug_ring_t *ring = bug->session->bug_ring[rw];
+	switch_media_bug_ring_cursor_t *cursor;
+	uint64_t mask;
+	switch_size_t got = 0;
+
+	if (bug->ring_bit[rw] < 0 || !ring) {
+		return 0;
+	}
+
+	cursor = &ring->cursors[bug->ring_bit[rw]];
+	mask = (uint64_t) 1 << bug->ring_bit[rw];
+
+	switch_mutex_lock(ring->mutex);
+
+	if (ring->head - cursor->seq > SWITCH_MEDIA_BUG_RING_FRAMES) {
+		cursor->seq = ring->head - SWITCH_MEDIA_BUG_RING_FRAMES;
+		cursor->offset = 0;
+	}
+
+	while (len && cursor->frames && cursor->seq != ring->head) {
+		switch_media_bug_ring_slot_t *slot = RING_SLOT(ring, cursor->seq);
+		uint32_t bytes;
+
+		if (!(slot->mask & mask)) {
+			cursor->seq++;
+			cursor->offset = 0;
+			continue;
+		}
+
+		bytes = slot->datalen - cursor->offset;
+
+		if (bytes > len) {
+			bytes = (uint32_t) len;
+		}
+
+		if (data) {
+			memcpy((uint8_t *) data + got, slot->data + cursor->offset, bytes);
+		}
+
+		got += bytes;
+		len -= bytes;
+		cursor->offset += bytes;
+		cursor->pending -= bytes;
+
+		if (cursor->offset == slot->datalen) {
+			slot->mask &= ~mask;
+			cursor->frames--;
+			cursor->seq++;
+			cursor->offset = 0;
+		}
+	}
+
+	switch_mutex_unlock(ring->mutex);
+
+	return got;
+}
+
+static switch_size_t media_bug_ring_inuse(switch_media_bug_t *bug, switch_rw_t rw)
+{
+	switch_media_bug_ring_t *ring = bug->session->bug_ring[rw];
+	switch_size_t inuse;
+
+	if (bug->ring_bit[rw] < 0 || !ring) {
+		return 0;
+	}
+
+	switch_mutex_lock(ring->mutex);
+	inuse = ring->cursors[bug->ring_bit[rw]].pending;
+	switch_mutex_unlock(ring->mutex);
+
+	return inuse;
+}
+
+void switch_core_media_bug_ring_feed(switch_media_bug_t *bug, switch_rw_t rw, const void *data, uint32_t datalen, int64_t *ticket)
+{
+	switch_media_bug_ring_t *ring = bug->session->bug_ring[rw];
+	switch_media_bug_ring_slot_t *slot = NULL;
+	switch_media_bug_ring_cursor_t *cursor;
+	uint64_t mask;
+
+	if (bug->ring_bit[rw] < 0 || !ring || !datalen) {
+		return;
+	}
+
+	cursor = &ring->cursors[bug->ring_bit[rw]];
+	mask = (uint64_t) 1 << bug->ring_bit[rw];
+
+	switch_mutex_lock(ring->mutex);
+
+	/* the same frame going to several bugs is only stored once, the ticket names the slot that already holds it */
+	if (ticket && *ticket >= 0) {
+		switch_media_bug_ring_slot_t *last = RING_SLOT(ring, (uint32_t) *ticket);
+
+		if (last->seq == (uint32_t) *ticket && ring->head - last->seq <= SWITCH_MEDIA_BUG_RING_FRAMES) {
+			slot = last;
+		}
+	}
+
+	if (!slot) {
+		slot = media_bug_ring_push(ring, data, datalen);
+
+		if (ticket) {
+			*ticket = slot->seq;
+		}
+	}
+
+	if (!(slot->mask & mask) && (int32_t) (slot->seq - cursor->seq) >= 0) {
+		slot->mask |= mask;
+		cursor->pending += slot->datalen;
+		cursor->frames++;
+	}
+
+	switch_mutex_unlock(ring->mutex);
+}
+
+void switch_core_media_bug_ring_destroy(switch_core_session_t *session)
+{
+	int rw, x;
+
+	for (rw = 0; rw < 2; rw++) {
+		switch_media_bug_ring_t *ring = session->bug_ring[rw];
+
+		if (!ring) {
+			continue;
+		}
+
+		for (x = 0; x < SWITCH_MEDIA_BUG_RING_FRAMES; x++) {
+			switch_safe_free(ring->slots[x].data);
+		}
+
+		session->bug_ring[rw] = NULL;
+	}
+}
+
 static void switch_core_media_bug_destroy(switch_media_bug_t **bug)
 {
 	switch_event_t *event = NULL;
@@ -73,12 +326,11 @@ static void switch_core_media_bug_destroy(switch_media_bug_t **bug)
 		switch_clear_flag(bp->session->video_read_codec, SWITCH_CODEC_FLAG_VIDEO_PATCHING);
 	}
 
-	if (bp->raw_read_buffer) {
-		switch_buffer_destroy(&bp->raw_read_buffer);
-	}
+	media_bug_ring_detach(bp, SWITCH_RW_READ);
+	media_bug_ring_detach(bp, SWITCH_RW_WRITE);
 
-	if (bp->raw_write_buffer) {
-		switch_buffer_destroy(&bp->raw_write_buffer);
+	if (bp->resampler) {
+		switch_resample_destroy(&bp->resampler);
 	}
 
 	if (switch_event_create(&event, SWITCH_EVENT_MEDIA_BUG_STOP) == SWITCH_STATUS_SUCCESS) {
@@ -184,19 +436,18 @@ SWITCH_DECLARE(void *) switch_core_media_bug_get_user_data(switch_media_bug_t *b
 
 SWITCH_DECLARE(void) switch_core_media_bug_flush(switch_media_bug_t *bug)
 {
+	int rw;
 
 	bug->record_pre_buffer_count = 0;
 
-	if (bug->raw_read_buffer) {
-		switch_mutex_lock(bug->read_mutex);
-		switch_buffer_zero(bug->raw_read_buffer);
-		switch_mutex_unlock(bug->read_mutex);
-	}
+	for (rw = SWITCH_RW_READ; rw <= SWITCH_RW_WRITE; rw++) {
+		switch_media_bug_ring_t *ring = bug->session->bug_ring[rw];
 
-	if (bug->raw_write_buffer) {
-		switch_mutex_lock(bug->write_mutex);
-		switch_buffer_zero(bug->raw_write_buffer);
-		switch_mutex_unlock(bug->write_mutex);
+		if (bug->ring_bit[rw] >= 0 && ring) {
+			switch_mutex_lock(ring->mutex);
+			media_bug_ring_clear(ring, bug->ring_bit[rw]);
+			switch_mutex_unlock(ring->mutex);
+		}
 	}
 
 	bug->record_frame_size = 0;
@@ -205,23 +456,45 @@ SWITCH_DECLARE(void) switch_core_media_bug_flush(switch_media_bug_t *bug)
 
 SWITCH_DECLARE(void) switch_core_media_bug_inuse(switch_media_bug_t *bug, switch_size_t *readp, switch_size_t *writep)
 {
-	if (switch_test_flag(bug, SMBF_READ_STREAM)) {
-		switch_mutex_lock(bug->read_mutex);
-		*readp = bug->raw_read_buffer ? switch_buffer_inuse(bug->raw_read_buffer) : 0;
-		switch_mutex_unlock(bug->read_mutex);
-	} else {
-		*readp = 0;
-	}
+	*readp = switch_test_flag(bug, SMBF_READ_STREAM) ? media_bug_ring_inuse(bug, SWITCH_RW_READ) : 0;
+	*writep = switch_test_flag(bug, SMBF_WRITE_STREAM) ? media_bug_ring_inuse(bug, SWITCH_RW_WRITE) : 0;
+}
 
-	if (switch_test_flag(bug, SMBF_WRITE_STREAM)) {
-		switch_mutex_lock(bug->write_mutex);
-		*writep = bug->raw_write_buffer ? switch_buffer_inuse(bug->raw_write_buffer) : 0;
-		switch_mutex_unlock(bug->write_mutex);
-	} else {
-		*writep = 0;
+SWITCH_DECLARE(void) switch_core_media_bug_get_stats(switch_media_bug_t *bug, switch_media_bug_stats_t *stats)
+{
+	int rw;
+
+	memset(stats, 0, sizeof(*stats));
+
+	for (rw = SWITCH_RW_READ; rw <= SWITCH_RW_WRITE; rw++) {
+		switch_media_bug_ring_t *ring = bug->session->bug_ring[rw];
+		switch_media_bug_ring_cursor_t *cursor;
+
+		if (bug->ring_bit[rw] < 0 || !ring) {
+			continue;
+		}
+
+		cursor = &ring->cursors[bug->ring_bit[rw]];
+
+		switch_mutex_lock(ring->mutex);
+		if (rw == SWITCH_RW_READ) {
+			stats->read_lag_bytes = cursor->pending;
+			stats->read_lag_frames = cursor->frames;
+			stats->read_overruns = cursor->overruns;
+		} else {
+			stats->write_lag_bytes = cursor->pending;
+			stats->write_lag_frames = cursor->frames;
+			stats->write_overruns = cursor->overruns;
+		}
+		switch_mutex_unlock(ring->mutex);
 	}
 }
 
+SWITCH_DECLARE(void) switch_core_media_bug_set_rate(switch_media_bug_t *bug, uint32_t rate)
+{
+	bug->rate = rate;
+}
+
 SWITCH_DECLARE(switch_status_t) switch_core_media_bug_set_pre_buffer_framecount(switch_media_bug_t *bug, uint32_t framecount)
 {
 	bug->record_pre_buffer_max = framecount;
@@ -251,11 +524,11 @@ SWITCH_DECLARE(switch_status_t) switch_core_media_bug_read(switch_media_bug_t *b
 		return SWITCH_STATUS_FALSE;
 	}
 
-	if ((!bug->raw_read_buffer && (!bug->raw_write_buffer || !switch_test_flag(bug, SMBF_WRITE_STREAM)))) {
+	if (!switch_test_flag(bug, SMBF_READ_STREAM) && !switch_test_flag(bug, SMBF_READ_PING) && !switch_test_flag(bug, SMBF_WRITE_STREAM)) {
 		switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(switch_core_media_bug_get_session(bug)), SWITCH_LOG_ERROR,
-				"%s Buffer Error (raw_read_buffer=%p, raw_write_buffer=%p, read=%s, write=%s)\n",
+				"%s Buffer Error (read_ring=%d, write_ring=%d, read=%s, write=%s)\n",
 			        switch_channel_get_name(bug->session->channel),
-				(void *)bug->raw_read_buffer, (void *)bug->raw_write_buffer,
+				bug->ring_bit[SWITCH_RW_READ], bug->ring_bit[SWITCH_RW_WRITE],
 				switch_test_flag(bug, SMBF_READ_STREAM) ? "yes" : "no",
 				switch_test_flag(bug, SMBF_WRITE_STREAM) ? "yes" : "no");
 		return SWITCH_STATUS_FALSE;
@@ -266,16 +539,12 @@ SWITCH_DECLARE(switch_status_t) switch_core_media_bug_read(switch_media_bug_t *b
 
 	if (switch_test_flag(bug, SMBF_READ_STREAM)) {
 		has_read = 1;
-		switch_mutex_lock(bug->read_mutex);
-		do_read = switch_buffer_inuse(bug->raw_read_buffer);
-		switch_mutex_unlock(bug->read_mutex);
+		do_read = media_bug_ring_inuse(bug, SWITCH_RW_READ);
 	}
 
 	if (switch_test_flag(bug, SMBF_WRITE_STREAM)) {
 		has_write = 1;
-		switch_mutex_lock(bug->write_mutex);
-		do_write = switch_buffer_inuse(bug->raw_write_buffer);
-		switch_mutex_unlock(bug->write_mutex);
+		do_write = media_bug_ring_inuse(bug, SWITCH_RW_WRITE);
 	}
 
 
@@ -292,10 +561,8 @@ SWITCH_DECLARE(switch_status_t) switch_core_media_bug_read(switch_media_bug_t *b
 	}
 
 	if (bug->record_frame_size && do_write > do_read && do_write > (bug->record_frame_size * 2)) {
-		switch_mutex_lock(bug->write_mutex);
-		switch_buffer_toss(bug->raw_write_buffer, bug->record_frame_size);
-		do_write = switch_buffer_inuse(bug->raw_write_buffer);
-		switch_mutex_unlock(bug->write_mutex);
+		media_bug_ring_read(bug, SWITCH_RW_WRITE, NULL, bug->record_frame_size);
+		do_write = media_bug_ring_inuse(bug, SWITCH_RW_WRITE);
 	}
 
 
@@ -336,31 +603,24 @@ SWITCH_DECLARE(switch_status_t) switch_core_media_bug_read(switch_media_bug_t *b
 	}
 
 	if (do_read) {
-		switch_mutex_lock(bug->read_mutex);
-		frame->datalen = (uint32_t) switch_buffer_read(bug->raw_read_buffer, frame->data, do_read);
+		frame->datalen = (uint32_t) media_bug_ring_read(bug, SWITCH_RW_READ, frame->data, do_read);
 		if (frame->datalen != do_read) {
 			switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(switch_core_media_bug_get_session(bug)), SWITCH_LOG_ERROR, "Framing Error Reading!\n");
 			switch_core_media_bug_flush(bug);
-			switch_mutex_unlock(bug->read_mutex);
 			return SWITCH_STATUS_FALSE;
 		}
-		switch_mutex_unlock(bug->read_mutex);
 	} else if (fill_read) {
 		frame->datalen = (uint32_t)bytes;
 		memset(frame->data, 255, frame->datalen);
 	}
 
 	if (do_write) {
-		switch_assert(bug->raw_write_buffer);
-		switch_mutex_lock(bug->write_mutex);
-		datalen = (uint32_t) switch_buffer_read(bug->raw_write_buffer, bug->data, do_write);
+		datalen = (uint32_t) media_bug_ring_read(bug, SWITCH_RW_WRITE, bug->data, do_write);
 		if (datalen != do_write) {
 			switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(switch_core_media_bug_get_session(bug)), SWITCH_LOG_ERROR, "Framing Error Writing!\n");
 			switch_core_media_bug_flush(bug);
-			switch_mutex_unlock(bug->write_mutex);
 			return SWITCH_STATUS_FALSE;
 		}
-		switch_mutex_unlock(bug->write_mutex);
 	} else if (fill_write) {
 		datalen = bytes;
 		memset(bug->data, 255, datalen);
@@ -437,6 +697,36 @@ SWITCH_DECLARE(switch_status_t) switch_core_media_bug_read(switch_media_bug_t *b
 		frame->channels = read_impl.number_of_channels;
 	}
 
+	/* only bugs that asked for another rate pay for a resampler, and only on the frame they actually read */
+	if (bug->rate && bug->rate != frame->rate) {
+		switch_size_t out;
+
+		if (bug->resampler && ((uint32_t) bug->resampler->from_rate != frame->rate || (uint32_t) bug->resampler->channels != frame->channels)) {
+			switch_resample_destroy(&bug->resampler);
+		}
+
+		if (!bug->resampler && switch_resample_create(&bug->resampler, frame->rate, bug->rate, frame->datalen, SWITCH_RESAMPLE_QUALITY,
+													  frame->channels) != SWITCH_STATUS_SUCCESS) {
+			switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(switch_core_media_bug_get_session(bug)), SWITCH_LOG_ERROR, "%s Unable to create resampler!\n",
+							  switch_channel_get_name(bug->session->channel));
+			return SWITCH_STATUS_FALSE;
+		}
+
+		switch_resample_process(bug->resampler, frame->data, frame->samples);
+		out = bug->resampler->to_len * 2 * frame->channels;
+
+		if (frame->buflen < out) {
+			switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(switch_core_media_bug_get_session(bug)), SWITCH_LOG_ERROR, "%s frame buffer too small!\n",
+							  switch_channel_get_name(bug->session->channel));
+			return SWITCH_STATUS_FALSE;
+		}
+
+		memcpy(frame->data, bug->resampler->to, out);
+		frame->datalen = (uint32_t) out;
+		frame->samples = bug->resampler->to_len;
+		frame->rate = bug->rate;
+	}
+
 	return SWITCH_STATUS_SUCCESS;
 }
 
@@ -792,7 +1082,6 @@ SWITCH_DECLARE(switch_status_t) switch_core_media_bug_push_spy_frame(switch_medi
 	return SWITCH_STATUS_FALSE;
 }
 
-#define MAX_BUG_BUFFER 1024 * 512
 SWITCH_DECLARE(switch_status_t) switch_core_media_bug_add(switch_core_session_t *session,
 														  const char *function,
 														  const char *target,
@@ -802,7 +1091,6 @@ SWITCH_DECLARE(switch_status_t) switch_core_media_bug_add(switch_core_session_t
 														  switch_media_bug_t **new_bug)
 {
 	switch_media_bug_t *bug, *bp;
-	switch_size_t bytes;
 	switch_event_t *event;
 	int tap_only = 1, punt = 0, added = 0;
 
@@ -892,24 +1180,34 @@ SWITCH_DECLARE(switch_status_t) switch_core_media_bug_add(switch_core_session_t
 
 	bug->stop_time = stop_time;
 
-	if (!(bytes = bug->read_impl.decoded_bytes_per_packet)) {
-		bytes = 320;
-	}
-	
 	if (!bug->flags) {
 		bug->flags = (SMBF_READ_STREAM | SMBF_WRITE_STREAM);
 	}
 
-	if (switch_test_flag(bug, SMBF_READ_STREAM) || switch_test_flag(bug, SMBF_READ_PING)) {
-		switch_buffer_create_dynamic(&bug->raw_read_buffer, bytes * SWITCH_BUFFER_BLOCK_FRAMES, bytes * SWITCH_BUFFER_START_FRAMES, MAX_BUG_BUFFER);
-		switch_mutex_init(&bug->read_mutex, SWITCH_MUTEX_NESTED, session->pool);
-	}
+	bug->ring_bit[SWITCH_RW_READ] = bug->ring_bit[SWITCH_RW_WRITE] = -1;
 
-	bytes = bug->write_impl.decoded_bytes_per_packet;
+	if (switch_test_flag(bug, SMBF_READ_STREAM) || switch_test_flag(bug, SMBF_WRITE_STREAM)) {
+		switch_thread_rwlock_wrlock(session->bug_rwlock);
+		if (switch_test_flag(bug, SMBF_READ_STREAM)) {
+			bug->ring_bit[SWITCH_RW_READ] = media_bug_ring_attach(session, SWITCH_RW_READ);
+		}
+		if (switch_test_flag(bug, SMBF_WRITE_STREAM)) {
+			bug->ring_bit[SWITCH_RW_WRITE] = media_bug_ring_attach(session, SWITCH_RW_WRITE);
+		}
+		switch_thread_rwlock_unlock(session->bug_rwlock);
 
-	if (switch_test_flag(bug, SMBF_WRITE_STREAM)) {
-		switch_buffer_create_dynamic(&bug->raw_write_buffer, bytes * SWITCH_BUFFER_BLOCK_FRAMES, bytes * SWITCH_BUFFER_START_FRAMES, MAX_BUG_BUFFER);
-		switch_mutex_init(&bug->write_mutex, SWITCH_MUTEX_NESTED, session->pool);
+		if ((switch_test_flag(bug, SMBF_READ_STREAM) && bug->ring_bit[SWITCH_RW_READ] < 0) ||
+			(switch_test_flag(bug, SMBF_WRITE_STREAM) && bug->ring_bit[SWITCH_RW_WRITE] < 0)) {
+			switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_ERROR, "Too many media bugs on %s, at most %d can tap the audio\n",
+							  switch_channel_get_name(session->channel), SWITCH_MEDIA_BUG_RING_BUGS);
+			media_bug_ring_detach(bug, SWITCH_RW_READ);
+			media_bug_ring_detach(bug, SWITCH_RW_WRITE);
+			return SWITCH_STATUS_GENERR;
+		}
+	}
+
+	if (switch_test_flag(bug, SMBF_READ_STREAM) || switch_test_flag(bug, SMBF_READ_PING)) {
+		switch_mutex_init(&bug->read_mutex, SWITCH_MUTEX_NESTED, session->pool);
 	}
 
 	if ((bug->flags & SMBF_THREAD_LOCK)) {
@@ -1219,13 +1517,21 @@ SWITCH_DECLARE(switch_status_t) switch_core_media_bug_enumerate(switch_core_sess
 		switch_thread_rwlock_rdlock(session->bug_rwlock);
 		for (bp = session->bugs; bp; bp = bp->next) {
 			int thread_locked = (bp->thread_id && bp->thread_id == switch_thread_self());
+			switch_media_bug_stats_t stats;
+
+			switch_core_media_bug_get_stats(bp, &stats);
 			stream->write_function(stream,
 								   " <media-bug>\n"
 								   "  <function>%s</function>\n"
 								   "  <target>%s</target>\n"
 								   "  <thread-locked>%d</thread-locked>\n"
+								   "  <read-lag-frames>%u</read-lag-frames>\n"
+								   "  <read-overruns>%u</read-overruns>\n"
+								   "  <write-lag-frames>%u</write-lag-frames>\n"
+								   "  <write-overruns>%u</write-overruns>\n"
 								   " </media-bug>\n",
-								   bp->function, bp->target, thread_locked);
+								   bp->function, bp->target, thread_locked,
+								   stats.read_lag_frames, stats.read_overruns, stats.write_lag_frames, stats.write_overruns);
 
 		}
 		switch_thread_rwlock_unlock(session->bug_rwlock);
@@ -35,19 +35,30 @@
 #include <switch.h>
 #include "private/switch_core_pvt.h"
 
+/* Freed ports are held back for this many releases before they can be handed out again */
+#define PORT_QUARANTINE_LEN 32
+
 struct switch_core_port_allocator {
 	char *ip;
 	switch_port_t start;
 	switch_port_t end;
-	switch_port_t next;
-	int8_t *track;
+	uint32_t *track;			/* one bit per port slot, set while allocated or quarantined */
+	uint32_t track_words;
 	uint32_t track_len;
 	uint32_t track_used;
+	uint32_t *quarantine;		/* ring of recently freed slots, their bits stay set until they fall out */
+	uint32_t quarantine_len;
+	uint32_t quarantine_head;
+	uint32_t quarantine_count;
 	switch_port_flag_t flags;
 	switch_mutex_t *mutex;
 	switch_memory_pool_t *pool;
 };
 
+#define track_test(_a, _i) ((_a)->track[(_i) >> 5] & (1U << ((_i) & 31)))
+#define track_set(_a, _i) (_a)->track[(_i) >> 5] |= (1U << ((_i) & 31))
+#define track_clear(_a, _i) (_a)->track[(_i) >> 5] &= ~(1U << ((_i) & 31))
+
 SWITCH_DECLARE(switch_status_t) switch_core_port_allocator_new(const char *ip, switch_port_t start,
 															   switch_port_t end, switch_port_flag_t flags, switch_core_port_allocator_t **new_allocator)
 {
@@ -101,10 +112,21 @@ SWITCH_DECLARE(switch_status_t) switch_core_port_allocator_new(const char *ip, s
 		alloc->track_len /= 2;
 	}
 
-	alloc->track = switch_core_alloc(pool, (alloc->track_len + 2) * sizeof(switch_byte_t));
+	alloc->track_words = (alloc->track_len + 31) / 32;
+	alloc->track = switch_core_alloc(pool, alloc->track_words * sizeof(uint32_t));
+
+	/* slots past the end of the range in the last word are never free */
+	if ((alloc->track_len % 32)) {
+		alloc->track[alloc->track_words - 1] = ~((1U << (alloc->track_len % 32)) - 1);
+	}
+
+	/* keep at least half of a small range usable */
+	alloc->quarantine_len = alloc->track_len / 2 < PORT_QUARANTINE_LEN ? alloc->track_len / 2 : PORT_QUARANTINE_LEN;
+	if (alloc->quarantine_len) {
+		alloc->quarantine = switch_core_alloc(pool, alloc->quarantine_len * sizeof(uint32_t));
+	}
 
 	alloc->start = start;
-	alloc->next = start;
 	alloc->end = end;
 
 
@@ -140,62 +162,126 @@ static switch_bool_t test_port(switch_core_port_allocator_t *alloc, int type, sw
 	return r;
 }
 
+/* index of the lowest set bit, v must not be 0 */
+static inline uint32_t lowest_bit(uint32_t v)
+{
+	static const uint8_t debruijn[32] = {
+		0, 1, 28, 2, 29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4, 8,
+		31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6, 11, 5, 10, 9
+	};
+
+	return debruijn[((uint32_t)((v & -v) * 0x077CB531U)) >> 27];
+}
+
+/* Find the first free slot at or after index, wrapping around. Whole words are skipped at a time
+   so this is O(1) amortized as long as the range isn't close to full. */
+static switch_bool_t find_free_slot(switch_core_port_allocator_t *alloc, uint32_t index, uint32_t *slot)
+{
+	uint32_t word = index >> 5;
+	uint32_t n;
+
+	for (n = 0; n <= alloc->track_words; n++) {
+		uint32_t w = (word + n) % alloc->track_words;
+		uint32_t avail = ~alloc->track[w];
+
+		if (n == 0) {
+			avail &= ~((1U << (index & 31)) - 1);
+		} else if (n == alloc->track_words) {
+			avail &= (1U << (index & 31)) - 1;
+		}
+
+		if (avail) {
+			*slot = (w << 5) + lowest_bit(avail);
+			return SWITCH_TRUE;
+		}
+	}
+
+	return SWITCH_FALSE;
+}
+
+/* Hold a slot back, releasing the oldest quarantined one if the ring is full */
+static void quarantine_slot(switch_core_port_allocator_t *alloc, uint32_t index)
+{
+	uint32_t pos;
+
+	if (!alloc->quarantine_len) {
+		track_clear(alloc, index);
+		return;
+	}
+
+	if (alloc->quarantine_count == alloc->quarantine_len) {
+		track_clear(alloc, alloc->quarantine[alloc->quarantine_head]);
+		alloc->quarantine_head = (alloc->quarantine_head + 1) % alloc->quarantine_len;
+		alloc->quarantine_count--;
+	}
+
+	pos = (alloc->quarantine_head + alloc->quarantine_count) % alloc->quarantine_len;
+	alloc->quarantine[pos] = index;
+	alloc->quarantine_count++;
+}
+
+/* Give the oldest quarantined slot back, used when nothing else is free */
+static switch_bool_t unquarantine_slot(switch_core_port_allocator_t *alloc)
+{
+	if (!alloc->quarantine_count) {
+		return SWITCH_FALSE;
+	}
+
+	track_clear(alloc, alloc->quarantine[alloc->quarantine_head]);
+	alloc->quarantine_head = (alloc->quarantine_head + 1) % alloc->quarantine_len;
+	alloc->quarantine_count--;
+
+	return SWITCH_TRUE;
+}
+
 SWITCH_DECLARE(switch_status_t) switch_core_port_allocator_request_port(switch_core_port_allocator_t *alloc, switch_port_t *port_ptr)
 {
 	switch_port_t port = 0;
 	switch_status_t status = SWITCH_STATUS_FALSE;
 	int even = switch_test_flag(alloc, SPF_EVEN);
 	int odd = switch_test_flag(alloc, SPF_ODD);
+	uint32_t tries = 0;
 
 	switch_mutex_lock(alloc->mutex);
 	srand((unsigned) ((unsigned) (intptr_t) port_ptr + (unsigned) (intptr_t) switch_thread_self() + switch_micro_time_now()));
 
-	while (alloc->track_used < alloc->track_len) {
+	while (alloc->track_used < alloc->track_len && tries++ < alloc->track_len) {
 		uint32_t index;
-		uint32_t tries = 0;
-
-		/* randomly pick a port */
-		index = rand() % alloc->track_len;
+		switch_bool_t r = SWITCH_TRUE;
 
-		/* if it is used walk up the list to find a free one */
-		while (alloc->track[index] && tries < alloc->track_len) {
-			tries++;
-			if (alloc->track[index] < 0) {
-				alloc->track[index]++;
-			}
-			if (++index >= alloc->track_len) {
-				index = 0;
+		/* randomly pick a port, if it is used take the next free one after it */
+		if (!find_free_slot(alloc, rand() % alloc->track_len, &index)) {
+			if (unquarantine_slot(alloc)) {
+				continue;
 			}
+			break;
 		}
 
-		if (tries < alloc->track_len) {
-			switch_bool_t r = SWITCH_TRUE;
+		if ((even && odd)) {
+			port = (switch_port_t) (index + alloc->start);
+		} else {
+			port = (switch_port_t) (index + (alloc->start / 2));
+			port *= 2;
+		}
 
-			if ((even && odd)) {
-				port = (switch_port_t) (index + alloc->start);
-			} else {
-				port = (switch_port_t) (index + (alloc->start / 2));
-				port *= 2;
-			}
+		if ((alloc->flags & SPF_ROBUST_UDP)) {
+			r = test_port(alloc, SOCK_DGRAM, port);
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "UDP port robustness check for port %d %s\n", port, r ? "pass" : "fail");
+		}
 
-			if ((alloc->flags & SPF_ROBUST_UDP)) {
-				r = test_port(alloc, SOCK_DGRAM, port);
-				switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "UDP port robustness check for port %d %s\n", port, r ? "pass" : "fail");
-			}
+		if ((alloc->flags & SPF_ROBUST_TCP)) {
+			r = test_port(alloc, SOCK_STREAM, port);
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "TCP port robustness check for port %d %s\n", port, r ? "pass" : "fail");
+		}
 
-			if ((alloc->flags & SPF_ROBUST_TCP)) {
-				r = test_port(alloc, SOCK_STREAM, port);
-				switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "TCP port robustness check for port %d %s\n", port, r ? "pass" : "fail");
-			}
+		track_set(alloc, index);
 
-			if (r) {
-				alloc->track[index] = 1;
-				alloc->track_used++;
-				status = SWITCH_STATUS_SUCCESS;
-				goto end;
-			} else {
-				alloc->track[index] = -4;
-			}
+		if (r) {
+			alloc->track_used++;
+			status = SWITCH_STATUS_SUCCESS;
+			goto end;
+		} else {
+			quarantine_slot(alloc, index);
 		}
 	}
 
@@ -220,7 +306,7 @@ SWITCH_DECLARE(switch_status_t) switch_core_port_allocator_free_port(switch_core
 	switch_status_t status = SWITCH_STATUS_FALSE;
 	int even = switch_test_flag(alloc, SPF_EVEN);
 	int odd = switch_test_flag(alloc, SPF_ODD);
-	int index;
+	uint32_t index;
 
 	if (port < alloc->start) {
 		return SWITCH_STATUS_GENERR;
@@ -232,17 +318,40 @@ SWITCH_DECLARE(switch_status_t) switch_core_port_allocator_free_port(switch_core
 		index /= 2;
 	}
 
+	if (index >= alloc->track_len) {
+		return SWITCH_STATUS_GENERR;
+	}
+
 	switch_mutex_lock(alloc->mutex);
-	if (alloc->track[index] > 0) {
-		alloc->track[index] = -4;
-		alloc->track_used--;
-		status = SWITCH_STATUS_SUCCESS;
+	if (track_test(alloc, index)) {
+		uint32_t i;
+
+		/* a quarantined slot was never handed out, don't count it twice */
+		for (i = 0; i < alloc->quarantine_count; i++) {
+			if (alloc->quarantine[(alloc->quarantine_head + i) % alloc->quarantine_len] == index) {
+				break;
+			}
+		}
+
+		if (i == alloc->quarantine_count) {
+			quarantine_slot(alloc, index);
+			alloc->track_used--;
+			status = SWITCH_STATUS_SUCCESS;
+		}
 	}
 	switch_mutex_unlock(alloc->mutex);
 
 	return status;
 }
 
+SWITCH_DECLARE(void) switch_core_port_allocator_usage(switch_core_port_allocator_t *alloc, uint32_t *used, uint32_t *total)
+{
+	switch_mutex_lock(alloc->mutex);
+	*used = alloc->track_used;
+	*total = alloc->track_len;
+	switch_mutex_unlock(alloc->mutex);
+}
+
 SWITCH_DECLARE(void) switch_core_port_allocator_destroy(switch_core_port_allocator_t **alloc)
 {
 	switch_memory_pool_t *pool = (*alloc)->pool;
@@ -0,0 +1,750 @@
+/*
+ * FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ * Copyright (C) 2005-2018, Anthony Minessale II <anthm@freeswitch.org>
+ *
+ * Version: MPL 1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ *
+ * The Initial Developer of the Original Code is
+ * Anthony Minessale II <anthm@freeswitch.org>
+ * Portions created by the Initial Developer are Copyright (C)
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *
+ * Anthony Minessale II <anthm@freeswitch.org>
+ *
+ *
+ * switch_core_prompt_cache.c -- Shared cache of decoded prompts for file playback
+ *
+ */
+
+#include <switch.h>
+#include "private/switch_core_pvt.h"
+
+#ifdef WIN32
+#undef SWITCH_MOD_DECLARE_DATA
+#define SWITCH_MOD_DECLARE_DATA __declspec(dllexport)
+#endif
+SWITCH_MODULE_LOAD_FUNCTION(core_prompt_cache_load);
+SWITCH_MODULE_SHUTDOWN_FUNCTION(core_prompt_cache_shutdown);
+SWITCH_MODULE_DEFINITION(CORE_PROMPT_CACHE_MODULE, core_prompt_cache_load, core_prompt_cache_shutdown, NULL);
+
+/* one decoded prompt, L16 at a fixed (rate, channels), shared read-only by every handle playing it */
+typedef struct prompt_cache_entry_s {
+	char *key;
+	char *path;
+	uint32_t rate;
+	uint32_t channels;
+	int16_t *data;
+	switch_size_t samples;
+	switch_size_t bytes;
+	time_t mtime;
+	int64_t size;
+	switch_time_t created;
+	switch_time_t last_used;
+	uint64_t hits;
+	int refs;
+	int stale;
+	int orphan;
+	struct prompt_cache_entry_s *prev;
+	struct prompt_cache_entry_s *next;
+} prompt_cache_entry_t;
+
+typedef struct {
+	prompt_cache_entry_t *entry;
+	switch_size_t pos;
+} prompt_cache_context_t;
+
+/* a file that did not make it into the cache, not decoded again until it changes on disk or the limits change */
+typedef struct {
+	char *path;
+	time_t mtime;
+	int64_t size;
+	switch_size_t max_file_size;
+	switch_size_t budget;
+} prompt_cache_reject_t;
+
+/* the reject memo is dropped as a whole when it grows past this */
+#define PROMPT_CACHE_MAX_REJECTS 4096
+
+/* how long shutdown waits for handles still playing from the cache */
+#define PROMPT_CACHE_DRAIN_WAIT 5000000
+
+static struct {
+	switch_memory_pool_t *pool;
+	switch_mutex_t *mutex;
+	switch_hash_t *entries;
+	switch_hash_t *loading;
+	switch_hash_t *rejects;
+	uint32_t reject_count;
+	switch_file_interface_t *file_interface;
+	/* LRU list, most recently used first */
+	prompt_cache_entry_t *head;
+	prompt_cache_entry_t *tail;
+	/* expired entries still being played */
+	prompt_cache_entry_t *draining;
+	switch_size_t bytes;
+	uint32_t count;
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t evictions;
+	uint64_t invalidations;
+	uint64_t skips;
+	int refs;
+	int running;
+} globals;
+
+static char *supported_formats[] = { NULL };
+
+static void entry_unlink(prompt_cache_entry_t *entry)
+{
+	if (entry->prev) {
+		entry->prev->next = entry->next;
+	} else if (globals.head == entry) {
+		globals.head = entry->next;
+	}
+
+	if (entry->next) {
+		entry->next->prev = entry->prev;
+	} else if (globals.tail == entry) {
+		globals.tail = entry->prev;
+	}
+
+	entry->prev = entry->next = NULL;
+}
+
+static void entry_link_head(prompt_cache_entry_t *entry)
+{
+	entry->prev = NULL;
+	entry->next = globals.head;
+
+	if (globals.head) {
+		globals.head->prev = entry;
+	}
+
+	globals.head = entry;
+
+	if (!globals.tail) {
+		globals.tail = entry;
+	}
+}
+
+static void entry_destroy(prompt_cache_entry_t *entry)
+{
+	switch_safe_free(entry->data);
+	switch_safe_free(entry->key);
+	switch_safe_free(entry->path);
+	free(entry);
+}
+
+/* take the entry out of the index; the memory goes away with the last handle still reading it */
+static void entry_expire(prompt_cache_entry_t *entry)
+{
+	if (entry->stale) {
+		return;
+	}
+
+	entry->stale = 1;
+	switch_core_hash_delete(globals.entries, entry->key);
+	entry_unlink(entry);
+	globals.bytes -= entry->bytes;
+	globals.count--;
+
+	if (!entry->refs) {
+		entry_destroy(entry);
+	} else {
+		entry->next = globals.draining;
+		if (globals.draining) {
+			globals.draining->prev = entry;
+		}
+		globals.draining = entry;
+	}
+}
+
+static void entry_drained(prompt_cache_entry_t *entry)
+{
+	if (entry->prev) {
+		entry->prev->next = entry->next;
+	} else {
+		globals.draining = entry->next;
+	}
+
+	if (entry->next) {
+		entry->next->prev = entry->prev;
+	}
+
+	entry_destroy(entry);
+}
+
+/* keys are path|rate|channels, a path only matches its own keys, not the keys of longer paths it is a prefix of */
+static switch_bool_t key_has_path(const char *key, const char *path)
+{
+	size_t len = strlen(path);
+
+	return !strncmp(key, path, len) && key[len] == '|';
+}
+
+/* switch_core_hash_delete_multi() callback, pData is a path to match or NULL for all */
+static switch_bool_t reject_flush(const void *key, const void *val, void *pData)
+{
+	prompt_cache_reject_t *reject = (prompt_cache_reject_t *) val;
+	const char *path = (const char *) pData;
+
+	if (path && strcmp(reject->path, path) && !key_has_path((const char *) key, path)) {
+		return SWITCH_FALSE;
+	}
+
+	switch_safe_free(reject->path);
+	free(reject);
+	globals.reject_count--;
+
+	return SWITCH_TRUE;
+}
+
+static void rejects_clear(void)
+{
+	switch_core_hash_delete_multi(globals.rejects, reject_flush, NULL);
+}
+
+static void reject_add(const char *key, const char *path, struct stat *st, switch_size_t budget)
+{
+	prompt_cache_reject_t *reject;
+
+	if ((reject = switch_core_hash_delete(globals.rejects, key))) {
+		switch_safe_free(reject->path);
+		free(reject);
+		globals.reject_count--;
+	}
+
+	if (globals.reject_count >= PROMPT_CACHE_MAX_REJECTS) {
+		rejects_clear();
+	}
+
+	switch_zmalloc(reject, sizeof(*reject));
+	reject->path = strdup(path);
+	reject->mtime = st->st_mtime;
+	reject->size = st->st_size;
+	reject->max_file_size = runtime.prompt_cache_max_file_size;
+	reject->budget = budget;
+	switch_core_hash_insert(globals.rejects, key, reject);
+	globals.reject_count++;
+}
+
+static int reject_match(const char *key, const char *path, struct stat *st, switch_size_t budget)
+{
+	prompt_cache_reject_t *reject;
+
+	if (!(reject = switch_core_hash_find(globals.rejects, key))) {
+		return 0;
+	}
+
+	return reject->mtime == st->st_mtime && reject->size == st->st_size && !strcmp(reject->path, path) &&
+		reject->max_file_size == runtime.prompt_cache_max_file_size && reject->budget == budget;
+}
+
+static void enforce_budget(switch_size_t budget)
+{
+	prompt_cache_entry_t *entry = globals.tail, *prev;
+
+	while (entry && globals.bytes > budget) {
+		prev = entry->prev;
+
+		if (!entry->refs) {
+			globals.evictions++;
+			entry_expire(entry);
+		}
+
+		entry = prev;
+	}
+}
+
+/* sound packs keep per-rate copies in <dir>/<rate>/<file>, the same place mod_sndfile looks */
+static char *resolve_path(const char *file_path, uint32_t rate, struct stat *st)
+{
+	const char *last;
+	char *alt_path;
+
+	if (!stat(file_path, st)) {
+		return strdup(file_path);
+	}
+
+	if (!(last = strrchr(file_path, '/')) && !(last = strrchr(file_path, '\\'))) {
+		return NULL;
+	}
+
+	alt_path = switch_mprintf("%.*s%s%u%s", (int) (last - file_path), file_path, SWITCH_PATH_SEPARATOR, rate, last);
+
+	if (!stat(alt_path, st)) {
+		return alt_path;
+	}
+
+	free(alt_path);
+	return NULL;
+}
+
+static prompt_cache_entry_t *entry_load(const char *file_path, const char *key, const char *path, struct stat *st, uint32_t channels, uint32_t rate)
+{
+	switch_file_handle_t lfh = { 0 };
+	prompt_cache_entry_t *entry = NULL;
+	switch_size_t max_bytes = runtime.prompt_cache_max_file_size;
+	switch_size_t alloc = 0, used = 0, len;
+	int16_t *data = NULL;
+	int16_t buf[SWITCH_RECOMMENDED_BUFFER_SIZE / 2];
+
+	if (switch_core_file_open(&lfh, file_path, channels, rate,
+							  SWITCH_FILE_FLAG_READ | SWITCH_FILE_DATA_SHORT | SWITCH_FILE_NOCACHE, NULL) != SWITCH_STATUS_SUCCESS) {
+		return NULL;
+	}
+
+	for (;;) {
+		len = sizeof(buf) / 2 / channels;
+
+		if (switch_core_file_read(&lfh, buf, &len) != SWITCH_STATUS_SUCCESS || !len) {
+			break;
+		}
+
+		len *= 2 * channels;
+
+		if (max_bytes && used + len > max_bytes) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "Prompt [%s] is larger than %" SWITCH_SIZE_T_FMT " bytes, not caching\n",
+							  path, max_bytes);
+			switch_safe_free(data);
+			switch_core_file_close(&lfh);
+			return NULL;
+		}
+
+		if (used + len > alloc) {
+			void *mem;
+
+			alloc = alloc ? alloc * 2 : (rate * channels * 2);
+			while (alloc < used + len) {
+				alloc *= 2;
+			}
+
+			mem = realloc(data, alloc);
+			switch_assert(mem);
+			data = mem;
+		}
+
+		memcpy((char *) data + used, buf, len);
+		used += len;
+	}
+
+	switch_core_file_close(&lfh);
+
+	if (!used) {
+		switch_safe_free(data);
+		return NULL;
+	}
+
+	switch_zmalloc(entry, sizeof(*entry));
+	entry->key = strdup(key);
+	entry->path = strdup(path);
+	entry->rate = rate;
+	entry->channels = channels;
+	entry->data = data;
+	entry->bytes = used;
+	entry->samples = used / 2 / channels;
+	entry->mtime = st->st_mtime;
+	entry->size = st->st_size;
+	entry->created = switch_micro_time_now();
+
+	return entry;
+}
+
+switch_status_t switch_core_prompt_cache_open(switch_file_handle_t *fh, const char *file_path)
+{
+	prompt_cache_entry_t *entry = NULL;
+	prompt_cache_context_t *context;
+	switch_size_t budget = runtime.prompt_cache_size;
+	struct stat st;
+	char *path = NULL, *key = NULL;
+	uint32_t channels = fh->channels ? fh->channels : 1, rate = fh->samplerate;
+
+	if (!globals.running || !budget || !globals.file_interface) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	if (!switch_test_flag(fh, SWITCH_FILE_FLAG_READ) ||
+		(fh->flags & (SWITCH_FILE_FLAG_WRITE | SWITCH_FILE_NATIVE | SWITCH_FILE_FLAG_VIDEO | SWITCH_FILE_NOCACHE)) ||
+		fh->params || fh->stream_name || fh->spool_path || fh->real_channels) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	if (!(path = resolve_path(file_path, rate, &st))) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	key = switch_mprintf("%s|%u|%u", file_path, rate, channels);
+
+	switch_mutex_lock(globals.mutex);
+
+	if ((entry = switch_core_hash_find(globals.entries, key))) {
+		if (entry->mtime != st.st_mtime || entry->size != st.st_size || strcmp(entry->path, path)) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "Prompt [%s] changed on disk, invalidating cache entry\n", path);
+			globals.invalidations++;
+			entry_expire(entry);
+			entry = NULL;
+		}
+	}
+
+	if (entry) {
+		entry->refs++;
+		globals.refs++;
+		entry->hits++;
+		entry->last_used = switch_micro_time_now();
+		entry_unlink(entry);
+		entry_link_head(entry);
+		globals.hits++;
+		switch_mutex_unlock(globals.mutex);
+		goto found;
+	}
+
+	if (reject_match(key, path, &st, budget)) {
+		/* too big or undecodable the last time we tried, and it has not changed since */
+		globals.skips++;
+		switch_mutex_unlock(globals.mutex);
+		goto end;
+	}
+
+	globals.misses++;
+
+	if (switch_core_hash_find(globals.loading, key)) {
+		/* someone else is already decoding this one, play it the old way rather than wait */
+		switch_mutex_unlock(globals.mutex);
+		goto end;
+	}
+
+	switch_core_hash_insert(globals.loading, key, (void *) globals.pool);
+	switch_mutex_unlock(globals.mutex);
+
+	entry = entry_load(file_path, key, path, &st, channels, rate);
+
+	switch_mutex_lock(globals.mutex);
+	switch_core_hash_delete(globals.loading, key);
+
+	if (entry && (entry->bytes > budget || !globals.running)) {
+		entry_destroy(entry);
+		entry = NULL;
+		if (globals.running) {
+			reject_add(key, path, &st, budget);
+		}
+	} else if (!entry && globals.running) {
+		reject_add(key, path, &st, budget);
+	} else {
+		entry->refs++;
+		globals.refs++;
+		entry->last_used = entry->created;
+		switch_core_hash_insert(globals.entries, entry->key, entry);
+		entry_link_head(entry);
+		globals.bytes += entry->bytes;
+		globals.count++;
+		enforce_budget(budget);
+	}
+
+	switch_mutex_unlock(globals.mutex);
+
+	if (!entry) {
+		goto end;
+	}
+
+  found:
+
+	context = switch_core_alloc(fh->memory_pool, sizeof(*context));
+	context->entry = entry;
+	fh->private_info = context;
+
+	UNPROTECT_INTERFACE(fh->file_interface);
+	fh->file_interface = globals.file_interface;
+	PROTECT_INTERFACE(fh->file_interface);
+
+	fh->samplerate = entry->rate;
+	fh->channels = entry->channels;
+	fh->samples = (unsigned int) entry->samples;
+	fh->seekable = 1;
+	fh->speed = 0;
+	fh->pos = 0;
+
+	switch_safe_free(key);
+	switch_safe_free(path);
+
+	return SWITCH_STATUS_SUCCESS;
+
+  end:
+
+	switch_safe_free(key);
+	switch_safe_free(path);
+
+	return SWITCH_STATUS_FALSE;
+}
+
+static switch_status_t prompt_cache_file_open(switch_file_handle_t *handle, const char *path)
+{
+	/* handles are attached by switch_core_prompt_cache_open(), there is nothing to open by extension */
+	return SWITCH_STATUS_FALSE;
+}
+
+static switch_status_t prompt_cache_file_close(switch_file_handle_t *handle)
+{
+	prompt_cache_context_t *context = handle->private_info;
+	prompt_cache_entry_t *entry;
+
+	if (!context || !(entry = context->entry)) {
+		return SWITCH_STATUS_SUCCESS;
+	}
+
+	/* outlived the cache, see core_prompt_cache_shutdown() */
+	if (entry->orphan) {
+		context->entry = NULL;
+		handle->private_info = NULL;
+		return SWITCH_STATUS_SUCCESS;
+	}
+
+	switch_mutex_lock(globals.mutex);
+	globals.refs--;
+	if (!--entry->refs && entry->stale) {
+		entry_drained(entry);
+	}
+	switch_mutex_unlock(globals.mutex);
+
+	context->entry = NULL;
+	handle->private_info = NULL;
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+static switch_status_t prompt_cache_file_read(switch_file_handle_t *handle, void *data, switch_size_t *len)
+{
+	prompt_cache_context_t *context = handle->private_info;
+	prompt_cache_entry_t *entry = context->entry;
+	switch_size_t remaining = entry->samples - context->pos;
+
+	if (*len > remaining) {
+		*len = remaining;
+	}
+
+	if (!*len) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	memcpy(data, entry->data + context->pos * entry->channels, *len * 2 * entry->channels);
+	context->pos += *len;
+	handle->pos = context->pos;
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+static switch_status_t prompt_cache_file_seek(switch_file_handle_t *handle, unsigned int *cur_sample, int64_t samples, int whence)
+{
+	prompt_cache_context_t *context = handle->private_info;
+	prompt_cache_entry_t *entry = context->entry;
+	int64_t pos;
+
+	switch (whence) {
+	case SEEK_CUR:
+		pos = (int64_t) context->pos + samples;
+		break;
+	case SEEK_END:
+		pos = (int64_t) entry->samples + samples;
+		break;
+	default:
+		pos = samples;
+		break;
+	}
+
+	if (pos < 0) {
+		pos = 0;
+	} else if (pos > (int64_t) entry->samples) {
+		pos = entry->samples;
+	}
+
+	context->pos = (switch_size_t) pos;
+	handle->pos = pos;
+	*cur_sample = (unsigned int) pos;
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+static switch_status_t prompt_cache_file_get_string(switch_file_handle_t *handle, switch_audio_col_t col, const char **string)
+{
+	return SWITCH_STATUS_FALSE;
+}
+
+SWITCH_DECLARE(switch_size_t) switch_core_prompt_cache_size(switch_size_t bytes)
+{
+	if (bytes) {
+		runtime.prompt_cache_size = bytes;
+
+		/* the rejects remember the budget they failed against, a new one gets them another try */
+		if (globals.running) {
+			switch_mutex_lock(globals.mutex);
+			enforce_budget(bytes);
+			switch_mutex_unlock(globals.mutex);
+		}
+	}
+
+	return runtime.prompt_cache_size;
+}
+
+SWITCH_DECLARE(uint32_t) switch_core_prompt_cache_flush(const char *path)
+{
+	prompt_cache_entry_t *entry, *next;
+	uint32_t flushed = 0;
+
+	if (!globals.running) {
+		return 0;
+	}
+
+	switch_mutex_lock(globals.mutex);
+	for (entry = globals.head; entry; entry = next) {
+		next = entry->next;
+
+		if (zstr(path) || !strcmp(entry->path, path) || key_has_path(entry->key, path)) {
+			globals.invalidations++;
+			entry_expire(entry);
+			flushed++;
+		}
+	}
+
+	switch_core_hash_delete_multi(globals.rejects, reject_flush, zstr(path) ? NULL : (void *) path);
+	switch_mutex_unlock(globals.mutex);
+
+	return flushed;
+}
+
+SWITCH_DECLARE(void) switch_core_prompt_cache_status(switch_stream_handle_t *stream)
+{
+	prompt_cache_entry_t *entry;
+	switch_time_t now = switch_micro_time_now();
+
+	if (!globals.running) {
+		stream->write_function(stream, "Prompt cache not running\n");
+		return;
+	}
+
+	switch_mutex_lock(globals.mutex);
+
+	for (entry = globals.head; entry; entry = entry->next) {
+		stream->write_function(stream, "%s\n\tRate: %u\n\tChannels: %u\n\tBytes: %" SWITCH_SIZE_T_FMT "\n\tHits: %" SWITCH_UINT64_T_FMT
+							   "\n\tIn use: %d\n\tAge: %" SWITCH_TIME_T_FMT "s\n\tIdle: %" SWITCH_TIME_T_FMT "s\n",
+							   entry->path, entry->rate, entry->channels, entry->bytes, entry->hits, entry->refs,
+							   (now - entry->created) / 1000000, (now - entry->last_used) / 1000000);
+	}
+
+	stream->write_function(stream, "%u entr%s, %" SWITCH_SIZE_T_FMT "/%" SWITCH_SIZE_T_FMT " bytes, %" SWITCH_UINT64_T_FMT " hit%s, %"
+						   SWITCH_UINT64_T_FMT " miss%s, %" SWITCH_UINT64_T_FMT " evicted, %" SWITCH_UINT64_T_FMT " invalidated, %"
+						   SWITCH_UINT64_T_FMT " skipped, %u rejected\n",
+						   globals.count, globals.count == 1 ? "y" : "ies", globals.bytes, runtime.prompt_cache_size,
+						   globals.hits, globals.hits == 1 ? "" : "s", globals.misses, globals.misses == 1 ? "" : "es",
+						   globals.evictions, globals.invalidations, globals.skips, globals.reject_count);
+
+	switch_mutex_unlock(globals.mutex);
+}
+
+SWITCH_MODULE_LOAD_FUNCTION(core_prompt_cache_load)
+{
+	switch_file_interface_t *file_interface;
+
+	memset(&globals, 0, sizeof(globals));
+	globals.pool = pool;
+	switch_mutex_init(&globals.mutex, SWITCH_MUTEX_NESTED, pool);
+	switch_core_hash_init(&globals.entries);
+	switch_core_hash_init(&globals.loading);
+	switch_core_hash_init(&globals.rejects);
+
+	*module_interface = switch_loadable_module_create_module_interface(pool, modname);
+
+	file_interface = switch_loadable_module_create_interface(*module_interface, SWITCH_FILE_INTERFACE);
+	file_interface->interface_name = modname;
+	file_interface->extens = supported_formats;
+	file_interface->file_open = prompt_cache_file_open;
+	file_interface->file_close = prompt_cache_file_close;
+	file_interface->file_read = prompt_cache_file_read;
+	file_interface->file_seek = prompt_cache_file_seek;
+	file_interface->file_get_string = prompt_cache_file_get_string;
+
+	globals.file_interface = file_interface;
+	globals.running = 1;
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+SWITCH_MODULE_SHUTDOWN_FUNCTION(core_prompt_cache_shutdown)
+{
+	prompt_cache_entry_t *entry, *next;
+	switch_time_t started = switch_micro_time_now();
+	int refs;
+
+	switch_mutex_lock(globals.mutex);
+	globals.running = 0;
+	rejects_clear();
+	switch_mutex_unlock(globals.mutex);
+
+	/* give the handles still playing from the cache a moment to close */
+	for (;;) {
+		switch_mutex_lock(globals.mutex);
+		refs = globals.refs;
+		switch_mutex_unlock(globals.mutex);
+
+		if (!refs || switch_micro_time_now() - started > PROMPT_CACHE_DRAIN_WAIT) {
+			break;
+		}
+
+		switch_yield(100000);
+	}
+
+	switch_mutex_lock(globals.mutex);
+	for (entry = globals.head; entry; entry = next) {
+		next = entry->next;
+
+		if (entry->refs) {
+			/* the handle outlives the module, the entry is leaked on purpose rather than freed under it */
+			entry->orphan = 1;
+		} else {
+			entry_destroy(entry);
+		}
+	}
+
+	for (entry = globals.draining; entry; entry = entry->next) {
+		entry->orphan = 1;
+	}
+
+	if (refs) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "%d prompt cache handle%s still open at shutdown, leaking their entries\n",
+						  refs, refs == 1 ? "" : "s");
+	}
+
+	globals.head = globals.tail = globals.draining = NULL;
+	globals.bytes = 0;
+	globals.count = 0;
+	switch_mutex_unlock(globals.mutex);
+
+	switch_core_hash_destroy(&globals.entries);
+	switch_core_hash_destroy(&globals.loading);
+	switch_core_hash_destroy(&globals.rejects);
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+/* For Emacs:
+ * Local Variables:
+ * mode:c
+ * indent-tabs-mode:t
+ * tab-width:4
+ * c-basic-offset:4
+ * End:
+ * For VIM:
+ * vim:set softtabstop=4 shiftwidth=4 tabstop=4 noet:
+ */
@@ -118,13 +118,108 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_set_codec_slin(switch_core_s
 }
 
 
+struct str_node {
+	char *str;
+	struct str_node *next;
+};
+
+static inline struct switch_session_stripe *session_stripe(const char *key)
+{
+	uint32_t h = 2166136261u;
+
+	/* fnv1a, the uuids are random enough that any spread will do */
+	for (; *key; key++) {
+		h = (h ^ (uint8_t) *key) * 16777619u;
+	}
+
+	return &session_manager.session_stripes[h % SWITCH_SESSION_STRIPES];
+}
+
+/* renames touch two stripes, always take them in the same order */
+static void session_stripes_wrlock(struct switch_session_stripe *a, struct switch_session_stripe *b)
+{
+	if (a == b) {
+		switch_thread_rwlock_wrlock(a->rwlock);
+		return;
+	}
+
+	if (a > b) {
+		struct switch_session_stripe *tmp = a;
+		a = b;
+		b = tmp;
+	}
+
+	switch_thread_rwlock_wrlock(a->rwlock);
+	switch_thread_rwlock_wrlock(b->rwlock);
+}
+
+static void session_stripes_unlock(struct switch_session_stripe *a, struct switch_session_stripe *b)
+{
+	switch_thread_rwlock_unlock(a->rwlock);
+	if (b != a) {
+		switch_thread_rwlock_unlock(b->rwlock);
+	}
+}
+
+static switch_bool_t session_table_exists(const char *key)
+{
+	struct switch_session_stripe *stripe = session_stripe(key);
+	switch_bool_t r;
+
+	switch_thread_rwlock_rdlock(stripe->rwlock);
+	r = switch_core_hash_find(stripe->table, key) ? SWITCH_TRUE : SWITCH_FALSE;
+	switch_thread_rwlock_unlock(stripe->rwlock);
+
+	return r;
+}
+
+/* copy the uuids of the live sessions one stripe at a time, so walking them never holds up calls coming and going */
+static struct str_node *session_table_snapshot(switch_memory_pool_t *pool)
+{
+	struct str_node *head = NULL, *np;
+	switch_hash_index_t *hi;
+	const void *key;
+	void *val;
+	int i;
+
+	for (i = 0; i < SWITCH_SESSION_STRIPES; i++) {
+		struct switch_session_stripe *stripe = &session_manager.session_stripes[i];
+
+		switch_thread_rwlock_rdlock(stripe->rwlock);
+		for (hi = switch_core_hash_first(stripe->table); hi; hi = switch_core_hash_next(&hi)) {
+			switch_core_session_t *session;
+
+			switch_core_hash_this(hi, &key, NULL, &val);
+			session = (switch_core_session_t *) val;
+
+			/* external ids point at sessions already listed under their uuid */
+			if (!session || strcmp((const char *) key, session->uuid_str)) {
+				continue;
+			}
+
+			if (switch_core_session_read_lock(session) == SWITCH_STATUS_SUCCESS) {
+				np = switch_core_alloc(pool, sizeof(*np));
+				np->str = switch_core_strdup(pool, session->uuid_str);
+				np->next = head;
+				head = np;
+				switch_core_session_rwunlock(session);
+			}
+		}
+		switch_thread_rwlock_unlock(stripe->rwlock);
+	}
+
+	return head;
+}
+
 SWITCH_DECLARE(switch_core_session_t *) switch_core_session_perform_locate(const char *uuid_str, const char *file, const char *func, int line)
 {
 	switch_core_session_t *session = NULL;
 
 	if (uuid_str) {
-		switch_mutex_lock(runtime.session_hash_mutex);
-		if ((session = switch_core_hash_find(session_manager.session_table, uuid_str))) {
+		struct switch_session_stripe *stripe = session_stripe(uuid_str);
+
+		switch_thread_rwlock_rdlock(stripe->rwlock);
+		if ((session = switch_core_hash_find(stripe->table, uuid_str))) {
 			/* Acquire a read lock on the session */
 #ifdef SWITCH_DEBUG_RWLOCKS
 			if (switch_core_session_perform_read_lock(session, file, func, line) != SWITCH_STATUS_SUCCESS) {
@@ -138,7 +233,7 @@ SWITCH_DECLARE(switch_core_session_t *) switch_core_session_perform_locate(const
 				session = NULL;
 			}
 		}
-		switch_mutex_unlock(runtime.session_hash_mutex);
+		switch_thread_rwlock_unlock(stripe->rwlock);
 	}
 
 	/* if its not NULL, now it's up to you to rwunlock this */
@@ -155,8 +250,10 @@ SWITCH_DECLARE(switch_core_session_t *) switch_core_session_perform_force_locate
 	switch_status_t status;
 
 	if (uuid_str) {
-		switch_mutex_lock(runtime.session_hash_mutex);
-		if ((session = switch_core_hash_find(session_manager.session_table, uuid_str))) {
+		struct switch_session_stripe *stripe = session_stripe(uuid_str);
+
+		switch_thread_rwlock_rdlock(stripe->rwlock);
+		if ((session = switch_core_hash_find(stripe->table, uuid_str))) {
 			/* Acquire a read lock on the session */
 
 			if (switch_test_flag(session, SSF_DESTROYED)) {
@@ -178,7 +275,7 @@ SWITCH_DECLARE(switch_core_session_t *) switch_core_session_perform_force_locate
 				session = NULL;
 			}
 		}
-		switch_mutex_unlock(runtime.session_hash_mutex);
+		switch_thread_rwlock_unlock(stripe->rwlock);
 	}
 
 	/* if its not NULL, now it's up to you to rwunlock this */
@@ -203,48 +300,26 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_perform_get_partner(switch_c
 }
 
 
-struct str_node {
-	char *str;
-	struct str_node *next;
-};
-
 SWITCH_DECLARE(uint32_t) switch_core_session_hupall_matching_vars_ans(switch_event_t *vars, switch_call_cause_t cause, switch_hup_type_t type)
 {
-	switch_hash_index_t *hi;
-	void *val;
 	switch_core_session_t *session;
 	switch_memory_pool_t *pool;
 	struct str_node *head = NULL, *np;
 	uint32_t r = 0;
 
-	switch_core_new_memory_pool(&pool);
-
 	if (!vars || !vars->headers)
 		return r;
 
-	switch_mutex_lock(runtime.session_hash_mutex);
-	for (hi = switch_core_hash_first(session_manager.session_table); hi; hi = switch_core_hash_next(&hi)) {
-		switch_core_hash_this(hi, NULL, NULL, &val);
-		if (val) {
-			session = (switch_core_session_t *) val;
-			if (switch_core_session_read_lock(session) == SWITCH_STATUS_SUCCESS) {
-				int ans = switch_channel_test_flag(switch_core_session_get_channel(session), CF_ANSWERED);
-				if ((ans && (type & SHT_ANSWERED)) || (!ans && (type & SHT_UNANSWERED))) {
-					np = switch_core_alloc(pool, sizeof(*np));
-					np->str = switch_core_strdup(pool, session->uuid_str);
-					np->next = head;
-					head = np;
-				}
-				switch_core_session_rwunlock(session);
-			}
-		}
-	}
-	switch_mutex_unlock(runtime.session_hash_mutex);
+	switch_core_new_memory_pool(&pool);
+
+	head = session_table_snapshot(pool);
 
 	for(np = head; np; np = np->next) {
 		if ((session = switch_core_session_locate(np->str))) {
 			const char *this_value;
-			if (switch_channel_up_nosig(session->channel)) {
+			int ans = switch_channel_test_flag(session->channel, CF_ANSWERED);
+
+			if (((ans && (type & SHT_ANSWERED)) || (!ans && (type & SHT_UNANSWERED))) && switch_channel_up_nosig(session->channel)) {
 				/* check if all conditions are satisfied */
 				int do_hangup = 1;
 				switch_event_header_t *hp;
@@ -288,8 +363,6 @@ SWITCH_DECLARE(uint32_t) switch_core_session_hupall_matching_var_ans(const char
 
 SWITCH_DECLARE(switch_console_callback_match_t *) switch_core_session_findall_matching_var(const char *var_name, const char *var_val)
 {
-	switch_hash_index_t *hi;
-	void *val;
 	switch_core_session_t *session;
 	switch_memory_pool_t *pool;
 	struct str_node *head = NULL, *np;
@@ -302,21 +375,7 @@ SWITCH_DECLARE(switch_console_callback_match_t *) switch_core_session_findall_ma
 
 	switch_core_new_memory_pool(&pool);
 
-	switch_mutex_lock(runtime.session_hash_mutex);
-	for (hi = switch_core_hash_first(session_manager.session_table); hi; hi = switch_core_hash_next(&hi)) {
-		switch_core_hash_this(hi, NULL, NULL, &val);
-		if (val) {
-			session = (switch_core_session_t *) val;
-			if (switch_core_session_read_lock(session) == SWITCH_STATUS_SUCCESS) {
-				np = switch_core_alloc(pool, sizeof(*np));
-				np->str = switch_core_strdup(pool, session->uuid_str);
-				np->next = head;
-				head = np;
-				switch_core_session_rwunlock(session);
-			}
-		}
-	}
-	switch_mutex_unlock(runtime.session_hash_mutex);
+	head = session_table_snapshot(pool);
 
 	for(np = head; np; np = np->next) {
 		if ((session = switch_core_session_locate(np->str))) {
@@ -338,35 +397,19 @@ SWITCH_DECLARE(switch_console_callback_match_t *) switch_core_session_findall_ma
 
 SWITCH_DECLARE(void) switch_core_session_hupall_endpoint(const switch_endpoint_interface_t *endpoint_interface, switch_call_cause_t cause)
 {
-	switch_hash_index_t *hi;
-	void *val;
 	switch_core_session_t *session;
 	switch_memory_pool_t *pool;
 	struct str_node *head = NULL, *np;
 
 	switch_core_new_memory_pool(&pool);
 
-	switch_mutex_lock(runtime.session_hash_mutex);
-	for (hi = switch_core_hash_first(session_manager.session_table); hi; hi = switch_core_hash_next(&hi)) {
-		switch_core_hash_this(hi, NULL, NULL, &val);
-		if (val) {
-			session = (switch_core_session_t *) val;
-			if (switch_core_session_read_lock(session) == SWITCH_STATUS_SUCCESS) {
-				if (session->endpoint_interface == endpoint_interface) {
-					np = switch_core_alloc(pool, sizeof(*np));
-					np->str = switch_core_strdup(pool, session->uuid_str);
-					np->next = head;
-					head = np;
-				}
-				switch_core_session_rwunlock(session);
-			}
-		}
-	}
-	switch_mutex_unlock(runtime.session_hash_mutex);
+	head = session_table_snapshot(pool);
 
 	for(np = head; np; np = np->next) {
 		if ((session = switch_core_session_locate(np->str))) {
-			switch_channel_hangup(session->channel, cause);
+			if (session->endpoint_interface == endpoint_interface) {
+				switch_channel_hangup(session->channel, cause);
+			}
 			switch_core_session_rwunlock(session);
 		}
 	}
@@ -377,30 +420,13 @@ SWITCH_DECLARE(void) switch_core_session_hupall_endpoint(const switch_endpoint_i
 
 SWITCH_DECLARE(void) switch_core_session_hupall(switch_call_cause_t cause)
 {
-	switch_hash_index_t *hi;
-	void *val;
 	switch_core_session_t *session;
 	switch_memory_pool_t *pool;
 	struct str_node *head = NULL, *np;
 
 	switch_core_new_memory_pool(&pool);
 
-
-	switch_mutex_lock(runtime.session_hash_mutex);
-	for (hi = switch_core_hash_first(session_manager.session_table); hi; hi = switch_core_hash_next(&hi)) {
-		switch_core_hash_this(hi, NULL, NULL, &val);
-		if (val) {
-			session = (switch_core_session_t *) val;
-			if (switch_core_session_read_lock(session) == SWITCH_STATUS_SUCCESS) {
-				np = switch_core_alloc(pool, sizeof(*np));
-				np->str = switch_core_strdup(pool, session->uuid_str);
-				np->next = head;
-				head = np;
-				switch_core_session_rwunlock(session);
-			}
-		}
-	}
-	switch_mutex_unlock(runtime.session_hash_mutex);
+	head = session_table_snapshot(pool);
 
 	for(np = head; np; np = np->next) {
 		if ((session = switch_core_session_locate(np->str))) {
@@ -416,23 +442,17 @@ SWITCH_DECLARE(void) switch_core_session_hupall(switch_call_cause_t cause)
 
 SWITCH_DECLARE(switch_console_callback_match_t *) switch_core_session_findall(void)
 {
-	switch_hash_index_t *hi;
-	void *val;
-	switch_core_session_t *session;
+	switch_memory_pool_t *pool;
+	struct str_node *np;
 	switch_console_callback_match_t *my_matches = NULL;
 
-	switch_mutex_lock(runtime.session_hash_mutex);
-	for (hi = switch_core_hash_first(session_manager.session_table); hi; hi = switch_core_hash_next(&hi)) {
-		switch_core_hash_this(hi, NULL, NULL, &val);
-		if (val) {
-			session = (switch_core_session_t *) val;
-			if (switch_core_session_read_lock(session) == SWITCH_STATUS_SUCCESS) {
-				switch_console_push_match(&my_matches, session->uuid_str);
-				switch_core_session_rwunlock(session);
-			}
-		}
+	switch_core_new_memory_pool(&pool);
+
+	for (np = session_table_snapshot(pool); np; np = np->next) {
+		switch_console_push_match(&my_matches, np->str);
 	}
-	switch_mutex_unlock(runtime.session_hash_mutex);
+
+	switch_core_destroy_memory_pool(&pool);
 
 	return my_matches;
 }
@@ -442,17 +462,13 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_message_send(const char *uui
 	switch_core_session_t *session = NULL;
 	switch_status_t status = SWITCH_STATUS_FALSE;
 
-	switch_mutex_lock(runtime.session_hash_mutex);
-	if ((session = switch_core_hash_find(session_manager.session_table, uuid_str)) != 0) {
-		/* Acquire a read lock on the session or forget it the channel is dead */
-		if (switch_core_session_read_lock(session) == SWITCH_STATUS_SUCCESS) {
-			if (switch_channel_up_nosig(session->channel)) {
-				status = switch_core_session_receive_message(session, message);
-			}
-			switch_core_session_rwunlock(session);
+	/* the table is not held while the message or event is handled */
+	if ((session = switch_core_session_locate(uuid_str))) {
+		if (switch_channel_up_nosig(session->channel)) {
+			status = switch_core_session_receive_message(session, message);
 		}
+		switch_core_session_rwunlock(session);
 	}
-	switch_mutex_unlock(runtime.session_hash_mutex);
 
 	return status;
 }
@@ -462,17 +478,13 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_event_send(const char *uuid_
 	switch_core_session_t *session = NULL;
 	switch_status_t status = SWITCH_STATUS_FALSE;
 
-	switch_mutex_lock(runtime.session_hash_mutex);
-	if ((session = switch_core_hash_find(session_manager.session_table, uuid_str)) != 0) {
-		/* Acquire a read lock on the session or forget it the channel is dead */
-		if (switch_core_session_read_lock(session) == SWITCH_STATUS_SUCCESS) {
-			if (switch_channel_up_nosig(session->channel)) {
-				status = switch_core_session_queue_event(session, event);
-			}
-			switch_core_session_rwunlock(session);
+	/* the table is not held while the message or event is handled */
+	if ((session = switch_core_session_locate(uuid_str))) {
+		if (switch_channel_up_nosig(session->channel)) {
+			status = switch_core_session_queue_event(session, event);
 		}
+		switch_core_session_rwunlock(session);
 	}
-	switch_mutex_unlock(runtime.session_hash_mutex);
 
 	return status;
 }
@@ -1539,6 +1551,7 @@ SWITCH_DECLARE(void) switch_core_session_perform_destroy(switch_core_session_t *
 	switch_memory_pool_t *pool;
 	switch_event_t *event;
 	switch_endpoint_interface_t *endpoint_interface = (*session)->endpoint_interface;
+	struct switch_session_stripe *stripe;
 	int i;
 
 
@@ -1568,11 +1581,18 @@ SWITCH_DECLARE(void) switch_core_session_perform_destroy(switch_core_session_t *
 
 	switch_scheduler_del_task_group((*session)->uuid_str);
 
-	switch_mutex_lock(runtime.session_hash_mutex);
-	switch_core_hash_delete(session_manager.session_table, (*session)->uuid_str);
+	stripe = session_stripe((*session)->uuid_str);
+	switch_thread_rwlock_wrlock(stripe->rwlock);
+	switch_core_hash_delete(stripe->table, (*session)->uuid_str);
+	switch_thread_rwlock_unlock(stripe->rwlock);
 	if ((*session)->external_id) {
-		switch_core_hash_delete(session_manager.session_table, (*session)->external_id);
+		stripe = session_stripe((*session)->external_id);
+		switch_thread_rwlock_wrlock(stripe->rwlock);
+		switch_core_hash_delete(stripe->table, (*session)->external_id);
+		switch_thread_rwlock_unlock(stripe->rwlock);
 	}
+
+	switch_mutex_lock(runtime.session_hash_mutex);
 	if (session_manager.session_count) {
 		session_manager.session_count--;
 		if (session_manager.session_count == 0) {
@@ -1598,6 +1618,7 @@ SWITCH_DECLARE(void) switch_core_session_perform_destroy(switch_core_session_t *
 
 	switch_buffer_destroy(&(*session)->raw_read_buffer);
 	switch_buffer_destroy(&(*session)->raw_write_buffer);
+	switch_core_media_bug_ring_destroy(*session);
 	switch_ivr_clear_speech_cache(*session);
 	switch_channel_uninit((*session)->channel);
 
@@ -2029,6 +2050,7 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_set_uuid(switch_core_session
 	switch_event_t *event;
 	switch_core_session_message_t msg = { 0 };
 	switch_caller_profile_t *profile;
+	struct switch_session_stripe *old_stripe, *new_stripe;
 
 	switch_assert(use_uuid);
 
@@ -2036,11 +2058,13 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_set_uuid(switch_core_session
 		return SWITCH_STATUS_SUCCESS;
 	}
 
+	old_stripe = session_stripe(session->uuid_str);
+	new_stripe = session_stripe(use_uuid);
 
-	switch_mutex_lock(runtime.session_hash_mutex);
-	if (switch_core_hash_find(session_manager.session_table, use_uuid)) {
+	session_stripes_wrlock(old_stripe, new_stripe);
+	if (switch_core_hash_find(new_stripe->table, use_uuid)) {
 		switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_CRIT, "Duplicate UUID!\n");
-		switch_mutex_unlock(runtime.session_hash_mutex);
+		session_stripes_unlock(old_stripe, new_stripe);
 		return SWITCH_STATUS_FALSE;
 	}
 
@@ -2059,10 +2083,10 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_set_uuid(switch_core_session
 
 	switch_event_create(&event, SWITCH_EVENT_CHANNEL_UUID);
 	switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Old-Unique-ID", session->uuid_str);
-	switch_core_hash_delete(session_manager.session_table, session->uuid_str);
+	switch_core_hash_delete(old_stripe->table, session->uuid_str);
 	switch_set_string(session->uuid_str, use_uuid);
-	switch_core_hash_insert(session_manager.session_table, session->uuid_str, session);
-	switch_mutex_unlock(runtime.session_hash_mutex);
+	switch_core_hash_insert(new_stripe->table, session->uuid_str, session);
+	session_stripes_unlock(old_stripe, new_stripe);
 	switch_channel_event_set_data(session->channel, event);
 	switch_event_fire(&event);
 
@@ -2072,32 +2096,36 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_set_uuid(switch_core_session
 
 SWITCH_DECLARE(switch_status_t) switch_core_session_set_external_id(switch_core_session_t *session, const char *use_external_id)
 {
+	struct switch_session_stripe *old_stripe, *new_stripe;
+
 	switch_assert(use_external_id);
 
 	if (session->external_id && !strcmp(use_external_id, session->external_id)) {
 		return SWITCH_STATUS_SUCCESS;
 	}
 
+	new_stripe = session_stripe(use_external_id);
+	old_stripe = session->external_id ? session_stripe(session->external_id) : new_stripe;
 
-	switch_mutex_lock(runtime.session_hash_mutex);
-	if (strcmp(use_external_id, session->uuid_str) && switch_core_hash_find(session_manager.session_table, use_external_id)) {
+	session_stripes_wrlock(old_stripe, new_stripe);
+	if (strcmp(use_external_id, session->uuid_str) && switch_core_hash_find(new_stripe->table, use_external_id)) {
 		switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_WARNING, "Duplicate External ID!\n");
-		switch_mutex_unlock(runtime.session_hash_mutex);
+		session_stripes_unlock(old_stripe, new_stripe);
 		return SWITCH_STATUS_FALSE;
 	}
 
 	switch_channel_set_variable(session->channel, "session_external_id", use_external_id);
 
 	if (session->external_id && strcmp(session->external_id, session->uuid_str)) {
-		switch_core_hash_delete(session_manager.session_table, session->external_id);
+		switch_core_hash_delete(old_stripe->table, session->external_id);
 	}
 
 	session->external_id = switch_core_session_strdup(session, use_external_id);
 
 	if (strcmp(session->external_id, session->uuid_str)) {
-		switch_core_hash_insert(session_manager.session_table, session->external_id, session);
+		switch_core_hash_insert(new_stripe->table, session->external_id, session);
 	}
-	switch_mutex_unlock(runtime.session_hash_mutex);
+	session_stripes_unlock(old_stripe, new_stripe);
 
 	return SWITCH_STATUS_SUCCESS;
 }
@@ -2386,11 +2414,12 @@ SWITCH_DECLARE(switch_core_session_t *) switch_core_session_request_uuid(switch_
 	switch_memory_pool_t *usepool;
 	switch_core_session_t *session;
 	switch_uuid_t uuid;
+	struct switch_session_stripe *stripe;
 	uint32_t count = 0;
 	int32_t sps = 0;
 
 
-	if (use_uuid && switch_core_hash_find(session_manager.session_table, use_uuid)) {
+	if (use_uuid && session_table_exists(use_uuid)) {
 		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CRIT, "Duplicate UUID!\n");
 		return NULL;
 	}
@@ -2500,8 +2529,12 @@ SWITCH_DECLARE(switch_core_session_t *) switch_core_session_request_uuid(switch_
 	switch_queue_create(&session->private_event_queue, SWITCH_EVENT_QUEUE_LEN, session->pool);
 	switch_queue_create(&session->private_event_queue_pri, SWITCH_EVENT_QUEUE_LEN, session->pool);
 
+	stripe = session_stripe(session->uuid_str);
+	switch_thread_rwlock_wrlock(stripe->rwlock);
+	switch_core_hash_insert(stripe->table, session->uuid_str, session);
+	switch_thread_rwlock_unlock(stripe->rwlock);
+
 	switch_mutex_lock(runtime.session_hash_mutex);
-	switch_core_hash_insert(session_manager.session_table, session->uuid_str, session);
 	session->id = session_manager.session_id++;
 	session_manager.session_count++;
 
@@ -2628,11 +2661,16 @@ SWITCH_DECLARE(uint32_t) switch_core_sessions_per_second(uint32_t new_limit)
 
 void switch_core_session_init(switch_memory_pool_t *pool)
 {
+	int i;
+
 	memset(&session_manager, 0, sizeof(session_manager));
 	session_manager.session_limit = 1000;
 	session_manager.session_id = 1;
 	session_manager.memory_pool = pool;
-	switch_core_hash_init(&session_manager.session_table);
+	for (i = 0; i < SWITCH_SESSION_STRIPES; i++) {
+		switch_core_hash_init(&session_manager.session_stripes[i].table);
+		switch_thread_rwlock_create(&session_manager.session_stripes[i].rwlock, session_manager.memory_pool);
+	}
 	switch_mutex_init(&session_manager.mutex, SWITCH_MUTEX_DEFAULT, session_manager.memory_pool);
 	switch_thread_cond_create(&session_manager.cond, session_manager.memory_pool);
 	switch_queue_create(&session_manager.thread_queue, 100000, session_manager.memory_pool);
@@ -2640,12 +2678,16 @@ void switch_core_session_init(switch_memory_pool_t *pool)
 
 void switch_core_session_uninit(void)
 {
+	int i;
+
 	switch_queue_term(session_manager.thread_queue);
 	switch_mutex_lock(session_manager.mutex);
 	if (session_manager.running)
 		switch_thread_cond_timedwait(session_manager.cond, session_manager.mutex, 10000000);
 	switch_mutex_unlock(session_manager.mutex);
-	switch_core_hash_destroy(&session_manager.session_table);
+	for (i = 0; i < SWITCH_SESSION_STRIPES; i++) {
+		switch_core_hash_destroy(&session_manager.session_stripes[i].table);
+	}
 }
 
 SWITCH_DECLARE(switch_app_log_t *) switch_core_session_get_app_log(switch_core_session_t *session)
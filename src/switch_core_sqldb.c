@@ -55,8 +55,32 @@ struct switch_cache_db_handle {
 	uint32_t use_count;
 	uint64_t total_used_count;
 	struct switch_cache_db_handle *next;
+	struct switch_cache_db_pool *db_pool;
+	struct switch_cache_db_handle *pool_next;
+	struct switch_cache_db_handle *idle_prev;
+	struct switch_cache_db_handle *idle_next;
+	uint8_t idle;
 };
 
+/* the handles of one dsn, so asking for a handle only locks the handles it could get */
+struct switch_cache_db_pool {
+	char name[CACHE_DB_LEN];
+	switch_mutex_t *mutex;
+	switch_thread_cond_t *cond;
+	switch_cache_db_handle_t *handles;
+	switch_cache_db_handle_t *idle;
+	uint32_t total;
+	uint32_t used;
+	uint32_t waiting;
+	uint64_t affinity_hits;
+	uint64_t idle_hits;
+	uint64_t creates;
+	uint64_t waits;
+	uint64_t timeouts;
+	struct switch_cache_db_pool *next;
+};
+typedef struct switch_cache_db_pool switch_cache_db_pool_t;
+
 static struct {
 	switch_memory_pool_t *memory_pool;
 	switch_thread_t *db_thread;
@@ -65,8 +89,15 @@ static struct {
 	switch_mutex_t *dbh_mutex;
 	switch_mutex_t *ctl_mutex;
 	switch_cache_db_handle_t *handle_pool;
+	/* handles counted against max_db_handles, guarded by slot_mutex */
 	uint32_t total_handles;
-	uint32_t total_used_handles;
+	switch_atomic_t total_used_handles;
+	switch_mutex_t *slot_mutex;
+	switch_thread_cond_t *slot_cond;
+	switch_atomic_t slot_waiting;
+	switch_hash_t *db_pools;
+	switch_cache_db_pool_t *db_pool_list;
+	switch_thread_rwlock_t *db_pools_rwlock;
 	switch_cache_db_handle_t *dbh;
 	switch_sql_queue_manager_t *qm;
 	int paused;
@@ -101,9 +132,73 @@ static void destroy_handle(switch_cache_db_handle_t **dbh)
 	}
 }
 
+static switch_cache_db_pool_t *get_db_pool(const char *db_str)
+{
+	switch_cache_db_pool_t *db_pool;
+
+	switch_thread_rwlock_rdlock(sql_manager.db_pools_rwlock);
+	db_pool = switch_core_hash_find(sql_manager.db_pools, db_str);
+	switch_thread_rwlock_unlock(sql_manager.db_pools_rwlock);
+
+	if (db_pool) {
+		return db_pool;
+	}
+
+	/* pools live until shutdown, there is one per dsn ever used */
+	switch_thread_rwlock_wrlock(sql_manager.db_pools_rwlock);
+	if (!(db_pool = switch_core_hash_find(sql_manager.db_pools, db_str))) {
+		db_pool = switch_core_alloc(sql_manager.memory_pool, sizeof(*db_pool));
+		switch_set_string(db_pool->name, db_str);
+		switch_mutex_init(&db_pool->mutex, SWITCH_MUTEX_NESTED, sql_manager.memory_pool);
+		switch_thread_cond_create(&db_pool->cond, sql_manager.memory_pool);
+		switch_core_hash_insert(sql_manager.db_pools, db_str, db_pool);
+		db_pool->next = sql_manager.db_pool_list;
+		sql_manager.db_pool_list = db_pool;
+	}
+	switch_thread_rwlock_unlock(sql_manager.db_pools_rwlock);
+
+	return db_pool;
+}
+
+/* called with the pool mutex held */
+static void db_pool_idle_push(switch_cache_db_pool_t *db_pool, switch_cache_db_handle_t *dbh)
+{
+	if (dbh->idle) {
+		return;
+	}
+
+	dbh->idle = 1;
+	dbh->idle_prev = NULL;
+	dbh->idle_next = db_pool->idle;
+	if (db_pool->idle) {
+		db_pool->idle->idle_prev = dbh;
+	}
+	db_pool->idle = dbh;
+}
+
+/* called with the pool mutex held */
+static void db_pool_idle_remove(switch_cache_db_pool_t *db_pool, switch_cache_db_handle_t *dbh)
+{
+	if (!dbh->idle) {
+		return;
+	}
+
+	if (dbh->idle_prev) {
+		dbh->idle_prev->idle_next = dbh->idle_next;
+	} else {
+		db_pool->idle = dbh->idle_next;
+	}
+	if (dbh->idle_next) {
+		dbh->idle_next->idle_prev = dbh->idle_prev;
+	}
+	dbh->idle_prev = dbh->idle_next = NULL;
+	dbh->idle = 0;
+}
+
 static void add_handle(switch_cache_db_handle_t *dbh, const char *db_str, const char *db_callsite_str, const char *thread_str)
 {
 	switch_ssize_t hlen = -1;
+	switch_cache_db_pool_t *db_pool = get_db_pool(db_str);
 
 	switch_mutex_lock(sql_manager.dbh_mutex);
 	switch_mutex_lock(dbh->mutex);
@@ -119,14 +214,77 @@ static void add_handle(switch_cache_db_handle_t *dbh, const char *db_str, const
 	dbh->next = sql_manager.handle_pool;
 
 	sql_manager.handle_pool = dbh;
-	sql_manager.total_handles++;
-	sql_manager.total_used_handles++;
+	switch_atomic_inc(&sql_manager.total_used_handles);
 	switch_mutex_unlock(sql_manager.dbh_mutex);
+
+	/* the totals were reserved before connecting */
+	switch_mutex_lock(db_pool->mutex);
+	dbh->db_pool = db_pool;
+	dbh->pool_next = db_pool->handles;
+	db_pool->handles = dbh;
+	db_pool->used++;
+	db_pool->creates++;
+	switch_mutex_unlock(db_pool->mutex);
+}
+
+/* wake the callers waiting for room under max_db_handles, whatever their dsn */
+static void db_slot_wake(void)
+{
+	if (switch_atomic_read(&sql_manager.slot_waiting)) {
+		switch_mutex_lock(sql_manager.slot_mutex);
+		switch_thread_cond_broadcast(sql_manager.slot_cond);
+		switch_mutex_unlock(sql_manager.slot_mutex);
+	}
+}
+
+/* called with slot_mutex held */
+static switch_bool_t db_slot_free(void)
+{
+	return !runtime.max_db_handles || sql_manager.total_handles < runtime.max_db_handles ||
+		switch_atomic_read(&sql_manager.total_used_handles) < sql_manager.total_handles;
+}
+
+/* give back a slot reserved for a handle that failed to connect */
+static void db_pool_unreserve(switch_cache_db_pool_t *db_pool)
+{
+	switch_mutex_lock(db_pool->mutex);
+	db_pool->total--;
+	if (db_pool->waiting) {
+		switch_thread_cond_broadcast(db_pool->cond);
+	}
+	switch_mutex_lock(sql_manager.slot_mutex);
+	sql_manager.total_handles--;
+	switch_mutex_unlock(sql_manager.slot_mutex);
+	switch_mutex_unlock(db_pool->mutex);
+
+	db_slot_wake();
 }
 
 static void del_handle(switch_cache_db_handle_t *dbh)
 {
 	switch_cache_db_handle_t *dbh_ptr, *last = NULL;
+	switch_cache_db_pool_t *db_pool = dbh->db_pool;
+
+	if (db_pool) {
+		switch_mutex_lock(db_pool->mutex);
+		db_pool_idle_remove(db_pool, dbh);
+		for (dbh_ptr = db_pool->handles; dbh_ptr; dbh_ptr = dbh_ptr->pool_next) {
+			if (dbh_ptr == dbh) {
+				if (last) {
+					last->pool_next = dbh_ptr->pool_next;
+				} else {
+					db_pool->handles = dbh_ptr->pool_next;
+				}
+				db_pool->total--;
+				break;
+			}
+			last = dbh_ptr;
+		}
+		/* a waiter may now open one of its own */
+		switch_thread_cond_broadcast(db_pool->cond);
+		switch_mutex_unlock(db_pool->mutex);
+		last = NULL;
+	}
 
 	switch_mutex_lock(sql_manager.dbh_mutex);
 	for (dbh_ptr = sql_manager.handle_pool; dbh_ptr; dbh_ptr = dbh_ptr->next) {
@@ -136,13 +294,17 @@ static void del_handle(switch_cache_db_handle_t *dbh)
 			} else {
 				sql_manager.handle_pool = dbh_ptr->next;
 			}
+			switch_mutex_lock(sql_manager.slot_mutex);
 			sql_manager.total_handles--;
+			switch_mutex_unlock(sql_manager.slot_mutex);
 			break;
 		}
 
 		last = dbh_ptr;
 	}
 	switch_mutex_unlock(sql_manager.dbh_mutex);
+
+	db_slot_wake();
 }
 
 SWITCH_DECLARE(void) switch_cache_db_database_interface_flush_handles(switch_database_interface_t *database_interface)
@@ -179,25 +341,25 @@ top:
 	switch_mutex_unlock(sql_manager.dbh_mutex);
 }
 
-static switch_cache_db_handle_t *get_handle(const char *db_str, const char *user_str, const char *thread_str)
+static switch_cache_db_handle_t *get_handle(switch_cache_db_pool_t *db_pool, const char *user_str, const char *thread_str)
 {
 	switch_ssize_t hlen = -1;
-	unsigned long hash = 0, thread_hash = 0;
+	unsigned long thread_hash = 0;
 	switch_cache_db_handle_t *dbh_ptr, *r = NULL;
 
-	hash = switch_ci_hashfunc_default(db_str, &hlen);
 	thread_hash = switch_ci_hashfunc_default(thread_str, &hlen);
 
-	switch_mutex_lock(sql_manager.dbh_mutex);
+	switch_mutex_lock(db_pool->mutex);
 
 	/* First loop allows a thread to use a handle multiple times sumiltaneously
 	   but only if that handle is in use by the same thread. In that case use_count will be incremented.
 	   This allows SQLite to read and write within a single thread, giving the same handle for both operations.
 	*/
-	for (dbh_ptr = sql_manager.handle_pool; dbh_ptr; dbh_ptr = dbh_ptr->next) {
-		if (dbh_ptr->thread_hash == thread_hash && dbh_ptr->hash == hash &&
+	for (dbh_ptr = db_pool->handles; dbh_ptr; dbh_ptr = dbh_ptr->pool_next) {
+		if (dbh_ptr->thread_hash == thread_hash &&
 			!switch_test_flag(dbh_ptr, CDF_PRUNE) && switch_mutex_trylock(dbh_ptr->mutex) == SWITCH_STATUS_SUCCESS) {
 			r = dbh_ptr;
+			db_pool->affinity_hits++;
 			break;
 		}
 	}
@@ -206,24 +368,28 @@ static switch_cache_db_handle_t *get_handle(const char *db_str, const char *user
 		/* If a handle idles, take it and associate with the thread.
 		   If a handle is in use, skip and create new one.
 		*/
-		for (dbh_ptr = sql_manager.handle_pool; dbh_ptr; dbh_ptr = dbh_ptr->next) {
-			if (dbh_ptr->hash == hash && !dbh_ptr->use_count && !switch_test_flag(dbh_ptr, CDF_PRUNE) &&
+		for (dbh_ptr = db_pool->idle; dbh_ptr; dbh_ptr = dbh_ptr->idle_next) {
+			if (!dbh_ptr->use_count && !switch_test_flag(dbh_ptr, CDF_PRUNE) &&
 				switch_mutex_trylock(dbh_ptr->mutex) == SWITCH_STATUS_SUCCESS) {
 				r = dbh_ptr;
 				r->thread_hash = thread_hash;
+				db_pool->idle_hits++;
 				break;
 			}
 		}
 	}
 
 	if (r) {
-		r->use_count++;
+		db_pool_idle_remove(db_pool, r);
+		if (!r->use_count++) {
+			db_pool->used++;
+		}
 		r->total_used_count++;
-		sql_manager.total_used_handles++;
+		switch_atomic_inc(&sql_manager.total_used_handles);
 		switch_set_string(r->last_user, user_str);
 	}
 
-	switch_mutex_unlock(sql_manager.dbh_mutex);
+	switch_mutex_unlock(db_pool->mutex);
 
 	return r;
 
@@ -348,6 +514,8 @@ SWITCH_DECLARE(void) switch_cache_db_flush_handles(void)
 
 SWITCH_DECLARE(void) switch_cache_db_release_db_handle(switch_cache_db_handle_t **dbh)
 {
+	switch_cache_db_pool_t *db_pool = NULL;
+
 	if (dbh && *dbh) {
 
 		switch((*dbh)->type) {
@@ -362,16 +530,28 @@ SWITCH_DECLARE(void) switch_cache_db_release_db_handle(switch_cache_db_handle_t
 		}
 
 		(*dbh)->last_used = switch_epoch_time_now(NULL);
-		if ((*dbh)->use_count) {
-			--(*dbh)->use_count;
+
+		if ((db_pool = (*dbh)->db_pool)) {
+			switch_mutex_lock(db_pool->mutex);
+		}
+
+		if ((*dbh)->use_count && !--(*dbh)->use_count && db_pool) {
+			db_pool->used--;
+			db_pool_idle_push(db_pool, *dbh);
+			if (db_pool->waiting) {
+				switch_thread_cond_signal(db_pool->cond);
+			}
+		}
+
+		if (db_pool) {
+			switch_mutex_unlock(db_pool->mutex);
 		}
 
 		switch_mutex_unlock((*dbh)->mutex);
 		*dbh = NULL;
 
-		switch_mutex_lock(sql_manager.dbh_mutex);
-		sql_manager.total_used_handles--;
-		switch_mutex_unlock(sql_manager.dbh_mutex);
+		switch_atomic_dec(&sql_manager.total_used_handles);
+		db_slot_wake();
 	}
 }
 
@@ -514,30 +694,16 @@ SWITCH_DECLARE(switch_status_t) _switch_cache_db_get_db_handle(switch_cache_db_h
 	char db_str[CACHE_DB_LEN] = "";
 	char db_callsite_str[CACHE_DB_LEN] = "";
 	switch_cache_db_handle_t *new_dbh = NULL;
-	int waiting = 0;
-	uint32_t yield_len = 100000, total_yield = 0;
+	switch_cache_db_pool_t *db_pool;
+	int waiting = 0, reserved = 0;
+	uint32_t yield_len = 100000;
+	switch_time_t started = switch_micro_time_now();
 
 	const char *db_name = NULL;
 	const char *odbc_user = NULL;
 	const char *odbc_pass = NULL;
 	const char *db_type = NULL;
 
-	while(runtime.max_db_handles && sql_manager.total_handles >= runtime.max_db_handles && sql_manager.total_used_handles >= sql_manager.total_handles) {
-		if (!waiting++) {
-			switch_log_printf(SWITCH_CHANNEL_ID_LOG, file, func, line, NULL, SWITCH_LOG_WARNING, "Max handles %u exceeded, blocking....\n",
-							  runtime.max_db_handles);
-		}
-
-		switch_yield(yield_len);
-		total_yield += yield_len;
-
-		if (runtime.db_handle_timeout && total_yield > runtime.db_handle_timeout) {
-			switch_log_printf(SWITCH_CHANNEL_ID_LOG, file, func, line, NULL, SWITCH_LOG_ERROR, "Error connecting\n");
-			*dbh = NULL;
-			return SWITCH_STATUS_FALSE;
-		}
-	}
-
 	switch (type) {
 	case SCDB_TYPE_DATABASE_INTERFACE:
 		{
@@ -577,7 +743,64 @@ SWITCH_DECLARE(switch_status_t) _switch_cache_db_get_db_handle(switch_cache_db_h
 	snprintf(db_callsite_str, sizeof(db_callsite_str) - 1, "%s:%d", file, line);
 	snprintf(thread_str, sizeof(thread_str) - 1, "thread=\"%lu\"",  (unsigned long) (intptr_t) self);
 
-	if ((new_dbh = get_handle(db_str, db_callsite_str, thread_str))) {
+	db_pool = get_db_pool(db_str);
+
+	/* wait for a handle of this dsn to come back while no new one may be opened.
+	   the pool mutex is nested so it stays held across get_handle() and a release
+	   cannot slip in between the check and the wait */
+	switch_mutex_lock(db_pool->mutex);
+	while (!(new_dbh = get_handle(db_pool, db_callsite_str, thread_str))) {
+		switch_bool_t dsn_full = runtime.max_db_handles_per_dsn && db_pool->total >= runtime.max_db_handles_per_dsn;
+
+		/* count the new handle against both caps before connecting, so racing callers cannot overshoot them */
+		if (!dsn_full) {
+			switch_mutex_lock(sql_manager.slot_mutex);
+			if (db_slot_free()) {
+				sql_manager.total_handles++;
+				db_pool->total++;
+				reserved = 1;
+			}
+			switch_mutex_unlock(sql_manager.slot_mutex);
+			if (reserved) {
+				break;
+			}
+		}
+
+		if (!waiting++) {
+			switch_log_printf(SWITCH_CHANNEL_ID_LOG, file, func, line, NULL, SWITCH_LOG_WARNING, "Max handles %u exceeded, blocking....\n",
+							  dsn_full ? runtime.max_db_handles_per_dsn : runtime.max_db_handles);
+		}
+		db_pool->waits++;
+
+		if (dsn_full) {
+			/* only a handle of this dsn going away or idle helps */
+			db_pool->waiting++;
+			switch_thread_cond_timedwait(db_pool->cond, db_pool->mutex, yield_len);
+			db_pool->waiting--;
+		} else {
+			/* a release or close in any dsn may make room */
+			switch_mutex_lock(sql_manager.slot_mutex);
+			switch_mutex_unlock(db_pool->mutex);
+			switch_atomic_inc(&sql_manager.slot_waiting);
+			if (!db_slot_free()) {
+				switch_thread_cond_timedwait(sql_manager.slot_cond, sql_manager.slot_mutex, yield_len);
+			}
+			switch_atomic_dec(&sql_manager.slot_waiting);
+			switch_mutex_unlock(sql_manager.slot_mutex);
+			switch_mutex_lock(db_pool->mutex);
+		}
+
+		if (runtime.db_handle_timeout && switch_micro_time_now() - started > runtime.db_handle_timeout) {
+			db_pool->timeouts++;
+			switch_mutex_unlock(db_pool->mutex);
+			switch_log_printf(SWITCH_CHANNEL_ID_LOG, file, func, line, NULL, SWITCH_LOG_ERROR, "Error connecting\n");
+			*dbh = NULL;
+			return SWITCH_STATUS_FALSE;
+		}
+	}
+	switch_mutex_unlock(db_pool->mutex);
+
+	if (new_dbh) {
 		if (type == SCDB_TYPE_DATABASE_INTERFACE) {
 			switch_log_printf(SWITCH_CHANNEL_ID_LOG, file, func, line, NULL, SWITCH_LOG_DEBUG10,
 				"Reuse Unused Cached DB handle %s [Database interface prefix: %s]\n", new_dbh->name, connection_options->database_interface_options.prefix);
@@ -672,6 +895,8 @@ SWITCH_DECLARE(switch_status_t) _switch_cache_db_get_db_handle(switch_cache_db_h
 
 	if (new_dbh) {
 		new_dbh->last_used = switch_epoch_time_now(NULL);
+	} else if (reserved) {
+		db_pool_unreserve(db_pool);
 	}
 
 	*dbh = new_dbh;
@@ -3569,6 +3794,10 @@ switch_status_t switch_core_sqldb_start(switch_memory_pool_t *pool, switch_bool_
 
 	switch_mutex_init(&sql_manager.dbh_mutex, SWITCH_MUTEX_NESTED, sql_manager.memory_pool);
 	switch_mutex_init(&sql_manager.ctl_mutex, SWITCH_MUTEX_NESTED, sql_manager.memory_pool);
+	switch_mutex_init(&sql_manager.slot_mutex, SWITCH_MUTEX_NESTED, sql_manager.memory_pool);
+	switch_thread_cond_create(&sql_manager.slot_cond, sql_manager.memory_pool);
+	switch_thread_rwlock_create(&sql_manager.db_pools_rwlock, sql_manager.memory_pool);
+	switch_core_hash_init(&sql_manager.db_pools);
 
 	if (!sql_manager.manage) goto skip;
 
@@ -3930,27 +4159,77 @@ void switch_core_sqldb_stop(void)
 	sql_close(0);
 }
 
+/* sanitize password */
+static void cache_db_clean_name(const char *name, char *cleankey_str, size_t len)
+{
+	const char *needles[3];
+	const char *pos1 = NULL;
+	const char *pos2 = NULL;
+	int i = 0;
+
+	needles[0] = "pass=\"";
+	needles[1] = "password=";
+	needles[2] = "password='";
+
+	memset(cleankey_str, 0, len);
+	for (i = 0; i < 3; i++) {
+		if((pos1 = strstr(name, needles[i]))) {
+			pos1 += strlen(needles[i]);
+
+			if (!(pos2 = strstr(pos1, "\""))) {
+				if (!(pos2 = strstr(pos1, "'"))) {
+					if (!(pos2 = strstr(pos1, " "))) {
+						pos2 = pos1 + strlen(pos1);
+					}
+				}
+			}
+			strncpy(cleankey_str, name, pos1 - name);
+			strcpy(&cleankey_str[pos1 - name], pos2);
+			break;
+		}
+	}
+	if (i == 3) {
+		snprintf(cleankey_str, len, "%s", name);
+	}
+}
+
+SWITCH_DECLARE(void) switch_cache_db_pool_totals(uint32_t *pools, uint32_t *handles, uint32_t *used, uint64_t *waits)
+{
+	switch_cache_db_pool_t *db_pool;
+
+	*pools = *handles = *used = 0;
+	*waits = 0;
+
+	if (!sql_manager.db_pools_rwlock) {
+		return;
+	}
+
+	switch_thread_rwlock_rdlock(sql_manager.db_pools_rwlock);
+	for (db_pool = sql_manager.db_pool_list; db_pool; db_pool = db_pool->next) {
+		switch_mutex_lock(db_pool->mutex);
+		(*pools)++;
+		*handles += db_pool->total;
+		*used += db_pool->used;
+		*waits += db_pool->waits;
+		switch_mutex_unlock(db_pool->mutex);
+	}
+	switch_thread_rwlock_unlock(sql_manager.db_pools_rwlock);
+}
+
 SWITCH_DECLARE(void) switch_cache_db_status(switch_stream_handle_t *stream)
 {
 	/* return some status info suitable for the cli */
 	switch_cache_db_handle_t *dbh = NULL;
+	switch_cache_db_pool_t *db_pool = NULL;
 	switch_bool_t locked = SWITCH_FALSE;
 	time_t now = switch_epoch_time_now(NULL);
 	char cleankey_str[CACHE_DB_LEN];
-	char *pos1 = NULL;
-	char *pos2 = NULL;
 	int count = 0, used = 0;
 
 	switch_mutex_lock(sql_manager.dbh_mutex);
 
 	for (dbh = sql_manager.handle_pool; dbh; dbh = dbh->next) {
-		char *needles[3];
 		time_t diff = 0;
-		int i = 0;
-
-		needles[0] = "pass=\"";
-		needles[1] = "password=";
-		needles[2] = "password='";
 
 		diff = now - dbh->last_used;
 
@@ -3961,27 +4240,7 @@ SWITCH_DECLARE(void) switch_cache_db_status(switch_stream_handle_t *stream)
 			locked = SWITCH_TRUE;
 		}
 
-		/* sanitize password */
-		memset(cleankey_str, 0, sizeof(cleankey_str));
-		for (i = 0; i < 3; i++) {
-			if((pos1 = strstr(dbh->name, needles[i]))) {
-				pos1 += strlen(needles[i]);
-
-				if (!(pos2 = strstr(pos1, "\""))) {
-					if (!(pos2 = strstr(pos1, "'"))) {
-						if (!(pos2 = strstr(pos1, " "))) {
-							pos2 = pos1 + strlen(pos1);
-						}
-					}
-				}
-				strncpy(cleankey_str, dbh->name, pos1 - dbh->name);
-				strcpy(&cleankey_str[pos1 - dbh->name], pos2);
-				break;
-			}
-		}
-		if (i == 3) {
-			snprintf(cleankey_str, sizeof(cleankey_str), "%s", dbh->name);
-		}
+		cache_db_clean_name(dbh->name, cleankey_str, sizeof(cleankey_str));
 
 		count++;
 
@@ -4002,6 +4261,20 @@ SWITCH_DECLARE(void) switch_cache_db_status(switch_stream_handle_t *stream)
 	stream->write_function(stream, "%d total. %d in use.\n", count, used);
 
 	switch_mutex_unlock(sql_manager.dbh_mutex);
+
+	switch_thread_rwlock_rdlock(sql_manager.db_pools_rwlock);
+	for (db_pool = sql_manager.db_pool_list; db_pool; db_pool = db_pool->next) {
+		cache_db_clean_name(db_pool->name, cleankey_str, sizeof(cleankey_str));
+
+		switch_mutex_lock(db_pool->mutex);
+		stream->write_function(stream, "Pool %s\n\tHandles: %u, %u in use, %u waiting\n"
+							   "\tReused by same thread: %" SWITCH_UINT64_T_FMT ", from idle: %" SWITCH_UINT64_T_FMT ", opened: %" SWITCH_UINT64_T_FMT "\n"
+							   "\tWaits: %" SWITCH_UINT64_T_FMT ", timeouts: %" SWITCH_UINT64_T_FMT "\n",
+							   cleankey_str, db_pool->total, db_pool->used, db_pool->waiting,
+							   db_pool->affinity_hits, db_pool->idle_hits, db_pool->creates, db_pool->waits, db_pool->timeouts);
+		switch_mutex_unlock(db_pool->mutex);
+	}
+	switch_thread_rwlock_unlock(sql_manager.db_pools_rwlock);
 }
 
 SWITCH_DECLARE(char*)switch_sql_concat(void)
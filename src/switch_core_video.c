@@ -387,6 +387,459 @@ SWITCH_DECLARE(void) switch_img_attenuate(switch_image_t *img)
 
 }
 
+/* Image row kernels
+ *
+ * Blending an ARGB layer onto I420 and checking chroma key pixels against the
+ * last frame are done a row at a time by the kernels below.  Each one has a
+ * plain C version plus SSE2 and AVX2 versions on x86 built with gcc or clang,
+ * compiled with per function target attributes and picked at runtime by
+ * switch_img_simd_init().  All of them give the same bytes as the per pixel
+ * code they replaced.
+ */
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !defined(SWITCH_IMG_NO_SIMD)
+#define IMG_X86 1
+#include <immintrin.h>
+#define IMG_SSE2 __attribute__((target("sse2")))
+#define IMG_AVX2 __attribute__((target("avx2")))
+#endif
+
+/* pixels blended per pass, keeps the scratch rows on the stack */
+#define IMG_BLEND_CHUNK 512
+
+/* block of a non ARGB overlay converted on the stack per blend, both even so blocks never split a chroma sample */
+#define IMG_CONVERT_W 128
+#define IMG_CONVERT_H 16
+
+typedef struct {
+	const char *name;
+	/* alpha < 0 blends with the alpha of each source pixel and leaves fully transparent ones alone,
+	   otherwise alpha is used for every source pixel that is not fully transparent */
+	void (*blend_i420)(const uint8_t *argb, const uint8_t *y_in, const uint8_t *u_in, const uint8_t *v_in,
+					   uint8_t *y_out, uint8_t *u_out, uint8_t *v_out, int n, int alpha);
+	/* copies the cached alpha while every color channel is within 4 of the cached pixel,
+	   returns how many pixels matched */
+	int (*cache_run)(uint8_t *argb, const uint8_t *cache, int n);
+} img_impl_t;
+
+static void scalar_blend_i420(const uint8_t *argb, const uint8_t *y_in, const uint8_t *u_in, const uint8_t *v_in,
+							  uint8_t *y_out, uint8_t *u_out, uint8_t *v_out, int n, int alpha)
+{
+#ifdef SWITCH_HAVE_YUV
+	int i;
+
+	for (i = 0; i < n; i++) {
+		switch_rgb_color_t *rgb = (switch_rgb_color_t *)(argb + i * 4);
+		switch_yuv_color_t yuv;
+		switch_rgb_color_t RGB, c;
+		int a = alpha < 0 ? rgb->a : alpha;
+
+		yuv.y = y_in[i];
+		yuv.u = u_in[i];
+		yuv.v = v_in[i];
+
+		if (alpha < 0 && rgb->a == 0) {
+			y_out[i] = yuv.y;
+			u_out[i] = yuv.u;
+			v_out[i] = yuv.v;
+			continue;
+		}
+
+		if (alpha < 0 && rgb->a == 255) {
+			c = *rgb;
+		} else {
+			switch_color_yuv2rgb(&yuv, &RGB);
+
+			if (rgb->a == 0) {
+				c = RGB;
+			} else {
+				c.r = ((RGB.r * (255 - a)) >> 8) + ((rgb->r * a) >> 8);
+				c.g = ((RGB.g * (255 - a)) >> 8) + ((rgb->g * a) >> 8);
+				c.b = ((RGB.b * (255 - a)) >> 8) + ((rgb->b * a) >> 8);
+			}
+		}
+
+		switch_color_rgb2yuv(&c, &yuv);
+		y_out[i] = yuv.y;
+		u_out[i] = yuv.u;
+		v_out[i] = yuv.v;
+	}
+#endif
+}
+
+static int scalar_cache_run(uint8_t *argb, const uint8_t *cache, int n)
+{
+	int i;
+
+	for (i = 0; i < n; i++) {
+		switch_rgb_color_t *color = (switch_rgb_color_t *)(argb + i * 4);
+		const switch_rgb_color_t *cache_color = (const switch_rgb_color_t *)(cache + i * 4);
+
+		if (abs(color->r - cache_color->r) > 4 || abs(color->g - cache_color->g) > 4 || abs(color->b - cache_color->b) > 4) {
+			break;
+		}
+
+		color->a = cache_color->a;
+	}
+
+	return i;
+}
+
+static const img_impl_t img_scalar = {
+	"scalar", scalar_blend_i420, scalar_cache_run
+};
+
+#ifdef IMG_X86
+
+/* The color math runs in 16 bit lanes.  The yuv to rgb products need more
+ * than 16 bits, pre-shifting the difference so mulhi lands on the same
+ * >> 14 (or >> 10) keeps them exact.  x86 is little endian so an ARGB pixel
+ * is b, g, r, a in memory.
+ */
+
+IMG_SSE2 static void sse2_blend_i420(const uint8_t *argb, const uint8_t *y_in, const uint8_t *u_in, const uint8_t *v_in,
+									 uint8_t *y_out, uint8_t *u_out, uint8_t *v_out, int n, int alpha)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i ff = _mm_set1_epi32(0xff);
+	const __m128i k128 = _mm_set1_epi16(128);
+	const __m128i k255 = _mm_set1_epi16(255);
+	const __m128i k16 = _mm_set1_epi16(16);
+	const __m128i fixed = _mm_set1_epi16((short) (alpha < 0 ? 0 : alpha));
+	int i = 0;
+
+	for (; i + 8 <= n; i += 8) {
+		__m128i lo = _mm_loadu_si128((const __m128i *) (argb + i * 4));
+		__m128i hi = _mm_loadu_si128((const __m128i *) (argb + i * 4 + 16));
+		__m128i sb = _mm_packs_epi32(_mm_and_si128(lo, ff), _mm_and_si128(hi, ff));
+		__m128i sg = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(lo, 8), ff), _mm_and_si128(_mm_srli_epi32(hi, 8), ff));
+		__m128i sr = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(lo, 16), ff), _mm_and_si128(_mm_srli_epi32(hi, 16), ff));
+		__m128i sa = _mm_packs_epi32(_mm_srli_epi32(lo, 24), _mm_srli_epi32(hi, 24));
+		__m128i y = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *) (y_in + i)), zero);
+		__m128i u = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *) (u_in + i)), zero);
+		__m128i v = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *) (v_in + i)), zero);
+		__m128i du = _mm_slli_epi16(_mm_sub_epi16(u, k128), 2);
+		__m128i dv = _mm_sub_epi16(v, k128);
+		__m128i r, g, b, a, na, cr, cg, cb, oy, ou, ov, clear;
+
+		r = _mm_add_epi16(y, _mm_mulhi_epi16(_mm_slli_epi16(dv, 2), _mm_set1_epi16(22457)));
+		g = _mm_sub_epi16(_mm_sub_epi16(y, _mm_mulhi_epi16(_mm_slli_epi16(dv, 6), _mm_set1_epi16(715))),
+						  _mm_mulhi_epi16(du, _mm_set1_epi16(5532)));
+		b = _mm_add_epi16(y, _mm_mulhi_epi16(du, _mm_set1_epi16(28384)));
+		r = _mm_min_epi16(_mm_max_epi16(r, zero), k255);
+		g = _mm_min_epi16(_mm_max_epi16(g, zero), k255);
+		b = _mm_min_epi16(_mm_max_epi16(b, zero), k255);
+
+		a = alpha < 0 ? sa : fixed;
+		na = _mm_sub_epi16(k255, a);
+		cr = _mm_add_epi16(_mm_srli_epi16(_mm_mullo_epi16(r, na), 8), _mm_srli_epi16(_mm_mullo_epi16(sr, a), 8));
+		cg = _mm_add_epi16(_mm_srli_epi16(_mm_mullo_epi16(g, na), 8), _mm_srli_epi16(_mm_mullo_epi16(sg, a), 8));
+		cb = _mm_add_epi16(_mm_srli_epi16(_mm_mullo_epi16(b, na), 8), _mm_srli_epi16(_mm_mullo_epi16(sb, a), 8));
+
+		clear = _mm_cmpeq_epi16(sa, zero);
+
+		if (alpha < 0) {
+			__m128i solid = _mm_cmpeq_epi16(sa, k255);
+
+			cr = _mm_or_si128(_mm_and_si128(solid, sr), _mm_andnot_si128(solid, cr));
+			cg = _mm_or_si128(_mm_and_si128(solid, sg), _mm_andnot_si128(solid, cg));
+			cb = _mm_or_si128(_mm_and_si128(solid, sb), _mm_andnot_si128(solid, cb));
+		} else {
+			cr = _mm_or_si128(_mm_and_si128(clear, r), _mm_andnot_si128(clear, cr));
+			cg = _mm_or_si128(_mm_and_si128(clear, g), _mm_andnot_si128(clear, cg));
+			cb = _mm_or_si128(_mm_and_si128(clear, b), _mm_andnot_si128(clear, cb));
+		}
+
+		/* y stays below 65536 so the unsigned shift is exact, u and v stay within a signed 16 bit range */
+		oy = _mm_add_epi16(_mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(cr, _mm_set1_epi16(66)),
+																	  _mm_mullo_epi16(cg, _mm_set1_epi16(129))),
+														_mm_add_epi16(_mm_mullo_epi16(cb, _mm_set1_epi16(25)), k128)), 8), k16);
+		ou = _mm_add_epi16(_mm_srai_epi16(_mm_add_epi16(_mm_sub_epi16(_mm_mullo_epi16(cb, _mm_set1_epi16(112)),
+																	  _mm_add_epi16(_mm_mullo_epi16(cr, _mm_set1_epi16(38)),
+																					_mm_mullo_epi16(cg, _mm_set1_epi16(74)))), k128), 8), k128);
+		ov = _mm_add_epi16(_mm_srai_epi16(_mm_add_epi16(_mm_sub_epi16(_mm_mullo_epi16(cr, _mm_set1_epi16(112)),
+																	  _mm_add_epi16(_mm_mullo_epi16(cg, _mm_set1_epi16(94)),
+																					_mm_mullo_epi16(cb, _mm_set1_epi16(18)))), k128), 8), k128);
+
+		if (alpha < 0) {
+			oy = _mm_or_si128(_mm_and_si128(clear, y), _mm_andnot_si128(clear, oy));
+			ou = _mm_or_si128(_mm_and_si128(clear, u), _mm_andnot_si128(clear, ou));
+			ov = _mm_or_si128(_mm_and_si128(clear, v), _mm_andnot_si128(clear, ov));
+		}
+
+		_mm_storel_epi64((__m128i *) (y_out + i), _mm_packus_epi16(oy, oy));
+		_mm_storel_epi64((__m128i *) (u_out + i), _mm_packus_epi16(ou, ou));
+		_mm_storel_epi64((__m128i *) (v_out + i), _mm_packus_epi16(ov, ov));
+	}
+
+	if (i < n) {
+		scalar_blend_i420(argb + i * 4, y_in + i, u_in + i, v_in + i, y_out + i, u_out + i, v_out + i, n - i, alpha);
+	}
+}
+
+IMG_SSE2 static int sse2_cache_run(uint8_t *argb, const uint8_t *cache, int n)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i four = _mm_set1_epi8(4);
+	const __m128i amask = _mm_set1_epi32((int) 0xff000000);
+	int i = 0;
+
+	for (; i + 4 <= n; i += 4) {
+		__m128i p = _mm_loadu_si128((const __m128i *) (argb + i * 4));
+		__m128i c = _mm_loadu_si128((const __m128i *) (cache + i * 4));
+		__m128i d = _mm_or_si128(_mm_subs_epu8(p, c), _mm_subs_epu8(c, p));
+
+		/* alpha bytes never count */
+		if ((_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_subs_epu8(d, four), zero)) | 0x8888) != 0xffff) {
+			break;
+		}
+
+		_mm_storeu_si128((__m128i *) (argb + i * 4), _mm_or_si128(_mm_and_si128(c, amask), _mm_andnot_si128(amask, p)));
+	}
+
+	return i + scalar_cache_run(argb + i * 4, cache + i * 4, n - i);
+}
+
+static const img_impl_t img_sse2 = {
+	"sse2", sse2_blend_i420, sse2_cache_run
+};
+
+IMG_AVX2 static void avx2_blend_i420(const uint8_t *argb, const uint8_t *y_in, const uint8_t *u_in, const uint8_t *v_in,
+									 uint8_t *y_out, uint8_t *u_out, uint8_t *v_out, int n, int alpha)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i ff = _mm256_set1_epi32(0xff);
+	const __m256i k128 = _mm256_set1_epi16(128);
+	const __m256i k255 = _mm256_set1_epi16(255);
+	const __m256i k16 = _mm256_set1_epi16(16);
+	const __m256i fixed = _mm256_set1_epi16((short) (alpha < 0 ? 0 : alpha));
+	int i = 0;
+
+	for (; i + 16 <= n; i += 16) {
+		__m256i lo = _mm256_loadu_si256((const __m256i *) (argb + i * 4));
+		__m256i hi = _mm256_loadu_si256((const __m256i *) (argb + i * 4 + 32));
+		/* packs works per 128 bit lane, the permute puts the pixels back in order */
+		__m256i sb = _mm256_permute4x64_epi64(_mm256_packs_epi32(_mm256_and_si256(lo, ff), _mm256_and_si256(hi, ff)), 0xD8);
+		__m256i sg = _mm256_permute4x64_epi64(_mm256_packs_epi32(_mm256_and_si256(_mm256_srli_epi32(lo, 8), ff),
+																 _mm256_and_si256(_mm256_srli_epi32(hi, 8), ff)), 0xD8);
+		__m256i sr = _mm256_permute4x64_epi64(_mm256_packs_epi32(_mm256_and_si256(_mm256_srli_epi32(lo, 16), ff),
+																 _mm256_and_si256(_mm256_srli_epi32(hi, 16), ff)), 0xD8);
+		__m256i sa = _mm256_permute4x64_epi64(_mm256_packs_epi32(_mm256_srli_epi32(lo, 24), _mm256_srli_epi32(hi, 24)), 0xD8);
+		__m256i y = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (y_in + i)));
+		__m256i u = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (u_in + i)));
+		__m256i v = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (v_in + i)));
+		__m256i du = _mm256_slli_epi16(_mm256_sub_epi16(u, k128), 2);
+		__m256i dv = _mm256_sub_epi16(v, k128);
+		__m256i r, g, b, a, na, cr, cg, cb, oy, ou, ov, clear;
+
+		r = _mm256_add_epi16(y, _mm256_mulhi_epi16(_mm256_slli_epi16(dv, 2), _mm256_set1_epi16(22457)));
+		g = _mm256_sub_epi16(_mm256_sub_epi16(y, _mm256_mulhi_epi16(_mm256_slli_epi16(dv, 6), _mm256_set1_epi16(715))),
+							 _mm256_mulhi_epi16(du, _mm256_set1_epi16(5532)));
+		b = _mm256_add_epi16(y, _mm256_mulhi_epi16(du, _mm256_set1_epi16(28384)));
+		r = _mm256_min_epi16(_mm256_max_epi16(r, zero), k255);
+		g = _mm256_min_epi16(_mm256_max_epi16(g, zero), k255);
+		b = _mm256_min_epi16(_mm256_max_epi16(b, zero), k255);
+
+		a = alpha < 0 ? sa : fixed;
+		na = _mm256_sub_epi16(k255, a);
+		cr = _mm256_add_epi16(_mm256_srli_epi16(_mm256_mullo_epi16(r, na), 8), _mm256_srli_epi16(_mm256_mullo_epi16(sr, a), 8));
+		cg = _mm256_add_epi16(_mm256_srli_epi16(_mm256_mullo_epi16(g, na), 8), _mm256_srli_epi16(_mm256_mullo_epi16(sg, a), 8));
+		cb = _mm256_add_epi16(_mm256_srli_epi16(_mm256_mullo_epi16(b, na), 8), _mm256_srli_epi16(_mm256_mullo_epi16(sb, a), 8));
+
+		clear = _mm256_cmpeq_epi16(sa, zero);
+
+		if (alpha < 0) {
+			__m256i solid = _mm256_cmpeq_epi16(sa, k255);
+
+			cr = _mm256_blendv_epi8(cr, sr, solid);
+			cg = _mm256_blendv_epi8(cg, sg, solid);
+			cb = _mm256_blendv_epi8(cb, sb, solid);
+		} else {
+			cr = _mm256_blendv_epi8(cr, r, clear);
+			cg = _mm256_blendv_epi8(cg, g, clear);
+			cb = _mm256_blendv_epi8(cb, b, clear);
+		}
+
+		oy = _mm256_add_epi16(_mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(_mm256_mullo_epi16(cr, _mm256_set1_epi16(66)),
+																				 _mm256_mullo_epi16(cg, _mm256_set1_epi16(129))),
+																_mm256_add_epi16(_mm256_mullo_epi16(cb, _mm256_set1_epi16(25)), k128)), 8), k16);
+		ou = _mm256_add_epi16(_mm256_srai_epi16(_mm256_add_epi16(_mm256_sub_epi16(_mm256_mullo_epi16(cb, _mm256_set1_epi16(112)),
+																				 _mm256_add_epi16(_mm256_mullo_epi16(cr, _mm256_set1_epi16(38)),
+																								  _mm256_mullo_epi16(cg, _mm256_set1_epi16(74)))),
+																k128), 8), k128);
+		ov = _mm256_add_epi16(_mm256_srai_epi16(_mm256_add_epi16(_mm256_sub_epi16(_mm256_mullo_epi16(cr, _mm256_set1_epi16(112)),
+																				 _mm256_add_epi16(_mm256_mullo_epi16(cg, _mm256_set1_epi16(94)),
+																								  _mm256_mullo_epi16(cb, _mm256_set1_epi16(18)))),
+																k128), 8), k128);
+
+		if (alpha < 0) {
+			oy = _mm256_blendv_epi8(oy, y, clear);
+			ou = _mm256_blendv_epi8(ou, u, clear);
+			ov = _mm256_blendv_epi8(ov, v, clear);
+		}
+
+		_mm_storeu_si128((__m128i *) (y_out + i), _mm256_castsi256_si128(_mm256_permute4x64_epi64(_mm256_packus_epi16(oy, oy), 0xD8)));
+		_mm_storeu_si128((__m128i *) (u_out + i), _mm256_castsi256_si128(_mm256_permute4x64_epi64(_mm256_packus_epi16(ou, ou), 0xD8)));
+		_mm_storeu_si128((__m128i *) (v_out + i), _mm256_castsi256_si128(_mm256_permute4x64_epi64(_mm256_packus_epi16(ov, ov), 0xD8)));
+	}
+
+	if (i < n) {
+		sse2_blend_i420(argb + i * 4, y_in + i, u_in + i, v_in + i, y_out + i, u_out + i, v_out + i, n - i, alpha);
+	}
+}
+
+IMG_AVX2 static int avx2_cache_run(uint8_t *argb, const uint8_t *cache, int n)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i four = _mm256_set1_epi8(4);
+	const __m256i amask = _mm256_set1_epi32((int) 0xff000000);
+	int i = 0;
+
+	for (; i + 8 <= n; i += 8) {
+		__m256i p = _mm256_loadu_si256((const __m256i *) (argb + i * 4));
+		__m256i c = _mm256_loadu_si256((const __m256i *) (cache + i * 4));
+		__m256i d = _mm256_or_si256(_mm256_subs_epu8(p, c), _mm256_subs_epu8(c, p));
+
+		if (((uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_subs_epu8(d, four), zero)) | 0x88888888) != 0xffffffff) {
+			break;
+		}
+
+		_mm256_storeu_si256((__m256i *) (argb + i * 4), _mm256_blendv_epi8(p, c, amask));
+	}
+
+	return i + sse2_cache_run(argb + i * 4, cache + i * 4, n - i);
+}
+
+static const img_impl_t img_avx2 = {
+	"avx2", avx2_blend_i420, avx2_cache_run
+};
+
+#endif
+
+static const img_impl_t *img_simd = &img_scalar;
+
+static const img_impl_t *img_simd_best(void)
+{
+#ifdef IMG_X86
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("avx2")) {
+		return &img_avx2;
+	}
+
+	if (__builtin_cpu_supports("sse2")) {
+		return &img_sse2;
+	}
+#endif
+
+	return &img_scalar;
+}
+
+SWITCH_DECLARE(void) switch_img_simd_init(void)
+{
+	img_simd = img_simd_best();
+}
+
+SWITCH_DECLARE(switch_status_t) switch_img_simd_set_impl(const char *name)
+{
+	const img_impl_t *best = img_simd_best();
+
+	if (zstr(name) || !strcasecmp(name, "auto")) {
+		img_simd = best;
+		return SWITCH_STATUS_SUCCESS;
+	}
+
+	if (!strcasecmp(name, img_scalar.name)) {
+		img_simd = &img_scalar;
+		return SWITCH_STATUS_SUCCESS;
+	}
+
+#ifdef IMG_X86
+	if (!strcasecmp(name, img_sse2.name) && best != &img_scalar) {
+		img_simd = &img_sse2;
+		return SWITCH_STATUS_SUCCESS;
+	}
+
+	if (!strcasecmp(name, img_avx2.name) && best == &img_avx2) {
+		img_simd = &img_avx2;
+		return SWITCH_STATUS_SUCCESS;
+	}
+#endif
+
+	return SWITCH_STATUS_FALSE;
+}
+
+SWITCH_DECLARE(const char *) switch_img_simd_impl_name(void)
+{
+	return img_simd->name;
+}
+
+#ifdef SWITCH_HAVE_YUV
+/* Blend w x h ARGB pixels onto an I420 image at x, y (already clipped to it).
+ * Drawing one pixel at a time lets the top left pixel of each 2x2 block see
+ * the old chroma and write the new one, and the other three see what it wrote.
+ * Even rows are run twice to keep that: once for the even columns, then again
+ * over the updated chroma for the odd ones.
+ */
+static void img_blend_i420(switch_image_t *IMG, const uint8_t *src, int src_stride, int x, int y, int w, int h, int alpha)
+{
+	uint8_t u_in[IMG_BLEND_CHUNK], v_in[IMG_BLEND_CHUNK];
+	uint8_t y_tmp[IMG_BLEND_CHUNK], u_tmp[IMG_BLEND_CHUNK], v_tmp[IMG_BLEND_CHUNK];
+	int X, i, k;
+
+	for (X = x; X < x + w; ) {
+		/* chunks after the first start on an even column so they never split a block */
+		int n = MIN(x + w - X, IMG_BLEND_CHUNK - (X & 1));
+		int expanded = 0;
+
+		for (i = 0; i < h; i++) {
+			int row = y + i;
+			uint8_t *yp = IMG->planes[SWITCH_PLANE_Y] + IMG->stride[SWITCH_PLANE_Y] * row + X;
+			uint8_t *up = IMG->planes[SWITCH_PLANE_U] + IMG->stride[SWITCH_PLANE_U] * (row / 2);
+			uint8_t *vp = IMG->planes[SWITCH_PLANE_V] + IMG->stride[SWITCH_PLANE_V] * (row / 2);
+			const uint8_t *argb = src + src_stride * i + (X - x) * 4;
+
+			/* an odd row reuses the chroma the even row above it just wrote */
+			if (!expanded) {
+				for (k = 0; k < n; k++) {
+					u_in[k] = up[(X + k) / 2];
+					v_in[k] = vp[(X + k) / 2];
+				}
+			}
+
+			if (row & 1) {
+				img_simd->blend_i420(argb, yp, u_in, v_in, yp, u_tmp, v_tmp, n, alpha);
+				expanded = 0;
+				continue;
+			}
+
+			img_simd->blend_i420(argb, yp, u_in, v_in, y_tmp, u_tmp, v_tmp, n, alpha);
+
+			for (k = X & 1; k < n; k += 2) {
+				yp[k] = y_tmp[k];
+				up[(X + k) / 2] = u_tmp[k];
+				vp[(X + k) / 2] = v_tmp[k];
+			}
+
+			for (k = 0; k < n; k++) {
+				u_in[k] = up[(X + k) / 2];
+				v_in[k] = vp[(X + k) / 2];
+			}
+
+			img_simd->blend_i420(argb, yp, u_in, v_in, y_tmp, u_tmp, v_tmp, n, alpha);
+
+			for (k = !(X & 1); k < n; k += 2) {
+				yp[k] = y_tmp[k];
+			}
+
+			expanded = 1;
+		}
+
+		X += n;
+	}
+}
+#endif
+
 SWITCH_DECLARE(void) switch_img_patch_rgb(switch_image_t *IMG, switch_image_t *img, int x, int y, switch_bool_t noalpha)
 {
 #ifdef SWITCH_HAVE_YUV
@@ -451,32 +904,20 @@ SWITCH_DECLARE(void) switch_img_patch(switch_image_t *IMG, switch_image_t *img,
 	switch_assert(IMG->fmt == SWITCH_IMG_FMT_I420);
 
 	if (img->fmt == SWITCH_IMG_FMT_ARGB) {
+#ifdef SWITCH_HAVE_YUV
 		int max_w = MIN(img->d_w, IMG->d_w - abs(x));
 		int max_h = MIN(img->d_h, IMG->d_h - abs(y));
-		int j;
-		uint8_t alpha;
-		switch_rgb_color_t *rgb;
+		int j0 = MAX(0, -x), i0 = MAX(0, -y);
 
-		for (i = 0; i < max_h; i++) {
-			for (j = 0; j < max_w; j++) {
-				rgb = (switch_rgb_color_t *)(img->planes[SWITCH_PLANE_PACKED] + i * img->stride[SWITCH_PLANE_PACKED] + j * 4);
-				alpha = rgb->a;
+		/* only the part that lands inside IMG */
+		max_w = MIN(max_w, (int)IMG->d_w - x);
+		max_h = MIN(max_h, (int)IMG->d_h - y);
 
-				if (alpha == 255) {
-					switch_img_draw_pixel(IMG, x + j, y + i, rgb);
-				} else if (alpha != 0) {
-					switch_rgb_color_t RGB = { 0 };
-					
-					switch_img_get_rgb_pixel(IMG, &RGB, x + j, y + i);
-					RGB.a = 255;
-					RGB.r = ((RGB.r * (255 - alpha)) >> 8) + ((rgb->r * alpha) >> 8);
-					RGB.g = ((RGB.g * (255 - alpha)) >> 8) + ((rgb->g * alpha) >> 8);
-					RGB.b = ((RGB.b * (255 - alpha)) >> 8) + ((rgb->b * alpha) >> 8);
-					
-					switch_img_draw_pixel(IMG, x + j, y + i, &RGB);
-				}
-			}
+		if (max_w > j0 && max_h > i0) {
+			img_blend_i420(IMG, img->planes[SWITCH_PLANE_PACKED] + i0 * img->stride[SWITCH_PLANE_PACKED] + j0 * 4,
+						   img->stride[SWITCH_PLANE_PACKED], x + j0, y + i0, max_w - j0, max_h - i0, -1);
 		}
+#endif
 
 		return;
 
@@ -1247,8 +1688,22 @@ SWITCH_DECLARE(void) switch_chromakey_process(switch_chromakey_t *ck, switch_ima
 
 		if (!ck->no_cache && cache_img && cache_pixel) {
 			switch_rgb_color_t *cache_color = (switch_rgb_color_t *)cache_pixel;
-				
-			if (switch_color_distance_cheap(color, cache_color) < 5) {
+
+			if (ck->autocolor != SWITCH_SHADE_AUTO) {
+				/* nothing but the alpha changes on a cache hit unless we are learning the color, take the whole run at once */
+				int run = img_simd->cache_run(pixel, cache_pixel, (int)((end_pixel - pixel) / 4));
+
+				if (run) {
+#ifdef DEBUG_CHROMA
+					other_img_cached += run;
+					total_pixel += run - 1;
+#endif
+					pixel += (run - 1) * 4;
+					cache_pixel += (run - 1) * 4;
+					color = (switch_rgb_color_t *)pixel;
+					goto end;
+				}
+			} else if (switch_color_distance_cheap(color, cache_color) < 5) {
 #ifdef DEBUG_CHROMA
 				other_img_cached++;
 #endif
@@ -1604,14 +2059,10 @@ SWITCH_DECLARE(void) switch_img_fill(switch_image_t *img, int x, int y, int w, i
 			memset(img->planes[SWITCH_PLANE_V] + img->stride[SWITCH_PLANE_V] * (i / 2) + x / 2, yuv_color.v, len);
 		}
 	} else if (img->fmt == SWITCH_IMG_FMT_ARGB) {
-		for (i = 0; i < img->d_w; i++) {
-			*((switch_rgb_color_t *)img->planes[SWITCH_PLANE_PACKED] + i) = *color;
-		}
+		uint32_t value;
 
-		for (i = 1; i < img->d_h; i++) {
-			memcpy( img->planes[SWITCH_PLANE_PACKED] + i * img->d_w * 4,
-					img->planes[SWITCH_PLANE_PACKED], img->d_w * 4);
-		}
+		memcpy(&value, color, sizeof(value));
+		ARGBRect(img->planes[SWITCH_PLANE_PACKED], img->stride[SWITCH_PLANE_PACKED], 0, 0, img->d_w, img->d_h, value);
 	}
 #endif
 }
@@ -1646,8 +2097,8 @@ static inline void switch_img_get_rgb_pixel(switch_image_t *img, switch_rgb_colo
 
 SWITCH_DECLARE(void) switch_img_overlay(switch_image_t *IMG, switch_image_t *img, int x, int y, uint8_t percent)
 {
+#ifdef SWITCH_HAVE_YUV
 	int i, j, len, max_h;
-	switch_rgb_color_t RGB = {0}, rgb = {0}, c = {0};
 	int xoff = 0, yoff = 0;
 	uint8_t alpha = (int8_t)((255 * percent) / 100);
 
@@ -1671,24 +2122,36 @@ SWITCH_DECLARE(void) switch_img_overlay(switch_image_t *IMG, switch_image_t *img
 	if (y & 1) y++;
 	if (len <= 0) return;
 
-	for (i = y; i < max_h; i++) {
-		for (j = 0; j < len; j++) {
-			switch_img_get_rgb_pixel(IMG, &RGB, x + j, i);
-			switch_img_get_rgb_pixel(img, &rgb, j + xoff, i - y + yoff);
-
-			if (rgb.a > 0) {
-				c.r = ((RGB.r * (255 - alpha)) >> 8) + ((rgb.r * alpha) >> 8);
-				c.g = ((RGB.g * (255 - alpha)) >> 8) + ((rgb.g * alpha) >> 8);
-				c.b = ((RGB.b * (255 - alpha)) >> 8) + ((rgb.b * alpha) >> 8);
-			} else {
-				c.r = RGB.r;
-				c.g = RGB.g;
-				c.b = RGB.b;
-			}
+	/* nothing to blend when the overlay is entirely off the canvas */
+	len = MIN(len, MIN((int)IMG->d_w - x, (int)img->d_w - xoff));
+	max_h = MIN(max_h, y + (int)img->d_h - yoff);
+	if (len <= 0 || y >= max_h) return;
+
+	if (img->fmt == SWITCH_IMG_FMT_ARGB) {
+		img_blend_i420(IMG, img->planes[SWITCH_PLANE_PACKED] + yoff * img->stride[SWITCH_PLANE_PACKED] + xoff * 4,
+					   img->stride[SWITCH_PLANE_PACKED], x, y, len, max_h - y, alpha);
+	} else {
+		/* blend from ARGB converted a block at a time, x and y are even here so every block starts on a chroma sample */
+		uint8_t argb[IMG_CONVERT_W * IMG_CONVERT_H * 4];
+		int bx, by, bw, bh;
+
+		for (by = 0; by < max_h - y; by += IMG_CONVERT_H) {
+			bh = MIN(IMG_CONVERT_H, max_h - y - by);
+
+			for (bx = 0; bx < len; bx += IMG_CONVERT_W) {
+				bw = MIN(IMG_CONVERT_W, len - bx);
 
-			switch_img_draw_pixel(IMG, x + j, i, &c);
+				for (i = 0; i < bh; i++) {
+					for (j = 0; j < bw; j++) {
+						switch_img_get_rgb_pixel(img, (switch_rgb_color_t *)(argb + (i * IMG_CONVERT_W + j) * 4), bx + j + xoff, by + i + yoff);
+					}
+				}
+
+				img_blend_i420(IMG, argb, IMG_CONVERT_W * 4, x + bx, y + by, bw, bh, alpha);
+			}
 		}
 	}
+#endif
 }
 
 static uint8_t scv_art[14][16] = {
@@ -0,0 +1,595 @@
+/*
+ * FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ * Copyright (C) 2005-2014, Anthony Minessale II <anthm@freeswitch.org>
+ *
+ * Version: MPL 1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ *
+ * The Initial Developer of the Original Code is
+ * Anthony Minessale II <anthm@freeswitch.org>
+ * Portions created by the Initial Developer are Copyright (C)
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *
+ *
+ * switch_core_video_encode.c -- Video encode offload pool
+ *
+ * Sessions hand the images they write to a shared set of encoder threads
+ * instead of encoding in their own thread.  Every session gets a lane: its
+ * frames are queued on the lane and a lane is run by at most one worker at a
+ * time, so one encoder never sees two frames at once and packets leave in
+ * the order the frames came in.  A lane that falls behind drops its oldest
+ * raw frames rather than adding latency.
+ *
+ * A frame is encoded into a list of packets first and the packets are then
+ * written in one go.  Workers never wait on a session: when it can't be
+ * written to right now the job goes back on its lane and is tried again
+ * later, or dropped once it has waited too long.  A thread taking over the
+ * writes of a session flushes its lane first, see
+ * switch_core_video_encode_pool_flush().
+ *
+ */
+
+#include "switch.h"
+
+#define VIDEO_ENCODE_LANE_KEY "__video_encode_lane"
+#define VIDEO_ENCODE_MAX_THREADS 128
+#define VIDEO_ENCODE_BUCKETS 8
+/* room left after an encoded packet for srtp to grow it in place */
+#define VIDEO_ENCODE_PACKET_TAIL 256
+/* usec an encoded frame may wait for its session to be writable */
+#define VIDEO_ENCODE_MAX_WRITE_WAIT 100000
+
+typedef struct video_encode_job_s {
+	switch_frame_t frame;
+	switch_image_t *img;
+	switch_io_flag_t flags;
+	int stream_id;
+	switch_time_t queued;
+	switch_time_t encoded;
+	switch_video_encode_func_t encode;
+	switch_video_encode_write_func_t write;
+	switch_frame_t *packets;
+	uint32_t packet_count;
+	uint32_t packet_alloc;
+	struct video_encode_job_s *next;
+} video_encode_job_t;
+
+/* a scheduled lane is on the queue or in a worker, and holds a read lock on its session while it is */
+typedef struct video_encode_lane_s {
+	switch_core_session_t *session;
+	switch_mutex_t *mutex;
+	video_encode_job_t *head;
+	video_encode_job_t *tail;
+	uint32_t pending;
+	uint8_t scheduled;
+	uint8_t busy;
+	uint32_t flushing;
+	switch_byte_t *packet;
+} video_encode_lane_t;
+
+static struct {
+	switch_memory_pool_t *pool;
+	switch_mutex_t *mutex;
+	switch_queue_t *queue;
+	switch_thread_t *threads[VIDEO_ENCODE_MAX_THREADS];
+	uint32_t thread_count;
+	uint32_t max_pending;
+	switch_bool_t affinity;
+	int running;
+	switch_atomic_t depth;
+	uint32_t max_depth;
+	uint64_t submitted;
+	uint64_t encoded;
+	uint64_t dropped;
+	uint64_t latency[VIDEO_ENCODE_BUCKETS];
+	uint64_t encode_time[VIDEO_ENCODE_BUCKETS];
+} video_encode;
+
+/* usec, the last bucket takes everything above the last bound */
+static const switch_time_t video_encode_bounds[VIDEO_ENCODE_BUCKETS - 1] = { 1000, 2000, 5000, 10000, 20000, 33000, 66000 };
+
+static int video_encode_bucket(switch_time_t usec)
+{
+	int b;
+
+	for (b = 0; b < VIDEO_ENCODE_BUCKETS - 1; b++) {
+		if (usec < video_encode_bounds[b]) {
+			break;
+		}
+	}
+
+	return b;
+}
+
+static void video_encode_job_free(video_encode_job_t **jobp)
+{
+	video_encode_job_t *job = *jobp;
+	uint32_t i;
+
+	if (job) {
+		for (i = 0; i < job->packet_count; i++) {
+			free(job->packets[i].packet);
+		}
+		switch_safe_free(job->packets);
+		switch_img_free(&job->img);
+		free(job);
+		*jobp = NULL;
+	}
+}
+
+static void video_encode_count(video_encode_job_t *job, switch_bool_t dropped)
+{
+	switch_mutex_lock(video_encode.mutex);
+	if (dropped) {
+		video_encode.dropped++;
+	} else {
+		video_encode.encoded++;
+		video_encode.latency[video_encode_bucket(switch_time_now() - job->queued)]++;
+	}
+	switch_mutex_unlock(video_encode.mutex);
+}
+
+/* keep a copy of the packet the encoder just put in frame */
+static void video_encode_keep(video_encode_job_t *job, switch_frame_t *frame)
+{
+	switch_frame_t *packet;
+	switch_byte_t *buf;
+
+	if (job->packet_count == job->packet_alloc) {
+		job->packet_alloc = job->packet_alloc ? job->packet_alloc * 2 : 8;
+		job->packets = realloc(job->packets, job->packet_alloc * sizeof(*job->packets));
+		switch_assert(job->packets);
+	}
+
+	buf = malloc(12 + frame->datalen + VIDEO_ENCODE_PACKET_TAIL);
+	switch_assert(buf);
+	memcpy(buf + 12, frame->data, frame->datalen);
+
+	packet = &job->packets[job->packet_count++];
+	*packet = *frame;
+	packet->img = NULL;
+	packet->packet = buf;
+	packet->data = buf + 12;
+	packet->buflen = frame->datalen + VIDEO_ENCODE_PACKET_TAIL;
+}
+
+/* encode the frame unless that was done on an earlier try, then write the packets */
+static switch_status_t video_encode_run(video_encode_lane_t *lane, video_encode_job_t *job)
+{
+	switch_status_t status = SWITCH_STATUS_SUCCESS;
+
+	if (switch_channel_down_nosig(switch_core_session_get_channel(lane->session))) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	if (!job->encoded) {
+		switch_frame_t frame = job->frame;
+		switch_time_t started = switch_time_now();
+
+		frame.img = job->img;
+		frame.packet = lane->packet;
+		frame.data = lane->packet + 12;
+		frame.buflen = SWITCH_RTP_MAX_BUF_LEN - 12;
+
+		do {
+			frame.datalen = 0;
+			status = job->encode(lane->session, &frame);
+
+			if ((status == SWITCH_STATUS_SUCCESS || status == SWITCH_STATUS_MORE_DATA) && frame.datalen) {
+				video_encode_keep(job, &frame);
+			}
+		} while (status == SWITCH_STATUS_MORE_DATA);
+
+		job->encoded = switch_time_now();
+		switch_img_free(&job->img);
+
+		switch_mutex_lock(video_encode.mutex);
+		video_encode.encode_time[video_encode_bucket(job->encoded - started)]++;
+		switch_mutex_unlock(video_encode.mutex);
+
+		if (status != SWITCH_STATUS_SUCCESS) {
+			return status;
+		}
+	}
+
+	if (!job->packet_count) {
+		return SWITCH_STATUS_SUCCESS;
+	}
+
+	return job->write(lane->session, job->packets, job->packet_count, job->flags, job->stream_id);
+}
+
+static void *SWITCH_THREAD_FUNC video_encode_thread(switch_thread_t *thread, void *obj)
+{
+	intptr_t cpu = (intptr_t) obj;
+	void *pop = NULL;
+
+	if (video_encode.affinity) {
+		switch_core_thread_set_cpu_affinity((int) cpu);
+	}
+
+	while (video_encode.running) {
+		video_encode_lane_t *lane;
+		video_encode_job_t *job;
+		switch_core_session_t *session;
+		switch_status_t status = SWITCH_STATUS_FALSE;
+		switch_bool_t release = SWITCH_FALSE, retry = SWITCH_FALSE;
+
+		if (switch_queue_pop(video_encode.queue, &pop) != SWITCH_STATUS_SUCCESS || !pop) {
+			continue;
+		}
+
+		lane = (video_encode_lane_t *) pop;
+		session = lane->session;
+
+		switch_mutex_lock(lane->mutex);
+		if ((job = lane->head)) {
+			if (!(lane->head = job->next)) {
+				lane->tail = NULL;
+			}
+			job->next = NULL;
+			lane->pending--;
+			lane->busy = 1;
+		}
+		switch_mutex_unlock(lane->mutex);
+
+		if (job) {
+			switch_atomic_dec(&video_encode.depth);
+			status = video_encode_run(lane, job);
+		}
+
+		switch_mutex_lock(lane->mutex);
+		if (job) {
+			/* somebody else is writing, try again later unless the lane is being flushed for them */
+			if (status == SWITCH_STATUS_INUSE && !lane->flushing && switch_time_now() - job->encoded < VIDEO_ENCODE_MAX_WRITE_WAIT) {
+				if (!(job->next = lane->head)) {
+					lane->tail = job;
+				}
+				lane->head = job;
+				lane->pending++;
+				switch_atomic_inc(&video_encode.depth);
+				retry = SWITCH_TRUE;
+			}
+			lane->busy = 0;
+		}
+		if (lane->head) {
+			/* back of the line so busy sessions take turns */
+			switch_queue_push(video_encode.queue, lane);
+		} else {
+			lane->scheduled = 0;
+			release = SWITCH_TRUE;
+		}
+		switch_mutex_unlock(lane->mutex);
+
+		if (job && !retry) {
+			video_encode_count(job, status == SWITCH_STATUS_INUSE ? SWITCH_TRUE : SWITCH_FALSE);
+			video_encode_job_free(&job);
+		}
+
+		if (release) {
+			switch_core_session_rwunlock(session);
+		}
+
+		if (retry) {
+			switch_cond_next();
+		}
+	}
+
+	return NULL;
+}
+
+SWITCH_DECLARE(switch_status_t) switch_core_video_encode_pool_start(uint32_t threads, uint32_t max_pending, switch_bool_t affinity)
+{
+	switch_threadattr_t *thd_attr;
+	int cpus = switch_core_cpu_count();
+	uint32_t i;
+
+	if (video_encode.running) {
+		if (threads != video_encode.thread_count) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "video-encode-threads changes need a restart, keeping %u\n",
+							  video_encode.thread_count);
+		}
+		video_encode.max_pending = max_pending ? max_pending : 1;
+		return SWITCH_STATUS_SUCCESS;
+	}
+
+	if (!threads) {
+		return SWITCH_STATUS_SUCCESS;
+	}
+
+	if (threads > VIDEO_ENCODE_MAX_THREADS) {
+		threads = VIDEO_ENCODE_MAX_THREADS;
+	}
+
+	if (!video_encode.pool) {
+		switch_core_new_memory_pool(&video_encode.pool);
+		switch_mutex_init(&video_encode.mutex, SWITCH_MUTEX_NESTED, video_encode.pool);
+		switch_queue_create(&video_encode.queue, SWITCH_CORE_QUEUE_LEN, video_encode.pool);
+	}
+
+	video_encode.max_pending = max_pending ? max_pending : 1;
+	video_encode.affinity = affinity;
+	video_encode.running = 1;
+
+	switch_threadattr_create(&thd_attr, video_encode.pool);
+	switch_threadattr_stacksize_set(thd_attr, SWITCH_THREAD_STACKSIZE);
+	switch_threadattr_priority_set(thd_attr, SWITCH_PRI_REALTIME);
+
+	for (i = 0; i < threads; i++) {
+		if (switch_thread_create(&video_encode.threads[i], thd_attr, video_encode_thread, (void *) (intptr_t) (cpus > 0 ? i % cpus : 0),
+								 video_encode.pool) != SWITCH_STATUS_SUCCESS) {
+			break;
+		}
+	}
+
+	video_encode.thread_count = i;
+
+	if (!i) {
+		video_encode.running = 0;
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Cannot start video encode threads\n");
+		return SWITCH_STATUS_FALSE;
+	}
+
+	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_INFO, "Video encode pool started with %u thread(s), %u frame(s) pending per session\n",
+					  video_encode.thread_count, video_encode.max_pending);
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+SWITCH_DECLARE(void) switch_core_video_encode_pool_stop(void)
+{
+	void *pop = NULL;
+	switch_status_t st;
+	uint32_t i;
+
+	if (!video_encode.running) {
+		return;
+	}
+
+	video_encode.running = 0;
+
+	switch_queue_interrupt_all(video_encode.queue);
+
+	for (i = 0; i < video_encode.thread_count; i++) {
+		switch_thread_join(&st, video_encode.threads[i]);
+		video_encode.threads[i] = NULL;
+	}
+
+	video_encode.thread_count = 0;
+
+	while (switch_queue_trypop(video_encode.queue, &pop) == SWITCH_STATUS_SUCCESS && pop) {
+		video_encode_lane_t *lane = (video_encode_lane_t *) pop;
+		video_encode_job_t *job;
+
+		switch_core_session_t *session = lane->session;
+
+		switch_mutex_lock(lane->mutex);
+		while ((job = lane->head)) {
+			lane->head = job->next;
+			video_encode_count(job, SWITCH_TRUE);
+			video_encode_job_free(&job);
+			switch_atomic_dec(&video_encode.depth);
+		}
+		lane->tail = NULL;
+		lane->pending = 0;
+		lane->scheduled = 0;
+		switch_mutex_unlock(lane->mutex);
+
+		switch_core_session_rwunlock(session);
+	}
+}
+
+SWITCH_DECLARE(switch_bool_t) switch_core_video_encode_pool_active(void)
+{
+	return video_encode.running ? SWITCH_TRUE : SWITCH_FALSE;
+}
+
+SWITCH_DECLARE(switch_status_t) switch_core_video_encode_pool_submit(switch_core_session_t *session, switch_frame_t *frame, switch_image_t **img,
+																	 switch_io_flag_t flags, int stream_id,
+																	 switch_video_encode_func_t encode, switch_video_encode_write_func_t write)
+{
+	switch_channel_t *channel = switch_core_session_get_channel(session);
+	video_encode_lane_t *lane;
+	video_encode_job_t *job, *drop = NULL;
+	switch_bool_t schedule = SWITCH_FALSE;
+	uint32_t depth;
+
+	if (!video_encode.running || !img || !*img) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	if (!(lane = switch_channel_get_private(channel, VIDEO_ENCODE_LANE_KEY))) {
+		lane = switch_core_session_alloc(session, sizeof(*lane));
+		lane->session = session;
+		lane->packet = switch_core_session_alloc(session, SWITCH_RTP_MAX_BUF_LEN);
+		switch_mutex_init(&lane->mutex, SWITCH_MUTEX_NESTED, switch_core_session_get_pool(session));
+		switch_channel_set_private(channel, VIDEO_ENCODE_LANE_KEY, lane);
+	}
+
+	switch_mutex_lock(lane->mutex);
+
+	if (lane->flushing) {
+		switch_mutex_unlock(lane->mutex);
+		return SWITCH_STATUS_FALSE;
+	}
+
+	if (!lane->scheduled) {
+		/* held until the lane runs dry */
+		if (switch_core_session_read_lock(session) != SWITCH_STATUS_SUCCESS) {
+			switch_mutex_unlock(lane->mutex);
+			return SWITCH_STATUS_FALSE;
+		}
+		lane->scheduled = 1;
+		schedule = SWITCH_TRUE;
+	}
+
+	switch_zmalloc(job, sizeof(*job));
+	job->frame = *frame;
+	job->frame.img = NULL;
+	job->img = *img;
+	*img = NULL;
+	job->flags = flags;
+	job->stream_id = stream_id;
+	job->queued = switch_time_now();
+	job->encode = encode;
+	job->write = write;
+
+	if (lane->tail) {
+		lane->tail->next = job;
+	} else {
+		lane->head = job;
+	}
+	lane->tail = job;
+
+	if (++lane->pending > video_encode.max_pending) {
+		drop = lane->head;
+		lane->head = drop->next;
+		lane->pending--;
+	}
+
+	if (schedule) {
+		switch_queue_push(video_encode.queue, lane);
+	}
+
+	switch_mutex_unlock(lane->mutex);
+
+	if (drop) {
+		video_encode_job_free(&drop);
+	} else {
+		switch_atomic_inc(&video_encode.depth);
+	}
+
+	depth = switch_atomic_read(&video_encode.depth);
+
+	switch_mutex_lock(video_encode.mutex);
+	video_encode.submitted++;
+	if (drop) {
+		video_encode.dropped++;
+	}
+	if (depth > video_encode.max_depth) {
+		video_encode.max_depth = depth;
+	}
+	switch_mutex_unlock(video_encode.mutex);
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+SWITCH_DECLARE(void) switch_core_video_encode_pool_flush(switch_core_session_t *session)
+{
+	video_encode_lane_t *lane;
+	video_encode_job_t *job, *next;
+
+	if (!(lane = switch_channel_get_private(switch_core_session_get_channel(session), VIDEO_ENCODE_LANE_KEY))) {
+		return;
+	}
+
+	switch_mutex_lock(lane->mutex);
+	lane->flushing++;
+	job = lane->head;
+	lane->head = lane->tail = NULL;
+	lane->pending = 0;
+	switch_mutex_unlock(lane->mutex);
+
+	/* the lane stays scheduled, the worker that pops it next finds it empty and lets the session go */
+	for (; job; job = next) {
+		next = job->next;
+		switch_atomic_dec(&video_encode.depth);
+		video_encode_count(job, SWITCH_TRUE);
+		video_encode_job_free(&job);
+	}
+
+	/* a frame in a worker drops itself once it sees the flush, or is written before we return */
+	for (;;) {
+		uint8_t busy;
+
+		switch_mutex_lock(lane->mutex);
+		busy = lane->busy;
+		switch_mutex_unlock(lane->mutex);
+
+		if (!busy) {
+			break;
+		}
+
+		switch_cond_next();
+	}
+
+	switch_mutex_lock(lane->mutex);
+	lane->flushing--;
+	switch_mutex_unlock(lane->mutex);
+}
+
+SWITCH_DECLARE(void) switch_core_video_encode_pool_counters(uint64_t *submitted, uint64_t *encoded, uint64_t *dropped)
+{
+	if (!video_encode.mutex) {
+		*submitted = *encoded = *dropped = 0;
+		return;
+	}
+
+	switch_mutex_lock(video_encode.mutex);
+	*submitted = video_encode.submitted;
+	*encoded = video_encode.encoded;
+	*dropped = video_encode.dropped;
+	switch_mutex_unlock(video_encode.mutex);
+}
+
+SWITCH_DECLARE(void) switch_core_video_encode_pool_stats(switch_stream_handle_t *stream, switch_bool_t reset)
+{
+	int b;
+
+	if (!video_encode.mutex) {
+		stream->write_function(stream, "Video encode pool disabled, set video-encode-threads in switch.conf to enable it\n");
+		return;
+	}
+
+	switch_mutex_lock(video_encode.mutex);
+
+	stream->write_function(stream, "%u thread(s), %u frame(s) pending per session\n", video_encode.thread_count, video_encode.max_pending);
+	stream->write_function(stream, "Queue depth: %u, max %u\n", switch_atomic_read(&video_encode.depth), video_encode.max_depth);
+	stream->write_function(stream, "Frames: %" SWITCH_UINT64_T_FMT " submitted, %" SWITCH_UINT64_T_FMT " encoded, %" SWITCH_UINT64_T_FMT " dropped\n",
+						   video_encode.submitted, video_encode.encoded, video_encode.dropped);
+	stream->write_function(stream, "%-10s %14s %14s\n", "usec", "frame latency", "encode time");
+
+	for (b = 0; b < VIDEO_ENCODE_BUCKETS; b++) {
+		char label[16];
+
+		if (b < VIDEO_ENCODE_BUCKETS - 1) {
+			switch_snprintf(label, sizeof(label), "<%" SWITCH_TIME_T_FMT, video_encode_bounds[b]);
+		} else {
+			switch_snprintf(label, sizeof(label), ">=%" SWITCH_TIME_T_FMT, video_encode_bounds[b - 1]);
+		}
+		stream->write_function(stream, "%-10s %14" SWITCH_UINT64_T_FMT " %14" SWITCH_UINT64_T_FMT "\n", label, video_encode.latency[b], video_encode.encode_time[b]);
+	}
+
+	if (reset) {
+		video_encode.max_depth = 0;
+		video_encode.submitted = video_encode.encoded = video_encode.dropped = 0;
+		memset(video_encode.latency, 0, sizeof(video_encode.latency));
+		memset(video_encode.encode_time, 0, sizeof(video_encode.encode_time));
+	}
+
+	switch_mutex_unlock(video_encode.mutex);
+}
+
+/* For Emacs:
+ * Local Variables:
+ * mode:c
+ * indent-tabs-mode:t
+ * tab-width:4
+ * c-basic-offset:4
+ * End:
+ * For VIM:
+ * vim:set softtabstop=4 shiftwidth=4 tabstop=4 noet:
+ */
@@ -1,6 +1,54 @@
 #include <switch.h>
 #include "switch_curl.h"
 #include <curl/curl.h>
+#include "private/switch_core_pvt.h"
+
+#define CURL_POOL_MAX_IDLE 64
+/* hosts tracked at once, the least recently used one makes room for a new one */
+#define CURL_POOL_MAX_HOSTS 256
+/* a host unused for this long is dropped with its idle handles and their connections */
+#define CURL_POOL_HOST_IDLE 300
+/* seconds the async transfers still running at shutdown get to finish */
+#define CURL_ASYNC_DRAIN 5
+
+/* Easy handles parked per scheme://host:port, curl keeps their connections alive between requests */
+typedef struct curl_pool_host_s {
+	char *name;
+	switch_CURL *idle[CURL_POOL_MAX_IDLE];
+	int idle_count;
+	uint64_t requests;
+	uint64_t reused;
+	uint64_t failed;
+	uint64_t http2;
+	double total_time;
+	double max_time;
+	time_t last_used;
+} curl_pool_host_t;
+
+typedef struct curl_async_request_s {
+	switch_CURL *handle;
+	switch_curl_async_callback_t callback;
+	void *user_data;
+	/* transfers on the multi handle, only the curl thread touches these */
+	struct curl_async_request_s *prev;
+	struct curl_async_request_s *next;
+} curl_async_request_t;
+
+static struct {
+	switch_memory_pool_t *pool;
+	switch_mutex_t *mutex;
+	switch_hash_t *hosts;
+	uint32_t host_count;
+	time_t last_sweep;
+	CURLSH *share;
+	switch_mutex_t *share_mutex[CURL_LOCK_DATA_LAST];
+	CURLM *multi;
+	switch_queue_t *async_queue;
+	switch_thread_t *async_thread;
+	curl_async_request_t *async_active;
+	uint32_t async_pending;
+	int running;
+} curl_pool;
 
 SWITCH_DECLARE(switch_CURL *) switch_curl_easy_init(void)
 {
@@ -48,13 +96,491 @@ SWITCH_DECLARE(const char *) switch_curl_easy_strerror(switch_CURLcode errornum
 	return curl_easy_strerror(errornum);
 }
 
+static void curl_share_lock(CURL *handle, curl_lock_data data, curl_lock_access access, void *userptr)
+{
+	if (data < CURL_LOCK_DATA_LAST) {
+		switch_mutex_lock(curl_pool.share_mutex[data]);
+	}
+}
+
+static void curl_share_unlock(CURL *handle, curl_lock_data data, void *userptr)
+{
+	if (data < CURL_LOCK_DATA_LAST) {
+		switch_mutex_unlock(curl_pool.share_mutex[data]);
+	}
+}
+
+/* scheme://host:port of url, lower cased and without credentials */
+static void curl_pool_host_key(const char *url, char *buf, switch_size_t len)
+{
+	const char *p, *host, *end, *at;
+	switch_size_t i = 0;
+
+	if ((p = strstr(url, "://"))) {
+		host = p + 3;
+	} else {
+		host = url;
+	}
+
+	end = host + strcspn(host, "/?#");
+
+	if ((at = memchr(host, '@', end - host))) {
+		while ((p = memchr(at + 1, '@', end - at - 1))) {
+			at = p;
+		}
+	}
+
+	for (p = url; p < host && i < len - 1; p++) {
+		buf[i++] = (char) switch_tolower(*p);
+	}
+
+	for (p = at ? at + 1 : host; p < end && i < len - 1; p++) {
+		buf[i++] = (char) switch_tolower(*p);
+	}
+
+	buf[i] = '\0';
+}
+
+static void curl_pool_host_destroy(curl_pool_host_t *host)
+{
+	int i;
+
+	for (i = 0; i < host->idle_count; i++) {
+		curl_easy_cleanup(host->idle[i]);
+	}
+
+	switch_safe_free(host->name);
+	free(host);
+}
+
+/* switch_core_hash_delete_multi() callback, pData points at the oldest last_used to keep or is NULL to drop them all */
+static switch_bool_t curl_pool_host_expired(const void *key, const void *val, void *pData)
+{
+	curl_pool_host_t *host = (curl_pool_host_t *) val;
+	time_t *keep = (time_t *) pData;
+
+	if (keep && host->last_used >= *keep) {
+		return SWITCH_FALSE;
+	}
+
+	curl_pool_host_destroy(host);
+	curl_pool.host_count--;
+
+	return SWITCH_TRUE;
+}
+
+/* called with curl_pool.mutex held */
+static void curl_pool_host_sweep(time_t now)
+{
+	time_t keep = now - CURL_POOL_HOST_IDLE;
+
+	if (now - curl_pool.last_sweep < 60) {
+		return;
+	}
+
+	curl_pool.last_sweep = now;
+	switch_core_hash_delete_multi(curl_pool.hosts, curl_pool_host_expired, &keep);
+}
+
+/* called with curl_pool.mutex held */
+static curl_pool_host_t *curl_pool_host_get(const char *key)
+{
+	curl_pool_host_t *host;
+	time_t now = switch_epoch_time_now(NULL);
+
+	curl_pool_host_sweep(now);
+
+	if (!(host = switch_core_hash_find(curl_pool.hosts, key))) {
+		if (curl_pool.host_count >= CURL_POOL_MAX_HOSTS) {
+			switch_hash_index_t *hi;
+			curl_pool_host_t *oldest = NULL;
+			void *val;
+
+			for (hi = switch_core_hash_first(curl_pool.hosts); hi; hi = switch_core_hash_next(&hi)) {
+				switch_core_hash_this(hi, NULL, NULL, &val);
+				if (!oldest || ((curl_pool_host_t *) val)->last_used < oldest->last_used) {
+					oldest = (curl_pool_host_t *) val;
+				}
+			}
+
+			if (oldest) {
+				switch_core_hash_delete(curl_pool.hosts, oldest->name);
+				curl_pool_host_destroy(oldest);
+				curl_pool.host_count--;
+			}
+		}
+
+		switch_zmalloc(host, sizeof(*host));
+		host->name = strdup(key);
+		switch_core_hash_insert(curl_pool.hosts, key, host);
+		curl_pool.host_count++;
+	}
+
+	host->last_used = now;
+
+	return host;
+}
+
+SWITCH_DECLARE(switch_CURL *) switch_curl_easy_acquire(const char *url)
+{
+	switch_CURL *handle = NULL;
+	curl_pool_host_t *host;
+	char key[256];
+
+	if (!curl_pool.running || !runtime.curl_pool_max_idle || zstr(url)) {
+		return switch_curl_easy_init();
+	}
+
+	curl_pool_host_key(url, key, sizeof(key));
+
+	switch_mutex_lock(curl_pool.mutex);
+	host = curl_pool_host_get(key);
+	if (host->idle_count) {
+		handle = host->idle[--host->idle_count];
+	}
+	switch_mutex_unlock(curl_pool.mutex);
+
+	if (handle) {
+		/* drops the options of the last user, keeps its connections, DNS and TLS session caches */
+		curl_easy_reset(handle);
+	} else if (!(handle = curl_easy_init())) {
+		return NULL;
+	}
+
+	curl_easy_setopt(handle, CURLOPT_SHARE, curl_pool.share);
+	curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+#if LIBCURL_VERSION_NUM >= 0x071900
+	curl_easy_setopt(handle, CURLOPT_TCP_KEEPALIVE, 1L);
+#endif
+#if LIBCURL_VERSION_NUM >= 0x072f00
+	curl_easy_setopt(handle, CURLOPT_HTTP_VERSION, (long) CURL_HTTP_VERSION_2TLS);
+#endif
+
+	return handle;
+}
+
+SWITCH_DECLARE(void) switch_curl_easy_release(switch_CURL *handle)
+{
+	curl_pool_host_t *host;
+	char *url = NULL;
+	char key[256];
+	long connects = 0, code = 0;
+	double total_time = 0;
+#if LIBCURL_VERSION_NUM >= 0x073200
+	long http_version = 0;
+#endif
+
+	if (!handle) {
+		return;
+	}
+
+	if (!curl_pool.running || !runtime.curl_pool_max_idle ||
+		curl_easy_getinfo(handle, CURLINFO_EFFECTIVE_URL, &url) != CURLE_OK || zstr(url)) {
+		curl_easy_cleanup(handle);
+		return;
+	}
+
+	curl_pool_host_key(url, key, sizeof(key));
+	curl_easy_getinfo(handle, CURLINFO_NUM_CONNECTS, &connects);
+	curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &code);
+	curl_easy_getinfo(handle, CURLINFO_TOTAL_TIME, &total_time);
+#if LIBCURL_VERSION_NUM >= 0x073200
+	curl_easy_getinfo(handle, CURLINFO_HTTP_VERSION, &http_version);
+#endif
+
+	/* write the cookie jar the caller may have set and forget the cookies, the next user must not see them */
+	curl_easy_setopt(handle, CURLOPT_COOKIELIST, "FLUSH");
+	curl_easy_setopt(handle, CURLOPT_COOKIELIST, "ALL");
+
+	switch_mutex_lock(curl_pool.mutex);
+	host = curl_pool_host_get(key);
+	host->requests++;
+	if (!code) {
+		host->failed++;
+	} else if (!connects) {
+		host->reused++;
+	}
+#if LIBCURL_VERSION_NUM >= 0x073200
+	if (http_version == CURL_HTTP_VERSION_2_0) {
+		host->http2++;
+	}
+#endif
+	host->total_time += total_time;
+	if (total_time > host->max_time) {
+		host->max_time = total_time;
+	}
+	if (code && host->idle_count < (int) runtime.curl_pool_max_idle && host->idle_count < CURL_POOL_MAX_IDLE) {
+		host->idle[host->idle_count++] = handle;
+		handle = NULL;
+	}
+	switch_mutex_unlock(curl_pool.mutex);
+
+	if (handle) {
+		curl_easy_cleanup(handle);
+	}
+}
+
+static void curl_async_add(curl_async_request_t *req)
+{
+	curl_easy_setopt(req->handle, CURLOPT_PRIVATE, (char *) req);
+#if LIBCURL_VERSION_NUM >= 0x072b00
+	/* wait for a connection to multiplex on rather than opening a new one */
+	curl_easy_setopt(req->handle, CURLOPT_PIPEWAIT, 1L);
+#endif
+
+	req->prev = NULL;
+	if ((req->next = curl_pool.async_active)) {
+		req->next->prev = req;
+	}
+	curl_pool.async_active = req;
+
+	curl_multi_add_handle(curl_pool.multi, req->handle);
+}
+
+/* hand a finished, aborted or never started transfer back to its owner */
+static void curl_async_done(curl_async_request_t *req, CURLcode code, switch_bool_t active)
+{
+	if (active) {
+		if (req->prev) {
+			req->prev->next = req->next;
+		} else {
+			curl_pool.async_active = req->next;
+		}
+		if (req->next) {
+			req->next->prev = req->prev;
+		}
+
+		curl_multi_remove_handle(curl_pool.multi, req->handle);
+		curl_easy_setopt(req->handle, CURLOPT_PRIVATE, NULL);
+	}
+
+	req->callback(req->handle, code, req->user_data);
+	free(req);
+
+	switch_mutex_lock(curl_pool.mutex);
+	curl_pool.async_pending--;
+	switch_mutex_unlock(curl_pool.mutex);
+}
+
+static void curl_async_reap(void)
+{
+	CURLMsg *msg;
+	int left = 0;
+
+	while ((msg = curl_multi_info_read(curl_pool.multi, &left))) {
+		curl_async_request_t *req = NULL;
+
+		if (msg->msg != CURLMSG_DONE) {
+			continue;
+		}
+
+		curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char **) &req);
+
+		if (req) {
+			curl_async_done(req, msg->data.result, SWITCH_TRUE);
+		}
+	}
+}
+
+static void *SWITCH_THREAD_FUNC curl_async_thread(switch_thread_t *thread, void *obj)
+{
+	switch_time_t deadline = 0;
+	uint32_t pending;
+	int running = 0;
+	void *pop;
+
+	for (;;) {
+		if (!curl_pool.running) {
+			/* no new requests once stopped, finish the ones we have for as long as the drain allows */
+			if (!deadline) {
+				deadline = switch_micro_time_now() + CURL_ASYNC_DRAIN * 1000000;
+			}
+
+			switch_mutex_lock(curl_pool.mutex);
+			pending = curl_pool.async_pending;
+			switch_mutex_unlock(curl_pool.mutex);
+
+			if (!pending || switch_micro_time_now() > deadline) {
+				break;
+			}
+		}
+
+		if (!running) {
+			/* nothing in flight, sleep on the queue */
+			pop = NULL;
+			if (switch_queue_pop_timeout(curl_pool.async_queue, &pop, 1000000) != SWITCH_STATUS_SUCCESS || !pop) {
+				continue;
+			}
+			curl_async_add((curl_async_request_t *) pop);
+		}
+
+		while (switch_queue_trypop(curl_pool.async_queue, &pop) == SWITCH_STATUS_SUCCESS) {
+			if (pop) {
+				curl_async_add((curl_async_request_t *) pop);
+			}
+		}
+
+		curl_multi_perform(curl_pool.multi, &running);
+		curl_async_reap();
+
+		if (running) {
+#if LIBCURL_VERSION_NUM >= 0x074400
+			curl_multi_poll(curl_pool.multi, NULL, 0, 1000, NULL);
+#elif LIBCURL_VERSION_NUM >= 0x071c00
+			curl_multi_wait(curl_pool.multi, NULL, 0, 10, NULL);
+#else
+			switch_yield(10000);
+#endif
+		}
+	}
+
+	if (curl_pool.async_active) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "Aborting %u HTTP transfer%s still running at shutdown\n",
+						  curl_pool.async_pending, curl_pool.async_pending == 1 ? "" : "s");
+	}
+
+	while (curl_pool.async_active) {
+		curl_async_done(curl_pool.async_active, CURLE_ABORTED_BY_CALLBACK, SWITCH_TRUE);
+	}
+
+	while (switch_queue_trypop(curl_pool.async_queue, &pop) == SWITCH_STATUS_SUCCESS) {
+		if (pop) {
+			curl_async_done((curl_async_request_t *) pop, CURLE_ABORTED_BY_CALLBACK, SWITCH_FALSE);
+		}
+	}
+
+	return NULL;
+}
+
+SWITCH_DECLARE(switch_status_t) switch_curl_easy_perform_async(switch_CURL *handle, switch_curl_async_callback_t callback, void *user_data)
+{
+	curl_async_request_t *req;
+	switch_status_t status = SWITCH_STATUS_FALSE;
+
+	if (!handle || !callback) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	switch_zmalloc(req, sizeof(*req));
+	req->handle = handle;
+	req->callback = callback;
+	req->user_data = user_data;
+
+	/* running only drops under the mutex, nothing is queued behind the drain */
+	switch_mutex_lock(curl_pool.mutex);
+	if (curl_pool.running) {
+		if (!curl_pool.async_thread) {
+			switch_threadattr_t *thd_attr = NULL;
+
+			switch_threadattr_create(&thd_attr, curl_pool.pool);
+			switch_threadattr_stacksize_set(thd_attr, SWITCH_THREAD_STACKSIZE);
+			switch_thread_create(&curl_pool.async_thread, thd_attr, curl_async_thread, NULL, curl_pool.pool);
+		}
+		if (switch_queue_trypush(curl_pool.async_queue, req) == SWITCH_STATUS_SUCCESS) {
+			curl_pool.async_pending++;
+			status = SWITCH_STATUS_SUCCESS;
+		}
+	}
+	switch_mutex_unlock(curl_pool.mutex);
+
+	if (status != SWITCH_STATUS_SUCCESS) {
+		free(req);
+		return status;
+	}
+
+#if LIBCURL_VERSION_NUM >= 0x074400
+	curl_multi_wakeup(curl_pool.multi);
+#endif
+
+	return status;
+}
+
+SWITCH_DECLARE(void) switch_curl_pool_status(switch_stream_handle_t *stream)
+{
+	switch_hash_index_t *hi;
+	void *val;
+
+	switch_mutex_lock(curl_pool.mutex);
+
+	stream->write_function(stream, "%-40s %10s %8s %8s %8s %9s %9s %5s\n",
+						   "host", "requests", "reused", "failed", "http2", "avg(ms)", "max(ms)", "idle");
+
+	for (hi = switch_core_hash_first(curl_pool.hosts); hi; hi = switch_core_hash_next(&hi)) {
+		curl_pool_host_t *host;
+
+		switch_core_hash_this(hi, NULL, NULL, &val);
+		host = (curl_pool_host_t *) val;
+
+		stream->write_function(stream, "%-40s %10" SWITCH_UINT64_T_FMT " %7.1f%% %8" SWITCH_UINT64_T_FMT " %8" SWITCH_UINT64_T_FMT " %9.1f %9.1f %5d\n",
+							   host->name, host->requests,
+							   host->requests ? (double) host->reused * 100 / host->requests : 0.0,
+							   host->failed, host->http2,
+							   host->requests ? host->total_time * 1000 / host->requests : 0.0,
+							   host->max_time * 1000, host->idle_count);
+	}
+
+	stream->write_function(stream, "\n%u host%s, async requests in flight: %u, max idle handles per host: %u\n",
+						   curl_pool.host_count, curl_pool.host_count == 1 ? "" : "s", curl_pool.async_pending, runtime.curl_pool_max_idle);
+
+	switch_mutex_unlock(curl_pool.mutex);
+}
+
 SWITCH_DECLARE(void) switch_curl_init(void)
 {
+	int i;
+
 	curl_global_init(CURL_GLOBAL_ALL);
+
+	memset(&curl_pool, 0, sizeof(curl_pool));
+	switch_core_new_memory_pool(&curl_pool.pool);
+	switch_mutex_init(&curl_pool.mutex, SWITCH_MUTEX_NESTED, curl_pool.pool);
+	switch_core_hash_init(&curl_pool.hosts);
+	switch_queue_create(&curl_pool.async_queue, SWITCH_CORE_QUEUE_LEN, curl_pool.pool);
+
+	for (i = 0; i < CURL_LOCK_DATA_LAST; i++) {
+		switch_mutex_init(&curl_pool.share_mutex[i], SWITCH_MUTEX_NESTED, curl_pool.pool);
+	}
+
+	curl_pool.share = curl_share_init();
+	curl_share_setopt(curl_pool.share, CURLSHOPT_LOCKFUNC, curl_share_lock);
+	curl_share_setopt(curl_pool.share, CURLSHOPT_UNLOCKFUNC, curl_share_unlock);
+	curl_share_setopt(curl_pool.share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+	curl_share_setopt(curl_pool.share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+
+	curl_pool.multi = curl_multi_init();
+#ifdef CURLPIPE_MULTIPLEX
+	curl_multi_setopt(curl_pool.multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+#endif
+
+	curl_pool.running = 1;
 }
 
 SWITCH_DECLARE(void) switch_curl_destroy(void)
 {
+	switch_status_t st;
+
+	if (curl_pool.running) {
+		switch_mutex_lock(curl_pool.mutex);
+		curl_pool.running = 0;
+		switch_core_hash_delete_multi(curl_pool.hosts, curl_pool_host_expired, NULL);
+		switch_mutex_unlock(curl_pool.mutex);
+
+		/* the thread finishes or aborts what is in flight, every request gets its callback */
+		if (curl_pool.async_thread) {
+			switch_queue_trypush(curl_pool.async_queue, NULL);
+#if LIBCURL_VERSION_NUM >= 0x074400
+			curl_multi_wakeup(curl_pool.multi);
+#endif
+			switch_thread_join(&st, curl_pool.async_thread);
+			curl_pool.async_thread = NULL;
+		}
+
+		curl_multi_cleanup(curl_pool.multi);
+		curl_share_cleanup(curl_pool.share);
+		switch_core_hash_destroy(&curl_pool.hosts);
+		switch_core_destroy_memory_pool(&curl_pool.pool);
+	}
+
 	curl_global_cleanup();
 }
 
@@ -0,0 +1,786 @@
+/*
+ * FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ * Copyright (C) 2005-2014, Anthony Minessale II <anthm@freeswitch.org>
+ *
+ * Version: MPL 1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ *
+ * The Initial Developer of the Original Code is
+ * Anthony Minessale II <anthm@freeswitch.org>
+ * Portions created by the Initial Developer are Copyright (C)
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *
+ *
+ * switch_dsp.c -- Vectorized signed linear DSP primitives
+ *
+ * Every primitive has a plain C version plus SSE2 and AVX2 versions on x86
+ * built with gcc or clang.  The vector code is compiled with per function
+ * target attributes so the core does not need any extra -m flags, and
+ * switch_dsp_init() picks the widest set the cpu reports at runtime.
+ * Integer primitives give bit exact results across implementations.
+ *
+ */
+
+#include <switch.h>
+#include <switch_dsp.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !defined(SWITCH_DSP_NO_SIMD)
+#define DSP_X86 1
+#include <immintrin.h>
+#define DSP_SSE2 __attribute__((target("sse2")))
+#define DSP_AVX2 __attribute__((target("avx2")))
+#endif
+
+/* the vector loops accumulate in 32 bit lanes, fold them into 64 bits at least this often */
+#define DSP_ENERGY_BLOCK 32768
+/* zero crossings are counted in 16 bit lanes */
+#define DSP_ZC_BLOCK 16384
+
+typedef struct {
+	const char *name;
+	uint64_t (*energy)(const int16_t *data, uint32_t samples, uint32_t stride);
+	uint32_t (*peak)(const int16_t *data, uint32_t samples, uint32_t stride);
+	uint32_t (*zero_crossings)(const int16_t *data, uint32_t samples, uint32_t stride);
+	void (*gain)(int16_t *data, uint32_t samples, double gain);
+	void (*mix)(int16_t *data, const int16_t *other, uint32_t samples);
+	void (*clamp)(const int32_t *in, int16_t *out, uint32_t samples);
+	void (*goertzel)(const int16_t *data, uint32_t samples, const float *coefs, uint32_t filters, float *power);
+} dsp_impl_t;
+
+
+static uint64_t scalar_energy(const int16_t *data, uint32_t samples, uint32_t stride)
+{
+	uint64_t energy = 0;
+	uint32_t i, j;
+
+	for (i = 0, j = 0; i < samples; i++, j += stride) {
+		energy += abs(data[j]);
+	}
+
+	return energy;
+}
+
+static uint32_t scalar_peak(const int16_t *data, uint32_t samples, uint32_t stride)
+{
+	uint32_t peak = 0, i, j;
+
+	for (i = 0, j = 0; i < samples; i++, j += stride) {
+		uint32_t a = abs(data[j]);
+		if (a > peak) peak = a;
+	}
+
+	return peak;
+}
+
+static uint32_t scalar_zero_crossings(const int16_t *data, uint32_t samples, uint32_t stride)
+{
+	uint32_t count = 0, i, j;
+
+	for (i = 1, j = stride; i < samples; i++, j += stride) {
+		if ((data[j] ^ data[j - stride]) < 0) count++;
+	}
+
+	return count;
+}
+
+static void scalar_gain(int16_t *data, uint32_t samples, double gain)
+{
+	uint32_t x;
+	int32_t tmp;
+
+	for (x = 0; x < samples; x++) {
+		tmp = (int32_t) (data[x] * gain);
+		switch_normalize_to_16bit(tmp);
+		data[x] = (int16_t) tmp;
+	}
+}
+
+static void scalar_mix(int16_t *data, const int16_t *other, uint32_t samples)
+{
+	uint32_t x;
+	int32_t z;
+
+	for (x = 0; x < samples; x++) {
+		z = data[x] + other[x];
+		switch_normalize_to_16bit(z);
+		data[x] = (int16_t) z;
+	}
+}
+
+static void scalar_clamp(const int32_t *in, int16_t *out, uint32_t samples)
+{
+	uint32_t x;
+	int32_t z;
+
+	for (x = 0; x < samples; x++) {
+		z = in[x];
+		switch_normalize_to_16bit(z);
+		out[x] = (int16_t) z;
+	}
+}
+
+static void scalar_goertzel(const int16_t *data, uint32_t samples, const float *coefs, uint32_t filters, float *power)
+{
+	uint32_t f, i;
+
+	for (f = 0; f < filters; f++) {
+		float c = coefs[f], s0, s1 = 0, s2 = 0;
+
+		for (i = 0; i < samples; i++) {
+			s0 = c * s1 - s2 + (float) data[i];
+			s2 = s1;
+			s1 = s0;
+		}
+
+		power[f] = s1 * s1 + s2 * s2 - c * s1 * s2;
+	}
+}
+
+static const dsp_impl_t dsp_scalar = {
+	"scalar", scalar_energy, scalar_peak, scalar_zero_crossings, scalar_gain, scalar_mix, scalar_clamp, scalar_goertzel
+};
+
+#ifdef DSP_X86
+
+/* energy vectorizes for mono and for one channel of interleaved stereo, anything wider stays scalar */
+
+DSP_SSE2 static uint64_t sse2_energy(const int16_t *data, uint32_t samples, uint32_t stride)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i mask = stride == 1 ? _mm_set1_epi32(-1) : _mm_set1_epi32(0xffff);
+	uint32_t n, i = 0, lanes[4];
+	uint64_t energy = 0;
+
+	if (stride > 2) {
+		return scalar_energy(data, samples, stride);
+	}
+
+	n = (samples - 1) * stride + 1;
+
+	while (i + 8 <= n) {
+		__m128i acc = zero;
+		uint32_t blocks = 0;
+
+		for (; i + 8 <= n && blocks < DSP_ENERGY_BLOCK; i += 8, blocks++) {
+			__m128i v = _mm_loadu_si128((const __m128i *) (data + i));
+			__m128i s = _mm_srai_epi16(v, 15);
+			/* |v| as unsigned 16 bit, so -32768 comes out as 32768 */
+			__m128i a = _mm_and_si128(_mm_sub_epi16(_mm_xor_si128(v, s), s), mask);
+			acc = _mm_add_epi32(acc, _mm_add_epi32(_mm_unpacklo_epi16(a, zero), _mm_unpackhi_epi16(a, zero)));
+		}
+
+		_mm_storeu_si128((__m128i *) lanes, acc);
+		energy += (uint64_t) lanes[0] + lanes[1] + lanes[2] + lanes[3];
+	}
+
+	for (; i < n; i += stride) {
+		energy += abs(data[i]);
+	}
+
+	return energy;
+}
+
+DSP_SSE2 static uint32_t sse2_peak(const int16_t *data, uint32_t samples, uint32_t stride)
+{
+	__m128i hi = _mm_setzero_si128(), lo = _mm_setzero_si128();
+	int16_t max[8], min[8];
+	uint32_t i = 0, peak = 0;
+
+	if (stride != 1) {
+		return scalar_peak(data, samples, stride);
+	}
+
+	for (; i + 8 <= samples; i += 8) {
+		__m128i v = _mm_loadu_si128((const __m128i *) (data + i));
+		hi = _mm_max_epi16(hi, v);
+		lo = _mm_min_epi16(lo, v);
+	}
+
+	_mm_storeu_si128((__m128i *) max, hi);
+	_mm_storeu_si128((__m128i *) min, lo);
+
+	for (; i < samples; i++) {
+		uint32_t a = abs(data[i]);
+		if (a > peak) peak = a;
+	}
+
+	for (i = 0; i < 8; i++) {
+		if ((uint32_t) max[i] > peak) peak = max[i];
+		if ((uint32_t) -min[i] > peak) peak = -min[i];
+	}
+
+	return peak;
+}
+
+DSP_SSE2 static uint32_t sse2_zero_crossings(const int16_t *data, uint32_t samples, uint32_t stride)
+{
+	const __m128i ones = _mm_set1_epi16(1);
+	uint32_t i = 1, count = 0, lanes[4];
+
+	if (stride != 1) {
+		return scalar_zero_crossings(data, samples, stride);
+	}
+
+	while (i + 8 <= samples) {
+		__m128i acc = _mm_setzero_si128();
+		uint32_t blocks = 0;
+
+		for (; i + 8 <= samples && blocks < DSP_ZC_BLOCK; i += 8, blocks++) {
+			__m128i cur = _mm_loadu_si128((const __m128i *) (data + i));
+			__m128i prev = _mm_loadu_si128((const __m128i *) (data + i - 1));
+			/* -1 in every lane where the sign bit flipped */
+			acc = _mm_sub_epi16(acc, _mm_srai_epi16(_mm_xor_si128(cur, prev), 15));
+		}
+
+		_mm_storeu_si128((__m128i *) lanes, _mm_madd_epi16(acc, ones));
+		count += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+	}
+
+	for (; i < samples; i++) {
+		if ((data[i] ^ data[i - 1]) < 0) count++;
+	}
+
+	return count;
+}
+
+DSP_SSE2 static __m128i sse2_gain4(__m128i x, __m128d g)
+{
+	__m128i a = _mm_cvttpd_epi32(_mm_mul_pd(_mm_cvtepi32_pd(x), g));
+	__m128i b = _mm_cvttpd_epi32(_mm_mul_pd(_mm_cvtepi32_pd(_mm_shuffle_epi32(x, _MM_SHUFFLE(1, 0, 3, 2))), g));
+
+	return _mm_unpacklo_epi64(a, b);
+}
+
+DSP_SSE2 static void sse2_gain(int16_t *data, uint32_t samples, double gain)
+{
+	const __m128d g = _mm_set1_pd(gain);
+	uint32_t i = 0;
+
+	for (; i + 8 <= samples; i += 8) {
+		__m128i v = _mm_loadu_si128((const __m128i *) (data + i));
+		__m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+		__m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+		_mm_storeu_si128((__m128i *) (data + i), _mm_packs_epi32(sse2_gain4(lo, g), sse2_gain4(hi, g)));
+	}
+
+	if (i < samples) {
+		scalar_gain(data + i, samples - i, gain);
+	}
+}
+
+DSP_SSE2 static void sse2_mix(int16_t *data, const int16_t *other, uint32_t samples)
+{
+	uint32_t i = 0;
+
+	for (; i + 8 <= samples; i += 8) {
+		__m128i a = _mm_loadu_si128((const __m128i *) (data + i));
+		__m128i b = _mm_loadu_si128((const __m128i *) (other + i));
+		_mm_storeu_si128((__m128i *) (data + i), _mm_adds_epi16(a, b));
+	}
+
+	if (i < samples) {
+		scalar_mix(data + i, other + i, samples - i);
+	}
+}
+
+DSP_SSE2 static void sse2_clamp(const int32_t *in, int16_t *out, uint32_t samples)
+{
+	uint32_t i = 0;
+
+	for (; i + 8 <= samples; i += 8) {
+		__m128i a = _mm_loadu_si128((const __m128i *) (in + i));
+		__m128i b = _mm_loadu_si128((const __m128i *) (in + i + 4));
+		_mm_storeu_si128((__m128i *) (out + i), _mm_packs_epi32(a, b));
+	}
+
+	if (i < samples) {
+		scalar_clamp(in + i, out + i, samples - i);
+	}
+}
+
+/* one filter per lane with the sample broadcast across them; each pass runs four
+   independent vectors so the recursion latency overlaps instead of adding up */
+#define DSP_GOERTZEL_VECS 4
+
+DSP_SSE2 static void sse2_goertzel(const int16_t *data, uint32_t samples, const float *coefs, uint32_t filters, float *power)
+{
+	uint32_t f, i, v;
+
+	for (f = 0; f < filters; f += 4 * DSP_GOERTZEL_VECS) {
+		float c[4 * DSP_GOERTZEL_VECS] = { 0 }, p[4 * DSP_GOERTZEL_VECS];
+		uint32_t n = filters - f < 4 * DSP_GOERTZEL_VECS ? filters - f : 4 * DSP_GOERTZEL_VECS;
+		__m128 vc[DSP_GOERTZEL_VECS], s1[DSP_GOERTZEL_VECS], s2[DSP_GOERTZEL_VECS];
+
+		memcpy(c, coefs + f, n * sizeof(float));
+
+		for (v = 0; v < DSP_GOERTZEL_VECS; v++) {
+			vc[v] = _mm_loadu_ps(c + 4 * v);
+			s1[v] = s2[v] = _mm_setzero_ps();
+		}
+
+		for (i = 0; i < samples; i++) {
+			__m128 x = _mm_set1_ps((float) data[i]);
+
+			for (v = 0; v < DSP_GOERTZEL_VECS; v++) {
+				__m128 s0 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(vc[v], s1[v]), s2[v]), x);
+				s2[v] = s1[v];
+				s1[v] = s0;
+			}
+		}
+
+		for (v = 0; v < DSP_GOERTZEL_VECS; v++) {
+			_mm_storeu_ps(p + 4 * v, _mm_sub_ps(_mm_add_ps(_mm_mul_ps(s1[v], s1[v]), _mm_mul_ps(s2[v], s2[v])),
+												_mm_mul_ps(_mm_mul_ps(vc[v], s1[v]), s2[v])));
+		}
+
+		memcpy(power + f, p, n * sizeof(float));
+	}
+}
+
+static const dsp_impl_t dsp_sse2 = {
+	"sse2", sse2_energy, sse2_peak, sse2_zero_crossings, sse2_gain, sse2_mix, sse2_clamp, sse2_goertzel
+};
+
+DSP_AVX2 static uint64_t avx2_energy(const int16_t *data, uint32_t samples, uint32_t stride)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i mask = stride == 1 ? _mm256_set1_epi32(-1) : _mm256_set1_epi32(0xffff);
+	uint32_t n, i = 0, lanes[8];
+	uint64_t energy = 0;
+
+	if (stride > 2) {
+		return scalar_energy(data, samples, stride);
+	}
+
+	n = (samples - 1) * stride + 1;
+
+	while (i + 16 <= n) {
+		__m256i acc = zero;
+		uint32_t blocks = 0;
+
+		for (; i + 16 <= n && blocks < DSP_ENERGY_BLOCK; i += 16, blocks++) {
+			__m256i a = _mm256_and_si256(_mm256_abs_epi16(_mm256_loadu_si256((const __m256i *) (data + i))), mask);
+			acc = _mm256_add_epi32(acc, _mm256_add_epi32(_mm256_unpacklo_epi16(a, zero), _mm256_unpackhi_epi16(a, zero)));
+		}
+
+		_mm256_storeu_si256((__m256i *) lanes, acc);
+		energy += (uint64_t) lanes[0] + lanes[1] + lanes[2] + lanes[3] + lanes[4] + lanes[5] + lanes[6] + lanes[7];
+	}
+
+	for (; i < n; i += stride) {
+		energy += abs(data[i]);
+	}
+
+	return energy;
+}
+
+DSP_AVX2 static uint32_t avx2_peak(const int16_t *data, uint32_t samples, uint32_t stride)
+{
+	__m256i top = _mm256_setzero_si256();
+	uint16_t lanes[16];
+	uint32_t i = 0, peak = 0;
+
+	if (stride != 1) {
+		return scalar_peak(data, samples, stride);
+	}
+
+	for (; i + 16 <= samples; i += 16) {
+		/* abs_epi16 leaves -32768 as 0x8000, which is right when read back unsigned */
+		top = _mm256_max_epu16(top, _mm256_abs_epi16(_mm256_loadu_si256((const __m256i *) (data + i))));
+	}
+
+	_mm256_storeu_si256((__m256i *) lanes, top);
+
+	for (; i < samples; i++) {
+		uint32_t a = abs(data[i]);
+		if (a > peak) peak = a;
+	}
+
+	for (i = 0; i < 16; i++) {
+		if (lanes[i] > peak) peak = lanes[i];
+	}
+
+	return peak;
+}
+
+DSP_AVX2 static void avx2_gain(int16_t *data, uint32_t samples, double gain)
+{
+	const __m256d g = _mm256_set1_pd(gain);
+	uint32_t i = 0;
+
+	for (; i + 8 <= samples; i += 8) {
+		__m256i x = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *) (data + i)));
+		__m128i a = _mm256_cvttpd_epi32(_mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(x)), g));
+		__m128i b = _mm256_cvttpd_epi32(_mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(x, 1)), g));
+		_mm_storeu_si128((__m128i *) (data + i), _mm_packs_epi32(a, b));
+	}
+
+	if (i < samples) {
+		scalar_gain(data + i, samples - i, gain);
+	}
+}
+
+DSP_AVX2 static void avx2_mix(int16_t *data, const int16_t *other, uint32_t samples)
+{
+	uint32_t i = 0;
+
+	for (; i + 16 <= samples; i += 16) {
+		__m256i a = _mm256_loadu_si256((const __m256i *) (data + i));
+		__m256i b = _mm256_loadu_si256((const __m256i *) (other + i));
+		_mm256_storeu_si256((__m256i *) (data + i), _mm256_adds_epi16(a, b));
+	}
+
+	if (i < samples) {
+		scalar_mix(data + i, other + i, samples - i);
+	}
+}
+
+DSP_AVX2 static void avx2_clamp(const int32_t *in, int16_t *out, uint32_t samples)
+{
+	uint32_t i = 0;
+
+	for (; i + 16 <= samples; i += 16) {
+		__m256i a = _mm256_loadu_si256((const __m256i *) (in + i));
+		__m256i b = _mm256_loadu_si256((const __m256i *) (in + i + 8));
+		/* packs works per 128 bit half, put the quarters back in order */
+		_mm256_storeu_si256((__m256i *) (out + i), _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), _MM_SHUFFLE(3, 1, 2, 0)));
+	}
+
+	if (i < samples) {
+		scalar_clamp(in + i, out + i, samples - i);
+	}
+}
+
+DSP_AVX2 static void avx2_goertzel(const int16_t *data, uint32_t samples, const float *coefs, uint32_t filters, float *power)
+{
+	uint32_t f, i, v;
+
+	for (f = 0; f < filters; f += 8 * DSP_GOERTZEL_VECS) {
+		float c[8 * DSP_GOERTZEL_VECS] = { 0 }, p[8 * DSP_GOERTZEL_VECS];
+		uint32_t n = filters - f < 8 * DSP_GOERTZEL_VECS ? filters - f : 8 * DSP_GOERTZEL_VECS;
+		__m256 vc[DSP_GOERTZEL_VECS], s1[DSP_GOERTZEL_VECS], s2[DSP_GOERTZEL_VECS];
+
+		memcpy(c, coefs + f, n * sizeof(float));
+
+		for (v = 0; v < DSP_GOERTZEL_VECS; v++) {
+			vc[v] = _mm256_loadu_ps(c + 8 * v);
+			s1[v] = s2[v] = _mm256_setzero_ps();
+		}
+
+		for (i = 0; i < samples; i++) {
+			__m256 x = _mm256_set1_ps((float) data[i]);
+
+			for (v = 0; v < DSP_GOERTZEL_VECS; v++) {
+				__m256 s0 = _mm256_add_ps(_mm256_sub_ps(_mm256_mul_ps(vc[v], s1[v]), s2[v]), x);
+				s2[v] = s1[v];
+				s1[v] = s0;
+			}
+		}
+
+		for (v = 0; v < DSP_GOERTZEL_VECS; v++) {
+			_mm256_storeu_ps(p + 8 * v, _mm256_sub_ps(_mm256_add_ps(_mm256_mul_ps(s1[v], s1[v]), _mm256_mul_ps(s2[v], s2[v])),
+													  _mm256_mul_ps(_mm256_mul_ps(vc[v], s1[v]), s2[v])));
+		}
+
+		memcpy(power + f, p, n * sizeof(float));
+	}
+}
+
+/* zero crossings gain nothing from the wider registers over sse2 */
+static const dsp_impl_t dsp_avx2 = {
+	"avx2", avx2_energy, avx2_peak, sse2_zero_crossings, avx2_gain, avx2_mix, avx2_clamp, avx2_goertzel
+};
+
+#endif
+
+static const dsp_impl_t *dsp = &dsp_scalar;
+
+static const dsp_impl_t *dsp_best(void)
+{
+#ifdef DSP_X86
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("avx2")) {
+		return &dsp_avx2;
+	}
+
+	if (__builtin_cpu_supports("sse2")) {
+		return &dsp_sse2;
+	}
+#endif
+
+	return &dsp_scalar;
+}
+
+SWITCH_DECLARE(void) switch_dsp_init(void)
+{
+	dsp = dsp_best();
+}
+
+SWITCH_DECLARE(switch_status_t) switch_dsp_set_impl(const char *name)
+{
+	const dsp_impl_t *best = dsp_best();
+
+	if (zstr(name) || !strcasecmp(name, "auto")) {
+		dsp = best;
+		return SWITCH_STATUS_SUCCESS;
+	}
+
+	if (!strcasecmp(name, dsp_scalar.name)) {
+		dsp = &dsp_scalar;
+		return SWITCH_STATUS_SUCCESS;
+	}
+
+#ifdef DSP_X86
+	if (!strcasecmp(name, dsp_sse2.name) && best != &dsp_scalar) {
+		dsp = &dsp_sse2;
+		return SWITCH_STATUS_SUCCESS;
+	}
+
+	if (!strcasecmp(name, dsp_avx2.name) && best == &dsp_avx2) {
+		dsp = &dsp_avx2;
+		return SWITCH_STATUS_SUCCESS;
+	}
+#endif
+
+	return SWITCH_STATUS_FALSE;
+}
+
+SWITCH_DECLARE(const char *) switch_dsp_impl_name(void)
+{
+	return dsp->name;
+}
+
+SWITCH_DECLARE(uint64_t) switch_dsp_energy(const int16_t *data, uint32_t samples, uint32_t stride)
+{
+	if (!samples) return 0;
+	if (!stride) stride = 1;
+
+	return dsp->energy(data, samples, stride);
+}
+
+SWITCH_DECLARE(uint32_t) switch_dsp_peak(const int16_t *data, uint32_t samples, uint32_t stride)
+{
+	if (!samples) return 0;
+	if (!stride) stride = 1;
+
+	return dsp->peak(data, samples, stride);
+}
+
+SWITCH_DECLARE(uint32_t) switch_dsp_zero_crossings(const int16_t *data, uint32_t samples, uint32_t stride)
+{
+	if (samples < 2) return 0;
+	if (!stride) stride = 1;
+
+	return dsp->zero_crossings(data, samples, stride);
+}
+
+SWITCH_DECLARE(void) switch_dsp_gain(int16_t *data, uint32_t samples, double gain)
+{
+	dsp->gain(data, samples, gain);
+}
+
+SWITCH_DECLARE(void) switch_dsp_mix(int16_t *data, const int16_t *other, uint32_t samples)
+{
+	dsp->mix(data, other, samples);
+}
+
+SWITCH_DECLARE(void) switch_dsp_clamp_to_16bit(const int32_t *in, int16_t *out, uint32_t samples)
+{
+	dsp->clamp(in, out, samples);
+}
+
+SWITCH_DECLARE(void) switch_dsp_goertzel_bank(const int16_t *data, uint32_t samples, const float *coefs, uint32_t filters, float *power)
+{
+	dsp->goertzel(data, samples, coefs, filters, power);
+}
+
+
+/* frequencies per tone as in a teletone map, and distinct frequencies per bank */
+#define DSP_TONE_FREQS TELETONE_MAX_TONES
+#define DSP_BANK_FREQS 64
+
+typedef struct {
+	uint8_t freq[DSP_TONE_FREQS];
+	uint32_t count;
+	int positives;
+	int negatives;
+	int hits;
+} dsp_tone_t;
+
+struct switch_dsp_tone_bank_s {
+	uint32_t rate;
+	uint32_t block_len;
+	int16_t *block;
+	uint32_t fill;
+	double freqs[DSP_BANK_FREQS];
+	float coefs[DSP_BANK_FREQS];
+	uint32_t freq_count;
+	dsp_tone_t tones[SWITCH_DSP_TONE_BANK_MAX];
+	uint32_t tone_count;
+};
+
+/* same block length and hit/miss counters as teletone_multi_tone_init */
+#define DSP_TONE_BLOCK 102
+#define DSP_TONE_POSITIVE_FACTOR 2
+#define DSP_TONE_NEGATIVE_FACTOR 10
+#define DSP_TONE_HIT_FACTOR 2
+
+SWITCH_DECLARE(switch_status_t) switch_dsp_tone_bank_create(switch_dsp_tone_bank_t **bank, uint32_t rate, switch_memory_pool_t *pool)
+{
+	switch_dsp_tone_bank_t *b;
+
+	if (!rate) rate = 8000;
+
+	b = switch_core_alloc(pool, sizeof(*b));
+	b->rate = rate;
+	b->block_len = DSP_TONE_BLOCK * (rate / 8000 ? rate / 8000 : 1);
+	b->block = switch_core_alloc(pool, b->block_len * sizeof(int16_t));
+
+	*bank = b;
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+SWITCH_DECLARE(int) switch_dsp_tone_bank_add(switch_dsp_tone_bank_t *bank, const double *freqs, uint32_t count)
+{
+	dsp_tone_t *tone;
+	uint32_t i, f;
+
+	if (!count || count > DSP_TONE_FREQS || bank->tone_count >= SWITCH_DSP_TONE_BANK_MAX) {
+		return -1;
+	}
+
+	tone = &bank->tones[bank->tone_count];
+	memset(tone, 0, sizeof(*tone));
+
+	for (i = 0; i < count; i++) {
+		/* tones that share a frequency share its filter */
+		for (f = 0; f < bank->freq_count && bank->freqs[f] != freqs[i]; f++);
+
+		if (f == bank->freq_count) {
+			if (f == DSP_BANK_FREQS) {
+				return -1;
+			}
+			bank->freqs[f] = freqs[i];
+			bank->coefs[f] = (float) (2.0 * cos(2.0 * M_PI * freqs[i] / bank->rate));
+			bank->freq_count++;
+		}
+
+		tone->freq[i] = (uint8_t) f;
+	}
+
+	tone->count = count;
+
+	return (int) bank->tone_count++;
+}
+
+static uint32_t dsp_tone_bank_block(switch_dsp_tone_bank_t *bank, uint32_t active)
+{
+	float power[DSP_BANK_FREQS];
+	int64_t energy = 0;
+	uint32_t i, t, hit = 0;
+
+	for (i = 0; i < bank->block_len; i++) {
+		energy += (int32_t) bank->block[i] * bank->block[i];
+	}
+
+	switch_dsp_goertzel_bank(bank->block, bank->block_len, bank->coefs, bank->freq_count, power);
+
+	for (t = 0; t < bank->tone_count; t++) {
+		dsp_tone_t *tone = &bank->tones[t];
+		float eng_sum = 0;
+
+		if (!(active & (1U << t))) {
+			continue;
+		}
+
+		for (i = 0; i < tone->count; i++) {
+			eng_sum += power[tone->freq[i]];
+		}
+
+		/* teletone also requires each filter to beat a second filter on the same frequency,
+		   which only differs from the first by float rounding, so that test is not carried over */
+		if (eng_sum > 42.0 * energy) {
+			if (tone->negatives) {
+				tone->negatives--;
+			}
+			tone->positives++;
+
+			if (tone->positives >= DSP_TONE_POSITIVE_FACTOR) {
+				tone->hits++;
+			}
+			if (tone->hits >= DSP_TONE_HIT_FACTOR) {
+				hit |= 1U << t;
+				tone->positives = tone->negatives = tone->hits = 0;
+			}
+		} else {
+			tone->negatives++;
+			if (tone->positives) {
+				tone->positives--;
+			}
+			if (tone->negatives > DSP_TONE_NEGATIVE_FACTOR) {
+				tone->positives = tone->hits = 0;
+			}
+		}
+	}
+
+	return hit;
+}
+
+SWITCH_DECLARE(uint32_t) switch_dsp_tone_bank_feed(switch_dsp_tone_bank_t *bank, const int16_t *data, uint32_t samples, uint32_t active)
+{
+	uint32_t hit = 0;
+
+	if (bank->tone_count < SWITCH_DSP_TONE_BANK_MAX) {
+		active &= (1U << bank->tone_count) - 1;
+	}
+
+	if (!active) {
+		/* nobody is listening, start a fresh block when someone is */
+		bank->fill = 0;
+		return 0;
+	}
+
+	while (samples) {
+		uint32_t n = bank->block_len - bank->fill;
+
+		if (n > samples) n = samples;
+
+		memcpy(bank->block + bank->fill, data, n * sizeof(int16_t));
+		bank->fill += n;
+		data += n;
+		samples -= n;
+
+		if (bank->fill == bank->block_len) {
+			hit |= dsp_tone_bank_block(bank, active);
+			bank->fill = 0;
+		}
+	}
+
+	return hit;
+}
+
+/* For Emacs:
+ * Local Variables:
+ * mode:c
+ * indent-tabs-mode:t
+ * tab-width:4
+ * c-basic-offset:4
+ * End:
+ * For VIM:
+ * vim:set softtabstop=4 shiftwidth=4 tabstop=4 noet:
+ */
@@ -131,6 +131,218 @@ static char *my_dup(const char *s)
 
 static void free_header(switch_event_header_t **header);
 
+/*
+  Header names are interned: every header with the same name points at one
+  shared copy that carries its precomputed hash, the copies live until the
+  process exits.  Slots are only ever filled, under EVENT_NAME_MUTEX, after the
+  entry is complete.  The fill is a compare and swap with a full barrier and
+  lookups read the slots with acquire loads, so they walk the table without
+  locking and never see a half written entry.
+*/
+#define EVENT_NAME_SLOTS 8192
+#define EVENT_NAME_MAX 4096
+#define EVENT_NAME_MAX_LEN 64
+
+typedef struct event_name_s {
+	unsigned long hash;
+	char name[1];
+} event_name_t;
+
+static event_name_t *EVENT_NAME_TABLE[EVENT_NAME_SLOTS] = { 0 };
+static uint32_t EVENT_NAME_COUNT = 0;
+static switch_mutex_t *EVENT_NAME_MUTEX = NULL;
+
+#if defined(__GNUC__) || defined(__clang__)
+#define EVENT_NAME_SLOT(slot) __atomic_load_n(&EVENT_NAME_TABLE[slot], __ATOMIC_ACQUIRE)
+#else
+#define EVENT_NAME_SLOT(slot) ((event_name_t *) switch_atomic_casptr((volatile void **) &EVENT_NAME_TABLE[slot], NULL, NULL))
+#endif
+
+/*
+  Headers and short values are carved out of blocks owned by the event so a
+  typical event costs a handful of mallocs instead of three per header.  The
+  blocks double in size up to EVENT_ARENA_MAX, past that (long lived events
+  such as channel variables) everything goes back to malloc.
+*/
+#define EVENT_ARENA_BLOCK 1024
+#define EVENT_ARENA_MAX (64 * 1024)
+#define EVENT_ARENA_VALUE_MAX 512
+
+struct switch_event_arena {
+	struct switch_event_arena *next;
+	switch_size_t size;
+	switch_size_t used;
+	switch_size_t total;
+};
+
+/* switch_event_header_t flags */
+#define EH_ARENA (1 << 0)
+#define EH_NAME_SHARED (1 << 1)
+#define EH_VALUE_ARENA (1 << 2)
+
+static event_name_t *event_name_intern(const char *name, unsigned long hash, switch_size_t len)
+{
+	event_name_t *en = NULL;
+	uint32_t slot, i;
+	int full = 0;
+
+	for (i = 0, slot = hash & (EVENT_NAME_SLOTS - 1); i < EVENT_NAME_SLOTS; i++, slot = (slot + 1) & (EVENT_NAME_SLOTS - 1)) {
+		if (!(en = EVENT_NAME_SLOT(slot))) {
+			break;
+		}
+		if (en->hash == hash && !strcmp(en->name, name)) {
+			return en;
+		}
+	}
+
+	if (!EVENT_NAME_MUTEX || EVENT_NAME_COUNT >= EVENT_NAME_MAX || len >= EVENT_NAME_MAX_LEN) {
+		return NULL;
+	}
+
+	switch_mutex_lock(EVENT_NAME_MUTEX);
+
+	for (i = 0, slot = hash & (EVENT_NAME_SLOTS - 1); i < EVENT_NAME_SLOTS; i++, slot = (slot + 1) & (EVENT_NAME_SLOTS - 1)) {
+		if (!(en = EVENT_NAME_TABLE[slot])) {
+			break;
+		}
+		if (en->hash == hash && !strcmp(en->name, name)) {
+			goto end;
+		}
+	}
+
+	if (EVENT_NAME_COUNT >= EVENT_NAME_MAX) {
+		en = NULL;
+		goto end;
+	}
+
+	en = ALLOC(sizeof(*en) + len);
+	switch_assert(en);
+	en->hash = hash;
+	memcpy(en->name, name, len + 1);
+	switch_atomic_casptr((volatile void **) &EVENT_NAME_TABLE[slot], en, NULL);
+
+	/* the table never empties, say so the one time it fills up */
+	full = (++EVENT_NAME_COUNT == EVENT_NAME_MAX);
+
+ end:
+
+	switch_mutex_unlock(EVENT_NAME_MUTEX);
+
+	if (full) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "Event header name table is full at %d names, new names are copied per header from now on\n",
+						  EVENT_NAME_MAX);
+	}
+
+	return en;
+}
+
+#define EVENT_ARENA_ALIGN(len) (((len) + sizeof(void *) - 1) & ~(sizeof(void *) - 1))
+
+static struct switch_event_arena *event_arena_block(switch_event_t *event, switch_size_t size)
+{
+	struct switch_event_arena *arena;
+	switch_size_t total = event->arena ? event->arena->total : 0;
+
+	if (total + size > EVENT_ARENA_MAX) {
+		return NULL;
+	}
+
+	arena = ALLOC(sizeof(*arena) + size);
+	switch_assert(arena);
+	arena->next = event->arena;
+	arena->size = size;
+	arena->used = 0;
+	arena->total = total + size;
+	event->arena = arena;
+
+	return arena;
+}
+
+static void *event_arena_alloc(switch_event_t *event, switch_size_t len)
+{
+	struct switch_event_arena *arena = event->arena;
+	char *p;
+
+	len = EVENT_ARENA_ALIGN(len);
+
+	if (!arena || arena->used + len > arena->size) {
+		switch_size_t size = arena ? arena->size * 2 : EVENT_ARENA_BLOCK;
+
+		while (size < len) {
+			size *= 2;
+		}
+
+		if (!(arena = event_arena_block(event, size))) {
+			return NULL;
+		}
+	}
+
+	p = (char *) (arena + 1) + arena->used;
+	arena->used += len;
+
+	return p;
+}
+
+static void event_arena_destroy(switch_event_t *event)
+{
+	struct switch_event_arena *arena, *next;
+
+	for (arena = event->arena; arena; arena = next) {
+		next = arena->next;
+		FREE(arena);
+	}
+
+	event->arena = NULL;
+}
+
+static char *event_arena_dup(switch_event_t *event, const char *str)
+{
+	switch_size_t len = strlen(str) + 1;
+	char *p = NULL;
+
+	if (len <= EVENT_ARENA_VALUE_MAX && (p = event_arena_alloc(event, len))) {
+		memcpy(p, str, len);
+	}
+
+	return p;
+}
+
+static void header_set_name(switch_event_header_t *header, const char *header_name)
+{
+	switch_ssize_t hlen = -1;
+	unsigned long hash = switch_ci_hashfunc_default(header_name, &hlen);
+	event_name_t *en;
+
+	if (!(header->flags & EH_NAME_SHARED)) {
+		FREE(header->name);
+	}
+
+	if ((en = event_name_intern(header_name, hash, (switch_size_t) hlen))) {
+		header->name = en->name;
+		header->flags |= EH_NAME_SHARED;
+	} else {
+		header->name = DUP(header_name);
+		header->flags &= ~EH_NAME_SHARED;
+	}
+
+	header->hash = hash;
+}
+
+/* hand the value over as malloc'd memory the caller may realloc or free */
+static char *header_take_value(switch_event_header_t *header)
+{
+	char *value = header->value;
+
+	if (value && (header->flags & EH_VALUE_ARENA)) {
+		value = DUP(value);
+	}
+
+	header->value = NULL;
+	header->flags &= ~EH_VALUE_ARENA;
+
+	return value;
+}
+
 /* make sure this is synced with the switch_event_types_t enum in switch_types.h
    also never put any new ones before EVENT_ALL
 */
@@ -624,6 +836,9 @@ SWITCH_DECLARE(switch_status_t) switch_event_shutdown(void)
 	switch_core_hash_destroy(&event_channel_manager.perm_hash);
 
 	switch_core_hash_destroy(&CUSTOM_HASH);
+
+	/* interned names stay, events still in flight may point at them */
+	EVENT_NAME_MUTEX = NULL;
 	switch_core_memory_reclaim_events();
 
 	return SWITCH_STATUS_SUCCESS;
@@ -705,6 +920,7 @@ SWITCH_DECLARE(switch_status_t) switch_event_init(switch_memory_pool_t *pool)
 	switch_mutex_init(&POOL_LOCK, SWITCH_MUTEX_NESTED, RUNTIME_POOL);
 	switch_mutex_init(&EVENT_QUEUE_MUTEX, SWITCH_MUTEX_NESTED, RUNTIME_POOL);
 	switch_mutex_init(&CUSTOM_HASH_MUTEX, SWITCH_MUTEX_NESTED, RUNTIME_POOL);
+	switch_mutex_init(&EVENT_NAME_MUTEX, SWITCH_MUTEX_NESTED, RUNTIME_POOL);
 	switch_core_hash_init(&CUSTOM_HASH);
 	// 最小化启动直接退出
 	if (switch_core_test_flag(SCF_MINIMAL)) {
@@ -810,10 +1026,7 @@ SWITCH_DECLARE(switch_status_t) switch_event_rename_header(switch_event_t *event
 
 	for (hp = event->headers; hp; hp = hp->next) {
 		if ((!hp->hash || hash == hp->hash) && !strcasecmp(hp->name, header_name)) {
-			FREE(hp->name);
-			hp->name = DUP(new_header_name);
-			hlen = -1;
-			hp->hash = switch_ci_hashfunc_default(hp->name, &hlen);
+			header_set_name(hp, new_header_name);
 			x++;
 		}
 	}
@@ -905,10 +1118,14 @@ SWITCH_DECLARE(switch_status_t) switch_event_del_header_val(switch_event_t *even
 	return status;
 }
 
-static switch_event_header_t *new_header(const char *header_name)
+static switch_event_header_t *alloc_header(switch_event_t *event)
 {
 	switch_event_header_t *header;
 
+	if ((header = event_arena_alloc(event, sizeof(*header)))) {
+		memset(header, 0, sizeof(*header));
+		header->flags = EH_ARENA;
+	} else {
 #ifdef SWITCH_EVENT_RECYCLE
 		void *pop;
 		if (EVENT_HEADER_RECYCLE_QUEUE && switch_queue_trypop(EVENT_HEADER_RECYCLE_QUEUE, &pop) == SWITCH_STATUS_SUCCESS) {
@@ -922,10 +1139,51 @@ static switch_event_header_t *new_header(const char *header_name)
 #endif
 
 		memset(header, 0, sizeof(*header));
-		header->name = DUP(header_name);
+	}
+
+	return header;
+}
+
+static switch_event_header_t *new_header(switch_event_t *event, const char *header_name)
+{
+	switch_event_header_t *header = alloc_header(event);
+
+	header_set_name(header, header_name);
+
+	return header;
+}
+
+/* plain headers that switch_event_add_header_string would store exactly as they are */
+static switch_bool_t header_copyable(const switch_event_header_t *hp)
+{
+	return !hp->idx && !zstr(hp->value) && strncmp(hp->value, "ARRAY::", 7) && strcmp(hp->name, "_body") && !strchr(hp->name, '[');
+}
 
-		return header;
+/* append a copy of hp to event sharing the interned name and its hash */
+static void copy_header(switch_event_t *event, const switch_event_header_t *hp)
+{
+	switch_event_header_t *header = alloc_header(event);
+
+	if ((hp->flags & EH_NAME_SHARED)) {
+		header->name = hp->name;
+		header->flags |= EH_NAME_SHARED;
+	} else {
+		header->name = DUP(hp->name);
+	}
+	header->hash = hp->hash;
 
+	if ((header->value = event_arena_dup(event, hp->value))) {
+		header->flags |= EH_VALUE_ARENA;
+	} else {
+		header->value = DUP(hp->value);
+	}
+
+	if (event->last_header) {
+		event->last_header->next = header;
+	} else {
+		event->headers = header;
+	}
+	event->last_header = header;
 }
 
 static void free_header(switch_event_header_t **header)
@@ -946,8 +1204,18 @@ static void free_header(switch_event_header_t **header)
 			}
 		}
 
-		FREE((*header)->name);
-		FREE((*header)->value);
+		if (!((*header)->flags & EH_NAME_SHARED)) {
+			FREE((*header)->name);
+		}
+		if (!((*header)->flags & EH_VALUE_ARENA)) {
+			FREE((*header)->value);
+		}
+
+		if (((*header)->flags & EH_ARENA)) {
+			/* released with the event */
+			*header = NULL;
+			return;
+		}
 
 #ifdef SWITCH_EVENT_RECYCLE
 		if (switch_queue_trypush(EVENT_HEADER_RECYCLE_QUEUE, *header) != SWITCH_STATUS_SUCCESS) {
@@ -1002,10 +1270,9 @@ SWITCH_DECLARE(int) switch_event_add_array(switch_event_t *event, const char *va
 	return 0;
 }
 
-static switch_status_t switch_event_base_add_header(switch_event_t *event, switch_stack_t stack, const char *header_name, char *data)
+static switch_status_t switch_event_base_add_header(switch_event_t *event, switch_stack_t stack, const char *header_name, char *data, switch_bool_t in_arena)
 {
 	switch_event_header_t *header = NULL;
-	switch_ssize_t hlen = -1;
 	int exists = 0, fly = 0;
 	char *index_ptr;
 	int index = 0;
@@ -1031,7 +1298,7 @@ static switch_status_t switch_event_base_add_header(switch_event_t *event, switc
 
 		if (!(header = switch_event_get_header_ptr(event, header_name)) && index_ptr) {
 
-			tmp_header = header = new_header(header_name);
+			tmp_header = header = new_header(event, header_name);
 
 			if (switch_test_flag(event, EF_UNIQ_HEADERS)) {
 				switch_event_del_header(event, header_name);
@@ -1088,7 +1355,9 @@ static switch_status_t switch_event_base_add_header(switch_event_t *event, switc
 
 		if (zstr(data)) {
 			switch_event_del_header(event, header_name);
-			FREE(data);
+			if (!in_arena) {
+				FREE(data);
+			}
 			goto end;
 		}
 
@@ -1098,12 +1367,14 @@ static switch_status_t switch_event_base_add_header(switch_event_t *event, switc
 
 		if (!strncmp(data, "ARRAY::", 7)) {
 			switch_event_add_array(event, header_name, data);
-			FREE(data);
+			if (!in_arena) {
+				FREE(data);
+			}
 			goto end;
 		}
 
 
-		header = new_header(header_name);
+		header = new_header(event, header_name);
 	}
 
 	if ((stack & SWITCH_STACK_PUSH) || (stack & SWITCH_STACK_UNSHIFT)) {
@@ -1115,8 +1386,7 @@ static switch_status_t switch_event_base_add_header(switch_event_t *event, switc
 		if (header->value && !header->idx) {
 			m = malloc(sizeof(char *));
 			switch_assert(m);
-			m[0] = header->value;
-			header->value = NULL;
+			m[0] = header_take_value(header);
 			header->array = m;
 			header->idx++;
 			m = NULL;
@@ -1150,6 +1420,10 @@ static switch_status_t switch_event_base_add_header(switch_event_t *event, switc
 
 		if (len) {
 			len += 8;
+			if ((header->flags & EH_VALUE_ARENA)) {
+				header->value = NULL;
+				header->flags &= ~EH_VALUE_ARENA;
+			}
 			hv = realloc(header->value, len);
 			switch_assert(hv);
 			header->value = hv;
@@ -1176,13 +1450,16 @@ static switch_status_t switch_event_base_add_header(switch_event_t *event, switc
 		}
 
 	} else {
-		switch_safe_free(header->value);
+		char *old = header_take_value(header);
+
+		switch_safe_free(old);
 		header->value = data;
+		if (in_arena) {
+			header->flags |= EH_VALUE_ARENA;
+		}
 	}
 
 	if (!exists) {
-		header->hash = switch_ci_hashfunc_default(header->name, &hlen);
-
 		if ((stack & SWITCH_STACK_TOP)) {
 			header->next = event->headers;
 			event->headers = header;
@@ -1221,7 +1498,7 @@ SWITCH_DECLARE(switch_status_t) switch_event_add_header(switch_event_t *event, s
 		return SWITCH_STATUS_MEMERR;
 	}
 
-	return switch_event_base_add_header(event, stack, header_name, data);
+	return switch_event_base_add_header(event, stack, header_name, data, SWITCH_FALSE);
 }
 
 SWITCH_DECLARE(switch_status_t) switch_event_set_subclass_name(switch_event_t *event, const char *subclass_name)
@@ -1239,7 +1516,15 @@ SWITCH_DECLARE(switch_status_t) switch_event_set_subclass_name(switch_event_t *e
 SWITCH_DECLARE(switch_status_t) switch_event_add_header_string(switch_event_t *event, switch_stack_t stack, const char *header_name, const char *data)
 {
 	if (data) {
-		return switch_event_base_add_header(event, stack, header_name, (stack & SWITCH_STACK_NODUP) ? (char *)data : DUP(data));
+		char *copy;
+
+		/* plain values can live in the event, arrays are realloc'd so they can't */
+		if (!(stack & (SWITCH_STACK_NODUP | SWITCH_STACK_PUSH | SWITCH_STACK_UNSHIFT)) && !strchr(header_name, '[') &&
+			(copy = event_arena_dup(event, data))) {
+			return switch_event_base_add_header(event, stack, header_name, copy, SWITCH_TRUE);
+		}
+
+		return switch_event_base_add_header(event, stack, header_name, (stack & SWITCH_STACK_NODUP) ? (char *)data : DUP(data), SWITCH_FALSE);
 	}
 	return SWITCH_STATUS_GENERR;
 }
@@ -1289,6 +1574,7 @@ SWITCH_DECLARE(void) switch_event_destroy(switch_event_t **event)
 			hp = hp->next;
 			free_header(&this);
 		}
+		event_arena_destroy(ep);
 		FREE(ep->body);
 		FREE(ep->subclass_name);
 #ifdef SWITCH_EVENT_RECYCLE
@@ -1326,6 +1612,7 @@ SWITCH_DECLARE(void) switch_event_merge(switch_event_t *event, switch_event_t *t
 SWITCH_DECLARE(switch_status_t) switch_event_dup(switch_event_t **event, switch_event_t *todup)
 {
 	switch_event_header_t *hp;
+	switch_size_t need = 0;
 
 	if (switch_event_create_subclass(event, SWITCH_EVENT_CLONE, todup->subclass_name) != SWITCH_STATUS_SUCCESS) {
 		return SWITCH_STATUS_GENERR;
@@ -1335,12 +1622,31 @@ SWITCH_DECLARE(switch_status_t) switch_event_dup(switch_event_t **event, switch_
 	(*event)->event_user_data = todup->event_user_data;
 	(*event)->bind_user_data = todup->bind_user_data;
 	(*event)->flags = todup->flags;
+
+	/* size one block for all the plain headers up front */
+	for (hp = todup->headers; hp; hp = hp->next) {
+		if (header_copyable(hp)) {
+			switch_size_t len = strlen(hp->value) + 1;
+
+			need += EVENT_ARENA_ALIGN(sizeof(*hp));
+			if (len <= EVENT_ARENA_VALUE_MAX) {
+				need += EVENT_ARENA_ALIGN(len);
+			}
+		}
+	}
+
+	if (need > EVENT_ARENA_BLOCK && (!(*event)->arena || (*event)->arena->size - (*event)->arena->used < need)) {
+		event_arena_block(*event, need);
+	}
+
 	for (hp = todup->headers; hp; hp = hp->next) {
 		if (todup->subclass_name && !strcmp(hp->name, "Event-Subclass")) {
 			continue;
 		}
 
-		if (hp->idx) {
+		if (header_copyable(hp)) {
+			copy_header(*event, hp);
+		} else if (hp->idx) {
 			int i;
 			for (i = 0; i < hp->idx; i++) {
 				switch_event_add_header_string(*event, SWITCH_STACK_PUSH, hp->name, hp->array[i]);
@@ -1849,18 +2155,54 @@ SWITCH_DECLARE(switch_status_t) switch_event_serialize_json_obj(switch_event_t *
 
 SWITCH_DECLARE(switch_status_t) switch_event_serialize_json(switch_event_t *event, char **str)
 {
+	switch_event_header_t *hp;
+	switch_json_writer_t w;
+	char buf[4096];
 
-	cJSON *cj;
-	*str = NULL;
+	/* same output as switch_event_serialize_json_obj + cJSON_PrintUnformatted without the tree */
+	switch_json_writer_init(&w, buf, sizeof(buf));
+	switch_json_writer_object_start(&w);
 
-	if (switch_event_serialize_json_obj(event, &cj) == SWITCH_STATUS_SUCCESS) {
-		*str = cJSON_PrintUnformatted(cj);
-		cJSON_Delete(cj);
+	for (hp = event->headers; hp; hp = hp->next) {
+		if (!hp->name) {
+			continue;
+		}
 
-		return SWITCH_STATUS_SUCCESS;
+		if (hp->idx) {
+			int i;
+
+			switch_json_writer_key(&w, hp->name);
+			switch_json_writer_array_start(&w);
+
+			for(i = 0; i < hp->idx; i++) {
+				if (hp->array[i]) {
+					switch_json_writer_string(&w, hp->array[i]);
+				}
+			}
+
+			switch_json_writer_array_end(&w);
+
+		} else {
+			switch_json_writer_add_string(&w, hp->name, hp->value);
+		}
 	}
 
-	return SWITCH_STATUS_FALSE;
+	if (event->body) {
+		int blen = (int) strlen(event->body);
+		char tmp[25];
+
+		switch_snprintf(tmp, sizeof(tmp), "%d", blen);
+
+		switch_json_writer_add_string(&w, "Content-Length", tmp);
+		switch_json_writer_add_string(&w, "_body", event->body);
+	}
+
+	switch_json_writer_object_end(&w);
+
+	*str = switch_json_writer_dup(&w);
+	switch_json_writer_destroy(&w);
+
+	return SWITCH_STATUS_SUCCESS;
 }
 
 static switch_xml_t add_xml_header(switch_xml_t xml, char *name, char *value, int offset)
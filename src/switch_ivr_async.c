@@ -1161,8 +1161,34 @@ struct record_helper {
 	switch_event_t *variables;
 	switch_mutex_t *cond_mutex;
 	switch_thread_cond_t *cond;
+	/* write-behind through the shared record writer pool, guarded by buffer_mutex */
+	int writer;
+	int writer_queued;
+	int writer_closing;
+	int writer_error;
+	uint32_t writer_channels;
+	switch_size_t writer_chunk;
+	switch_size_t writer_max;
+	switch_size_t writer_bytes_per_ms;
+	switch_size_t writer_max_inuse;
+	uint32_t writer_drops;
+	struct record_helper *writer_next;
 };
 
+static struct {
+	switch_memory_pool_t *pool;
+	switch_mutex_t *mutex;
+	switch_queue_t *queue;
+	switch_thread_t *threads[SWITCH_MAX_RECORD_WRITER_THREADS];
+	uint32_t thread_count;
+	struct record_helper *list;
+	uint32_t active;
+	uint64_t flushes;
+	uint64_t bytes;
+	uint64_t drops;
+	int running;
+} record_writers;
+
 static switch_status_t record_helper_destroy(struct record_helper **rh, switch_core_session_t *session);
 
 /**
@@ -1179,7 +1205,9 @@ static void set_completion_cause(struct record_helper *rh, const char *completio
 static switch_bool_t is_silence_frame(switch_frame_t *frame, int silence_threshold, switch_codec_implementation_t *codec_impl)
 {
 	int16_t *fdata = (int16_t *) frame->data;
-	uint32_t samples = frame->datalen / sizeof(*fdata);
+	uint32_t channels = codec_impl->number_of_channels ? codec_impl->number_of_channels : 1;
+	/* samples per channel, the frame is interleaved */
+	uint32_t samples = frame->datalen / sizeof(*fdata) / channels;
 	switch_bool_t is_silence = SWITCH_TRUE;
 	uint32_t channel_num = 0;
 
@@ -1189,13 +1217,9 @@ static switch_bool_t is_silence_frame(switch_frame_t *frame, int silence_thresho
 	}
 
 	/* is silence only if every channel is silent */
-	for (channel_num = 0; channel_num < codec_impl->number_of_channels && is_silence; channel_num++) {
-		uint32_t count = 0, j = channel_num;
-		double energy = 0;
-		for (count = 0; count < samples; count++) {
-			energy += abs(fdata[j]);
-			j += codec_impl->number_of_channels;
-		}
+	for (channel_num = 0; channel_num < channels && is_silence; channel_num++) {
+		double energy = (double) switch_dsp_energy(fdata + channel_num, samples, channels);
+
 		is_silence &= (uint32_t) ((energy / (samples / divisor)) < silence_threshold);
 	}
 
@@ -1352,6 +1376,257 @@ static void *SWITCH_THREAD_FUNC recording_thread(switch_thread_t *thread, void *
 	return NULL;
 }
 
+static void *SWITCH_THREAD_FUNC record_writer_thread(switch_thread_t *thread, void *obj)
+{
+	void *pop = NULL;
+	uint8_t *data = NULL;
+	switch_size_t datalen = 0;
+
+	while (switch_queue_pop(record_writers.queue, &pop) == SWITCH_STATUS_SUCCESS && pop) {
+		struct record_helper *rh = (struct record_helper *) pop;
+
+		for (;;) {
+			switch_size_t inuse, bytes, samples;
+
+			switch_mutex_lock(rh->buffer_mutex);
+			inuse = switch_buffer_inuse(rh->thread_buffer);
+
+			if (inuse < rh->writer_chunk) {
+				/* until this is cleared the recording belongs to us, see record_writer_detach() */
+				rh->writer_queued = 0;
+				switch_mutex_unlock(rh->buffer_mutex);
+				break;
+			}
+
+			bytes = inuse - (inuse % (2 * rh->writer_channels));
+
+			if (bytes > datalen) {
+				void *mem = realloc(data, bytes);
+				switch_assert(mem);
+				data = mem;
+				datalen = bytes;
+			}
+
+			switch_buffer_read(rh->thread_buffer, data, bytes);
+			switch_mutex_unlock(rh->buffer_mutex);
+
+			samples = bytes / 2 / rh->writer_channels;
+
+			if (!rh->writer_error && switch_core_file_write(rh->fh, data, &samples) != SWITCH_STATUS_SUCCESS) {
+				rh->writer_error = 1;
+			}
+
+			switch_mutex_lock(record_writers.mutex);
+			record_writers.flushes++;
+			record_writers.bytes += bytes;
+			switch_mutex_unlock(record_writers.mutex);
+		}
+	}
+
+	switch_safe_free(data);
+
+	return NULL;
+}
+
+void switch_ivr_record_writers_start(switch_memory_pool_t *pool)
+{
+	uint32_t i;
+
+	if (record_writers.running || !runtime.record_writer_threads) {
+		return;
+	}
+
+	memset(&record_writers, 0, sizeof(record_writers));
+	record_writers.pool = pool;
+	record_writers.thread_count = runtime.record_writer_threads;
+
+	if (record_writers.thread_count > SWITCH_MAX_RECORD_WRITER_THREADS) {
+		record_writers.thread_count = SWITCH_MAX_RECORD_WRITER_THREADS;
+	}
+
+	switch_mutex_init(&record_writers.mutex, SWITCH_MUTEX_NESTED, pool);
+	switch_queue_create(&record_writers.queue, SWITCH_CORE_QUEUE_LEN, pool);
+
+	for (i = 0; i < record_writers.thread_count; i++) {
+		switch_threadattr_t *thd_attr = NULL;
+
+		switch_threadattr_create(&thd_attr, pool);
+		switch_threadattr_stacksize_set(thd_attr, SWITCH_THREAD_STACKSIZE);
+		switch_threadattr_priority_set(thd_attr, SWITCH_PRI_LOW);
+		switch_thread_create(&record_writers.threads[i], thd_attr, record_writer_thread, NULL, pool);
+	}
+
+	record_writers.running = 1;
+
+	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "Started %u record writer thread%s\n",
+					  record_writers.thread_count, record_writers.thread_count == 1 ? "" : "s");
+}
+
+void switch_ivr_record_writers_stop(void)
+{
+	uint32_t i;
+	switch_status_t st;
+
+	if (!record_writers.running) {
+		return;
+	}
+
+	record_writers.running = 0;
+
+	for (i = 0; i < record_writers.thread_count; i++) {
+		switch_queue_push(record_writers.queue, NULL);
+	}
+
+	for (i = 0; i < record_writers.thread_count; i++) {
+		switch_thread_join(&st, record_writers.threads[i]);
+	}
+}
+
+static void record_writer_attach(struct record_helper *rh, switch_media_bug_t *bug)
+{
+	uint32_t rate = rh->read_impl.actual_samples_per_second ? rh->read_impl.actual_samples_per_second : 8000;
+	switch_size_t frame;
+
+	rh->writer_channels = switch_core_media_bug_test_flag(bug, SMBF_STEREO) ? 2 : rh->read_impl.number_of_channels;
+	if (!rh->writer_channels) {
+		rh->writer_channels = 1;
+	}
+
+	frame = 2 * rh->writer_channels;
+	rh->writer_bytes_per_ms = rate / 1000 * frame;
+	rh->writer_chunk = rh->writer_bytes_per_ms * runtime.record_writer_flush_ms;
+	rh->writer_chunk -= rh->writer_chunk % frame;
+	rh->writer_max = rh->writer_bytes_per_ms * runtime.record_writer_max_lag_ms;
+
+	if (rh->writer_max && rh->writer_max < rh->writer_chunk * 2) {
+		rh->writer_max = rh->writer_chunk * 2;
+	}
+
+	switch_mutex_init(&rh->buffer_mutex, SWITCH_MUTEX_NESTED, rh->helper_pool);
+	switch_buffer_create_dynamic(&rh->thread_buffer, rh->writer_chunk, rh->writer_chunk * 2, 0);
+	rh->writer = 1;
+
+	switch_mutex_lock(record_writers.mutex);
+	rh->writer_next = record_writers.list;
+	record_writers.list = rh;
+	record_writers.active++;
+	switch_mutex_unlock(record_writers.mutex);
+}
+
+/* queue the recording for a writer once a whole chunk is waiting, frames past the lag limit are dropped */
+static void record_writer_feed(struct record_helper *rh, void *data, switch_size_t datalen)
+{
+	switch_size_t inuse;
+	int push = 0;
+
+	switch_mutex_lock(rh->buffer_mutex);
+	inuse = switch_buffer_inuse(rh->thread_buffer);
+
+	if (rh->writer_max && inuse + datalen > rh->writer_max) {
+		rh->writer_drops++;
+		switch_mutex_unlock(rh->buffer_mutex);
+
+		switch_mutex_lock(record_writers.mutex);
+		record_writers.drops++;
+		switch_mutex_unlock(record_writers.mutex);
+		return;
+	}
+
+	switch_buffer_write(rh->thread_buffer, data, datalen);
+	inuse += datalen;
+
+	if (inuse > rh->writer_max_inuse) {
+		rh->writer_max_inuse = inuse;
+	}
+
+	if (inuse >= rh->writer_chunk && !rh->writer_queued && !rh->writer_closing) {
+		rh->writer_queued = push = 1;
+	}
+
+	if (push && switch_queue_trypush(record_writers.queue, rh) != SWITCH_STATUS_SUCCESS) {
+		/* queue is full, try again with the next frame */
+		rh->writer_queued = 0;
+	}
+
+	switch_mutex_unlock(rh->buffer_mutex);
+}
+
+/* wait for any writer still flushing this recording, then take the remaining audio back to the caller */
+static void record_writer_detach(struct record_helper *rh, switch_channel_t *channel)
+{
+	struct record_helper *np, *last = NULL;
+
+	if (!rh->writer) {
+		return;
+	}
+
+	for (;;) {
+		switch_mutex_lock(rh->buffer_mutex);
+		if (!rh->writer_queued) {
+			rh->writer_closing = 1;
+			switch_mutex_unlock(rh->buffer_mutex);
+			break;
+		}
+		switch_mutex_unlock(rh->buffer_mutex);
+		switch_yield(10000);
+	}
+
+	switch_mutex_lock(record_writers.mutex);
+	for (np = record_writers.list; np; np = np->writer_next) {
+		if (np == rh) {
+			if (last) {
+				last->writer_next = np->writer_next;
+			} else {
+				record_writers.list = np->writer_next;
+			}
+			record_writers.active--;
+			break;
+		}
+		last = np;
+	}
+	switch_mutex_unlock(record_writers.mutex);
+
+	rh->writer = 0;
+
+	if (channel) {
+		switch_channel_set_variable_printf(channel, "record_writer_drops", "%u", rh->writer_drops);
+		switch_channel_set_variable_printf(channel, "record_writer_max_lag_ms", "%" SWITCH_SIZE_T_FMT,
+										   rh->writer_bytes_per_ms ? rh->writer_max_inuse / rh->writer_bytes_per_ms : 0);
+	}
+}
+
+SWITCH_DECLARE(void) switch_ivr_record_writer_status(switch_stream_handle_t *stream)
+{
+	struct record_helper *rh;
+
+	if (!record_writers.running) {
+		stream->write_function(stream, "Record writer pool not running\n");
+		return;
+	}
+
+	switch_mutex_lock(record_writers.mutex);
+
+	for (rh = record_writers.list; rh; rh = rh->writer_next) {
+		switch_size_t inuse;
+
+		switch_mutex_lock(rh->buffer_mutex);
+		inuse = switch_buffer_inuse(rh->thread_buffer);
+		switch_mutex_unlock(rh->buffer_mutex);
+
+		stream->write_function(stream, "%s\n\tLag: %" SWITCH_SIZE_T_FMT "ms\n\tMax lag: %" SWITCH_SIZE_T_FMT "ms\n\tDrops: %u\n\tQueued: %s\n",
+							   rh->file, inuse / rh->writer_bytes_per_ms, rh->writer_max_inuse / rh->writer_bytes_per_ms,
+							   rh->writer_drops, rh->writer_queued ? "true" : "false");
+	}
+
+	stream->write_function(stream, "%u thread%s, %u recording%s, %" SWITCH_UINT64_T_FMT " flushes, %" SWITCH_UINT64_T_FMT " bytes, %"
+						   SWITCH_UINT64_T_FMT " dropped frames\n",
+						   record_writers.thread_count, record_writers.thread_count == 1 ? "" : "s",
+						   record_writers.active, record_writers.active == 1 ? "" : "s",
+						   record_writers.flushes, record_writers.bytes, record_writers.drops);
+
+	switch_mutex_unlock(record_writers.mutex);
+}
+
 static void record_helper_post_process(struct record_helper *rh, switch_core_session_t *session)
 {
 	switch_channel_t *channel = switch_core_session_get_channel(session);
@@ -1458,7 +1733,10 @@ static switch_bool_t record_callback(switch_media_bug_t *bug, void *user_data, s
 			/* Required for potential record_transfer */
 			rh->bug = bug;
 			
-			if (!rh->native && rh->fh && (zstr(var) || switch_true(var))) {
+			if (!rh->native && rh->fh && (zstr(var) || switch_true(var)) && record_writers.running &&
+				!switch_core_file_has_video(rh->fh, SWITCH_TRUE)) {
+				record_writer_attach(rh, bug);
+			} else if (!rh->native && rh->fh && (zstr(var) || switch_true(var))) {
 				switch_threadattr_t *thd_attr = NULL;
 				int sanity = 200;
 
@@ -1619,6 +1897,22 @@ static switch_bool_t record_callback(switch_media_bug_t *bug, void *user_data, s
 					switch_thread_join(&st, rh->thread);
 				}
 
+				if (rh->writer) {
+					record_writer_detach(rh, channel);
+
+					while ((len = switch_buffer_read(rh->thread_buffer, data, sizeof(data) - (sizeof(data) % (2 * rh->writer_channels))))) {
+						len = len / 2 / rh->writer_channels;
+						if (!rh->writer_error && switch_core_file_write(rh->fh, data, &len) != SWITCH_STATUS_SUCCESS) {
+							rh->writer_error = 1;
+						}
+					}
+
+					if (rh->writer_error) {
+						switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_ERROR, "Error writing %s\n", rh->file);
+						set_completion_cause(rh, "uri-failure");
+					}
+				}
+
 				if (rh->thread_buffer) {
 					switch_buffer_destroy(&rh->thread_buffer);
 				}
@@ -1715,7 +2009,18 @@ static switch_bool_t record_callback(switch_media_bug_t *bug, void *user_data, s
 				} else {
 					len = (switch_size_t) frame.datalen / 2 / frame.channels;
 
-					if (rh->thread_buffer) {
+					if (rh->writer) {
+						if (rh->writer_error) {
+							switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_ERROR, "Error writing %s\n", rh->file);
+							set_completion_cause(rh, "uri-failure");
+							if (rh->hangup_on_error) {
+								switch_channel_hangup(channel, SWITCH_CAUSE_DESTINATION_OUT_OF_ORDER);
+								switch_core_session_reset(session, SWITCH_TRUE, SWITCH_TRUE);
+							}
+							return SWITCH_FALSE;
+						}
+						record_writer_feed(rh, mask ? null_data : data, frame.datalen);
+					} else if (rh->thread_buffer) {
 						switch_mutex_lock(rh->buffer_mutex);
 						switch_buffer_write(rh->thread_buffer, mask ? null_data : data, frame.datalen);
 						switch_mutex_unlock(rh->buffer_mutex);
@@ -2892,6 +3197,11 @@ static switch_status_t record_helper_destroy(struct record_helper **rh, switch_c
 		switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_ERROR, "Destroying a record helper of another session!\n");
 	}
 
+	if ((*rh)->writer) {
+		record_writer_detach(*rh, NULL);
+		switch_buffer_destroy(&(*rh)->thread_buffer);
+	}
+
 	if ((*rh)->native) {
 		switch_core_file_close(&(*rh)->in_fh);
 		switch_core_file_close(&(*rh)->out_fh);
@@ -4117,11 +4427,10 @@ SWITCH_DECLARE(switch_status_t) switch_ivr_inband_dtmf_generate_session(switch_c
 
 #define MAX_TONES 16
 typedef struct {
-	teletone_multi_tone_t mt;
+	int bank_tone;
 	char *app;
 	char *data;
 	char *key;
-	teletone_tone_map_t map;
 	int up;
 	int total_hits;
 	int hits;
@@ -4137,6 +4446,8 @@ typedef struct {
 typedef struct {
 	switch_tone_detect_t list[MAX_TONES + 1];
 	int index;
+	/* every tone's frequencies go through one filter bank pass per block */
+	switch_dsp_tone_bank_t *bank;
 	switch_media_bug_t *bug;
 	switch_core_session_t *session;
 	int bug_running;
@@ -4186,6 +4497,7 @@ static switch_bool_t tone_detect_callback(switch_media_bug_t *bug, void *user_da
 	switch_tone_container_t *cont = (switch_tone_container_t *) user_data;
 	switch_frame_t *frame = NULL;
 	int i = 0;
+	uint32_t active = 0, hits = 0;
 	switch_bool_t rval = SWITCH_TRUE;
 
 	switch (type) {
@@ -4231,7 +4543,13 @@ static switch_bool_t tone_detect_callback(switch_media_bug_t *bug, void *user_da
 				if (skip)
 					continue;
 
-				if (teletone_multi_tone_detect(&cont->list[i].mt, frame->data, frame->samples)) {
+				active |= 1U << cont->list[i].bank_tone;
+			}
+
+			hits = switch_dsp_tone_bank_feed(cont->bank, frame->data, frame->samples, active);
+
+			for (i = 0; hits && i < cont->index; i++) {
+				if (hits & (1U << cont->list[i].bank_tone)) {
 					switch_event_t *event;
 					cont->list[i].hits++;
 
@@ -4328,6 +4646,7 @@ SWITCH_DECLARE(switch_status_t) switch_ivr_tone_detect_session(switch_core_sessi
 	switch_tone_container_t *cont = switch_channel_get_private(channel, "_tone_detect_");
 	char *p, *next;
 	int i = 0, ok = 0, detect_fax = 0;
+	double freqs[TELETONE_MAX_TONES];
 	switch_media_bug_flag_t bflags = 0;
 	const char *var;
 	switch_codec_implementation_t read_impl = { 0 };
@@ -4385,9 +4704,9 @@ SWITCH_DECLARE(switch_status_t) switch_ivr_tone_detect_session(switch_core_sessi
 		next = strchr(p, ',');
 		while (*p == ' ')
 			p++;
-		if ((this = (teletone_process_t) atof(p))) {
+		if ((this = (teletone_process_t) atof(p)) && i < TELETONE_MAX_TONES) {
 			ok++;
-			cont->list[cont->index].map.freqs[i++] = this;
+			freqs[i++] = this;
 		}
 		if (!strncasecmp(p, "1100", 4)) {
 			detect_fax = cont->index;
@@ -4397,7 +4716,6 @@ SWITCH_DECLARE(switch_status_t) switch_ivr_tone_detect_session(switch_core_sessi
 			p = next + 1;
 		}
 	} while (next);
-	cont->list[cont->index].map.freqs[i++] = 0;
 
 	if (!ok) {
 		switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_ERROR, "Invalid tone spec!\n");
@@ -4422,9 +4740,16 @@ SWITCH_DECLARE(switch_status_t) switch_ivr_tone_detect_session(switch_core_sessi
 	cont->list[cont->index].start_time = switch_micro_time_now();
 
 	cont->list[cont->index].up = 1;
-	memset(&cont->list[cont->index].mt, 0, sizeof(cont->list[cont->index].mt));
-	cont->list[cont->index].mt.sample_rate = read_impl.actual_samples_per_second;
-	teletone_multi_tone_init(&cont->list[cont->index].mt, &cont->list[cont->index].map);
+
+	if (!cont->bank) {
+		switch_dsp_tone_bank_create(&cont->bank, read_impl.actual_samples_per_second, switch_core_session_get_pool(session));
+	}
+
+	if ((cont->list[cont->index].bank_tone = switch_dsp_tone_bank_add(cont->bank, freqs, ok)) < 0) {
+		switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_ERROR, "Too many tone frequencies!\n");
+		return SWITCH_STATUS_FALSE;
+	}
+
 	cont->session = session;
 
 	if (switch_channel_pre_answer(channel) != SWITCH_STATUS_SUCCESS) {
@@ -162,6 +162,7 @@ typedef struct {
 	switch_caller_profile_t *caller_profile_override;
 	switch_bool_t check_vars;
 	switch_memory_pool_t *pool;
+	switch_channel_watcher_t *watcher;
 	originate_status_t originate_status[MAX_PEERS];// = { {0} };
 } originate_global_t;
 
@@ -1466,6 +1467,7 @@ typedef struct {
 	switch_thread_t *thread;
 	switch_mutex_t *mutex;
 	switch_dial_handle_t *dh;
+	switch_channel_watcher_t *watcher;
 } enterprise_originate_handle_t;
 
 
@@ -1494,6 +1496,7 @@ static void *SWITCH_THREAD_FUNC enterprise_originate_thread(switch_thread_t *thr
 
 
 	handle->done = 1;
+	switch_channel_watcher_signal(handle->watcher);
 	switch_mutex_lock(handle->mutex);
 	switch_mutex_unlock(handle->mutex);
 
@@ -1575,11 +1578,13 @@ SWITCH_DECLARE(switch_status_t) switch_ivr_enterprise_originate(switch_core_sess
 	struct ent_originate_ringback rb_data = { 0 };
 	const char *ringback_data = NULL;
 	switch_event_t *var_event = NULL;
+	switch_channel_watcher_t *watcher = NULL;
 	int getcause = 1;
 
 	*cause = SWITCH_CAUSE_SUCCESS;
 
 	switch_core_new_memory_pool(&pool);
+	switch_channel_watcher_create(&watcher);
 
 	if (zstr(bridgeto) && (!hl || hl->handle_idx == 0)) {
 		*cause = SWITCH_CAUSE_DESTINATION_OUT_OF_ORDER;
@@ -1693,6 +1698,7 @@ SWITCH_DECLARE(switch_status_t) switch_ivr_enterprise_originate(switch_core_sess
 		handles[i].caller_profile_override = cp;
 		switch_event_dup(&handles[i].ovars, var_event);
 		handles[i].flags = flags;
+		handles[i].watcher = watcher;
 		if (hl) {
 			switch_dial_handle_dup(&handles[i].dh, hl->handles[i]);
 		}
@@ -1724,6 +1730,10 @@ SWITCH_DECLARE(switch_status_t) switch_ivr_enterprise_originate(switch_core_sess
 	}
 
 
+	if (channel) {
+		switch_channel_watch(channel, watcher);
+	}
+
 	for (;;) {
 		running = 0;
 		over = 0;
@@ -1752,13 +1762,14 @@ SWITCH_DECLARE(switch_status_t) switch_ivr_enterprise_originate(switch_core_sess
 			} else {
 				over++;
 			}
-
-			switch_yield(10000);
 		}
 
 		if (!running || over == x_argc) {
 			break;
 		}
+
+		/* the handles signal when their originate returns, the timeout covers cancel_cause */
+		switch_channel_watcher_wait(watcher, 20);
 	}
 
 
@@ -1848,6 +1859,11 @@ SWITCH_DECLARE(switch_status_t) switch_ivr_enterprise_originate(switch_core_sess
 		switch_event_destroy(&var_event);
 	}
 
+	if (channel) {
+		switch_channel_unwatch(channel, watcher);
+	}
+	switch_channel_watcher_release(&watcher);
+
 	switch_core_destroy_memory_pool(&pool);
 
 	return status;
@@ -2121,6 +2137,12 @@ SWITCH_DECLARE(switch_status_t) switch_ivr_originate(switch_core_session_t *sess
 	oglobals.error_file = NULL;
 	switch_core_new_memory_pool(&oglobals.pool);
 
+	/* woken by the state and answer changes of the caller and the peers instead of polling them */
+	switch_channel_watcher_create(&oglobals.watcher);
+	if (caller_channel) {
+		switch_channel_watch(caller_channel, oglobals.watcher);
+	}
+
 	if (caller_profile_override) {
 		oglobals.caller_profile_override = switch_caller_profile_dup(oglobals.pool, caller_profile_override);
 	} else if (session) {
@@ -3226,6 +3248,8 @@ SWITCH_DECLARE(switch_status_t) switch_ivr_originate(switch_core_session_t *sess
 					goto outer_for;
 				}
 
+				switch_channel_watch(oglobals.originate_status[i].peer_channel, oglobals.watcher);
+
 				if (!switch_core_session_running(oglobals.originate_status[i].peer_session)) {
 					if (oglobals.originate_status[i].per_channel_delay_start) {
 						switch_channel_set_flag(oglobals.originate_status[i].peer_channel, CF_BLOCK_STATE);
@@ -3279,8 +3303,6 @@ SWITCH_DECLARE(switch_status_t) switch_ivr_originate(switch_core_session_t *sess
 						}
 						goto notready;
 					}
-
-					switch_cond_next();
 				}
 
 				check_per_channel_timeouts(&oglobals, and_argc, start, &force_reason);
@@ -3291,6 +3313,7 @@ SWITCH_DECLARE(switch_status_t) switch_ivr_originate(switch_core_session_t *sess
 					goto done;
 				}
 
+				switch_channel_watcher_wait(oglobals.watcher, 20);
 			}
 
 		  endfor1:
@@ -3565,7 +3588,8 @@ SWITCH_DECLARE(switch_status_t) switch_ivr_originate(switch_core_session_t *sess
 			do_continue:
 
 				if (!read_packet) {
-					switch_yield(20000);
+					/* the timeout keeps the cadence of the ringback, cancel_cause and the time limits */
+					switch_channel_watcher_wait(oglobals.watcher, 20);
 				}
 			}
 
@@ -3713,6 +3737,9 @@ SWITCH_DECLARE(switch_status_t) switch_ivr_originate(switch_core_session_t *sess
 						if (caller_channel && switch_channel_up_nosig(caller_channel) && !switch_channel_test_flag(caller_channel, CF_INTERCEPTED)) {
 							switch_channel_hangup(caller_channel, SWITCH_CAUSE_ATTENDED_TRANSFER);
 						}
+						if (caller_channel) {
+							switch_channel_unwatch(caller_channel, oglobals.watcher);
+						}
 						caller_channel = NULL;
 						oglobals.session = NULL;
 						session = NULL;
@@ -4101,6 +4128,8 @@ SWITCH_DECLARE(switch_status_t) switch_ivr_originate(switch_core_session_t *sess
 					continue;
 				}
 
+				switch_channel_unwatch(oglobals.originate_status[i].peer_channel, oglobals.watcher);
+
 				if (session) {
 					val = switch_core_session_sprintf(oglobals.originate_status[i].peer_session, "%s;%s",
 													  switch_core_session_get_uuid(oglobals.originate_status[i].peer_session),
@@ -4261,6 +4290,10 @@ SWITCH_DECLARE(switch_status_t) switch_ivr_originate(switch_core_session_t *sess
 		}
 	}
 
+	if (caller_channel) {
+		switch_channel_unwatch(caller_channel, oglobals.watcher);
+	}
+	switch_channel_watcher_release(&oglobals.watcher);
 
 	switch_core_destroy_memory_pool(&oglobals.pool);
 
@@ -1,4 +1,5 @@
 #include "switch.h"
+#include <locale.h>
 
 SWITCH_DECLARE(cJSON *) cJSON_CreateStringPrintf(const char *fmt, ...)
 {
@@ -28,6 +29,326 @@ SWITCH_DECLARE(const char *)cJSON_GetObjectCstr(const cJSON *object, const char
 	   return cj->valuestring;
 }
 
+static void json_writer_grow(switch_json_writer_t *w, switch_size_t need)
+{
+	switch_size_t size = w->size ? w->size : 256;
+	char *data;
+
+	while (size < w->len + need + 1) {
+		size *= 2;
+	}
+
+	if (w->data == w->initial) {
+		data = malloc(size);
+		switch_assert(data);
+		if (w->len) {
+			memcpy(data, w->data, w->len);
+		}
+	} else {
+		data = realloc(w->data, size);
+		switch_assert(data);
+	}
+
+	w->data = data;
+	w->size = size;
+}
+
+static inline char *json_writer_ensure(switch_json_writer_t *w, switch_size_t need)
+{
+	if (w->len + need + 1 > w->size) {
+		json_writer_grow(w, need);
+	}
+
+	return w->data + w->len;
+}
+
+static inline void json_writer_putc(switch_json_writer_t *w, char c)
+{
+	char *p = json_writer_ensure(w, 1);
+
+	*p = c;
+	w->len++;
+}
+
+/* comma between members, nothing between a key and its value */
+static inline void json_writer_sep(switch_json_writer_t *w)
+{
+	if (w->pending_key) {
+		w->pending_key = 0;
+	} else if (!w->first) {
+		json_writer_putc(w, ',');
+	}
+
+	w->first = 0;
+}
+
+/* same escaping as print_string_ptr in cJSON.c, without the quotes */
+static void json_writer_escape(switch_json_writer_t *w, const char *str)
+{
+	const unsigned char *s;
+	switch_size_t escapes = 0, len;
+	char *p;
+
+	for (s = (const unsigned char *) str; *s; s++) {
+		switch (*s) {
+		case '"':
+		case '\\':
+		case '\b':
+		case '\f':
+		case '\n':
+		case '\r':
+		case '\t':
+			escapes++;
+			break;
+		default:
+			if (*s < 32) {
+				escapes += 5;
+			}
+			break;
+		}
+	}
+
+	len = (switch_size_t) (s - (const unsigned char *) str);
+	p = json_writer_ensure(w, len + escapes);
+
+	if (!escapes) {
+		memcpy(p, str, len);
+		p += len;
+	} else {
+		for (s = (const unsigned char *) str; *s; s++) {
+			if (*s > 31 && *s != '"' && *s != '\\') {
+				*p++ = *s;
+				continue;
+			}
+
+			*p++ = '\\';
+			switch (*s) {
+			case '\\':
+				*p++ = '\\';
+				break;
+			case '"':
+				*p++ = '"';
+				break;
+			case '\b':
+				*p++ = 'b';
+				break;
+			case '\f':
+				*p++ = 'f';
+				break;
+			case '\n':
+				*p++ = 'n';
+				break;
+			case '\r':
+				*p++ = 'r';
+				break;
+			case '\t':
+				*p++ = 't';
+				break;
+			default:
+				sprintf(p, "u%04x", *s);
+				p += 5;
+				break;
+			}
+		}
+	}
+
+	w->len += len + escapes;
+}
+
+static void json_writer_quote(switch_json_writer_t *w, const char *str)
+{
+	json_writer_putc(w, '"');
+	if (str) {
+		json_writer_escape(w, str);
+	}
+	json_writer_putc(w, '"');
+}
+
+SWITCH_DECLARE(void) switch_json_writer_init(switch_json_writer_t *w, char *buf, switch_size_t size)
+{
+	memset(w, 0, sizeof(*w));
+
+	if (buf && size) {
+		w->data = w->initial = buf;
+		w->size = size;
+	}
+
+	w->first = 1;
+}
+
+SWITCH_DECLARE(void) switch_json_writer_reset(switch_json_writer_t *w)
+{
+	w->len = 0;
+	w->first = 1;
+	w->pending_key = 0;
+}
+
+SWITCH_DECLARE(void) switch_json_writer_destroy(switch_json_writer_t *w)
+{
+	if (w->data != w->initial) {
+		free(w->data);
+	}
+
+	w->data = w->initial = NULL;
+	w->len = w->size = 0;
+}
+
+SWITCH_DECLARE(void) switch_json_writer_object_start(switch_json_writer_t *w)
+{
+	json_writer_sep(w);
+	json_writer_putc(w, '{');
+	w->first = 1;
+}
+
+SWITCH_DECLARE(void) switch_json_writer_object_end(switch_json_writer_t *w)
+{
+	json_writer_putc(w, '}');
+	w->first = 0;
+}
+
+SWITCH_DECLARE(void) switch_json_writer_array_start(switch_json_writer_t *w)
+{
+	json_writer_sep(w);
+	json_writer_putc(w, '[');
+	w->first = 1;
+}
+
+SWITCH_DECLARE(void) switch_json_writer_array_end(switch_json_writer_t *w)
+{
+	json_writer_putc(w, ']');
+	w->first = 0;
+}
+
+SWITCH_DECLARE(void) switch_json_writer_key(switch_json_writer_t *w, const char *name)
+{
+	json_writer_sep(w);
+	json_writer_quote(w, name);
+	json_writer_putc(w, ':');
+	w->pending_key = 1;
+}
+
+SWITCH_DECLARE(void) switch_json_writer_key_prefixed(switch_json_writer_t *w, const char *prefix, const char *name)
+{
+	json_writer_sep(w);
+	json_writer_putc(w, '"');
+	if (prefix) {
+		json_writer_escape(w, prefix);
+	}
+	if (name) {
+		json_writer_escape(w, name);
+	}
+	json_writer_putc(w, '"');
+	json_writer_putc(w, ':');
+	w->pending_key = 1;
+}
+
+SWITCH_DECLARE(void) switch_json_writer_string(switch_json_writer_t *w, const char *val)
+{
+	json_writer_sep(w);
+	json_writer_quote(w, val);
+}
+
+/* same formatting as print_number in cJSON.c */
+SWITCH_DECLARE(void) switch_json_writer_number(switch_json_writer_t *w, double val)
+{
+	char buf[26];
+	char decimal_point = '.';
+	struct lconv *lc = localeconv();
+	double test;
+	int i, len;
+	char *p;
+
+	json_writer_sep(w);
+
+	if (lc && lc->decimal_point) {
+		decimal_point = *lc->decimal_point;
+	}
+
+	if ((val * 0) != 0) {
+		len = sprintf(buf, "null");
+	} else {
+		len = sprintf(buf, "%1.15g", val);
+
+		if (sscanf(buf, "%lg", &test) != 1 || test != val) {
+			len = sprintf(buf, "%1.17g", val);
+		}
+	}
+
+	if (len < 0 || len > (int) sizeof(buf) - 1) {
+		return;
+	}
+
+	p = json_writer_ensure(w, len);
+
+	for (i = 0; i < len; i++) {
+		p[i] = buf[i] == decimal_point ? '.' : buf[i];
+	}
+
+	w->len += len;
+}
+
+SWITCH_DECLARE(void) switch_json_writer_cjson(switch_json_writer_t *w, const cJSON *item)
+{
+	char *p;
+	char *text;
+
+	json_writer_sep(w);
+
+	/* print into the space we already have first, most items are small */
+	p = json_writer_ensure(w, 64);
+	if (cJSON_PrintPreallocated((cJSON *) item, p, (int) (w->size - w->len), 0)) {
+		w->len += strlen(p);
+		return;
+	}
+
+	if ((text = cJSON_PrintUnformatted(item))) {
+		switch_size_t len = strlen(text);
+
+		p = json_writer_ensure(w, len);
+		memcpy(p, text, len);
+		w->len += len;
+		free(text);
+	}
+}
+
+SWITCH_DECLARE(void) switch_json_writer_add_string(switch_json_writer_t *w, const char *name, const char *val)
+{
+	if (!name || !val) {
+		return;
+	}
+
+	switch_json_writer_key(w, name);
+	switch_json_writer_string(w, val);
+}
+
+SWITCH_DECLARE(void) switch_json_writer_add_number(switch_json_writer_t *w, const char *name, double val)
+{
+	if (!name) {
+		return;
+	}
+
+	switch_json_writer_key(w, name);
+	switch_json_writer_number(w, val);
+}
+
+SWITCH_DECLARE(const char *) switch_json_writer_get(switch_json_writer_t *w)
+{
+	json_writer_ensure(w, 0);
+	w->data[w->len] = '\0';
+
+	return w->data;
+}
+
+SWITCH_DECLARE(char *) switch_json_writer_dup(switch_json_writer_t *w)
+{
+	char *str = malloc(w->len + 1);
+
+	switch_assert(str);
+	memcpy(str, switch_json_writer_get(w), w->len + 1);
+
+	return str;
+}
+
 /* For Emacs:
  * Local Variables:
  * mode:c
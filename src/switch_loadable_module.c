@@ -78,8 +78,62 @@ struct switch_loadable_module {
 	switch_loadable_module_type_t type;
 };
 
+typedef struct switch_module_timeline_s {
+	const char *name;
+	const char *what;
+	switch_time_t start;
+	switch_time_t end;
+	switch_status_t status;
+	struct switch_module_timeline_s *next;
+} switch_module_timeline_t;
+
+typedef struct switch_module_load_job_s {
+	char *name;
+	char *path;
+	char *depends;
+	switch_bool_t global;
+	switch_bool_t critical;
+	switch_bool_t parallel;
+	int *deps;
+	int dep_count;
+	int state;
+	switch_status_t status;
+} switch_module_load_job_t;
+
+typedef struct switch_module_task_s {
+	const char *modname;
+	const char *what;
+	switch_loadable_module_task_t task;
+	void *obj;
+	struct switch_module_task_s *next;
+} switch_module_task_t;
+
+typedef enum {
+	MLJ_PENDING,
+	MLJ_RUNNING,
+	MLJ_DONE
+} switch_module_load_job_state_t;
+
+typedef struct switch_module_loader_s {
+	switch_mutex_t *mutex;
+	switch_thread_cond_t *cond;
+	switch_module_load_job_t *jobs;
+	int job_count;
+	int job_size;
+	int done;
+	int running;
+	switch_module_task_t *tasks;
+	switch_module_task_t *tasks_tail;
+	const char *cancel;
+	switch_loadable_module_load_func_t load_func;
+	void *user_data;
+	switch_memory_pool_t *pool;
+} switch_module_loader_t;
+
 struct switch_loadable_module_container {
 	switch_hash_t *module_hash;
+	/* names reserved by a load in progress, so loader threads never load one module twice */
+	switch_hash_t *loading_hash;
 	switch_hash_t *endpoint_hash;
 	switch_hash_t *codec_hash;
 	switch_hash_t *dialplan_hash;
@@ -100,6 +154,10 @@ struct switch_loadable_module_container {
 	switch_hash_t *secondary_recover_hash;
 	switch_mutex_t *mutex;
 	switch_memory_pool_t *pool;
+	switch_module_loader_t *loader;
+	switch_time_t started;
+	switch_module_timeline_t *timeline;
+	switch_module_timeline_t *timeline_tail;
 };
 
 static struct switch_loadable_module_container loadable_modules;
@@ -1772,6 +1830,81 @@ static switch_status_t switch_loadable_module_load_file(char *path, char *filena
 	return SWITCH_STATUS_SUCCESS;
 
 }
+static void switch_loadable_module_timeline_add(const char *name, const char *what, switch_time_t start, switch_status_t status)
+{
+	switch_module_timeline_t *tl;
+
+	switch_mutex_lock(loadable_modules.mutex);
+	tl = switch_core_alloc(loadable_modules.pool, sizeof(*tl));
+	tl->name = switch_core_strdup(loadable_modules.pool, name);
+	tl->what = switch_core_strdup(loadable_modules.pool, what);
+	tl->start = start;
+	tl->end = switch_time_now();
+	tl->status = status;
+
+	if (loadable_modules.timeline_tail) {
+		loadable_modules.timeline_tail->next = tl;
+	} else {
+		loadable_modules.timeline = tl;
+	}
+	loadable_modules.timeline_tail = tl;
+	switch_mutex_unlock(loadable_modules.mutex);
+}
+
+SWITCH_DECLARE(void) switch_loadable_module_timeline(switch_stream_handle_t *stream)
+{
+	switch_module_timeline_t *tl;
+
+	stream->write_function(stream, "%-32s %-24s %10s %10s %s\n", "module", "step", "start(ms)", "took(ms)", "status");
+
+	switch_mutex_lock(loadable_modules.mutex);
+	for (tl = loadable_modules.timeline; tl; tl = tl->next) {
+		stream->write_function(stream, "%-32s %-24s %10" SWITCH_TIME_T_FMT " %10" SWITCH_TIME_T_FMT " %s\n", tl->name, tl->what,
+							   (tl->start - loadable_modules.started) / 1000, (tl->end - tl->start) / 1000,
+							   tl->status == SWITCH_STATUS_SUCCESS || tl->status == SWITCH_STATUS_NOUNLOAD ? "ok" : "failed");
+	}
+	switch_mutex_unlock(loadable_modules.mutex);
+}
+
+SWITCH_DECLARE(switch_status_t) switch_loadable_module_defer(const char *modname, const char *what, switch_loadable_module_task_t task, void *obj)
+{
+	switch_module_loader_t *loader;
+	switch_module_task_t *mt;
+	switch_time_t start;
+	switch_status_t status;
+
+	switch_mutex_lock(loadable_modules.mutex);
+	if ((loader = loadable_modules.loader)) {
+		switch_mutex_lock(loader->mutex);
+		mt = switch_core_alloc(loader->pool, sizeof(*mt));
+		mt->modname = switch_core_strdup(loader->pool, modname);
+		mt->what = switch_core_strdup(loader->pool, what);
+		mt->task = task;
+		mt->obj = obj;
+
+		if (loader->tasks_tail) {
+			loader->tasks_tail->next = mt;
+		} else {
+			loader->tasks = mt;
+		}
+		loader->tasks_tail = mt;
+
+		switch_thread_cond_broadcast(loader->cond);
+		switch_mutex_unlock(loader->mutex);
+	}
+	switch_mutex_unlock(loadable_modules.mutex);
+
+	if (loader) {
+		return SWITCH_STATUS_SUCCESS;
+	}
+
+	start = switch_time_now();
+	status = task(obj);
+	switch_loadable_module_timeline_add(modname, what, start, status);
+
+	return status;
+}
+
 SWITCH_DECLARE(switch_status_t) switch_loadable_module_load_module(const char *dir, const char *fname, switch_bool_t runtime, const char **err)
 {
 	return switch_loadable_module_load_module_ex(dir, fname, runtime, SWITCH_FALSE, err, SWITCH_LOADABLE_MODULE_TYPE_COMMON, NULL);
@@ -1784,6 +1917,8 @@ static switch_status_t switch_loadable_module_load_module_ex(const char *dir, co
 	char *file, *dot;
 	switch_loadable_module_t *new_module = NULL;
 	switch_status_t status = SWITCH_STATUS_SUCCESS;
+	switch_time_t start = switch_time_now();
+	int loaded;
 
 #ifdef WIN32
 	const char *ext = ".dll";
@@ -1816,7 +1951,14 @@ static switch_status_t switch_loadable_module_load_module_ex(const char *dir, co
 	}
 
 
-	if (switch_core_hash_find_locked(loadable_modules.module_hash, file, loadable_modules.mutex)) {
+	/* check and reserve the name in one go, the loader threads may have the same module listed twice */
+	switch_mutex_lock(loadable_modules.mutex);
+	if (!(loaded = switch_core_hash_find(loadable_modules.module_hash, file) || switch_core_hash_find(loadable_modules.loading_hash, file))) {
+		switch_core_hash_insert(loadable_modules.loading_hash, file, file);
+	}
+	switch_mutex_unlock(loadable_modules.mutex);
+
+	if (loaded) {
 		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "Module %s Already Loaded!\n", file);
 		*err = "Module already loaded";
 		status = SWITCH_STATUS_FALSE;
@@ -1834,6 +1976,11 @@ static switch_status_t switch_loadable_module_load_module_ex(const char *dir, co
 		*err = "module load file routine returned an error";
 	}
 
+	if (!loaded) {
+		switch_core_hash_delete_locked(loadable_modules.loading_hash, file, loadable_modules.mutex);
+	}
+
+	switch_loadable_module_timeline_add(file, "load", start, status);
 
 	return status;
 
@@ -2073,6 +2220,342 @@ static void switch_loadable_module_path_init()
 }
 #endif
 
+static int switch_loadable_module_name_eq(const char *a, const char *b)
+{
+	const char *ea = strchr(a, '.'), *eb = strchr(b, '.');
+	size_t la = ea ? (size_t) (ea - a) : strlen(a);
+	size_t lb = eb ? (size_t) (eb - b) : strlen(b);
+
+	return la == lb && !strncasecmp(a, b, la);
+}
+
+static switch_module_loader_t *switch_loadable_module_loader_create(switch_xml_t mods)
+{
+	switch_module_loader_t *loader;
+	switch_memory_pool_t *pool;
+	switch_xml_t ld;
+	int count = 0;
+
+	for (ld = switch_xml_child(mods, "load"); ld; ld = ld->next) {
+		count++;
+	}
+
+	switch_core_new_memory_pool(&pool);
+	loader = switch_core_alloc(pool, sizeof(*loader));
+	loader->pool = pool;
+	loader->job_size = count;
+	loader->jobs = switch_core_alloc(pool, sizeof(*loader->jobs) * (count ? count : 1));
+	switch_mutex_init(&loader->mutex, SWITCH_MUTEX_NESTED, pool);
+	switch_thread_cond_create(&loader->cond, pool);
+
+	return loader;
+}
+
+static void switch_loadable_module_loader_add(switch_module_loader_t *loader, const char *path, const char *name, switch_bool_t global,
+											  switch_bool_t critical, const char *depends, switch_bool_t parallel)
+{
+	switch_module_load_job_t *job;
+
+	switch_assert(loader->job_count < loader->job_size);
+	job = &loader->jobs[loader->job_count++];
+	job->path = path ? switch_core_strdup(loader->pool, path) : NULL;
+	job->name = switch_core_strdup(loader->pool, name);
+	job->depends = zstr(depends) ? NULL : switch_core_strdup(loader->pool, depends);
+	job->global = global;
+	job->critical = critical;
+	job->parallel = parallel || job->depends;
+	job->state = MLJ_PENDING;
+}
+
+/* An entry without depends or parallel keeps the file order, it waits for the entry of that kind before it and for
+   everything listed in between.  The others only wait for what their depends attribute names. */
+static void switch_loadable_module_loader_resolve(switch_module_loader_t *loader)
+{
+	int i, j, x, serial = -1;
+
+	for (i = 0; i < loader->job_count; i++) {
+		switch_module_load_job_t *job = &loader->jobs[i];
+		char *argv[64] = { 0 };
+		int argc;
+
+		if (!job->parallel) {
+			j = serial < 0 ? 0 : serial;
+			job->deps = switch_core_alloc(loader->pool, sizeof(int) * (i - j + 1));
+			for (; j < i; j++) {
+				job->deps[job->dep_count++] = j;
+			}
+			serial = i;
+			continue;
+		}
+
+		if (!job->depends) {
+			continue;
+		}
+
+		argc = switch_separate_string(job->depends, ',', argv, (sizeof(argv) / sizeof(argv[0])));
+		job->deps = switch_core_alloc(loader->pool, sizeof(int) * argc);
+
+		for (x = 0; x < argc; x++) {
+			char *dep = switch_strip_whitespace(argv[x]);
+			int found = 0;
+
+			for (j = 0; j < loader->job_count; j++) {
+				if (j != i && switch_loadable_module_name_eq(loader->jobs[j].name, dep)) {
+					job->deps[job->dep_count++] = j;
+					found = 1;
+					break;
+				}
+			}
+
+			if (!found && switch_loadable_module_exists(dep) != SWITCH_STATUS_SUCCESS) {
+				switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "Module %s depends on %s which is not in modules.conf\n", job->name, dep);
+			}
+
+			switch_safe_free(dep);
+		}
+	}
+}
+
+static switch_module_load_job_t *switch_loadable_module_loader_next(switch_module_loader_t *loader)
+{
+	int i, x;
+
+	for (i = 0; i < loader->job_count; i++) {
+		switch_module_load_job_t *job = &loader->jobs[i];
+		int ready = 1;
+
+		if (job->state != MLJ_PENDING) {
+			continue;
+		}
+
+		for (x = 0; x < job->dep_count; x++) {
+			if (loader->jobs[job->deps[x]].state != MLJ_DONE) {
+				ready = 0;
+				break;
+			}
+		}
+
+		if (ready) {
+			return job;
+		}
+	}
+
+	return NULL;
+}
+
+static void *SWITCH_THREAD_FUNC switch_loadable_module_loader_thread(switch_thread_t *thread, void *obj)
+{
+	switch_module_loader_t *loader = (switch_module_loader_t *) obj;
+
+	switch_mutex_lock(loader->mutex);
+
+	for (;;) {
+		switch_module_task_t *mt;
+		switch_module_load_job_t *job;
+		const char *cancel;
+		switch_time_t start;
+		switch_status_t status;
+		int i;
+
+		if ((mt = loader->tasks)) {
+			if (!(loader->tasks = mt->next)) {
+				loader->tasks_tail = NULL;
+			}
+			loader->running++;
+			switch_mutex_unlock(loader->mutex);
+
+			start = switch_time_now();
+			status = mt->task(mt->obj);
+			switch_loadable_module_timeline_add(mt->modname, mt->what, start, status);
+
+			switch_mutex_lock(loader->mutex);
+			loader->running--;
+			switch_thread_cond_broadcast(loader->cond);
+			continue;
+		}
+
+		if (loader->done == loader->job_count) {
+			if (!loader->running) {
+				switch_thread_cond_broadcast(loader->cond);
+				break;
+			}
+			switch_thread_cond_wait(loader->cond, loader->mutex);
+			continue;
+		}
+
+		if (!(job = switch_loadable_module_loader_next(loader))) {
+			if (loader->running) {
+				switch_thread_cond_wait(loader->cond, loader->mutex);
+				continue;
+			}
+
+			/* nothing is loading and nothing can start, the depends attributes go round in a circle */
+			for (i = 0; i < loader->job_count; i++) {
+				if (loader->jobs[i].state == MLJ_PENDING) {
+					job = &loader->jobs[i];
+					break;
+				}
+			}
+
+			switch_assert(job);
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "Circular module dependency, loading %s anyway\n", job->name);
+		}
+
+		job->state = MLJ_RUNNING;
+		loader->running++;
+		cancel = loader->cancel;
+		switch_mutex_unlock(loader->mutex);
+
+		if (cancel) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "Not loading %s, startup was cancelled by %s\n", job->name, cancel);
+			job->status = SWITCH_STATUS_FALSE;
+		} else {
+			job->status = loader->load_func(job->path, job->name, job->global, loader->user_data);
+		}
+
+		switch_mutex_lock(loader->mutex);
+		if (job->status == SWITCH_STATUS_GENERR && job->critical && !loader->cancel) {
+			loader->cancel = job->name;
+		}
+		job->state = MLJ_DONE;
+		loader->done++;
+		loader->running--;
+		switch_thread_cond_broadcast(loader->cond);
+	}
+
+	switch_mutex_unlock(loader->mutex);
+
+	return NULL;
+}
+
+/* Load the modules collected in the loader on a pool of threads.  A module only starts once the modules named in its
+   depends attribute are done, the work a module handed to switch_loadable_module_defer runs on the same threads and
+   this returns when all of it is finished, or the name of the critical module that failed to load. */
+static char *switch_loadable_module_loader_run(switch_module_loader_t *loader, uint32_t thread_count)
+{
+	switch_thread_t *threads[64] = { 0 };
+	switch_threadattr_t *thd_attr = NULL;
+	switch_module_task_t *mt;
+	switch_status_t st;
+	char *cancel;
+	uint32_t i;
+
+	if (thread_count > (sizeof(threads) / sizeof(threads[0]))) {
+		thread_count = (sizeof(threads) / sizeof(threads[0]));
+	}
+
+	switch_loadable_module_loader_resolve(loader);
+
+	switch_mutex_lock(loadable_modules.mutex);
+	loadable_modules.loader = loader;
+	switch_mutex_unlock(loadable_modules.mutex);
+
+	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CONSOLE, "Loading %d modules on %u threads\n", loader->job_count, thread_count);
+
+	switch_threadattr_create(&thd_attr, loader->pool);
+	switch_threadattr_stacksize_set(thd_attr, SWITCH_THREAD_STACKSIZE);
+
+	for (i = 0; i < thread_count; i++) {
+		switch_thread_create(&threads[i], thd_attr, switch_loadable_module_loader_thread, loader, loader->pool);
+	}
+
+	for (i = 0; i < thread_count; i++) {
+		if (threads[i]) {
+			switch_thread_join(&st, threads[i]);
+		}
+	}
+
+	switch_mutex_lock(loadable_modules.mutex);
+	loadable_modules.loader = NULL;
+	switch_mutex_unlock(loadable_modules.mutex);
+
+	/* anything deferred after the last thread left */
+	while ((mt = loader->tasks)) {
+		switch_time_t start = switch_time_now();
+		switch_status_t status;
+
+		loader->tasks = mt->next;
+		status = mt->task(mt->obj);
+		switch_loadable_module_timeline_add(mt->modname, mt->what, start, status);
+	}
+
+	cancel = loader->cancel ? strdup(loader->cancel) : NULL;
+	switch_core_destroy_memory_pool(&loader->pool);
+
+	return cancel;
+}
+
+static switch_status_t switch_loadable_module_load_entry(const char *path, const char *name, switch_bool_t global, void *user_data)
+{
+	const char *err;
+
+	return switch_loadable_module_load_module_ex(path, name, SWITCH_FALSE, global, &err, SWITCH_LOADABLE_MODULE_TYPE_COMMON, NULL);
+}
+
+SWITCH_DECLARE(unsigned int) switch_loadable_module_load_list(switch_xml_t mods, uint32_t threads, switch_loadable_module_load_func_t load_func,
+															  void *user_data, char **failed)
+{
+	switch_module_loader_t *loader = NULL;
+	switch_xml_t ld;
+	unsigned int count = 0;
+
+#ifdef WIN32
+	const char *ext = ".dll";
+	const char *EXT = ".DLL";
+#elif defined (MACOSX) || defined (DARWIN)
+	const char *ext = ".dylib";
+	const char *EXT = ".DYLIB";
+#else
+	const char *ext = ".so";
+	const char *EXT = ".SO";
+#endif
+
+	*failed = NULL;
+
+	if (!load_func) {
+		load_func = switch_loadable_module_load_entry;
+	}
+
+	if (threads > 1) {
+		loader = switch_loadable_module_loader_create(mods);
+		loader->load_func = load_func;
+		loader->user_data = user_data;
+	}
+
+	for (ld = switch_xml_child(mods, "load"); ld; ld = ld->next) {
+		switch_bool_t global = SWITCH_FALSE;
+		const char *val = switch_xml_attr_soft(ld, "module");
+		const char *path = switch_xml_attr_soft(ld, "path");
+		const char *critical = switch_xml_attr_soft(ld, "critical");
+		const char *sglobal = switch_xml_attr_soft(ld, "global");
+		if (zstr(val) || (strchr(val, '.') && !strstr(val, ext) && !strstr(val, EXT))) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CONSOLE, "Invalid extension for %s\n", val);
+			continue;
+		}
+		global = switch_true(sglobal);
+
+		if (path && zstr(path)) {
+			path = SWITCH_GLOBAL_dirs.mod_dir;
+		}
+		if (loader) {
+			switch_loadable_module_loader_add(loader, path, val, global, switch_true(critical), switch_xml_attr(ld, "depends"),
+											  switch_true(switch_xml_attr(ld, "parallel")));
+		} else if (load_func(path, val, global, user_data) == SWITCH_STATUS_GENERR) {
+			if (critical && switch_true(critical)) {
+				*failed = strdup(val);
+				return count + 1;
+			}
+		}
+		count++;
+	}
+
+	if (loader) {
+		*failed = switch_loadable_module_loader_run(loader, threads);
+	}
+
+	return count;
+}
+
 SWITCH_DECLARE(switch_status_t) switch_loadable_module_init(switch_bool_t autoload)
 {
 
@@ -2105,6 +2588,7 @@ SWITCH_DECLARE(switch_status_t) switch_loadable_module_init(switch_bool_t autolo
 
 	memset(&loadable_modules, 0, sizeof(loadable_modules));
 	switch_core_new_memory_pool(&loadable_modules.pool);
+	loadable_modules.started = switch_time_now();
 
 
 #ifdef WIN32
@@ -2112,6 +2596,7 @@ SWITCH_DECLARE(switch_status_t) switch_loadable_module_init(switch_bool_t autolo
 #endif
 
 	switch_core_hash_init(&loadable_modules.module_hash);
+	switch_core_hash_init(&loadable_modules.loading_hash);
 	switch_core_hash_init_nocase(&loadable_modules.endpoint_hash);
 	switch_core_hash_init_nocase(&loadable_modules.codec_hash);
 	switch_core_hash_init_nocase(&loadable_modules.timer_hash);
@@ -2149,6 +2634,7 @@ SWITCH_DECLARE(switch_status_t) switch_loadable_module_init(switch_bool_t autolo
 	switch_loadable_module_load_module_ex("", "CORE_SOFTTIMER_MODULE", SWITCH_FALSE, SWITCH_FALSE, &err, SWITCH_LOADABLE_MODULE_TYPE_COMMON, event_hash);
 	switch_loadable_module_load_module_ex("", "CORE_PCM_MODULE", SWITCH_FALSE, SWITCH_FALSE, &err, SWITCH_LOADABLE_MODULE_TYPE_COMMON, event_hash);
 	switch_loadable_module_load_module_ex("", "CORE_SPEEX_MODULE", SWITCH_FALSE, SWITCH_FALSE, &err, SWITCH_LOADABLE_MODULE_TYPE_COMMON, event_hash);
+	switch_loadable_module_load_module_ex("", "CORE_PROMPT_CACHE_MODULE", SWITCH_FALSE, SWITCH_FALSE, &err, SWITCH_LOADABLE_MODULE_TYPE_COMMON, event_hash);
 
 	/*
 		Loading pre-load modules.
@@ -2220,30 +2706,16 @@ SWITCH_DECLARE(switch_status_t) switch_loadable_module_init(switch_bool_t autolo
 
 	/* Loading common modules */
 	if ((xml = switch_xml_open_cfg(cf, &cfg, NULL))) {
-		switch_xml_t mods, ld;
+		switch_xml_t mods;
 		if ((mods = switch_xml_child(cfg, "modules"))) {
-			for (ld = switch_xml_child(mods, "load"); ld; ld = ld->next) {
-				switch_bool_t global = SWITCH_FALSE;
-				const char *val = switch_xml_attr_soft(ld, "module");
-				const char *path = switch_xml_attr_soft(ld, "path");
-				const char *critical = switch_xml_attr_soft(ld, "critical");
-				const char *sglobal = switch_xml_attr_soft(ld, "global");
-				if (zstr(val) || (strchr(val, '.') && !strstr(val, ext) && !strstr(val, EXT))) {
-					switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CONSOLE, "Invalid extension for %s\n", val);
-					continue;
-				}
-				global = switch_true(sglobal);
+			char *failed = NULL;
 
-				if (path && zstr(path)) {
-					path = SWITCH_GLOBAL_dirs.mod_dir;
-				}
-				if (switch_loadable_module_load_module_ex(path, val, SWITCH_FALSE, global, &err, SWITCH_LOADABLE_MODULE_TYPE_COMMON, NULL) == SWITCH_STATUS_GENERR) {
-					if (critical && switch_true(critical)) {
-						switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CRIT, "Failed to load critical module '%s', abort()\n", val);
-						abort();
-					}
-				}
-				count++;
+			count += switch_loadable_module_load_list(mods, runtime.module_load_threads, NULL, NULL, &failed);
+
+			if (failed) {
+				switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CRIT, "Failed to load critical module '%s', abort()\n", failed);
+				free(failed);
+				abort();
 			}
 		}
 		switch_xml_free(xml);
@@ -2449,6 +2921,7 @@ SWITCH_DECLARE(void) switch_loadable_module_shutdown(void)
 	}
 
 	switch_core_hash_destroy(&loadable_modules.module_hash);
+	switch_core_hash_destroy(&loadable_modules.loading_hash);
 	switch_core_hash_destroy(&loadable_modules.endpoint_hash);
 	switch_core_hash_destroy(&loadable_modules.codec_hash);
 	switch_core_hash_destroy(&loadable_modules.timer_hash);
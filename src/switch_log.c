@@ -88,15 +88,238 @@ static const char *
 SWITCH_SEQ_FYELLOW };
 
 
+/* the message text without its initial space and new line */
+static char *log_node_message(const switch_log_node_t *node)
+{
+	char *full_message = node->content;
+
+	if (*full_message == ' ') {
+		full_message++;
+	}
+	if (*full_message == '\n') {
+		full_message++;
+	}
+
+	return full_message;
+}
+
+/* log tags, configured channel variables and LOG_FIELDS from the message, the message text is advanced past them */
+static switch_event_t *log_node_fields(const switch_log_node_t *node, switch_event_t *chan_vars, char **full_messageP, char **parsed_full_messageP)
+{
+	char *full_message = log_node_message(node);
+	switch_event_t *log_fields = NULL;
+	switch_core_session_t *session = NULL;
+
+	/* get fields from log tags */
+	if (node->tags) {
+		switch_event_dup(&log_fields, node->tags);
+	}
+
+	/* get fields from channel data, if configured */
+	if (!zstr(node->userdata) && chan_vars && chan_vars->headers && (session = switch_core_session_locate(node->userdata))) {
+		switch_channel_t *channel = switch_core_session_get_channel(session);
+		switch_event_header_t *hp;
+		/* session_fields name mapped to variable name */
+		for (hp = chan_vars->headers; hp; hp = hp->next) {
+			if (!zstr(hp->name) && !zstr(hp->value)) {
+				const char *val = switch_channel_get_variable(channel, hp->value);
+				if (!zstr(val)) {
+					if (!log_fields) {
+						switch_event_create_plain(&log_fields, SWITCH_EVENT_CHANNEL_DATA);
+					}
+					switch_event_add_header_string(log_fields, SWITCH_STACK_BOTTOM, hp->name, val);
+				}
+			}
+		}
+		switch_core_session_rwunlock(session);
+	}
+
+	/* parse list of fields from message text, if any */
+	if (strncmp(full_message, "LOG_FIELDS", 10) == 0) {
+		switch_event_create_brackets(full_message+10, '[', ']', ',', &log_fields, parsed_full_messageP, SWITCH_TRUE);
+		full_message = *parsed_full_messageP;
+	}
+
+	*full_messageP = full_message;
+	return log_fields;
+}
+
+static void log_node_write_field(switch_json_writer_t *w, const char *prefix, const char *name, const char *value)
+{
+	if (zstr(name) || zstr(value)) {
+		return;
+	}
+
+	if (strncmp(name, "@#", 2) == 0) {
+		switch_json_writer_key_prefixed(w, prefix, name + 2);
+		switch_json_writer_number(w, strtod(value, NULL));
+	} else {
+		switch_json_writer_key_prefixed(w, prefix, name);
+		switch_json_writer_string(w, value);
+	}
+}
+
+/*
+ * Tags and channel variables written as they are give what log_node_fields() would have merged them into, unless
+ * the tags keep their headers unique or carry a subclass header or the message has LOG_FIELDS to parse
+ */
+static switch_bool_t log_node_fields_direct(const switch_log_node_t *node, const char *full_message)
+{
+	if (strncmp(full_message, "LOG_FIELDS", 10) == 0) {
+		return SWITCH_FALSE;
+	}
+
+	return !node->tags || (!node->tags->subclass_name && !switch_test_flag(node->tags, EF_UNIQ_HEADERS));
+}
+
+SWITCH_DECLARE(void) switch_log_node_json_write(switch_json_writer_t *w, const switch_log_node_t *node, int log_level, switch_log_json_format_t *json_format, switch_event_t *chan_vars)
+{
+	char *hostname;
+	char *full_message = log_node_message(node);
+	char *parsed_full_message = NULL;
+	const char *prefix = json_format->custom_field_prefix ? json_format->custom_field_prefix : "";
+	switch_event_t *log_fields = NULL;
+	switch_core_session_t *session = NULL;
+	switch_event_header_t *hp;
+
+	if (node->meta && cJSON_IsObject(node->meta)) {
+		cJSON *field = NULL;
+
+		for (field = node->meta->child; field; field = field->next) {
+			if (json_format->custom_field_prefix) {
+				if (!zstr(field->string)) {
+					switch_json_writer_key_prefixed(w, json_format->custom_field_prefix, field->string);
+					switch_json_writer_cjson(w, field);
+				}
+			} else {
+				switch_json_writer_key(w, field->string);
+				switch_json_writer_cjson(w, field);
+			}
+		}
+	}
+
+	if (json_format->version.name && json_format->version.value) {
+		switch_json_writer_add_string(w, json_format->version.name, json_format->version.value);
+	}
+	if (json_format->host.name) {
+		if (json_format->host.value) {
+			switch_json_writer_add_string(w, json_format->host.name, json_format->host.value);
+		} else if ((hostname = switch_core_get_variable("hostname")) && !zstr(hostname)) {
+			switch_json_writer_add_string(w, json_format->host.name, hostname);
+		} else if ((hostname = switch_core_get_variable("local_ip_v4")) && !zstr(hostname)) {
+			switch_json_writer_add_string(w, json_format->host.name, hostname);
+		}
+	}
+	if (json_format->timestamp.name) {
+		double timestamp = node->timestamp;
+		if (json_format->timestamp_divisor > 1.0) {
+			timestamp = timestamp / json_format->timestamp_divisor;
+		}
+		switch_json_writer_add_number(w, json_format->timestamp.name, timestamp);
+	}
+	if (json_format->level.name) {
+		switch_json_writer_add_number(w, json_format->level.name, log_level);
+	}
+	if (json_format->ident.name) {
+		if (json_format->ident.value) {
+			switch_json_writer_add_string(w, json_format->ident.name, json_format->ident.value);
+		} else {
+			switch_json_writer_add_string(w, json_format->ident.name, "freeswitch");
+		}
+	}
+	if (json_format->pid.name) {
+		if (json_format->pid.value) {
+			switch_json_writer_add_number(w, json_format->pid.name, atoi(json_format->pid.value));
+		} else {
+			switch_json_writer_add_number(w, json_format->pid.name, (int)getpid());
+		}
+	}
+	if (json_format->uuid.name && !zstr(node->userdata)) {
+		switch_json_writer_add_string(w, json_format->uuid.name, node->userdata);
+	}
+	if (json_format->file.name && !zstr_buf(node->file)) {
+		switch_json_writer_add_string(w, json_format->file.name, node->file);
+		if (json_format->line.name) {
+			switch_json_writer_add_number(w, json_format->line.name, node->line);
+		}
+	}
+	if (json_format->function.name && !zstr_buf(node->func)) {
+		switch_json_writer_add_string(w, json_format->function.name, node->func);
+	}
+	if (json_format->sequence.name) {
+		switch_json_writer_add_number(w, json_format->sequence.name, node->sequence);
+	}
+
+	/* add additional fields, straight from the tags and the channel when nothing has to be merged first */
+	if (log_node_fields_direct(node, full_message)) {
+		if (node->tags) {
+			for (hp = node->tags->headers; hp; hp = hp->next) {
+				log_node_write_field(w, prefix, hp->name, hp->value);
+			}
+		}
+
+		if (!zstr(node->userdata) && chan_vars && chan_vars->headers && (session = switch_core_session_locate(node->userdata))) {
+			switch_channel_t *channel = switch_core_session_get_channel(session);
+
+			/* session_fields name mapped to variable name */
+			for (hp = chan_vars->headers; hp; hp = hp->next) {
+				if (!zstr(hp->name) && !zstr(hp->value)) {
+					log_node_write_field(w, prefix, hp->name, switch_channel_get_variable(channel, hp->value));
+				}
+			}
+			switch_core_session_rwunlock(session);
+		}
+	} else if ((log_fields = log_node_fields(node, chan_vars, &full_message, &parsed_full_message))) {
+		for (hp = log_fields->headers; hp; hp = hp->next) {
+			log_node_write_field(w, prefix, hp->name, hp->value);
+		}
+		switch_event_destroy(&log_fields);
+	}
+
+	if (json_format->full_message.name) {
+		switch_json_writer_add_string(w, json_format->full_message.name, full_message);
+	} else {
+		switch_json_writer_add_string(w, "message", full_message);
+	}
+
+	if (json_format->short_message.name) {
+		char short_message[151];
+		char *short_message_end = NULL;
+		switch_snprintf(short_message, sizeof(short_message) - 1, "%s", full_message);
+		if ((short_message_end = strchr(short_message, '\n'))) {
+			*short_message_end = '\0';
+		}
+		switch_json_writer_add_string(w, json_format->short_message.name, short_message);
+	}
+
+	switch_safe_free(parsed_full_message);
+}
+
+SWITCH_DECLARE(char *) switch_log_node_to_json_string(const switch_log_node_t *node, int log_level, switch_log_json_format_t *json_format, switch_event_t *chan_vars)
+{
+	switch_json_writer_t w;
+	char buf[2048];
+	char *text;
+
+	switch_json_writer_init(&w, buf, sizeof(buf));
+	switch_json_writer_object_start(&w);
+	switch_log_node_json_write(&w, node, log_level, json_format, chan_vars);
+	switch_json_writer_object_end(&w);
+
+	text = switch_json_writer_dup(&w);
+	switch_json_writer_destroy(&w);
+
+	return text;
+}
+
 SWITCH_DECLARE(cJSON *) switch_log_node_to_json(const switch_log_node_t *node, int log_level, switch_log_json_format_t *json_format, switch_event_t *chan_vars)
 {
 	cJSON *json = NULL;
 	char *hostname;
-	char *full_message = node->content;
+	char *full_message = NULL;
 	char *parsed_full_message = NULL;
 	char *field_name = NULL;
 	switch_event_t *log_fields = NULL;
-	switch_core_session_t *session = NULL;
 
 	if (node->meta && cJSON_IsObject(node->meta)) {
 		if (json_format->custom_field_prefix) {
@@ -168,43 +391,7 @@ SWITCH_DECLARE(cJSON *) switch_log_node_to_json(const switch_log_node_t *node, i
 		cJSON_AddItemToObject(json, json_format->sequence.name, cJSON_CreateNumber(node->sequence));
 	}
 
-	/* skip initial space and new line */
-	if (*full_message == ' ') {
-		full_message++;
-	}
-	if (*full_message == '\n') {
-		full_message++;
-	}
-
-	/* get fields from log tags */
-	if (node->tags) {
-		switch_event_dup(&log_fields, node->tags);
-	}
-
-	/* get fields from channel data, if configured */
-	if (!zstr(node->userdata) && chan_vars && chan_vars->headers && (session = switch_core_session_locate(node->userdata))) {
-		switch_channel_t *channel = switch_core_session_get_channel(session);
-		switch_event_header_t *hp;
-		/* session_fields name mapped to variable name */
-		for (hp = chan_vars->headers; hp; hp = hp->next) {
-			if (!zstr(hp->name) && !zstr(hp->value)) {
-				const char *val = switch_channel_get_variable(channel, hp->value);
-				if (!zstr(val)) {
-					if (!log_fields) {
-						switch_event_create_plain(&log_fields, SWITCH_EVENT_CHANNEL_DATA);
-					}
-					switch_event_add_header_string(log_fields, SWITCH_STACK_BOTTOM, hp->name, val);
-				}
-			}
-		}
-		switch_core_session_rwunlock(session);
-	}
-
-	/* parse list of fields from message text, if any */
-	if (strncmp(full_message, "LOG_FIELDS", 10) == 0) {
-		switch_event_create_brackets(full_message+10, '[', ']', ',', &log_fields, &parsed_full_message, SWITCH_TRUE);
-		full_message = parsed_full_message;
-	}
+	log_fields = log_node_fields(node, chan_vars, &full_message, &parsed_full_message);
 
 	/* add additional fields */
 	if (log_fields) {
@@ -230,8 +230,7 @@ SWITCH_DECLARE(void) switch_generate_sln_silence(int16_t *data, uint32_t samples
 
 SWITCH_DECLARE(uint32_t) switch_merge_sln(int16_t *data, uint32_t samples, int16_t *other_data, uint32_t other_samples, int channels)
 {
-	int i;
-	int32_t x, z;
+	int32_t x;
 
 	if (channels == 0) channels = 1;
 
@@ -241,11 +240,7 @@ SWITCH_DECLARE(uint32_t) switch_merge_sln(int16_t *data, uint32_t samples, int16
 		x = samples;
 	}
 
-	for (i = 0; i < x * channels; i++) {
-		z = data[i] + other_data[i];
-		switch_normalize_to_16bit(z);
-		data[i] = (int16_t) z;
-	}
+	switch_dsp_mix(data, other_data, x * channels);
 
 	return x;
 }
@@ -381,15 +376,7 @@ SWITCH_DECLARE(void) switch_change_sln_volume_granular(int16_t *data, uint32_t s
 	newrate = chart[i];
 
 	if (newrate) {
-		int32_t tmp;
-		uint32_t x;
-		int16_t *fp = data;
-
-		for (x = 0; x < samples; x++) {
-			tmp = (int32_t) (fp[x] * newrate);
-			switch_normalize_to_16bit(tmp);
-			fp[x] = (int16_t) tmp;
-		}
+		switch_dsp_gain(data, samples, newrate);
 	} else {
 		memset(data, 0, samples * 2);
 	}
@@ -420,15 +407,7 @@ SWITCH_DECLARE(void) switch_change_sln_volume(int16_t *data, uint32_t samples, i
 	newrate = chart[i];
 
 	if (newrate) {
-		int32_t tmp;
-		uint32_t x;
-		int16_t *fp = data;
-
-		for (x = 0; x < samples; x++) {
-			tmp = (int32_t) (fp[x] * newrate);
-			switch_normalize_to_16bit(tmp);
-			fp[x] = (int16_t) tmp;
-		}
+		switch_dsp_gain(data, samples, newrate);
 	}
 }
 
@@ -536,12 +515,7 @@ SWITCH_DECLARE(switch_status_t) switch_agc_feed(switch_agc_t *agc, int16_t *data
 	}
 							
 	if (agc->energy_avg) {
-		uint32_t energy = 0;
-		int i;
-
-		for (i = 0; i < samples * channels; i++) {
-			energy += abs(data[i]);
-		}
+		uint32_t energy = (uint32_t) switch_dsp_energy(data, samples * channels, 1);
 
 		if (samples) { 
 			agc->score = energy / samples * channels;
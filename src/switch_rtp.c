@@ -120,6 +120,56 @@ static int zrtp_on = 0;
 
 static switch_hash_t *alloc_hash = NULL;
 
+/* Pre-bound RTP/RTCP socket pairs, kept per media ip and refilled in the background so the
+   SDP/answer path doesn't pay for socket() and bind() during call bursts */
+typedef struct rtp_prebound_s {
+	switch_memory_pool_t *pool;
+	/* claimed pairs are hashed by port, pairs of other ips on the same port hang off port_next */
+	char *key;
+	char *ip;
+	switch_sockaddr_t *addr;
+	switch_port_t port;
+	switch_socket_t *rtp_sock;
+	switch_socket_t *rtcp_sock;
+	struct rtp_prebound_s *next;
+	struct rtp_prebound_s *port_next;
+} rtp_prebound_t;
+
+typedef struct rtp_socket_pool_s {
+	char *ip;
+	rtp_prebound_t *head;
+	rtp_prebound_t *tail;
+	uint32_t ready;
+	uint64_t taken;
+	uint64_t bind_failures;
+	struct rtp_socket_pool_s *next;
+} rtp_socket_pool_t;
+
+static struct {
+	switch_memory_pool_t *pool;
+	switch_mutex_t *mutex;
+	switch_thread_cond_t *cond;
+	switch_hash_t *pools;
+	switch_hash_t *claimed;
+	uint32_t claimed_count;
+	rtp_socket_pool_t *pool_list;
+	uint32_t size;
+	int running;
+	switch_thread_t *thread;
+
+	uint64_t requests;
+	uint64_t pooled;
+	uint64_t failures;
+	switch_time_t wait_total;
+	switch_time_t wait_max;
+	uint64_t setups;
+	uint64_t setups_pooled;
+	switch_time_t setup_total;
+	switch_time_t setup_max;
+} sock_pool;
+
+static void rtp_socket_pool_shutdown(void);
+
 typedef struct {
 	srtp_hdr_t header;
 	char body[SWITCH_RTP_MAX_BUF_LEN+4+sizeof(char *)];
@@ -1588,6 +1638,11 @@ SWITCH_DECLARE(void) switch_rtp_init(switch_memory_pool_t *pool)
 	}
 #endif
 	switch_mutex_init(&port_lock, SWITCH_MUTEX_NESTED, pool);
+	sock_pool.pool = pool;
+	switch_mutex_init(&sock_pool.mutex, SWITCH_MUTEX_NESTED, pool);
+	switch_thread_cond_create(&sock_pool.cond, pool);
+	switch_core_hash_init(&sock_pool.pools);
+	switch_core_hash_init(&sock_pool.claimed);
 	switch_rtp_dtls_init();
 	global_init = 1;
 }
@@ -2638,6 +2693,8 @@ SWITCH_DECLARE(void) switch_rtp_shutdown(void)
 		return;
 	}
 
+	rtp_socket_pool_shutdown();
+
 	switch_mutex_lock(port_lock);
 
 	for (hi = switch_core_hash_first(alloc_hash); hi; hi = switch_core_hash_next(&hi)) {
@@ -2651,6 +2708,9 @@ SWITCH_DECLARE(void) switch_rtp_shutdown(void)
 	switch_core_hash_destroy(&alloc_hash);
 	switch_mutex_unlock(port_lock);
 
+	switch_core_hash_destroy(&sock_pool.pools);
+	switch_core_hash_destroy(&sock_pool.claimed);
+
 #ifdef ENABLE_ZRTP
 	if (zrtp_on) {
 		zrtp_status_t status = zrtp_status_ok;
@@ -2694,42 +2754,431 @@ SWITCH_DECLARE(switch_port_t) switch_rtp_set_end_port(switch_port_t port)
 	return END_PORT;
 }
 
-SWITCH_DECLARE(void) switch_rtp_release_port(const char *ip, switch_port_t port)
+static switch_port_t rtp_allocator_request_port(const char *ip)
 {
+	switch_port_t port = 0;
 	switch_core_port_allocator_t *alloc = NULL;
 
-	if (!ip || !port) {
-		return;
+	switch_mutex_lock(port_lock);
+	alloc = switch_core_hash_find(alloc_hash, ip);
+	if (!alloc) {
+		if (switch_core_port_allocator_new(ip, START_PORT, END_PORT, SPF_EVEN, &alloc) != SWITCH_STATUS_SUCCESS) {
+			abort();
+		}
+
+		switch_core_hash_insert(alloc_hash, ip, alloc);
+	}
+
+	if (switch_core_port_allocator_request_port(alloc, &port) != SWITCH_STATUS_SUCCESS) {
+		port = 0;
 	}
 
+	switch_mutex_unlock(port_lock);
+	return port;
+}
+
+static void rtp_allocator_release_port(const char *ip, switch_port_t port)
+{
+	switch_core_port_allocator_t *alloc = NULL;
+
 	switch_mutex_lock(port_lock);
 	if ((alloc = switch_core_hash_find(alloc_hash, ip))) {
 		switch_core_port_allocator_free_port(alloc, port);
 	}
 	switch_mutex_unlock(port_lock);
+}
+
+static switch_socket_t *rtp_prebind_socket(const char *ip, switch_port_t port, switch_memory_pool_t *pool, switch_sockaddr_t **addrp)
+{
+	switch_sockaddr_t *addr = NULL;
+	switch_socket_t *sock = NULL;
+
+	if (switch_sockaddr_info_get(&addr, ip, SWITCH_UNSPEC, port, 0, pool) != SWITCH_STATUS_SUCCESS) {
+		return NULL;
+	}
+
+	if (switch_socket_create(&sock, switch_sockaddr_get_family(addr), SOCK_DGRAM, 0, pool) != SWITCH_STATUS_SUCCESS) {
+		return NULL;
+	}
+
+	if (switch_socket_opt_set(sock, SWITCH_SO_REUSEADDR, 1) != SWITCH_STATUS_SUCCESS || switch_socket_bind(sock, addr) != SWITCH_STATUS_SUCCESS) {
+		switch_socket_close(sock);
+		return NULL;
+	}
+
+	if (addrp) {
+		*addrp = addr;
+	}
 
+	return sock;
 }
 
-SWITCH_DECLARE(switch_port_t) switch_rtp_request_port(const char *ip)
+static rtp_prebound_t *rtp_prebound_create(const char *ip, switch_port_t port)
 {
-	switch_port_t port = 0;
-	switch_core_port_allocator_t *alloc = NULL;
+	switch_memory_pool_t *pool = NULL;
+	rtp_prebound_t *pb;
 
-	switch_mutex_lock(port_lock);
-	alloc = switch_core_hash_find(alloc_hash, ip);
-	if (!alloc) {
-		if (switch_core_port_allocator_new(ip, START_PORT, END_PORT, SPF_EVEN, &alloc) != SWITCH_STATUS_SUCCESS) {
-			abort();
+	if (switch_core_new_memory_pool(&pool) != SWITCH_STATUS_SUCCESS) {
+		return NULL;
+	}
+
+	pb = switch_core_alloc(pool, sizeof(*pb));
+	pb->pool = pool;
+	pb->port = port;
+	pb->key = switch_core_sprintf(pool, "%u", port);
+	pb->ip = switch_core_strdup(pool, ip);
+
+	if (!(pb->rtp_sock = rtp_prebind_socket(ip, port, pool, &pb->addr))) {
+		switch_core_destroy_memory_pool(&pool);
+		return NULL;
+	}
+
+	/* RTCP is optional, set_local_address binds it itself if this one didn't work out */
+	pb->rtcp_sock = rtp_prebind_socket(ip, port + 1, pool, NULL);
+
+	return pb;
+}
+
+static void rtp_prebound_destroy(rtp_prebound_t **pb)
+{
+	switch_memory_pool_t *pool = (*pb)->pool;
+
+	/* the sockets are in the same pool, destroying it closes whatever nobody claimed */
+	*pb = NULL;
+	switch_core_destroy_memory_pool(&pool);
+}
+
+static void *SWITCH_THREAD_FUNC rtp_socket_pool_thread(switch_thread_t *thread, void *obj)
+{
+	switch_mutex_lock(sock_pool.mutex);
+
+	while (sock_pool.running) {
+		rtp_socket_pool_t *sp;
+		int filled = 0;
+
+		for (sp = sock_pool.pool_list; sp && sock_pool.running; sp = sp->next) {
+			while (sock_pool.running && sp->ready < sock_pool.size) {
+				rtp_prebound_t *pb = NULL;
+				switch_port_t port;
+
+				/* pools are never removed while we run, sp stays valid without the lock */
+				switch_mutex_unlock(sock_pool.mutex);
+
+				if ((port = rtp_allocator_request_port(sp->ip))) {
+					if (!(pb = rtp_prebound_create(sp->ip, port))) {
+						rtp_allocator_release_port(sp->ip, port);
+					}
+				}
+
+				switch_mutex_lock(sock_pool.mutex);
+
+				if (!pb) {
+					sp->bind_failures++;
+					break;
+				}
+
+				if (sp->tail) {
+					sp->tail->next = pb;
+				} else {
+					sp->head = pb;
+				}
+				sp->tail = pb;
+				sp->ready++;
+				filled++;
+			}
 		}
 
-		switch_core_hash_insert(alloc_hash, ip, alloc);
+		if (sock_pool.running && !filled) {
+			/* woken up as soon as a socket is taken, the timeout retries after bind failures */
+			switch_thread_cond_timedwait(sock_pool.cond, sock_pool.mutex, 1000000);
+		}
 	}
 
-	if (switch_core_port_allocator_request_port(alloc, &port) != SWITCH_STATUS_SUCCESS) {
-		port = 0;
+	switch_mutex_unlock(sock_pool.mutex);
+
+	return NULL;
+}
+
+/* Take a pre-bound pair for ip, the socket pool for that ip is created on first use */
+static switch_port_t rtp_socket_pool_take(const char *ip)
+{
+	rtp_socket_pool_t *sp;
+	rtp_prebound_t *pb = NULL;
+
+	switch_mutex_lock(sock_pool.mutex);
+
+	if (!(sp = switch_core_hash_find(sock_pool.pools, ip))) {
+		sp = switch_core_alloc(sock_pool.pool, sizeof(*sp));
+		sp->ip = switch_core_strdup(sock_pool.pool, ip);
+		sp->next = sock_pool.pool_list;
+		sock_pool.pool_list = sp;
+		switch_core_hash_insert(sock_pool.pools, sp->ip, sp);
+	}
+
+	if (!sock_pool.thread) {
+		switch_threadattr_t *thd_attr = NULL;
+
+		sock_pool.running = 1;
+		switch_threadattr_create(&thd_attr, sock_pool.pool);
+		switch_threadattr_stacksize_set(thd_attr, SWITCH_THREAD_STACKSIZE);
+		switch_thread_create(&sock_pool.thread, thd_attr, rtp_socket_pool_thread, NULL, sock_pool.pool);
+	}
+
+	if ((pb = sp->head)) {
+		if (!(sp->head = pb->next)) {
+			sp->tail = NULL;
+		}
+		pb->next = NULL;
+		sp->ready--;
+		sp->taken++;
+
+		pb->port_next = switch_core_hash_find(sock_pool.claimed, pb->key);
+		switch_core_hash_insert(sock_pool.claimed, pb->key, pb);
+		sock_pool.claimed_count++;
+	}
+
+	switch_thread_cond_signal(sock_pool.cond);
+	switch_mutex_unlock(sock_pool.mutex);
+
+	return pb ? pb->port : 0;
+}
+
+/*
+ * Hand the pre-bound rtp or rtcp socket for a port taken from the pool over to a session.  The session's
+ * host may be written differently from the ip the port was requested for, so claims match the bound address.
+ */
+static switch_socket_t *rtp_socket_pool_claim(switch_sockaddr_t *addr, switch_port_t port, switch_bool_t rtcp)
+{
+	switch_socket_t *sock = NULL;
+	rtp_prebound_t *pb, *head;
+	char key[16];
+
+	if (!sock_pool.claimed_count) {
+		return NULL;
 	}
 
+	switch_snprintf(key, sizeof(key), "%u", port);
+
+	switch_mutex_lock(sock_pool.mutex);
+	head = switch_core_hash_find(sock_pool.claimed, key);
+
+	for (pb = head; pb; pb = pb->port_next) {
+		if (switch_cmp_addr(pb->addr, addr, SWITCH_TRUE)) {
+			if (rtcp) {
+				sock = pb->rtcp_sock;
+				pb->rtcp_sock = NULL;
+			} else {
+				sock = pb->rtp_sock;
+				pb->rtp_sock = NULL;
+			}
+			break;
+		}
+	}
+
+	if (!sock) {
+		/* the session binds the port itself, a pooled socket left on it would get part of its packets */
+		for (pb = head; pb; pb = pb->port_next) {
+			switch_socket_t **psock = rtcp ? &pb->rtcp_sock : &pb->rtp_sock;
+
+			if (*psock) {
+				switch_socket_close(*psock);
+				*psock = NULL;
+			}
+		}
+	}
+	switch_mutex_unlock(sock_pool.mutex);
+
+	return sock;
+}
+
+/* The session is done with a pooled port, its sockets are already closed */
+static void rtp_socket_pool_forget(const char *ip, switch_port_t port)
+{
+	rtp_prebound_t *pb, *head, *prev = NULL;
+	char key[16];
+
+	if (!sock_pool.claimed_count) {
+		return;
+	}
+
+	switch_snprintf(key, sizeof(key), "%u", port);
+
+	switch_mutex_lock(sock_pool.mutex);
+	head = switch_core_hash_find(sock_pool.claimed, key);
+
+	/* release gets the ip the port was requested for */
+	for (pb = head; pb && strcmp(pb->ip, ip); pb = pb->port_next) {
+		prev = pb;
+	}
+
+	if (pb) {
+		if (prev) {
+			prev->port_next = pb->port_next;
+		} else if (pb->port_next) {
+			switch_core_hash_insert(sock_pool.claimed, key, pb->port_next);
+		} else {
+			switch_core_hash_delete(sock_pool.claimed, key);
+		}
+		sock_pool.claimed_count--;
+	}
+	switch_mutex_unlock(sock_pool.mutex);
+
+	if (pb) {
+		rtp_prebound_destroy(&pb);
+	}
+}
+
+static void rtp_socket_pool_shutdown(void)
+{
+	switch_hash_index_t *hi;
+	rtp_socket_pool_t *sp;
+	void *val;
+
+	switch_mutex_lock(sock_pool.mutex);
+	sock_pool.running = 0;
+	switch_thread_cond_broadcast(sock_pool.cond);
+	switch_mutex_unlock(sock_pool.mutex);
+
+	if (sock_pool.thread) {
+		switch_status_t st;
+		switch_thread_join(&st, sock_pool.thread);
+		sock_pool.thread = NULL;
+	}
+
+	switch_mutex_lock(sock_pool.mutex);
+
+	for (sp = sock_pool.pool_list; sp; sp = sp->next) {
+		while (sp->head) {
+			rtp_prebound_t *pb = sp->head;
+			sp->head = pb->next;
+			rtp_allocator_release_port(sp->ip, pb->port);
+			rtp_prebound_destroy(&pb);
+		}
+		sp->tail = NULL;
+		sp->ready = 0;
+	}
+
+	while ((hi = switch_core_hash_first(sock_pool.claimed))) {
+		rtp_prebound_t *pb, *next;
+		switch_core_hash_this(hi, NULL, NULL, &val);
+		pb = (rtp_prebound_t *) val;
+		switch_safe_free(hi);
+		switch_core_hash_delete(sock_pool.claimed, pb->key);
+		for (; pb; pb = next) {
+			next = pb->port_next;
+			rtp_prebound_destroy(&pb);
+		}
+	}
+	sock_pool.claimed_count = 0;
+
+	switch_mutex_unlock(sock_pool.mutex);
+}
+
+SWITCH_DECLARE(uint32_t) switch_rtp_set_socket_pool_size(uint32_t size)
+{
+	if (sock_pool.mutex) {
+		switch_mutex_lock(sock_pool.mutex);
+	}
+	sock_pool.size = size;
+	if (sock_pool.mutex) {
+		switch_thread_cond_signal(sock_pool.cond);
+		switch_mutex_unlock(sock_pool.mutex);
+	}
+	return sock_pool.size;
+}
+
+SWITCH_DECLARE(void) switch_rtp_port_status(switch_stream_handle_t *stream)
+{
+	switch_hash_index_t *hi;
+	rtp_socket_pool_t *sp;
+	const void *var;
+	void *val;
+
+	switch_mutex_lock(sock_pool.mutex);
+	stream->write_function(stream, "socket_pool_size: %u\n", sock_pool.size);
+	stream->write_function(stream, "requests: %" SWITCH_UINT64_T_FMT "\n", sock_pool.requests);
+	stream->write_function(stream, "from_pool: %" SWITCH_UINT64_T_FMT "\n", sock_pool.pooled);
+	stream->write_function(stream, "from_allocator: %" SWITCH_UINT64_T_FMT "\n", sock_pool.requests - sock_pool.pooled - sock_pool.failures);
+	stream->write_function(stream, "failures: %" SWITCH_UINT64_T_FMT "\n", sock_pool.failures);
+	stream->write_function(stream, "request_wait_avg_us: %" SWITCH_TIME_T_FMT "\n",
+						   sock_pool.requests ? sock_pool.wait_total / (switch_time_t) sock_pool.requests : 0);
+	stream->write_function(stream, "request_wait_max_us: %" SWITCH_TIME_T_FMT "\n", sock_pool.wait_max);
+	stream->write_function(stream, "socket_setups: %" SWITCH_UINT64_T_FMT " (%" SWITCH_UINT64_T_FMT " pre-bound)\n", sock_pool.setups, sock_pool.setups_pooled);
+	stream->write_function(stream, "socket_setup_avg_us: %" SWITCH_TIME_T_FMT "\n",
+						   sock_pool.setups ? sock_pool.setup_total / (switch_time_t) sock_pool.setups : 0);
+	stream->write_function(stream, "socket_setup_max_us: %" SWITCH_TIME_T_FMT "\n", sock_pool.setup_max);
+	stream->write_function(stream, "claimed: %u\n", sock_pool.claimed_count);
+
+	for (sp = sock_pool.pool_list; sp; sp = sp->next) {
+		stream->write_function(stream, "pool %s: ready %u taken %" SWITCH_UINT64_T_FMT " bind_failures %" SWITCH_UINT64_T_FMT "\n",
+							   sp->ip, sp->ready, sp->taken, sp->bind_failures);
+	}
+	switch_mutex_unlock(sock_pool.mutex);
+
+	switch_mutex_lock(port_lock);
+	for (hi = switch_core_hash_first(alloc_hash); hi; hi = switch_core_hash_next(&hi)) {
+		uint32_t used = 0, total = 0;
+
+		switch_core_hash_this(hi, &var, NULL, &val);
+		switch_core_port_allocator_usage((switch_core_port_allocator_t *) val, &used, &total);
+		stream->write_function(stream, "ports %s: %u/%u in use\n", (char *) var, used, total);
+	}
 	switch_mutex_unlock(port_lock);
+}
+
+static void rtp_port_setup_time(switch_time_t started, switch_bool_t pooled)
+{
+	switch_time_t took = switch_time_now() - started;
+
+	switch_mutex_lock(sock_pool.mutex);
+	sock_pool.setups++;
+	if (pooled) {
+		sock_pool.setups_pooled++;
+	}
+	sock_pool.setup_total += took;
+	if (took > sock_pool.setup_max) {
+		sock_pool.setup_max = took;
+	}
+	switch_mutex_unlock(sock_pool.mutex);
+}
+
+SWITCH_DECLARE(void) switch_rtp_release_port(const char *ip, switch_port_t port)
+{
+	if (!ip || !port) {
+		return;
+	}
+
+	rtp_socket_pool_forget(ip, port);
+	rtp_allocator_release_port(ip, port);
+}
+
+SWITCH_DECLARE(switch_port_t) switch_rtp_request_port(const char *ip)
+{
+	switch_time_t started = switch_time_now(), took;
+	switch_port_t port = 0;
+	switch_bool_t pooled = SWITCH_FALSE;
+
+	if (sock_pool.size && (port = rtp_socket_pool_take(ip))) {
+		pooled = SWITCH_TRUE;
+	} else {
+		port = rtp_allocator_request_port(ip);
+	}
+
+	took = switch_time_now() - started;
+
+	switch_mutex_lock(sock_pool.mutex);
+	sock_pool.requests++;
+	if (pooled) {
+		sock_pool.pooled++;
+	} else if (!port) {
+		sock_pool.failures++;
+	}
+	sock_pool.wait_total += took;
+	if (took > sock_pool.wait_max) {
+		sock_pool.wait_max = took;
+	}
+	switch_mutex_unlock(sock_pool.mutex);
+
 	return port;
 }
 
@@ -2815,19 +3264,21 @@ static switch_status_t enable_local_rtcp_socket(switch_rtp_t *rtp_session, const
 			goto done;
 		}
 
-		if (switch_socket_create(&rtcp_new_sock, switch_sockaddr_get_family(rtp_session->rtcp_local_addr), SOCK_DGRAM, 0, rtp_session->pool) != SWITCH_STATUS_SUCCESS) {
-			*err = "RTCP Socket Error!";
-			goto done;
-		}
+		if (!(rtcp_new_sock = rtp_socket_pool_claim(rtp_session->rtcp_local_addr, port, SWITCH_TRUE))) {
+			if (switch_socket_create(&rtcp_new_sock, switch_sockaddr_get_family(rtp_session->rtcp_local_addr), SOCK_DGRAM, 0, rtp_session->pool) != SWITCH_STATUS_SUCCESS) {
+				*err = "RTCP Socket Error!";
+				goto done;
+			}
 
-		if (switch_socket_opt_set(rtcp_new_sock, SWITCH_SO_REUSEADDR, 1) != SWITCH_STATUS_SUCCESS) {
-			*err = "RTCP Socket Error!";
-			goto done;
-		}
+			if (switch_socket_opt_set(rtcp_new_sock, SWITCH_SO_REUSEADDR, 1) != SWITCH_STATUS_SUCCESS) {
+				*err = "RTCP Socket Error!";
+				goto done;
+			}
 
-		if (switch_socket_bind(rtcp_new_sock, rtp_session->rtcp_local_addr) != SWITCH_STATUS_SUCCESS) {
-			*err = "RTCP Bind Error!";
-			goto done;
+			if (switch_socket_bind(rtcp_new_sock, rtp_session->rtcp_local_addr) != SWITCH_STATUS_SUCCESS) {
+				*err = "RTCP Bind Error!";
+				goto done;
+			}
 		}
 
 		if (switch_sockaddr_info_get(&rtp_session->rtcp_from_addr, switch_get_addr(bufa, sizeof(bufa), rtp_session->from_addr),
@@ -2868,6 +3319,8 @@ SWITCH_DECLARE(switch_status_t) switch_rtp_set_local_address(switch_rtp_t *rtp_s
 {
 	switch_socket_t *new_sock = NULL, *old_sock = NULL;
 	switch_status_t status = SWITCH_STATUS_FALSE;
+	switch_bool_t prebound = SWITCH_FALSE;
+	switch_time_t setup_started;
 	int j = 0;
 #ifndef WIN32
 	char o[5] = "TEST", i[5] = "";
@@ -2911,14 +3364,21 @@ SWITCH_DECLARE(switch_status_t) switch_rtp_set_local_address(switch_rtp_t *rtp_s
 		switch_rtp_kill_socket(rtp_session);
 	}
 
-	if (switch_socket_create(&new_sock, switch_sockaddr_get_family(rtp_session->local_addr), SOCK_DGRAM, 0, rtp_session->pool) != SWITCH_STATUS_SUCCESS) {
-		*err = "Socket Error!";
-		goto done;
-	}
+	setup_started = switch_time_now();
 
-	if (switch_socket_opt_set(new_sock, SWITCH_SO_REUSEADDR, 1) != SWITCH_STATUS_SUCCESS) {
-		*err = "Socket Error!";
-		goto done;
+	/* a port from the socket pool comes with its socket already bound */
+	if ((new_sock = rtp_socket_pool_claim(rtp_session->local_addr, port, SWITCH_FALSE))) {
+		prebound = SWITCH_TRUE;
+	} else {
+		if (switch_socket_create(&new_sock, switch_sockaddr_get_family(rtp_session->local_addr), SOCK_DGRAM, 0, rtp_session->pool) != SWITCH_STATUS_SUCCESS) {
+			*err = "Socket Error!";
+			goto done;
+		}
+
+		if (switch_socket_opt_set(new_sock, SWITCH_SO_REUSEADDR, 1) != SWITCH_STATUS_SUCCESS) {
+			*err = "Socket Error!";
+			goto done;
+		}
 	}
 
 	if (rtp_session->flags[SWITCH_RTP_FLAG_VIDEO]) {
@@ -2929,12 +3389,14 @@ SWITCH_DECLARE(switch_status_t) switch_rtp_set_local_address(switch_rtp_t *rtp_s
 		switch_socket_opt_set(new_sock, SWITCH_SO_SNDBUF, 851968);
 	}
 
-	if (switch_socket_bind(new_sock, rtp_session->local_addr) != SWITCH_STATUS_SUCCESS) {
+	if (!prebound && switch_socket_bind(new_sock, rtp_session->local_addr) != SWITCH_STATUS_SUCCESS) {
 		char *em = switch_core_sprintf(rtp_session->pool, "Bind Error! %s:%d", host, port);
 		*err = em;
 		goto done;
 	}
 
+	rtp_port_setup_time(setup_started, prebound);
+
 
 	if ((j = atoi(host)) && j > 223 && j < 240) { /* mcast */
 		if (switch_mcast_interface(new_sock, rtp_session->local_addr) != SWITCH_STATUS_SUCCESS) {
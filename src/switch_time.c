@@ -88,6 +88,8 @@ static int COND = 1;
 
 static int MATRIX = 1;
 
+static uint32_t WHEELS = 0;
+
 #ifdef WIN32
 static CRITICAL_SECTION timer_section;
 static switch_time_t win32_tick_time_since_start = -1;
@@ -117,11 +119,40 @@ SWITCH_MODULE_SHUTDOWN_FUNCTION(softtimer_shutdown);
 SWITCH_MODULE_RUNTIME_FUNCTION(softtimer_runtime);
 SWITCH_MODULE_DEFINITION(CORE_SOFTTIMER_MODULE, softtimer_load, softtimer_shutdown, softtimer_runtime);
 
+#define TIMER_WHEEL_MAX_SHARDS 64
+#define TIMER_WHEEL_BUCKETS 10
+
+/* upper bounds in microseconds of the wake latency and jitter histogram buckets, the last one is open */
+static const switch_time_t timer_wheel_bounds[TIMER_WHEEL_BUCKETS - 1] = { 50, 100, 250, 500, 1000, 2000, 5000, 10000, 20000 };
+
+/* one group of timers of an interval sharing a condition, so a tick wakes each group under its own lock */
+struct timer_wheel_shard {
+	switch_mutex_t *mutex;
+	switch_thread_cond_t *cond;
+	uint32_t timers;
+	uint32_t waiters;
+	/* when the runtime thread last woke this group */
+	switch_time_t fired;
+	uint64_t wakes;
+	uint64_t latency[TIMER_WHEEL_BUCKETS];
+	uint64_t jitter[TIMER_WHEEL_BUCKETS];
+};
+typedef struct timer_wheel_shard timer_wheel_shard_t;
+
+struct timer_wheel {
+	uint32_t shards;
+	uint32_t next;
+	timer_wheel_shard_t shard[TIMER_WHEEL_MAX_SHARDS];
+};
+typedef struct timer_wheel timer_wheel_t;
+
 struct timer_private {
 	switch_size_t reference;
 	switch_size_t start;
 	uint32_t roll;
 	uint32_t ready;
+	timer_wheel_shard_t *shard;
+	switch_time_t last_wake;
 };
 typedef struct timer_private timer_private_t;
 
@@ -132,6 +163,7 @@ struct timer_matrix {
 	switch_mutex_t *mutex;
 	switch_thread_cond_t *cond;
 	switch_thread_rwlock_t *rwlock;
+	timer_wheel_t *wheel;
 };
 typedef struct timer_matrix timer_matrix_t;
 
@@ -363,6 +395,37 @@ SWITCH_DECLARE(void) switch_time_set_matrix(switch_bool_t enable)
 	switch_time_sync();
 }
 
+SWITCH_DECLARE(void) switch_time_set_timer_wheels(uint32_t shards)
+{
+	if (shards > TIMER_WHEEL_MAX_SHARDS) {
+		shards = TIMER_WHEEL_MAX_SHARDS;
+	}
+
+	WHEELS = shards;
+
+	if (WHEELS) {
+		/* the wheels hang off the timer matrix, which fd-per-timer and the timerfd runtime bypass */
+		TFD = 0;
+		MATRIX = 1;
+	}
+	switch_time_sync();
+}
+
+SWITCH_DECLARE(uint32_t) switch_time_get_timer_wheels(void)
+{
+	return WHEELS;
+}
+
+SWITCH_DECLARE(int) switch_time_get_timerfd(void)
+{
+	return TFD;
+}
+
+SWITCH_DECLARE(switch_bool_t) switch_time_get_matrix(void)
+{
+	return MATRIX ? SWITCH_TRUE : SWITCH_FALSE;
+}
+
 SWITCH_DECLARE(void) switch_time_set_nanosleep(switch_bool_t enable)
 {
 #if defined(HAVE_CLOCK_NANOSLEEP)
@@ -696,6 +759,164 @@ SWITCH_DECLARE(void) switch_cond_yield(switch_interval_time_t t)
 
 }
 
+#define check_roll() if (private_info->roll < TIMER_MATRIX[timer->interval].roll) {	\
+		private_info->roll++;											\
+		private_info->reference = private_info->start = (switch_size_t)TIMER_MATRIX[timer->interval].tick;	\
+		private_info->start--; /* Must have a diff */					\
+	}																	\
+
+
+static int timer_wheel_bucket(switch_time_t usec)
+{
+	int i;
+
+	for (i = 0; i < TIMER_WHEEL_BUCKETS - 1; i++) {
+		if (usec < timer_wheel_bounds[i]) {
+			break;
+		}
+	}
+
+	return i;
+}
+
+/* called with globals.mutex held */
+static timer_wheel_shard_t *timer_wheel_join(timer_matrix_t *matrix)
+{
+	timer_wheel_t *wheel = matrix->wheel;
+	timer_wheel_shard_t *shard;
+	uint32_t i;
+
+	if (!wheel) {
+		wheel = switch_core_alloc(module_pool, sizeof(*wheel));
+		wheel->shards = WHEELS;
+		for (i = 0; i < wheel->shards; i++) {
+			switch_mutex_init(&wheel->shard[i].mutex, SWITCH_MUTEX_NESTED, module_pool);
+			switch_thread_cond_create(&wheel->shard[i].cond, module_pool);
+		}
+		matrix->wheel = wheel;
+	}
+
+	/* the least loaded group keeps them even as calls come and go */
+	shard = &wheel->shard[wheel->next++ % wheel->shards];
+	for (i = 0; i < wheel->shards; i++) {
+		if (wheel->shard[i].timers < shard->timers) {
+			shard = &wheel->shard[i];
+		}
+	}
+	shard->timers++;
+
+	return shard;
+}
+
+static void timer_wheel_wait(switch_timer_t *timer, timer_private_t *private_info)
+{
+	timer_matrix_t *matrix = &TIMER_MATRIX[timer->interval];
+	timer_wheel_shard_t *shard = private_info->shard;
+	switch_interval_time_t timeout = (switch_interval_time_t) timer->interval * 2000;
+	switch_time_t now;
+	int waited = 0;
+
+	switch_mutex_lock(shard->mutex);
+	while (globals.RUNNING == 1 && private_info->ready && matrix->tick < private_info->reference) {
+		check_roll();
+		shard->waiters++;
+		switch_thread_cond_timedwait(shard->cond, shard->mutex, timeout);
+		shard->waiters--;
+		waited = 1;
+	}
+
+	now = time_now(runtime.offset);
+
+	if (waited) {
+		shard->wakes++;
+		shard->latency[timer_wheel_bucket(now > shard->fired ? now - shard->fired : 0)]++;
+	}
+
+	if (private_info->last_wake) {
+		switch_time_t jitter = now - private_info->last_wake - (switch_time_t) timer->interval * 1000;
+		shard->jitter[timer_wheel_bucket(jitter < 0 ? -jitter : jitter)]++;
+	}
+	private_info->last_wake = now;
+	switch_mutex_unlock(shard->mutex);
+}
+
+/* wake the groups of an interval that just ticked, called from the runtime thread */
+static void timer_wheel_fire(timer_wheel_t *wheel, switch_time_t ts)
+{
+	uint32_t i;
+
+	/* waiters and fired belong to the group's lock, a group with nobody waiting costs one uncontended lock */
+	for (i = 0; i < wheel->shards; i++) {
+		timer_wheel_shard_t *shard = &wheel->shard[i];
+
+		switch_mutex_lock(shard->mutex);
+		shard->fired = ts;
+		if (shard->waiters) {
+			switch_thread_cond_broadcast(shard->cond);
+		}
+		switch_mutex_unlock(shard->mutex);
+	}
+}
+
+SWITCH_DECLARE(void) switch_time_timer_stats(switch_stream_handle_t *stream, switch_bool_t reset)
+{
+	uint32_t x, i;
+	int b, found = 0;
+
+	if (!globals.mutex) {
+		stream->write_function(stream, "-ERR soft timer not loaded\n");
+		return;
+	}
+
+	switch_mutex_lock(globals.mutex);
+	for (x = 1; x < MAX_ELEMENTS; x++) {
+		timer_wheel_t *wheel = TIMER_MATRIX[x].wheel;
+		uint64_t latency[TIMER_WHEEL_BUCKETS] = { 0 }, jitter[TIMER_WHEEL_BUCKETS] = { 0 }, wakes = 0;
+		uint32_t timers = 0;
+
+		if (!wheel) {
+			continue;
+		}
+
+		for (i = 0; i < wheel->shards; i++) {
+			timer_wheel_shard_t *shard = &wheel->shard[i];
+
+			switch_mutex_lock(shard->mutex);
+			timers += shard->timers;
+			wakes += shard->wakes;
+			for (b = 0; b < TIMER_WHEEL_BUCKETS; b++) {
+				latency[b] += shard->latency[b];
+				jitter[b] += shard->jitter[b];
+			}
+			if (reset) {
+				shard->wakes = 0;
+				memset(shard->latency, 0, sizeof(shard->latency));
+				memset(shard->jitter, 0, sizeof(shard->jitter));
+			}
+			switch_mutex_unlock(shard->mutex);
+		}
+
+		stream->write_function(stream, "Interval %ums: %u timers in %u groups, %" SWITCH_UINT64_T_FMT " wakes\n", x, timers, wheel->shards, wakes);
+		stream->write_function(stream, "%-10s %14s %14s\n", "usec", "wake latency", "jitter");
+		for (b = 0; b < TIMER_WHEEL_BUCKETS; b++) {
+			char label[16];
+
+			if (b < TIMER_WHEEL_BUCKETS - 1) {
+				switch_snprintf(label, sizeof(label), "<%" SWITCH_TIME_T_FMT, timer_wheel_bounds[b]);
+			} else {
+				switch_snprintf(label, sizeof(label), ">=%" SWITCH_TIME_T_FMT, timer_wheel_bounds[b - 1]);
+			}
+			stream->write_function(stream, "%-10s %14" SWITCH_UINT64_T_FMT " %14" SWITCH_UINT64_T_FMT "\n", label, latency[b], jitter[b]);
+		}
+		found++;
+	}
+	switch_mutex_unlock(globals.mutex);
+
+	if (!found) {
+		stream->write_function(stream, "No timer wheels in use%s\n", WHEELS ? "" : ", set timer-wheels in switch.conf to enable them");
+	}
+}
+
 static switch_status_t timer_init(switch_timer_t *timer)
 {
 	timer_private_t *private_info;
@@ -734,6 +955,9 @@ static switch_status_t timer_init(switch_timer_t *timer)
 			switch_thread_cond_create(&TIMER_MATRIX[timer->interval].cond, module_pool);
 		}
 		TIMER_MATRIX[timer->interval].count++;
+		if (WHEELS && timer->interval < MAX_ELEMENTS) {
+			private_info->shard = timer_wheel_join(&TIMER_MATRIX[timer->interval]);
+		}
 		switch_mutex_unlock(globals.mutex);
 		timer->private_info = private_info;
 		private_info->start = private_info->reference = (switch_size_t)TIMER_MATRIX[timer->interval].tick;
@@ -765,13 +989,6 @@ static switch_status_t timer_init(switch_timer_t *timer)
 	return SWITCH_STATUS_MEMERR;
 }
 
-#define check_roll() if (private_info->roll < TIMER_MATRIX[timer->interval].roll) {	\
-		private_info->roll++;											\
-		private_info->reference = private_info->start = (switch_size_t)TIMER_MATRIX[timer->interval].tick;	\
-		private_info->start--; /* Must have a diff */					\
-	}																	\
-
-
 static switch_status_t timer_step(switch_timer_t *timer)
 {
 	timer_private_t *private_info;
@@ -867,6 +1084,7 @@ static switch_status_t timer_next(switch_timer_t *timer)
 	/* sync up timer if it's not been called for a while otherwise it will return instantly several times until it catches up */
 	if (delta < -1) {
 		private_info->reference = (switch_size_t)(timer->tick = TIMER_MATRIX[timer->interval].tick);
+		private_info->last_wake = 0;
 	}
 	timer_step(timer);
 
@@ -875,6 +1093,11 @@ static switch_status_t timer_next(switch_timer_t *timer)
 		goto end;
 	}
 
+	if (private_info->shard) {
+		timer_wheel_wait(timer, private_info);
+		goto end;
+	}
+
 	while (globals.RUNNING == 1 && private_info->ready && TIMER_MATRIX[timer->interval].tick < private_info->reference) {
 		check_roll();
 
@@ -965,6 +1188,9 @@ static switch_status_t timer_destroy(switch_timer_t *timer)
 	if (timer->interval < MAX_ELEMENTS) {
 		switch_mutex_lock(globals.mutex);
 		TIMER_MATRIX[timer->interval].count--;
+		if (private_info && private_info->shard) {
+			private_info->shard->timers--;
+		}
 		if (TIMER_MATRIX[timer->interval].count == 0) {
 			TIMER_MATRIX[timer->interval].tick = 0;
 		}
@@ -1285,6 +1511,10 @@ SWITCH_MODULE_RUNTIME_FUNCTION(softtimer_runtime)
 				if ((current_ms % x) == 0) {
 					if (TIMER_MATRIX[x].count) {
 						TIMER_MATRIX[x].tick++;
+
+						if (TIMER_MATRIX[x].wheel) {
+							timer_wheel_fire(TIMER_MATRIX[x].wheel, ts);
+						}
 #ifdef DISABLE_1MS_COND
 
 						if (TIMER_MATRIX[x].mutex && switch_mutex_trylock(TIMER_MATRIX[x].mutex) == SWITCH_STATUS_SUCCESS) {
@@ -1313,6 +1543,9 @@ SWITCH_MODULE_RUNTIME_FUNCTION(softtimer_runtime)
 			switch_thread_cond_broadcast(TIMER_MATRIX[x].cond);
 			switch_mutex_unlock(TIMER_MATRIX[x].mutex);
 		}
+		if (TIMER_MATRIX[x].wheel) {
+			timer_wheel_fire(TIMER_MATRIX[x].wheel, ts);
+		}
 	}
 
 	if (tfd > -1) {
@@ -200,11 +200,7 @@ SWITCH_DECLARE(switch_vad_state_t) switch_vad_process(switch_vad_t *vad, int16_t
 		score = ret > 0 ? vad->thresh + 100 : 0;
 	} else {
 #endif
-		int energy = 0, j = 0, count = 0;
-		for (energy = 0, j = 0, count = 0; count < samples; count++) {
-			energy += abs(data[j]);
-			j += vad->channels;
-		}
+		int energy = (int) switch_dsp_energy(data, samples, vad->channels);
 
 		score = (uint32_t) (energy / (samples / vad->divisor));
 #ifdef SWITCH_HAVE_FVAD
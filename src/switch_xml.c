@@ -57,6 +57,7 @@
 
 #include <switch.h>
 #include <switch_stun.h>
+#include "private/switch_core_pvt.h"
 #ifndef WIN32
 #include <sys/wait.h>
 #include <switch_private.h>
@@ -103,6 +104,13 @@ void globfree(glob_t *);
 #define SWITCH_XML_WS   "\t\r\n "	/* whitespace */
 #define SWITCH_XML_ERRL 128		/* maximum error string length */
 
+static void preprocess_set_variable(const char *name, const char *value);
+static void xml_deps_note_file(const char *path);
+static void xml_deps_note_glob(const char *pattern, glob_t *gd);
+static void xml_deps_note_var(const char *name, const char *value);
+static void xml_deps_note_env(const char *name, const char *value);
+static void xml_deps_note_volatile(const char *directive);
+
 static void preprocess_exec_set(char *keyval)
 {
 	char *key = keyval;
@@ -130,7 +138,7 @@ static void preprocess_exec_set(char *keyval)
 					tmp[0] = '\0'; /* remove trailing spaces and newlines */
 					tmp--;
 				}
-				switch_core_set_variable(key, exec_result.data);
+				preprocess_set_variable(key, exec_result.data);
 			}
 		} else {
 			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Error while executing command: %s\n", val);
@@ -169,7 +177,7 @@ static void preprocess_stun_set(char *keyval)
 					tmp[0] = '\0'; /* remove trailing spaces and newlines */
 					tmp--;
 				}
-				switch_core_set_variable(key, external_ip);
+				preprocess_set_variable(key, external_ip);
 			}
 		} else {
 			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "stun-set failed.\n");
@@ -195,8 +203,10 @@ static void preprocess_env_set(char *keyval)
 			// val    "PATH"
 			char *data = getenv(val);
 
+			xml_deps_note_env(val, data);
+
 			if (data) {
-				switch_core_set_variable(key, data);
+				preprocess_set_variable(key, data);
 			}
 		}
 	}
@@ -204,6 +214,7 @@ static void preprocess_env_set(char *keyval)
 
 static int preprocess(const char *cwd, const char *file, FILE *write_fd, int rlevel);
 
+typedef struct switch_xml_dir_index switch_xml_dir_index_t;
 typedef struct switch_xml_root *switch_xml_root_t;
 struct switch_xml_root {		/* additional data for the root tag */
 	struct switch_xml xml;		/* is a super-struct built on top of switch_xml struct */
@@ -219,6 +230,7 @@ struct switch_xml_root {		/* additional data for the root tag */
 	char ***pi;					/* processing instructions */
 	short standalone;			/* non-zero if <?xml standalone="yes"?> */
 	char err[SWITCH_XML_ERRL];	/* error string */
+	switch_xml_dir_index_t *dir_index;	/* user lookup index of the directory section */
 };
 
 char *SWITCH_XML_NIL[] = { NULL };	/* empty, null terminated array of strings */
@@ -247,8 +259,359 @@ SWITCH_DECLARE_NONSTD(switch_xml_t) __switch_xml_open_root(uint8_t reload, const
 static void *XML_OPEN_ROOT_FUNCTION_USER_DATA = NULL;
 static switch_xml_open_root_function_t XML_OPEN_ROOT_FUNCTION = (switch_xml_open_root_function_t)__switch_xml_open_root;
 
+/* directory cache used by switch_xml_locate_user_merged(), user is NULL for a cached miss */
+typedef struct user_cache_entry_s {
+	switch_xml_t user;
+	switch_time_t expires;
+	uint8_t loading;
+	uint8_t refreshing;
+} user_cache_entry_t;
+
 static switch_hash_t *CACHE_HASH = NULL;
-static switch_hash_t *CACHE_EXPIRES_HASH = NULL;
+static switch_thread_cond_t *CACHE_COND = NULL;
+static switch_event_node_t *CACHE_FLUSH_NODE = NULL;
+
+static struct {
+	uint64_t hits;
+	uint64_t stale_hits;
+	uint64_t negative_hits;
+	uint64_t misses;
+	uint64_t coalesced;
+	uint64_t refreshes;
+} CACHE_STATS;
+
+#define USER_CACHE_WAIT_MS 5000
+
+/* inputs of a preprocess pass, so reloadxml can tell when running it again would give the same tree */
+typedef enum {
+	XML_DEP_FILE,				/* a file read by the preprocessor */
+	XML_DEP_GLOB,				/* an include pattern, hashed over the paths it matched */
+	XML_DEP_VAR,				/* a global variable expanded before the config set it */
+	XML_DEP_ENV,				/* an environment variable read by env-set */
+	XML_DEP_SET					/* a global variable the config set, with its final value */
+} xml_dep_type_t;
+
+typedef struct xml_dep_s {
+	xml_dep_type_t type;
+	char *name;
+	char *value;
+	int64_t mtime;
+	uint64_t size;
+	uint64_t hash;
+	struct xml_dep_s *next;
+} xml_dep_t;
+
+typedef struct {
+	xml_dep_t *head;
+	xml_dep_t *tail;
+	switch_hash_t *names;		/* type + name -> dep, each input is recorded once */
+	uint32_t count;
+	int64_t stamp;				/* when the files were looked at */
+	const char *volatile_input;	/* first directive whose result can change without any file changing */
+} xml_deps_t;
+
+#define XML_DEP_MISSING ((uint64_t) -1)
+
+/* the pass FILE_LOCK is held for, NULL when nobody asked for the inputs */
+static xml_deps_t *XML_DEPS = NULL;
+/* inputs of the tree ROOT_DEPS_TREE, under XML_LOCK, only trusted while that tree is still MAIN_XML_ROOT */
+static xml_deps_t *ROOT_DEPS = NULL;
+static switch_xml_t ROOT_DEPS_TREE = NULL;
+
+static uint64_t xml_dep_hash(uint64_t hash, const void *data, switch_size_t len)
+{
+	const uint8_t *p = (const uint8_t *) data;
+
+	while (len--) {
+		hash ^= *p++;
+		hash *= 0x100000001b3ULL;
+	}
+
+	return hash;
+}
+
+#define XML_DEP_HASH_INIT 0xcbf29ce484222325ULL
+
+static switch_status_t xml_dep_hash_file(const char *path, uint64_t *hash)
+{
+	char buf[65536];
+	switch_ssize_t l;
+	int fd;
+
+	if ((fd = open(path, O_RDONLY, 0)) < 0) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	*hash = XML_DEP_HASH_INIT;
+
+	while ((l = read(fd, buf, sizeof(buf))) > 0) {
+		*hash = xml_dep_hash(*hash, buf, l);
+	}
+
+	close(fd);
+
+	return l < 0 ? SWITCH_STATUS_FALSE : SWITCH_STATUS_SUCCESS;
+}
+
+static void xml_dep_hash_value(xml_dep_t *dep, const char *value)
+{
+	if (value) {
+		dep->size = strlen(value);
+		dep->hash = xml_dep_hash(XML_DEP_HASH_INIT, value, dep->size);
+	} else {
+		dep->size = XML_DEP_MISSING;
+		dep->hash = 0;
+	}
+}
+
+static xml_deps_t *xml_deps_create(void)
+{
+	xml_deps_t *deps = (xml_deps_t *) switch_must_malloc(sizeof(*deps));
+
+	memset(deps, 0, sizeof(*deps));
+	switch_core_hash_init(&deps->names);
+	deps->stamp = (int64_t) switch_epoch_time_now(NULL);
+
+	return deps;
+}
+
+static void xml_deps_destroy(xml_deps_t **depsp)
+{
+	xml_deps_t *deps = *depsp;
+	xml_dep_t *dep;
+
+	*depsp = NULL;
+
+	if (!deps) {
+		return;
+	}
+
+	while ((dep = deps->head)) {
+		deps->head = dep->next;
+		switch_safe_free(dep->name);
+		switch_safe_free(dep->value);
+		free(dep);
+	}
+
+	if (deps->names) {
+		switch_core_hash_destroy(&deps->names);
+	}
+
+	free(deps);
+}
+
+static xml_dep_t *xml_deps_find(xml_deps_t *deps, xml_dep_type_t type, const char *name)
+{
+	char key[1024];
+
+	switch_snprintf(key, sizeof(key), "%d:%s", type, name);
+
+	return (xml_dep_t *) switch_core_hash_find(deps->names, key);
+}
+
+static xml_dep_t *xml_deps_add(xml_deps_t *deps, xml_dep_type_t type, const char *name)
+{
+	char key[1024];
+	xml_dep_t *dep;
+
+	if ((dep = xml_deps_find(deps, type, name))) {
+		return dep;
+	}
+
+	dep = (xml_dep_t *) switch_must_malloc(sizeof(*dep));
+	memset(dep, 0, sizeof(*dep));
+	dep->type = type;
+	dep->name = switch_must_strdup(name);
+
+	if (deps->tail) {
+		deps->tail->next = dep;
+	} else {
+		deps->head = dep;
+	}
+	deps->tail = dep;
+	deps->count++;
+
+	switch_snprintf(key, sizeof(key), "%d:%s", type, name);
+	switch_core_hash_insert(deps->names, key, dep);
+
+	return dep;
+}
+
+static void xml_deps_note_file(const char *path)
+{
+	struct stat st;
+	xml_dep_t *dep;
+
+	if (!XML_DEPS) {
+		return;
+	}
+
+	dep = xml_deps_add(XML_DEPS, XML_DEP_FILE, path);
+
+	if (stat(path, &st) || xml_dep_hash_file(path, &dep->hash) != SWITCH_STATUS_SUCCESS) {
+		dep->size = XML_DEP_MISSING;
+		return;
+	}
+
+	dep->size = (uint64_t) st.st_size;
+	dep->mtime = (int64_t) st.st_mtime;
+}
+
+static void xml_deps_note_glob(const char *pattern, glob_t *gd)
+{
+	xml_dep_t *dep;
+	size_t n;
+
+	if (!XML_DEPS) {
+		return;
+	}
+
+	dep = xml_deps_add(XML_DEPS, XML_DEP_GLOB, pattern);
+	dep->hash = XML_DEP_HASH_INIT;
+	dep->size = 0;
+
+	for (n = 0; gd && n < gd->gl_pathc; n++) {
+		dep->hash = xml_dep_hash(dep->hash, gd->gl_pathv[n], strlen(gd->gl_pathv[n]) + 1);
+		dep->size++;
+	}
+}
+
+static void xml_deps_note_var(const char *name, const char *value)
+{
+	/* once the config set a variable its value follows from the files */
+	if (!XML_DEPS || xml_deps_find(XML_DEPS, XML_DEP_SET, name) || xml_deps_find(XML_DEPS, XML_DEP_VAR, name)) {
+		return;
+	}
+
+	xml_dep_hash_value(xml_deps_add(XML_DEPS, XML_DEP_VAR, name), value);
+}
+
+static void xml_deps_note_env(const char *name, const char *value)
+{
+	if (XML_DEPS) {
+		xml_dep_hash_value(xml_deps_add(XML_DEPS, XML_DEP_ENV, name), value);
+	}
+}
+
+static void xml_deps_note_volatile(const char *directive)
+{
+	if (XML_DEPS && !XML_DEPS->volatile_input) {
+		XML_DEPS->volatile_input = directive;
+	}
+}
+
+static void preprocess_set_variable(const char *name, const char *value)
+{
+	switch_core_set_variable(name, value);
+
+	if (XML_DEPS) {
+		xml_deps_add(XML_DEPS, XML_DEP_SET, name);
+	}
+}
+
+/* take the final value of everything the config set once the pass is over */
+static void xml_deps_finish(xml_deps_t *deps)
+{
+	xml_dep_t *dep;
+
+	for (dep = deps->head; dep; dep = dep->next) {
+		if (dep->type == XML_DEP_SET) {
+			switch_safe_free(dep->value);
+			dep->value = switch_core_get_variable_dup(dep->name);
+			xml_dep_hash_value(dep, dep->value);
+		}
+	}
+}
+
+static switch_bool_t xml_dep_value_changed(xml_dep_t *dep, const char *value)
+{
+	xml_dep_t now = { 0 };
+
+	xml_dep_hash_value(&now, value);
+
+	return now.size != dep->size || now.hash != dep->hash;
+}
+
+/* returns the first input that changed since the pass, NULL if running it again would give the same tree.
+   cold is for a process that never ran the pass, the variables the config sets are not there to compare yet */
+static const char *xml_deps_changed(xml_deps_t *deps, switch_bool_t cold)
+{
+	xml_dep_t *dep;
+	struct stat st;
+	uint64_t hash;
+
+	if (deps->volatile_input) {
+		return deps->volatile_input;
+	}
+
+	for (dep = deps->head; dep; dep = dep->next) {
+		switch (dep->type) {
+		case XML_DEP_FILE:
+			if (stat(dep->name, &st)) {
+				if (dep->size != XML_DEP_MISSING) {
+					return dep->name;
+				}
+				break;
+			}
+
+			if (dep->size != (uint64_t) st.st_size) {
+				return dep->name;
+			}
+
+			/* a file written in the second we looked at it may change again without its mtime moving */
+			if (dep->mtime != (int64_t) st.st_mtime || dep->mtime >= deps->stamp) {
+				if (xml_dep_hash_file(dep->name, &hash) != SWITCH_STATUS_SUCCESS || hash != dep->hash) {
+					return dep->name;
+				}
+			}
+			break;
+		case XML_DEP_GLOB:
+			{
+				glob_t gd;
+				xml_dep_t now = { 0 };
+				size_t n;
+				int r = glob(dep->name, GLOB_ERR, NULL, &gd);
+
+				now.hash = XML_DEP_HASH_INIT;
+
+				if (r == 0) {
+					for (n = 0; n < gd.gl_pathc; n++) {
+						now.hash = xml_dep_hash(now.hash, gd.gl_pathv[n], strlen(gd.gl_pathv[n]) + 1);
+						now.size++;
+					}
+					globfree(&gd);
+				} else if (r != GLOB_NOMATCH) {
+					return dep->name;
+				}
+
+				if (now.size != dep->size || now.hash != dep->hash) {
+					return dep->name;
+				}
+			}
+			break;
+		case XML_DEP_ENV:
+			if (xml_dep_value_changed(dep, getenv(dep->name))) {
+				return dep->name;
+			}
+			break;
+		case XML_DEP_VAR:
+		case XML_DEP_SET:
+			if (!cold || dep->type == XML_DEP_VAR) {
+				char *value = switch_core_get_variable_dup(dep->name);
+				switch_bool_t changed = xml_dep_value_changed(dep, value);
+
+				switch_safe_free(value);
+
+				if (changed) {
+					return dep->name;
+				}
+			}
+			break;
+		}
+	}
+
+	return NULL;
+}
 
 struct xml_section_t {
 	const char *name;
@@ -1278,7 +1641,10 @@ static char *expand_vars(char *buf, char *ebuf, switch_size_t elen, switch_size_
 				var = rp;
 				*e++ = '\0';
 				rp = e;
-				if ((val = switch_core_get_variable_dup(var))) {
+				val = switch_core_get_variable_dup(var);
+				xml_deps_note_var(var, val);
+
+				if (val) {
 					char *p;
 					for (p = val; p && *p && wp <= ep; p++) {
 						*wp++ = *p;
@@ -1300,8 +1666,9 @@ static char *expand_vars(char *buf, char *ebuf, switch_size_t elen, switch_size_
 
 	*wp++ = '\0';
 	*newlen = strlen(ebuf);
+
+	return ebuf;
 }
-return ebuf;
 
 static FILE *preprocess_exec(const char *cwd, const char *command, FILE *write_fd, int rlevel)
 {
@@ -1380,6 +1747,8 @@ static FILE *preprocess_glob(const char *cwd, const char *pattern, FILE *write_f
 	}
 
 	glob_return = glob(pattern, GLOB_ERR, NULL, &glob_data);
+	xml_deps_note_glob(pattern, glob_return ? NULL : &glob_data);
+
 	if (glob_return == GLOB_NOSPACE || glob_return == GLOB_ABORTED) {
 		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Error including %s\n", pattern);
 		goto end;
@@ -1430,6 +1799,8 @@ static int preprocess(const char *cwd, const char *file, FILE *write_fd, int rle
 		return -1;
 	}
 
+	xml_deps_note_file(file);
+
 	setvbuf(read_fd, (char *) NULL, _IOFBF, 65536);
 
 	for(;;) {
@@ -1545,13 +1916,15 @@ static int preprocess(const char *cwd, const char *file, FILE *write_fd, int rle
 				}
 				// 数据放入header
 				// key: external_auth_calls  value: false
-				if (val) { switch_core_set_variable(name, val); }
+				if (val) { preprocess_set_variable(name, val); }
 			} else if (!strcasecmp(tcmd, "exec-set")) {
 				// tcmd执行后放入  test=echo 1234
 				// key: test  value: 1234
+				xml_deps_note_volatile("exec-set");
 				preprocess_exec_set(targ);
 			} else if (!strcasecmp(tcmd, "stun-set")) {
 				// stun网络协议相关配置修改
+				xml_deps_note_volatile("stun-set");
 				preprocess_stun_set(targ);
 			} else if (!strcasecmp(tcmd, "env-set")) {
 				// X-pre-process 允许环境变量获取
@@ -1562,6 +1935,7 @@ static int preprocess(const char *cwd, const char *file, FILE *write_fd, int rle
 				preprocess_glob(cwd, targ, write_fd, rlevel + 1);
 			} else if (!strcasecmp(tcmd, "exec")) {
 				// 异步执行命令
+				xml_deps_note_volatile("exec");
 				preprocess_exec(cwd, targ, write_fd, rlevel + 1);
 			}
 
@@ -1614,16 +1988,19 @@ static int preprocess(const char *cwd, const char *file, FILE *write_fd, int rle
 					}
 
 					if (val) {
-						switch_core_set_variable(name, val);
+						preprocess_set_variable(name, val);
 					}
 
 				} else if (!strcasecmp(cmd, "exec-set")) {
+					xml_deps_note_volatile("exec-set");
 					preprocess_exec_set(arg);
 				} else if (!strcasecmp(cmd, "stun-set")) {
+					xml_deps_note_volatile("stun-set");
 					preprocess_stun_set(arg);
 				} else if (!strcasecmp(cmd, "include")) {
 					preprocess_glob(cwd, arg, write_fd, rlevel + 1);
 				} else if (!strcasecmp(cmd, "exec")) {
+					xml_deps_note_volatile("exec");
 					preprocess_exec(cwd, arg, write_fd, rlevel + 1);
 				}
 			}
@@ -1672,9 +2049,10 @@ SWITCH_DECLARE(switch_xml_t) switch_xml_parse_file_simple(const char *file)
 	return NULL;
 }
 
-SWITCH_DECLARE(switch_xml_t) switch_xml_parse_file(const char *file)
+/* deps receives every input the preprocessor looked at */
+static switch_xml_t xml_parse_file_ex(const char *file, xml_deps_t *deps)
 {
-	int fd = -1;
+	int fd = -1, ok;
 	FILE *write_fd = NULL;
 	switch_xml_t xml = NULL;
 	char *new_file = NULL;
@@ -1705,8 +2083,17 @@ SWITCH_DECLARE(switch_xml_t) switch_xml_parse_file(const char *file)
 	}
 
 	setvbuf(write_fd, (char *) NULL, _IOFBF, 65536);
+
+	XML_DEPS = deps;
 	// 预编译、整合配置xml
-	if (preprocess(SWITCH_GLOBAL_dirs.conf_dir, file, write_fd, 0) > -1) {
+	ok = preprocess(SWITCH_GLOBAL_dirs.conf_dir, file, write_fd, 0) > -1;
+	XML_DEPS = NULL;
+
+	if (deps) {
+		xml_deps_finish(deps);
+	}
+
+	if (ok) {
 		fclose(write_fd);
 		write_fd = NULL;
 		// 删除文件临时fsxml文件
@@ -1744,93 +2131,543 @@ SWITCH_DECLARE(switch_xml_t) switch_xml_parse_file(const char *file)
 	return xml;
 }
 
-SWITCH_DECLARE(switch_status_t) switch_xml_locate(const char *section,
-												  const char *tag_name,
-												  const char *key_name,
-												  const char *key_value,
-												  switch_xml_t *root, switch_xml_t *node, switch_event_t *params, switch_bool_t clone)
+SWITCH_DECLARE(switch_xml_t) switch_xml_parse_file(const char *file)
 {
-	switch_xml_t conf = NULL;
-	switch_xml_t tag = NULL;
-	switch_xml_t xml = NULL;
-	switch_xml_binding_t *binding;
-	uint8_t loops = 0;
-	switch_xml_section_t sections = BINDINGS ? switch_xml_parse_section_string(section) : 0;
+	return xml_parse_file_ex(file, NULL);
+}
 
-	switch_thread_rwlock_rdlock(B_RWLOCK);
+/* binary copy of a parsed tree, read back at startup instead of preprocessing and parsing the config again */
+#define XML_CACHE_MAGIC 0x42584346	/* "FCXB" */
+#define XML_CACHE_VERSION 1
+#define XML_CACHE_NONE ((uint32_t) -1)
 
-	for (binding = BINDINGS; binding; binding = binding->next) {
-		if (binding->sections && !(sections & binding->sections)) {
-			continue;
-		}
+typedef struct {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t word_size;			/* the cache is only read back by a build like the one that wrote it */
+	uint32_t volatile_input;	/* never set in a cache that is worth reading */
+	uint32_t dep_count;
+	uint32_t node_count;
+	uint32_t attr_count;
+	uint32_t strings_len;
+	int64_t stamp;
+} xml_cache_header_t;
 
-		if ((xml = binding->function(section, tag_name, key_name, key_value, params, binding->user_data))) {
-			const char *err = NULL;
+typedef struct {
+	uint32_t type;
+	uint32_t name;
+	uint32_t value;				/* XML_CACHE_NONE unless XML_DEP_SET with a value */
+	uint32_t pad;
+	int64_t mtime;
+	uint64_t size;
+	uint64_t hash;
+} xml_cache_dep_t;
 
-			err = switch_xml_error(xml);
-			if (zstr(err)) {
-				if ((conf = switch_xml_find_child(xml, "section", "name", "result"))) {
-					switch_xml_t p;
-					const char *aname;
+typedef struct {
+	uint32_t name;
+	uint32_t txt;
+	uint32_t parent;			/* index of the parent, nodes come in document order so it is always smaller */
+	uint32_t prev;				/* index of the previous child of the parent with the same name */
+	uint32_t attr;				/* index of the first attribute pair */
+	uint32_t attr_count;
+	uint32_t flags;
+	uint32_t pad;
+	uint64_t off;
+} xml_cache_node_t;
 
-					if ((p = switch_xml_child(conf, "result"))) {
-						aname = switch_xml_attr(p, "status");
-						if (aname && !strcasecmp(aname, "not found")) {
-							switch_xml_free(xml);
-							xml = NULL;
-							continue;
-						}
-					}
-				}
-				break;
-			} else {
-				switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Error[%s]\n", err);
-				switch_xml_free(xml);
-				xml = NULL;
-			}
-		}
+typedef struct {
+	switch_buffer_t *nodes;
+	switch_buffer_t *attrs;
+	switch_buffer_t *strings;
+	switch_hash_t *names;		/* tag and attribute names are stored once */
+	uint32_t node_count;
+	uint32_t attr_count;
+} xml_cache_writer_t;
+
+static uint32_t xml_cache_string(xml_cache_writer_t *w, const char *s, switch_bool_t shared)
+{
+	uint32_t off;
+	void *val;
+
+	if (!s) {
+		return XML_CACHE_NONE;
 	}
-	switch_thread_rwlock_unlock(B_RWLOCK);
 
-	for (;;) {
-		if (!xml) {
-			if (!(xml = switch_xml_root())) {
-				*node = NULL;
-				*root = NULL;
-				return SWITCH_STATUS_FALSE;
+	if (shared && (val = switch_core_hash_find(w->names, s))) {
+		return (uint32_t) (intptr_t) val - 1;
+	}
+
+	off = (uint32_t) switch_buffer_inuse(w->strings);
+	switch_buffer_write(w->strings, s, strlen(s) + 1);
+
+	if (shared) {
+		switch_core_hash_insert(w->names, s, (void *) (intptr_t) (off + 1));
+	}
+
+	return off;
+}
+
+static void xml_cache_write_node(xml_cache_writer_t *w, switch_xml_t xml, uint32_t parent, uint32_t prev)
+{
+	xml_cache_node_t node = { 0 };
+	uint32_t index = w->node_count++;
+	switch_xml_t child;
+	int i;
+
+	/* {name, previous index} of the last child seen for each tag name, few names repeat under one parent */
+	struct {
+		const char *name;
+		uint32_t index;
+	} *seen = NULL;
+	int seen_count = 0, seen_size = 0;
+
+	node.name = xml_cache_string(w, xml->name, SWITCH_TRUE);
+	node.txt = xml_cache_string(w, xml->txt ? xml->txt : "", SWITCH_FALSE);
+	node.parent = parent;
+	node.prev = prev;
+	node.attr = w->attr_count;
+	node.flags = xml->flags & SWITCH_XML_CDATA;
+	node.off = xml->off;
+
+	for (i = 0; xml->attr && xml->attr[i]; i += 2) {
+		uint32_t pair[2];
+
+		pair[0] = xml_cache_string(w, xml->attr[i], SWITCH_TRUE);
+		pair[1] = xml_cache_string(w, xml->attr[i + 1], SWITCH_FALSE);
+		switch_buffer_write(w->attrs, pair, sizeof(pair));
+		w->attr_count++;
+		node.attr_count++;
+	}
+
+	switch_buffer_write(w->nodes, &node, sizeof(node));
+
+	for (child = xml->child; child; child = child->ordered) {
+		uint32_t child_prev = XML_CACHE_NONE;
+
+		for (i = 0; i < seen_count; i++) {
+			if (!strcmp(seen[i].name, child->name)) {
+				break;
 			}
 		}
 
-		if ((conf = switch_xml_find_child(xml, "section", "name", section)) && (tag = switch_xml_find_child(conf, tag_name, key_name, key_value))) {
-			if (clone) {
-				char *x = switch_xml_toxml(tag, SWITCH_FALSE);
-				switch_assert(x);
-				*node = *root = switch_xml_parse_str_dynamic(x, SWITCH_FALSE);	/* x will be free()'d in switch_xml_free() */
-				switch_xml_free(xml);
-			} else {
-				*node = tag;
-				*root = xml;
-			}
-			return SWITCH_STATUS_SUCCESS;
+		if (i < seen_count) {
+			child_prev = seen[i].index;
 		} else {
-			switch_xml_free(xml);
-			xml = NULL;
-			*node = NULL;
-			*root = NULL;
-			if (loops++ > 1) {
-				break;
+			if (seen_count == seen_size) {
+				seen_size = seen_size ? seen_size * 2 : 8;
+				seen = switch_must_realloc(seen, seen_size * sizeof(*seen));
 			}
+			seen[i].name = child->name;
+			seen_count++;
 		}
+
+		seen[i].index = w->node_count;
+		xml_cache_write_node(w, child, index, child_prev);
 	}
 
-	return SWITCH_STATUS_FALSE;
+	switch_safe_free(seen);
 }
 
-SWITCH_DECLARE(switch_status_t) switch_xml_locate_domain(const char *domain_name, switch_event_t *params, switch_xml_t *root, switch_xml_t *domain)
+static switch_status_t xml_cache_write(switch_xml_t xml, xml_deps_t *deps, const char *path)
 {
-	switch_event_t *my_params = NULL;
-	switch_status_t status;
-	*domain = NULL;
+	xml_cache_writer_t w = { 0 };
+	xml_cache_header_t header = { 0 };
+	switch_status_t status = SWITCH_STATUS_FALSE;
+	switch_buffer_t *dep_buf = NULL;
+	char *tmp = NULL;
+	FILE *fp = NULL;
+	xml_dep_t *dep;
+
+	if (deps && deps->volatile_input) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	switch_buffer_create_dynamic(&w.nodes, 65536, 65536, 0);
+	switch_buffer_create_dynamic(&w.attrs, 65536, 65536, 0);
+	switch_buffer_create_dynamic(&w.strings, 65536, 65536, 0);
+	switch_buffer_create_dynamic(&dep_buf, 4096, 4096, 0);
+	switch_core_hash_init(&w.names);
+
+	/* offset 0 is the empty string */
+	switch_buffer_write(w.strings, "", 1);
+
+	for (dep = deps ? deps->head : NULL; dep; dep = dep->next) {
+		xml_cache_dep_t rec = { 0 };
+
+		rec.type = dep->type;
+		rec.name = xml_cache_string(&w, dep->name, SWITCH_FALSE);
+		rec.value = xml_cache_string(&w, dep->value, SWITCH_FALSE);
+		rec.mtime = dep->mtime;
+		rec.size = dep->size;
+		rec.hash = dep->hash;
+		switch_buffer_write(dep_buf, &rec, sizeof(rec));
+		header.dep_count++;
+	}
+
+	xml_cache_write_node(&w, xml, XML_CACHE_NONE, XML_CACHE_NONE);
+
+	if (switch_buffer_inuse(w.strings) >= XML_CACHE_NONE) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "XML tree too large to cache in %s\n", path);
+		goto end;
+	}
+
+	header.magic = XML_CACHE_MAGIC;
+	header.version = XML_CACHE_VERSION;
+	header.word_size = sizeof(void *);
+	header.node_count = w.node_count;
+	header.attr_count = w.attr_count;
+	header.strings_len = (uint32_t) switch_buffer_inuse(w.strings);
+	header.stamp = deps ? deps->stamp : 0;
+
+	tmp = switch_mprintf("%s.tmp", path);
+
+	if (!(fp = fopen(tmp, "wb"))) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "Couldn't write XML cache %s (%s)\n", tmp, strerror(errno));
+		goto end;
+	}
+
+	if (fwrite(&header, sizeof(header), 1, fp) != 1 ||
+		(header.dep_count && fwrite(switch_buffer_get_head_pointer(dep_buf), switch_buffer_inuse(dep_buf), 1, fp) != 1) ||
+		fwrite(switch_buffer_get_head_pointer(w.nodes), switch_buffer_inuse(w.nodes), 1, fp) != 1 ||
+		(w.attr_count && fwrite(switch_buffer_get_head_pointer(w.attrs), switch_buffer_inuse(w.attrs), 1, fp) != 1) ||
+		fwrite(switch_buffer_get_head_pointer(w.strings), switch_buffer_inuse(w.strings), 1, fp) != 1) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "Short write on XML cache %s\n", tmp);
+		fclose(fp);
+		unlink(tmp);
+		goto end;
+	}
+
+	fclose(fp);
+
+	if (rename(tmp, path)) {
+		unlink(tmp);
+		goto end;
+	}
+
+	status = SWITCH_STATUS_SUCCESS;
+
+  end:
+
+	switch_safe_free(tmp);
+	switch_buffer_destroy(&w.nodes);
+	switch_buffer_destroy(&w.attrs);
+	switch_buffer_destroy(&w.strings);
+	switch_buffer_destroy(&dep_buf);
+	switch_core_hash_destroy(&w.names);
+
+	return status;
+}
+
+static char **xml_cache_attrs(const uint32_t *pairs, uint32_t count, char *strings)
+{
+	char **attr;
+	uint32_t i;
+
+	if (!count) {
+		return SWITCH_XML_NIL;
+	}
+
+	/* same layout the parser builds so switch_xml_set_attr() can grow it later */
+	attr = (char **) switch_must_malloc((count * 2 + 2) * sizeof(char *));
+	for (i = 0; i < count; i++) {
+		attr[i * 2] = strings + pairs[i * 2];
+		attr[i * 2 + 1] = strings + pairs[i * 2 + 1];
+	}
+	attr[count * 2] = NULL;
+	attr[count * 2 + 1] = (char *) switch_must_malloc(count + 1);
+	memset(attr[count * 2 + 1], ' ', count);
+	attr[count * 2 + 1][count] = '\0';
+
+	return attr;
+}
+
+/* loads a tree written by xml_cache_write(), the strings stay in the one block read from disk */
+static switch_xml_t xml_cache_read(const char *path, xml_deps_t **depsp)
+{
+	xml_cache_header_t *header;
+	xml_cache_dep_t *drecs;
+	xml_cache_node_t *nodes;
+	uint32_t *pairs;
+	char *strings, *m = NULL;
+	switch_xml_t *tbl = NULL, *last_child = NULL, *last_type = NULL, xml = NULL;
+	xml_deps_t *deps = NULL;
+	switch_xml_root_t root;
+	const char *changed;
+	struct stat st;
+	uint64_t expect;
+	uint32_t i;
+	int fd;
+
+	if ((fd = open(path, O_RDONLY, 0)) < 0) {
+		return NULL;
+	}
+
+	if (fstat(fd, &st) || (uint64_t) st.st_size < sizeof(*header)) {
+		close(fd);
+		return NULL;
+	}
+
+	m = (char *) switch_must_malloc(st.st_size);
+
+	if (read(fd, m, st.st_size) != (switch_ssize_t) st.st_size) {
+		close(fd);
+		goto fail;
+	}
+
+	close(fd);
+
+	header = (xml_cache_header_t *) m;
+
+	if (header->magic != XML_CACHE_MAGIC || header->version != XML_CACHE_VERSION || header->word_size != sizeof(void *) ||
+		header->volatile_input || !header->node_count || !header->strings_len) {
+		goto fail;
+	}
+
+	expect = sizeof(*header) + (uint64_t) header->dep_count * sizeof(*drecs) + (uint64_t) header->node_count * sizeof(*nodes) +
+		(uint64_t) header->attr_count * 2 * sizeof(uint32_t) + header->strings_len;
+
+	if (expect != (uint64_t) st.st_size) {
+		goto fail;
+	}
+
+	drecs = (xml_cache_dep_t *) (m + sizeof(*header));
+	nodes = (xml_cache_node_t *) (drecs + header->dep_count);
+	pairs = (uint32_t *) (nodes + header->node_count);
+	strings = (char *) (pairs + header->attr_count * 2);
+
+	if (strings[header->strings_len - 1] != '\0') {
+		goto fail;
+	}
+
+#define XML_CACHE_STR_OK(_o) ((_o) < header->strings_len)
+
+	deps = xml_deps_create();
+	deps->stamp = header->stamp;
+
+	for (i = 0; i < header->dep_count; i++) {
+		xml_dep_t *dep;
+
+		if (drecs[i].type > XML_DEP_SET || !XML_CACHE_STR_OK(drecs[i].name) ||
+			(drecs[i].value != XML_CACHE_NONE && !XML_CACHE_STR_OK(drecs[i].value))) {
+			goto fail;
+		}
+
+		dep = xml_deps_add(deps, (xml_dep_type_t) drecs[i].type, strings + drecs[i].name);
+		dep->mtime = drecs[i].mtime;
+		dep->size = drecs[i].size;
+		dep->hash = drecs[i].hash;
+		if (drecs[i].value != XML_CACHE_NONE) {
+			dep->value = switch_must_strdup(strings + drecs[i].value);
+		}
+	}
+
+	if ((changed = xml_deps_changed(deps, SWITCH_TRUE))) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_INFO, "XML cache %s is stale, %s changed\n", path, changed);
+		goto fail;
+	}
+
+	for (i = 0; i < header->attr_count * 2; i++) {
+		if (!XML_CACHE_STR_OK(pairs[i])) {
+			goto fail;
+		}
+	}
+
+	tbl = (switch_xml_t *) switch_must_malloc(header->node_count * sizeof(switch_xml_t));
+	last_child = (switch_xml_t *) switch_must_malloc(header->node_count * sizeof(switch_xml_t));
+	last_type = (switch_xml_t *) switch_must_malloc(header->node_count * sizeof(switch_xml_t));
+	memset(last_child, 0, header->node_count * sizeof(switch_xml_t));
+	memset(last_type, 0, header->node_count * sizeof(switch_xml_t));
+
+	for (i = 0; i < header->node_count; i++) {
+		xml_cache_node_t *node = &nodes[i];
+		switch_xml_t x, parent;
+
+		if (!XML_CACHE_STR_OK(node->name) || !XML_CACHE_STR_OK(node->txt) ||
+			(uint64_t) node->attr + node->attr_count > header->attr_count ||
+			(i ? node->parent >= i : node->parent != XML_CACHE_NONE) ||
+			(node->prev != XML_CACHE_NONE && (node->prev >= i || nodes[node->prev].parent != node->parent))) {
+			goto fail;
+		}
+
+		if (!i) {
+			xml = x = switch_xml_new(strings + node->name);
+		} else {
+			x = (switch_xml_t) switch_must_malloc(sizeof(struct switch_xml));
+			memset(x, 0, sizeof(struct switch_xml));
+			x->name = strings + node->name;
+		}
+
+		x->txt = strings + node->txt;
+		x->attr = xml_cache_attrs(pairs + node->attr * 2, node->attr_count, strings);
+		x->flags |= node->flags & SWITCH_XML_CDATA;
+		x->off = (switch_size_t) node->off;
+		tbl[i] = x;
+
+		if (!i) {
+			continue;
+		}
+
+		/* nodes come in document order, so every link is an append */
+		parent = tbl[node->parent];
+		x->parent = parent;
+
+		if (last_child[node->parent]) {
+			last_child[node->parent]->ordered = x;
+		} else {
+			parent->child = x;
+		}
+		last_child[node->parent] = x;
+
+		if (node->prev != XML_CACHE_NONE) {
+			tbl[node->prev]->next = x;
+		} else {
+			if (last_type[node->parent]) {
+				last_type[node->parent]->sibling = x;
+			}
+			last_type[node->parent] = x;
+		}
+	}
+
+#undef XML_CACHE_STR_OK
+
+	root = (switch_xml_root_t) xml;
+	root->m = m;
+	root->len = st.st_size;
+	root->dynamic = 1;			/* so we know to free m in switch_xml_free() */
+
+	free(tbl);
+	free(last_child);
+	free(last_type);
+
+	if (depsp) {
+		*depsp = deps;
+	} else {
+		xml_deps_destroy(&deps);
+	}
+
+	return xml;
+
+  fail:
+
+	if (xml) {
+		/* strings still belong to m, free the nodes built so far without it */
+		switch_xml_free(xml);
+	}
+
+	switch_safe_free(tbl);
+	switch_safe_free(last_child);
+	switch_safe_free(last_type);
+	switch_safe_free(m);
+	xml_deps_destroy(&deps);
+
+	return NULL;
+}
+
+SWITCH_DECLARE(switch_status_t) switch_xml_write_cache(switch_xml_t xml, const char *file)
+{
+	if (!xml || zstr(file)) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	return xml_cache_write(xml, NULL, file);
+}
+
+SWITCH_DECLARE(switch_xml_t) switch_xml_parse_cache(const char *file)
+{
+	if (zstr(file)) {
+		return NULL;
+	}
+
+	return xml_cache_read(file, NULL);
+}
+
+SWITCH_DECLARE(switch_status_t) switch_xml_locate(const char *section,
+												  const char *tag_name,
+												  const char *key_name,
+												  const char *key_value,
+												  switch_xml_t *root, switch_xml_t *node, switch_event_t *params, switch_bool_t clone)
+{
+	switch_xml_t conf = NULL;
+	switch_xml_t tag = NULL;
+	switch_xml_t xml = NULL;
+	switch_xml_binding_t *binding;
+	uint8_t loops = 0;
+	switch_xml_section_t sections = BINDINGS ? switch_xml_parse_section_string(section) : 0;
+
+	switch_thread_rwlock_rdlock(B_RWLOCK);
+
+	for (binding = BINDINGS; binding; binding = binding->next) {
+		if (binding->sections && !(sections & binding->sections)) {
+			continue;
+		}
+
+		if ((xml = binding->function(section, tag_name, key_name, key_value, params, binding->user_data))) {
+			const char *err = NULL;
+
+			err = switch_xml_error(xml);
+			if (zstr(err)) {
+				if ((conf = switch_xml_find_child(xml, "section", "name", "result"))) {
+					switch_xml_t p;
+					const char *aname;
+
+					if ((p = switch_xml_child(conf, "result"))) {
+						aname = switch_xml_attr(p, "status");
+						if (aname && !strcasecmp(aname, "not found")) {
+							switch_xml_free(xml);
+							xml = NULL;
+							continue;
+						}
+					}
+				}
+				break;
+			} else {
+				switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Error[%s]\n", err);
+				switch_xml_free(xml);
+				xml = NULL;
+			}
+		}
+	}
+	switch_thread_rwlock_unlock(B_RWLOCK);
+
+	for (;;) {
+		if (!xml) {
+			if (!(xml = switch_xml_root())) {
+				*node = NULL;
+				*root = NULL;
+				return SWITCH_STATUS_FALSE;
+			}
+		}
+
+		if ((conf = switch_xml_find_child(xml, "section", "name", section)) && (tag = switch_xml_find_child(conf, tag_name, key_name, key_value))) {
+			if (clone) {
+				char *x = switch_xml_toxml(tag, SWITCH_FALSE);
+				switch_assert(x);
+				*node = *root = switch_xml_parse_str_dynamic(x, SWITCH_FALSE);	/* x will be free()'d in switch_xml_free() */
+				switch_xml_free(xml);
+			} else {
+				*node = tag;
+				*root = xml;
+			}
+			return SWITCH_STATUS_SUCCESS;
+		} else {
+			switch_xml_free(xml);
+			xml = NULL;
+			*node = NULL;
+			*root = NULL;
+			if (loops++ > 1) {
+				break;
+			}
+		}
+	}
+
+	return SWITCH_STATUS_FALSE;
+}
+
+SWITCH_DECLARE(switch_status_t) switch_xml_locate_domain(const char *domain_name, switch_event_t *params, switch_xml_t *root, switch_xml_t *domain)
+{
+	switch_event_t *my_params = NULL;
+	switch_status_t status;
+	*domain = NULL;
 
 	if (!params) {
 		switch_event_create(&my_params, SWITCH_EVENT_REQUEST_PARAMS);
@@ -1893,11 +2730,190 @@ SWITCH_DECLARE(switch_status_t) switch_xml_locate_group(const char *group_name,
 	return status;
 }
 
+/* containers with fewer users than this are cheaper to walk than to hash */
+#define SWITCH_XML_DIR_INDEX_MIN 16
+
+typedef struct switch_xml_user_index switch_xml_user_index_t;
+struct switch_xml_user_index {
+	switch_xml_t *users;		/* user tags of the container in document order */
+	switch_hash_t *ids;			/* id -> slot of the first user with it */
+	switch_hash_t *aliases;		/* number-alias -> slot of the first user with it */
+	switch_hash_t *ips;			/* ip -> slot of the first user with it */
+	switch_xml_t *typed;		/* slot of the first user with a type other than pointer */
+	switch_xml_user_index_t *next;
+};
+
+struct switch_xml_dir_index {
+	switch_hash_t *containers;	/* address of the users tag -> its switch_xml_user_index_t */
+	switch_xml_user_index_t *head;
+	uint32_t users;
+};
+
+static void dir_index_add_key(switch_hash_t *hash, const char *key, switch_xml_t *slot)
+{
+	/* find_user_in_tag returns the first match in document order, so keep the first one */
+	if (!zstr(key) && !switch_core_hash_find(hash, key)) {
+		switch_core_hash_insert(hash, key, slot);
+	}
+}
+
+static void dir_index_container(switch_xml_dir_index_t *idx, switch_xml_t tag)
+{
+	switch_xml_user_index_t *ui;
+	switch_xml_t x;
+	const char *type;
+	char key[64];
+	uint32_t count = 0, i = 0;
+
+	for (x = switch_xml_child(tag, "user"); x; x = x->next) {
+		count++;
+	}
+
+	if (count < SWITCH_XML_DIR_INDEX_MIN) {
+		return;
+	}
+
+	ui = (switch_xml_user_index_t *) switch_must_malloc(sizeof(*ui));
+	memset(ui, 0, sizeof(*ui));
+	ui->users = (switch_xml_t *) switch_must_malloc(sizeof(switch_xml_t) * count);
+	switch_core_hash_init_nocase(&ui->ids);
+	switch_core_hash_init_nocase(&ui->aliases);
+	switch_core_hash_init_nocase(&ui->ips);
+
+	for (x = switch_xml_child(tag, "user"); x; x = x->next, i++) {
+		ui->users[i] = x;
+		dir_index_add_key(ui->ids, switch_xml_attr(x, "id"), &ui->users[i]);
+		dir_index_add_key(ui->aliases, switch_xml_attr(x, "number-alias"), &ui->users[i]);
+		dir_index_add_key(ui->ips, switch_xml_attr(x, "ip"), &ui->users[i]);
+
+		if (!ui->typed && (type = switch_xml_attr(x, "type")) && strcasecmp(type, "pointer")) {
+			ui->typed = &ui->users[i];
+		}
+	}
+
+	switch_snprintf(key, sizeof(key), "%p", (void *) tag);
+	switch_core_hash_insert(idx->containers, key, ui);
+	ui->next = idx->head;
+	idx->head = ui;
+	idx->users += count;
+}
+
+static void dir_index_destroy(switch_xml_dir_index_t **idxp)
+{
+	switch_xml_dir_index_t *idx = *idxp;
+	switch_xml_user_index_t *ui;
+
+	*idxp = NULL;
+
+	if (!idx) {
+		return;
+	}
+
+	while ((ui = idx->head)) {
+		idx->head = ui->next;
+		switch_core_hash_destroy(&ui->ids);
+		switch_core_hash_destroy(&ui->aliases);
+		switch_core_hash_destroy(&ui->ips);
+		free(ui->users);
+		free(ui);
+	}
+
+	switch_core_hash_destroy(&idx->containers);
+	free(idx);
+}
+
+SWITCH_DECLARE(uint32_t) switch_xml_index_directory(switch_xml_t xml)
+{
+	switch_xml_root_t root;
+	switch_xml_dir_index_t *idx;
+	switch_xml_t section, domain, groups, group, users;
+
+	if (!xml || xml->parent) {
+		return 0;
+	}
+
+	root = (switch_xml_root_t) xml;
+
+	if (root->dir_index) {
+		return root->dir_index->users;
+	}
+
+	idx = (switch_xml_dir_index_t *) switch_must_malloc(sizeof(*idx));
+	memset(idx, 0, sizeof(*idx));
+	switch_core_hash_init(&idx->containers);
+
+	/* the same containers switch_xml_locate_user_in_domain and switch_xml_locate_user_merged search */
+	for (section = switch_xml_child(xml, "section"); section; section = section->next) {
+		const char *name = switch_xml_attr_soft(section, "name");
+
+		if (strcasecmp(name, "directory")) {
+			continue;
+		}
+
+		for (domain = switch_xml_child(section, "domain"); domain; domain = domain->next) {
+			dir_index_container(idx, domain);
+
+			if ((users = switch_xml_child(domain, "users"))) {
+				dir_index_container(idx, users);
+			}
+
+			if ((groups = switch_xml_child(domain, "groups"))) {
+				for (group = switch_xml_child(groups, "group"); group; group = group->next) {
+					if ((users = switch_xml_child(group, "users"))) {
+						dir_index_container(idx, users);
+					}
+				}
+			}
+		}
+	}
+
+	root->dir_index = idx;
+	/* dir_index_lookup() only trusts tops flagged as roots */
+	switch_set_flag(xml, SWITCH_XML_ROOT);
+
+	return idx->users;
+}
+
+static switch_xml_user_index_t *dir_index_lookup(switch_xml_t tag)
+{
+	switch_xml_t top = tag;
+	switch_xml_dir_index_t *idx;
+	char key[64];
+
+	while (top->parent) {
+		top = top->parent;
+	}
+
+	/* a tag that is not a root is no switch_xml_root_t, a subtree on its own takes the walk */
+	if (!switch_test_flag(top, SWITCH_XML_ROOT) || !(idx = ((switch_xml_root_t) top)->dir_index)) {
+		return NULL;
+	}
+
+	switch_snprintf(key, sizeof(key), "%p", (void *) tag);
+
+	return (switch_xml_user_index_t *) switch_core_hash_find(idx->containers, key);
+}
+
+/* earliest of the candidate slots, which is what the linear walk would have stopped at */
+static switch_xml_t *dir_index_first(switch_xml_t *a, switch_xml_t *b)
+{
+	if (!a) {
+		return b;
+	}
+
+	if (!b) {
+		return a;
+	}
+
+	return a < b ? a : b;
+}
+
 static switch_status_t find_user_in_tag(switch_xml_t tag, const char *ip, const char *user_name,
 										const char *key, switch_event_t *params, switch_xml_t *user)
 {
 	const char *type = "!pointer";
 	const char *val;
+	switch_xml_user_index_t *ui;
 
 	if (params && (val = switch_event_get_header(params, "user_type"))) {
 		if (!strcasecmp(val, "any")) {
@@ -1907,6 +2923,30 @@ static switch_status_t find_user_in_tag(switch_xml_t tag, const char *ip, const
 		}
 	}
 
+	/* the index only knows the default type filter, anything else takes the walk below */
+	if ((!type || !strcmp(type, "!pointer")) && (!user_name || !strcasecmp(key, "id")) && (ui = dir_index_lookup(tag))) {
+		switch_xml_t *typed = type ? ui->typed : NULL;
+		switch_xml_t *slot;
+
+		if (ip) {
+			if ((slot = dir_index_first(switch_core_hash_find(ui->ips, ip), typed))) {
+				*user = *slot;
+				return SWITCH_STATUS_SUCCESS;
+			}
+		}
+
+		if (user_name) {
+			slot = dir_index_first(switch_core_hash_find(ui->ids, user_name), switch_core_hash_find(ui->aliases, user_name));
+
+			if ((slot = dir_index_first(slot, typed))) {
+				*user = *slot;
+				return SWITCH_STATUS_SUCCESS;
+			}
+		}
+
+		return SWITCH_STATUS_FALSE;
+	}
+
 	if (ip) {
 		if ((*user = switch_xml_find_child_multi(tag, "user", "ip", ip, "type", type, NULL))) {
 			return SWITCH_STATUS_SUCCESS;
@@ -2015,15 +3055,46 @@ SWITCH_DECLARE(void) switch_xml_merge_user(switch_xml_t user, switch_xml_t domai
 	}
 }
 
+static void user_cache_entry_destroy(user_cache_entry_t **entryP)
+{
+	user_cache_entry_t *entry = *entryP;
+
+	*entryP = NULL;
+
+	if (entry->user) {
+		switch_xml_free(entry->user);
+	}
+
+	free(entry);
+}
+
+struct user_cache_flush {
+	uint32_t count;
+	switch_bool_t loading;
+};
+
+/* switch_core_hash_delete_multi() callback, entries being loaded are only dropped when flush->loading is set */
+static switch_bool_t user_cache_entry_flush(const void *key, const void *val, void *pData)
+{
+	user_cache_entry_t *entry = (user_cache_entry_t *) val;
+	struct user_cache_flush *flush = (struct user_cache_flush *) pData;
+
+	if (entry->loading && !flush->loading) {
+		return SWITCH_FALSE;
+	}
+
+	user_cache_entry_destroy(&entry);
+	flush->count++;
+
+	return SWITCH_TRUE;
+}
+
 SWITCH_DECLARE(uint32_t) switch_xml_clear_user_cache(const char *key, const char *user_name, const char *domain_name)
 {
-	switch_hash_index_t *hi = NULL;
-	void *val;
-	const void *var;
 	char mega_key[1024];
 	int r = 0;
-	switch_xml_t lookup;
-	char *expires_val = NULL;
+	user_cache_entry_t *lookup;
+	struct user_cache_flush flush = { 0, SWITCH_FALSE };
 
 	switch_mutex_lock(CACHE_MUTEX);
 
@@ -2034,108 +3105,299 @@ SWITCH_DECLARE(uint32_t) switch_xml_clear_user_cache(const char *key, const char
 	if (key && user_name && domain_name) {
 		switch_snprintf(mega_key, sizeof(mega_key), "%s%s%s", key, user_name, domain_name);
 
-		if ((lookup = switch_core_hash_find(CACHE_HASH, mega_key))) {
+		/* an entry being loaded is left alone, its loader replaces it when done */
+		if ((lookup = switch_core_hash_find(CACHE_HASH, mega_key)) && !lookup->loading) {
 			switch_core_hash_delete(CACHE_HASH, mega_key);
-			if ((expires_val = switch_core_hash_find(CACHE_EXPIRES_HASH, mega_key))) {
-				switch_core_hash_delete(CACHE_EXPIRES_HASH, mega_key);
-				free(expires_val);
-				expires_val = NULL;
-			}
-			switch_xml_free(lookup);
+			user_cache_entry_destroy(&lookup);
 			r++;
 		}
 
 	} else {
+		switch_core_hash_delete_multi(CACHE_HASH, user_cache_entry_flush, &flush);
+		r = flush.count;
+	}
 
-		while ((hi = switch_core_hash_first_iter( CACHE_HASH, hi))) {
-			switch_core_hash_this(hi, &var, NULL, &val);
-			switch_xml_free(val);
-			switch_core_hash_delete(CACHE_HASH, var);
-			r++;
-		}
+	switch_mutex_unlock(CACHE_MUTEX);
 
-		while ((hi = switch_core_hash_first_iter( CACHE_EXPIRES_HASH, hi))) {
-			switch_core_hash_this(hi, &var, NULL, &val);
-			switch_safe_free(val);
-			switch_core_hash_delete(CACHE_EXPIRES_HASH, var);
-		}
+	return r;
+
+}
+
+static void user_cache_flush_event_handler(switch_event_t *event)
+{
+	const char *key = switch_event_get_header(event, "key");
+	const char *user_name = switch_event_get_header(event, "user");
+	const char *domain_name = switch_event_get_header(event, "domain");
+	uint32_t r;
 
-		switch_safe_free(hi);
+	r = switch_xml_clear_user_cache(key, user_name, domain_name);
+
+	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "Flushed %u cached user(s) on %s event\n", r, SWITCH_XML_CACHE_FLUSH_EVENT);
+}
+
+SWITCH_DECLARE(void) switch_xml_user_cache_status(switch_stream_handle_t *stream)
+{
+	switch_hash_index_t *hi;
+	void *val;
+	uint32_t users = 0, negative = 0, loading = 0;
+	uint64_t lookups;
+
+	switch_mutex_lock(CACHE_MUTEX);
+
+	for (hi = switch_core_hash_first(CACHE_HASH); hi; hi = switch_core_hash_next(&hi)) {
+		user_cache_entry_t *entry;
+
+		switch_core_hash_this(hi, NULL, NULL, &val);
+		entry = (user_cache_entry_t *) val;
+
+		if (entry->loading) {
+			loading++;
+		} else if (entry->user) {
+			users++;
+		} else {
+			negative++;
+		}
 	}
 
+	lookups = CACHE_STATS.hits + CACHE_STATS.stale_hits + CACHE_STATS.negative_hits + CACHE_STATS.misses;
+
+	stream->write_function(stream, "Entries: %u users, %u not found, %u loading\n", users, negative, loading);
+	stream->write_function(stream, "Lookups: %" SWITCH_UINT64_T_FMT "\n", lookups);
+	stream->write_function(stream, "Hits: %" SWITCH_UINT64_T_FMT " fresh, %" SWITCH_UINT64_T_FMT " stale, %" SWITCH_UINT64_T_FMT " not found\n",
+						   CACHE_STATS.hits, CACHE_STATS.stale_hits, CACHE_STATS.negative_hits);
+	stream->write_function(stream, "Misses: %" SWITCH_UINT64_T_FMT " (%" SWITCH_UINT64_T_FMT " waited on another lookup)\n",
+						   CACHE_STATS.misses, CACHE_STATS.coalesced);
+	stream->write_function(stream, "Background refreshes: %" SWITCH_UINT64_T_FMT "\n", CACHE_STATS.refreshes);
+	stream->write_function(stream, "Hit rate: %.1f%%\n",
+						   lookups ? (double) (lookups - CACHE_STATS.misses) * 100 / lookups : 0.0);
+
 	switch_mutex_unlock(CACHE_MUTEX);
+}
 
-	return r;
+struct user_cache_refresh {
+	char *key;
+	char *user_name;
+	char *domain_name;
+	char *ip;
+	switch_event_t *params;
+};
+
+static switch_status_t user_cache_fetch(const char *key, const char *user_name, const char *domain_name,
+										const char *ip, switch_event_t *params, switch_bool_t refresh, switch_xml_t *user);
+
+static void *SWITCH_THREAD_FUNC user_cache_refresh_thread(switch_thread_t *thread, void *obj)
+{
+	struct user_cache_refresh *r = (struct user_cache_refresh *) obj;
+	switch_xml_t x_user = NULL;
+
+	if (user_cache_fetch(r->key, r->user_name, r->domain_name, r->ip, r->params, SWITCH_TRUE, &x_user) == SWITCH_STATUS_SUCCESS) {
+		switch_xml_free(x_user);
+	}
 
+	if (r->params) {
+		switch_event_destroy(&r->params);
+	}
+
+	return NULL;
 }
 
-static switch_status_t switch_xml_locate_user_cache(const char *key, const char *user_name, const char *domain_name, switch_xml_t *user)
+static void user_cache_refresh(const char *key, const char *user_name, const char *domain_name, const char *ip, switch_event_t *params)
+{
+	switch_memory_pool_t *pool;
+	switch_thread_data_t *td;
+	struct user_cache_refresh *r;
+
+	switch_core_new_memory_pool(&pool);
+
+	r = switch_core_alloc(pool, sizeof(*r));
+	r->key = switch_core_strdup(pool, key);
+	r->user_name = switch_core_strdup(pool, user_name);
+	r->domain_name = switch_core_strdup(pool, domain_name);
+	r->ip = ip ? switch_core_strdup(pool, ip) : NULL;
+
+	if (params) {
+		switch_event_dup(&r->params, params);
+	}
+
+	td = switch_core_alloc(pool, sizeof(*td));
+	td->func = user_cache_refresh_thread;
+	td->obj = r;
+	td->pool = pool;
+
+	switch_thread_pool_launch_thread(&td);
+}
+
+/*
+  SWITCH_STATUS_SUCCESS with a copy of the cached user, SWITCH_STATUS_NOTFOUND for a cached miss,
+  otherwise the caller has to do the lookup and hand the result to user_cache_store()
+*/
+static switch_status_t switch_xml_locate_user_cache(const char *key, const char *user_name, const char *domain_name,
+													const char *ip, switch_event_t *params, switch_xml_t *user)
 {
 	char mega_key[1024];
 	switch_status_t status = SWITCH_STATUS_FALSE;
-	switch_xml_t lookup;
+	user_cache_entry_t *lookup;
+	switch_time_t started = 0;
+	int refresh = 0;
 
 	switch_snprintf(mega_key, sizeof(mega_key), "%s%s%s", key, user_name, domain_name);
 
 	switch_mutex_lock(CACHE_MUTEX);
-	if ((lookup = switch_core_hash_find(CACHE_HASH, mega_key))) {
-		char *expires_lookup = NULL;
 
-		if ((expires_lookup = switch_core_hash_find(CACHE_EXPIRES_HASH, mega_key))) {
-			switch_time_t time_expires = 0;
-			switch_time_t time_now = 0;
+	while ((lookup = switch_core_hash_find(CACHE_HASH, mega_key))) {
+		switch_time_t time_now = switch_micro_time_now();
 
-			time_now = switch_micro_time_now();
-			time_expires = atol(expires_lookup);
-			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "Cache Info\nTime Now:\t%ld\nExpires:\t%ld\n", (long)time_now, (long)time_expires);
-			if (time_expires < time_now) {
-				switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "Cache expired for %s@%s, doing fresh lookup\n", user_name, domain_name);
-			} else {
-				*user = switch_xml_dup(lookup);
+		if (lookup->loading) {
+			/* somebody else is fetching this user already, wait for their answer rather than asking the binding again */
+			if (!started) {
+				started = time_now;
+				CACHE_STATS.coalesced++;
+			} else if (time_now - started > USER_CACHE_WAIT_MS * 1000) {
+				break;
+			}
+			switch_thread_cond_timedwait(CACHE_COND, CACHE_MUTEX, 100000);
+			continue;
+		}
+
+		if (!lookup->expires || lookup->expires >= time_now) {
+			if (lookup->user) {
+				*user = switch_xml_dup(lookup->user);
 				status = SWITCH_STATUS_SUCCESS;
+				CACHE_STATS.hits++;
+			} else {
+				status = SWITCH_STATUS_NOTFOUND;
+				CACHE_STATS.negative_hits++;
 			}
-		} else {
-			*user = switch_xml_dup(lookup);
+			goto end;
+		}
+
+		if (lookup->user && runtime.directory_stale_cache_ms && lookup->expires + runtime.directory_stale_cache_ms * 1000 >= time_now) {
+			*user = switch_xml_dup(lookup->user);
 			status = SWITCH_STATUS_SUCCESS;
+			CACHE_STATS.stale_hits++;
+
+			if (!lookup->refreshing) {
+				lookup->refreshing = 1;
+				CACHE_STATS.refreshes++;
+				refresh = 1;
+			}
+			goto end;
+		}
+
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "Cache expired for %s@%s, doing fresh lookup\n", user_name, domain_name);
+
+		/* the expired entry was cached, so the answer will be too, keep it as the loading marker */
+		if (lookup->user) {
+			switch_xml_free(lookup->user);
+			lookup->user = NULL;
 		}
+		lookup->loading = 1;
+		CACHE_STATS.misses++;
+		goto end;
 	}
+
+	/* nothing says this user is cacheable, so there is nothing for others to wait on */
+	CACHE_STATS.misses++;
+
+ end:
+
 	switch_mutex_unlock(CACHE_MUTEX);
 
+	if (refresh) {
+		user_cache_refresh(key, user_name, domain_name, ip, params);
+	}
+
 	return status;
 }
 
-static void switch_xml_user_cache(const char *key, const char *user_name, const char *domain_name, switch_xml_t user, switch_time_t expires)
+/* user is cached with the expiry if cache is set (a NULL user caches the miss), otherwise any entry is dropped */
+static void user_cache_store(const char *key, const char *user_name, const char *domain_name, switch_xml_t user, switch_time_t expires, switch_bool_t cache)
 {
 	char mega_key[1024];
-	switch_xml_t lookup;
-	char *expires_lookup;
+	user_cache_entry_t *lookup;
 
 	switch_snprintf(mega_key, sizeof(mega_key), "%s%s%s", key, user_name, domain_name);
 
 	switch_mutex_lock(CACHE_MUTEX);
+
 	if ((lookup = switch_core_hash_find(CACHE_HASH, mega_key))) {
 		switch_core_hash_delete(CACHE_HASH, mega_key);
-		switch_xml_free(lookup);
+		user_cache_entry_destroy(&lookup);
 	}
-	if ((expires_lookup = switch_core_hash_find(CACHE_EXPIRES_HASH, mega_key))) {
-		switch_core_hash_delete(CACHE_EXPIRES_HASH, mega_key);
-		switch_safe_free(expires_lookup);
+
+	if (cache) {
+		switch_zmalloc(lookup, sizeof(*lookup));
+		lookup->user = user ? switch_xml_dup(user) : NULL;
+		lookup->expires = expires;
+		switch_core_hash_insert(CACHE_HASH, mega_key, lookup);
 	}
-	if (expires) {
-		char *expires_val = (char *)switch_core_hash_insert_alloc(CACHE_EXPIRES_HASH, mega_key, 22);
-		if (!snprintf(expires_val, 22, "%ld", (long)expires)) {
-			switch_core_hash_delete(CACHE_EXPIRES_HASH, mega_key);
-			switch_safe_free(expires_val);
-		}
+
+	switch_thread_cond_broadcast(CACHE_COND);
+	switch_mutex_unlock(CACHE_MUTEX);
+}
+
+static void user_cache_refresh_failed(const char *key, const char *user_name, const char *domain_name)
+{
+	char mega_key[1024];
+	user_cache_entry_t *lookup;
+
+	switch_snprintf(mega_key, sizeof(mega_key), "%s%s%s", key, user_name, domain_name);
+
+	switch_mutex_lock(CACHE_MUTEX);
+	if ((lookup = switch_core_hash_find(CACHE_HASH, mega_key))) {
+		lookup->refreshing = 0;
 	}
-	switch_core_hash_insert(CACHE_HASH, mega_key, switch_xml_dup(user));
 	switch_mutex_unlock(CACHE_MUTEX);
 }
 
+static switch_status_t user_cache_fetch(const char *key, const char *user_name, const char *domain_name,
+										const char *ip, switch_event_t *params, switch_bool_t refresh, switch_xml_t *user)
+{
+	switch_xml_t xml, domain, group, x_user, x_user_dup;
+	switch_status_t status;
+
+	if ((status = switch_xml_locate_user(key, user_name, domain_name, ip, &xml, &domain, &x_user, &group, params)) == SWITCH_STATUS_SUCCESS) {
+		const char *cacheable = NULL;
+		switch_time_t expires = 0;
+
+		x_user_dup = switch_xml_dup(x_user);
+		switch_xml_merge_user(x_user_dup, domain, group);
+
+		cacheable = switch_xml_attr(x_user_dup, "cacheable");
+		if (!zstr(cacheable)) {
+			switch_time_t time_now = 0;
+
+			if (switch_is_number(cacheable)) {
+				int cache_ms = atol(cacheable);
+				switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "caching lookup for user %s@%s for %d milliseconds\n",
+								  user_name, domain_name, cache_ms);
+				time_now = switch_micro_time_now();
+				expires = time_now + (cache_ms * 1000);
+			} else {
+				switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "caching lookup for user %s@%s indefinitely\n", user_name, domain_name);
+			}
+		}
+		user_cache_store(key, user_name, domain_name, x_user_dup, expires, !zstr(cacheable));
+		*user = x_user_dup;
+		switch_xml_free(xml);
+	} else if (refresh) {
+		/* keep serving the stale copy until it runs out rather than dropping it on a failed refresh */
+		user_cache_refresh_failed(key, user_name, domain_name);
+	} else if (runtime.directory_negative_cache_ms) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "caching failed lookup for user %s@%s for %u milliseconds\n",
+						  user_name, domain_name, runtime.directory_negative_cache_ms);
+		user_cache_store(key, user_name, domain_name, NULL, switch_micro_time_now() + runtime.directory_negative_cache_ms * 1000, SWITCH_TRUE);
+	} else {
+		user_cache_store(key, user_name, domain_name, NULL, 0, SWITCH_FALSE);
+	}
+
+	return status;
+}
+
 SWITCH_DECLARE(switch_status_t) switch_xml_locate_user_merged(const char *key, const char *user_name, const char *domain_name,
 															  const char *ip, switch_xml_t *user, switch_event_t *params)
 {
-	switch_xml_t xml, domain, group, x_user, x_user_dup;
+	switch_xml_t x_user;
 	switch_status_t status = SWITCH_STATUS_FALSE;
 	char *kdup = NULL;
 	char *keys[10] = {0};
@@ -2150,33 +3412,13 @@ SWITCH_DECLARE(switch_status_t) switch_xml_locate_user_merged(const char *key, c
 	}
 
 	for(i = 0; i < nkeys; i++) {
-		if ((status = switch_xml_locate_user_cache(keys[i], user_name, domain_name, &x_user)) == SWITCH_STATUS_SUCCESS) {
+		if ((status = switch_xml_locate_user_cache(keys[i], user_name, domain_name, ip, params, &x_user)) == SWITCH_STATUS_SUCCESS) {
 			*user = x_user;
 			break;
-		} else if ((status = switch_xml_locate_user(keys[i], user_name, domain_name, ip, &xml, &domain, &x_user, &group, params)) == SWITCH_STATUS_SUCCESS) {
-			const char *cacheable = NULL;
-
-			x_user_dup = switch_xml_dup(x_user);
-			switch_xml_merge_user(x_user_dup, domain, group);
-
-			cacheable = switch_xml_attr(x_user_dup, "cacheable");
-			if (!zstr(cacheable)) {
-				switch_time_t expires = 0;
-				switch_time_t time_now = 0;
-
-				if (switch_is_number(cacheable)) {
-					int cache_ms = atol(cacheable);
-					switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "caching lookup for user %s@%s for %d milliseconds\n",
-									  user_name, domain_name, cache_ms);
-					time_now = switch_micro_time_now();
-					expires = time_now + (cache_ms * 1000);
-				} else {
-					switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "caching lookup for user %s@%s indefinitely\n", user_name, domain_name);
-				}
-				switch_xml_user_cache(keys[i], user_name, domain_name, x_user_dup, expires);
-			}
-			*user = x_user_dup;
-			switch_xml_free(xml);
+		} else if (status == SWITCH_STATUS_NOTFOUND) {
+			status = SWITCH_STATUS_FALSE;
+		} else if ((status = user_cache_fetch(keys[i], user_name, domain_name, ip, params, SWITCH_FALSE, &x_user)) == SWITCH_STATUS_SUCCESS) {
+			*user = x_user;
 			break;
 		}
 	}
@@ -2321,6 +3563,12 @@ SWITCH_DECLARE(switch_status_t) switch_xml_set_root(switch_xml_t new_main)
 {
 	switch_xml_t old_root = NULL;
 
+	/* whatever reloadxml knew about the inputs of the old tree does not hold for this one */
+	ROOT_DEPS_TREE = NULL;
+
+	/* index the new tree before anybody can see it so a reload swaps tree and index at once */
+	switch_xml_index_directory(new_main);
+
 	switch_mutex_lock(REFLOCK);
 
 	old_root = MAIN_XML_ROOT;
@@ -2390,9 +3638,12 @@ SWITCH_DECLARE(switch_xml_t) switch_xml_open_root(uint8_t reload, const char **e
 SWITCH_DECLARE_NONSTD(switch_xml_t) __switch_xml_open_root(uint8_t reload, const char **err, void *user_data)
 {
 	char path_buf[1024];
+	char cache_buf[1024];
 	uint8_t errcnt = 0;
 	// 预编译、整合后的xml配置对象
 	switch_xml_t new_main, r = NULL;
+	xml_deps_t *deps = NULL;
+	const char *changed = NULL;
 
 	if (MAIN_XML_ROOT) {
 		// xml not reload
@@ -2400,10 +3651,47 @@ SWITCH_DECLARE_NONSTD(switch_xml_t) __switch_xml_open_root(uint8_t reload, const
 			r = switch_xml_root();
 			goto done;
 		}
+
+		/* nothing the preprocessor read has changed, running it again would build the same tree */
+		if (reload != SWITCH_XML_RELOAD_FORCE && ROOT_DEPS && ROOT_DEPS_TREE == MAIN_XML_ROOT) {
+			if (!(changed = xml_deps_changed(ROOT_DEPS, SWITCH_FALSE))) {
+				switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_INFO, "XML config unchanged, keeping the current tree\n");
+				*err = "Success";
+				r = switch_xml_root();
+				goto done;
+			}
+
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "Reloading XML config, %s changed\n", changed);
+		}
+	}
+
+	switch_snprintf(cache_buf, sizeof(cache_buf), "%s%s%s.fsbin", SWITCH_GLOBAL_dirs.log_dir, SWITCH_PATH_SEPARATOR, SWITCH_GLOBAL_filenames.conf_name);
+
+	if (!MAIN_XML_ROOT && (new_main = xml_cache_read(cache_buf, &deps))) {
+		xml_dep_t *dep;
+
+		/* the globals the preprocessor would have set */
+		for (dep = deps->head; dep; dep = dep->next) {
+			if (dep->type == XML_DEP_SET && dep->value) {
+				switch_core_set_variable(dep->name, dep->value);
+			}
+		}
+
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_INFO, "XML config loaded from %s\n", cache_buf);
+		*err = "Success";
+		switch_xml_set_root(new_main);
+		xml_deps_destroy(&ROOT_DEPS);
+		ROOT_DEPS = deps;
+		ROOT_DEPS_TREE = new_main;
+		r = switch_xml_root();
+		goto done;
 	}
+
+	deps = xml_deps_create();
+
 	// conf_name "freeswitch.xml"
 	switch_snprintf(path_buf, sizeof(path_buf), "%s%s%s", SWITCH_GLOBAL_dirs.conf_dir, SWITCH_PATH_SEPARATOR, SWITCH_GLOBAL_filenames.conf_name);
-	if ((new_main = switch_xml_parse_file(path_buf))) {
+	if ((new_main = xml_parse_file_ex(path_buf, deps))) {
 		*err = switch_xml_error(new_main);
 		switch_copy_string(not_so_threadsafe_error_buffer, *err, sizeof(not_so_threadsafe_error_buffer));
 		*err = not_so_threadsafe_error_buffer;
@@ -2413,8 +3701,17 @@ SWITCH_DECLARE_NONSTD(switch_xml_t) __switch_xml_open_root(uint8_t reload, const
 			errcnt++;
 		} else {
 			*err = "Success";
-			switch_xml_set_root(new_main);
 
+			/* a config using exec, exec-set or stun-set is not worth caching, do not leave an older one behind */
+			if (xml_cache_write(new_main, deps, cache_buf) != SWITCH_STATUS_SUCCESS) {
+				unlink(cache_buf);
+			}
+
+			switch_xml_set_root(new_main);
+			xml_deps_destroy(&ROOT_DEPS);
+			ROOT_DEPS = deps;
+			ROOT_DEPS_TREE = new_main;
+			deps = NULL;
 		}
 	} else {
 		*err = "Cannot Open log directory or XML Root!";
@@ -2427,6 +3724,8 @@ SWITCH_DECLARE_NONSTD(switch_xml_t) __switch_xml_open_root(uint8_t reload, const
 
  done:
 
+	xml_deps_destroy(&deps);
+
 	return r;
 }
 
@@ -2453,7 +3752,8 @@ SWITCH_DECLARE(switch_status_t) switch_xml_init(switch_memory_pool_t *pool, cons
 	switch_mutex_init(&REFLOCK, SWITCH_MUTEX_NESTED, XML_MEMORY_POOL);
 	switch_mutex_init(&FILE_LOCK, SWITCH_MUTEX_NESTED, XML_MEMORY_POOL);
 	switch_core_hash_init(&CACHE_HASH);
-	switch_core_hash_init(&CACHE_EXPIRES_HASH);
+	switch_thread_cond_create(&CACHE_COND, XML_MEMORY_POOL);
+	switch_event_bind_removable("xml", SWITCH_EVENT_CUSTOM, SWITCH_XML_CACHE_FLUSH_EVENT, user_cache_flush_event_handler, NULL, &CACHE_FLUSH_NODE);
 
 	switch_thread_rwlock_create(&B_RWLOCK, XML_MEMORY_POOL);
 
@@ -2470,6 +3770,7 @@ SWITCH_DECLARE(switch_status_t) switch_xml_init(switch_memory_pool_t *pool, cons
 SWITCH_DECLARE(switch_status_t) switch_xml_destroy(void)
 {
 	switch_status_t status = SWITCH_STATUS_FALSE;
+	struct user_cache_flush flush = { 0, SWITCH_TRUE };
 
 
 	switch_mutex_lock(XML_LOCK);
@@ -2482,13 +3783,19 @@ SWITCH_DECLARE(switch_status_t) switch_xml_destroy(void)
 		status = SWITCH_STATUS_SUCCESS;
 	}
 
+	xml_deps_destroy(&ROOT_DEPS);
+	ROOT_DEPS_TREE = NULL;
+
 	switch_mutex_unlock(XML_LOCK);
 	switch_mutex_unlock(REFLOCK);
 
-	switch_xml_clear_user_cache(NULL, NULL, NULL);
+	switch_event_unbind(&CACHE_FLUSH_NODE);
 
+	/* nobody is left to finish a load, drop the loading markers as well */
+	switch_mutex_lock(CACHE_MUTEX);
+	switch_core_hash_delete_multi(CACHE_HASH, user_cache_entry_flush, &flush);
 	switch_core_hash_destroy(&CACHE_HASH);
-	switch_core_hash_destroy(&CACHE_EXPIRES_HASH);
+	switch_mutex_unlock(CACHE_MUTEX);
 
 	return status;
 }
@@ -2851,6 +4158,8 @@ SWITCH_DECLARE(void) switch_xml_free(switch_xml_t xml)
 #if (_MSC_VER >= 1400)			// VC8+
 		__analysis_assume(sizeof(root->ent) > 44);	/* tail recursion confuses code analysis */
 #endif
+		dir_index_destroy(&root->dir_index);
+
 		for (i = 10; root->ent[i]; i += 2)	/* 0 - 9 are default entities (<>&"') */
 			if ((s = root->ent[i + 1]) < root->s || s > root->e)
 				free(s);
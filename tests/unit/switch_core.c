@@ -36,6 +36,54 @@
 #include <openssl/ssl.h>
 #endif
 
+static switch_status_t deferred_task(void *obj)
+{
+	(*(int *) obj)++;
+	return SWITCH_STATUS_SUCCESS;
+}
+
+typedef struct {
+	switch_mutex_t *mutex;
+	char order[16];
+	int loaded;
+	int active;
+	int max_active;
+} load_record_t;
+
+/* stands in for the module loader, mod_f fails to load */
+static switch_status_t record_load(const char *path, const char *name, switch_bool_t global, void *user_data)
+{
+	load_record_t *rec = (load_record_t *) user_data;
+
+	switch_mutex_lock(rec->mutex);
+	if (++rec->active > rec->max_active) {
+		rec->max_active = rec->active;
+	}
+	switch_mutex_unlock(rec->mutex);
+
+	switch_yield(100000);
+
+	switch_mutex_lock(rec->mutex);
+	rec->active--;
+	rec->order[rec->loaded++] = name[4];
+	switch_mutex_unlock(rec->mutex);
+
+	return name[4] == 'f' ? SWITCH_STATUS_GENERR : SWITCH_STATUS_SUCCESS;
+}
+
+static unsigned int load_list(const char *text, uint32_t threads, load_record_t *rec, char **failed)
+{
+	switch_xml_t xml = switch_xml_parse_str_dup((char *) text);
+	unsigned int count;
+
+	memset(rec->order, 0, sizeof(rec->order));
+	rec->loaded = rec->active = rec->max_active = 0;
+	count = switch_loadable_module_load_list(xml, threads, record_load, rec, failed);
+	switch_xml_free(xml);
+
+	return count;
+}
+
 FST_CORE_BEGIN("./conf")
 {
 	FST_SUITE_BEGIN(switch_core)
@@ -359,6 +407,147 @@ FST_CORE_BEGIN("./conf")
 			fst_requires(hash == NULL);
 		}
 		FST_TEST_END()
+
+		FST_TEST_BEGIN(test_switch_core_port_allocator)
+		{
+			switch_core_port_allocator_t *alloc = NULL;
+			switch_port_t port, first = 0;
+			uint8_t seen[100] = { 0 };
+			uint32_t used = 0, total = 0;
+			int i;
+
+			/* 50 even ports, more than one bitmap word */
+			fst_check_int_equals(switch_core_port_allocator_new("127.0.0.1", 20000, 20099, SPF_EVEN, &alloc), SWITCH_STATUS_SUCCESS);
+			fst_requires(alloc);
+
+			for (i = 0; i < 50; i++) {
+				fst_check_int_equals(switch_core_port_allocator_request_port(alloc, &port), SWITCH_STATUS_SUCCESS);
+				fst_check(port >= 20000 && port <= 20098 && !(port % 2));
+				fst_check(!seen[port - 20000]);
+				seen[port - 20000] = 1;
+				if (!first) {
+					first = port;
+				}
+			}
+
+			switch_core_port_allocator_usage(alloc, &used, &total);
+			fst_check_int_equals(used, 50);
+			fst_check_int_equals(total, 50);
+
+			/* exhausted */
+			fst_check_int_equals(switch_core_port_allocator_request_port(alloc, &port), SWITCH_STATUS_FALSE);
+			fst_check_int_equals(port, 0);
+
+			/* a freed port comes back even while it is held back from reuse, but only once */
+			fst_check_int_equals(switch_core_port_allocator_free_port(alloc, first), SWITCH_STATUS_SUCCESS);
+			fst_check_int_equals(switch_core_port_allocator_free_port(alloc, first), SWITCH_STATUS_FALSE);
+			fst_check_int_equals(switch_core_port_allocator_request_port(alloc, &port), SWITCH_STATUS_SUCCESS);
+			fst_check_int_equals(port, first);
+
+			switch_core_port_allocator_destroy(&alloc);
+			fst_requires(alloc == NULL);
+		}
+		FST_TEST_END()
+
+		FST_TEST_BEGIN(test_switch_loadable_module_timeline)
+		{
+			switch_stream_handle_t stream = { 0 };
+			int runs = 0;
+
+			/* past startup deferred work runs right away */
+			fst_check_int_equals(switch_loadable_module_defer("mod_test_defer", "deferred step", deferred_task, &runs), SWITCH_STATUS_SUCCESS);
+			fst_check_int_equals(runs, 1);
+
+			SWITCH_STANDARD_STREAM(stream);
+			switch_loadable_module_timeline(&stream);
+			fst_check_string_has((char *) stream.data, "mod_loopback");
+			fst_check_string_has((char *) stream.data, "mod_test_defer");
+			fst_check_string_has((char *) stream.data, "deferred step");
+			switch_safe_free(stream.data);
+		}
+		FST_TEST_END()
+
+		FST_TEST_BEGIN(test_switch_loadable_module_load_list)
+		{
+			load_record_t rec = { 0 };
+			char *failed = NULL;
+
+			switch_mutex_init(&rec.mutex, SWITCH_MUTEX_NESTED, fst_pool);
+
+			/* plain entries keep the file order on any number of threads */
+			fst_check_int_equals(load_list("<modules><load module=\"mod_a\"/><load module=\"mod_b\"/><load module=\"mod_c\"/></modules>",
+										   4, &rec, &failed), 3);
+			fst_check(failed == NULL);
+			fst_check_string_equals(rec.order, "abc");
+			fst_check_int_equals(rec.max_active, 1);
+
+			/* the ones that opt in load together */
+			fst_check_int_equals(load_list("<modules><load module=\"mod_a\" parallel=\"true\"/><load module=\"mod_b\" parallel=\"true\"/>"
+										   "<load module=\"mod_c\" parallel=\"true\"/></modules>", 4, &rec, &failed), 3);
+			fst_check(failed == NULL);
+			fst_check_int_equals(rec.loaded, 3);
+			fst_check_int_equals(rec.max_active, 3);
+
+			/* depends wins over the file order, a plain entry waits for everything listed before it */
+			fst_check_int_equals(load_list("<modules><load module=\"mod_c\" depends=\"mod_b\"/><load module=\"mod_b\" depends=\"mod_a\"/>"
+										   "<load module=\"mod_a\" parallel=\"true\"/><load module=\"mod_d\"/></modules>", 4, &rec, &failed), 4);
+			fst_check(failed == NULL);
+			fst_check_string_equals(rec.order, "abcd");
+
+			/* a cycle is broken in file order */
+			fst_check_int_equals(load_list("<modules><load module=\"mod_a\" depends=\"mod_b\"/><load module=\"mod_b\" depends=\"mod_a\"/></modules>",
+										   4, &rec, &failed), 2);
+			fst_check(failed == NULL);
+			fst_check_string_equals(rec.order, "ab");
+
+			/* a failed critical module cancels what did not start yet */
+			load_list("<modules><load module=\"mod_a\"/><load module=\"mod_f\" critical=\"true\"/><load module=\"mod_c\"/></modules>",
+					  4, &rec, &failed);
+			fst_check_string_equals(failed, "mod_f");
+			fst_check_string_equals(rec.order, "af");
+			switch_safe_free(failed);
+
+			/* and stops the one by one load */
+			load_list("<modules><load module=\"mod_a\"/><load module=\"mod_f\" critical=\"true\"/><load module=\"mod_c\"/></modules>",
+					  0, &rec, &failed);
+			fst_check_string_equals(failed, "mod_f");
+			fst_check_string_equals(rec.order, "af");
+			switch_safe_free(failed);
+		}
+		FST_TEST_END()
+
+		FST_TEST_BEGIN(test_switch_timer_wheels)
+		{
+			switch_timer_t timer = { 0 };
+			switch_stream_handle_t stream = { 0 };
+			switch_time_t start, elapsed;
+			uint32_t wheels = switch_time_get_timer_wheels();
+			int tfd = switch_time_get_timerfd();
+			switch_bool_t matrix = switch_time_get_matrix();
+			int i;
+
+			switch_time_set_timer_wheels(2);
+			fst_requires(switch_core_timer_init(&timer, "soft", 20, 160, fst_pool) == SWITCH_STATUS_SUCCESS);
+
+			switch_core_timer_next(&timer);
+			start = switch_time_now();
+			for (i = 0; i < 10; i++) {
+				switch_core_timer_next(&timer);
+			}
+			elapsed = (switch_time_now() - start) / 1000;
+			fst_xcheck(elapsed >= 150 && elapsed <= 300, "Expect 10 steps of a 20ms wheel timer to take about 200ms");
+
+			SWITCH_STANDARD_STREAM(stream);
+			switch_time_timer_stats(&stream, SWITCH_TRUE);
+			fst_check_string_has((char *) stream.data, "Interval 20ms: 1 timers in 2 groups");
+			switch_safe_free(stream.data);
+
+			switch_core_timer_destroy(&timer);
+			switch_time_set_timer_wheels(wheels);
+			switch_time_set_timerfd(tfd);
+			switch_time_set_matrix(matrix);
+		}
+		FST_TEST_END()
 	}
 	FST_SUITE_END()
 }
@@ -82,6 +82,30 @@ FST_CORE_DB_BEGIN("./conf")
 		}
 		FST_TEST_END()
 
+		FST_TEST_BEGIN(test_switch_cache_db_handle_pool)
+		{
+			switch_cache_db_handle_t *dbh = NULL, *dbh2 = NULL;
+			char *dsn = "test_switch_cache_db_handle_pool.db";
+			uint32_t pools = 0, handles = 0, used = 0, used_before = 0;
+			uint64_t waits = 0;
+
+			fst_requires(switch_cache_db_get_db_handle_dsn(&dbh, dsn) == SWITCH_STATUS_SUCCESS);
+			switch_cache_db_pool_totals(&pools, &handles, &used_before, &waits);
+			fst_check(pools > 0);
+			fst_check(handles > 0);
+
+			/* the handle goes back to the pool of its database and is handed out again */
+			dbh2 = dbh;
+			switch_cache_db_release_db_handle(&dbh);
+			switch_cache_db_pool_totals(&pools, &handles, &used, &waits);
+			fst_check_int_equals(used, used_before - 1);
+
+			fst_requires(switch_cache_db_get_db_handle_dsn(&dbh, dsn) == SWITCH_STATUS_SUCCESS);
+			fst_check(dbh == dbh2);
+			switch_cache_db_release_db_handle(&dbh);
+		}
+		FST_TEST_END()
+
 		FST_TEST_BEGIN(test_switch_cache_db_queue_manager_race)
 		{
 			int i;
@@ -224,6 +224,100 @@ FST_CORE_BEGIN("./conf")
 		}
 		FST_TEST_END()
 
+		FST_TEST_BEGIN(test_switch_core_file_prompt_cache)
+		{
+			switch_file_handle_t fhw = { 0 }, fh1 = { 0 }, fh2 = { 0 };
+			switch_file_interface_t *cache_interface;
+			switch_status_t status = SWITCH_STATUS_FALSE;
+			switch_stream_handle_t stream = { 0 };
+			static char filename[] = "/tmp/fs_prompt_cache_unit_test.wav";
+			int16_t buf[160], buf1[160], buf2[160];
+			switch_size_t len;
+			unsigned int pos = 0;
+			int i;
+
+			for (i = 0; i < 160; i++) {
+				buf[i] = (int16_t) (i * 100);
+			}
+
+			status = switch_core_file_open(&fhw, filename, 1, 8000, SWITCH_FILE_FLAG_WRITE | SWITCH_FILE_DATA_SHORT, NULL);
+			fst_requires(status == SWITCH_STATUS_SUCCESS);
+			for (i = 0; i < 10; i++) {
+				len = 160;
+				switch_core_file_write(&fhw, buf, &len);
+			}
+			switch_core_file_close(&fhw);
+
+			switch_core_prompt_cache_size(1024 * 1024);
+
+			status = switch_core_file_open(&fh1, filename, 1, 8000, SWITCH_FILE_FLAG_READ | SWITCH_FILE_DATA_SHORT, NULL);
+			fst_requires(status == SWITCH_STATUS_SUCCESS);
+			status = switch_core_file_open(&fh2, filename, 1, 8000, SWITCH_FILE_FLAG_READ | SWITCH_FILE_DATA_SHORT, NULL);
+			fst_requires(status == SWITCH_STATUS_SUCCESS);
+			fst_check(fh1.file_interface == fh2.file_interface);
+			fst_check(fh1.samples == 1600);
+			cache_interface = fh1.file_interface;
+
+			len = 160;
+			fst_check(switch_core_file_read(&fh1, buf1, &len) == SWITCH_STATUS_SUCCESS);
+			fst_check(len == 160);
+			len = 160;
+			fst_check(switch_core_file_read(&fh2, buf2, &len) == SWITCH_STATUS_SUCCESS);
+			fst_check(len == 160);
+			fst_check(!memcmp(buf, buf1, sizeof(buf)));
+			fst_check(!memcmp(buf1, buf2, sizeof(buf1)));
+
+			fst_check(switch_core_file_seek(&fh2, &pos, 1580, SEEK_SET) == SWITCH_STATUS_SUCCESS);
+			fst_check(pos == 1580);
+			len = 160;
+			fst_check(switch_core_file_read(&fh2, buf2, &len) == SWITCH_STATUS_SUCCESS);
+			fst_check(len == 20);
+
+			SWITCH_STANDARD_STREAM(stream);
+			switch_core_prompt_cache_status(&stream);
+			fst_check(switch_stristr(filename, stream.data) != NULL);
+			fst_check(switch_stristr("Hits: 1", stream.data) != NULL);
+			switch_safe_free(stream.data);
+
+			/* in-use entries are only unindexed, readers keep their data */
+			fst_check(switch_core_prompt_cache_flush(filename) == 1);
+			len = 160;
+			fst_check(switch_core_file_read(&fh1, buf1, &len) == SWITCH_STATUS_SUCCESS);
+			fst_check(!memcmp(buf, buf1, sizeof(buf)));
+
+			switch_core_file_close(&fh1);
+			switch_core_file_close(&fh2);
+
+			/* a prompt over the budget is decoded once, then played from disk until it changes or the budget does */
+			switch_core_prompt_cache_size(1024);
+
+			for (i = 0; i < 2; i++) {
+				memset(&fh1, 0, sizeof(fh1));
+				status = switch_core_file_open(&fh1, filename, 1, 8000, SWITCH_FILE_FLAG_READ | SWITCH_FILE_DATA_SHORT, NULL);
+				fst_requires(status == SWITCH_STATUS_SUCCESS);
+				fst_check(fh1.file_interface != cache_interface);
+				switch_core_file_close(&fh1);
+			}
+
+			SWITCH_STANDARD_STREAM(stream);
+			switch_core_prompt_cache_status(&stream);
+			fst_check(switch_stristr("1 skipped, 1 rejected", stream.data) != NULL);
+			switch_safe_free(stream.data);
+
+			switch_core_prompt_cache_size(1024 * 1024);
+			memset(&fh1, 0, sizeof(fh1));
+			status = switch_core_file_open(&fh1, filename, 1, 8000, SWITCH_FILE_FLAG_READ | SWITCH_FILE_DATA_SHORT, NULL);
+			fst_requires(status == SWITCH_STATUS_SUCCESS);
+			fst_check(fh1.file_interface == cache_interface);
+			switch_core_file_close(&fh1);
+
+			/* a path the cached one starts with is another file */
+			fst_check(switch_core_prompt_cache_flush(switch_core_strndup(fst_pool, filename, strlen(filename) - 4)) == 0);
+			fst_check(switch_core_prompt_cache_flush(filename) == 1);
+
+			unlink(filename);
+		}
+		FST_TEST_END()
 	}
 	FST_SUITE_END()
 }
@@ -31,6 +31,70 @@
 #include <switch.h>
 #include <test/switch_test.h>
 
+static switch_bool_t media_bug_ring_callback(switch_media_bug_t *bug, void *user_data, switch_abc_type_t type)
+{
+	return SWITCH_TRUE;
+}
+
+static uint32_t video_encode_seen[8];
+static volatile int video_encode_seen_count = 0;
+
+static switch_status_t video_encode_step(switch_core_session_t *session, switch_frame_t *frame)
+{
+	if (!frame->img) {
+		return SWITCH_STATUS_FALSE;
+	}
+	frame->datalen = 1;
+	return SWITCH_STATUS_SUCCESS;
+}
+
+static switch_status_t video_encode_record(switch_core_session_t *session, switch_frame_t *packets, uint32_t count, switch_io_flag_t flags, int stream_id)
+{
+	if (count == 1 && video_encode_seen_count < 8) {
+		video_encode_seen[video_encode_seen_count] = packets[0].timestamp;
+		video_encode_seen_count++;
+	}
+	return SWITCH_STATUS_SUCCESS;
+}
+
+/* packets written to the session, from the pool or inline */
+static volatile uint32_t video_write_packets = 0;
+static volatile uint32_t video_write_last_ts = 0;
+static volatile int video_write_backwards = 0;
+
+static switch_status_t video_write_record(switch_core_session_t *session, switch_frame_t *frame, switch_io_flag_t flags, int stream_id)
+{
+	if (frame->timestamp < video_write_last_ts) {
+		video_write_backwards = 1;
+	}
+	video_write_last_ts = frame->timestamp;
+	video_write_packets++;
+	return SWITCH_STATUS_SUCCESS;
+}
+
+static int video_write_frames(switch_core_session_t *session, uint32_t *ts, int count)
+{
+	int i, ok = 0;
+
+	for (i = 0; i < count; i++) {
+		switch_frame_t frame = { 0 };
+		switch_rgb_color_t color = { 0 };
+
+		color.r = (uint8_t) (*ts * 37);
+		color.g = (uint8_t) (*ts * 11);
+		frame.img = switch_img_alloc(NULL, SWITCH_IMG_FMT_I420, 320, 240, 1);
+		switch_img_fill(frame.img, 0, 0, 320, 240, &color);
+		*ts += 3000;
+		frame.timestamp = *ts;
+		frame.flags = SFF_USE_VIDEO_TIMESTAMP;
+		if (switch_core_session_write_video_frame(session, &frame, SWITCH_IO_FLAG_FORCE, 0) == SWITCH_STATUS_SUCCESS) {
+			ok++;
+		}
+		switch_img_free(&frame.img);
+	}
+
+	return ok;
+}
 
 FST_CORE_BEGIN("./conf")
 {
@@ -71,6 +135,187 @@ FST_CORE_BEGIN("./conf")
 			fst_check(session == NULL);
 		}
 		FST_SESSION_END()
+
+		FST_SESSION_BEGIN(session_table_snapshot)
+		{
+			switch_console_callback_match_t *matches;
+			switch_console_callback_match_node_t *m;
+			switch_core_session_t *session;
+			char new_uuid[SWITCH_UUID_FORMATTED_LENGTH + 1];
+			int found = 0;
+
+			fst_check(switch_core_session_set_external_id(fst_session, "snapshot-ext") == SWITCH_STATUS_SUCCESS);
+
+			/* listed once under its uuid even though the external id points at it too */
+			matches = switch_core_session_findall();
+			fst_requires(matches);
+			for (m = matches->head; m; m = m->next) {
+				fst_check_string_not_equals(m->val, "snapshot-ext");
+				if (!strcmp(m->val, switch_core_session_get_uuid(fst_session))) {
+					found++;
+				}
+			}
+			fst_check_int_equals(found, 1);
+			switch_console_free_matches(&matches);
+
+			switch_uuid_str(new_uuid, sizeof(new_uuid));
+			fst_check(switch_core_session_set_uuid(fst_session, new_uuid) == SWITCH_STATUS_SUCCESS);
+			session = switch_core_session_locate(new_uuid);
+			fst_requires(session == fst_session);
+			switch_core_session_rwunlock(session);
+			session = switch_core_session_locate("snapshot-ext");
+			fst_requires(session == fst_session);
+			switch_core_session_rwunlock(session);
+		}
+		FST_SESSION_END()
+
+		FST_SESSION_BEGIN(session_media_bug_ring)
+		{
+			switch_media_bug_t *bug = NULL, *wide_bug = NULL;
+			switch_media_bug_stats_t stats = { 0 };
+			switch_size_t readp = 0, writep = 0;
+			uint8_t data[SWITCH_RECOMMENDED_BUFFER_SIZE];
+			switch_frame_t frame = { 0 };
+			int frames = 0;
+
+			fst_requires(switch_core_media_bug_add(fst_session, "test", NULL, media_bug_ring_callback, NULL, 0, SMBF_WRITE_STREAM, &bug) == SWITCH_STATUS_SUCCESS);
+			fst_requires(switch_core_media_bug_add(fst_session, "test_wide", NULL, media_bug_ring_callback, NULL, 0, SMBF_WRITE_STREAM, &wide_bug) == SWITCH_STATUS_SUCCESS);
+			switch_core_media_bug_set_rate(wide_bug, 16000);
+
+			switch_ivr_play_file(fst_session, NULL, "tone_stream://%(500,0,400)", NULL);
+
+			/* both bugs see the same frames and nobody read them yet */
+			switch_core_media_bug_inuse(bug, &readp, &writep);
+			fst_check(readp == 0);
+			fst_check(writep >= 320 * 20);
+			switch_core_media_bug_get_stats(bug, &stats);
+			fst_check(stats.write_lag_bytes == writep);
+			fst_check(stats.write_lag_frames >= 20);
+			fst_check(stats.write_overruns == 0);
+			switch_core_media_bug_get_stats(wide_bug, &stats);
+			fst_check(stats.write_lag_bytes == writep);
+
+			frame.data = data;
+			frame.buflen = sizeof(data);
+
+			while (switch_core_media_bug_read(bug, &frame, SWITCH_FALSE) == SWITCH_STATUS_SUCCESS) {
+				fst_check(frame.rate == 8000);
+				fst_check(frame.datalen == 320);
+				frames++;
+			}
+
+			fst_check(frames > 0);
+			switch_core_media_bug_get_stats(bug, &stats);
+			fst_check(stats.write_lag_frames == 0);
+
+			/* reading one bug leaves the other untouched */
+			switch_core_media_bug_get_stats(wide_bug, &stats);
+			fst_check(stats.write_lag_bytes == writep);
+
+			fst_check(switch_core_media_bug_read(wide_bug, &frame, SWITCH_FALSE) == SWITCH_STATUS_SUCCESS);
+			fst_check(frame.rate == 16000);
+			fst_check(frame.samples > 160);
+			fst_check(frame.datalen == frame.samples * 2);
+
+			switch_core_media_bug_flush(wide_bug);
+			switch_core_media_bug_get_stats(wide_bug, &stats);
+			fst_check(stats.write_lag_bytes == 0);
+
+			switch_core_media_bug_remove(fst_session, &wide_bug);
+			switch_core_media_bug_remove(fst_session, &bug);
+		}
+		FST_SESSION_END()
+		FST_SESSION_BEGIN(video_encode_pool_order)
+		{
+			switch_frame_t frame = { 0 };
+			uint32_t i;
+			int waited = 0;
+
+			fst_requires(switch_core_video_encode_pool_start(2, 8, SWITCH_FALSE) == SWITCH_STATUS_SUCCESS);
+			fst_check(switch_core_video_encode_pool_active());
+
+			for (i = 0; i < 8; i++) {
+				switch_image_t *img = switch_img_alloc(NULL, SWITCH_IMG_FMT_I420, 16, 16, 1);
+
+				frame.timestamp = i;
+				fst_check(switch_core_video_encode_pool_submit(fst_session, &frame, &img, SWITCH_IO_FLAG_NONE, 0,
+																	video_encode_step, video_encode_record) == SWITCH_STATUS_SUCCESS);
+				fst_check(img == NULL);
+			}
+
+			while (video_encode_seen_count < 8 && waited++ < 200) {
+				switch_yield(10000);
+			}
+
+			/* two workers, one lane: frames still come out in submit order */
+			fst_requires(video_encode_seen_count == 8);
+			for (i = 0; i < 8; i++) {
+				fst_check(video_encode_seen[i] == i);
+			}
+
+			switch_core_video_encode_pool_stop();
+			fst_check(!switch_core_video_encode_pool_active());
+		}
+		FST_SESSION_END()
+
+		FST_SESSION_BEGIN_RATE_VIDEO(video_encode_pool_write_video_frame, 8000, "VP8")
+		{
+			switch_codec_t codec = { 0 };
+			switch_codec_settings_t codec_settings = {{ 0 }};
+			uint64_t submitted, encoded, dropped, submitted0, encoded0, dropped0;
+			uint32_t ts = 0, packets;
+			int waited = 0;
+
+			codec_settings.video.width = 320;
+			codec_settings.video.height = 240;
+			fst_requires(switch_core_codec_init(&codec, "VP8", NULL, NULL, 90000, 0, 1, SWITCH_CODEC_FLAG_ENCODE | SWITCH_CODEC_FLAG_DECODE,
+												&codec_settings, fst_pool) == SWITCH_STATUS_SUCCESS);
+			fst_requires(switch_core_session_set_video_write_codec(fst_session, &codec) == SWITCH_STATUS_SUCCESS);
+			switch_core_event_hook_add_video_write_frame(fst_session, video_write_record);
+
+			/* one frame pending at most, writing faster than vp8 encodes drops the oldest ones */
+			fst_requires(switch_core_video_encode_pool_start(1, 1, SWITCH_FALSE) == SWITCH_STATUS_SUCCESS);
+			switch_core_video_encode_pool_counters(&submitted0, &encoded0, &dropped0);
+
+			fst_check(video_write_frames(fst_session, &ts, 30) == 30);
+
+			do {
+				switch_yield(10000);
+				switch_core_video_encode_pool_counters(&submitted, &encoded, &dropped);
+			} while (submitted - submitted0 > (encoded - encoded0) + (dropped - dropped0) && waited++ < 500);
+
+			fst_check(submitted - submitted0 == 30);
+			fst_check((encoded - encoded0) + (dropped - dropped0) == 30);
+			fst_check(dropped - dropped0 > 0);
+			fst_check(encoded - encoded0 > 0);
+			fst_check(video_write_packets > 0);
+			fst_check(!video_write_backwards);
+
+			/* take the writes over with frames still queued, none of them may go out after ours */
+			fst_check(video_write_frames(fst_session, &ts, 10) == 10);
+			switch_core_media_lock_video_write(fst_session);
+
+			switch_core_video_encode_pool_counters(&submitted0, &encoded0, &dropped0);
+			fst_check(submitted0 == encoded0 + dropped0);
+			packets = video_write_packets;
+
+			fst_check(video_write_frames(fst_session, &ts, 5) == 5);
+			fst_check(video_write_packets > packets);
+
+			switch_yield(100000);
+			switch_core_video_encode_pool_counters(&submitted, &encoded, &dropped);
+			fst_check(submitted == submitted0);
+			fst_check(encoded == encoded0);
+
+			switch_core_media_unlock_video_write(fst_session);
+			fst_check(!video_write_backwards);
+
+			switch_core_video_encode_pool_stop();
+			switch_core_event_hook_remove_video_write_frame(fst_session, video_write_record);
+			switch_core_session_set_video_write_codec(fst_session, NULL);
+			switch_core_codec_destroy(&codec);
+		}
+		FST_SESSION_END()
 	}
 	FST_SUITE_END()
 }
@@ -34,6 +34,230 @@
 
 #include <test/switch_test.h>
 
+// #define BENCHMARK 1
+
+#ifdef SWITCH_HAVE_YUV
+static const char *img_impls[] = { "scalar", "sse2", "avx2" };
+
+/* frames per image kernel benchmark run */
+#define IMG_BENCH_FRAMES 50
+
+/* the per pixel loops switch_img_patch and switch_img_overlay used before the blend kernels, kept as the reference */
+#ifndef MIN
+#define MIN(a,b) ((a) < (b) ? (a) : (b))
+#endif
+#ifndef MAX
+#define MAX(a,b) ((a) > (b) ? (a) : (b))
+#endif
+#define LEGACY_CLAMP(val) MAX(0, MIN(val, 255))
+
+static void legacy_rgb2yuv(switch_rgb_color_t *rgb, switch_yuv_color_t *yuv)
+{
+	yuv->y = ( (  66 * rgb->r + 129 * rgb->g +  25 * rgb->b + 128) >> 8) +  16;
+	yuv->u = ( ( -38 * rgb->r -  74 * rgb->g + 112 * rgb->b + 128) >> 8) + 128;
+	yuv->v = ( ( 112 * rgb->r -  94 * rgb->g -  18 * rgb->b + 128) >> 8) + 128;
+}
+
+static void legacy_yuv2rgb(switch_yuv_color_t *yuv, switch_rgb_color_t *rgb)
+{
+	rgb->a = 255;
+	rgb->r = LEGACY_CLAMP( yuv->y + ((22457 * (yuv->v-128)) >> 14));
+	rgb->g = LEGACY_CLAMP((yuv->y - ((715   * (yuv->v-128)) >> 10) - ((5532 * (yuv->u-128)) >> 14)));
+	rgb->b = LEGACY_CLAMP((yuv->y + ((28384 * (yuv->u-128)) >> 14)));
+}
+
+static void legacy_draw_pixel(switch_image_t *img, int x, int y, switch_rgb_color_t *color)
+{
+	switch_yuv_color_t yuv = {0};
+
+	if (x < 0 || y < 0 || x >= img->d_w || y >= img->d_h) return;
+
+	legacy_rgb2yuv(color, &yuv);
+
+	img->planes[SWITCH_PLANE_Y][y * img->stride[SWITCH_PLANE_Y] + x] = yuv.y;
+
+	if (((x & 0x1) == 0) && ((y & 0x1) == 0)) {
+		img->planes[SWITCH_PLANE_U][y / 2 * img->stride[SWITCH_PLANE_U] + x / 2] = yuv.u;
+		img->planes[SWITCH_PLANE_V][y / 2 * img->stride[SWITCH_PLANE_V] + x / 2] = yuv.v;
+	}
+}
+
+static void legacy_get_rgb_pixel(switch_image_t *img, switch_rgb_color_t *rgb, int x, int y)
+{
+	if (x < 0 || y < 0 || x >= img->d_w || y >= img->d_h) return;
+
+	if (img->fmt == SWITCH_IMG_FMT_I420) {
+		switch_yuv_color_t yuv = {0};
+
+		yuv.y = *(img->planes[SWITCH_PLANE_Y] + img->stride[SWITCH_PLANE_Y] * y + x);
+		yuv.u = *(img->planes[SWITCH_PLANE_U] + img->stride[SWITCH_PLANE_U] * (y / 2) + x / 2);
+		yuv.v = *(img->planes[SWITCH_PLANE_V] + img->stride[SWITCH_PLANE_V] * (y / 2) + x / 2);
+		legacy_yuv2rgb(&yuv, rgb);
+	} else if (img->fmt == SWITCH_IMG_FMT_ARGB) {
+		*rgb = *((switch_rgb_color_t *)img->planes[SWITCH_PLANE_PACKED] + img->d_w * y + x);
+	}
+}
+
+/* ARGB onto I420 */
+static void legacy_img_patch(switch_image_t *IMG, switch_image_t *img, int x, int y)
+{
+	int max_w = MIN(img->d_w, IMG->d_w - abs(x));
+	int max_h = MIN(img->d_h, IMG->d_h - abs(y));
+	int i, j;
+	uint8_t alpha;
+	switch_rgb_color_t *rgb;
+
+	for (i = 0; i < max_h; i++) {
+		for (j = 0; j < max_w; j++) {
+			rgb = (switch_rgb_color_t *)(img->planes[SWITCH_PLANE_PACKED] + i * img->stride[SWITCH_PLANE_PACKED] + j * 4);
+			alpha = rgb->a;
+
+			if (alpha == 255) {
+				legacy_draw_pixel(IMG, x + j, y + i, rgb);
+			} else if (alpha != 0) {
+				switch_rgb_color_t RGB = { 0 };
+
+				legacy_get_rgb_pixel(IMG, &RGB, x + j, y + i);
+				RGB.a = 255;
+				RGB.r = ((RGB.r * (255 - alpha)) >> 8) + ((rgb->r * alpha) >> 8);
+				RGB.g = ((RGB.g * (255 - alpha)) >> 8) + ((rgb->g * alpha) >> 8);
+				RGB.b = ((RGB.b * (255 - alpha)) >> 8) + ((rgb->b * alpha) >> 8);
+
+				legacy_draw_pixel(IMG, x + j, y + i, &RGB);
+			}
+		}
+	}
+}
+
+static void legacy_img_overlay(switch_image_t *IMG, switch_image_t *img, int x, int y, uint8_t percent)
+{
+	int i, j, len, max_h;
+	switch_rgb_color_t RGB = {0}, rgb = {0}, c = {0};
+	int xoff = 0, yoff = 0;
+	uint8_t alpha = (int8_t)((255 * percent) / 100);
+
+	if (x < 0) {
+		xoff = -x;
+		x = 0;
+	}
+
+	if (y < 0) {
+		yoff = -y;
+		y = 0;
+	}
+
+	max_h = MIN(y + img->d_h - yoff, IMG->d_h);
+	len = MIN(img->d_w - xoff, IMG->d_w - x);
+
+	if (x & 1) { x++; len--; }
+	if (y & 1) y++;
+	if (len <= 0) return;
+
+	for (i = y; i < max_h; i++) {
+		for (j = 0; j < len; j++) {
+			legacy_get_rgb_pixel(IMG, &RGB, x + j, i);
+			legacy_get_rgb_pixel(img, &rgb, j + xoff, i - y + yoff);
+
+			if (rgb.a > 0) {
+				c.r = ((RGB.r * (255 - alpha)) >> 8) + ((rgb.r * alpha) >> 8);
+				c.g = ((RGB.g * (255 - alpha)) >> 8) + ((rgb.g * alpha) >> 8);
+				c.b = ((RGB.b * (255 - alpha)) >> 8) + ((rgb.b * alpha) >> 8);
+			} else {
+				c.r = RGB.r;
+				c.g = RGB.g;
+				c.b = RGB.b;
+			}
+
+			legacy_draw_pixel(IMG, x + j, i, &c);
+		}
+	}
+}
+
+static void img_fill_noise(switch_image_t *img)
+{
+	int plane, planes = img->fmt == SWITCH_IMG_FMT_ARGB ? 1 : 3;
+	uint32_t row, col;
+
+	for (plane = 0; plane < planes; plane++) {
+		uint32_t w = img->fmt == SWITCH_IMG_FMT_ARGB ? img->d_w * 4 : plane ? (img->d_w + 1) / 2 : img->d_w;
+		uint32_t h = plane ? (img->d_h + 1) / 2 : img->d_h;
+
+		for (row = 0; row < h; row++) {
+			for (col = 0; col < w; col++) {
+				img->planes[plane][row * img->stride[plane] + col] = rand();
+			}
+		}
+	}
+
+	if (img->fmt == SWITCH_IMG_FMT_ARGB) {
+		/* a third fully transparent, a third solid, the rest in between */
+		for (row = 0; row < img->d_h; row++) {
+			for (col = 0; col < img->d_w; col++) {
+				switch_rgb_color_t *rgb = (switch_rgb_color_t *)(img->planes[SWITCH_PLANE_PACKED] + row * img->stride[SWITCH_PLANE_PACKED] + col * 4);
+				int r = rand() % 3;
+
+				if (r == 0) rgb->a = 0;
+				else if (r == 1) rgb->a = 255;
+			}
+		}
+	}
+}
+
+static switch_bool_t img_equals(switch_image_t *a, switch_image_t *b)
+{
+	int plane, planes = a->fmt == SWITCH_IMG_FMT_ARGB ? 1 : 3;
+	uint32_t row;
+
+	for (plane = 0; plane < planes; plane++) {
+		uint32_t w = a->fmt == SWITCH_IMG_FMT_ARGB ? a->d_w * 4 : plane ? (a->d_w + 1) / 2 : a->d_w;
+		uint32_t h = plane ? (a->d_h + 1) / 2 : a->d_h;
+
+		for (row = 0; row < h; row++) {
+			if (memcmp(a->planes[plane] + row * a->stride[plane], b->planes[plane] + row * b->stride[plane], w)) {
+				return SWITCH_FALSE;
+			}
+		}
+	}
+
+	return SWITCH_TRUE;
+}
+
+#ifdef BENCHMARK
+static void img_bench(const char *what, int w, int h)
+{
+	switch_image_t *canvas = switch_img_alloc(NULL, SWITCH_IMG_FMT_I420, w, h, 1);
+	switch_image_t *layer = switch_img_alloc(NULL, SWITCH_IMG_FMT_ARGB, w, h, 1);
+	int k, x;
+
+	img_fill_noise(canvas);
+	img_fill_noise(layer);
+
+	for (k = 0; k < (int) (sizeof(img_impls) / sizeof(img_impls[0])); k++) {
+		switch_time_t start;
+
+		if (switch_img_simd_set_impl(img_impls[k]) != SWITCH_STATUS_SUCCESS) {
+			continue;
+		}
+
+		start = switch_time_now();
+		for (x = 0; x < IMG_BENCH_FRAMES; x++) {
+			switch_img_patch(canvas, layer, 0, 0);
+		}
+		printf("%-8s %s patch   %.3fms per frame\n", img_impls[k], what, (double) (switch_time_now() - start) / IMG_BENCH_FRAMES / 1000);
+
+		start = switch_time_now();
+		for (x = 0; x < IMG_BENCH_FRAMES; x++) {
+			switch_img_overlay(canvas, layer, 0, 0, 50);
+		}
+		printf("%-8s %s overlay %.3fms per frame\n", img_impls[k], what, (double) (switch_time_now() - start) / IMG_BENCH_FRAMES / 1000);
+	}
+
+	switch_img_free(&canvas);
+	switch_img_free(&layer);
+}
+#endif
+#endif
+
 FST_CORE_BEGIN("./conf")
 {
 	FST_SUITE_BEGIN(switch_core_video)
@@ -324,6 +548,136 @@ FST_CORE_BEGIN("./conf")
 			unlink(jpg_write_filename);
 		}
 		FST_TEST_END()
+		FST_TEST_BEGIN(img_simd_matches_scalar)
+		{
+			int round, k;
+
+			srand(1234);
+
+			for (round = 0; round < 30; round++) {
+				int w = 1 + rand() % 300, h = 1 + rand() % 100;
+				int x = rand() % 200 - 40, y = rand() % 80 - 20;
+				uint8_t percent = rand() % 101;
+				/* every third round overlays an I420 image, which goes through the ARGB conversion blocks */
+				switch_img_fmt_t fmt = round % 3 == 2 ? SWITCH_IMG_FMT_I420 : SWITCH_IMG_FMT_ARGB;
+				switch_image_t *canvas = switch_img_alloc(NULL, SWITCH_IMG_FMT_I420, 320, 180, 1);
+				switch_image_t *layer = switch_img_alloc(NULL, fmt, w, h, 1);
+				switch_image_t *patched = NULL, *overlaid = NULL;
+				/* the old overlay loop redrew the whole canvas through a lossy color round trip when the layer was entirely off it */
+				switch_bool_t visible = !(x < 0 && -x >= w) && !(y < 0 && -y >= h);
+
+				img_fill_noise(canvas);
+				img_fill_noise(layer);
+
+				if (fmt == SWITCH_IMG_FMT_ARGB) {
+					switch_img_copy(canvas, &patched);
+					legacy_img_patch(patched, layer, x, y);
+				}
+				switch_img_copy(canvas, &overlaid);
+				legacy_img_overlay(overlaid, layer, x, y, percent);
+
+				for (k = 0; k < (int) (sizeof(img_impls) / sizeof(img_impls[0])); k++) {
+					switch_image_t *tmp = NULL;
+
+					if (switch_img_simd_set_impl(img_impls[k]) != SWITCH_STATUS_SUCCESS) {
+						continue;
+					}
+
+					fst_check_string_equals(switch_img_simd_impl_name(), img_impls[k]);
+
+					if (patched) {
+						switch_img_copy(canvas, &tmp);
+						switch_img_patch(tmp, layer, x, y);
+						fst_check(img_equals(tmp, patched));
+						switch_img_free(&tmp);
+					}
+
+					if (visible) {
+						switch_img_copy(canvas, &tmp);
+						switch_img_overlay(tmp, layer, x, y, percent);
+						fst_check(img_equals(tmp, overlaid));
+						switch_img_free(&tmp);
+					}
+				}
+
+				switch_img_free(&canvas);
+				switch_img_free(&layer);
+				switch_img_free(&patched);
+				switch_img_free(&overlaid);
+			}
+
+			switch_img_simd_set_impl("auto");
+		}
+		FST_TEST_END()
+
+		FST_TEST_BEGIN(chromakey_simd_matches_scalar)
+		{
+			switch_image_t *frames[4] = { 0 }, *ref = NULL;
+			switch_rgb_color_t green = { 0 };
+			int i, k;
+
+			green.g = 255;
+			green.a = 255;
+
+			srand(4321);
+			frames[0] = switch_img_alloc(NULL, SWITCH_IMG_FMT_ARGB, 333, 77, 1);
+			img_fill_noise(frames[0]);
+
+			/* later frames jitter a little so most pixels hit the cache */
+			for (i = 1; i < 4; i++) {
+				uint32_t p;
+
+				switch_img_copy(frames[0], &frames[i]);
+				for (p = 0; p < frames[i]->d_w * frames[i]->d_h * 4; p++) {
+					frames[i]->planes[SWITCH_PLANE_PACKED][p] += rand() % 3;
+				}
+			}
+
+			for (k = 0; k < (int) (sizeof(img_impls) / sizeof(img_impls[0])); k++) {
+				switch_chromakey_t *ck = NULL;
+				switch_image_t *tmp = NULL;
+
+				if (switch_img_simd_set_impl(img_impls[k]) != SWITCH_STATUS_SUCCESS) {
+					continue;
+				}
+
+				switch_chromakey_create(&ck);
+				switch_chromakey_add_color(ck, &green, 300);
+
+				for (i = 0; i < 4; i++) {
+					switch_img_free(&tmp);
+					switch_img_copy(frames[i], &tmp);
+					switch_chromakey_process(ck, tmp);
+				}
+
+				if (!ref) {
+					ref = tmp;
+					tmp = NULL;
+				} else {
+					fst_check(img_equals(tmp, ref));
+				}
+
+				switch_img_free(&tmp);
+				switch_chromakey_destroy(&ck);
+			}
+
+			for (i = 0; i < 4; i++) {
+				switch_img_free(&frames[i]);
+			}
+			switch_img_free(&ref);
+			switch_img_simd_set_impl("auto");
+		}
+		FST_TEST_END()
+
+#ifdef BENCHMARK
+		FST_TEST_BEGIN(benchmark_img_blend)
+		{
+			img_bench("720p ", 1280, 720);
+			img_bench("1080p", 1920, 1080);
+			switch_img_simd_set_impl("auto");
+		}
+		FST_TEST_END()
+#endif
 #endif /* SWITCH_HAVE_YUV */
 	}
 	FST_SUITE_END()
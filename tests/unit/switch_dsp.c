@@ -0,0 +1,412 @@
+/*
+ * FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ * Copyright (C) 2005-2014, Anthony Minessale II <anthm@freeswitch.org>
+ *
+ * Version: MPL 1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License Version
+ * 1.1 (the "License"); you may not use this file except in compliance with
+ * the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+ * for the specific language governing rights and limitations under the
+ * License.
+ *
+ * The Original Code is FreeSWITCH Modular Media Switching Software Library / Soft-Switch Application
+ *
+ * The Initial Developer of the Original Code is
+ * Anthony Minessale II <anthm@freeswitch.org>
+ * Portions created by the Initial Developer are Copyright (C)
+ * the Initial Developer. All Rights Reserved.
+ *
+ * Contributor(s):
+ *
+ *
+ * switch_dsp.c -- DSP primitive tests, checked against the loops they replaced
+ *
+ */
+#include <switch.h>
+#include <stdlib.h>
+
+#include <test/switch_test.h>
+
+// #define BENCHMARK 1
+
+/* frames per benchmark run, 20ms of 16kHz mono each */
+#define BENCH_FRAMES 200000
+#define BENCH_SAMPLES 320
+
+static const char *impls[] = { "scalar", "sse2", "avx2" };
+
+/* the per frame loops as they were written before switch_dsp */
+
+static uint32_t legacy_energy(const int16_t *data, uint32_t samples, uint32_t stride)
+{
+	uint32_t energy = 0, count, j = 0;
+
+	for (count = 0; count < samples; count++) {
+		energy += abs(data[j]);
+		j += stride;
+	}
+
+	return energy;
+}
+
+static void legacy_gain(int16_t *data, uint32_t samples, double newrate)
+{
+	int32_t tmp;
+	uint32_t x;
+
+	for (x = 0; x < samples; x++) {
+		tmp = (int32_t) (data[x] * newrate);
+		switch_normalize_to_16bit(tmp);
+		data[x] = (int16_t) tmp;
+	}
+}
+
+static void legacy_mix(int16_t *data, const int16_t *other, uint32_t samples)
+{
+	uint32_t x;
+	int32_t z;
+
+	for (x = 0; x < samples; x++) {
+		z = data[x] + other[x];
+		switch_normalize_to_16bit(z);
+		data[x] = (int16_t) z;
+	}
+}
+
+static void fill_noise(int16_t *buf, uint32_t samples)
+{
+	uint32_t i;
+
+	for (i = 0; i < samples; i++) {
+		switch (rand() % 8) {
+		case 0:
+			buf[i] = -32768;
+			break;
+		case 1:
+			buf[i] = 32767;
+			break;
+		default:
+			buf[i] = (int16_t) (rand() - RAND_MAX / 2);
+		}
+	}
+}
+
+#ifdef BENCHMARK
+static double bench_us(switch_time_t start)
+{
+	return (double) (switch_time_now() - start) / BENCH_FRAMES;
+}
+#endif
+
+/* a stack of call progress, fax and dtmf style tone specs, kept further apart than
+   the ~80Hz a 12.75ms detection block can resolve so none of them trips another */
+#define TONE_SPECS 10
+static const double tone_specs[TONE_SPECS][3] = {
+	{ 350, 440 }, { 480, 620 }, { 1100 }, { 2100 }, { 913.8, 1370.6, 1776.7 }, { 2600 }, { 697, 1209 }, { 852, 1477 }, { 3000 }, { 1650, 2400 }
+};
+static const uint32_t tone_spec_freqs[TONE_SPECS] = { 2, 2, 1, 1, 3, 1, 2, 2, 1, 2 };
+
+/* 20ms of tone spec number "spec" with a little noise on top, pos carries the phase across frames */
+static void next_tone_frame(int16_t *buf, uint32_t samples, uint32_t rate, int spec, uint32_t *pos)
+{
+	uint32_t i, f;
+
+	for (i = 0; i < samples; i++, (*pos)++) {
+		double v = (rand() % 200) - 100;
+
+		for (f = 0; spec >= 0 && f < tone_spec_freqs[spec]; f++) {
+			v += 6000.0 * sin(2.0 * M_PI * tone_specs[spec][f] * *pos / rate);
+		}
+
+		buf[i] = (int16_t) v;
+	}
+}
+
+static switch_dsp_tone_bank_t *tone_bank_create(uint32_t rate, switch_memory_pool_t *pool)
+{
+	switch_dsp_tone_bank_t *bank = NULL;
+	int spec;
+
+	switch_dsp_tone_bank_create(&bank, rate, pool);
+
+	for (spec = 0; spec < TONE_SPECS; spec++) {
+		switch_dsp_tone_bank_add(bank, tone_specs[spec], tone_spec_freqs[spec]);
+	}
+
+	return bank;
+}
+
+FST_MINCORE_BEGIN("./conf")
+{
+	FST_SUITE_BEGIN(switch_dsp)
+	{
+		FST_SETUP_BEGIN()
+		{
+			srand(1234);
+		}
+		FST_SETUP_END()
+
+		FST_TEARDOWN_BEGIN()
+		{
+			switch_dsp_set_impl("auto");
+		}
+		FST_TEARDOWN_END()
+
+		FST_TEST_BEGIN(test_switch_dsp_matches_legacy)
+		{
+			int16_t data[1031], a[1031], b[1031];
+			int32_t wide[1031];
+			int k, round;
+
+			for (k = 0; k < (int) (sizeof(impls) / sizeof(impls[0])); k++) {
+				if (switch_dsp_set_impl(impls[k]) != SWITCH_STATUS_SUCCESS) {
+					switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_NOTICE, "%s not supported on this cpu, skipping\n", impls[k]);
+					continue;
+				}
+
+				fst_check_string_equals(switch_dsp_impl_name(), impls[k]);
+
+				for (round = 0; round < 50; round++) {
+					uint32_t samples = 1 + rand() % 1024, stride, i, peak = 0, zc = 0;
+					double gain = (rand() % 2000) / 100.0;
+
+					fill_noise(data, sizeof(data) / sizeof(data[0]));
+					fill_noise(b, sizeof(b) / sizeof(b[0]));
+
+					for (stride = 1; stride <= 3; stride++) {
+						uint32_t n = (samples - 1) / stride + 1;
+						fst_check(switch_dsp_energy(data + stride - 1, n - (stride > 1), stride) ==
+								  legacy_energy(data + stride - 1, n - (stride > 1), stride));
+					}
+
+					for (i = 0; i < samples; i++) {
+						if ((uint32_t) abs(data[i]) > peak) peak = abs(data[i]);
+						if (i && (data[i] < 0) != (data[i - 1] < 0)) zc++;
+						wide[i] = (rand() % 200000) - 100000;
+					}
+
+					fst_check_int_equals(switch_dsp_peak(data, samples, 1), peak);
+					fst_check_int_equals(switch_dsp_zero_crossings(data, samples, 1), zc);
+
+					memcpy(a, data, sizeof(a));
+					legacy_gain(a, samples, gain);
+					switch_dsp_gain(data, samples, gain);
+					fst_check(!memcmp(a, data, samples * sizeof(int16_t)));
+
+					legacy_mix(a, b, samples);
+					switch_dsp_mix(data, b, samples);
+					fst_check(!memcmp(a, data, samples * sizeof(int16_t)));
+
+					switch_dsp_clamp_to_16bit(wide, data, samples);
+					for (i = 0; i < samples; i++) {
+						int32_t z = wide[i];
+						switch_normalize_to_16bit(z);
+						if (data[i] != z) break;
+					}
+					fst_check_int_equals(i, samples);
+				}
+			}
+		}
+		FST_TEST_END()
+
+		FST_TEST_BEGIN(test_switch_dsp_goertzel_bank)
+		{
+			/* the dtmf row and column frequencies, 8kHz, 205 sample blocks */
+			static const double freqs[] = { 697, 770, 852, 941, 1209, 1336, 1477, 1633 };
+			float coefs[8], power[8];
+			int16_t block[205];
+			int k, f, i;
+
+			for (f = 0; f < 8; f++) {
+				coefs[f] = (float) (2.0 * cos(2.0 * M_PI * freqs[f] / 8000.0));
+			}
+
+			for (i = 0; i < 205; i++) {
+				block[i] = (int16_t) (8000.0 * sin(2.0 * M_PI * 770.0 * i / 8000.0) + 8000.0 * sin(2.0 * M_PI * 1477.0 * i / 8000.0));
+			}
+
+			for (k = 0; k < (int) (sizeof(impls) / sizeof(impls[0])); k++) {
+				if (switch_dsp_set_impl(impls[k]) != SWITCH_STATUS_SUCCESS) continue;
+
+				/* 7 filters keeps a partially filled vector in play */
+				switch_dsp_goertzel_bank(block, 205, coefs, 7, power);
+				power[7] = 0;
+				switch_dsp_goertzel_bank(block, 205, coefs + 7, 1, power + 7);
+
+				for (f = 0; f < 8; f++) {
+					if (f == 1 || f == 6) {
+						fst_check(power[f] > 1e11);
+					} else {
+						fst_check(power[f] < 1e10);
+					}
+				}
+			}
+		}
+		FST_TEST_END()
+
+		FST_TEST_BEGIN(test_switch_dsp_tone_bank)
+		{
+			static const uint32_t rates[] = { 8000, 16000 };
+			int16_t frame[320];
+			int k, r, spec, x;
+
+			for (k = 0; k < (int) (sizeof(impls) / sizeof(impls[0])); k++) {
+				if (switch_dsp_set_impl(impls[k]) != SWITCH_STATUS_SUCCESS) continue;
+
+				for (r = 0; r < 2; r++) {
+					uint32_t samples = rates[r] / 50;
+
+					/* -1 is noise only */
+					for (spec = -1; spec < TONE_SPECS; spec++) {
+						switch_dsp_tone_bank_t *bank = tone_bank_create(rates[r], fst_pool);
+						uint32_t pos = 0, seen = 0, hits;
+
+						/* one second of audio */
+						for (x = 0; x < 50; x++) {
+							next_tone_frame(frame, samples, rates[r], spec, &pos);
+							hits = switch_dsp_tone_bank_feed(bank, frame, samples, 0xffffffff);
+							seen |= hits;
+						}
+
+						fst_check_int_equals(seen, spec < 0 ? 0 : 1U << spec);
+
+						/* tones left out of the active mask are never reported */
+						if (spec >= 0) {
+							seen = 0;
+							for (x = 0; x < 50; x++) {
+								next_tone_frame(frame, samples, rates[r], spec, &pos);
+								seen |= switch_dsp_tone_bank_feed(bank, frame, samples, ~(1U << spec));
+							}
+							fst_check_int_equals(seen, 0);
+						}
+					}
+				}
+			}
+
+			fst_check(switch_dsp_tone_bank_add(tone_bank_create(8000, fst_pool), tone_specs[0], 0) < 0);
+		}
+		FST_TEST_END()
+
+#ifdef BENCHMARK
+		FST_TEST_BEGIN(benchmark_tone_bank)
+		{
+			teletone_multi_tone_t mt[TONE_SPECS];
+			switch_dsp_tone_bank_t *bank;
+			int16_t frame[160];
+			uint32_t pos = 0;
+			switch_time_t start;
+			int k, spec, x, frames = BENCH_FRAMES / 10;
+
+			next_tone_frame(frame, 160, 8000, 1, &pos);
+
+			for (spec = 0; spec < TONE_SPECS; spec++) {
+				teletone_tone_map_t map = { { 0 } };
+				uint32_t f;
+
+				for (f = 0; f < tone_spec_freqs[spec]; f++) {
+					map.freqs[f] = tone_specs[spec][f];
+				}
+
+				memset(&mt[spec], 0, sizeof(mt[spec]));
+				mt[spec].sample_rate = 8000;
+				teletone_multi_tone_init(&mt[spec], &map);
+			}
+
+			start = switch_time_now();
+			for (x = 0; x < frames; x++) {
+				for (spec = 0; spec < TONE_SPECS; spec++) {
+					teletone_multi_tone_detect(&mt[spec], frame, 160);
+				}
+			}
+			printf("%-8s %d tone specs %.3fus per 160 sample frame\n", "teletone", TONE_SPECS, (double) (switch_time_now() - start) / frames);
+
+			for (k = 0; k < (int) (sizeof(impls) / sizeof(impls[0])); k++) {
+				if (switch_dsp_set_impl(impls[k]) != SWITCH_STATUS_SUCCESS) continue;
+
+				bank = tone_bank_create(8000, fst_pool);
+
+				start = switch_time_now();
+				for (x = 0; x < frames; x++) {
+					switch_dsp_tone_bank_feed(bank, frame, 160, 0xffffffff);
+				}
+				printf("%-8s %d tone specs %.3fus per 160 sample frame\n", impls[k], TONE_SPECS, (double) (switch_time_now() - start) / frames);
+			}
+		}
+		FST_TEST_END()
+#endif
+
+#ifdef BENCHMARK
+		FST_TEST_BEGIN(benchmark)
+		{
+			static int16_t frame[BENCH_SAMPLES], other[BENCH_SAMPLES];
+			volatile uint64_t sink = 0;
+			switch_time_t start;
+			int k, x;
+
+			fill_noise(frame, BENCH_SAMPLES);
+			fill_noise(other, BENCH_SAMPLES);
+
+			start = switch_time_now();
+			for (x = 0; x < BENCH_FRAMES; x++) {
+				sink += legacy_energy(frame, BENCH_SAMPLES, 1);
+			}
+			printf("%-8s energy %.3fus", "legacy", bench_us(start));
+
+			start = switch_time_now();
+			for (x = 0; x < BENCH_FRAMES; x++) {
+				legacy_gain(frame, BENCH_SAMPLES, x & 1 ? 1.3 : 0.8);
+			}
+			printf(" gain %.3fus", bench_us(start));
+
+			start = switch_time_now();
+			for (x = 0; x < BENCH_FRAMES; x++) {
+				legacy_mix(frame, other, BENCH_SAMPLES);
+			}
+			printf(" mix %.3fus per %d sample frame\n", bench_us(start), BENCH_SAMPLES);
+
+			for (k = 0; k < (int) (sizeof(impls) / sizeof(impls[0])); k++) {
+				if (switch_dsp_set_impl(impls[k]) != SWITCH_STATUS_SUCCESS) continue;
+
+				start = switch_time_now();
+				for (x = 0; x < BENCH_FRAMES; x++) {
+					sink += switch_dsp_energy(frame, BENCH_SAMPLES, 1);
+				}
+				printf("%-8s energy %.3fus", impls[k], bench_us(start));
+
+				start = switch_time_now();
+				for (x = 0; x < BENCH_FRAMES; x++) {
+					switch_dsp_gain(frame, BENCH_SAMPLES, x & 1 ? 1.3 : 0.8);
+				}
+				printf(" gain %.3fus", bench_us(start));
+
+				start = switch_time_now();
+				for (x = 0; x < BENCH_FRAMES; x++) {
+					switch_dsp_mix(frame, other, BENCH_SAMPLES);
+				}
+				printf(" mix %.3fus per %d sample frame\n", bench_us(start), BENCH_SAMPLES);
+			}
+
+			fst_check(sink > 0);
+		}
+		FST_TEST_END()
+#endif
+	}
+	FST_SUITE_END()
+}
+FST_MINCORE_END()
+
+/* For Emacs:
+ * Local Variables:
+ * mode:c
+ * indent-tabs-mode:t
+ * tab-width:4
+ * c-basic-offset:4
+ * End:
+ * For VIM:
+ * vim:set softtabstop=4 shiftwidth=4 tabstop=4 noet:
+ */
@@ -104,6 +104,112 @@ FST_TEST_BEGIN(benchmark)
 }
 FST_TEST_END()
 
+FST_TEST_BEGIN(serialize_json)
+{
+  switch_event_t *event = NULL;
+  cJSON *cj = NULL;
+  char *tree_text = NULL, *text = NULL;
+#ifdef BENCHMARK
+  switch_time_t start_ts;
+  uint64_t tree_total, writer_total;
+  int loops = 1000, x = 0;
+#endif
+
+  fst_requires(switch_event_create(&event, SWITCH_EVENT_CUSTOM) == SWITCH_STATUS_SUCCESS);
+  switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Unique-ID", "c8a3e5f2-0000-4b5c-9a1e-6c2f9e1d7a10");
+  switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Quoted", "say \"hi\"\tback\\ \x01 \xc3\xa9");
+  switch_event_add_header_string(event, SWITCH_STACK_PUSH, "Multi", "one");
+  switch_event_add_header_string(event, SWITCH_STACK_PUSH, "Multi", "two");
+  switch_event_add_body(event, "line one\nline two\n");
+
+  fst_requires(switch_event_serialize_json_obj(event, &cj) == SWITCH_STATUS_SUCCESS);
+  tree_text = cJSON_PrintUnformatted(cj);
+  cJSON_Delete(cj);
+
+  fst_requires(switch_event_serialize_json(event, &text) == SWITCH_STATUS_SUCCESS);
+  fst_check_string_equals(text, tree_text);
+  free(text);
+
+#ifdef BENCHMARK
+  start_ts = switch_time_now();
+  for (x = 0; x < loops; x++) {
+    switch_event_serialize_json_obj(event, &cj);
+    text = cJSON_PrintUnformatted(cj);
+    cJSON_Delete(cj);
+    free(text);
+  }
+  tree_total = switch_time_now() - start_ts;
+
+  start_ts = switch_time_now();
+  for (x = 0; x < loops; x++) {
+    switch_event_serialize_json(event, &text);
+    free(text);
+  }
+  writer_total = switch_time_now() - start_ts;
+
+  printf("switch_event json: cJSON tree %" SWITCH_UINT64_T_FMT "us, writer %" SWITCH_UINT64_T_FMT "us / %d loops\n",
+       tree_total, writer_total, loops);
+#endif
+
+  free(tree_text);
+  switch_event_destroy(&event);
+}
+FST_TEST_END()
+
+FST_TEST_BEGIN(dup_arena_headers)
+{
+  switch_event_t *event = NULL, *clone = NULL;
+  char *text = NULL, *clone_text = NULL;
+  char name[96], big[1024];
+  int x = 0;
+
+  memset(big, 'v', sizeof(big) - 1);
+  big[sizeof(big) - 1] = '\0';
+
+  fst_requires(switch_event_create(&event, SWITCH_EVENT_CHANNEL_DATA) == SWITCH_STATUS_SUCCESS);
+
+  for (x = 0; x < 4; x++) {
+    switch_snprintf(name, sizeof(name), "variable_test_%d", x);
+    switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, name, x ? name : big);
+  }
+
+  /* enough headers to run past the per event storage and fall back to malloc, the names are too long to be interned
+     so the process wide name table is left alone */
+  for (x = 0; x < 1500; x++) {
+    switch_snprintf(name, sizeof(name), "variable_long_enough_not_to_be_interned_in_the_event_name_table_%d", x);
+    switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, name, (x % 50) ? name : big);
+  }
+  switch_event_add_header_string(event, SWITCH_STACK_PUSH, "Multi", "one");
+  switch_event_add_header_string(event, SWITCH_STACK_PUSH, "Multi", "two");
+  switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Channel-State", "CS_NEW");
+  switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, "Channel-State", "CS_INIT");
+  fst_check_string_equals(switch_event_get_header(event, "Channel-State"), "CS_INIT");
+
+  /* a plain value turned into an array keeps its first element */
+  switch_event_add_header_string(event, SWITCH_STACK_PUSH, "Channel-State", "CS_ROUTING");
+  fst_check_string_equals(switch_event_get_header(event, "Channel-State"), "ARRAY::CS_INIT|:CS_ROUTING");
+
+  fst_requires(switch_event_dup(&clone, event) == SWITCH_STATUS_SUCCESS);
+  fst_check(switch_event_get_header_ptr(clone, "variable_test_1")->name == switch_event_get_header_ptr(event, "variable_test_1")->name);
+
+  switch_event_serialize_json(event, &text);
+  switch_event_serialize_json(clone, &clone_text);
+  fst_check_string_equals(clone_text, text);
+  free(text);
+  free(clone_text);
+
+  switch_event_del_header(clone, "variable_test_0");
+  fst_check(switch_event_get_header(clone, "variable_test_0") == NULL);
+  fst_check_string_equals(switch_event_get_header(event, "variable_test_0"), big);
+
+  fst_check(switch_event_rename_header(clone, "variable_test_2", "Renamed") == SWITCH_STATUS_SUCCESS);
+  fst_check_string_equals(switch_event_get_header(clone, "renamed"), "variable_test_2");
+
+  switch_event_destroy(&event);
+  switch_event_destroy(&clone);
+}
+FST_TEST_END()
+
 FST_SUITE_END()
 
 FST_MINCORE_END()
@@ -195,6 +195,39 @@ FST_CORE_BEGIN("./conf_async")
 			unlink(record_filename);
 		}
 		FST_SESSION_END()
+
+		FST_SESSION_BEGIN(session_record_writer_pool)
+		{
+			const char *record_filename = switch_core_session_sprintf(fst_session, "%s%s%s.wav", SWITCH_GLOBAL_dirs.temp_dir, SWITCH_PATH_SEPARATOR, switch_core_session_get_uuid(fst_session));
+			switch_stream_handle_t stream = { 0 };
+			const char *duration_ms_str;
+			switch_status_t status;
+
+			status = switch_ivr_record_session_event(fst_session, record_filename, 0, NULL, NULL);
+			fst_xcheck(status == SWITCH_STATUS_SUCCESS, "Expect switch_ivr_record_session() to return SWITCH_STATUS_SUCCESS");
+
+			status = switch_ivr_play_file(fst_session, NULL, "tone_stream://%(1000,0,400)", NULL);
+			fst_xcheck(status == SWITCH_STATUS_SUCCESS, "Expect switch_ivr_play_file() to return SWITCH_STATUS_SUCCESS");
+
+			SWITCH_STANDARD_STREAM(stream);
+			switch_ivr_record_writer_status(&stream);
+			fst_check_string_has((char *)stream.data, record_filename);
+			fst_check_string_has((char *)stream.data, "2 threads, 1 recording");
+			switch_safe_free(stream.data);
+
+			status = switch_ivr_stop_record_session(fst_session, record_filename);
+			fst_xcheck(status == SWITCH_STATUS_SUCCESS, "Expect switch_ivr_stop_record_session() to return SWITCH_STATUS_SUCCESS");
+
+			fst_xcheck(switch_file_exists(record_filename, fst_pool) == SWITCH_STATUS_SUCCESS, "Expect recording file to exist");
+			fst_check_string_equals(switch_channel_get_variable(fst_channel, "record_writer_drops"), "0");
+
+			duration_ms_str = switch_channel_get_variable(fst_channel, "record_ms");
+			fst_requires(duration_ms_str != NULL);
+			fst_xcheck(atoi(duration_ms_str) >= 900, "Expect the whole recording to reach the file");
+
+			unlink(record_filename);
+		}
+		FST_SESSION_END()
 	}
 	FST_SUITE_END()
 }
@@ -785,6 +785,40 @@ FST_CORE_BEGIN("./conf")
 		}
 		FST_TEST_END()
 
+		FST_TEST_BEGIN(originate_test_answer_latency)
+		{
+			switch_time_t total = 0;
+			int runs = 5, x;
+
+			for (x = 0; x < runs; x++) {
+				switch_core_session_t *session = NULL;
+				switch_channel_t *channel = NULL;
+				switch_caller_profile_t *cp;
+				switch_status_t status;
+				switch_call_cause_t cause;
+				switch_time_t now;
+
+				status = switch_ivr_originate(NULL, &session, &cause, "{null_auto_answer_delay=200}null/+15553334444", 2, NULL, NULL, NULL, NULL, NULL, SOF_NONE, NULL, NULL);
+				now = switch_time_now();
+				fst_requires(session);
+				fst_check(status == SWITCH_STATUS_SUCCESS);
+
+				channel = switch_core_session_get_channel(session);
+				fst_requires(channel);
+				cp = switch_channel_get_caller_profile(channel);
+				fst_requires(cp && cp->times && cp->times->answered);
+				total += now - cp->times->answered;
+
+				switch_channel_hangup(channel, SWITCH_CAUSE_NORMAL_CLEARING);
+				switch_core_session_rwunlock(session);
+			}
+
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_INFO, "answer to return latency: %" SWITCH_TIME_T_FMT "us avg over %d calls\n", total / runs, runs);
+			fst_check(total / runs < 10000);
+			switch_sleep(1000000);
+		}
+		FST_TEST_END()
+
 		FST_TEST_BEGIN(enterprise_originate_test_group_confirm_two_handles)
 		{
 			switch_core_session_t *session = NULL;
@@ -88,6 +88,44 @@ static char *wait_for_log(switch_interval_time_t timeout_ms)
 	return log_str;
 }
 
+/* the cJSON tree printed the way mod_console and mod_graylog2 used to, with graylog2's _microtimestamp when asked */
+static char *log_node_tree_text(const switch_log_node_t *node, switch_log_json_format_t *format, switch_event_t *chan_vars, switch_bool_t microtimestamp)
+{
+	cJSON *json = switch_log_node_to_json(node, node->level, format, chan_vars);
+	char *text;
+
+	if (microtimestamp) {
+		cJSON_AddItemToObject(json, "_microtimestamp", cJSON_CreateNumber(node->timestamp));
+	}
+	text = cJSON_PrintUnformatted(json);
+	cJSON_Delete(json);
+
+	return text;
+}
+
+/* the same through the writer, the way mod_graylog2 does it now */
+static char *log_node_writer_text(const switch_log_node_t *node, switch_log_json_format_t *format, switch_event_t *chan_vars, switch_bool_t microtimestamp)
+{
+	switch_json_writer_t w;
+	char buf[64];
+	char *text;
+
+	if (!microtimestamp) {
+		return switch_log_node_to_json_string(node, node->level, format, chan_vars);
+	}
+
+	/* small enough to make the writer grow onto the heap */
+	switch_json_writer_init(&w, buf, sizeof(buf));
+	switch_json_writer_object_start(&w);
+	switch_log_node_json_write(&w, node, node->level, format, chan_vars);
+	switch_json_writer_add_number(&w, "_microtimestamp", node->timestamp);
+	switch_json_writer_object_end(&w);
+	text = switch_json_writer_dup(&w);
+	switch_json_writer_destroy(&w);
+
+	return text;
+}
+
 FST_CORE_BEGIN("./conf")
 {
 	FST_SUITE_BEGIN(switch_log)
@@ -189,6 +227,106 @@ FST_CORE_BEGIN("./conf")
 			switch_log_unbind_logger(test_logger);
 		}
 		FST_SESSION_END()
+
+		FST_SESSION_BEGIN(switch_log_node_json_matches_tree)
+		{
+			switch_log_json_format_t gelf_format = { { 0 } };
+			switch_log_node_t node = { 0 };
+			switch_event_t *chan_vars = NULL;
+			cJSON *item = NULL;
+			char *tree_text, *writer_text;
+			char content[] = " LOG_FIELDS[@#latency=12.5,tag=from \"message\"]switch_log test: first line\tend\nsecond line \xc3\xa9\n";
+
+			/* mod_graylog2's format */
+			gelf_format.version.name = "version";
+			gelf_format.version.value = "1.1";
+			gelf_format.host.name = "host";
+			gelf_format.timestamp.name = "timestamp";
+			gelf_format.timestamp_divisor = 1000000;
+			gelf_format.level.name = "level";
+			gelf_format.ident.name = "_ident";
+			gelf_format.ident.value = "freeswitch";
+			gelf_format.pid.name = "_pid";
+			gelf_format.pid.value = "4321";
+			gelf_format.uuid.name = "_uuid";
+			gelf_format.file.name = "_file";
+			gelf_format.line.name = "_line";
+			gelf_format.function.name = "_function";
+			gelf_format.full_message.name = "full_message";
+			gelf_format.short_message.name = "short_message";
+			gelf_format.custom_field_prefix = "_";
+			gelf_format.sequence.name = "_sequence";
+
+			switch_channel_set_variable(fst_channel, "switch_log_test_var", "chan \"value\"");
+			switch_event_create_plain(&chan_vars, SWITCH_EVENT_CHANNEL_DATA);
+			switch_event_add_header_string(chan_vars, SWITCH_STACK_BOTTOM, "caller", "switch_log_test_var");
+			switch_event_add_header_string(chan_vars, SWITCH_STACK_BOTTOM, "missing", "switch_log_test_no_such_var");
+
+			node.content = content;
+			switch_set_string(node.file, "switch_log.c");
+			switch_set_string(node.func, "test_func");
+			node.line = 123;
+			node.level = SWITCH_LOG_WARNING;
+			node.timestamp = 1600000000123456LL;
+			node.sequence = 987654321;
+			node.userdata = (char *) switch_core_session_get_uuid(fst_session);
+			switch_event_create_plain(&node.tags, SWITCH_EVENT_CHANNEL_DATA);
+			switch_event_add_header_string(node.tags, SWITCH_STACK_BOTTOM, "tagged", "yes");
+			switch_event_add_header_string(node.tags, SWITCH_STACK_BOTTOM, "@#weight", "0.25");
+			node.meta = cJSON_CreateObject();
+			cJSON_AddStringToObject(node.meta, "foo", "b\"ar\\");
+			cJSON_AddNumberToObject(node.meta, "measure", 3.14159);
+			cJSON_AddNumberToObject(node.meta, "big", 1e300);
+			cJSON_AddNumberToObject(node.meta, "negative", -42);
+			cJSON_AddNullToObject(node.meta, "nothing");
+			cJSON_AddTrueToObject(node.meta, "yes");
+			item = cJSON_AddObjectToObject(node.meta, "nested");
+			cJSON_AddStringToObject(item, "stringval", "1234");
+			item = cJSON_AddArrayToObject(item, "array");
+			cJSON_AddItemToArray(item, cJSON_CreateString("12"));
+			cJSON_AddItemToArray(item, cJSON_CreateNumber(0.1));
+
+			/* graylog2: prefixed meta, channel variables, log fields and _microtimestamp */
+			tree_text = log_node_tree_text(&node, &gelf_format, chan_vars, SWITCH_TRUE);
+			writer_text = log_node_writer_text(&node, &gelf_format, chan_vars, SWITCH_TRUE);
+			fst_check_string_has(tree_text, "\"_caller\":\"chan \\\"value\\\"\"");
+			fst_check_string_has(tree_text, "\"_microtimestamp\":1600000000123456");
+			fst_check_string_equals(writer_text, tree_text);
+			switch_safe_free(tree_text);
+			switch_safe_free(writer_text);
+
+			/* no custom_field_prefix, meta fields go in as they are */
+			gelf_format.custom_field_prefix = NULL;
+			tree_text = log_node_tree_text(&node, &gelf_format, chan_vars, SWITCH_FALSE);
+			writer_text = log_node_writer_text(&node, &gelf_format, chan_vars, SWITCH_FALSE);
+			fst_check_string_has(tree_text, "{\"foo\":");
+			fst_check_string_equals(writer_text, tree_text);
+			switch_safe_free(tree_text);
+			switch_safe_free(writer_text);
+
+			/* mod_console's format, no channel variables */
+			tree_text = log_node_tree_text(&node, &json_format, NULL, SWITCH_FALSE);
+			writer_text = log_node_writer_text(&node, &json_format, NULL, SWITCH_FALSE);
+			fst_check_string_equals(writer_text, tree_text);
+			switch_safe_free(tree_text);
+			switch_safe_free(writer_text);
+
+			/* no LOG_FIELDS, tags and channel variables are written without merging them first */
+			node.content = strstr(content, "switch_log test");
+			gelf_format.custom_field_prefix = "_";
+			tree_text = log_node_tree_text(&node, &gelf_format, chan_vars, SWITCH_TRUE);
+			writer_text = log_node_writer_text(&node, &gelf_format, chan_vars, SWITCH_TRUE);
+			fst_check_string_has(tree_text, "\"_weight\":0.25");
+			fst_check_string_has(tree_text, "\"_caller\":\"chan \\\"value\\\"\"");
+			fst_check_string_equals(writer_text, tree_text);
+			switch_safe_free(tree_text);
+			switch_safe_free(writer_text);
+
+			cJSON_Delete(node.meta);
+			switch_event_destroy(&node.tags);
+			switch_event_destroy(&chan_vars);
+		}
+		FST_SESSION_END()
 	}
 	FST_SUITE_END()
 
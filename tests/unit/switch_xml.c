@@ -34,6 +34,76 @@
 
 #include <test/switch_test.h>
 
+static int directory_lookups = 0;
+
+static switch_xml_t directory_search(const char *section, const char *tag_name, const char *key_name, const char *key_value,
+									 switch_event_t *params, void *user_data)
+{
+	const char *user = switch_event_get_header(params, "user");
+	char *xml;
+
+	directory_lookups++;
+
+	if (zstr(user) || strcmp(user, "1000")) {
+		return NULL;
+	}
+
+	xml = "<document type=\"freeswitch/xml\"><section name=\"directory\"><domain name=\"cache.test\"><users>"
+		"<user id=\"1000\" cacheable=\"60000\"><params><param name=\"password\" value=\"1234\"/></params></user>"
+		"</users></domain></section></document>";
+
+	return switch_xml_parse_str_dup(xml);
+}
+
+// #define BENCHMARK 1
+
+#define DIR_USERS 20000
+#define DIR_LOOKUPS 2000
+
+/* one big users tag and a group, with the odd ordering cases find_user_in_tag has to honour */
+static char *directory_xml(void)
+{
+	switch_stream_handle_t stream = { 0 };
+	int x;
+
+	SWITCH_STANDARD_STREAM(stream);
+	stream.write_function(&stream, "<document type=\"freeswitch/xml\"><section name=\"directory\"><domain name=\"index.test\"><users>");
+
+	for (x = 0; x < DIR_USERS; x++) {
+		stream.write_function(&stream, "<user id=\"%d\" number-alias=\"%d\"%s/>", 10000 + x, 50000 + x, x == 17 ? " ip=\"10.0.0.17\"" : "");
+	}
+
+	/* shadowed by the alias of user 10000 in document order */
+	stream.write_function(&stream, "<user id=\"50000\"/>");
+	stream.write_function(&stream, "<user id=\"ptr\" type=\"pointer\"/><user id=\"Late\"/>");
+	stream.write_function(&stream, "</users></domain><domain name=\"group.test\"><groups><group name=\"g1\"><users>");
+
+	for (x = 0; x < 32; x++) {
+		stream.write_function(&stream, "<user id=\"g%d\"/>", x);
+	}
+
+	stream.write_function(&stream, "<user id=\"catchall\" type=\"virtual\"/><user id=\"g100\"/></users></group></groups>");
+	stream.write_function(&stream, "</domain></section></document>");
+
+	return (char *) stream.data;
+}
+
+static switch_xml_t directory_domain(switch_xml_t xml, const char *name)
+{
+	return switch_xml_find_child(switch_xml_find_child(xml, "section", "name", "directory"), "domain", "name", name);
+}
+
+static const char *find_in_domain(switch_xml_t xml, const char *domain_name, const char *name)
+{
+	switch_xml_t user = NULL;
+
+	if (switch_xml_locate_user_in_domain(name, directory_domain(xml, domain_name), &user, NULL) != SWITCH_STATUS_SUCCESS) {
+		return NULL;
+	}
+
+	return switch_xml_attr(user, "id");
+}
+
 FST_MINCORE_BEGIN("./conf")
 {
 	FST_SUITE_BEGIN(switch_xml)
@@ -117,6 +187,181 @@ FST_MINCORE_BEGIN("./conf")
 			free(xml_string);
 		}
 		FST_TEST_END()
+
+		FST_TEST_BEGIN(test_user_cache)
+		{
+			switch_xml_binding_t *binding = NULL;
+			switch_xml_t user = NULL;
+			switch_status_t status;
+			switch_stream_handle_t stream = { 0 };
+
+			fst_requires(switch_xml_bind_search_function_ret(directory_search, SWITCH_XML_SECTION_DIRECTORY, NULL, &binding) == SWITCH_STATUS_SUCCESS);
+
+			directory_lookups = 0;
+			switch_xml_clear_user_cache(NULL, NULL, NULL);
+
+			status = switch_xml_locate_user_merged("id", "1000", "cache.test", NULL, &user, NULL);
+			fst_requires(status == SWITCH_STATUS_SUCCESS);
+			fst_check_string_equals(switch_xml_attr(user, "id"), "1000");
+			switch_xml_free(user);
+			fst_check_int_equals(directory_lookups, 1);
+
+			/* cacheable user comes out of the cache */
+			status = switch_xml_locate_user_merged("id", "1000", "cache.test", NULL, &user, NULL);
+			fst_requires(status == SWITCH_STATUS_SUCCESS);
+			fst_check(switch_xml_child(user, "params") != NULL);
+			switch_xml_free(user);
+			fst_check_int_equals(directory_lookups, 1);
+
+			/* unknown users are not cached unless directory-negative-cache-ms is set */
+			status = switch_xml_locate_user_merged("id", "2000", "cache.test", NULL, &user, NULL);
+			fst_check(status != SWITCH_STATUS_SUCCESS);
+			status = switch_xml_locate_user_merged("id", "2000", "cache.test", NULL, &user, NULL);
+			fst_check(status != SWITCH_STATUS_SUCCESS);
+			fst_check_int_equals(directory_lookups, 3);
+
+			/* lookups whose answer is not cached leave no loading marker behind */
+			SWITCH_STANDARD_STREAM(stream);
+			switch_xml_user_cache_status(&stream);
+			fst_check_string_has((char *) stream.data, "Entries: 1 users, 0 not found, 0 loading\n");
+			switch_safe_free(stream.data);
+
+			fst_check_int_equals(switch_xml_clear_user_cache("id", "1000", "cache.test"), 1);
+			status = switch_xml_locate_user_merged("id", "1000", "cache.test", NULL, &user, NULL);
+			fst_requires(status == SWITCH_STATUS_SUCCESS);
+			switch_xml_free(user);
+			fst_check_int_equals(directory_lookups, 4);
+
+			switch_xml_clear_user_cache(NULL, NULL, NULL);
+			switch_xml_unbind_search_function(&binding);
+		}
+		FST_TEST_END()
+
+		FST_TEST_BEGIN(test_binary_cache)
+		{
+			const char *text = "<document type=\"freeswitch/xml\"><section name=\"a\"><x id=\"1\"/>between<y/><x id=\"2\">two</x>"
+				"<z><![CDATA[<raw>]]></z><y name=\"last\"/></section><section name=\"b\"/></document>";
+			char *path = switch_mprintf("%s%sswitch_xml_cache_test.fsbin", SWITCH_GLOBAL_dirs.temp_dir, SWITCH_PATH_SEPARATOR);
+			switch_xml_t xml = switch_xml_parse_str_dup((char *) text), cached, section, x;
+			char *a, *b;
+			FILE *fp;
+
+			fst_requires(xml);
+			fst_requires(switch_xml_write_cache(xml, path) == SWITCH_STATUS_SUCCESS);
+			fst_requires((cached = switch_xml_parse_cache(path)));
+
+			a = switch_xml_toxml(xml, SWITCH_FALSE);
+			b = switch_xml_toxml(cached, SWITCH_FALSE);
+			fst_check_string_equals(a, b);
+			free(a);
+			free(b);
+
+			/* same name and sibling chains the parser builds */
+			fst_requires((section = switch_xml_find_child(cached, "section", "name", "a")));
+			fst_requires((x = switch_xml_child(section, "x")));
+			fst_check_string_equals(switch_xml_attr(x->next, "id"), "2");
+			fst_check_string_equals(x->next->txt, "two");
+			fst_check_string_equals(switch_xml_attr(switch_xml_child(section, "y")->next, "name"), "last");
+			fst_check_string_equals(switch_xml_child(section, "z")->txt, "<raw>");
+			fst_check(switch_xml_find_child(cached, "section", "name", "b") != NULL);
+
+			/* the loaded tree can be edited like a parsed one */
+			switch_xml_set_attr_d(x, "id", "one");
+			switch_xml_set_attr_d(x, "extra", "yes");
+			fst_check_string_equals(switch_xml_attr(x, "id"), "one");
+			fst_check_string_equals(switch_xml_attr(x, "extra"), "yes");
+
+			switch_xml_free(cached);
+			switch_xml_free(xml);
+
+			/* anything that is not a cache is refused */
+			fst_requires((fp = fopen(path, "wb")));
+			fprintf(fp, "%s", text);
+			fclose(fp);
+			fst_check(switch_xml_parse_cache(path) == NULL);
+
+			unlink(path);
+			free(path);
+		}
+		FST_TEST_END()
+
+		FST_TEST_BEGIN(test_directory_index)
+		{
+			char *text = directory_xml();
+			switch_xml_t indexed = switch_xml_parse_str_dup(text);
+			switch_xml_t plain = switch_xml_parse_str_dup(text);
+			const char *names[] = { "10000", "59999", "50000", "10017", "late", "ptr", "nobody" };
+			switch_xml_t domain, user = NULL, group = NULL;
+			int x;
+
+			fst_requires(indexed);
+			fst_requires(plain);
+			fst_check_int_equals(switch_xml_index_directory(indexed), DIR_USERS + 3 + 34);
+			/* asking twice does not rebuild */
+			fst_check_int_equals(switch_xml_index_directory(indexed), DIR_USERS + 3 + 34);
+
+			for (x = 0; x < (int) (sizeof(names) / sizeof(names[0])); x++) {
+				const char *a = find_in_domain(indexed, "index.test", names[x]);
+				const char *b = find_in_domain(plain, "index.test", names[x]);
+
+				fst_xcheck((a == NULL) == (b == NULL), names[x]);
+				if (a && b) {
+					fst_check_string_equals(a, b);
+				}
+			}
+
+			fst_check_string_equals(find_in_domain(indexed, "index.test", "50000"), "10000");
+			fst_check_string_equals(find_in_domain(indexed, "index.test", "LATE"), "Late");
+
+			/* the typed user answers for any name in the group it sits in, ahead of later ids */
+			domain = directory_domain(indexed, "group.test");
+			fst_requires(switch_xml_locate_user_in_domain("g100", domain, &user, &group) == SWITCH_STATUS_SUCCESS);
+			fst_check_string_equals(switch_xml_attr(user, "id"), "catchall");
+			fst_check_string_equals(switch_xml_attr(group, "name"), "g1");
+			fst_requires(switch_xml_locate_user_in_domain("g5", domain, &user, NULL) == SWITCH_STATUS_SUCCESS);
+			fst_check_string_equals(switch_xml_attr(user, "id"), "g5");
+
+			switch_xml_free(indexed);
+			switch_xml_free(plain);
+			free(text);
+		}
+		FST_TEST_END()
+
+#ifdef BENCHMARK
+		FST_TEST_BEGIN(benchmark_directory_index)
+		{
+			char *text = directory_xml();
+			switch_xml_t docs[2];
+			switch_time_t start;
+			char name[32];
+			int k, x, found;
+
+			docs[0] = switch_xml_parse_str_dup(text);
+			docs[1] = switch_xml_parse_str_dup(text);
+			fst_requires(docs[0]);
+			fst_requires(docs[1]);
+
+			start = switch_time_now();
+			switch_xml_index_directory(docs[1]);
+			printf("indexing %d users took %.3fms\n", DIR_USERS, (double) (switch_time_now() - start) / 1000);
+
+			for (k = 0; k < 2; k++) {
+				found = 0;
+				start = switch_time_now();
+				for (x = 0; x < DIR_LOOKUPS; x++) {
+					switch_snprintf(name, sizeof(name), "%d", 10000 + (x * 7919) % DIR_USERS);
+					found += find_in_domain(docs[k], "index.test", name) != NULL;
+				}
+				printf("%-8s %.3fus per lookup among %d users\n", k ? "indexed" : "linear", (double) (switch_time_now() - start) / DIR_LOOKUPS, DIR_USERS);
+				fst_check_int_equals(found, DIR_LOOKUPS);
+			}
+
+			switch_xml_free(docs[0]);
+			switch_xml_free(docs[1]);
+			free(text);
+		}
+		FST_TEST_END()
+#endif
 	}
 	FST_SUITE_END()
 }